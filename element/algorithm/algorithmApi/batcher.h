@@ -0,0 +1,234 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SOPHON_STREAM_ELEMENT_ALGORITHMAPI_BATCHER_H_
+#define SOPHON_STREAM_ELEMENT_ALGORITHMAPI_BATCHER_H_
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <nlohmann/json.hpp>
+#include <set>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace sophon_stream {
+namespace framework {
+class Message;
+}  // namespace framework
+
+namespace element {
+
+/**
+ * @brief 动态组batch的统计信息
+ */
+struct BatchStatistics {
+  std::int64_t mBatchCount = 0;
+  std::int64_t mObjectCount = 0;
+  /**
+   * @brief 实际送入推理的batch size之和，包含补齐的部分
+   */
+  std::int64_t mSlotCount = 0;
+  std::int64_t mTimeoutCount = 0;
+  /**
+   * @brief 各个batch size被选中的次数
+   */
+  std::map<int, std::int64_t> mBatchSizeHistogram;
+
+  float fillRate() const {
+    return mSlotCount == 0 ? 0.f : (float)mObjectCount / mSlotCount;
+  }
+};
+
+inline void to_json(nlohmann::json& j, const BatchStatistics& statistics) {
+  nlohmann::json histogram = nlohmann::json::object();
+  for (auto& it : statistics.mBatchSizeHistogram)
+    histogram[std::to_string(it.first)] = it.second;
+  j = nlohmann::json{{"batch_count", statistics.mBatchCount},
+                     {"object_count", statistics.mObjectCount},
+                     {"slot_count", statistics.mSlotCount},
+                     {"timeout_count", statistics.mTimeoutCount},
+                     {"fill_rate", statistics.fillRate()},
+                     {"batch_size_histogram", histogram}};
+}
+
+/**
+ * @brief 算法element的动态组batch工具
+ * @brief
+ * 从输入队列中收集数据，batch凑满或者从第一个数据到达起超过最大等待时间后立即送出，
+ * 并在模型编译的多个batch size中选择能容纳当前数据量的最小值，
+ * 调用者按选中的batch size选择模型的stage推理
+ * @brief 优先级为p的数据最多等待maxWait/(p+1)，高优先级数据到达后batch会提前送出
+ * @brief 等待时间从数据进入输入队列时开始计算，在队列中排队的时间也计算在内
+ * @brief 收到FLUSH或EOS控制消息时立即送出
+ * @brief
+ * 数据来源通过PopHandler注入，时钟可以通过setClock替换，可以脱离Element单独使用和测试。
+ * MessageT需要提供header()、isControl()、empty()和takeObjectMetadata()，
+ * 与framework::Message相同
+ */
+template <typename MessageT>
+class BasicDynamicBatcher {
+ public:
+  using Clock = std::chrono::steady_clock;
+  /**
+   * @brief 从输入队列取一个消息，队列为空时返回空消息
+   */
+  using PopHandler = std::function<MessageT()>;
+  /**
+   * @brief 返回false时立即结束收集
+   */
+  using RunningHandler = std::function<bool()>;
+  /**
+   * @brief 取当前时间和等待一段时间，缺省为steady_clock和sleep_for
+   */
+  using NowHandler = std::function<Clock::time_point()>;
+  using SleepHandler = std::function<void(Clock::duration)>;
+
+  using Statistics = BatchStatistics;
+
+  BasicDynamicBatcher() = default;
+
+  /**
+   * @brief 配置组batch参数
+   * @param[in] maxBatch : 单次最多收集的数据量
+   * @param[in] batchSizes : 模型中编译的batch size，为空时只使用maxBatch
+   * @param[in] maxWaitUs :
+   * 第一个数据到达后的最大等待时间，小于0时一直等待直到batch凑满
+   */
+  void init(int maxBatch, const std::set<int>& batchSizes, int maxWaitUs) {
+    mMaxBatch = maxBatch > 0 ? maxBatch : 1;
+    mBatchSizes = batchSizes;
+    if (mBatchSizes.empty()) mBatchSizes.insert(mMaxBatch);
+    mMaxWait = std::chrono::microseconds(maxWaitUs);
+  }
+
+  void setClock(NowHandler now, SleepHandler sleep) {
+    mNow = std::move(now);
+    mSleep = std::move(sleep);
+  }
+
+  /**
+   * @brief 收集一个batch
+   * @param[out] objectMetadatas : 需要推理的数据，不包含mFilter为true的数据
+   * @param[out] pendingObjectMetadatas : 收集到的全部数据，按到达顺序排列
+   * @param[out] controlMessages :
+   * 收集期间收到的控制消息，调用者送出pendingObjectMetadatas之后再转发
+   * @return int
+   * 本次选中的batch size，推理时使用这个batch size对应的stage；没有需要推理的数据时返回0
+   */
+  template <typename ObjectMetadatas>
+  int collect(const PopHandler& pop, const RunningHandler& running,
+              ObjectMetadatas& objectMetadatas,
+              ObjectMetadatas& pendingObjectMetadatas,
+              std::vector<MessageT>& controlMessages) {
+    bool timeout = false;
+    Clock::time_point deadline;
+    while (static_cast<int>(objectMetadatas.size()) < mMaxBatch &&
+           running()) {
+      auto message = pop();
+      if (message.isControl()) {
+        controlMessages.push_back(std::move(message));
+        break;
+      }
+      if (message.empty()) {
+        if (pendingObjectMetadatas.empty() || mMaxWait.count() < 0) {
+          mSleep(mIdleInterval);
+          continue;
+        }
+        auto now = mNow();
+        if (now >= deadline) {
+          timeout = true;
+          break;
+        }
+        mSleep(std::min<Clock::duration>(mPollInterval, deadline - now));
+        continue;
+      }
+
+      const auto& header = message.header();
+      int priority = std::max(header.mPriority, 0);
+      auto itemDeadline = header.mEnqueueTime + mMaxWait / (priority + 1);
+      auto objectMetadata = message.takeObjectMetadata();
+      if (pendingObjectMetadatas.empty() || itemDeadline < deadline)
+        deadline = itemDeadline;
+      if (!objectMetadata->mFilter) objectMetadatas.push_back(objectMetadata);
+
+      pendingObjectMetadatas.push_back(objectMetadata);
+
+      if (objectMetadata->mFrame->mEndOfStream) {
+        break;
+      }
+    }
+
+    int batchSize = chooseBatchSize(objectMetadatas.size());
+    record(objectMetadatas.size(), batchSize, timeout);
+    return batchSize;
+  }
+
+  /**
+   * @brief 选择能容纳objectNum个数据的最小batch size
+   */
+  int chooseBatchSize(int objectNum) const {
+    if (objectNum <= 0) return 0;
+    auto it = mBatchSizes.lower_bound(objectNum);
+    return it == mBatchSizes.end() ? *mBatchSizes.rbegin() : *it;
+  }
+
+  Statistics getStatistics() {
+    std::lock_guard<std::mutex> lock(mStatisticsMutex);
+    return mStatistics;
+  }
+
+  void resetStatistics() {
+    std::lock_guard<std::mutex> lock(mStatisticsMutex);
+    mStatistics = Statistics();
+  }
+
+ private:
+  void record(int objectNum, int batchSize, bool timeout) {
+    if (objectNum <= 0) return;
+    std::lock_guard<std::mutex> lock(mStatisticsMutex);
+    ++mStatistics.mBatchCount;
+    mStatistics.mObjectCount += objectNum;
+    mStatistics.mSlotCount += batchSize;
+    if (timeout) ++mStatistics.mTimeoutCount;
+    ++mStatistics.mBatchSizeHistogram[batchSize];
+  }
+
+  int mMaxBatch = 1;
+  std::set<int> mBatchSizes;
+  std::chrono::microseconds mMaxWait{-1};
+
+  /**
+   * @brief 队列为空且还没有收到数据时的轮询间隔
+   */
+  const std::chrono::microseconds mIdleInterval{1000};
+  /**
+   * @brief 已经收到数据、等待凑batch时的轮询间隔
+   */
+  const std::chrono::microseconds mPollInterval{200};
+
+  NowHandler mNow = [] { return Clock::now(); };
+  SleepHandler mSleep = [](Clock::duration duration) {
+    std::this_thread::sleep_for(duration);
+  };
+
+  std::mutex mStatisticsMutex;
+  Statistics mStatistics;
+};
+
+using DynamicBatcher = BasicDynamicBatcher<framework::Message>;
+
+}  // namespace element
+}  // namespace sophon_stream
+
+#endif  // SOPHON_STREAM_ELEMENT_ALGORITHMAPI_BATCHER_H_
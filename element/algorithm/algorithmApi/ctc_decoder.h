@@ -0,0 +1,253 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SOPHON_STREAM_ELEMENT_ALGORITHMAPI_CTC_DECODER_H_
+#define SOPHON_STREAM_ELEMENT_ALGORITHMAPI_CTC_DECODER_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace sophon_stream {
+namespace element {
+
+/**
+ * @brief 返回data[0, num)中第一个最大值的下标，num需大于0
+ */
+inline int ctcArgmax(const float* data, int num, float* maxValue) {
+  float best = data[0];
+  int i = 0;
+#if defined(__aarch64__)
+  if (num >= 4) {
+    float32x4_t m = vld1q_f32(data);
+    for (i = 4; i + 4 <= num; i += 4) m = vmaxq_f32(m, vld1q_f32(data + i));
+    best = vmaxvq_f32(m);
+  }
+#elif defined(__SSE2__)
+  if (num >= 4) {
+    __m128 m = _mm_loadu_ps(data);
+    for (i = 4; i + 4 <= num; i += 4) m = _mm_max_ps(m, _mm_loadu_ps(data + i));
+    m = _mm_max_ps(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(1, 0, 3, 2)));
+    m = _mm_max_ps(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(2, 3, 0, 1)));
+    best = _mm_cvtss_f32(m);
+  }
+#endif
+  for (; i < num; ++i) best = std::max(best, data[i]);
+  int index = 0;
+  while (index < num - 1 && data[index] != best) ++index;
+  *maxValue = best;
+  return index;
+}
+
+/**
+ * @brief CTC解码，供文字识别、车牌识别等element共用
+ * @brief
+ * 一个batch的输出共用同一份预分配的缓冲；beam search在每个时间步只保留概率最高的beamWidth个字符，
+ * 候选序列用平铺的(父节点, 字符下标)表记录，结束时回溯得到最优路径，不拷贝前缀。
+ * 解码结果为去掉重复字符和blank之后的字符下标及其概率。
+ * 不加锁，每个线程或每次后处理使用各自的实例
+ */
+class CtcDecoder {
+ public:
+  struct Result {
+    std::vector<int> labels;
+    std::vector<float> confs;
+  };
+
+  /**
+   * @param blank blank字符的下标
+   * @param beamWidth 小于等于1时使用贪心解码
+   */
+  void configure(int blank, int beamWidth) {
+    mBlank = blank;
+    mBeamWidth = beamWidth;
+  }
+
+  /**
+   * @brief 限制可以输出的字符，allowed[c]为0的字符不参与解码，空表示不限制
+   */
+  void setAllowedClasses(const std::vector<std::uint8_t>& allowed) {
+    mAllowed = allowed;
+  }
+
+  /**
+   * @brief 解码一个batch的输出，logits布局为[batch][T][C]
+   */
+  void decode(const float* logits, int batch, int T, int C,
+              std::vector<Result>& results) {
+    results.resize(batch);
+    for (int b = 0; b < batch; ++b) {
+      const float* data = logits + static_cast<std::size_t>(b) * T * C;
+      if (mBeamWidth > 1)
+        beamSearch(data, T, C, results[b]);
+      else
+        greedy(data, T, C, results[b]);
+    }
+  }
+
+  /**
+   * @brief 贪心解码一条输出，logits布局为[T][C]
+   */
+  void greedy(const float* logits, int T, int C, Result& result) {
+    mPath.resize(T);
+    mPathConfs.resize(T);
+    for (int t = 0; t < T; ++t) {
+      const float* row = logits + static_cast<std::size_t>(t) * C;
+      mPath[t] = mAllowed.empty() ? ctcArgmax(row, C, &mPathConfs[t])
+                                  : maskedArgmax(row, C, &mPathConfs[t]);
+    }
+    collapse(T, result);
+  }
+
+  /**
+   * @brief 贪心解码一条按字符优先存放的输出，logits布局为[C][T]
+   */
+  void greedyClassMajor(const float* logits, int T, int C, Result& result) {
+    mPath.assign(T, mBlank);
+    mPathConfs.assign(T, -std::numeric_limits<float>::infinity());
+    // 按行更新每个时间步的最大值，内层循环连续访存
+    for (int c = 0; c < C; ++c) {
+      if (!allowed(c)) continue;
+      const float* row = logits + static_cast<std::size_t>(c) * T;
+      for (int t = 0; t < T; ++t) {
+        bool greater = row[t] > mPathConfs[t];
+        mPathConfs[t] = greater ? row[t] : mPathConfs[t];
+        mPath[t] = greater ? c : mPath[t];
+      }
+    }
+    collapse(T, result);
+  }
+
+  /**
+   * @brief beam search解码一条输出，logits布局为[T][C]，
+   * 序列的得分为各时间步所选字符概率的乘积
+   */
+  void beamSearch(const float* logits, int T, int C, Result& result) {
+    int k = std::min(mBeamWidth, C);
+    mParents.resize(static_cast<std::size_t>(T) * k);
+    mLabels.resize(static_cast<std::size_t>(T) * k);
+    mConfs.resize(static_cast<std::size_t>(T) * k);
+    mScores.assign(1, 1.f);
+    for (int t = 0; t < T; ++t) {
+      const float* row = logits + static_cast<std::size_t>(t) * C;
+      topK(row, C, k);
+      int* parents = &mParents[static_cast<std::size_t>(t) * k];
+      int* labels = &mLabels[static_cast<std::size_t>(t) * k];
+      float* confs = &mConfs[static_cast<std::size_t>(t) * k];
+      // 从beam数 x k个扩展中插入排序选出得分最高的k个
+      std::vector<float>& nextScores = mNextScores;
+      nextScores.clear();
+      for (int j = 0; j < static_cast<int>(mScores.size()); ++j) {
+        for (int c : mTop) {
+          float score = mScores[j] * row[c];
+          int n = nextScores.size();
+          if (n == k && score <= nextScores[n - 1]) continue;
+          if (n < k) {
+            nextScores.push_back(score);
+            ++n;
+          }
+          int pos = n - 1;
+          for (; pos > 0 && nextScores[pos - 1] < score; --pos) {
+            nextScores[pos] = nextScores[pos - 1];
+            parents[pos] = parents[pos - 1];
+            labels[pos] = labels[pos - 1];
+            confs[pos] = confs[pos - 1];
+          }
+          nextScores[pos] = score;
+          parents[pos] = j;
+          labels[pos] = c;
+          confs[pos] = row[c];
+        }
+      }
+      mScores.swap(mNextScores);
+    }
+
+    mPath.resize(T);
+    mPathConfs.resize(T);
+    for (int t = T - 1, j = 0; t >= 0; --t) {
+      std::size_t slot = static_cast<std::size_t>(t) * k + j;
+      mPath[t] = mLabels[slot];
+      mPathConfs[t] = mConfs[slot];
+      j = mParents[slot];
+    }
+    collapse(T, result);
+  }
+
+ private:
+  bool allowed(int c) const {
+    return mAllowed.empty() || c == mBlank ||
+           (c < static_cast<int>(mAllowed.size()) && mAllowed[c]);
+  }
+
+  int maskedArgmax(const float* row, int C, float* maxValue) const {
+    int best = -1;
+    for (int c = 0; c < C; ++c)
+      if (allowed(c) && (best < 0 || row[c] > row[best])) best = c;
+    *maxValue = row[best];
+    return best;
+  }
+
+  // mTop按概率从高到低保存row中允许输出的前k个字符，概率相同时下标小的在前
+  void topK(const float* row, int C, int k) {
+    mTop.clear();
+    for (int c = 0; c < C; ++c) {
+      if (!allowed(c)) continue;
+      int n = mTop.size();
+      if (n == k && row[c] <= row[mTop[n - 1]]) continue;
+      if (n < k) {
+        mTop.push_back(c);
+        ++n;
+      }
+      int pos = n - 1;
+      for (; pos > 0 && row[mTop[pos - 1]] < row[c]; --pos)
+        mTop[pos] = mTop[pos - 1];
+      mTop[pos] = c;
+    }
+  }
+
+  // 合并mPath中连续重复的字符并去掉blank
+  void collapse(int T, Result& result) const {
+    result.labels.clear();
+    result.confs.clear();
+    int last = mBlank;
+    for (int t = 0; t < T; ++t) {
+      int c = mPath[t];
+      if (c != mBlank && c != last) {
+        result.labels.push_back(c);
+        result.confs.push_back(mPathConfs[t]);
+      }
+      last = c;
+    }
+  }
+
+  int mBlank = 0;
+  int mBeamWidth = 1;
+  std::vector<std::uint8_t> mAllowed;
+
+  std::vector<int> mPath;
+  std::vector<float> mPathConfs;
+  std::vector<int> mTop;
+  std::vector<float> mScores;
+  std::vector<float> mNextScores;
+  std::vector<int> mParents;
+  std::vector<int> mLabels;
+  std::vector<float> mConfs;
+};
+
+}  // namespace element
+}  // namespace sophon_stream
+
+#endif  // SOPHON_STREAM_ELEMENT_ALGORITHMAPI_CTC_DECODER_H_
@@ -0,0 +1,142 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SOPHON_STREAM_ELEMENT_ALGORITHMAPI_HOST_PRE_PROCESS_H_
+#define SOPHON_STREAM_ELEMENT_ALGORITHMAPI_HOST_PRE_PROCESS_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "common/cpu_image_ops.h"
+#include "common/error_code.h"
+#include "common/inference_backend.h"
+
+namespace sophon_stream {
+namespace element {
+
+/**
+ * @brief 主机内存上的前处理，用cpu_image_ops代替bmcv，生成HostNetwork的输入
+ * @brief
+ * 几何关系与yolov5的前处理一致：keepAspect为true时按长边等比缩放、居中并填充114，
+ * 否则直接拉伸到网络输入大小；随后按alpha、beta归一化为planar，bgr2rgb为true时转为RGB
+ */
+class HostPreProcess {
+ public:
+  /**
+   * @brief 一张图在网络输入中的位置，后处理用它把框映射回原图
+   * @brief 原图坐标 = (网络输入坐标 - pad) / ratio
+   */
+  struct Letterbox {
+    float ratioW = 1.f;
+    float ratioH = 1.f;
+    int padX = 0;
+    int padY = 0;
+    // 缩放后的图像大小
+    int width = 0;
+    int height = 0;
+  };
+
+  bool keepAspect = true;
+  bool bgr2rgb = true;
+  float alpha[3] = {1.f / 255, 1.f / 255, 1.f / 255};
+  float beta[3] = {0.f, 0.f, 0.f};
+
+  /**
+   * @brief 按配置中的mean、std设置归一化参数，与yolov5初始化converto_attr的方式相同
+   */
+  void setMeanStd(const std::vector<float>& mean, const std::vector<float>& std,
+                  float inputScale = 1.f) {
+    for (int i = 0; i < 3; ++i) {
+      alpha[i] = inputScale / std[i];
+      beta[i] = -mean[i] / std[i] * inputScale;
+    }
+  }
+
+  /**
+   * @brief 计算一张图缩放后在网络输入中的区域
+   */
+  Letterbox letterbox(int srcW, int srcH, int netW, int netH) const {
+    Letterbox box;
+    box.width = netW;
+    box.height = netH;
+    float rW = static_cast<float>(netW) / srcW;
+    float rH = static_cast<float>(netH) / srcH;
+    if (!keepAspect) {
+      box.ratioW = rW;
+      box.ratioH = rH;
+      return box;
+    }
+    if (rH > rW) {
+      box.ratioW = box.ratioH = rW;
+      box.height = std::max(static_cast<int>(srcH * rW), 1);
+      box.padY = (netH - box.height) / 2;
+    } else {
+      box.ratioW = box.ratioH = rH;
+      box.width = std::max(static_cast<int>(srcW * rH), 1);
+      box.padX = (netW - box.width) / 2;
+    }
+    return box;
+  }
+
+  /**
+   * @brief 把一个batch的图像转为网络的第0个输入
+   * @param[in] info 网络输入的描述，shape为NCHW，支持FLOAT32和INT8
+   * @param[out] input batch为images.size()，其余维度与info相同
+   * @param[out] letterboxes 每张图在网络输入中的位置
+   * @return 图像为空、通道数与网络不符或dtype不支持时返回PARAMETER_ERROR
+   */
+  common::ErrorCode preProcess(const std::vector<common::HostImage>& images,
+                               const common::TensorInfo& info,
+                               common::HostTensor& input,
+                               std::vector<Letterbox>& letterboxes) const {
+    constexpr int kFloat32 = 0, kInt8 = 2;
+    if (images.empty() || info.shape.size() != 4 ||
+        (info.dtype != kFloat32 && info.dtype != kInt8))
+      return common::ErrorCode::PARAMETER_ERROR;
+    const int channels = info.shape[1], netH = info.shape[2],
+              netW = info.shape[3];
+    const std::size_t planeSize = static_cast<std::size_t>(channels) * netH * netW;
+
+    std::vector<int> shape = info.shape;
+    shape[0] = static_cast<int>(images.size());
+    input.allocate(info.dtype, shape);
+    letterboxes.resize(images.size());
+
+    common::HostImage resized;
+    std::vector<float> planar(planeSize);
+    for (std::size_t b = 0; b < images.size(); ++b) {
+      const auto& image = images[b];
+      if (image.width <= 0 || image.height <= 0 || image.channels != channels)
+        return common::ErrorCode::PARAMETER_ERROR;
+      Letterbox box = letterbox(image.width, image.height, netW, netH);
+      common::cpuResize(image, netW, netH, resized, true, box.padX, box.padY,
+                        box.width, box.height);
+      letterboxes[b] = box;
+
+      if (info.dtype == kFloat32) {
+        common::cpuConvertTo(resized, alpha, beta, bgr2rgb,
+                             input.floatData() + b * planeSize);
+        continue;
+      }
+      common::cpuConvertTo(resized, alpha, beta, bgr2rgb, planar.data());
+      auto* out = reinterpret_cast<std::int8_t*>(input.data.data()) + b * planeSize;
+      for (std::size_t i = 0; i < planeSize; ++i)
+        out[i] = static_cast<std::int8_t>(
+            std::min(std::max(std::round(planar[i]), -128.f), 127.f));
+    }
+    return common::ErrorCode::SUCCESS;
+  }
+};
+
+}  // namespace element
+}  // namespace sophon_stream
+
+#endif  // SOPHON_STREAM_ELEMENT_ALGORITHMAPI_HOST_PRE_PROCESS_H_
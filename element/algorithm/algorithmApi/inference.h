@@ -17,12 +17,30 @@ class Inference {
   Inference() = default;
   virtual ~Inference() = default;
 
+  /**
+   * @brief 返回输入batch维等于batchSize的stage
+   * @brief batchSize小于等于0或者模型中没有这个batch size时返回0，即按stage 0推理
+   */
+  template <typename T, typename U = Context,
+            typename std::enable_if<std::is_base_of<U, T>::value, int>::type* =
+                nullptr>
+  int getStageIndex(std::shared_ptr<T> context, int batchSize) {
+    if (batchSize <= 0) return 0;
+    auto netinfo = context->bmNetwork->m_netinfo;
+    for (int s = 0; s < netinfo->stage_num; ++s)
+      if (netinfo->stages[s].input_shapes[0].dims[0] == batchSize) return s;
+    return 0;
+  }
+
   template <typename T, typename U = Context,
             typename std::enable_if<std::is_base_of<U, T>::value, int>::type* =
                 nullptr>
   std::shared_ptr<sophon_stream::common::bmTensors> mergeInputDeviceMem(
-      std::shared_ptr<T> context, common::ObjectMetadatas& objectMetadatas) {
+      std::shared_ptr<T> context, common::ObjectMetadatas& objectMetadatas,
+      int batchSize = 0) {
     // 合并inputBMtensors，并且申请连续的outputBMtensors
+    int stage = getStageIndex(context, batchSize);
+    if (batchSize <= 0) batchSize = context->max_batch;
     std::shared_ptr<sophon_stream::common::bmTensors> inputTensors =
         std::make_shared<sophon_stream::common::bmTensors>();
     inputTensors.reset(
@@ -42,10 +60,10 @@ class Inference {
       inputTensors->tensors[i]->dtype =
           context->bmNetwork->m_netinfo->input_dtypes[i];
       inputTensors->tensors[i]->shape =
-          context->bmNetwork->m_netinfo->stages[0].input_shapes[i];
+          context->bmNetwork->m_netinfo->stages[stage].input_shapes[i];
       inputTensors->tensors[i]->st_mode = BM_STORE_1N;
       // 计算大小
-      int input_bytes = context->max_batch *
+      int input_bytes = batchSize *
                         inputTensors->tensors[i]->shape.dims[1] *
                         context->net_h * context->net_w;
       if (BM_FLOAT32 == context->bmNetwork->m_netinfo->input_dtypes[0])
@@ -60,9 +78,9 @@ class Inference {
         if (objectMetadatas[j]->mFrame->mEndOfStream) break;
         bm_memcpy_d2d_byte(
             inputTensors->handle, inputTensors->tensors[i]->device_mem,
-            j * input_bytes / context->max_batch,
+            j * input_bytes / batchSize,
             objectMetadatas[j]->mInputBMtensors->tensors[i]->device_mem, 0,
-            input_bytes / context->max_batch);
+            input_bytes / batchSize);
       }
     }
     return inputTensors;
@@ -72,7 +90,8 @@ class Inference {
             typename std::enable_if<std::is_base_of<U, T>::value, int>::type* =
                 nullptr>
   std::shared_ptr<sophon_stream::common::bmTensors> getOutputDeviceMem(
-      std::shared_ptr<T> context) {
+      std::shared_ptr<T> context, int batchSize = 0) {
+    int stage = getStageIndex(context, batchSize);
     std::shared_ptr<sophon_stream::common::bmTensors> outputTensors =
         std::make_shared<sophon_stream::common::bmTensors>();
     outputTensors.reset(
@@ -92,11 +111,12 @@ class Inference {
       outputTensors->tensors[i]->dtype =
           context->bmNetwork->m_netinfo->output_dtypes[i];
       outputTensors->tensors[i]->shape =
-          context->bmNetwork->m_netinfo->stages[0].output_shapes[i];
+          context->bmNetwork->m_netinfo->stages[stage].output_shapes[i];
       outputTensors->tensors[i]->st_mode = BM_STORE_1N;
-      // 计算大小
+      // 计算大小，指定batch size时只申请对应stage的大小
       size_t max_size = 0;
       for (int s = 0; s < context->bmNetwork->m_netinfo->stage_num; s++) {
+        if (batchSize > 0 && s != stage) continue;
         size_t out_size = bmrt_shape_count(
             &context->bmNetwork->m_netinfo->stages[s].output_shapes[i]);
         if (max_size < out_size) {
@@ -124,8 +144,12 @@ class Inference {
                 nullptr>
   void splitOutputMemIntoObjectMetadatas(
       std::shared_ptr<T> context, common::ObjectMetadatas& objectMetadatas,
-      std::shared_ptr<sophon_stream::common::bmTensors> outputTensors) {
+      std::shared_ptr<sophon_stream::common::bmTensors> outputTensors,
+      int batchSize = 0) {
     // 把outputTensors的显存拆出来给objectMetadatas
+    int stage = getStageIndex(context, batchSize);
+    bool stageOnly = batchSize > 0;
+    if (!stageOnly) batchSize = context->max_batch;
     for (int i = 0; i < objectMetadatas.size(); ++i) {
       if (objectMetadatas[i]->mFrame->mEndOfStream) break;
       objectMetadatas[i]->mOutputBMtensors =
@@ -148,12 +172,13 @@ class Inference {
         objectMetadatas[i]->mOutputBMtensors->tensors[j]->dtype =
             context->bmNetwork->m_netinfo->output_dtypes[j];
         objectMetadatas[i]->mOutputBMtensors->tensors[j]->shape =
-            context->bmNetwork->m_netinfo->stages[0].output_shapes[j];
+            context->bmNetwork->m_netinfo->stages[stage].output_shapes[j];
         objectMetadatas[i]->mOutputBMtensors->tensors[j]->shape.dims[0] /=
-            context->max_batch;
+            batchSize;
         objectMetadatas[i]->mOutputBMtensors->tensors[j]->st_mode = BM_STORE_1N;
         size_t max_size = 0;
         for (int s = 0; s < context->bmNetwork->m_netinfo->stage_num; s++) {
+          if (stageOnly && s != stage) continue;
           size_t out_size = bmrt_shape_count(
               &context->bmNetwork->m_netinfo->stages[s].output_shapes[j]);
           if (max_size < out_size) {
@@ -162,7 +187,7 @@ class Inference {
         }
         if (BM_FLOAT32 == context->bmNetwork->m_netinfo->output_dtypes[j])
           max_size *= 4;
-        max_size /= context->max_batch;
+        max_size /= batchSize;
         auto ret = bm_malloc_device_byte_heap(
             objectMetadatas[i]->mOutputBMtensors->handle,
             &objectMetadatas[i]->mOutputBMtensors->tensors[j]->device_mem, STREAM_NPU_HEAP,
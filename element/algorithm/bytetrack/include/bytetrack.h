@@ -25,6 +25,23 @@ class Bytetrack : public ::sophon_stream::framework::Element {
 
   common::ErrorCode doWork(int dataPipeId) override;
 
+  /**
+   * @brief 跟踪器按通道保存在处理线程中，通道不能在线程之间迁移
+   */
+  bool isChannelStateful() const override { return true; }
+
+  /**
+   * @brief 直接读写mDetectionBatch，上游输出按列存放的检测结果时不再转换
+   */
+  bool acceptsDetectionBatch() const override { return true; }
+
+  /**
+   * @brief 快照保存每个通道的tracker和全局的轨迹id计数，按外部通道号恢复
+   */
+  std::uint32_t getStateVersion() const override { return 1; }
+  common::ErrorCode saveState(common::StateWriter& writer) override;
+  common::ErrorCode loadState(common::StateReader& reader) override;
+
   static constexpr const char* CONFIG_INTERNAL_FRAME_RATE_FIELD = "frame_rate";
   static constexpr const char* CONFIG_INTERNAL_TRACK_BUFFER_FIELD =
       "track_buffer";
@@ -40,15 +57,23 @@ class Bytetrack : public ::sophon_stream::framework::Element {
       "correct_box";
   static constexpr const char* CONFIG_INTERNAL_AGNOSTIC_FIELD =
       "agnostic";
+  static constexpr const char* CONFIG_INTERNAL_INTERPOLATE_FIELD =
+      "interpolate";
 
  private:
   std::shared_ptr<BytetrackContext> mContext;  // context对象
 
-  std::map<int, std::shared_ptr<BYTETracker>> mByteTrackerMap;
+  // {dataPipeId : {channelIdInternal : tracker}}，每个线程只访问自己的通道
+  std::map<int, std::map<int, std::shared_ptr<BYTETracker>>> mByteTrackerMap;
+
+  // {channelId : tracker}，从快照恢复、还没有被通道取走的tracker
+  std::map<int, std::shared_ptr<BYTETracker>> mRestoredTrackers;
+  std::mutex mRestoredTrackersMutex;
 
   common::ErrorCode initContext(const std::string& json);
   void process(int dataPipeId,
                std::shared_ptr<common::ObjectMetadata>& objectMetadata);
+  std::shared_ptr<BYTETracker> createTracker(int channelId);
 };
 
 }  // namespace bytetrack
@@ -1,45 +1,50 @@
-//===----------------------------------------------------------------------===//
-//
-// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
-//
-// SOPHON-DEMO is licensed under the 2-Clause BSD License except for the
-// third-party components.
-//
-//===----------------------------------------------------------------------===//
-
-#ifndef SOPHON_STREAM_ELEMENT_BYTETRACK_KALMANFILTER_H_
-#define SOPHON_STREAM_ELEMENT_BYTETRACK_KALMANFILTER_H_
-
-#include <cstddef>
-#include <opencv2/opencv.hpp>
-
-namespace sophon_stream {
-namespace element {
-namespace bytetrack {
-
-class KalmanFilter {
- public:
-  static const double chi2inv95[10];
-  KalmanFilter();
-  ~KalmanFilter();
-  std::pair<cv::Mat, cv::Mat> initiate(const cv::Mat& measurement);
-  std::pair<cv::Mat, cv::Mat> predict(const cv::Mat& mean,
-                                      const cv::Mat& covariance);
-  std::pair<cv::Mat, cv::Mat> update(const cv::Mat& mean,
-                                     const cv::Mat& covariance,
-                                     const cv::Mat& measurement);
-  cv::Mat gating_distance(const cv::Mat& mean, const cv::Mat& covariance,
-                          const std::vector<cv::Mat>& measurements,
-                          bool only_position = false);
-
- private:
-  std::unique_ptr<cv::KalmanFilter> opencv_kf;
-  float _std_weight_position;
-  float _std_weight_velocity;
-};
-
-}  // namespace bytetrack
-}  // namespace element
-}  // namespace sophon_stream
-
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-DEMO is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SOPHON_STREAM_ELEMENT_BYTETRACK_KALMANFILTER_H_
+#define SOPHON_STREAM_ELEMENT_BYTETRACK_KALMANFILTER_H_
+
+#include <array>
+
+namespace sophon_stream {
+namespace element {
+namespace bytetrack {
+
+/**
+ * @brief 状态为(x, y, a, h, vx, vy, va, vh)
+ */
+using KalmanMean = std::array<float, 8>;
+
+/**
+ * @brief
+ * 状态转移和观测只在同一坐标的位置和速度之间耦合，噪声为对角阵，因此协方差始终由4个
+ * 独立的2x2块组成。依次保存4个块的pp、pv、vv，共12个数
+ */
+using KalmanCovariance = std::array<float, 12>;
+
+class KalmanFilter {
+ public:
+  KalmanFilter();
+  ~KalmanFilter();
+  void initiate(const std::array<float, 4>& measurement, KalmanMean& mean,
+                KalmanCovariance& covariance) const;
+  void predict(KalmanMean& mean, KalmanCovariance& covariance) const;
+  void update(KalmanMean& mean, KalmanCovariance& covariance,
+              const std::array<float, 4>& measurement) const;
+
+ private:
+  float _std_weight_position;
+  float _std_weight_velocity;
+};
+
+}  // namespace bytetrack
+}  // namespace element
+}  // namespace sophon_stream
+
 #endif  // SOPHON_STREAM_ELEMENT_BYTETRACK_KALMANFILTER_H_
\ No newline at end of file
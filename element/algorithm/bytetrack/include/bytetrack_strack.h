@@ -1,71 +1,90 @@
-//===----------------------------------------------------------------------===//
-//
-// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
-//
-// SOPHON-DEMO is licensed under the 2-Clause BSD License except for the
-// third-party components.
-//
-//===----------------------------------------------------------------------===//
-
-#ifndef SOPHON_STREAM_ELEMENT_BYTETRACK_STRACK_H_
-#define SOPHON_STREAM_ELEMENT_BYTETRACK_STRACK_H_
-
-#include "bytetrack_kalmanfilter.h"
-
-namespace sophon_stream {
-namespace element {
-namespace bytetrack {
-
-enum TrackState { New = 0, Tracked, Lost, Removed };
-
-class STrack {
- public:
-  STrack(std::vector<float> tlwh_, float score, int class_id);
-  ~STrack();
-
-  std::vector<float> static tlbr_to_tlwh(std::vector<float>& tlbr);
-  void static multi_predict(std::vector<std::shared_ptr<STrack>>& stracks,
-                            std::shared_ptr<KalmanFilter> kalman_filter);
-  void static_tlwh();
-  void static_tlbr();
-  std::vector<float> tlwh_to_xyah(std::vector<float> tlwh_tmp);
-  std::vector<float> to_xyah();
-  void mark_lost();
-  void mark_removed();
-  int next_id();
-  int end_frame();
-
-  void activate(std::shared_ptr<KalmanFilter> kalman_filter, int frame_id);
-  void re_activate(std::shared_ptr<KalmanFilter> kalman_filter,
-                   std::shared_ptr<STrack> new_track, int frame_id,
-                   bool correct_box, bool new_id = false);
-  void update(std::shared_ptr<KalmanFilter> kalman_filter,
-              std::shared_ptr<STrack> new_track, int frame_id, bool correct_box);
-  void kalman_correct_box(std::shared_ptr<KalmanFilter> kalman_filter,
-                   std::shared_ptr<STrack> new_track, bool correct_box);
-
- public:
-  bool is_activated;
-  int track_id;
-  int state;
-
-  std::vector<float> _tlwh;
-  std::vector<float> tlwh;
-  std::vector<float> tlbr;
-  int frame_id;
-  int tracklet_len;
-  int start_frame;
-
-  cv::Mat mean;
-  cv::Mat covariance;
-  float score;
-  int class_id;
-};
-
-using STracks = std::vector<std::shared_ptr<STrack>>;
-
-}  // namespace bytetrack
-}  // namespace element
-}  // namespace sophon_stream
-
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-DEMO is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SOPHON_STREAM_ELEMENT_BYTETRACK_STRACK_H_
+#define SOPHON_STREAM_ELEMENT_BYTETRACK_STRACK_H_
+
+#include <memory>
+#include <vector>
+
+#include "bytetrack_kalmanfilter.h"
+#include "common/state_archive.h"
+
+namespace sophon_stream {
+namespace element {
+namespace bytetrack {
+
+enum TrackState { New = 0, Tracked, Lost, Removed };
+
+class STrack {
+ public:
+  STrack(std::vector<float> tlwh_, float score, int class_id);
+  ~STrack();
+
+  std::vector<float> static tlbr_to_tlwh(std::vector<float>& tlbr);
+  void static multi_predict(std::vector<std::shared_ptr<STrack>>& stracks,
+                            std::shared_ptr<KalmanFilter> kalman_filter);
+  void static_tlwh();
+  void static_tlbr();
+  std::vector<float> tlwh_to_xyah(std::vector<float> tlwh_tmp);
+  std::vector<float> to_xyah();
+  /**
+   * @brief 由卡尔曼滤波当前的均值得到的框，不改变tlwh
+   */
+  std::vector<float> predicted_tlwh() const;
+  void mark_lost();
+  void mark_removed();
+  int next_id();
+  /**
+   * @brief 最近分配的轨迹id，所有tracker共用同一个计数
+   */
+  int static last_id();
+  /**
+   * @brief 恢复快照时保证后续分配的id大于快照中的id
+   */
+  void static restore_last_id(int id);
+  int end_frame();
+
+  void save(common::StateWriter& writer) const;
+  std::shared_ptr<STrack> static load(common::StateReader& reader);
+
+  void activate(std::shared_ptr<KalmanFilter> kalman_filter, int frame_id);
+  void re_activate(std::shared_ptr<KalmanFilter> kalman_filter,
+                   std::shared_ptr<STrack> new_track, int frame_id,
+                   bool correct_box, bool new_id = false);
+  void update(std::shared_ptr<KalmanFilter> kalman_filter,
+              std::shared_ptr<STrack> new_track, int frame_id, bool correct_box);
+  void kalman_correct_box(std::shared_ptr<KalmanFilter> kalman_filter,
+                   std::shared_ptr<STrack> new_track, bool correct_box);
+
+ public:
+  bool is_activated;
+  int track_id;
+  int state;
+
+  std::vector<float> _tlwh;
+  std::vector<float> tlwh;
+  std::vector<float> tlbr;
+  int frame_id;
+  int tracklet_len;
+  int start_frame;
+
+  KalmanMean mean;
+  KalmanCovariance covariance;
+  float score;
+  int class_id;
+};
+
+using STracks = std::vector<std::shared_ptr<STrack>>;
+
+}  // namespace bytetrack
+}  // namespace element
+}  // namespace sophon_stream
+
 #endif  // SOPHON_STREAM_ELEMENT_BYTETRACK_STRACK_H_
\ No newline at end of file
@@ -9,6 +9,7 @@
 
 #include "bytetrack.h"
 
+#include <algorithm>
 #include <nlohmann/json.hpp>
 
 #include "common/logger.h"
@@ -67,12 +68,18 @@ common::ErrorCode Bytetrack::initContext(const std::string& json) {
     mContext->agnostic =
         agnosticIt != configure.end() ? agnosticIt->get<bool>() : true;
 
+    auto interpolateIt = configure.find(CONFIG_INTERNAL_INTERPOLATE_FIELD);
+    mContext->interpolate =
+        interpolateIt != configure.end() ? interpolateIt->get<bool>() : false;
+
     IVS_DEBUG(
         "Bytetrack::initContext: frameRate: {0}, trackBuffer: {1}, "
         "trackThresh: {2}, "
-        "highThresh: {3}, matchThresh: {4}, correctBox: {5}, agnostic: {6}",
+        "highThresh: {3}, matchThresh: {4}, correctBox: {5}, agnostic: {6}, "
+        "interpolate: {7}",
         mContext->frameRate, mContext->trackBuffer, mContext->trackThresh,
-        mContext->highThresh, mContext->matchThresh, mContext->correctBox, mContext->agnostic);
+        mContext->highThresh, mContext->matchThresh, mContext->correctBox,
+        mContext->agnostic, mContext->interpolate);
 
   } while (false);
 
@@ -99,9 +106,9 @@ common::ErrorCode Bytetrack::initInternal(const std::string& json) {
 
     IVS_DEBUG("Bytetrack threadNumber: {0}", threadNumber);
 
-    // 初始化 tracker
+    // 每个线程的 tracker 按通道在首帧到达时创建
     for (int t = 0; t < threadNumber; ++t) {
-      mByteTrackerMap[t] = std::make_shared<BYTETracker>(mContext);
+      mByteTrackerMap[t].clear();
     }
 
   } while (false);
@@ -111,19 +118,84 @@ common::ErrorCode Bytetrack::initInternal(const std::string& json) {
 
 /**
  * update tracker
- * @param[in/out] objectMetadatas:  更新 tracker
+ * @param[in/out] objectMetadata:  更新 tracker
  */
 void Bytetrack::process(
     int dataPipeId, std::shared_ptr<common::ObjectMetadata>& objectMetadata) {
   auto byteTrackerIt = mByteTrackerMap.find(dataPipeId);
-  if (mByteTrackerMap.end() != byteTrackerIt) {
-    auto byteTracker = byteTrackerIt->second;
-    if (byteTracker) {
-      byteTracker->update(objectMetadata);
-    } else {
-      IVS_WARN("empty byteTrackerMap for dataPipeId : {0}", dataPipeId);
+  if (mByteTrackerMap.end() == byteTrackerIt) {
+    IVS_WARN("empty byteTrackerMap for dataPipeId : {0}", dataPipeId);
+    return;
+  }
+
+  if (objectMetadata->mFilter && !objectMetadata->mFrame->mEndOfStream &&
+      !mContext->interpolate)
+    return;
+  // 每个通道的帧依次更新自己的tracker
+  int channelIdInternal = objectMetadata->mFrame->mChannelIdInternal;
+  auto& byteTracker = byteTrackerIt->second[channelIdInternal];
+  if (!byteTracker)
+    byteTracker = createTracker(objectMetadata->mFrame->mChannelId);
+  byteTracker->update(objectMetadata);
+  // 通道结束后释放 tracker，channelIdInternal被复用时重新开始跟踪
+  if (objectMetadata->mFrame->mEndOfStream)
+    byteTrackerIt->second.erase(channelIdInternal);
+}
+
+std::shared_ptr<BYTETracker> Bytetrack::createTracker(int channelId) {
+  {
+    std::lock_guard<std::mutex> lock(mRestoredTrackersMutex);
+    auto restoredIt = mRestoredTrackers.find(channelId);
+    if (mRestoredTrackers.end() != restoredIt) {
+      auto byteTracker = restoredIt->second;
+      mRestoredTrackers.erase(restoredIt);
+      return byteTracker;
     }
   }
+  auto byteTracker = std::make_shared<BYTETracker>(mContext);
+  byteTracker->channel_id = channelId;
+  return byteTracker;
+}
+
+common::ErrorCode Bytetrack::saveState(common::StateWriter& writer) {
+  std::vector<std::shared_ptr<BYTETracker>> byteTrackers;
+  for (auto& threadTrackers : mByteTrackerMap)
+    for (auto& pair : threadTrackers.second)
+      if (pair.second) byteTrackers.push_back(pair.second);
+  {
+    // 恢复后还没有数据到达的通道继续保留
+    std::lock_guard<std::mutex> lock(mRestoredTrackersMutex);
+    for (auto& pair : mRestoredTrackers) byteTrackers.push_back(pair.second);
+  }
+
+  writer.write(STrack::last_id());
+  writer.write<std::uint32_t>(byteTrackers.size());
+  for (auto& byteTracker : byteTrackers) {
+    writer.write(byteTracker->channel_id);
+    byteTracker->save(writer);
+  }
+  return common::ErrorCode::SUCCESS;
+}
+
+common::ErrorCode Bytetrack::loadState(common::StateReader& reader) {
+  int lastId = 0;
+  std::uint32_t size = 0;
+  reader.read(lastId);
+  reader.read(size);
+  std::map<int, std::shared_ptr<BYTETracker>> restoredTrackers;
+  for (std::uint32_t i = 0; i < size && reader.ok(); ++i) {
+    auto byteTracker = std::make_shared<BYTETracker>(mContext);
+    reader.read(byteTracker->channel_id);
+    if (!byteTracker->load(reader)) break;
+    restoredTrackers[byteTracker->channel_id] = byteTracker;
+  }
+  if (!reader.ok()) return common::ErrorCode::SNAPSHOT_FAIL;
+
+  STrack::restore_last_id(lastId);
+  for (auto& threadTrackers : mByteTrackerMap) threadTrackers.second.clear();
+  std::lock_guard<std::mutex> lock(mRestoredTrackersMutex);
+  mRestoredTrackers.swap(restoredTrackers);
+  return common::ErrorCode::SUCCESS;
 }
 
 /**
@@ -145,42 +217,27 @@ common::ErrorCode Bytetrack::doWork(int dataPipeId) {
     return errorCode;
   }
 
-  common::ObjectMetadatas pendingObjectMetadatas;
-
-  std::shared_ptr<common::ObjectMetadata> objectMetadata = nullptr;
-
-  while (getThreadStatus() == ThreadStatus::RUN) {
-    auto data = popInputData(inputPort, dataPipeId);
-    if (!data) {
-      std::this_thread::sleep_for(std::chrono::milliseconds(10));
-      continue;
-    }
-    objectMetadata = std::static_pointer_cast<common::ObjectMetadata>(data);
-    pendingObjectMetadatas.push_back(objectMetadata);
-    if (!objectMetadata->mFilter) {
-      break;
-    }
-    if (objectMetadata->mFrame->mEndOfStream) {
-      break;
-    }
+  auto data = popInputData(inputPort, dataPipeId);
+  if (!data) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    return common::ErrorCode::SUCCESS;
   }
-  if (objectMetadata != nullptr) process(dataPipeId, objectMetadata);
-
-  for (auto& obj : pendingObjectMetadatas) {
-    int channel_id_internal = obj->mFrame->mChannelIdInternal;
-    int pipeId =
-        getSinkElementFlag()
-            ? 0
-            : (channel_id_internal % getOutputConnectorCapacity(outputPort));
-
-    errorCode =
-        pushOutputData(outputPort, pipeId, std::static_pointer_cast<void>(obj));
-    if (common::ErrorCode::SUCCESS != errorCode) {
-      IVS_WARN(
-          "Send data fail, element id: {0:d}, output port: {1:d}, data: "
-          "{2:p}",
-          getId(), outputPort, static_cast<void*>(obj.get()));
-    }
+  auto obj = std::static_pointer_cast<common::ObjectMetadata>(data);
+  process(dataPipeId, obj);
+
+  int channel_id_internal = obj->mFrame->mChannelIdInternal;
+  int pipeId = getSinkElementFlag()
+                   ? 0
+                   : getOutputDataPipeId(outputPort, channel_id_internal,
+                                         obj->mFrame->mEndOfStream);
+
+  errorCode =
+      pushOutputData(outputPort, pipeId, std::static_pointer_cast<void>(obj));
+  if (common::ErrorCode::SUCCESS != errorCode) {
+    IVS_WARN(
+        "Send data fail, element id: {0:d}, output port: {1:d}, data: "
+        "{2:p}",
+        getId(), outputPort, static_cast<void*>(obj.get()));
   }
 
   return common::ErrorCode::SUCCESS;
@@ -27,6 +27,33 @@ BYTETracker::BYTETracker(const std::shared_ptr<BytetrackContext> mContext) {
   this->class_offset = 7000;
   this->correct_box = mContext->correctBox;
   this->agnostic = mContext->agnostic;
+  this->interpolate = mContext->interpolate;
+  this->channel_id = -1;
+}
+
+void BYTETracker::save(common::StateWriter& writer) const {
+  writer.write(this->frame_id);
+  for (const STracks* stracks : {&this->tracked_stracks, &this->lost_stracks}) {
+    writer.write<std::uint32_t>(stracks->size());
+    for (auto& strack : *stracks) strack->save(writer);
+  }
+}
+
+bool BYTETracker::load(common::StateReader& reader) {
+  reader.read(this->frame_id);
+  for (STracks* stracks : {&this->tracked_stracks, &this->lost_stracks}) {
+    std::uint32_t size = 0;
+    stracks->clear();
+    reader.read(size);
+    for (std::uint32_t i = 0; i < size && reader.ok(); i++) {
+      auto strack = STrack::load(reader);
+      if (!strack) return false;
+      STrack::restore_last_id(strack->track_id);
+      stracks->push_back(strack);
+    }
+  }
+  this->removed_stracks.clear();
+  return reader.ok();
 }
 
 BYTETracker::~BYTETracker() {}
@@ -48,32 +75,46 @@ void BYTETracker::update(std::shared_ptr<common::ObjectMetadata>& objects) {
   STracks r_tracked_stracks;
   STracks output_stracks;
 
-  if (objects->mDetectedObjectMetadatas.size() > 0) {
-    for (auto subObj : objects->mDetectedObjectMetadatas) {
-      std::vector<float> tlbr_;
-      tlbr_.resize(4);
-      tlbr_[0] = subObj->mBox.mX;
-      tlbr_[1] = subObj->mBox.mY;
-      tlbr_[2] = subObj->mBox.mX + subObj->mBox.mWidth;
-      tlbr_[3] = subObj->mBox.mY + subObj->mBox.mHeight;
-
-      float score = subObj->mScores[0];
-      int class_id = subObj->mClassify;
-      if (!(this->agnostic)) {
-        tlbr_[0] += class_id * this->class_offset;
-        tlbr_[1] += class_id * this->class_offset;
-        tlbr_[2] += class_id * this->class_offset;
-        tlbr_[3] += class_id * this->class_offset;
-      }
+  auto addDetection = [&](int x, int y, int width, int height, float score,
+                          int class_id) {
+    if (score <= 0.1) return;
+    std::vector<float> tlbr_;
+    tlbr_.resize(4);
+    tlbr_[0] = x;
+    tlbr_[1] = y;
+    tlbr_[2] = x + width;
+    tlbr_[3] = y + height;
+    if (!(this->agnostic)) {
+      tlbr_[0] += class_id * this->class_offset;
+      tlbr_[1] += class_id * this->class_offset;
+      tlbr_[2] += class_id * this->class_offset;
+      tlbr_[3] += class_id * this->class_offset;
+    }
 
-      if (score > 0.1) {
-        std::shared_ptr<STrack> strack = std::make_shared<STrack>(
-            STrack::tlbr_to_tlwh(tlbr_), score, class_id);
-        if (score >= track_thresh)
-          detections.push_back(strack);
-        else
-          detections_low.push_back(strack);
-      }
+    std::shared_ptr<STrack> strack = std::make_shared<STrack>(
+        STrack::tlbr_to_tlwh(tlbr_), score, class_id);
+    if (score >= track_thresh)
+      detections.push_back(strack);
+    else
+      detections_low.push_back(strack);
+  };
+
+  // 没有检测的帧只推进运动模型，轨迹状态留到下一个检测帧再更新
+  bool interpolating = this->interpolate && objects->mFilter &&
+                       !objects->mFrame->mEndOfStream;
+  if (!interpolating) {
+    // 按列存放的检测结果直接顺序读取，不需要逐个访问DetectedObjectMetadata
+    auto& batch = objects->mDetectionBatch;
+    if (batch) {
+      for (std::size_t i = 0; i < batch->size(); ++i)
+        addDetection(batch->mX[i], batch->mY[i], batch->mWidth[i],
+                     batch->mHeight[i], batch->mScores[i],
+                     batch->mClassIds[i]);
+    } else {
+      for (auto subObj : objects->mDetectedObjectMetadatas)
+        addDetection(subObj->mBox.mX, subObj->mBox.mY, subObj->mBox.mWidth,
+                     subObj->mBox.mHeight, subObj->mScores[0],
+                     subObj->mClassify);
     }
   }
   // Add newly detected tracklets to tracked_stracks
@@ -83,10 +124,15 @@ void BYTETracker::update(std::shared_ptr<common::ObjectMetadata>& objects) {
     else
       temp_tracked_stracks.push_back(this->tracked_stracks[i]);
   }
-  ////////////////// Step 2: First association, with IoU //////////////////
   joint_stracks(temp_tracked_stracks, this->lost_stracks, strack_pool);
   STrack::multi_predict(strack_pool, this->kalman_filter);
 
+  if (interpolating) {
+    output_interpolated(objects);
+    return;
+  }
+
+  ////////////////// Step 2: First association, with IoU //////////////////
   std::vector<std::vector<float>> dists;
   int dist_size = strack_pool.size(), dist_size_size = detections.size();
   iou_distance(strack_pool, detections, dists);
@@ -235,36 +281,40 @@ void BYTETracker::update(std::shared_ptr<common::ObjectMetadata>& objects) {
   // objects->mSubObjectMetadatas.clear();
   objects->mDetectedObjectMetadatas.clear();
   objects->mTrackedObjectMetadatas.clear();
+  auto& batch = objects->mDetectionBatch;
+  if (batch) {
+    batch->clear();
+    batch->reserve(output_stracks.size());
+  }
+  int frameWidth = objects->mFrame->mSpData->width;
+  int frameHeight = objects->mFrame->mSpData->height;
   for (auto track_box : output_stracks) {
-    std::shared_ptr<common::ObjectMetadata> subOutputMetaData =
-        std::make_shared<common::ObjectMetadata>();
+    common::Rectangle<int> box;
+    box.mX = track_box->tlwh[0] < 0 ? 0 : track_box->tlwh[0];
+    box.mY = track_box->tlwh[1] < 0 ? 0 : track_box->tlwh[1];
+    if (!(this->agnostic)) {
+      box.mX -= track_box->class_id * this->class_offset;
+      box.mY -= track_box->class_id * this->class_offset;
+    }
+    box.mWidth = box.mX + track_box->tlwh[2] < frameWidth
+                     ? track_box->tlwh[2]
+                     : (frameWidth - box.mX);
+    box.mHeight = box.mY + track_box->tlwh[3] < frameHeight
+                      ? track_box->tlwh[3]
+                      : (frameHeight - box.mY);
+
+    if (batch) {
+      batch->push_back(box.mX, box.mY, box.mWidth, box.mHeight,
+                       track_box->score, track_box->class_id,
+                       track_box->track_id);
+      continue;
+    }
+
     std::shared_ptr<common::DetectedObjectMetadata> mDetectedObjectMetadata =
         std::make_shared<common::DetectedObjectMetadata>();
     std::shared_ptr<common::TrackedObjectMetadata> mTrackedObjectMetadata =
         std::make_shared<common::TrackedObjectMetadata>();
-
-    mDetectedObjectMetadata->mBox.mX =
-        track_box->tlwh[0] < 0 ? 0 : track_box->tlwh[0];
-    mDetectedObjectMetadata->mBox.mY =
-        track_box->tlwh[1] < 0 ? 0 : track_box->tlwh[1];
-    if (!(this->agnostic)) {
-      mDetectedObjectMetadata->mBox.mX -=
-          track_box->class_id * this->class_offset;
-      mDetectedObjectMetadata->mBox.mY -=
-          track_box->class_id * this->class_offset;
-    }
-    mDetectedObjectMetadata->mBox.mWidth =
-        mDetectedObjectMetadata->mBox.mX + track_box->tlwh[2] <
-                objects->mFrame->mSpData->width
-            ? track_box->tlwh[2]
-            : (objects->mFrame->mSpData->width -
-               mDetectedObjectMetadata->mBox.mX);
-    mDetectedObjectMetadata->mBox.mHeight =
-        mDetectedObjectMetadata->mBox.mY + track_box->tlwh[3] <
-                objects->mFrame->mSpData->height
-            ? track_box->tlwh[3]
-            : (objects->mFrame->mSpData->height -
-               mDetectedObjectMetadata->mBox.mY);
+    mDetectedObjectMetadata->mBox = box;
     mDetectedObjectMetadata->mClassify = track_box->class_id;
     mDetectedObjectMetadata->mScores.push_back(track_box->score);
     mTrackedObjectMetadata->mTrackId = track_box->track_id;
@@ -274,6 +324,47 @@ void BYTETracker::update(std::shared_ptr<common::ObjectMetadata>& objects) {
   }
 }
 
+void BYTETracker::output_interpolated(
+    std::shared_ptr<common::ObjectMetadata>& objects) {
+  objects->mDetectedObjectMetadatas.clear();
+  objects->mTrackedObjectMetadatas.clear();
+  objects->mDetectionBatch.reset();
+  int frameWidth = objects->mFrame->mSpData->width;
+  int frameHeight = objects->mFrame->mSpData->height;
+  for (auto& track : this->tracked_stracks) {
+    if (!track->is_activated || track->state != TrackState::Tracked) continue;
+    std::vector<float> tlwh_pred = track->predicted_tlwh();
+    if (tlwh_pred[2] * tlwh_pred[3] <= this->min_box_area) continue;
+
+    common::Rectangle<int> box;
+    box.mX = tlwh_pred[0] < 0 ? 0 : tlwh_pred[0];
+    box.mY = tlwh_pred[1] < 0 ? 0 : tlwh_pred[1];
+    if (!(this->agnostic)) {
+      box.mX -= track->class_id * this->class_offset;
+      box.mY -= track->class_id * this->class_offset;
+    }
+    box.mWidth = box.mX + tlwh_pred[2] < frameWidth ? tlwh_pred[2]
+                                                    : (frameWidth - box.mX);
+    box.mHeight = box.mY + tlwh_pred[3] < frameHeight
+                      ? tlwh_pred[3]
+                      : (frameHeight - box.mY);
+    if (box.mWidth <= 0 || box.mHeight <= 0) continue;
+
+    std::shared_ptr<common::DetectedObjectMetadata> mDetectedObjectMetadata =
+        std::make_shared<common::DetectedObjectMetadata>();
+    std::shared_ptr<common::TrackedObjectMetadata> mTrackedObjectMetadata =
+        std::make_shared<common::TrackedObjectMetadata>();
+    mDetectedObjectMetadata->mBox = box;
+    mDetectedObjectMetadata->mClassify = track->class_id;
+    mDetectedObjectMetadata->mScores.push_back(track->score);
+    mTrackedObjectMetadata->mTrackId = track->track_id;
+    mTrackedObjectMetadata->mInterpolated = true;
+
+    objects->mDetectedObjectMetadatas.push_back(mDetectedObjectMetadata);
+    objects->mTrackedObjectMetadatas.push_back(mTrackedObjectMetadata);
+  }
+}
+
 void BYTETracker::joint_stracks(STracks& tlista, STracks& tlistb,
                                 STracks& results) {
   std::map<int, int> exists;
@@ -386,62 +477,35 @@ void BYTETracker::linear_assignment(
   }
 }
 
-void BYTETracker::ious(std::vector<std::vector<float>>& atlbrs,
-                       std::vector<std::vector<float>>& btlbrs,
-                       std::vector<std::vector<float>>& results) {
-  if (atlbrs.size() * btlbrs.size() == 0) return;
-
-  results.resize(atlbrs.size());
-  for (int i = 0; i < results.size(); i++) {
-    results[i].resize(btlbrs.size());
-  }
-
-  // bbox_ious
-  for (int k = 0; k < btlbrs.size(); k++) {
-    std::vector<float> ious_tmp;
-    float box_area =
-        (btlbrs[k][2] - btlbrs[k][0] + 1) * (btlbrs[k][3] - btlbrs[k][1] + 1);
-    for (int n = 0; n < atlbrs.size(); n++) {
-      float iw = std::min(atlbrs[n][2], btlbrs[k][2]) -
-                 std::max(atlbrs[n][0], btlbrs[k][0]) + 1;
-      if (iw > 0) {
-        float ih = std::min(atlbrs[n][3], btlbrs[k][3]) -
-                   std::max(atlbrs[n][1], btlbrs[k][1]) + 1;
-        if (ih > 0) {
-          float ua = (atlbrs[n][2] - atlbrs[n][0] + 1) *
-                         (atlbrs[n][3] - atlbrs[n][1] + 1) +
-                     box_area - iw * ih;
-          results[n][k] = iw * ih / ua;
-        } else {
-          results[n][k] = 0.0;
-        }
-      } else {
-        results[n][k] = 0.0;
-      }
-    }
-  }
-}
-
 void BYTETracker::iou_distance(const STracks& atracks, const STracks& btracks,
                                std::vector<std::vector<float>>& cost_matrix) {
   if (atracks.size() * btracks.size() == 0) return;
 
-  std::vector<std::vector<float>> atlbrs, btlbrs;
-  for (int i = 0; i < atracks.size(); i++) {
-    atlbrs.push_back(atracks[i]->tlbr);
-  }
-  for (int i = 0; i < btracks.size(); i++) {
-    btlbrs.push_back(btracks[i]->tlbr);
-  }
-
-  std::vector<std::vector<float>> _ious;
-  ious(atlbrs, btlbrs, _ious);
-  for (int i = 0; i < _ious.size(); i++) {
-    std::vector<float> _iou;
-    for (int j = 0; j < _ious[i].size(); j++) {
-      _iou.push_back(1 - _ious[i][j]);
+  // btracks的坐标按列存放，内层循环在连续内存上无分支计算，便于编译器向量化
+  std::size_t nb = btracks.size();
+  std::vector<float> bx1(nb), by1(nb), bx2(nb), by2(nb), barea(nb);
+  for (std::size_t k = 0; k < nb; k++) {
+    const std::vector<float>& b = btracks[k]->tlbr;
+    bx1[k] = b[0];
+    by1[k] = b[1];
+    bx2[k] = b[2];
+    by2[k] = b[3];
+    barea[k] = (b[2] - b[0] + 1) * (b[3] - b[1] + 1);
+  }
+
+  cost_matrix.resize(atracks.size());
+  for (std::size_t n = 0; n < atracks.size(); n++) {
+    const std::vector<float>& a = atracks[n]->tlbr;
+    const float ax1 = a[0], ay1 = a[1], ax2 = a[2], ay2 = a[3];
+    const float aarea = (ax2 - ax1 + 1) * (ay2 - ay1 + 1);
+    cost_matrix[n].resize(nb);
+    float* cost = cost_matrix[n].data();
+    for (std::size_t k = 0; k < nb; k++) {
+      float iw = std::min(ax2, bx2[k]) - std::max(ax1, bx1[k]) + 1;
+      float ih = std::min(ay2, by2[k]) - std::max(ay1, by1[k]) + 1;
+      float inter = std::max(iw, 0.f) * std::max(ih, 0.f);
+      cost[k] = inter > 0 ? 1 - inter / (aarea + barea[k] - inter) : 1.f;
     }
-    cost_matrix.push_back(_iou);
   }
 }
 
@@ -1,185 +1,231 @@
-//===----------------------------------------------------------------------===//
-//
-// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
-//
-// SOPHON-DEMO is licensed under the 2-Clause BSD License except for the
-// third-party components.
-//
-//===----------------------------------------------------------------------===//
-
-#include "bytetrack_strack.h"
-
-namespace sophon_stream {
-namespace element {
-namespace bytetrack {
-
-STrack::STrack(std::vector<float> tlwh_, float score, int class_id) {
-  this->frame_id = 0;
-  this->tracklet_len = 0;
-  this->score = score;
-  this->class_id = class_id;
-  this->start_frame = 0;
-  this->is_activated = false;
-  this->track_id = 0;
-  this->state = TrackState::New;
-
-  _tlwh.resize(4);
-  _tlwh.assign(tlwh_.begin(), tlwh_.end());
-  tlwh.resize(4);
-  tlbr.resize(4);
-  static_tlwh();
-  static_tlbr();
-}
-
-STrack::~STrack() {}
-
-void STrack::activate(std::shared_ptr<KalmanFilter> kalman_filter,
-                      int frame_id) {
-  this->track_id = this->next_id();
-
-  std::vector<float> _tlwh_tmp(4);
-  _tlwh_tmp[0] = this->_tlwh[0];
-  _tlwh_tmp[1] = this->_tlwh[1];
-  _tlwh_tmp[2] = this->_tlwh[2];
-  _tlwh_tmp[3] = this->_tlwh[3];
-  std::vector<float> xyah = tlwh_to_xyah(_tlwh_tmp);
-  cv::Mat xyah_box(1, 4, CV_32F);
-  xyah_box.at<float>(0) = xyah[0];
-  xyah_box.at<float>(1) = xyah[1];
-  xyah_box.at<float>(2) = xyah[2];
-  xyah_box.at<float>(3) = xyah[3];
-  auto mc = kalman_filter->initiate(xyah_box);
-  this->mean = mc.first.clone();
-  this->covariance = mc.second.clone();
-
-  static_tlwh();
-  static_tlbr();
-
-  this->tracklet_len = 0;
-  this->state = TrackState::Tracked;
-  if (frame_id == 1) {
-    this->is_activated = true;
-  }
-  // this->is_activated = true;
-  this->frame_id = frame_id;
-  this->start_frame = frame_id;
-}
-
-void STrack::kalman_correct_box(std::shared_ptr<KalmanFilter> kalman_filter,
-                         std::shared_ptr<STrack> new_track, bool correct_box) {
-  if (correct_box) {
-    std::vector<float> xyah = tlwh_to_xyah(new_track->tlwh);
-    cv::Mat xyah_box(1, 4, CV_32F);
-    xyah_box.at<float>(0) = xyah[0];
-    xyah_box.at<float>(1) = xyah[1];
-    xyah_box.at<float>(2) = xyah[2];
-    xyah_box.at<float>(3) = xyah[3];
-    auto mc = kalman_filter->update(this->mean, this->covariance, xyah_box);
-    this->mean = mc.first.clone();
-    this->covariance = mc.second.clone();
-    static_tlwh();
-  } else {
-    if (this->state == TrackState::New) {
-      this->tlwh = this->_tlwh;
-      return;
-    }
-    this->tlwh = new_track->tlwh;
-  }
-}
-
-void STrack::re_activate(std::shared_ptr<KalmanFilter> kalman_filter,
-                         std::shared_ptr<STrack> new_track, int frame_id,
-                         bool correct_box, bool new_id) {
-  kalman_correct_box(kalman_filter, new_track, correct_box);
-  static_tlbr();
-
-  this->tracklet_len = 0;
-  this->state = TrackState::Tracked;
-  this->is_activated = true;
-  this->frame_id = frame_id;
-  this->score = new_track->score;
-  if (new_id) this->track_id = next_id();
-}
-
-void STrack::update(std::shared_ptr<KalmanFilter> kalman_filter,
-                    std::shared_ptr<STrack> new_track, int frame_id, bool correct_box) {
-  this->frame_id = frame_id;
-  this->tracklet_len++;
-
-  kalman_correct_box(kalman_filter, new_track, correct_box);
-  static_tlbr();
-
-  this->state = TrackState::Tracked;
-  this->is_activated = true;
-  this->score = new_track->score;
-}
-
-void STrack::static_tlwh() {
-  if (this->state == TrackState::New) {
-    tlwh[0] = _tlwh[0];
-    tlwh[1] = _tlwh[1];
-    tlwh[2] = _tlwh[2];
-    tlwh[3] = _tlwh[3];
-    return;
-  }
-
-  tlwh[0] = mean.at<float>(0);
-  tlwh[1] = mean.at<float>(1);
-  tlwh[2] = mean.at<float>(2);
-  tlwh[3] = mean.at<float>(3);
-
-  tlwh[2] *= tlwh[3];
-  tlwh[0] -= tlwh[2] / 2;
-  tlwh[1] -= tlwh[3] / 2;
-}
-
-void STrack::static_tlbr() {
-  tlbr.clear();
-  tlbr.assign(tlwh.begin(), tlwh.end());
-  tlbr[2] += tlbr[0];
-  tlbr[3] += tlbr[1];
-}
-
-std::vector<float> STrack::tlwh_to_xyah(std::vector<float> tlwh_tmp) {
-  std::vector<float> tlwh_output = tlwh_tmp;
-  tlwh_output[0] += tlwh_output[2] / 2;
-  tlwh_output[1] += tlwh_output[3] / 2;
-  tlwh_output[2] /= tlwh_output[3];
-  return tlwh_output;
-}
-
-std::vector<float> STrack::to_xyah() { return tlwh_to_xyah(tlwh); }
-
-std::vector<float> STrack::tlbr_to_tlwh(std::vector<float>& tlbr) {
-  tlbr[2] -= tlbr[0];
-  tlbr[3] -= tlbr[1];
-  return tlbr;
-}
-
-void STrack::mark_lost() { state = TrackState::Lost; }
-
-void STrack::mark_removed() { state = TrackState::Removed; }
-
-int STrack::next_id() {
-  static int _count = 0;
-  _count++;
-  return _count;
-}
-
-int STrack::end_frame() { return this->frame_id; }
-
-void STrack::multi_predict(std::vector<std::shared_ptr<STrack>>& stracks,
-                           std::shared_ptr<KalmanFilter> kalman_filter) {
-  for (int i = 0; i < stracks.size(); i++) {
-    if (stracks[i]->state != TrackState::Tracked) {
-      stracks[i]->mean.at<float>(7) = 0;
-    }
-    auto mc = kalman_filter->predict(stracks[i]->mean, stracks[i]->covariance);
-    stracks[i]->mean = mc.first.clone();
-    stracks[i]->covariance = mc.second.clone();
-  }
-}
-
-}  // namespace bytetrack
-}  // namespace element
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-DEMO is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#include "bytetrack_strack.h"
+
+#include <atomic>
+
+namespace sophon_stream {
+namespace element {
+namespace bytetrack {
+
+namespace {
+
+// 多个线程的tracker同时分配id
+std::atomic<int> track_id_count{0};
+
+}  // namespace
+
+STrack::STrack(std::vector<float> tlwh_, float score, int class_id) {
+  this->frame_id = 0;
+  this->tracklet_len = 0;
+  this->score = score;
+  this->class_id = class_id;
+  this->start_frame = 0;
+  this->is_activated = false;
+  this->track_id = 0;
+  this->state = TrackState::New;
+
+  _tlwh.resize(4);
+  _tlwh.assign(tlwh_.begin(), tlwh_.end());
+  tlwh.resize(4);
+  tlbr.resize(4);
+  static_tlwh();
+  static_tlbr();
+}
+
+STrack::~STrack() {}
+
+void STrack::activate(std::shared_ptr<KalmanFilter> kalman_filter,
+                      int frame_id) {
+  this->track_id = this->next_id();
+
+  std::vector<float> _tlwh_tmp(4);
+  _tlwh_tmp[0] = this->_tlwh[0];
+  _tlwh_tmp[1] = this->_tlwh[1];
+  _tlwh_tmp[2] = this->_tlwh[2];
+  _tlwh_tmp[3] = this->_tlwh[3];
+  std::vector<float> xyah = tlwh_to_xyah(_tlwh_tmp);
+  kalman_filter->initiate({xyah[0], xyah[1], xyah[2], xyah[3]}, this->mean,
+                          this->covariance);
+
+  static_tlwh();
+  static_tlbr();
+
+  this->tracklet_len = 0;
+  this->state = TrackState::Tracked;
+  if (frame_id == 1) {
+    this->is_activated = true;
+  }
+  // this->is_activated = true;
+  this->frame_id = frame_id;
+  this->start_frame = frame_id;
+}
+
+void STrack::kalman_correct_box(std::shared_ptr<KalmanFilter> kalman_filter,
+                         std::shared_ptr<STrack> new_track, bool correct_box) {
+  if (correct_box) {
+    std::vector<float> xyah = tlwh_to_xyah(new_track->tlwh);
+    kalman_filter->update(this->mean, this->covariance,
+                          {xyah[0], xyah[1], xyah[2], xyah[3]});
+    static_tlwh();
+  } else {
+    if (this->state == TrackState::New) {
+      this->tlwh = this->_tlwh;
+      return;
+    }
+    this->tlwh = new_track->tlwh;
+  }
+}
+
+void STrack::re_activate(std::shared_ptr<KalmanFilter> kalman_filter,
+                         std::shared_ptr<STrack> new_track, int frame_id,
+                         bool correct_box, bool new_id) {
+  kalman_correct_box(kalman_filter, new_track, correct_box);
+  static_tlbr();
+
+  this->tracklet_len = 0;
+  this->state = TrackState::Tracked;
+  this->is_activated = true;
+  this->frame_id = frame_id;
+  this->score = new_track->score;
+  if (new_id) this->track_id = next_id();
+}
+
+void STrack::update(std::shared_ptr<KalmanFilter> kalman_filter,
+                    std::shared_ptr<STrack> new_track, int frame_id, bool correct_box) {
+  this->frame_id = frame_id;
+  this->tracklet_len++;
+
+  kalman_correct_box(kalman_filter, new_track, correct_box);
+  static_tlbr();
+
+  this->state = TrackState::Tracked;
+  this->is_activated = true;
+  this->score = new_track->score;
+}
+
+void STrack::static_tlwh() {
+  if (this->state == TrackState::New) {
+    tlwh[0] = _tlwh[0];
+    tlwh[1] = _tlwh[1];
+    tlwh[2] = _tlwh[2];
+    tlwh[3] = _tlwh[3];
+    return;
+  }
+
+  tlwh[0] = mean[0];
+  tlwh[1] = mean[1];
+  tlwh[2] = mean[2];
+  tlwh[3] = mean[3];
+
+  tlwh[2] *= tlwh[3];
+  tlwh[0] -= tlwh[2] / 2;
+  tlwh[1] -= tlwh[3] / 2;
+}
+
+void STrack::static_tlbr() {
+  tlbr.clear();
+  tlbr.assign(tlwh.begin(), tlwh.end());
+  tlbr[2] += tlbr[0];
+  tlbr[3] += tlbr[1];
+}
+
+std::vector<float> STrack::tlwh_to_xyah(std::vector<float> tlwh_tmp) {
+  std::vector<float> tlwh_output = tlwh_tmp;
+  tlwh_output[0] += tlwh_output[2] / 2;
+  tlwh_output[1] += tlwh_output[3] / 2;
+  tlwh_output[2] /= tlwh_output[3];
+  return tlwh_output;
+}
+
+std::vector<float> STrack::to_xyah() { return tlwh_to_xyah(tlwh); }
+
+std::vector<float> STrack::predicted_tlwh() const {
+  std::vector<float> tlwh_tmp(4);
+  tlwh_tmp[3] = mean[3];
+  tlwh_tmp[2] = mean[2] * mean[3];
+  tlwh_tmp[0] = mean[0] - tlwh_tmp[2] / 2;
+  tlwh_tmp[1] = mean[1] - tlwh_tmp[3] / 2;
+  return tlwh_tmp;
+}
+
+std::vector<float> STrack::tlbr_to_tlwh(std::vector<float>& tlbr) {
+  tlbr[2] -= tlbr[0];
+  tlbr[3] -= tlbr[1];
+  return tlbr;
+}
+
+void STrack::mark_lost() { state = TrackState::Lost; }
+
+void STrack::mark_removed() { state = TrackState::Removed; }
+
+int STrack::next_id() { return ++track_id_count; }
+
+int STrack::last_id() { return track_id_count; }
+
+void STrack::restore_last_id(int id) {
+  int current = track_id_count;
+  while (current < id && !track_id_count.compare_exchange_weak(current, id)) {
+  }
+}
+
+int STrack::end_frame() { return this->frame_id; }
+
+void STrack::multi_predict(std::vector<std::shared_ptr<STrack>>& stracks,
+                           std::shared_ptr<KalmanFilter> kalman_filter) {
+  // 每条轨迹的状态只有20个float，原地预测比先拷贝到按列存放的缓存再拷回更快
+  for (auto& strack : stracks) {
+    if (strack->state != TrackState::Tracked) {
+      strack->mean[7] = 0;
+    }
+    kalman_filter->predict(strack->mean, strack->covariance);
+  }
+}
+
+void STrack::save(common::StateWriter& writer) const {
+  writer.write(is_activated);
+  writer.write(track_id);
+  writer.write(state);
+  writer.write(_tlwh);
+  writer.write(tlwh);
+  writer.write(tlbr);
+  writer.write(frame_id);
+  writer.write(tracklet_len);
+  writer.write(start_frame);
+  writer.write(mean);
+  writer.write(covariance);
+  writer.write(score);
+  writer.write(class_id);
+}
+
+std::shared_ptr<STrack> STrack::load(common::StateReader& reader) {
+  auto strack = std::make_shared<STrack>(std::vector<float>(4), 0, 0);
+  reader.read(strack->is_activated);
+  reader.read(strack->track_id);
+  reader.read(strack->state);
+  reader.read(strack->_tlwh);
+  reader.read(strack->tlwh);
+  reader.read(strack->tlbr);
+  reader.read(strack->frame_id);
+  reader.read(strack->tracklet_len);
+  reader.read(strack->start_frame);
+  reader.read(strack->mean);
+  reader.read(strack->covariance);
+  reader.read(strack->score);
+  reader.read(strack->class_id);
+  if (!reader.ok() || strack->_tlwh.size() != 4 ||
+      strack->tlwh.size() != 4 || strack->tlbr.size() != 4)
+    return nullptr;
+  return strack;
+}
+
+}  // namespace bytetrack
+}  // namespace element
 }  // namespace sophon_stream
\ No newline at end of file
@@ -244,7 +244,8 @@ namespace lightstereo {
         int outDataPipeId =
             getSinkElementFlag()
                 ? 0
-                : (channel_id_internal % getOutputConnectorCapacity(outputPorts[0]));
+                : getOutputDataPipeId(outputPorts[0], channel_id_internal,
+                                      objectMetadata->mFrame->mEndOfStream);
         errorCode =
             pushOutputData(outputPorts[0], outDataPipeId,
                           std::static_pointer_cast<void>(objectMetadata));
@@ -260,7 +261,8 @@ namespace lightstereo {
         int outDataPipeId =
             getSinkElementFlag()
                 ? 0
-                : (channel_id_internal % getOutputConnectorCapacity(outputPorts[1]));
+                : getOutputDataPipeId(outputPorts[1], channel_id_internal,
+                                      objectMetadata->mFrame->mEndOfStream);
         errorCode =
             pushOutputData(outputPorts[1], outDataPipeId,
                           std::static_pointer_cast<void>(objectMetadata));
@@ -278,7 +280,8 @@ namespace lightstereo {
         int outDataPipeId =
             getSinkElementFlag()
                 ? 0
-                : (channel_id_internal % getOutputConnectorCapacity(outputPorts[0]));
+                : getOutputDataPipeId(outputPorts[0], channel_id_internal,
+                                      objectMetadata->mFrame->mEndOfStream);
         errorCode =
             pushOutputData(outputPorts[0], outDataPipeId,
                           std::static_pointer_cast<void>(objectMetadata));
@@ -10,6 +10,7 @@
 #ifndef SOPHON_STREAM_ELEMENT_LPRNET_POST_PROCESS_H_
 #define SOPHON_STREAM_ELEMENT_LPRNET_POST_PROCESS_H_
 
+#include "algorithmApi/ctc_decoder.h"
 #include "algorithmApi/post_process.h"
 #include "lprnet_context.h"
 
@@ -27,10 +28,6 @@ class LprnetPostProcess : public ::sophon_stream::element::PostProcess {
    */
   void postProcess(std::shared_ptr<LprnetContext> context,
                    common::ObjectMetadatas& objectMetadatas);
-
- private:
-  std::string get_res(int pred_num[], int len_char, int clas_char);
-  int argmax(float* data, int num);
 };
 
 }  // namespace lprnet
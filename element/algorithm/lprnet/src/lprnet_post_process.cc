@@ -21,53 +21,15 @@ static char const* arr_chars[] = {
     "H",  "J",  "K",  "L",  "M",  "N",  "P",  "Q",  "R",  "S",  "T",  "U",
     "V",  "W",  "X",  "Y",  "Z",  "I",  "O",  "-"};
 
-int LprnetPostProcess::argmax(float* data, int num) {
-    float max_value = -1e10;
-    int max_index = 0;
-    for (int i = 0; i < num; ++i) {
-        float value = data[i];
-        if (value > max_value) {
-            max_value = value;
-            max_index = i;
-        }
-    }
-    return max_index;
-}
-
-std::string LprnetPostProcess::get_res(int pred_num[], int len_char, int clas_char) {
-    int no_repeat_blank[20];
-    int cn_no_repeat_blank = 0;
-    int pre_c = pred_num[0];
-    if (pre_c != clas_char - 1) {
-        no_repeat_blank[0] = pre_c;
-        cn_no_repeat_blank++;
-    }
-    for (int i = 0; i < len_char; i++) {
-        if (pred_num[i] == pre_c)
-            continue;
-        if (pred_num[i] == clas_char - 1) {
-            pre_c = pred_num[i];
-            continue;
-        }
-        no_repeat_blank[cn_no_repeat_blank] = pred_num[i];
-        pre_c = pred_num[i];
-        cn_no_repeat_blank++;
-    }
-
-    std::string res = "";
-    for (int j = 0; j < cn_no_repeat_blank; j++) {
-        res = res + arr_chars[no_repeat_blank[j]];
-    }
-
-    return res;
-}
-
-
 void LprnetPostProcess::init(std::shared_ptr<LprnetContext> context) {}
 
 void LprnetPostProcess::postProcess(std::shared_ptr<LprnetContext> context,
                                     common::ObjectMetadatas& objectMetadatas) {
     if (objectMetadatas.size() == 0) return;
+
+    CtcDecoder decoder;
+    decoder.configure(context->clas_char - 1, 1);
+    CtcDecoder::Result result;
     
     int idx = 0;  
     // get 1 batch data 
@@ -86,22 +48,16 @@ void LprnetPostProcess::postProcess(std::shared_ptr<LprnetContext> context,
         }
 
         float* output_data = nullptr;
-        float ptr[context->clas_char];
-        int pred_num[context->len_char];    
         
         for (int i = 0; i < context->output_num; i++) {
         auto out_tensor = outputTensors[i];
         output_data =
             (float*)out_tensor->get_cpu_data();
-        for (int j = 0; j < context->len_char; j++) {
-            for (int k = 0; k < context->clas_char; k++) {
-                ptr[k] = *(output_data + k * context->len_char + j);
-            }
-            int class_id = argmax(&ptr[0], context->clas_char);
-            float confidence = ptr[class_id];
-            pred_num[j] = class_id;      
-        }
-        std::string res = get_res(pred_num, context->len_char, context->clas_char);
+        // 输出按[clas_char][len_char]存放，blank为最后一类
+        decoder.greedyClassMajor(output_data, context->len_char,
+                                 context->clas_char, result);
+        std::string res;
+        for (int label : result.labels) res += arr_chars[label];
         std::shared_ptr<common::RecognizedObjectMetadata> detData =
                   std::make_shared<common::RecognizedObjectMetadata>();   
         detData->mLabelName = res;
@@ -0,0 +1,93 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SOPHON_STREAM_ELEMENT_OPENPOSE_CPU_DECODER_H_
+#define SOPHON_STREAM_ELEMENT_OPENPOSE_CPU_DECODER_H_
+
+#include <memory>
+#include <vector>
+
+#include "common/posed_object_metadata.h"
+
+namespace sophon_stream {
+namespace element {
+namespace openpose {
+
+/**
+ * @brief openpose的CPU后处理：关键点峰值检测与肢体连接
+ * @brief
+ * 峰值检测按4个像素一组做3x3邻域比较；肢体连接的PAF线积分在确定无法达到
+ * interMinAboveThreshold时提前结束，候选连接和人体子集保存在平铺的数组中，
+ * 多次调用之间复用。输出与原逐像素、逐候选对的实现完全一致。
+ * 不加锁，每个线程使用各自的实例
+ */
+class OpenposeCpuDecoder {
+ public:
+  /**
+   * @brief 单个通道的峰值检测
+   * @param map 热力图，大小为h * w
+   * @param maxPeaks 最多输出的峰值数，按光栅顺序
+   * @param threshold 峰值下限
+   * @param peaks 输出，[0]为峰值数，之后每3个数为一个峰值的亚像素x、y和得分
+   */
+  static void findPeaks(const float* map, int h, int w, int maxPeaks,
+                        float threshold, float* peaks);
+
+  /**
+   * @brief 按PAF把各关键点的峰值连接成人体
+   * @param heatMapPtr 热力图和PAF，每个通道width * height
+   * @param peaksPtr findPeaks的输出，每个通道3 * (maxPeaks + 1)个数
+   * @param bodyPartPairs 肢体两端的关键点下标
+   * @param mapIdx 每个肢体对应的PAF x、y通道
+   * @param maxPeople 最多输出的人数
+   */
+  void connect(
+      std::vector<std::shared_ptr<common::PosedObjectMetadata>>& poseKeypoints,
+      const float* heatMapPtr, const float* peaksPtr, int width, int height,
+      int maxPeaks, int interMinAboveThreshold, float interThreshold,
+      int minSubsetCnt, float minSubsetScore, float scaleFactor,
+      const std::vector<unsigned int>& bodyPartPairs,
+      const std::vector<unsigned int>& mapIdx, int numberBodyParts,
+      int maxPeople, common::PosedObjectMetadata::EModelType modelType);
+
+ private:
+  struct Candidate {
+    double score;
+    int a;
+    int b;
+  };
+  struct Connection {
+    int indexA;
+    int indexB;
+    double score;
+  };
+
+  // 计算一个肢体所有候选对的PAF得分，结果按得分从高到低排序
+  void scoreCandidates(const float* candidateA, int nA, const float* candidateB,
+                       int nB, const float* mapX, const float* mapY, int width,
+                       int height, int interMinAboveThreshold,
+                       float interThreshold);
+  int* row(int index) { return &mSubset[index * mSubsetSize]; }
+  int addRow();
+  bool hasPart(int part, int index);
+
+  int mSubsetSize = 0;
+  std::vector<int> mSubset;  // 每行为各关键点的峰值偏移，最后一位是关键点数
+  std::vector<double> mSubsetScores;
+  std::vector<Candidate> mCandidates;
+  std::vector<Connection> mConnections;
+  std::vector<char> mOccurA;
+  std::vector<char> mOccurB;
+};
+
+}  // namespace openpose
+}  // namespace element
+}  // namespace sophon_stream
+
+#endif  // SOPHON_STREAM_ELEMENT_OPENPOSE_CPU_DECODER_H_
@@ -14,6 +14,7 @@
 
 #include "algorithmApi/post_process.h"
 #include "openpose_context.h"
+#include "openpose_cpu_decoder.h"
 
 using namespace sophon_stream::common;
 
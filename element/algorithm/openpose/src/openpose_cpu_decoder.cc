@@ -0,0 +1,346 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#include "openpose_cpu_decoder.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace sophon_stream {
+namespace element {
+namespace openpose {
+
+namespace {
+
+inline int intRound(const float a) { return int(a + 0.5f); }
+
+inline bool isPeak(const float* up, const float* mid, const float* down, int x,
+                   float threshold) {
+  float value = mid[x];
+  return value > threshold && value > up[x - 1] && value > up[x] &&
+         value > up[x + 1] && value > mid[x - 1] && value > mid[x + 1] &&
+         value > down[x - 1] && value > down[x] && value > down[x + 1];
+}
+
+#if defined(__aarch64__) || defined(__SSE2__)
+// mid[x, x + 4)中峰值的位掩码，第k位对应x + k
+inline int peakMask4(const float* up, const float* mid, const float* down,
+                     int x, float threshold) {
+#if defined(__aarch64__)
+  float32x4_t v = vld1q_f32(mid + x);
+  uint32x4_t m = vcgtq_f32(v, vdupq_n_f32(threshold));
+  if (vmaxvq_u32(m) == 0) return 0;
+  m = vandq_u32(m, vcgtq_f32(v, vld1q_f32(mid + x - 1)));
+  m = vandq_u32(m, vcgtq_f32(v, vld1q_f32(mid + x + 1)));
+  m = vandq_u32(m, vcgtq_f32(v, vld1q_f32(up + x - 1)));
+  m = vandq_u32(m, vcgtq_f32(v, vld1q_f32(up + x)));
+  m = vandq_u32(m, vcgtq_f32(v, vld1q_f32(up + x + 1)));
+  m = vandq_u32(m, vcgtq_f32(v, vld1q_f32(down + x - 1)));
+  m = vandq_u32(m, vcgtq_f32(v, vld1q_f32(down + x)));
+  m = vandq_u32(m, vcgtq_f32(v, vld1q_f32(down + x + 1)));
+  const uint32x4_t bits = {1, 2, 4, 8};
+  return vaddvq_u32(vandq_u32(m, bits));
+#else
+  __m128 v = _mm_loadu_ps(mid + x);
+  __m128 m = _mm_cmpgt_ps(v, _mm_set1_ps(threshold));
+  if (_mm_movemask_ps(m) == 0) return 0;
+  m = _mm_and_ps(m, _mm_cmpgt_ps(v, _mm_loadu_ps(mid + x - 1)));
+  m = _mm_and_ps(m, _mm_cmpgt_ps(v, _mm_loadu_ps(mid + x + 1)));
+  m = _mm_and_ps(m, _mm_cmpgt_ps(v, _mm_loadu_ps(up + x - 1)));
+  m = _mm_and_ps(m, _mm_cmpgt_ps(v, _mm_loadu_ps(up + x)));
+  m = _mm_and_ps(m, _mm_cmpgt_ps(v, _mm_loadu_ps(up + x + 1)));
+  m = _mm_and_ps(m, _mm_cmpgt_ps(v, _mm_loadu_ps(down + x - 1)));
+  m = _mm_and_ps(m, _mm_cmpgt_ps(v, _mm_loadu_ps(down + x)));
+  m = _mm_and_ps(m, _mm_cmpgt_ps(v, _mm_loadu_ps(down + x + 1)));
+  return _mm_movemask_ps(m);
+#endif
+}
+#endif
+
+// 以峰值为中心的7x7区域按得分加权计算亚像素坐标
+inline void refinePeak(const float* map, int h, int w, int x, int y,
+                       float* peak) {
+  float xAcc = 0;
+  float yAcc = 0;
+  float scoreAcc = 0;
+  for (int kx = -3; kx <= 3; ++kx) {
+    int ux = x + kx;
+    if (ux >= 0 && ux < w) {
+      for (int ky = -3; ky <= 3; ++ky) {
+        int uy = y + ky;
+        if (uy >= 0 && uy < h) {
+          float score = map[uy * w + ux];
+          xAcc += ux * score;
+          yAcc += uy * score;
+          scoreAcc += score;
+        }
+      }
+    }
+  }
+  peak[0] = xAcc / scoreAcc;
+  peak[1] = yAcc / scoreAcc;
+  peak[2] = map[y * w + x];
+}
+
+}  // namespace
+
+void OpenposeCpuDecoder::findPeaks(const float* map, int h, int w,
+                                   int maxPeaks, float threshold,
+                                   float* peaks) {
+  int numPeaks = 0;
+  for (int y = 1; y < h - 1 && numPeaks != maxPeaks; ++y) {
+    const float* up = map + (y - 1) * w;
+    const float* mid = map + y * w;
+    const float* down = map + (y + 1) * w;
+    int x = 1;
+#if defined(__aarch64__) || defined(__SSE2__)
+    for (; x + 4 <= w - 1 && numPeaks != maxPeaks; x += 4) {
+      int mask = peakMask4(up, mid, down, x, threshold);
+      while (mask != 0 && numPeaks != maxPeaks) {
+        int k = __builtin_ctz(mask);
+        mask &= mask - 1;
+        refinePeak(map, h, w, x + k, y, peaks + (numPeaks + 1) * 3);
+        numPeaks++;
+      }
+    }
+#endif
+    for (; x < w - 1 && numPeaks != maxPeaks; ++x) {
+      if (!isPeak(up, mid, down, x, threshold)) continue;
+      refinePeak(map, h, w, x, y, peaks + (numPeaks + 1) * 3);
+      numPeaks++;
+    }
+  }
+  peaks[0] = numPeaks;
+}
+
+int OpenposeCpuDecoder::addRow() {
+  mSubset.resize(mSubset.size() + mSubsetSize, 0);
+  mSubsetScores.push_back(0);
+  return mSubsetScores.size() - 1;
+}
+
+bool OpenposeCpuDecoder::hasPart(int part, int index) {
+  for (int j = 0; j < static_cast<int>(mSubsetScores.size()); j++)
+    if (row(j)[part] == index) return true;
+  return false;
+}
+
+void OpenposeCpuDecoder::scoreCandidates(
+    const float* candidateA, int nA, const float* candidateB, int nB,
+    const float* mapX, const float* mapY, int width, int height,
+    int interMinAboveThreshold, float interThreshold) {
+  const int numInter = 10;
+  mCandidates.clear();
+  for (int i = 1; i <= nA; i++) {
+    const float sX = candidateA[i * 3];
+    const float sY = candidateA[i * 3 + 1];
+    for (int j = 1; j <= nB; j++) {
+      const float dX = candidateB[j * 3] - sX;
+      const float dY = candidateB[j * 3 + 1] - sY;
+      const float normVec = float(std::sqrt(dX * dX + dY * dY));
+      // If the peaks are coincident. Don't connect them.
+      if (!(normVec > 1e-6)) continue;
+      const float vecX = dX / normVec;
+      const float vecY = dY / normVec;
+
+      double sum = 0.;
+      int count = 0;
+      for (int lm = 0; lm < numInter; lm++) {
+        // 剩余的采样点全部高于阈值也不够interMinAboveThreshold时不再计算
+        if (count + numInter - lm <= interMinAboveThreshold) break;
+        const int mX = std::min(width - 1, intRound(sX + lm * dX / numInter));
+        const int mY = std::min(height - 1, intRound(sY + lm * dY / numInter));
+        const int idx = mY * width + mX;
+        const float score = (vecX * mapX[idx] + vecY * mapY[idx]);
+        if (score > interThreshold) {
+          sum += score;
+          count++;
+        }
+      }
+
+      if (count > interMinAboveThreshold)
+        mCandidates.push_back({sum / count, i, j});
+    }
+  }
+
+  // 与按std::tuple<float, int, int>降序排序一致
+  std::sort(mCandidates.begin(), mCandidates.end(),
+            [](const Candidate& l, const Candidate& r) {
+              float ls = l.score, rs = r.score;
+              if (ls != rs) return ls > rs;
+              if (l.a != r.a) return l.a > r.a;
+              return l.b > r.b;
+            });
+}
+
+void OpenposeCpuDecoder::connect(
+    std::vector<std::shared_ptr<common::PosedObjectMetadata>>& poseKeypoints,
+    const float* heatMapPtr, const float* peaksPtr, int width, int height,
+    int maxPeaks, int interMinAboveThreshold, float interThreshold,
+    int minSubsetCnt, float minSubsetScore, float scaleFactor,
+    const std::vector<unsigned int>& bodyPartPairs,
+    const std::vector<unsigned int>& mapIdx, int numberBodyParts,
+    int maxPeople, common::PosedObjectMetadata::EModelType modelType) {
+  const int numberBodyPartPairs = bodyPartPairs.size() / 2;
+  const int subsetCounterIndex = numberBodyParts;
+  const int peaksOffset = 3 * (maxPeaks + 1);
+  const int heatMapOffset = width * height;
+  mSubsetSize = numberBodyParts + 1;
+  mSubset.clear();
+  mSubsetScores.clear();
+
+  for (int pairIndex = 0; pairIndex < numberBodyPartPairs; pairIndex++) {
+    const int bodyPartA = bodyPartPairs[2 * pairIndex];
+    const int bodyPartB = bodyPartPairs[2 * pairIndex + 1];
+    const float* candidateA = peaksPtr + bodyPartA * peaksOffset;
+    const float* candidateB = peaksPtr + bodyPartB * peaksOffset;
+    const int nA = intRound(candidateA[0]);
+    const int nB = intRound(candidateB[0]);
+
+    // 一端没有峰值时，另一端未出现过的峰值各自成为一个人
+    if (nA == 0 || nB == 0) {
+      const int part = nA == 0 ? bodyPartB : bodyPartA;
+      const float* candidate = nA == 0 ? candidateB : candidateA;
+      const int n = nA == 0 ? nB : nA;
+      for (int i = 1; i <= n; i++) {
+        const int off = part * peaksOffset + i * 3 + 2;
+        if (hasPart(part, off)) continue;
+        int r = addRow();
+        row(r)[part] = off;
+        row(r)[subsetCounterIndex] = 1;
+        mSubsetScores[r] = candidate[i * 3 + 2];
+      }
+      continue;
+    }
+
+    scoreCandidates(candidateA, nA, candidateB, nB,
+                    heatMapPtr + mapIdx[2 * pairIndex] * heatMapOffset,
+                    heatMapPtr + mapIdx[2 * pairIndex + 1] * heatMapOffset,
+                    width, height, interMinAboveThreshold, interThreshold);
+
+    // 贪心选取得分最高且两端都未被占用的连接，最多min(nA, nB)个
+    mConnections.clear();
+    const int minAB = std::min(nA, nB);
+    mOccurA.assign(nA, 0);
+    mOccurB.assign(nB, 0);
+    for (const Candidate& candidate : mCandidates) {
+      if (mOccurA[candidate.a - 1] || mOccurB[candidate.b - 1]) continue;
+      mConnections.push_back({bodyPartA * peaksOffset + candidate.a * 3 + 2,
+                              bodyPartB * peaksOffset + candidate.b * 3 + 2,
+                              candidate.score});
+      if (static_cast<int>(mConnections.size()) == minAB) break;
+      mOccurA[candidate.a - 1] = 1;
+      mOccurB[candidate.b - 1] = 1;
+    }
+
+    if (pairIndex == 0) {
+      for (const Connection& connection : mConnections) {
+        int r = addRow();
+        row(r)[bodyPartPairs[0]] = connection.indexA;
+        row(r)[bodyPartPairs[1]] = connection.indexB;
+        row(r)[subsetCounterIndex] = 2;
+        mSubsetScores[r] = peaksPtr[connection.indexA] +
+                           peaksPtr[connection.indexB] + connection.score;
+      }
+    } else if ((numberBodyParts == 18 &&
+                (pairIndex == 17 || pairIndex == 18)) ||
+               ((numberBodyParts == 19 || (numberBodyParts == 25) ||
+                 numberBodyParts == 59 || numberBodyParts == 65) &&
+                (pairIndex == 18 || pairIndex == 19))) {
+      // 耳朵的连接只补全已有的人
+      for (const Connection& connection : mConnections) {
+        for (int j = 0; j < static_cast<int>(mSubsetScores.size()); j++) {
+          int& partA = row(j)[bodyPartA];
+          int& partB = row(j)[bodyPartB];
+          if (partA == connection.indexA && partB == 0)
+            partB = connection.indexB;
+          else if (partB == connection.indexB && partA == 0)
+            partA = connection.indexA;
+        }
+      }
+    } else {
+      for (const Connection& connection : mConnections) {
+        int num = 0;
+        int rows = mSubsetScores.size();
+        for (int j = 0; j < rows; j++) {
+          int* subsetJ = row(j);
+          if (subsetJ[bodyPartA] == connection.indexA) {
+            subsetJ[bodyPartB] = connection.indexB;
+            num++;
+            subsetJ[subsetCounterIndex] = subsetJ[subsetCounterIndex] + 1;
+            mSubsetScores[j] = mSubsetScores[j] +
+                               peaksPtr[connection.indexB] + connection.score;
+          }
+        }
+        if (num == 0) {
+          int r = addRow();
+          row(r)[bodyPartA] = connection.indexA;
+          row(r)[bodyPartB] = connection.indexB;
+          row(r)[subsetCounterIndex] = 2;
+          mSubsetScores[r] = peaksPtr[connection.indexA] +
+                             peaksPtr[connection.indexB] + connection.score;
+        }
+      }
+    }
+  }
+
+  // 去掉关键点数少于minSubsetCnt或平均得分不超过minSubsetScore的人，
+  // 最多保留前maxPeople个
+  std::vector<int> validSubsetIndexes;
+  for (int index = 0; index < static_cast<int>(mSubsetScores.size());
+       index++) {
+    const int subsetCounter = row(index)[subsetCounterIndex];
+    const double subsetScore = mSubsetScores[index];
+    if (subsetCounter >= minSubsetCnt &&
+        (subsetScore / subsetCounter) > minSubsetScore) {
+      validSubsetIndexes.push_back(index);
+      if (static_cast<int>(validSubsetIndexes.size()) == maxPeople) break;
+    } else if (subsetCounter < 1)
+      printf(
+          "Bad subsetCounter. Bug in this function if this happens. "
+          "%d, %s, %s",
+          __LINE__, __FUNCTION__, __FILE__);
+  }
+
+  poseKeypoints.resize(validSubsetIndexes.size());
+  for (std::size_t person = 0; person < validSubsetIndexes.size(); person++) {
+    std::shared_ptr<common::PosedObjectMetadata> poseData =
+        std::make_shared<common::PosedObjectMetadata>();
+    const int* subsetI = row(validSubsetIndexes[person]);
+    poseData->keypoints.resize(numberBodyParts * 3);
+    for (int bodyPart = 0; bodyPart < numberBodyParts; bodyPart++) {
+      const int baseOffset = bodyPart * 3;
+      const int bodyPartIndex = subsetI[bodyPart];
+      if (bodyPartIndex > 0) {
+        poseData->keypoints[baseOffset] =
+            peaksPtr[bodyPartIndex - 2] * scaleFactor;
+        poseData->keypoints[baseOffset + 1] =
+            peaksPtr[bodyPartIndex - 1] * scaleFactor;
+        poseData->keypoints[baseOffset + 2] = peaksPtr[bodyPartIndex];
+      } else {
+        poseData->keypoints[baseOffset] = 0.f;
+        poseData->keypoints[baseOffset + 1] = 0.f;
+        poseData->keypoints[baseOffset + 2] = 0.f;
+      }
+    }
+    poseData->modeltype = modelType;
+    poseKeypoints[person] = poseData;
+  }
+}
+
+}  // namespace openpose
+}  // namespace element
+}  // namespace sophon_stream
@@ -75,6 +75,8 @@ class Posec3d : public ::sophon_stream::framework::Element {
   static constexpr const char* CONFIG_INTERNAL_CLASS_NAMES_FILE_FIELD =
       "class_names_file";
   static constexpr const char* CONFIG_INTERNAL_FRAMES_NUM_FIELD = "frames_num";
+  static constexpr const char* CONFIG_INTERNAL_WINDOW_STRIDE_FIELD =
+      "window_stride";
 
  private:
   std::shared_ptr<Posec3dContext> mContext;          // context对象
@@ -29,6 +29,7 @@ class Posec3dContext : public ::sophon_stream::element::Context {
   int m_frame_h, m_frame_w;
   int m_net_crops_clips, m_net_channel, m_net_keypoints, net_h, net_w;
   int max_batch;
+  int window_stride;  // 相邻两次识别之间的新帧数，小于max_batch时窗口重叠
   int input_num;
   int output_num;
 
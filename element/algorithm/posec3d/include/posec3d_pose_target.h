@@ -0,0 +1,82 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SOPHON_STREAM_ELEMENT_POSEC3D_POSE_TARGET_H_
+#define SOPHON_STREAM_ELEMENT_POSEC3D_POSE_TARGET_H_
+
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace sophon_stream {
+namespace element {
+namespace posec3d {
+
+using fpptr_dim3 = std::vector<
+    std::shared_ptr<std::vector<std::shared_ptr<std::vector<float>>>>>;
+using fpptr_dim2 = std::vector<std::shared_ptr<std::vector<float>>>;
+
+/**
+ * @brief 生成模型输入heatmap
+ * @brief
+ * 每个源帧的heatmap只渲染一次，高斯按x、y方向分离计算，再按inds复制到各个采样位置。
+ * heatmap前后两半为两个crop，内容相同
+ * @param keypoints 源帧关键点，已按heatmap尺寸缩放
+ * @param keypoint_scores 源帧关键点置信度，小于1e-4的关键点不渲染
+ * @param inds 每个采样位置对应的源帧下标，共num_clips * clip_len个
+ * @param img_h heatmap高
+ * @param img_w heatmap宽
+ * @param num_c 关键点个数
+ * @param input_scale 输出值的缩放系数
+ * @param sigma 高斯标准差
+ * @param clip_len 每次裁剪的长度
+ * @param heatmap 输出heatmap的指针
+ * @param out_num 输出heatmap的长度
+ */
+void renderPoseTarget(const fpptr_dim3& keypoints,
+                      const fpptr_dim3& keypoint_scores,
+                      const std::vector<int>& inds, int img_h, int img_w,
+                      int num_c, float input_scale, float sigma, int clip_len,
+                      float* heatmap, int out_num);
+
+/**
+ * @brief 每路码流最近若干帧的关键点和置信度，用于重叠的滑动窗口
+ */
+class PoseWindow {
+ public:
+  /**
+   * @brief 把新到达的帧追加到该路码流的历史中，并用最近window_size帧替换keypoints
+   * @param channelId 码流的内部通道号
+   * @param window_size 窗口帧数
+   * @param keypoints 输入新帧的关键点，输出窗口内所有帧关键点的深拷贝
+   * @param keypoint_scores 输入新帧的关键点置信度，输出窗口内所有帧的置信度
+   */
+  void slide(int channelId, int window_size, fpptr_dim3& keypoints,
+             fpptr_dim3& keypoint_scores);
+
+  /**
+   * @brief 清空一路码流的历史
+   */
+  void reset(int channelId);
+
+ private:
+  std::map<int, std::deque<std::pair<std::shared_ptr<fpptr_dim2>,
+                                     std::shared_ptr<fpptr_dim2>>>>
+      mHistory;
+  std::mutex mMutex;
+};
+
+}  // namespace posec3d
+}  // namespace element
+}  // namespace sophon_stream
+
+#endif  // SOPHON_STREAM_ELEMENT_POSEC3D_POSE_TARGET_H_
@@ -12,15 +12,12 @@
 
 #include "algorithmApi/pre_process.h"
 #include "posec3d_context.h"
+#include "posec3d_pose_target.h"
 
 namespace sophon_stream {
 namespace element {
 namespace posec3d {
 
-using fpptr_dim3 = std::vector<
-    std::shared_ptr<std::vector<std::shared_ptr<std::vector<float>>>>>;
-using fpptr_dim2 = std::vector<std::shared_ptr<std::vector<float>>>;
-
 class Posec3dPreProcess : public ::sophon_stream::element::PreProcess {
  public:
   /**
@@ -34,19 +31,24 @@ class Posec3dPreProcess : public ::sophon_stream::element::PreProcess {
                                common::ObjectMetadatas& objectMetadatas);
   void init(std::shared_ptr<Posec3dContext> context);
 
+  /**
+   * @brief 清空一路码流的滑动窗口历史，码流结束时调用
+   * @param channelId 码流的内部通道号
+   */
+  void resetHistory(int channelId);
+
  private:
   /**
-   * @brief 对一个batch的数据做重采样
-   * @param sampled_keypoints 重采样关键点结果
-   * @param sampled_keypoint_scores 重采样关键点置信度结果
+   * @brief 计算重采样的帧下标
+   * @param num_frames 参与重采样的源帧数
+   * @param inds 输出num_clips * clip_len个源帧下标
    * @param clip_len 每次裁剪的长度
    * @param num_clips 裁剪次数
    * @param seed 当帧数大于裁剪长度时裁剪时的随机种子
    * @return common::ErrorCode
    * common::ErrorCode::SUCCESS，中间过程失败会中断执行
    */
-  common::ErrorCode uniformSampleFrames(fpptr_dim3& sampled_keypoints,
-                                        fpptr_dim3& sampled_keypoint_scores,
+  common::ErrorCode uniformSampleFrames(int num_frames, std::vector<int>& inds,
                                         int clip_len, int num_clips, int seed);
 
   /**
@@ -96,10 +98,11 @@ class Posec3dPreProcess : public ::sophon_stream::element::PreProcess {
                                std::vector<int>& crop_size);
 
   /**
-   * @brief 生成模型输入heatmap
+   * @brief 按scaling缩放关键点后用renderPoseTarget生成模型输入heatmap
    * @param context context指针
-   * @param sampled_keypoints 来自uniformSampleFrames输出的重采样关键点结果
-   * @param sampled_keypoint_scores 关键点输入
+   * @param keypoints centerCrop输出的源帧关键点
+   * @param keypoint_scores 源帧关键点置信度
+   * @param inds uniformSampleFrames输出的源帧下标
    * @param new_shape centerCrop输出的新长宽
    * @param heatmap 输出heatmap的指针
    * @param out_num 输出heatmap的长度
@@ -111,8 +114,8 @@ class Posec3dPreProcess : public ::sophon_stream::element::PreProcess {
    */
   common::ErrorCode generatePoseTarget(std::shared_ptr<Posec3dContext> context,
                                        fpptr_dim3& keypoints,
-                                       fpptr_dim3& sampled_keypoints,
-                                       fpptr_dim3& sampled_keypoint_scores,
+                                       fpptr_dim3& keypoint_scores,
+                                       std::vector<int>& inds,
                                        std::vector<int>& new_shape,
                                        float* heatmap, int out_num, float sigma,
                                        float scaling, int clip_len);
@@ -124,6 +127,9 @@ class Posec3dPreProcess : public ::sophon_stream::element::PreProcess {
    */
   void initTensors(std::shared_ptr<Posec3dContext> context,
                    common::ObjectMetadatas& objectMetadatas);
+
+  // 每路码流最近max_batch帧的关键点和置信度，仅在window_stride小于frames_num时使用
+  PoseWindow mWindow;
 };
 
 }  // namespace posec3d
@@ -9,6 +9,8 @@
 
 #include "posec3d.h"
 
+#include "common/logger.h"
+
 using namespace std::chrono_literals;
 
 namespace sophon_stream {
@@ -43,6 +45,18 @@ common::ErrorCode Posec3d::initContext(const std::string& json) {
     // 2. get input
     auto frameNum = configure.find(CONFIG_INTERNAL_FRAMES_NUM_FIELD);
     mContext->max_batch = frameNum->get<int>();
+    mContext->window_stride = mContext->max_batch;
+    auto windowStrideIt = configure.find(CONFIG_INTERNAL_WINDOW_STRIDE_FIELD);
+    if (configure.end() != windowStrideIt) {
+      int stride = windowStrideIt->get<int>();
+      if (stride <= 0 || stride > mContext->max_batch) {
+        IVS_ERROR("window_stride should be in [1, {0}], got {1}",
+                  mContext->max_batch, stride);
+        errorCode = common::ErrorCode::PARSE_CONFIGURE_FAIL;
+        break;
+      }
+      mContext->window_stride = stride;
+    }
     auto inputTensor = mContext->bmNetwork->inputTensor(0);
     mContext->input_num = mContext->bmNetwork->m_netinfo->input_num;
     mContext->m_net_crops_clips = inputTensor->get_shape()->dims[0];
@@ -73,7 +87,7 @@ common::ErrorCode Posec3d::initContext(const std::string& json) {
     // 4.converto
     mContext->input_scale = inputTensor->get_scale();
   } while (false);
-  return common::ErrorCode::SUCCESS;
+  return errorCode;
 }
 
 common::ErrorCode Posec3d::initInternal(const std::string& json) {
@@ -117,7 +131,8 @@ common::ErrorCode Posec3d::initInternal(const std::string& json) {
     }
 
     mContext->deviceId = getDeviceId();
-    initContext(configure.dump());
+    errorCode = initContext(configure.dump());
+    if (common::ErrorCode::SUCCESS != errorCode) break;
     // 前处理初始化
     mPreProcess->init(mContext);
     // 推理初始化
@@ -170,7 +185,7 @@ common::ErrorCode Posec3d::doWork(int dataPipeId) {
   common::ObjectMetadatas pendingObjectMetadatas;
 
   if (use_pre) {
-    while (objectMetadatas.size() < mContext->max_batch &&
+    while (objectMetadatas.size() < mContext->window_stride &&
            (getThreadStatus() == ThreadStatus::RUN)) {
       // 如果队列为空则等待
       auto data = popInputData(inputPort, dataPipeId);
@@ -188,7 +203,7 @@ common::ErrorCode Posec3d::doWork(int dataPipeId) {
       if (!objectMetadata->mFilter) objectMetadatas.push_back(objectMetadata);
     }
   } else {
-    while (pendingObjectMetadatas.size() < mContext->max_batch &&
+    while (pendingObjectMetadatas.size() < mContext->window_stride &&
            (getThreadStatus() == ThreadStatus::RUN)) {
       // 如果队列为空则等待
       auto data = popInputData(inputPort, dataPipeId);
@@ -212,6 +227,11 @@ common::ErrorCode Posec3d::doWork(int dataPipeId) {
 
   process(objectMetadatas);
 
+  if (use_pre && !pendingObjectMetadatas.empty() &&
+      pendingObjectMetadatas.back()->mFrame->mEndOfStream)
+    mPreProcess->resetHistory(
+        pendingObjectMetadatas.back()->mFrame->mChannelIdInternal);
+
   if (use_post && objectMetadatas.size() > 0) {
     // for all frames, they have the same action label
     for (auto& objectMetadata : pendingObjectMetadatas)
@@ -223,7 +243,8 @@ common::ErrorCode Posec3d::doWork(int dataPipeId) {
     int outDataPipeId =
         getSinkElementFlag()
             ? 0
-            : (channel_id_internal % getOutputConnectorCapacity(outputPort));
+            : getOutputDataPipeId(outputPort, channel_id_internal,
+                                  objectMetadata->mFrame->mEndOfStream);
     errorCode = pushOutputData(outputPort, outDataPipeId,
                                std::static_pointer_cast<void>(objectMetadata));
     if (common::ErrorCode::SUCCESS != errorCode) {
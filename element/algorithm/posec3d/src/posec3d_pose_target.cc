@@ -0,0 +1,141 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#include "posec3d_pose_target.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace sophon_stream {
+namespace element {
+namespace posec3d {
+
+void renderPoseTarget(const fpptr_dim3& keypoints,
+                      const fpptr_dim3& keypoint_scores,
+                      const std::vector<int>& inds, int img_h, int img_w,
+                      int num_c, float input_scale, float sigma, int clip_len,
+                      float* heatmap, int out_num) {
+  const float eps = 1e-4;
+  int num_src = keypoints.size();
+  float* data = heatmap;
+  memset((void*)data, 0, out_num * sizeof(float));
+  int heatmap_start_indx = out_num / 2;
+  int plane = img_h * img_w;
+
+  // 重采样后的帧只是源帧的重复，heatmap只取决于源帧，
+  // 因此每个源帧只渲染一次，再复制到所有采样到它的位置
+  std::vector<std::vector<int>> slots(num_src);
+  for (std::size_t i = 0; i < inds.size(); i++) slots[inds[i]].push_back(i);
+
+  struct Rect {
+    int st_x, ed_x, st_y, ed_y;
+  };
+  std::vector<float> frame_map(num_c * plane, 0.f);
+  std::vector<Rect> touched(num_c);
+  std::vector<float> gauss_x, gauss_y;
+  const float inv_two_sigma2 = 1.f / (2 * sigma * sigma);
+  for (int f = 0; f < num_src; f++) {
+    if (slots[f].empty()) continue;
+    for (auto& rect : touched) rect = {img_w, 0, img_h, 0};
+    for (int j = 0; j < num_c; j++) {
+      float* map = frame_map.data() + j * plane;
+      Rect& rect = touched[j];
+      for (std::size_t person_id = 0; person_id < keypoints[f]->size();
+           person_id++) {
+        float score = keypoint_scores[f]->at(person_id)->at(j);
+        if (score < eps) continue;
+
+        float mu_x = keypoints[f]->at(person_id)->at(j * 2);
+        float mu_y = keypoints[f]->at(person_id)->at(j * 2 + 1);
+
+        int st_x = std::max(int(mu_x - 3 * sigma), 0);
+        int ed_x = std::min(int(mu_x + 3 * sigma) + 1, img_w);
+        int st_y = std::max(int(mu_y - 3 * sigma), 0);
+        int ed_y = std::min(int(mu_y + 3 * sigma) + 1, img_h);
+        if (st_x >= ed_x || st_y >= ed_y) continue;
+
+        // 二维高斯可分离为x、y方向一维高斯的乘积，每个关键点只计算一次exp
+        gauss_x.resize(ed_x - st_x);
+        gauss_y.resize(ed_y - st_y);
+        for (int x = st_x; x < ed_x; x++)
+          gauss_x[x - st_x] =
+              std::exp(-(x - mu_x) * (x - mu_x) * inv_two_sigma2);
+        for (int y = st_y; y < ed_y; y++)
+          gauss_y[y - st_y] = std::exp(-(y - mu_y) * (y - mu_y) *
+                                       inv_two_sigma2) *
+                              score * input_scale;
+        for (int y = st_y; y < ed_y; y++) {
+          float* row = map + y * img_w;
+          float wy = gauss_y[y - st_y];
+          for (int x = st_x; x < ed_x; x++)
+            row[x] = std::max(row[x], gauss_x[x - st_x] * wy);
+        }
+        rect.st_x = std::min(rect.st_x, st_x);
+        rect.ed_x = std::max(rect.ed_x, ed_x);
+        rect.st_y = std::min(rect.st_y, st_y);
+        rect.ed_y = std::max(rect.ed_y, ed_y);
+      }
+    }
+
+    // 只复制有值的区域，两个crop的heatmap相同
+    for (int i : slots[f]) {
+      for (int j = 0; j < num_c; j++) {
+        const Rect& rect = touched[j];
+        if (rect.st_x >= rect.ed_x) continue;
+        float* base = data + i / clip_len * num_c * clip_len * plane +
+                      j * clip_len * plane + i % clip_len * plane;
+        const float* map = frame_map.data() + j * plane;
+        int bytes = (rect.ed_x - rect.st_x) * sizeof(float);
+        for (int y = rect.st_y; y < rect.ed_y; y++) {
+          int offset = y * img_w + rect.st_x;
+          memcpy(base + offset, map + offset, bytes);
+          memcpy(base + offset + heatmap_start_indx, map + offset, bytes);
+        }
+      }
+    }
+    for (int j = 0; j < num_c; j++) {
+      const Rect& rect = touched[j];
+      float* map = frame_map.data() + j * plane;
+      for (int y = rect.st_y; y < rect.ed_y; y++)
+        std::fill(map + y * img_w + rect.st_x, map + y * img_w + rect.ed_x,
+                  0.f);
+    }
+  }
+}
+
+void PoseWindow::slide(int channelId, int window_size, fpptr_dim3& keypoints,
+                       fpptr_dim3& keypoint_scores) {
+  std::lock_guard<std::mutex> lock(mMutex);
+  auto& history = mHistory[channelId];
+  for (std::size_t i = 0; i < keypoints.size(); i++)
+    history.emplace_back(keypoints[i], keypoint_scores[i]);
+  while (static_cast<int>(history.size()) > window_size) history.pop_front();
+
+  // 后续步骤会原地修改关键点，窗口内的帧需要深拷贝，历史中保留原始坐标
+  keypoints.clear();
+  keypoint_scores.clear();
+  for (auto& frame : history) {
+    std::shared_ptr<fpptr_dim2> frame_keypoints =
+        std::make_shared<fpptr_dim2>();
+    for (auto& person : *frame.first)
+      frame_keypoints->push_back(std::make_shared<std::vector<float>>(*person));
+    keypoints.push_back(frame_keypoints);
+    keypoint_scores.push_back(frame.second);
+  }
+}
+
+void PoseWindow::reset(int channelId) {
+  std::lock_guard<std::mutex> lock(mMutex);
+  mHistory.erase(channelId);
+}
+
+}  // namespace posec3d
+}  // namespace element
+}  // namespace sophon_stream
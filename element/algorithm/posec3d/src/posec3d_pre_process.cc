@@ -12,6 +12,7 @@
 #include <algorithm>
 #include <cmath>
 #include <cstdlib>
+#include <cstring>
 #include <fstream>
 
 #include "common/logger.h"
@@ -23,10 +24,9 @@ namespace posec3d {
 void Posec3dPreProcess::init(std::shared_ptr<Posec3dContext> context) {}
 
 common::ErrorCode Posec3dPreProcess::uniformSampleFrames(
-    fpptr_dim3& sampled_keypoints, fpptr_dim3& sampled_keypoint_scores,
-    int clip_len, int num_clips, int seed) {
-  int num_frames = sampled_keypoints.size();
-  std::vector<int> inds;
+    int num_frames, std::vector<int>& inds, int clip_len, int num_clips,
+    int seed) {
+  inds.clear();
   srand(seed);
 
   // frame clip
@@ -60,16 +60,6 @@ common::ErrorCode Posec3dPreProcess::uniformSampleFrames(
     }
   }
 
-  // filter frames
-  for (int i = 0; i < inds.size(); i++) {
-    sampled_keypoints.push_back(sampled_keypoints[inds[i]]);
-    sampled_keypoint_scores.push_back(sampled_keypoint_scores[inds[i]]);
-  }
-  sampled_keypoints.erase(sampled_keypoints.begin(),
-                          sampled_keypoints.begin() + num_frames);
-  sampled_keypoint_scores.erase(sampled_keypoint_scores.begin(),
-                                sampled_keypoint_scores.begin() + num_frames);
-
   return common::ErrorCode::SUCCESS;
 }
 
@@ -216,18 +206,15 @@ common::ErrorCode Posec3dPreProcess::centerCrop(
 
 common::ErrorCode Posec3dPreProcess::generatePoseTarget(
     std::shared_ptr<Posec3dContext> context, fpptr_dim3& keypoints,
-    fpptr_dim3& sampled_keypoints, fpptr_dim3& sampled_keypoint_scores,
+    fpptr_dim3& keypoint_scores, std::vector<int>& inds,
     std::vector<int>& new_shape, float* heatmap, int out_num, float sigma,
     float scaling, int clip_len) {
-  // gen an aug
-  const float eps = 1e-4;
   int img_h = new_shape[0], img_w = new_shape[1];
   // scale img_h, img_w and kps
   img_h = int(img_h * scaling + 0.5);
   img_w = int(img_w * scaling + 0.5);
 
   int num_c = context->m_net_keypoints;
-  int num_frame = sampled_keypoints.size();
   for (auto& obj : keypoints) {
     for (int j = 0; j < obj->size(); j++) {
       for (int i = 0; i < obj->at(j)->size(); i += 2) {
@@ -237,59 +224,15 @@ common::ErrorCode Posec3dPreProcess::generatePoseTarget(
     }
   }
 
-  float* data = heatmap;
-  memset((void*)data, 0, out_num * sizeof(float));
-  int heatmap_start_indx = out_num / 2;
-  for (int i = 0; i < num_frame; i++) {
-    for (int j = 0; j < num_c; j++) {
-      for (int person_id = 0; person_id < sampled_keypoints[i]->size();
-           person_id++) {
-        if (sampled_keypoint_scores[i]->at(person_id)->at(j) < eps) continue;
-
-        float mu_x = sampled_keypoints[i]->at(person_id)->at(j * 2);
-        float mu_y = sampled_keypoints[i]->at(person_id)->at(j * 2 + 1);
-
-        int st_x = std::max(int(mu_x - 3 * sigma), 0);
-        int ed_x = std::min(int(mu_x + 3 * sigma) + 1, img_w);
-        int st_y = std::max(int(mu_y - 3 * sigma), 0);
-        int ed_y = std::min(int(mu_y + 3 * sigma) + 1, img_h);
-        if (st_x >= ed_x || st_y >= ed_y) continue;
-
-        float* base = data + i / clip_len * num_c * clip_len * img_h * img_w +
-                      j * clip_len * img_h * img_w +
-                      i % clip_len * img_h * img_w;
-        for (int patch_x = st_x; patch_x < ed_x; patch_x++)
-          for (int patch_y = st_y; patch_y < ed_y; patch_y++) {
-            float value = exp(-(std::pow(patch_x - mu_x, 2) +
-                                std::pow(patch_y - mu_y, 2)) /
-                              2 / std::pow(sigma, 2)) *
-                          sampled_keypoint_scores[i]->at(person_id)->at(j);
-            value *= context->input_scale;
-            if (value > *(base + patch_y * img_w + patch_x)) {
-              *(base + patch_y * img_w + patch_x) = value;
-              *(base + patch_y * img_w + patch_x + heatmap_start_indx) = value;
-              /*
-              // original implement
-              if (j == 0)
-                *(base + heatmap_start_indx + patch_y * img_w + img_w - patch_x
-              - 1) = value; else if (j % 2 == 0)
-                *(data + heatmap_start_indx + i / clip_len * num_c * clip_len *
-              img_h * img_w + (j - 1) * clip_len * img_h * img_w + i % clip_len
-              * img_h * img_w + patch_y * img_w + img_w - patch_x - 1) = value;
-              else if (j % 2 == 1)
-                *(data + heatmap_start_indx + i / clip_len * num_c * clip_len *
-              img_h * img_w + (j + 1) * clip_len * img_h * img_w + i % clip_len
-              * img_h * img_w + patch_y * img_w + img_w - patch_x - 1) = value;
-              */
-            }
-          }
-      }
-    }
-  }
-
+  renderPoseTarget(keypoints, keypoint_scores, inds, img_h, img_w, num_c,
+                   context->input_scale, sigma, clip_len, heatmap, out_num);
   return common::ErrorCode::SUCCESS;
 }
 
+void Posec3dPreProcess::resetHistory(int channelId) {
+  mWindow.reset(channelId);
+}
+
 void Posec3dPreProcess::initTensors(std::shared_ptr<Posec3dContext> context,
                                     common::ObjectMetadatas& objectMetadatas) {
   auto& obj = objectMetadatas[0];
@@ -335,8 +278,6 @@ common::ErrorCode Posec3dPreProcess::preProcess(
 
   fpptr_dim3 keypoints;
   fpptr_dim3 keypoint_scores;
-  fpptr_dim3 sampled_keypoints;
-  fpptr_dim3 sampled_keypoint_scores;
   for (auto& obj : objectMetadatas) {
     std::shared_ptr<fpptr_dim2> single_person_keypoints =
         std::make_shared<fpptr_dim2>();
@@ -351,13 +292,14 @@ common::ErrorCode Posec3dPreProcess::preProcess(
     keypoints.push_back(single_person_keypoints);
     keypoint_scores.push_back(single_person_keypoint_scores);
   }
-  sampled_keypoints = keypoints;
-  sampled_keypoint_scores = keypoint_scores;
+  if (context->window_stride < context->max_batch)
+    mWindow.slide(objectMetadatas[0]->mFrame->mChannelIdInternal,
+                  context->max_batch, keypoints, keypoint_scores);
   int clip_len = 48, num_clips = 10;
 
   // upsample frames to get 480 objs
-  uniformSampleFrames(sampled_keypoints, sampled_keypoint_scores, clip_len,
-                      num_clips, 255);
+  std::vector<int> inds;
+  uniformSampleFrames(keypoints.size(), inds, clip_len, num_clips, 255);
   std::vector<float> hw_ratio = {1.0, 1.0};
   std::vector<int> new_shape;
   std::vector<float> crop_quadruple = {0, 0, 1, 1};
@@ -393,9 +335,8 @@ common::ErrorCode Posec3dPreProcess::preProcess(
     heatmap = objectMetadatas[0]->mInputBMtensors->cpu_data[0];
   } else
     heatmap = new float[out_num];
-  generatePoseTarget(context, keypoints, sampled_keypoints,
-                     sampled_keypoint_scores, new_shape, heatmap, out_num, 0.6,
-                     1.0, clip_len);
+  generatePoseTarget(context, keypoints, keypoint_scores, inds, new_shape,
+                     heatmap, out_num, 0.6, 1.0, clip_len);
 
   if (context->bmNetwork->is_soc)
     assert(BM_SUCCESS ==
@@ -75,6 +75,10 @@ class Ppocr_det : public ::sophon_stream::framework::Element {
       "bgr2rgb";
   static constexpr const char* CONFIG_INTERNAL_THRESHOLD_MEAN_FIELD = "mean";
   static constexpr const char* CONFIG_INTERNAL_THRESHOLD_STD_FIELD = "std";
+  static constexpr const char* CONFIG_INTERNAL_FAST_BOX_EXTRACTION_FIELD =
+      "fast_box_extraction";
+  static constexpr const char* CONFIG_INTERNAL_POLYGON_SCORE_FIELD =
+      "polygon_score";
 
  private:
   std::shared_ptr<Ppocr_detContext> mContext;          // context对象
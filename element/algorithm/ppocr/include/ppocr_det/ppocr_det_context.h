@@ -35,6 +35,11 @@ class Ppocr_detContext : public ::sophon_stream::element::Context {
   int input_num;
   int output_num;
   bmcv_convert_to_attr converto_attr;
+
+  // 为true时用RegionExtractor提取文本区域，否则使用findContours
+  bool fast_box_extraction = true;
+  // 为true时文本框得分为区域内像素的概率均值，否则为最小外接矩形内的均值
+  bool polygon_score = false;
 };
 }  // namespace ppocr_det
 }  // namespace element
@@ -16,6 +16,8 @@
 #include <string>
 #include <vector>
 
+#include "ppocr_det_region_extractor.h"
+
 namespace sophon_stream {
 namespace element {
 namespace ppocr_det {
@@ -38,12 +40,32 @@ class PostProcessor {
       const cv::Mat pred, const cv::Mat bitmap, const float& box_thresh,
       const float& det_db_unclip_ratio, const bool& use_polygon_score,
       const int& dest_width, const int& dest_height);
+  /**
+   * @brief 与BoxesFromBitmap输出相同格式的文本框，区域由RegionExtractor得到
+   * @param pred 概率图，行间距为stride个float
+   */
+  std::vector<std::vector<std::vector<int>>> BoxesFromRegions(
+      const float* pred, int stride, int width, int height,
+      const std::vector<TextRegion>& regions, const float& box_thresh,
+      const float& det_db_unclip_ratio, const bool& use_polygon_score,
+      const int& dest_width, const int& dest_height);
   std::vector<std::vector<float>> GetMiniBoxes(cv::RotatedRect box,
                                                float& ssid);
   float PolygonScoreAcc(std::vector<cv::Point> contour, cv::Mat pred);
   float BoxScoreFast(std::vector<std::vector<float>> box_array, cv::Mat pred);
+  /**
+   * @brief 逐行计算四边形覆盖的像素，求概率均值，结果与BoxScoreFast相同或相差边界像素
+   */
+  float BoxScoreScan(const std::vector<std::vector<float>>& box,
+                     const float* pred, int stride, int width, int height);
   cv::RotatedRect UnClip(std::vector<std::vector<float>> box,
                          const float& unclip_ratio);
+  /**
+   * @brief 矩形按圆角外扩distance后的最小外接矩形即各边外扩distance，不需要clipper
+   */
+  cv::RotatedRect UnClipRect(const cv::RotatedRect& rect,
+                             const std::vector<std::vector<float>>& box,
+                             const float& unclip_ratio);
   void GetContourArea(const std::vector<std::vector<float>>& box,
                       float unclip_ratio, float& distance);
   OCRBoxVec FilterTagDetRes(std::vector<std::vector<std::vector<int>>> boxes,
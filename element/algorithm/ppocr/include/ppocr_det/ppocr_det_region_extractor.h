@@ -0,0 +1,80 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SOPHON_STREAM_ELEMENT_PPOCR_DET_REGION_EXTRACTOR_H_
+#define SOPHON_STREAM_ELEMENT_PPOCR_DET_REGION_EXTRACTOR_H_
+
+#include <vector>
+
+namespace sophon_stream {
+namespace element {
+namespace ppocr_det {
+
+struct RegionPoint {
+  int x;
+  int y;
+};
+
+/**
+ * @brief 概率图上的一个8连通文本区域
+ */
+struct TextRegion {
+  // 每一段游程的两个端点，凸包与findContours得到的外轮廓相同
+  std::vector<RegionPoint> points;
+  int area = 0;            // 像素数
+  double scoreSum = 0;     // 区域内概率之和
+  int xmin, xmax, ymin, ymax;
+};
+
+/**
+ * @brief 文本区域提取，代替阈值化 + findContours
+ * @brief
+ * 按行把概率图上高于阈值的像素切成游程，与上一行相邻的游程用并查集合并，
+ * 只扫描一遍概率图，同时累计每个区域的像素数、概率和与外接框。
+ * 外接框必然得到过小最小外接矩形的区域不再收集端点，直接跳过。
+ * 每个连通域只输出一个区域，对应外轮廓；空洞不像findContours(RETR_LIST)那样
+ * 单独成为区域，空洞内的孤岛是独立的区域。不加锁，缓冲在多次调用之间复用
+ */
+class RegionExtractor {
+ public:
+  /**
+   * @param pred 概率图，行间距为stride个float
+   * @param width 参与计算的宽度
+   * @param height 参与计算的高度
+   * @param threshold 像素按(unsigned char)(p * 255) > threshold判为前景，与原实现一致
+   * @param minSize 最小外接矩形短边的下限
+   * @param maxCandidates 最多输出的区域数，按区域首个像素的光栅顺序，
+   * 只计入没有因minSize跳过的区域
+   */
+  void extract(const float* pred, int stride, int width, int height,
+               double threshold, float minSize, int maxCandidates,
+               std::vector<TextRegion>& regions);
+
+ private:
+  struct Run {
+    int y;
+    int x0;
+    int x1;
+    int label;
+    double sum;
+  };
+
+  int find(int label);
+  void unite(int a, int b);
+
+  std::vector<Run> mRuns;
+  std::vector<int> mParent;
+  std::vector<int> mRegionOf;
+};
+
+}  // namespace ppocr_det
+}  // namespace element
+}  // namespace sophon_stream
+
+#endif  // SOPHON_STREAM_ELEMENT_PPOCR_DET_REGION_EXTRACTOR_H_
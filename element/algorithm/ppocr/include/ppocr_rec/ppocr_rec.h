@@ -75,6 +75,8 @@ class PpocrRec : public ::sophon_stream::framework::Element {
   static constexpr const char* CONFIG_INTERNAL_BEAM_WIDTH_FIELD = "beam_width";
   static constexpr const char* CONFIG_INTERNAL_CLASS_NAMES_FILE_FIELD =
       "class_names_file";
+  static constexpr const char* CONFIG_INTERNAL_CHAR_WHITELIST_FIELD =
+      "char_whitelist";
 
  private:
   std::shared_ptr<PpocrRecContext> mContext;          // context对象
@@ -39,6 +39,8 @@ class PpocrRecContext : public ::sophon_stream::element::Context {
   bool beam_search = false;
   int beam_width = 3;
   std::vector<std::string> label_list_;
+  // 为空时不限制输出的字符，否则只输出allowed_classes[i]非0的字符
+  std::vector<uint8_t> allowed_classes;
 
   /**
    * @brief ppocr network stage shapes.
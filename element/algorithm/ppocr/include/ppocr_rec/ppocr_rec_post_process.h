@@ -12,6 +12,7 @@
 
 #include <numeric>
 
+#include "algorithmApi/ctc_decoder.h"
 #include "algorithmApi/post_process.h"
 #include "ppocr_rec_context.h"
 
@@ -19,21 +20,6 @@ namespace sophon_stream {
 namespace element {
 namespace ppocr_rec {
 
-// get recognition results.
-struct BeamSearchCandidate {
-  std::vector<int> prefix;
-  float score;
-  std::vector<float> confs;
-  BeamSearchCandidate() : score(0.0f) {}
-  BeamSearchCandidate(const std::vector<int>& pref, float scr,
-                      const std::vector<float>& cfs)
-      : prefix(pref), score(scr), confs(cfs) {}
-
-  bool operator<(const BeamSearchCandidate& other) const {
-    return score < other.score;
-  }
-};
-
 class PpocrRecPostProcess : public ::sophon_stream::element::PostProcess {
  public:
   void init(std::shared_ptr<PpocrRecContext> context);
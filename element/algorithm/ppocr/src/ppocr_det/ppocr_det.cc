@@ -40,6 +40,14 @@ namespace ppocr_det {
     mContext->stdd = stdIt->get<std::vector<float>>();
     assert(mContext->stdd.size() == 3);
 
+    auto fastBoxExtractionIt =
+        configure.find(CONFIG_INTERNAL_FAST_BOX_EXTRACTION_FIELD);
+    if (configure.end() != fastBoxExtractionIt)
+      mContext->fast_box_extraction = fastBoxExtractionIt->get<bool>();
+    auto polygonScoreIt = configure.find(CONFIG_INTERNAL_POLYGON_SCORE_FIELD);
+    if (configure.end() != polygonScoreIt)
+      mContext->polygon_score = polygonScoreIt->get<bool>();
+
     // 1. get network
     BMNNHandlePtr handle = std::make_shared<BMNNHandle>(mContext->deviceId);
     mContext->bmContext = std::make_shared<BMNNContext>(
@@ -190,7 +198,8 @@ namespace ppocr_det {
       int outDataPipeId =
           getSinkElementFlag()
               ? 0
-              : (channel_id_internal % getOutputConnectorCapacity(outputPort));
+              : getOutputDataPipeId(outputPort, channel_id_internal,
+                                    objectMetadata->mFrame->mEndOfStream);
       errorCode =
           pushOutputData(outputPort, outDataPipeId,
                          std::static_pointer_cast<void>(objectMetadata));
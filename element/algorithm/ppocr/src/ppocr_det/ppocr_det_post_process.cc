@@ -25,7 +25,11 @@ void Ppocr_detPostProcess::postProcess(
 
   const double threshold = min_score_thresh * 255;
   const double maxvalue = 255;
-  bool use_polygon_score = false;
+  bool use_polygon_score = context->polygon_score;
+  const int max_candidates = 1000;
+
+  RegionExtractor extractor;
+  std::vector<TextRegion> regions;
 
   for (auto obj : objectMetadatas) {
     if (obj->mFrame->mEndOfStream) break;
@@ -55,30 +59,41 @@ void Ppocr_detPostProcess::postProcess(
       float ratio_w = float(resize_w) / float(frame_width);
 
       int n = out_net_h_ * out_net_w_;
-      std::vector<float> pred(n, 0.0);
-      std::vector<unsigned char> cbuf(n, ' ');
-
-      for (int j = i * n; j < (i + 1) * n; j++) {
-        pred[j - i * n] = float(predict_batch[j]);
-        cbuf[j - i * n] = (unsigned char)((predict_batch[j]) * 255);
+      std::vector<std::vector<std::vector<int>>> boxes;
+      if (context->fast_box_extraction) {
+        // 直接在概率图上做连通域标记，不拷贝、不生成二值图
+        const float* pred = predict_batch + i * n;
+        extractor.extract(pred, out_net_w_, resize_w, resize_h, threshold, 3,
+                          max_candidates, regions);
+        boxes = m_post_processor.BoxesFromRegions(
+            pred, out_net_w_, resize_w, resize_h, regions, det_db_box_thresh,
+            det_db_unclip_ratio, use_polygon_score, frame_width, frame_height);
+      } else {
+        std::vector<float> pred(n, 0.0);
+        std::vector<unsigned char> cbuf(n, ' ');
+
+        for (int j = i * n; j < (i + 1) * n; j++) {
+          pred[j - i * n] = float(predict_batch[j]);
+          cbuf[j - i * n] = (unsigned char)((predict_batch[j]) * 255);
+        }
+
+        cv::Mat cbuf_map_(out_net_h_, out_net_w_, CV_8UC1,
+                          (unsigned char*)cbuf.data());
+        cv::Mat pred_map_(out_net_h_, out_net_w_, CV_32F, (float*)pred.data());
+
+        cv::Rect crop_region(0, 0, resize_w, resize_h);
+        cv::Mat cbuf_map = cbuf_map_(crop_region);
+        cv::Mat pred_map = pred_map_(crop_region);
+
+        cv::Mat bit_map;
+        cv::threshold(cbuf_map, bit_map, threshold, maxvalue,
+                      cv::THRESH_BINARY);
+
+        boxes = m_post_processor.BoxesFromBitmap(
+            pred_map, bit_map, det_db_box_thresh, det_db_unclip_ratio,
+            use_polygon_score, frame_width, frame_height);
       }
 
-      cv::Mat cbuf_map_(out_net_h_, out_net_w_, CV_8UC1,
-                        (unsigned char*)cbuf.data());
-      cv::Mat pred_map_(out_net_h_, out_net_w_, CV_32F, (float*)pred.data());
-
-      cv::Rect crop_region(0, 0, resize_w, resize_h);
-      cv::Mat cbuf_map = cbuf_map_(crop_region);
-      cv::Mat pred_map = pred_map_(crop_region);
-
-      cv::Mat bit_map;
-      cv::threshold(cbuf_map, bit_map, threshold, maxvalue, cv::THRESH_BINARY);
-
-      std::vector<std::vector<std::vector<int>>> boxes =
-          m_post_processor.BoxesFromBitmap(
-              pred_map, bit_map, det_db_box_thresh, det_db_unclip_ratio,
-              use_polygon_score, frame_width, frame_height);
-
       OCRBoxVec ocrboxes =
           m_post_processor.FilterTagDetRes(boxes, *obj->mFrame->mSpData.get());
 
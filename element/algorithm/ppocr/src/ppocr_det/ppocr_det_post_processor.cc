@@ -9,6 +9,8 @@
 
 #include "ppocr_det_post_processor.h"
 
+#include <limits>
+
 #include "clipper.h"
 
 namespace sophon_stream {
@@ -65,6 +67,64 @@ cv::RotatedRect PostProcessor::UnClip(std::vector<std::vector<float>> box,
   return res;
 }
 
+cv::RotatedRect PostProcessor::UnClipRect(
+    const cv::RotatedRect& rect, const std::vector<std::vector<float>>& box,
+    const float& unclip_ratio) {
+  float distance = 1.0;
+  GetContourArea(box, unclip_ratio, distance);
+  return cv::RotatedRect(rect.center,
+                         cv::Size2f(rect.size.width + 2 * distance,
+                                    rect.size.height + 2 * distance),
+                         rect.angle);
+}
+
+float PostProcessor::BoxScoreScan(const std::vector<std::vector<float>>& box,
+                                  const float* pred, int stride, int width,
+                                  int height) {
+  float box_x[4] = {box[0][0], box[1][0], box[2][0], box[3][0]};
+  float box_y[4] = {box[0][1], box[1][1], box[2][1], box[3][1]};
+  int xmin = clamp(int(std::floor(*(std::min_element(box_x, box_x + 4)))), 0,
+                   width - 1);
+  int xmax = clamp(int(std::ceil(*(std::max_element(box_x, box_x + 4)))), 0,
+                   width - 1);
+  int ymin = clamp(int(std::floor(*(std::min_element(box_y, box_y + 4)))), 0,
+                   height - 1);
+  int ymax = clamp(int(std::ceil(*(std::max_element(box_y, box_y + 4)))), 0,
+                   height - 1);
+  // 与BoxScoreFast一样使用取整后的顶点
+  int px[4], py[4];
+  for (int i = 0; i < 4; ++i) {
+    px[i] = int(box_x[i]);
+    py[i] = int(box_y[i]);
+  }
+
+  double sum = 0;
+  int count = 0;
+  for (int y = ymin; y <= ymax; ++y) {
+    float lo = std::numeric_limits<float>::max();
+    float hi = std::numeric_limits<float>::lowest();
+    for (int i = 0; i < 4; ++i) {
+      int j = (i + 1) % 4;
+      if (y < std::min(py[i], py[j]) || y > std::max(py[i], py[j])) continue;
+      if (py[i] == py[j]) {
+        lo = std::min(lo, float(std::min(px[i], px[j])));
+        hi = std::max(hi, float(std::max(px[i], px[j])));
+        continue;
+      }
+      float x = px[i] + float(y - py[i]) * (px[j] - px[i]) / (py[j] - py[i]);
+      lo = std::min(lo, x);
+      hi = std::max(hi, x);
+    }
+    if (lo > hi) continue;
+    int x0 = std::max(xmin, int(std::lround(lo)));
+    int x1 = std::min(xmax, int(std::lround(hi)));
+    const float* row = pred + static_cast<std::size_t>(y) * stride;
+    for (int x = x0; x <= x1; ++x) sum += row[x];
+    count += std::max(0, x1 - x0 + 1);
+  }
+  return count > 0 ? float(sum / count) : 0.f;
+}
+
 float PostProcessor::BoxScoreFast(std::vector<std::vector<float>> box_array,
                                   cv::Mat pred) {
   auto array = box_array;
@@ -277,6 +337,62 @@ std::vector<std::vector<std::vector<int>>> PostProcessor::BoxesFromBitmap(
   return boxes;
 }
 
+std::vector<std::vector<std::vector<int>>> PostProcessor::BoxesFromRegions(
+    const float* pred, int stride, int width, int height,
+    const std::vector<TextRegion>& regions, const float& box_thresh,
+    const float& det_db_unclip_ratio, const bool& use_polygon_score,
+    const int& dest_width, const int& dest_height) {
+  const int min_size = 3;
+
+  std::vector<std::vector<std::vector<int>>> boxes;
+  std::vector<cv::Point> points;
+  for (const TextRegion& region : regions) {
+    // 游程端点的凸包与外轮廓相同，最小外接矩形也相同
+    points.clear();
+    for (const RegionPoint& point : region.points)
+      points.emplace_back(point.x, point.y);
+    float ssid;
+    cv::RotatedRect box = cv::minAreaRect(points);
+    auto array = GetMiniBoxes(box, ssid);
+
+    if (ssid < min_size) {
+      continue;
+    }
+
+    float score;
+    if (use_polygon_score) /* compute using region pixels*/
+      score = float(region.scoreSum / region.area);
+    else
+      score = BoxScoreScan(array, pred, stride, width, height);
+
+    if (score < box_thresh) continue;
+
+    cv::RotatedRect clipbox = UnClipRect(box, array, det_db_unclip_ratio);
+    if (clipbox.size.height < 1.001 && clipbox.size.width < 1.001) {
+      continue;
+    }
+
+    auto cliparray = GetMiniBoxes(clipbox, ssid);
+
+    if (ssid < min_size + 2) continue;
+
+    std::vector<std::vector<int>> intcliparray;
+
+    for (int num_pt = 0; num_pt < 4; num_pt++) {
+      std::vector<int> a{
+          int(clampf(
+              roundf(cliparray[num_pt][0] / float(width) * float(dest_width)),
+              0, float(dest_width))),
+          int(clampf(
+              roundf(cliparray[num_pt][1] / float(height) * float(dest_height)),
+              0, float(dest_height)))};
+      intcliparray.push_back(a);
+    }
+    boxes.push_back(intcliparray);
+  }
+  return boxes;
+}
+
 std::vector<std::vector<int>> PostProcessor::OrderPointsClockwise(
     std::vector<std::vector<int>> pts) {
   std::vector<std::vector<int>> box = pts;
@@ -0,0 +1,122 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#include "ppocr_det_region_extractor.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace sophon_stream {
+namespace element {
+namespace ppocr_det {
+
+int RegionExtractor::find(int label) {
+  while (mParent[label] != label) {
+    mParent[label] = mParent[mParent[label]];
+    label = mParent[label];
+  }
+  return label;
+}
+
+void RegionExtractor::unite(int a, int b) {
+  a = find(a);
+  b = find(b);
+  // 根取较小的label，使区域顺序与首个游程的光栅顺序一致
+  if (a < b)
+    mParent[b] = a;
+  else if (b < a)
+    mParent[a] = b;
+}
+
+void RegionExtractor::extract(const float* pred, int stride, int width,
+                              int height, double threshold, float minSize,
+                              int maxCandidates,
+                              std::vector<TextRegion>& regions) {
+  regions.clear();
+  mRuns.clear();
+  mParent.clear();
+
+  std::size_t prevBegin = 0, prevEnd = 0;
+  for (int y = 0; y < height; ++y) {
+    const float* row = pred + static_cast<std::size_t>(y) * stride;
+    std::size_t curBegin = mRuns.size();
+    std::size_t p = prevBegin;
+    int x = 0;
+    while (x < width) {
+      while (x < width && !((unsigned char)(row[x] * 255) > threshold)) ++x;
+      if (x == width) break;
+      int x0 = x;
+      double sum = 0;
+      while (x < width && (unsigned char)(row[x] * 255) > threshold)
+        sum += row[x++];
+      int x1 = x - 1;
+
+      int label = mParent.size();
+      mParent.push_back(label);
+      // 8连通：上一行与[x0 - 1, x1 + 1]有交集的游程属于同一区域
+      while (p < prevEnd && mRuns[p].x1 < x0 - 1) ++p;
+      for (std::size_t q = p; q < prevEnd && mRuns[q].x0 <= x1 + 1; ++q)
+        unite(label, mRuns[q].label);
+      mRuns.push_back({y, x0, x1, label, sum});
+    }
+    prevBegin = curBegin;
+    prevEnd = mRuns.size();
+  }
+
+  // 汇总每个区域的统计量，区域按根label即首个游程的顺序编号
+  mRegionOf.assign(mParent.size(), -1);
+  for (const Run& run : mRuns) {
+    int root = find(run.label);
+    int& index = mRegionOf[root];
+    if (index < 0) {
+      index = regions.size();
+      regions.emplace_back();
+      TextRegion& region = regions.back();
+      region.xmin = run.x0;
+      region.xmax = run.x1;
+      region.ymin = region.ymax = run.y;
+    }
+    TextRegion& region = regions[index];
+    region.area += run.x1 - run.x0 + 1;
+    region.scoreSum += run.sum;
+    region.xmin = std::min(region.xmin, run.x0);
+    region.xmax = std::max(region.xmax, run.x1);
+    region.ymax = std::max(region.ymax, run.y);
+  }
+
+  // 最小外接矩形的短边不超过sqrt(2) * min(外接框宽, 高)，据此提前跳过小区域
+  std::vector<char> keep(regions.size(), 0);
+  int kept = 0;
+  for (std::size_t i = 0; i < regions.size(); ++i) {
+    const TextRegion& region = regions[i];
+    int extent =
+        std::min(region.xmax - region.xmin, region.ymax - region.ymin);
+    if (extent * std::sqrt(2.f) < minSize) continue;
+    if (kept >= maxCandidates) break;
+    keep[i] = 1;
+    ++kept;
+  }
+  for (const Run& run : mRuns) {
+    int index = mRegionOf[find(run.label)];
+    if (!keep[index]) continue;
+    regions[index].points.push_back({run.x0, run.y});
+    if (run.x1 != run.x0) regions[index].points.push_back({run.x1, run.y});
+  }
+  std::size_t out = 0;
+  for (std::size_t i = 0; i < regions.size(); ++i)
+    if (keep[i]) {
+      if (out != i) regions[out] = std::move(regions[i]);
+      ++out;
+    }
+  regions.resize(out);
+}
+
+}  // namespace ppocr_det
+}  // namespace element
+}  // namespace sophon_stream
@@ -9,6 +9,8 @@
 
 #include "ppocr_rec.h"
 
+#include <set>
+
 using namespace std::chrono_literals;
 
 namespace sophon_stream {
@@ -67,6 +69,26 @@ common::ErrorCode PpocrRec::initContext(const std::string& json) {
     mContext->beam_width = beamWidthIt->get<int>();
     STREAM_CHECK(mContext->beam_width >= 1 && mContext->beam_width <= 40,
                  "beam_size out of range, should be integer in range(1, 41)");
+    auto charWhitelistIt =
+        configure.find(CONFIG_INTERNAL_CHAR_WHITELIST_FIELD);
+    if (configure.end() != charWhitelistIt) {
+      // 按UTF-8字符拆分白名单，与字典中的字符逐个匹配
+      std::string whitelist = charWhitelistIt->get<std::string>();
+      std::set<std::string> chars;
+      for (std::size_t i = 0; i < whitelist.size();) {
+        unsigned char lead = whitelist[i];
+        std::size_t len = lead < 0x80   ? 1
+                          : lead < 0xE0 ? 2
+                          : lead < 0xF0 ? 3
+                                        : 4;
+        chars.insert(whitelist.substr(i, len));
+        i += len;
+      }
+      mContext->allowed_classes.assign(mContext->label_list_.size(), 0);
+      for (std::size_t i = 0; i < mContext->label_list_.size(); ++i)
+        if (chars.count(mContext->label_list_[i]))
+          mContext->allowed_classes[i] = 1;
+    }
     int pre_net_h = -1;
     for (int i = 0; i < mContext->bmNetwork->m_netinfo->stage_num; i++) {
       auto tensor = mContext->bmNetwork->inputTensor(0);
@@ -234,7 +256,8 @@ common::ErrorCode PpocrRec::doWork(int dataPipeId) {
     int outDataPipeId =
         getSinkElementFlag()
             ? 0
-            : (channel_id_internal % getOutputConnectorCapacity(outputPort));
+            : getOutputDataPipeId(outputPort, channel_id_internal,
+                                  objectMetadata->mFrame->mEndOfStream);
     errorCode = pushOutputData(outputPort, outDataPipeId,
                                std::static_pointer_cast<void>(objectMetadata));
     if (common::ErrorCode::SUCCESS != errorCode) {
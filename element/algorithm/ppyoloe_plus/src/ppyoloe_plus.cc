@@ -222,7 +222,8 @@ namespace ppyoloe_plus {
       int outDataPipeId =
           getSinkElementFlag()
               ? 0
-              : (channel_id_internal % getOutputConnectorCapacity(outputPort));
+              : getOutputDataPipeId(outputPort, channel_id_internal,
+                                    objectMetadata->mFrame->mEndOfStream);
       errorCode =
           pushOutputData(outputPort, outDataPipeId,
                          std::static_pointer_cast<void>(objectMetadata));
@@ -47,6 +47,9 @@ class ResNet : public ::sophon_stream::framework::Element {
   static constexpr const char* CONFIG_INTERNAL_TASK_TYPE_FIELD = "task_type";
   static constexpr const char* CONFIG_INTERNAL_CLASS_THRESH_FIELD =
       "class_thresh";
+  static constexpr const char* CONFIG_INTERNAL_TOP_K_FIELD = "top_k";
+  static constexpr const char* CONFIG_INTERNAL_FEATURE_NORMALIZE_FIELD =
+      "feature_normalize";
 
  private:
   std::shared_ptr<ResNetContext> mContext;      // context对象
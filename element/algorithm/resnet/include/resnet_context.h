@@ -39,6 +39,8 @@ class ResNetContext : public sophon_stream::element::Context {
 
   TaskType taskType = TaskType::SingleLabel;
   std::vector<float> class_thresh;
+  int top_k = 1;                   // SingleLabel输出得分最高的top_k个类别
+  bool feature_normalize = false;  // FeatureExtract是否对特征做L2归一化
 
   int m_frame_h, m_frame_w;
   int net_h, net_w, m_net_channel;
@@ -0,0 +1,67 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SOPHON_STREAM_ELEMENT_RESNET_HEADS_H_
+#define SOPHON_STREAM_ELEMENT_RESNET_HEADS_H_
+
+#include <vector>
+
+namespace sophon_stream {
+namespace element {
+namespace resnet {
+
+/**
+ * @brief 按batch计算分类网络输出头
+ * @brief
+ * 输入为一个batch连续存放的输出，每行对应一个目标。行最大值、缩放和平方和按4个数
+ * 一组计算，每个类别只计算一次exp。不加锁，每个线程使用各自的实例
+ */
+class ResNetHeads {
+ public:
+  /**
+   * @brief 单标签：每行做softmax，取得分最高的k个类别
+   * @param logits batch行，每行前classNum个数为logits
+   * @param stride 相邻两行的间隔
+   * @param scale softmax前乘到logits上的系数
+   * @param labels 输出，batch * k，每行按得分从高到低，得分相同时类别小的在前
+   * @param scores 输出，batch * k，与labels对应
+   */
+  void softmaxTopK(const float* logits, int batch, int classNum, int stride,
+                   float scale, int k, int* labels, float* scores);
+
+  /**
+   * @brief 多标签：每行做softmax，得分大于对应类别阈值的标签为1，否则为0
+   * @param thresh classNum个阈值
+   * @param scores 输出，batch * classNum
+   * @param labels 输出，batch * classNum
+   */
+  void softmaxThreshold(const float* logits, int batch, int classNum,
+                        int stride, float scale, const float* thresh,
+                        float* scores, int* labels);
+
+  /**
+   * @brief 特征向量逐行L2归一化，范数为0的行原样输出
+   * @param src batch行，每行dim个数
+   * @param dst 输出，可以与src相同
+   */
+  static void l2Normalize(const float* src, int batch, int dim, float* dst);
+
+ private:
+  // 一行softmax，结果写入mProb
+  void softmaxRow(const float* logits, int classNum, float scale);
+
+  std::vector<float> mProb;
+  std::vector<int> mIndex;
+};
+
+}  // namespace resnet
+}  // namespace element
+}  // namespace sophon_stream
+
+#endif  // SOPHON_STREAM_ELEMENT_RESNET_HEADS_H_
@@ -47,21 +47,34 @@ class ResNetMultiTask {
   std::shared_ptr<sophon_stream::common::bmTensors> getOutputDeviceMem(
       std::shared_ptr<ResNetContext> context);
 
-  void splitOutputMemIntoObjectMetadatas(
+  common::ErrorCode predict(
       std::shared_ptr<ResNetContext> context,
       common::ObjectMetadatas& objectMetadatas,
-      std::shared_ptr<sophon_stream::common::bmTensors> outputTensors);
-
-  common::ErrorCode predict(std::shared_ptr<ResNetContext> context,
-                            common::ObjectMetadatas& objectMetadatas);
+      std::shared_ptr<sophon_stream::common::bmTensors>& outputTensors);
 
   // postprocess
-  common::ErrorCode post_process_classfy(std::shared_ptr<ResNetContext> context,
-                                 common::ObjectMetadatas& objectMetadatas);
-  common::ErrorCode post_process_extract(std::shared_ptr<ResNetContext> context,
-                                 common::ObjectMetadatas& objectMetadatas);
-  common::ErrorCode post_process_multilabel(std::shared_ptr<ResNetContext> context,
-                                 common::ObjectMetadatas& objectMetadatas);
+  /**
+   * @brief 为整个batch的输出创建BMNNTensor，get_cpu_data时一次拷回主机
+   * @param rowSize 输出，每个目标的输出在batch中所占的元素个数
+   * @return 有效目标数，遇到EOS为止
+   */
+  int getBatchOutput(
+      std::shared_ptr<ResNetContext> context,
+      common::ObjectMetadatas& objectMetadatas,
+      std::shared_ptr<sophon_stream::common::bmTensors> outputTensors,
+      std::shared_ptr<BMNNTensor>& outputTensor, int& rowSize);
+  common::ErrorCode post_process_classfy(
+      std::shared_ptr<ResNetContext> context,
+      common::ObjectMetadatas& objectMetadatas,
+      std::shared_ptr<sophon_stream::common::bmTensors> outputTensors);
+  common::ErrorCode post_process_extract(
+      std::shared_ptr<ResNetContext> context,
+      common::ObjectMetadatas& objectMetadatas,
+      std::shared_ptr<sophon_stream::common::bmTensors> outputTensors);
+  common::ErrorCode post_process_multilabel(
+      std::shared_ptr<ResNetContext> context,
+      common::ObjectMetadatas& objectMetadatas,
+      std::shared_ptr<sophon_stream::common::bmTensors> outputTensors);
 
   int subId = 0;
 };
@@ -93,14 +93,32 @@ common::ErrorCode ResNet::initContext(const std::string& json) {
       auto class_thresh_it = configure.find(CONFIG_INTERNAL_CLASS_THRESH_FIELD);
       // 如果未配置，则默认全0.5，否则按照配置值设置
       if (class_thresh_it == configure.end()) {
-        mContext->class_thresh = std::vector<float>(mContext->output_num, 0.5);
+        mContext->class_thresh = std::vector<float>(mContext->class_num, 0.5);
       } else {
         mContext->class_thresh = class_thresh_it->get<std::vector<float>>();
-        STREAM_CHECK(mContext->class_thresh.size() == mContext->output_num,
+        STREAM_CHECK(mContext->class_thresh.size() == mContext->class_num,
                      "Invalid Model or ClassThresh List!");
       }
     }
 
+    auto topKIt = configure.find(CONFIG_INTERNAL_TOP_K_FIELD);
+    if (configure.end() != topKIt) {
+      if (!topKIt->is_number_integer() || topKIt->get<int>() < 1) {
+        IVS_ERROR("{0} must be a positive integer",
+                  CONFIG_INTERNAL_TOP_K_FIELD);
+        errorCode = common::ErrorCode::PARSE_CONFIGURE_FAIL;
+        break;
+      }
+      mContext->top_k = std::min(topKIt->get<int>(), mContext->class_num);
+    }
+
+    auto featureNormalizeIt =
+        configure.find(CONFIG_INTERNAL_FEATURE_NORMALIZE_FIELD);
+    if (configure.end() != featureNormalizeIt &&
+        featureNormalizeIt->is_boolean()) {
+      mContext->feature_normalize = featureNormalizeIt->get<bool>();
+    }
+
     // 4.converto
     float input_scale = inputTensor->get_scale();
     mContext->converto_attr.alpha_0 = 1 / mContext->stdd[0] * input_scale;
@@ -127,7 +145,7 @@ common::ErrorCode ResNet::initContext(const std::string& json) {
     }
 
   } while (false);
-  return common::ErrorCode::SUCCESS;
+  return errorCode;
 }
 
 common::ErrorCode ResNet::initInternal(const std::string& json) {
@@ -148,7 +166,8 @@ common::ErrorCode ResNet::initInternal(const std::string& json) {
 
     // 新建context
     mContext->deviceId = getDeviceId();
-    initContext(configure.dump());
+    errorCode = initContext(configure.dump());
+    if (common::ErrorCode::SUCCESS != errorCode) break;
 
     // 推理初始化
     mMultiTask->init(mContext);
@@ -212,7 +231,8 @@ common::ErrorCode ResNet::doWork(int dataPipeId) {
     int outDataPipeId =
         getSinkElementFlag()
             ? 0
-            : (channel_id_internal % getOutputConnectorCapacity(outputPort));
+            : getOutputDataPipeId(outputPort, channel_id_internal,
+                                  objectMetadata->mFrame->mEndOfStream);
     errorCode = pushOutputData(outputPort, outDataPipeId,
                                std::static_pointer_cast<void>(objectMetadata));
     if (common::ErrorCode::SUCCESS != errorCode) {
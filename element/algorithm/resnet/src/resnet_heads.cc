@@ -0,0 +1,161 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#include "resnet_heads.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace sophon_stream {
+namespace element {
+namespace resnet {
+
+namespace {
+
+float rowMax(const float* data, int n) {
+  float result = data[0];
+  int i = 0;
+#if defined(__aarch64__)
+  if (n >= 4) {
+    float32x4_t m = vld1q_f32(data);
+    for (i = 4; i + 4 <= n; i += 4) m = vmaxq_f32(m, vld1q_f32(data + i));
+    result = vmaxvq_f32(m);
+  }
+#elif defined(__SSE2__)
+  if (n >= 4) {
+    __m128 m = _mm_loadu_ps(data);
+    for (i = 4; i + 4 <= n; i += 4) m = _mm_max_ps(m, _mm_loadu_ps(data + i));
+    m = _mm_max_ps(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(1, 0, 3, 2)));
+    m = _mm_max_ps(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(2, 3, 0, 1)));
+    result = _mm_cvtss_f32(m);
+  }
+#endif
+  for (; i < n; ++i) result = std::max(result, data[i]);
+  return result;
+}
+
+void scaleRow(const float* src, int n, float factor, float* dst) {
+  int i = 0;
+#if defined(__aarch64__)
+  float32x4_t f = vdupq_n_f32(factor);
+  for (; i + 4 <= n; i += 4)
+    vst1q_f32(dst + i, vmulq_f32(vld1q_f32(src + i), f));
+#elif defined(__SSE2__)
+  __m128 f = _mm_set1_ps(factor);
+  for (; i + 4 <= n; i += 4)
+    _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_loadu_ps(src + i), f));
+#endif
+  for (; i < n; ++i) dst[i] = src[i] * factor;
+}
+
+float sumSquares(const float* data, int n) {
+  float result = 0;
+  int i = 0;
+#if defined(__aarch64__)
+  float32x4_t s = vdupq_n_f32(0);
+  for (; i + 4 <= n; i += 4) {
+    float32x4_t v = vld1q_f32(data + i);
+    s = vmlaq_f32(s, v, v);
+  }
+  result = vaddvq_f32(s);
+#elif defined(__SSE2__)
+  __m128 s = _mm_setzero_ps();
+  for (; i + 4 <= n; i += 4) {
+    __m128 v = _mm_loadu_ps(data + i);
+    s = _mm_add_ps(s, _mm_mul_ps(v, v));
+  }
+  s = _mm_add_ps(s, _mm_shuffle_ps(s, s, _MM_SHUFFLE(1, 0, 3, 2)));
+  s = _mm_add_ps(s, _mm_shuffle_ps(s, s, _MM_SHUFFLE(2, 3, 0, 1)));
+  result = _mm_cvtss_f32(s);
+#endif
+  for (; i < n; ++i) result += data[i] * data[i];
+  return result;
+}
+
+}  // namespace
+
+void ResNetHeads::softmaxRow(const float* logits, int classNum, float scale) {
+  mProb.resize(classNum);
+  float* prob = mProb.data();
+  scaleRow(logits, classNum, scale, prob);
+  // 减去最大值后再求exp，结果与直接求exp相同且不会上溢
+  float maxLogit = rowMax(prob, classNum);
+  float sum = 0;
+  for (int j = 0; j < classNum; ++j) {
+    prob[j] = std::exp(prob[j] - maxLogit);
+    sum += prob[j];
+  }
+  scaleRow(prob, classNum, 1.f / sum, prob);
+}
+
+void ResNetHeads::softmaxTopK(const float* logits, int batch, int classNum,
+                              int stride, float scale, int k, int* labels,
+                              float* scores) {
+  k = std::min(k, classNum);
+  for (int i = 0; i < batch; ++i) {
+    softmaxRow(logits + static_cast<std::size_t>(i) * stride, classNum, scale);
+    const float* prob = mProb.data();
+    int* rowLabels = labels + i * k;
+    float* rowScores = scores + i * k;
+    if (k == 1) {
+      int best = 0;
+      for (int j = 1; j < classNum; ++j)
+        if (prob[best] < prob[j]) best = j;
+      rowLabels[0] = best;
+      rowScores[0] = prob[best];
+      continue;
+    }
+    mIndex.resize(classNum);
+    for (int j = 0; j < classNum; ++j) mIndex[j] = j;
+    std::partial_sort(mIndex.begin(), mIndex.begin() + k, mIndex.end(),
+                      [prob](int l, int r) {
+                        return prob[l] != prob[r] ? prob[l] > prob[r] : l < r;
+                      });
+    for (int j = 0; j < k; ++j) {
+      rowLabels[j] = mIndex[j];
+      rowScores[j] = prob[mIndex[j]];
+    }
+  }
+}
+
+void ResNetHeads::softmaxThreshold(const float* logits, int batch,
+                                   int classNum, int stride, float scale,
+                                   const float* thresh, float* scores,
+                                   int* labels) {
+  for (int i = 0; i < batch; ++i) {
+    std::size_t offset = static_cast<std::size_t>(i) * classNum;
+    softmaxRow(logits + static_cast<std::size_t>(i) * stride, classNum, scale);
+    std::memcpy(scores + offset, mProb.data(), sizeof(float) * classNum);
+    for (int j = 0; j < classNum; ++j)
+      labels[offset + j] = scores[offset + j] > thresh[j] ? 1 : 0;
+  }
+}
+
+void ResNetHeads::l2Normalize(const float* src, int batch, int dim,
+                              float* dst) {
+  for (int i = 0; i < batch; ++i) {
+    std::size_t offset = static_cast<std::size_t>(i) * dim;
+    float norm = std::sqrt(sumSquares(src + offset, dim));
+    if (norm > 0)
+      scaleRow(src + offset, dim, 1.f / norm, dst + offset);
+    else if (dst != src)
+      std::memcpy(dst + offset, src + offset, sizeof(float) * dim);
+  }
+}
+
+}  // namespace resnet
+}  // namespace element
+}  // namespace sophon_stream
@@ -8,6 +8,11 @@
 //===----------------------------------------------------------------------===//
 #include "resnet_multitask.h"
 
+#include <algorithm>
+#include <cstring>
+
+#include "resnet_heads.h"
+
 #define USE_ASPECT_RATIO 1
 #define DUMP_FILE 0
 
@@ -62,7 +67,8 @@ common::ErrorCode ResNetMultiTask::multiTask(
     return errorCode;
   }
   // 2. forward
-  errorCode = predict(context, objectMetadatas);
+  std::shared_ptr<sophon_stream::common::bmTensors> outputTensors;
+  errorCode = predict(context, objectMetadatas, outputTensors);
   if (common::ErrorCode::SUCCESS != errorCode) {
     IVS_ERROR("ResNet predict error");
     return errorCode;
@@ -70,11 +76,12 @@ common::ErrorCode ResNetMultiTask::multiTask(
 
   if (context->taskType == TaskType::FeatureExtract) {
     // 3. post process
-    errorCode = post_process_extract(context, objectMetadatas);
+    errorCode = post_process_extract(context, objectMetadatas, outputTensors);
   } else if (context->taskType == TaskType::SingleLabel) {
-    errorCode = post_process_classfy(context, objectMetadatas);
+    errorCode = post_process_classfy(context, objectMetadatas, outputTensors);
   } else if (context->taskType == TaskType::MultiLabel) {
-    errorCode = post_process_multilabel(context, objectMetadatas);
+    errorCode =
+        post_process_multilabel(context, objectMetadatas, outputTensors);
   }
   if (common::ErrorCode::SUCCESS != errorCode) {
     IVS_ERROR("ResNet post_process error");
@@ -236,23 +243,21 @@ common::ErrorCode ResNetMultiTask::pre_process(
 
 common::ErrorCode ResNetMultiTask::predict(
     std::shared_ptr<ResNetContext> context,
-    common::ObjectMetadatas& objectMetadatas) {
+    common::ObjectMetadatas& objectMetadatas,
+    std::shared_ptr<sophon_stream::common::bmTensors>& outputTensors) {
   if (objectMetadatas.size() == 0) return common::ErrorCode::SUCCESS;
 
+  // 输出保留为整个batch连续的显存，后处理时一次拷回主机
+  outputTensors = getOutputDeviceMem(context);
   if (context->max_batch > 1) {
     auto inputTensors = mergeInputDeviceMem(context, objectMetadatas);
-    auto outputTensors = getOutputDeviceMem(context);
 
     int ret = 0;
     ret = context->bmNetwork->forward(inputTensors->tensors,
                                       outputTensors->tensors);
-
-    splitOutputMemIntoObjectMetadatas(context, objectMetadatas, outputTensors);
   } else {
-    objectMetadatas[0]->mOutputBMtensors = getOutputDeviceMem(context);
     int ret = context->bmNetwork->forward(
-        objectMetadatas[0]->mInputBMtensors->tensors,
-        objectMetadatas[0]->mOutputBMtensors->tensors);
+        objectMetadatas[0]->mInputBMtensors->tensors, outputTensors->tensors);
   }
 
   for (auto obj : objectMetadatas) {
@@ -262,48 +267,61 @@ common::ErrorCode ResNetMultiTask::predict(
   return common::ErrorCode::SUCCESS;
 }
 
+int ResNetMultiTask::getBatchOutput(
+    std::shared_ptr<ResNetContext> context,
+    common::ObjectMetadatas& objectMetadatas,
+    std::shared_ptr<sophon_stream::common::bmTensors> outputTensors,
+    std::shared_ptr<BMNNTensor>& outputTensor, int& rowSize) {
+  int num = 0;
+  while (num < objectMetadatas.size() &&
+         !objectMetadatas[num]->mFrame->mEndOfStream)
+    ++num;
+  if (num == 0) return 0;
+
+  int index = context->output_num - 1;
+  outputTensor = std::make_shared<BMNNTensor>(
+      outputTensors->handle, context->bmNetwork->m_netinfo->output_names[index],
+      context->bmNetwork->m_netinfo->output_scales[index],
+      outputTensors->tensors[index].get(), context->bmNetwork->is_soc);
+  rowSize = bmrt_shape_count(&outputTensors->tensors[index]->shape) /
+            context->max_batch;
+  return num;
+}
+
 common::ErrorCode ResNetMultiTask::post_process_classfy(
     std::shared_ptr<ResNetContext> context,
-    common::ObjectMetadatas& objectMetadatas) {
+    common::ObjectMetadatas& objectMetadatas,
+    std::shared_ptr<sophon_stream::common::bmTensors> outputTensors) {
   if (objectMetadatas.size() == 0) return common::ErrorCode::SUCCESS;
   assert(context->output_num == 1);
-  for (auto obj : objectMetadatas) {
-    if (obj->mFrame->mEndOfStream) break;
-    std::shared_ptr<BMNNTensor> outputTensor = std::make_shared<BMNNTensor>(
-        obj->mOutputBMtensors->handle,
-        context->bmNetwork->m_netinfo->output_names[context->output_num - 1],
-        context->bmNetwork->m_netinfo->output_scales[context->output_num - 1],
-        obj->mOutputBMtensors->tensors[context->output_num - 1].get(),
-        context->bmNetwork->is_soc);
-
-    float* output_data = (float*)outputTensor->get_cpu_data();
-
+  std::shared_ptr<BMNNTensor> outputTensor;
+  int rowSize = 0;
+  int num = getBatchOutput(context, objectMetadatas, outputTensors,
+                           outputTensor, rowSize);
+  if (num == 0) return common::ErrorCode::SUCCESS;
+  float* output_data = (float*)outputTensor->get_cpu_data();
+
+  auto output_scale =
+      context->bmNetwork->m_netinfo->output_scales[context->output_num - 1];
+  int k = std::min(context->top_k, context->class_num);
+  std::vector<int> labels(num * k);
+  std::vector<float> scores(num * k);
+  ResNetHeads heads;
+  heads.softmaxTopK(output_data, num, context->class_num, rowSize,
+                    output_scale, k, labels.data(), scores.data());
+
+  for (int i = 0; i < num; ++i) {
+    auto& obj = objectMetadatas[i];
     std::shared_ptr<common::RecognizedObjectMetadata> RecogObj =
         std::make_shared<common::RecognizedObjectMetadata>();
-
-    auto output_scale =
-        context->bmNetwork->m_netinfo->output_scales[context->output_num - 1];
-    float exp_sum = 0;
-    for (int j = 0; j < context->class_num; j++) {
-      exp_sum += std::exp(*(output_data + j) * output_scale);
-    }
-    int max_idx = -1;
-    float max_score = -1;
-    for (int j = 0; j < context->class_num; j++) {
-      float score = 0;
-      score = std::exp(*(output_data + j) * output_scale) / exp_sum;
-      if (max_score < score) {
-        max_score = score;
-        max_idx = j;
-      }
-    }
-
-    RecogObj->mScores.push_back(max_score);
-    RecogObj->mTopKLabels.push_back(max_idx);
+    RecogObj->mScores.assign(scores.begin() + i * k,
+                             scores.begin() + (i + 1) * k);
+    RecogObj->mTopKLabels.assign(labels.begin() + i * k,
+                                 labels.begin() + (i + 1) * k);
     obj->mRecognizedObjectMetadatas.push_back(RecogObj);
 
     IVS_DEBUG("recognizition succeed, frame_id: {0}, class_id: {1}",
-              obj->mFrame->mFrameId, max_idx);
+              obj->mFrame->mFrameId, labels[i * k]);
   }
 
   return common::ErrorCode::SUCCESS;
@@ -311,67 +329,68 @@ common::ErrorCode ResNetMultiTask::post_process_classfy(
 
 common::ErrorCode ResNetMultiTask::post_process_extract(
     std::shared_ptr<ResNetContext> context,
-    common::ObjectMetadatas& objectMetadatas) {
+    common::ObjectMetadatas& objectMetadatas,
+    std::shared_ptr<sophon_stream::common::bmTensors> outputTensors) {
   if (objectMetadatas.size() == 0) return common::ErrorCode::SUCCESS;
   assert(context->output_num == 1);
-  for (auto obj : objectMetadatas) {
-    if (obj->mFrame->mEndOfStream) break;
-    std::shared_ptr<BMNNTensor> outputTensor = std::make_shared<BMNNTensor>(
-        obj->mOutputBMtensors->handle,
-        context->bmNetwork->m_netinfo->output_names[context->output_num - 1],
-        context->bmNetwork->m_netinfo->output_scales[context->output_num - 1],
-        obj->mOutputBMtensors->tensors[context->output_num - 1].get(),
-        context->bmNetwork->is_soc);
-
-    float* output_data = (float*)outputTensor->get_cpu_data();
+  std::shared_ptr<BMNNTensor> outputTensor;
+  int rowSize = 0;
+  int num = getBatchOutput(context, objectMetadatas, outputTensors,
+                           outputTensor, rowSize);
+  if (num == 0) return common::ErrorCode::SUCCESS;
+  float* output_data = (float*)outputTensor->get_cpu_data();
+
+  // 一个batch的特征放在同一块连续内存中，各目标的feature_vector共享这块内存
+  std::shared_ptr<float> features(new float[num * rowSize],
+                                  std::default_delete<float[]>());
+  if (context->feature_normalize) {
+    ResNetHeads::l2Normalize(output_data, num, rowSize, features.get());
+  } else {
+    std::memcpy(features.get(), output_data, sizeof(float) * num * rowSize);
+  }
 
+  for (int i = 0; i < num; ++i) {
+    auto& obj = objectMetadatas[i];
     std::shared_ptr<common::RecognizedObjectMetadata> RecogObj =
         std::make_shared<common::RecognizedObjectMetadata>();
-
-    if (context->taskType == TaskType::FeatureExtract) {
-      RecogObj->feature_vector.reset(new float[512]);
-      std::memcpy(RecogObj->feature_vector.get(), output_data,
-                  sizeof(float) * 512);
-      obj->mRecognizedObjectMetadatas.push_back(RecogObj);
-      IVS_DEBUG("recognizition succeed, frame_id: {0}", obj->mFrame->mFrameId);
-      continue;
-    }
+    RecogObj->feature_vector =
+        std::shared_ptr<float>(features, features.get() + i * rowSize);
+    obj->mRecognizedObjectMetadatas.push_back(RecogObj);
+    IVS_DEBUG("recognizition succeed, frame_id: {0}", obj->mFrame->mFrameId);
   }
   return common::ErrorCode::SUCCESS;
 }
 
 common::ErrorCode ResNetMultiTask::post_process_multilabel(
     std::shared_ptr<ResNetContext> context,
-    common::ObjectMetadatas& objectMetadatas) {
+    common::ObjectMetadatas& objectMetadatas,
+    std::shared_ptr<sophon_stream::common::bmTensors> outputTensors) {
   if (objectMetadatas.size() == 0) return common::ErrorCode::SUCCESS;
-  for (auto obj : objectMetadatas) {
-    if (obj->mFrame->mEndOfStream) break;
-    std::shared_ptr<BMNNTensor> outputTensor = std::make_shared<BMNNTensor>(
-        obj->mOutputBMtensors->handle,
-        context->bmNetwork->m_netinfo->output_names[context->output_num - 1],
-        context->bmNetwork->m_netinfo->output_scales[context->output_num - 1],
-        obj->mOutputBMtensors->tensors[context->output_num - 1].get(),
-        context->bmNetwork->is_soc);
-
-    float* output_data = (float*)outputTensor->get_cpu_data();
-
+  std::shared_ptr<BMNNTensor> outputTensor;
+  int rowSize = 0;
+  int num = getBatchOutput(context, objectMetadatas, outputTensors,
+                           outputTensor, rowSize);
+  if (num == 0) return common::ErrorCode::SUCCESS;
+  float* output_data = (float*)outputTensor->get_cpu_data();
+
+  auto output_scale =
+      context->bmNetwork->m_netinfo->output_scales[context->output_num - 1];
+  int classNum = context->class_num;
+  std::vector<int> labels(num * classNum);
+  std::vector<float> scores(num * classNum);
+  ResNetHeads heads;
+  heads.softmaxThreshold(output_data, num, classNum, rowSize, output_scale,
+                         context->class_thresh.data(), scores.data(),
+                         labels.data());
+
+  for (int i = 0; i < num; ++i) {
     std::shared_ptr<common::RecognizedObjectMetadata> RecogObj =
         std::make_shared<common::RecognizedObjectMetadata>();
-
-    auto output_scale =
-        context->bmNetwork->m_netinfo->output_scales[context->output_num - 1];
-    // sigmoid
-    float exp_sum = 0;
-    for (int j = 0; j < context->class_num; j++) {
-      exp_sum += std::exp(*(output_data + j) * output_scale);
-    }
-    for (int j = 0; j < context->class_num; j++) {
-      float score = 0;
-      score = std::exp(*(output_data + j) * output_scale) / exp_sum;
-      RecogObj->mScores.push_back(score);
-      RecogObj->mTopKLabels.push_back((score > context->class_thresh[j]) ? 1 : 0);
-    }
-    obj->mRecognizedObjectMetadatas.push_back(RecogObj);
+    RecogObj->mScores.assign(scores.begin() + i * classNum,
+                             scores.begin() + (i + 1) * classNum);
+    RecogObj->mTopKLabels.assign(labels.begin() + i * classNum,
+                                 labels.begin() + (i + 1) * classNum);
+    objectMetadatas[i]->mRecognizedObjectMetadatas.push_back(RecogObj);
   }
   return common::ErrorCode::SUCCESS;
 }
@@ -483,61 +502,6 @@ ResNetMultiTask::getOutputDeviceMem(std::shared_ptr<ResNetContext> context) {
   return outputTensors;
 }
 
-void ResNetMultiTask::splitOutputMemIntoObjectMetadatas(
-    std::shared_ptr<ResNetContext> context,
-    common::ObjectMetadatas& objectMetadatas,
-    std::shared_ptr<sophon_stream::common::bmTensors> outputTensors) {
-  // 把outputTensors的显存拆出来给objectMetadatas
-  for (int i = 0; i < objectMetadatas.size(); ++i) {
-    if (objectMetadatas[i]->mFrame->mEndOfStream) break;
-    objectMetadatas[i]->mOutputBMtensors =
-        std::make_shared<sophon_stream::common::bmTensors>();
-    objectMetadatas[i]->mOutputBMtensors.reset(
-        new sophon_stream::common::bmTensors(),
-        [](sophon_stream::common::bmTensors* p) {
-          for (int i = 0; i < p->tensors.size(); ++i)
-            if (p->tensors[i]->device_mem.u.device.device_addr != 0) {
-              bm_free_device(p->handle, p->tensors[i]->device_mem);
-            }
-          delete p;
-          p = nullptr;
-        });
-    objectMetadatas[i]->mOutputBMtensors->tensors.resize(context->output_num);
-    objectMetadatas[i]->mOutputBMtensors->handle = context->handle;
-    for (int j = 0; j < context->output_num; ++j) {
-      objectMetadatas[i]->mOutputBMtensors->tensors[j] =
-          std::make_shared<bm_tensor_t>();
-      objectMetadatas[i]->mOutputBMtensors->tensors[j]->dtype =
-          context->bmNetwork->m_netinfo->output_dtypes[j];
-      objectMetadatas[i]->mOutputBMtensors->tensors[j]->shape =
-          context->bmNetwork->m_netinfo->stages[0].output_shapes[j];
-      objectMetadatas[i]->mOutputBMtensors->tensors[j]->shape.dims[0] /=
-          context->max_batch;
-      objectMetadatas[i]->mOutputBMtensors->tensors[j]->st_mode = BM_STORE_1N;
-      size_t max_size = 0;
-      for (int s = 0; s < context->bmNetwork->m_netinfo->stage_num; s++) {
-        size_t out_size = bmrt_shape_count(
-            &context->bmNetwork->m_netinfo->stages[s].output_shapes[j]);
-        if (max_size < out_size) {
-          max_size = out_size;
-        }
-      }
-      if (BM_FLOAT32 == context->bmNetwork->m_netinfo->output_dtypes[j])
-        max_size *= 4;
-      max_size /= context->max_batch;
-      auto ret = bm_malloc_device_byte(
-          objectMetadatas[i]->mOutputBMtensors->handle,
-          &objectMetadatas[i]->mOutputBMtensors->tensors[j]->device_mem,
-          max_size);
-      STREAM_CHECK(ret == 0, "Alloc Device Memory Failed! Program Terminated.")
-      bm_memcpy_d2d_byte(
-          context->handle,
-          objectMetadatas[i]->mOutputBMtensors->tensors[j]->device_mem, 0,
-          outputTensors->tensors[j]->device_mem, i * max_size, max_size);
-    }
-  }
-}
-
 }  // namespace resnet
 }  // namespace element
 }  // namespace sophon_stream
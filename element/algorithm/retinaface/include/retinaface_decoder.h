@@ -0,0 +1,127 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SOPHON_STREAM_ELEMENT_RETINAFACE_DECODER_H_
+#define SOPHON_STREAM_ELEMENT_RETINAFACE_DECODER_H_
+
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+namespace sophon_stream {
+namespace element {
+namespace retinaface {
+
+struct anchor_box {
+  float x1;
+  float y1;
+  float x2;
+  float y2;
+};
+
+struct FacePts {
+  float x[5];
+  float y[5];
+};
+
+struct FaceDetectInfo {
+  float score;
+  anchor_box rect;
+  FacePts pts;
+};
+
+// 归一化到[0, 1]的先验框中心和宽高
+struct RetinafacePrior {
+  float cx;
+  float cy;
+  float w;
+  float h;
+};
+
+/**
+ * @brief 按网络输入尺寸生成先验框，顺序与网络输出一致
+ */
+inline std::vector<RetinafacePrior> buildRetinafacePriors(int net_w,
+                                                          int net_h) {
+  const int num_layer = 3;
+  const size_t steps[] = {8, 16, 32};
+  const int num_anchor = 2;
+  const size_t anchor_sizes[][2] = {{16, 32}, {64, 128}, {256, 512}};
+
+  std::vector<RetinafacePrior> priors;
+  for (int il = 0; il < num_layer; ++il) {
+    int feature_width = (net_w + steps[il] - 1) / steps[il];
+    int feature_height = (net_h + steps[il] - 1) / steps[il];
+    for (int iy = 0; iy < feature_height; ++iy) {
+      for (int ix = 0; ix < feature_width; ++ix) {
+        for (int ia = 0; ia < num_anchor; ++ia) {
+          size_t min_size = anchor_sizes[il][ia];
+          RetinafacePrior prior;
+          prior.cx = (ix + 0.5) * steps[il] / net_w;
+          prior.cy = (iy + 0.5) * steps[il] / net_h;
+          prior.w = min_size * 1. / net_w;
+          prior.h = min_size * 1. / net_h;
+          priors.push_back(prior);
+        }
+      }
+    }
+  }
+  return priors;
+}
+
+/**
+ * @brief 解码置信度不低于threshold的先验框，结果追加到faceInfo，未做NMS
+ * @param cls_data 每个先验框2个值，第2个为人脸置信度
+ * @param loc_data 每个先验框4个值
+ * @param land_data 每个先验框10个值
+ * @param net_w 网络输入宽度，归一化坐标先映射到网络输入
+ * @param net_h 网络输入高度
+ * @param ratio 网络输入相对原图的缩放比例
+ */
+inline void decodeRetinafaceFaces(const std::vector<RetinafacePrior>& priors,
+                                  const float* cls_data, const float* loc_data,
+                                  const float* land_data, float threshold,
+                                  int net_w, int net_h, float ratio,
+                                  std::vector<FaceDetectInfo>& faceInfo) {
+  const float variances[] = {0.1, 0.2};
+  const float *loc, *land;
+  float x, y, w, h, conf;
+
+  FaceDetectInfo obj;
+  const int num_priors = priors.size();
+  for (int index = 0; index < num_priors; ++index) {
+    conf = cls_data[index * 2 + 1];
+    if (conf < threshold) continue;
+    const RetinafacePrior& prior = priors[index];
+    obj.score = conf;
+    loc = loc_data + index * 4;
+    w = std::exp(loc[2] * variances[1]) * prior.w;
+    h = std::exp(loc[3] * variances[1]) * prior.h;
+    x = prior.cx + loc[0] * variances[0] * prior.w;
+    y = prior.cy + loc[1] * variances[0] * prior.h;
+    obj.rect.x1 = (x - w / 2) * net_w / ratio;
+    obj.rect.x2 = (x + w / 2) * net_w / ratio;
+    obj.rect.y1 = (y - h / 2) * net_h / ratio;
+    obj.rect.y2 = (y + h / 2) * net_h / ratio;
+    land = land_data + index * 10;
+    for (int i = 0; i < 5; ++i) {
+      obj.pts.x[i] =
+          (prior.cx + land[i * 2] * variances[0] * prior.w) * net_w / ratio;
+      obj.pts.y[i] =
+          (prior.cy + land[i * 2 + 1] * variances[0] * prior.h) * net_h / ratio;
+    }
+    faceInfo.push_back(obj);
+  }
+}
+
+}  // namespace retinaface
+}  // namespace element
+}  // namespace sophon_stream
+
+#endif  // SOPHON_STREAM_ELEMENT_RETINAFACE_DECODER_H_
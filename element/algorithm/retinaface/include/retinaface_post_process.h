@@ -14,6 +14,7 @@
 
 #include "algorithmApi/post_process.h"
 #include "retinaface_context.h"
+#include "retinaface_decoder.h"
 
 using namespace std;
 using namespace cv;
@@ -39,24 +40,6 @@ struct anchor_win {
   float h;
 };
 
-struct anchor_box {
-  float x1;
-  float y1;
-  float x2;
-  float y2;
-};
-
-struct FacePts {
-  float x[5];
-  float y[5];
-};
-
-struct FaceDetectInfo {
-  float score;
-  anchor_box rect;
-  FacePts pts;
-};
-
 struct anchor_cfg {
  public:
   int STRIDE;
@@ -105,6 +88,9 @@ class RetinafacePostProcess : public ::sophon_stream::element::PostProcess {
   std::map<std::string, std::vector<anchor_box> > _anchors_fpn;
   std::map<std::string, std::vector<anchor_box> > _anchors;
   std::map<std::string, int> _num_anchors;
+
+  // init时按网络输入尺寸生成，顺序与网络输出一致
+  std::vector<RetinafacePrior> mPriors;
 };
 
 }  // namespace retinaface
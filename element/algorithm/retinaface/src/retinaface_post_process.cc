@@ -12,7 +12,10 @@ namespace sophon_stream {
 namespace element {
 namespace retinaface {
 
-void RetinafacePostProcess::init(std::shared_ptr<RetinafaceContext> context) {}
+void RetinafacePostProcess::init(std::shared_ptr<RetinafaceContext> context) {
+  // 先验框只取决于网络输入尺寸，构建一次供所有帧使用
+  mPriors = buildRetinafacePriors(context->net_w, context->net_h);
+}
 
 void RetinafacePostProcess::postProcess(
     std::shared_ptr<RetinafaceContext> context,
@@ -104,9 +107,6 @@ void RetinafacePostProcess::get_faceInfo(
     vector<FaceDetectInfo>& faceInfo, float** preds,
     map<string, int>& output_names_map, int img_h, int img_w, float ratio_,
     float threshold, float scales) {
-  int hs = context->net_h;
-  int ws = context->net_w;
-
   float* cls_data =
       preds[output_names_map[context->bmNetwork->m_netinfo->output_names[1]]];
   float* land_data =
@@ -114,66 +114,10 @@ void RetinafacePostProcess::get_faceInfo(
   float* loc_data =
       preds[output_names_map[context->bmNetwork->m_netinfo->output_names[0]]];
 
-  const int num_layer = 3;
-  const size_t steps[] = {8, 16, 32};
-  const int num_anchor = 2;
-  const size_t anchor_sizes[][2] = {{16, 32}, {64, 128}, {256, 512}};
-  const float variances[] = {0.1, 0.2};
-
-  size_t index = 0, min_size;
-  const float *loc, *land;
-  float x, y, w, h, conf;
-  float anchor_w, anchor_h, anchor_x, anchor_y;
-
-  FaceDetectInfo obj;
-  for (int il = 0; il < num_layer; ++il) {
-    int feature_width = (ws + steps[il] - 1) / steps[il];
-    int feature_height = (hs + steps[il] - 1) / steps[il];
-    for (int iy = 0; iy < feature_height; ++iy) {
-      for (int ix = 0; ix < feature_width; ++ix) {
-        for (int ia = 0; ia < num_anchor; ++ia) {
-          conf = cls_data[index * 2 + 1];
-          if (conf < threshold) goto cond;
-          min_size = anchor_sizes[il][ia];
-          anchor_x = (ix + 0.5) * steps[il] / ws;
-          anchor_y = (iy + 0.5) * steps[il] / hs;
-          anchor_w = min_size * 1. / ws;
-          anchor_h = min_size * 1. / hs;
-          obj.score = conf;
-          loc = loc_data + index * 4;
-          w = exp(loc[2] * variances[1]) * anchor_w;
-          h = exp(loc[3] * variances[1]) * anchor_h;
-          x = anchor_x + loc[0] * variances[0] * anchor_w;
-          y = anchor_y + loc[1] * variances[0] * anchor_h;
-          obj.rect.x1 = (x - w / 2) * 640 / ratio_;
-          obj.rect.x2 = (x + w / 2) * 640 / ratio_;
-          obj.rect.y1 = (y - h / 2) * 640 / ratio_;
-          obj.rect.y2 = (y + h / 2) * 640 / ratio_;
-          land = land_data + index * 10;
-          for (int i = 0; i < 5; ++i) {
-            obj.pts.x[i] =
-                (anchor_x +
-                 // land[i * 2] * variances[0] * anchor_w) * net_w_ / ratio_;
-                 // land[i * 2] * variances[0] * anchor_w) * img_w;
-                 land[i * 2] * variances[0] * anchor_w) *
-                640 / ratio_;
-            obj.pts.y[i] =
-                (anchor_y +
-                 // land[i * 2 + 1] * variances[0] * anchor_h) * net_h_ /
-                 // ratio_; land[i * 2 + 1] * variances[0] * anchor_h) * img_h;
-                 land[i * 2 + 1] * variances[0] * anchor_h) *
-                640 / ratio_;
-          }
-          faceInfo.push_back(obj);
-        cond:
-          ++index;
-        }
-      }
-    }
-  }
+  decodeRetinafaceFaces(mPriors, cls_data, loc_data, land_data, threshold,
+                        context->net_w, context->net_h, ratio_, faceInfo);
 
   faceInfo = nms(faceInfo, context->thresh_nms);
-
 }
 
 vector<anchor_box> RetinafacePostProcess::bbox_pred(
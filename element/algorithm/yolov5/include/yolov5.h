@@ -10,6 +10,7 @@
 #ifndef SOPHON_STREAM_ELEMENT_YOLOV5_H_
 #define SOPHON_STREAM_ELEMENT_YOLOV5_H_
 
+#include "algorithmApi/batcher.h"
 #include "element_factory.h"
 #include "group.h"
 #include "yolov5_context.h"
@@ -58,9 +59,18 @@ class Yolov5 : public ::sophon_stream::framework::Element {
   std::string postNameSetConfThreshold = "/yolov5/SetConfThreshold";
   void listenerSetConfThreshold(const httplib::Request& request,
                                 httplib::Response& response);
+  std::string getNameBatchStatistics = "/yolov5/BatchStatistics";
+  void listenerGetBatchStatistics(const httplib::Request& request,
+                                  httplib::Response& response);
   void registListenFunc(
       sophon_stream::framework::ListenThread* listener) override;
 
+  std::set<std::string> getHotConfigureKeys() const override;
+  common::ErrorCode applyConfigure(const nlohmann::json& configure,
+                                   bool check) override;
+
+  common::ErrorCode warmup() override;
+
   static constexpr const char* CONFIG_INTERNAL_STAGE_NAME_FIELD = "stage";
   static constexpr const char* CONFIG_INTERNAL_MODEL_PATH_FIELD = "model_path";
   static constexpr const char* CONFIG_INTERNAL_THRESHOLD_CONF_FIELD =
@@ -82,6 +92,10 @@ class Yolov5 : public ::sophon_stream::framework::Element {
   static constexpr const char* CONFIG_INTERNAL_HEIGHT_FILED = "height";
   static constexpr const char* CONFIG_INTERNAL_MAX_DET_FILED = "maxdet";
   static constexpr const char* CONFIG_INTERNAL_MIN_DET_FILED = "mindet";
+  static constexpr const char* CONFIG_INTERNAL_BATCH_TIMEOUT_FIELD =
+      "batch_timeout_ms";
+  static constexpr const char* CONFIG_INTERNAL_DETECTION_BATCH_FIELD =
+      "detection_batch";
 
  private:
   std::shared_ptr<Yolov5Context> mContext;          // context对象
@@ -96,8 +110,14 @@ class Yolov5 : public ::sophon_stream::framework::Element {
   std::string mFpsProfilerName;
   ::sophon_stream::common::FpsProfiler mFpsProfiler;
 
+  ::sophon_stream::element::DynamicBatcher mBatcher;  // 组batch对象
+
   common::ErrorCode initContext(const std::string& json);
-  void process(common::ObjectMetadatas& objectMetadatas, int dataPipeId);
+  /**
+   * @param[in] batchSize: 组batch时选中的batch size，推理使用模型中对应的stage
+   */
+  void process(common::ObjectMetadatas& objectMetadatas, int dataPipeId,
+               int batchSize);
 };
 
 }  // namespace yolov5
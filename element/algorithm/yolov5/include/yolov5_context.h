@@ -83,6 +83,10 @@ class Yolov5Context : public ::sophon_stream::element::Context {
   bmcv_rect_t roi;
   bool roi_predefined = false;
   int thread_number;
+  int batch_timeout_us = -1;  // 组batch的最大等待时间，小于0表示等待batch凑满
+  // 检测结果写入ObjectMetadata::mDetectionBatch，不再逐个创建DetectedObjectMetadata
+  bool detection_batch = false;
+  std::shared_ptr<const std::vector<std::string>> detection_class_names;
   unsigned int m_max_det = UINT_MAX, m_min_det = 0;
 };
 }  // namespace yolov5
@@ -29,9 +29,12 @@ class Yolov5Inference : public ::sophon_stream::element::Inference {
   /**
    * network predict output
    * @param[in] context: inputData and outputData
+   * @param[in] batchSize: 推理使用的batch size，选择模型中对应的stage；
+   * 小于等于0时使用max_batch
    */
   common::ErrorCode predict(std::shared_ptr<Yolov5Context> context,
-                            common::ObjectMetadatas& objectMetadatas);
+                            common::ObjectMetadatas& objectMetadatas,
+                            int batchSize = 0);
 
  private:
 };
@@ -43,6 +43,11 @@ class Yolov5PostProcess : public ::sophon_stream::element::PostProcess {
   void postProcess(std::shared_ptr<Yolov5Context> context,
                    common::ObjectMetadatas& objectMetadatas, int dataPipeId);
 
+  /**
+   * @brief 阈值热更新后，同步tpu_kernel后处理中的阈值
+   */
+  void updateThresholds(std::shared_ptr<Yolov5Context> context);
+
   ~Yolov5PostProcess() override;
 
  private:
@@ -60,6 +65,13 @@ class Yolov5PostProcess : public ::sophon_stream::element::PostProcess {
   void postProcessTPUKERNEL(std::shared_ptr<Yolov5Context> context,
                             common::ObjectMetadatas& objectMetadatas,
                             int dataPipeId);
+  /**
+   * @brief 加上roi偏移并按mindet/maxdet过滤后保存检测框
+   * @brief detection_batch为true时写入mDetectionBatch，否则创建DetectedObjectMetadata
+   */
+  void addDetection(const std::shared_ptr<Yolov5Context>& context,
+                    common::ObjectMetadata& objectMetadata,
+                    common::Rectangle<int> box, float score, int classId);
 };
 
 }  // namespace yolov5
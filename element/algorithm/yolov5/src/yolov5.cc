@@ -204,6 +204,25 @@ common::ErrorCode Yolov5::initContext(const std::string& json) {
           roi_it->find(CONFIG_INTERNAL_HEIGHT_FILED)->get<int>();
     }
     mContext->thread_number = getThreadNumber();
+
+    // 8. dynamic batch
+    auto batchTimeoutIt = configure.find(CONFIG_INTERNAL_BATCH_TIMEOUT_FIELD);
+    if (configure.end() != batchTimeoutIt && batchTimeoutIt->is_number()) {
+      mContext->batch_timeout_us =
+          static_cast<int>(batchTimeoutIt->get<float>() * 1000);
+    }
+
+    // 9. detection batch
+    auto detectionBatchIt =
+        configure.find(CONFIG_INTERNAL_DETECTION_BATCH_FIELD);
+    if (configure.end() != detectionBatchIt && detectionBatchIt->is_boolean()) {
+      mContext->detection_batch = detectionBatchIt->get<bool>();
+    }
+    if (mContext->class_thresh_valid) {
+      mContext->detection_class_names =
+          std::make_shared<const std::vector<std::string>>(
+              mContext->class_names);
+    }
   } while (false);
   return common::ErrorCode::SUCCESS;
 }
@@ -250,6 +269,8 @@ common::ErrorCode Yolov5::initInternal(const std::string& json) {
 
     mContext->deviceId = getDeviceId();
     initContext(configure.dump());
+    mBatcher.init(mContext->max_batch, mContext->bmNetwork->m_batches,
+                  mContext->batch_timeout_us);
     // 前处理初始化
     mPreProcess->init(mContext);
     // 推理初始化
@@ -261,7 +282,8 @@ common::ErrorCode Yolov5::initInternal(const std::string& json) {
   return errorCode;
 }
 
-void Yolov5::process(common::ObjectMetadatas& objectMetadatas, int dataPipeId) {
+void Yolov5::process(common::ObjectMetadatas& objectMetadatas, int dataPipeId,
+                     int batchSize) {
   common::ErrorCode errorCode = common::ErrorCode::SUCCESS;
   if (use_pre) {
     errorCode = mPreProcess->preProcess(mContext, objectMetadatas);
@@ -274,7 +296,7 @@ void Yolov5::process(common::ObjectMetadatas& objectMetadatas, int dataPipeId) {
   }
   // 推理
   if (use_infer) {
-    errorCode = mInference->predict(mContext, objectMetadatas);
+    errorCode = mInference->predict(mContext, objectMetadatas, batchSize);
     if (common::ErrorCode::SUCCESS != errorCode) {
       for (unsigned i = 0; i < objectMetadatas.size(); i++) {
         objectMetadatas[i]->mErrorCode = errorCode;
@@ -300,37 +322,24 @@ common::ErrorCode Yolov5::doWork(int dataPipeId) {
   }
 
   common::ObjectMetadatas pendingObjectMetadatas;
+  std::vector<framework::Message> controlMessages;
 
-  while (objectMetadatas.size() < mContext->max_batch &&
-         (getThreadStatus() == ThreadStatus::RUN)) {
-    // 如果队列为空则等待
-    auto data = popInputData(inputPort, dataPipeId);
-    if (!data) {
-      std::this_thread::sleep_for(std::chrono::milliseconds(10));
-      continue;
-    }
-
-    auto objectMetadata =
-        std::static_pointer_cast<common::ObjectMetadata>(data);
-    if (!objectMetadata->mFilter) objectMetadatas.push_back(objectMetadata);
-
-    pendingObjectMetadatas.push_back(objectMetadata);
+  int batchSize = mBatcher.collect(
+      [&]() { return popInputMessage(inputPort, dataPipeId); },
+      [&]() { return getThreadStatus() == ThreadStatus::RUN; },
+      objectMetadatas, pendingObjectMetadatas, controlMessages);
 
-    if (objectMetadata->mFrame->mEndOfStream) {
-      break;
-    }
-  }
-
-  process(objectMetadatas, dataPipeId);
+  process(objectMetadatas, dataPipeId, batchSize);
 
   for (auto& objectMetadata : pendingObjectMetadatas) {
     int channel_id_internal = objectMetadata->mFrame->mChannelIdInternal;
     int outDataPipeId =
         getSinkElementFlag()
             ? 0
-            : (channel_id_internal % getOutputConnectorCapacity(outputPort));
-    errorCode = pushOutputData(outputPort, outDataPipeId,
-                               std::static_pointer_cast<void>(objectMetadata));
+            : getOutputDataPipeId(outputPort, channel_id_internal,
+                                  objectMetadata->mFrame->mEndOfStream);
+    errorCode = pushOutputMessage(outputPort, outDataPipeId,
+                                  framework::Message(objectMetadata));
     if (common::ErrorCode::SUCCESS != errorCode) {
       IVS_WARN(
           "Send data fail, element id: {0:d}, output port: {1:d}, data: "
@@ -338,6 +347,9 @@ common::ErrorCode Yolov5::doWork(int dataPipeId) {
           getId(), outputPort, static_cast<void*>(objectMetadata.get()));
     }
   }
+  // 控制消息跟在它之前到达的数据后面
+  for (auto& controlMessage : controlMessages)
+    forwardControlMessage(controlMessage);
   mFpsProfiler.add(objectMetadatas.size());
 
   return common::ErrorCode::SUCCESS;
@@ -357,6 +369,8 @@ void Yolov5::setContext(
     std::shared_ptr<::sophon_stream::element::Context> context) {
   // check
   mContext = std::dynamic_pointer_cast<Yolov5Context>(context);
+  mBatcher.init(mContext->max_batch, mContext->bmNetwork->m_batches,
+                mContext->batch_timeout_us);
 }
 
 void Yolov5::setPreprocess(
@@ -382,6 +396,71 @@ void Yolov5::registListenFunc(
                        sophon_stream::framework::RequestType::POST,
                        std::bind(&Yolov5::listenerSetConfThreshold, this,
                                  std::placeholders::_1, std::placeholders::_2));
+  handlerName = getNameBatchStatistics + "/" + mIdStr;
+  listener->setHandler(handlerName.c_str(),
+                       sophon_stream::framework::RequestType::GET,
+                       std::bind(&Yolov5::listenerGetBatchStatistics, this,
+                                 std::placeholders::_1, std::placeholders::_2));
+}
+
+common::ErrorCode Yolov5::warmup() {
+  // 模型中编译的每个batch size各推理一次
+  return mContext->bmNetwork->warmup() == 0 ? common::ErrorCode::SUCCESS
+                                            : common::ErrorCode::WARMUP_FAIL;
+}
+
+std::set<std::string> Yolov5::getHotConfigureKeys() const {
+  return {CONFIG_INTERNAL_THRESHOLD_CONF_FIELD,
+          CONFIG_INTERNAL_THRESHOLD_NMS_FIELD};
+}
+
+common::ErrorCode Yolov5::applyConfigure(const nlohmann::json& configure,
+                                         bool check) {
+  float threshConfMin = mContext->thresh_conf_min;
+  auto threshConf = mContext->thresh_conf;
+  float threshNms = mContext->thresh_nms;
+
+  auto threshConfIt = configure.find(CONFIG_INTERNAL_THRESHOLD_CONF_FIELD);
+  if (configure.end() != threshConfIt) {
+    // 与initContext一致：float对应全局阈值，object对应按类别的阈值
+    if (threshConfIt->is_number() && !mContext->class_thresh_valid) {
+      threshConfMin = threshConfIt->get<float>();
+    } else if (threshConfIt->is_object() && mContext->class_thresh_valid) {
+      threshConfMin = 1;
+      for (auto it = threshConfIt->begin(); it != threshConfIt->end(); ++it) {
+        if (!it->is_number() ||
+            std::find(mContext->class_names.begin(),
+                      mContext->class_names.end(),
+                      it.key()) == mContext->class_names.end())
+          return common::ErrorCode::PARSE_CONFIGURE_FAIL;
+        threshConf[it.key()] = it->get<float>();
+      }
+      for (auto& it : threshConf)
+        threshConfMin = std::min(threshConfMin, it.second);
+    } else {
+      return common::ErrorCode::PARSE_CONFIGURE_FAIL;
+    }
+    if (threshConfMin <= 0 || threshConfMin >= 1)
+      return common::ErrorCode::PARSE_CONFIGURE_FAIL;
+  }
+
+  auto threshNmsIt = configure.find(CONFIG_INTERNAL_THRESHOLD_NMS_FIELD);
+  if (configure.end() != threshNmsIt) {
+    if (!threshNmsIt->is_number())
+      return common::ErrorCode::PARSE_CONFIGURE_FAIL;
+    threshNms = threshNmsIt->get<float>();
+    if (threshNms <= 0 || threshNms > 1)
+      return common::ErrorCode::PARSE_CONFIGURE_FAIL;
+  }
+
+  if (check) return common::ErrorCode::SUCCESS;
+
+  mContext->thresh_conf = threshConf;
+  mContext->thresh_conf_min = threshConfMin;
+  mContext->log_conf_threshold = -std::log(1 / mContext->thresh_conf_min - 1);
+  mContext->thresh_nms = threshNms;
+  if (mPostProcess) mPostProcess->updateThresholds(mContext);
+  return common::ErrorCode::SUCCESS;
 }
 
 void Yolov5::listenerSetConfThreshold(const httplib::Request& request,
@@ -389,14 +468,29 @@ void Yolov5::listenerSetConfThreshold(const httplib::Request& request,
   common::Response resp;
   common::RequestSingleFloat rsi;
   common::str_to_object(request.body, rsi);
-  mContext->thresh_conf_min = rsi.value;
-  resp.code = 0;
-  resp.msg = "success";
+  // lazy_init时模型加载之前还没有mContext
+  if (!isInitialized() || !mContext) {
+    resp.code = static_cast<int>(common::ErrorCode::ELEMENT_NOT_READY);
+    resp.msg = common::ErrorCodeToString(common::ErrorCode::ELEMENT_NOT_READY);
+  } else {
+    mContext->thresh_conf_min = rsi.value;
+    mContext->log_conf_threshold =
+        -std::log(1 / mContext->thresh_conf_min - 1);
+    resp.code = 0;
+    resp.msg = "success";
+  }
   nlohmann::json json_res = resp;
   response.set_content(json_res.dump(), "application/json");
   return;
 }
 
+void Yolov5::listenerGetBatchStatistics(const httplib::Request& request,
+                                        httplib::Response& response) {
+  nlohmann::json json_res = mBatcher.getStatistics();
+  response.set_content(json_res.dump(), "application/json");
+  return;
+}
+
 REGISTER_WORKER("yolov5", Yolov5)
 REGISTER_GROUP_WORKER("yolov5_group", sophon_stream::framework::Group<Yolov5>,
                       Yolov5)
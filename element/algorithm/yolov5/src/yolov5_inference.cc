@@ -19,12 +19,14 @@ void Yolov5Inference::init(std::shared_ptr<Yolov5Context> context) {}
 
 common::ErrorCode Yolov5Inference::predict(
     std::shared_ptr<Yolov5Context> context,
-    common::ObjectMetadatas& objectMetadatas) {
+    common::ObjectMetadatas& objectMetadatas, int batchSize) {
   if (objectMetadatas.size() == 0) return common::ErrorCode::SUCCESS;
 
-  if (context->max_batch > 1) {
-    auto inputTensors = mergeInputDeviceMem(context, objectMetadatas);
-    auto outputTensors = getOutputDeviceMem(context);
+  if (batchSize <= 0) batchSize = context->max_batch;
+  if (batchSize > 1) {
+    auto inputTensors =
+        mergeInputDeviceMem(context, objectMetadatas, batchSize);
+    auto outputTensors = getOutputDeviceMem(context, batchSize);
 
     int ret = 0;
 #if BMCV_VERSION_MAJOR > 1
@@ -35,11 +37,12 @@ common::ErrorCode Yolov5Inference::predict(
                                       outputTensors->tensors);
 #endif
 
-    splitOutputMemIntoObjectMetadatas(context, objectMetadatas, outputTensors);
+    splitOutputMemIntoObjectMetadatas(context, objectMetadatas, outputTensors,
+                                      batchSize);
   } else {
     if (objectMetadatas[0]->mFrame->mEndOfStream)
       return common::ErrorCode::SUCCESS;
-    objectMetadatas[0]->mOutputBMtensors = getOutputDeviceMem(context);
+    objectMetadatas[0]->mOutputBMtensors = getOutputDeviceMem(context, 1);
 #if BMCV_VERSION_MAJOR > 1
     int ret = context->bmNetwork->forward<false>(
         objectMetadatas[0]->mInputBMtensors->tensors,
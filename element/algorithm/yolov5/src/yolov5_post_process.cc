@@ -65,6 +65,19 @@ void Yolov5PostProcess::init(std::shared_ptr<Yolov5Context> context) {
   }
 }
 
+void Yolov5PostProcess::updateThresholds(
+    std::shared_ptr<Yolov5Context> context) {
+  if (multi_thread_tpu_kernel == nullptr) return;
+  for (int i = 0; i < context->thread_number; i++) {
+    for (int j = 0; j < context->max_batch; j++) {
+      multi_thread_tpu_kernel[i].api[j].nms_threshold =
+          0.1 > context->thresh_nms ? 0.1 : context->thresh_nms;
+      multi_thread_tpu_kernel[i].api[j].confidence_threshold =
+          0.1 > context->thresh_conf_min ? 0.1 : context->thresh_conf_min;
+    }
+  }
+}
+
 Yolov5PostProcess::~Yolov5PostProcess() {
   if (multi_thread_tpu_kernel != nullptr) {
     for (int i = 0; i < global_context->thread_number; i++) {
@@ -141,7 +154,9 @@ void Yolov5PostProcess::setTpuKernelMem(
   std::vector<std::vector<std::shared_ptr<bm_device_mem_t>>> in_dev_mems(
       context->max_batch,
       std::vector<std::shared_ptr<bm_device_mem_t>>(input_num));
-  for (int batch_idx = 0; batch_idx < context->max_batch; ++batch_idx) {
+  // 超时送出的batch可能不满
+  int num = std::min<int>(context->max_batch, objectMetadatas.size());
+  for (int batch_idx = 0; batch_idx < num; ++batch_idx) {
     if (objectMetadatas[batch_idx]->mFrame->mEndOfStream) break;
     for (int i = 0; i < input_num; i++)
       in_dev_mems[batch_idx][i] = std::make_shared<bm_device_mem_t>(
@@ -183,7 +198,8 @@ void Yolov5PostProcess::postProcessTPUKERNEL(
     common::ObjectMetadatas& objectMetadatas, int dataPipeId) {
   tpu_kernel& tpu_k = multi_thread_tpu_kernel[dataPipeId];
   setTpuKernelMem(context, objectMetadatas, tpu_k);
-  for (int i = 0; i < context->max_batch; i++) {
+  int num = std::min<int>(context->max_batch, objectMetadatas.size());
+  for (int i = 0; i < num; i++) {
     if (objectMetadatas[i]->mFrame->mEndOfStream) break;
     bm_image image = *objectMetadatas[i]->mFrame->mSpData;
     int tx1 = 0, ty1 = 0;
@@ -246,25 +262,12 @@ void Yolov5PostProcess::postProcessTPUKERNEL(
       temp_bbox.x = std::max(int(centerX - temp_bbox.width / 2), 0);
       temp_bbox.y = std::max(int(centerY - temp_bbox.height / 2), 0);
 
-      std::shared_ptr<common::DetectedObjectMetadata> detData =
-          std::make_shared<common::DetectedObjectMetadata>();
-      detData->mBox.mX = temp_bbox.x;
-      detData->mBox.mY = temp_bbox.y;
-      detData->mBox.mWidth =
-          std::min(temp_bbox.width, image.width - temp_bbox.x);
-      detData->mBox.mHeight =
-          std::min(temp_bbox.height, image.height - temp_bbox.y);
-      detData->mScores.push_back(temp_bbox.score);
-      detData->mClassify = temp_bbox.class_id;
-      if (context->roi_predefined) {
-        detData->mBox.mX += context->roi.start_x;
-        detData->mBox.mY += context->roi.start_y;
-      }
-      if (detData->mBox.mWidth > context->m_min_det &&
-          detData->mBox.mHeight > context->m_min_det &&
-          detData->mBox.mWidth < context->m_max_det &&
-          detData->mBox.mHeight < context->m_max_det)
-        objectMetadatas[i]->mDetectedObjectMetadatas.push_back(detData);
+      addDetection(context, *objectMetadatas[i],
+                   common::Rectangle<int>(
+                       temp_bbox.x, temp_bbox.y,
+                       std::min(temp_bbox.width, image.width - temp_bbox.x),
+                       std::min(temp_bbox.height, image.height - temp_bbox.y)),
+                   temp_bbox.score, temp_bbox.class_id);
     }
   }
 }
@@ -547,33 +550,52 @@ void Yolov5PostProcess::postProcessCPU(
       }
 
     for (auto bbox : yolobox_vec) {
-      std::shared_ptr<common::DetectedObjectMetadata> detData =
-          std::make_shared<common::DetectedObjectMetadata>();
-      detData->mBox.mX = bbox.x;
-      detData->mBox.mY = bbox.y;
-      detData->mBox.mWidth = bbox.width;
-      detData->mBox.mHeight = bbox.height;
-      detData->mScores.push_back(bbox.score);
-      detData->mClassify = bbox.class_id;
-
-      if (context->roi_predefined) {
-        detData->mBox.mX += context->roi.start_x;
-        detData->mBox.mY += context->roi.start_y;
-      }
-
-      if (context->class_thresh_valid) {
-        detData->mLabelName = context->class_names[detData->mClassify];
-      }
-      if (detData->mBox.mWidth > context->m_min_det &&
-          detData->mBox.mHeight > context->m_min_det &&
-          detData->mBox.mWidth < context->m_max_det &&
-          detData->mBox.mHeight < context->m_max_det)
-        obj->mDetectedObjectMetadatas.push_back(detData);
+      addDetection(context, *obj,
+                   common::Rectangle<int>(bbox.x, bbox.y, bbox.width,
+                                          bbox.height),
+                   bbox.score, bbox.class_id);
     }
     ++idx;
   }
 }
 
+void Yolov5PostProcess::addDetection(
+    const std::shared_ptr<Yolov5Context>& context,
+    common::ObjectMetadata& objectMetadata, common::Rectangle<int> box,
+    float score, int classId) {
+  if (context->roi_predefined) {
+    box.mX += context->roi.start_x;
+    box.mY += context->roi.start_y;
+  }
+  if (!(box.mWidth > context->m_min_det && box.mHeight > context->m_min_det &&
+        box.mWidth < context->m_max_det && box.mHeight < context->m_max_det))
+    return;
+
+  // 上游已经产生了DetectedObjectMetadata时继续追加到vector，保持结果在同一处
+  if (context->detection_batch &&
+      objectMetadata.mDetectedObjectMetadatas.empty()) {
+    if (!objectMetadata.mDetectionBatch) {
+      objectMetadata.mDetectionBatch =
+          std::make_shared<common::DetectionBatch>();
+      objectMetadata.mDetectionBatch->mClassNames =
+          context->detection_class_names;
+    }
+    objectMetadata.mDetectionBatch->push_back(box.mX, box.mY, box.mWidth,
+                                              box.mHeight, score, classId);
+    return;
+  }
+
+  std::shared_ptr<common::DetectedObjectMetadata> detData =
+      std::make_shared<common::DetectedObjectMetadata>();
+  detData->mBox = box;
+  detData->mScores.push_back(score);
+  detData->mClassify = classId;
+  if (context->class_thresh_valid) {
+    detData->mLabelName = context->class_names[classId];
+  }
+  objectMetadata.mDetectedObjectMetadatas.push_back(detData);
+}
+
 }  // namespace yolov5
 }  // namespace element
 }  // namespace sophon_stream
\ No newline at end of file
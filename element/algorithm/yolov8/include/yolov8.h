@@ -10,6 +10,7 @@
 #ifndef SOPHON_STREAM_ELEMENT_YOLOV8_H_
 #define SOPHON_STREAM_ELEMENT_YOLOV8_H_
 
+#include "algorithmApi/batcher.h"
 #include "element_factory.h"
 #include "group.h"
 #include "yolov8_context.h"
@@ -55,6 +56,18 @@ class Yolov8 : public ::sophon_stream::framework::Element {
     return mPostProcess;
   }
 
+  std::string getNameBatchStatistics = "/yolov8/BatchStatistics";
+  void listenerGetBatchStatistics(const httplib::Request& request,
+                                  httplib::Response& response);
+  void registListenFunc(
+      sophon_stream::framework::ListenThread* listener) override;
+
+  std::set<std::string> getHotConfigureKeys() const override;
+  common::ErrorCode applyConfigure(const nlohmann::json& configure,
+                                   bool check) override;
+
+  common::ErrorCode warmup() override;
+
   static constexpr const char* CONFIG_INTERNAL_STAGE_NAME_FIELD = "stage";
   static constexpr const char* CONFIG_INTERNAL_MODEL_PATH_FIELD = "model_path";
   static constexpr const char* CONFIG_INTERNAL_THRESHOLD_CONF_FIELD =
@@ -73,11 +86,21 @@ class Yolov8 : public ::sophon_stream::framework::Element {
   static constexpr const char* CONFIG_INTERNAL_WIDTH_FILED = "width";
   static constexpr const char* CONFIG_INTERNAL_HEIGHT_FILED = "height";
   static constexpr const char* CONFIG_INTERNAL_TASK_TYPE_FILED = "task_type";
+  static constexpr const char* CONFIG_INTERNAL_BATCH_TIMEOUT_FIELD =
+      "batch_timeout_ms";
+  static constexpr const char* CONFIG_INTERNAL_DETECTION_BATCH_FIELD =
+      "detection_batch";
 
   // yolov8_seg_tpu_opt
   static constexpr const char* CONFIG_INTERNAL_SEG_TPU_OPT_FILED = "seg_tpu_opt";      // yolov8_seg是否使用TPU后处理
   static constexpr const char* CONFIG_INTERNAL_MASK_BMODEL_PATH = "mask_bmodel_path";  // TPU 后处理的bmodel路径
 
+  // yolov8_obb
+  static constexpr const char* CONFIG_INTERNAL_OBB_NMS_IOU_FIELD =
+      "obb_nms_iou";
+  static constexpr const char* CONFIG_INTERNAL_OBB_PRE_NMS_TOPK_FIELD =
+      "obb_pre_nms_topk";
+
  private:
   std::shared_ptr<Yolov8Context> mContext;          // context对象
   std::shared_ptr<Yolov8PreProcess> mPreProcess;    // 预处理对象
@@ -91,8 +114,19 @@ class Yolov8 : public ::sophon_stream::framework::Element {
   std::string mFpsProfilerName;
   ::sophon_stream::common::FpsProfiler mFpsProfiler;
 
+  ::sophon_stream::element::DynamicBatcher mBatcher;  // 组batch对象
+
   common::ErrorCode initContext(const std::string& json);
-  void process(common::ObjectMetadatas& objectMetadatas, int dataPipeId);
+  /**
+   * @brief 按类别设置置信度阈值时，用所有类别阈值中的最小值更新thresh_conf_min
+   * @brief 后处理每帧直接读取mContext中的阈值，不需要另外刷新
+   */
+  void updateThresholds();
+  /**
+   * @param[in] batchSize: 组batch时选中的batch size，推理使用模型中对应的stage
+   */
+  void process(common::ObjectMetadatas& objectMetadatas, int dataPipeId,
+               int batchSize);
 };
 
 }  // namespace yolov8
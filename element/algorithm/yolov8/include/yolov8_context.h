@@ -54,6 +54,10 @@ class Yolov8Context : public ::sophon_stream::element::Context {
   bmcv_rect_t roi;
   bool roi_predefined = false;
   int thread_number;
+  int batch_timeout_us = -1;  // 组batch的最大等待时间，小于0表示等待batch凑满
+  // 检测结果写入ObjectMetadata::mDetectionBatch，不再逐个创建DetectedObjectMetadata
+  bool detection_batch = false;
+  std::shared_ptr<const std::vector<std::string>> detection_class_names;
 
   // yolov8_seg_tpu_opt
   bool seg_tpu_opt = false;
@@ -66,6 +70,9 @@ class Yolov8Context : public ::sophon_stream::element::Context {
   int tpu_mask_num = 32;
   int m_tpumask_net_h, m_tpumask_net_w;
 
+  // yolov8_obb
+  bool obb_polygon_iou = false;  // NMS使用旋转框多边形求交的IoU，否则使用probiou
+  int obb_pre_nms_topk = -1;     // 参与NMS的最高分候选框数，小于等于0表示不限制
 };
 }  // namespace yolov8
 }  // namespace element
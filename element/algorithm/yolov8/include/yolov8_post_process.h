@@ -11,8 +11,10 @@
 #define SOPHON_STREAM_ELEMENT_YOLOV8_POST_PROCESS_H_
 
 #include "algorithmApi/post_process.h"
+#include "common/segment_mask.h"
 #include "opencv2/opencv.hpp"
 #include "yolov8_context.h"
+#include "yolov8_rotated_nms.h"
 
 namespace sophon_stream {
 namespace element {
@@ -24,8 +26,9 @@ struct YoloV8Box {
   int class_id;
   std::vector<float> kps;
 
+  int index = -1;           // index in the detection output, seg only
   std::vector<float> mask;  // mask coefficient
-  cv::Mat mask_img;         // seg mask
+  common::SegmentMask seg_mask;  // seg mask
 };
 
 struct ImageInfo {
@@ -44,12 +47,6 @@ struct Paras {
 
 using YoloV8BoxVec = std::vector<YoloV8Box>;
 
-struct obbBox{
-  float x, y, w, h, angle, score;
-  int class_id;
-};
-using obbBoxVec = std::vector<obbBox>;
-
 class Yolov8PostProcess : public ::sophon_stream::element::PostProcess {
  public:
   void init(std::shared_ptr<Yolov8Context> context);
@@ -80,20 +77,31 @@ class Yolov8PostProcess : public ::sophon_stream::element::PostProcess {
   void postProcessObb(std::shared_ptr<Yolov8Context> context,
                       common::ObjectMetadatas& objectMetadatas);
   void clip_boxes(YoloV8BoxVec& yolobox_vec, int src_w, int src_h);
+  /**
+   * @brief 加上roi偏移并裁剪到图像范围内后保存检测框
+   * @brief detection_batch为true时写入mDetectionBatch，否则创建DetectedObjectMetadata
+   */
+  void addDetection(const std::shared_ptr<Yolov8Context>& context,
+                    common::ObjectMetadata& objectMetadata,
+                    common::Rectangle<int> box, float score, int classId);
 
   // yolov8 seg
-  void get_mask(std::shared_ptr<Yolov8Context> context,
-                const cv::Mat& mask_info, const cv::Mat& mask_data,
-                const ImageInfo& para, cv::Rect bound, cv::Mat& mask_out);
+  /**
+   * @brief 计算目标框在原型网格上覆盖区域的mask logits
+   * @param mask_info 目标框的mask系数，长度为mask_len
+   * @param protos 原型，布局为[mask_len][proto_h][proto_w]
+   * @param paras 原型网格中对应图像的区域和图像大小
+   * @param bound 目标框，图像坐标
+   */
+  void get_mask(const float* mask_info, const float* protos, int mask_len,
+                int proto_w, int proto_h, const Paras& paras, cv::Rect bound,
+                float threshold, common::SegmentMask& mask_out);
   void getmask_tpu(std::shared_ptr<Yolov8Context> context,
                    YoloV8BoxVec& yolov8box_input, int start,
                    const bm_tensor_t& segmentation_tensor, Paras& paras,
                    YoloV8BoxVec& yolov8box_output, float confThreshold);
 
   //obb utils.
-  void nms_rotated(obbBoxVec& dets, float nmsConfidence = 0.5);
-  std::tuple<float, float, float> convariance_matrix(const obbBox& obb);
-  float probiou(const obbBox& obb1, const obbBox& obb2, float eps = 1e-7);
   void regularize_rbox(obbBoxVec& obb);
   common::ObbObjectMetadata xywhr2xyxyxyxy(const obbBox& obb);
 };
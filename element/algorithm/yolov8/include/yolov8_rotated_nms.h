@@ -0,0 +1,97 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SOPHON_STREAM_ELEMENT_YOLOV8_ROTATED_NMS_H_
+#define SOPHON_STREAM_ELEMENT_YOLOV8_ROTATED_NMS_H_
+
+#include <vector>
+
+namespace sophon_stream {
+namespace element {
+namespace yolov8 {
+
+struct obbBox {
+  float x, y, w, h, angle, score;
+  int class_id;
+};
+using obbBoxVec = std::vector<obbBox>;
+
+/**
+ * @brief 旋转框NMS
+ * @brief
+ * 按类别分组，组内按得分从高到低做贪心抑制，每组保留maxDet个框后提前结束。
+ * 候选框先用轴对齐外接框排除不可能达到阈值的框对：probiou使用由阈值推出的
+ * 高斯分布范围，多边形IoU使用旋转框的外接矩形；probiou再按4个框一组计算
+ * 马氏距离项作为下界，只有通过这两步的框对才计算完整的IoU，抑制结果与逐对计算相同。
+ * 不加锁，每个线程使用各自的实例
+ */
+class RotatedNms {
+ public:
+  enum class IouType { ProbIou = 0, Polygon };
+
+  /**
+   * @brief 对dets做NMS
+   * @param dets 输入候选框，输出保留的框，按得分从低到高排列
+   * @param threshold IoU不小于threshold的低分同类框被抑制，取值(0, 1]
+   * @param maxDet 最多保留的框数，小于等于0时不限制
+   * @param preTopk 只取得分最高的preTopk个候选框参与NMS，小于等于0时不限制
+   */
+  void run(obbBoxVec& dets, float threshold, IouType iouType, int maxDet,
+           int preTopk);
+
+  /**
+   * @brief 两个旋转框的probiou，https://arxiv.org/pdf/2106.06072v1.pdf
+   */
+  static float probiou(const obbBox& obb1, const obbBox& obb2,
+                       float eps = 1e-7);
+
+  /**
+   * @brief 两个旋转框作为凸多边形求交得到的IoU
+   */
+  static float polygonIou(const obbBox& obb1, const obbBox& obb2);
+
+ private:
+  // 一个类别的候选框，可以提前排除的在前并按x排序，其余在后
+  struct Candidates {
+    std::vector<float> x, y;
+    std::vector<float> rx, ry;  // 外接框半宽、半高
+    std::vector<float> a, b;    // x、y方向的方差
+    std::vector<float> limit;   // 马氏距离项的上限，无法估计时为inf
+    std::vector<int> rank;      // 类别内按得分从高到低的名次
+    std::vector<int> index;     // 在dets中的下标
+    void resize(int n);
+  };
+
+  static bool bounded(const obbBox& box, IouType iouType);
+  void prepare(const obbBoxVec& dets, const int* order, int n,
+               IouType iouType);
+  // 对一个类别的候选框做贪心抑制，保留的框追加到mKeep
+  void suppress(const obbBoxVec& dets, float threshold, IouType iouType,
+                int maxDet);
+  // 用第i个框抑制[begin, end)中得分更低的框
+  void sweep(const obbBoxVec& dets, float threshold, IouType iouType, int i,
+             int begin, int end);
+
+  float mBdLimit = 0;
+  float mRadius = 0;
+  float mMaxRx = 0;
+  int mNumBounded = 0;
+  std::vector<int> mOrder;
+  std::vector<int> mKeep;
+  std::vector<int> mSorted;
+  std::vector<int> mPos;  // 名次对应的Candidates下标
+  std::vector<char> mSuppressed;
+  Candidates mCand;
+};
+
+}  // namespace yolov8
+}  // namespace element
+}  // namespace sophon_stream
+
+#endif  // SOPHON_STREAM_ELEMENT_YOLOV8_ROTATED_NMS_H_
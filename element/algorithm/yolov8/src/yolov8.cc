@@ -85,12 +85,7 @@ common::ErrorCode Yolov8::initContext(const std::string& json) {
       }
     }
 
-    for (auto thresh_it = mContext->thresh_conf.begin();
-         thresh_it != mContext->thresh_conf.end(); ++thresh_it) {
-      mContext->thresh_conf_min = mContext->thresh_conf_min < thresh_it->second
-                                      ? mContext->thresh_conf_min
-                                      : thresh_it->second;
-    }
+    updateThresholds();
 
     auto threshNmsIt = configure.find(CONFIG_INTERNAL_THRESHOLD_NMS_FIELD);
     mContext->thresh_nms = threshNmsIt->get<float>();
@@ -263,8 +258,45 @@ common::ErrorCode Yolov8::initContext(const std::string& json) {
           roi_it->find(CONFIG_INTERNAL_HEIGHT_FILED)->get<int>();
     }
     mContext->thread_number = getThreadNumber();
+
+    // 8. dynamic batch
+    auto batchTimeoutIt = configure.find(CONFIG_INTERNAL_BATCH_TIMEOUT_FIELD);
+    if (configure.end() != batchTimeoutIt && batchTimeoutIt->is_number()) {
+      mContext->batch_timeout_us =
+          static_cast<int>(batchTimeoutIt->get<float>() * 1000);
+    }
+
+    // 9. detection batch
+    auto detectionBatchIt =
+        configure.find(CONFIG_INTERNAL_DETECTION_BATCH_FIELD);
+    if (configure.end() != detectionBatchIt && detectionBatchIt->is_boolean()) {
+      mContext->detection_batch = detectionBatchIt->get<bool>();
+    }
+    if (mContext->class_thresh_valid) {
+      mContext->detection_class_names =
+          std::make_shared<const std::vector<std::string>>(
+              mContext->class_names);
+    }
+
+    // 10. obb nms
+    auto obbNmsIouIt = configure.find(CONFIG_INTERNAL_OBB_NMS_IOU_FIELD);
+    if (configure.end() != obbNmsIouIt) {
+      std::string iouType =
+          obbNmsIouIt->is_string() ? obbNmsIouIt->get<std::string>() : "";
+      if (iouType != "probiou" && iouType != "polygon") {
+        IVS_ERROR("{0} must be \"probiou\" or \"polygon\"",
+                  CONFIG_INTERNAL_OBB_NMS_IOU_FIELD);
+        errorCode = common::ErrorCode::PARSE_CONFIGURE_FAIL;
+        break;
+      }
+      mContext->obb_polygon_iou = iouType == "polygon";
+    }
+    auto obbTopkIt = configure.find(CONFIG_INTERNAL_OBB_PRE_NMS_TOPK_FIELD);
+    if (configure.end() != obbTopkIt && obbTopkIt->is_number_integer()) {
+      mContext->obb_pre_nms_topk = obbTopkIt->get<int>();
+    }
   } while (false);
-  return common::ErrorCode::SUCCESS;
+  return errorCode;
 }
 
 common::ErrorCode Yolov8::initInternal(const std::string& json) {
@@ -308,7 +340,10 @@ common::ErrorCode Yolov8::initInternal(const std::string& json) {
     }
 
     mContext->deviceId = getDeviceId();
-    initContext(configure.dump());
+    errorCode = initContext(configure.dump());
+    if (common::ErrorCode::SUCCESS != errorCode) break;
+    mBatcher.init(mContext->max_batch, mContext->bmNetwork->m_batches,
+                  mContext->batch_timeout_us);
     // 前处理初始化
     mPreProcess->init(mContext);
     // 推理初始化
@@ -320,7 +355,8 @@ common::ErrorCode Yolov8::initInternal(const std::string& json) {
   return errorCode;
 }
 
-void Yolov8::process(common::ObjectMetadatas& objectMetadatas, int dataPipeId) {
+void Yolov8::process(common::ObjectMetadatas& objectMetadatas, int dataPipeId,
+                     int batchSize) {
   common::ErrorCode errorCode = common::ErrorCode::SUCCESS;
   if (use_pre) {
     errorCode = mPreProcess->preProcess(mContext, objectMetadatas);
@@ -333,7 +369,7 @@ void Yolov8::process(common::ObjectMetadatas& objectMetadatas, int dataPipeId) {
   }
   // 推理
   if (use_infer) {
-    errorCode = mInference->predict(mContext, objectMetadatas);
+    errorCode = mInference->predict(mContext, objectMetadatas, batchSize);
     if (common::ErrorCode::SUCCESS != errorCode) {
       for (unsigned i = 0; i < objectMetadatas.size(); i++) {
         objectMetadatas[i]->mErrorCode = errorCode;
@@ -359,37 +395,24 @@ common::ErrorCode Yolov8::doWork(int dataPipeId) {
   }
 
   common::ObjectMetadatas pendingObjectMetadatas;
+  std::vector<framework::Message> controlMessages;
 
-  while (objectMetadatas.size() < mContext->max_batch &&
-         (getThreadStatus() == ThreadStatus::RUN)) {
-    // 如果队列为空则等待
-    auto data = popInputData(inputPort, dataPipeId);
-    if (!data) {
-      std::this_thread::sleep_for(std::chrono::milliseconds(10));
-      continue;
-    }
-
-    auto objectMetadata =
-        std::static_pointer_cast<common::ObjectMetadata>(data);
-    if (!objectMetadata->mFilter) objectMetadatas.push_back(objectMetadata);
-
-    pendingObjectMetadatas.push_back(objectMetadata);
+  int batchSize = mBatcher.collect(
+      [&]() { return popInputMessage(inputPort, dataPipeId); },
+      [&]() { return getThreadStatus() == ThreadStatus::RUN; },
+      objectMetadatas, pendingObjectMetadatas, controlMessages);
 
-    if (objectMetadata->mFrame->mEndOfStream) {
-      break;
-    }
-  }
-
-  process(objectMetadatas, dataPipeId);
+  process(objectMetadatas, dataPipeId, batchSize);
 
   for (auto& objectMetadata : pendingObjectMetadatas) {
     int channel_id_internal = objectMetadata->mFrame->mChannelIdInternal;
     int outDataPipeId =
         getSinkElementFlag()
             ? 0
-            : (channel_id_internal % getOutputConnectorCapacity(outputPort));
-    errorCode = pushOutputData(outputPort, outDataPipeId,
-                               std::static_pointer_cast<void>(objectMetadata));
+            : getOutputDataPipeId(outputPort, channel_id_internal,
+                                  objectMetadata->mFrame->mEndOfStream);
+    errorCode = pushOutputMessage(outputPort, outDataPipeId,
+                                  framework::Message(objectMetadata));
     if (common::ErrorCode::SUCCESS != errorCode) {
       IVS_WARN(
           "Send data fail, element id: {0:d}, output port: {1:d}, data: "
@@ -397,6 +420,9 @@ common::ErrorCode Yolov8::doWork(int dataPipeId) {
           getId(), outputPort, static_cast<void*>(objectMetadata.get()));
     }
   }
+  // 控制消息跟在它之前到达的数据后面
+  for (auto& controlMessage : controlMessages)
+    forwardControlMessage(controlMessage);
   mFpsProfiler.add(objectMetadatas.size());
 
   return common::ErrorCode::SUCCESS;
@@ -416,6 +442,8 @@ void Yolov8::setContext(
     std::shared_ptr<::sophon_stream::element::Context> context) {
   // check
   mContext = std::dynamic_pointer_cast<Yolov8Context>(context);
+  mBatcher.init(mContext->max_batch, mContext->bmNetwork->m_batches,
+                mContext->batch_timeout_us);
 }
 
 void Yolov8::setPreprocess(
@@ -433,6 +461,87 @@ void Yolov8::setPostprocess(
   mPostProcess = std::dynamic_pointer_cast<Yolov8PostProcess>(post);
 }
 
+void Yolov8::registListenFunc(
+    sophon_stream::framework::ListenThread* listener) {
+  std::string mIdStr = std::to_string(getId());
+  std::string handlerName = getNameBatchStatistics + "/" + mIdStr;
+  listener->setHandler(handlerName.c_str(),
+                       sophon_stream::framework::RequestType::GET,
+                       std::bind(&Yolov8::listenerGetBatchStatistics, this,
+                                 std::placeholders::_1, std::placeholders::_2));
+}
+
+common::ErrorCode Yolov8::warmup() {
+  // 模型中编译的每个batch size各推理一次
+  return mContext->bmNetwork->warmup() == 0 ? common::ErrorCode::SUCCESS
+                                            : common::ErrorCode::WARMUP_FAIL;
+}
+
+std::set<std::string> Yolov8::getHotConfigureKeys() const {
+  return {CONFIG_INTERNAL_THRESHOLD_CONF_FIELD,
+          CONFIG_INTERNAL_THRESHOLD_NMS_FIELD};
+}
+
+common::ErrorCode Yolov8::applyConfigure(const nlohmann::json& configure,
+                                         bool check) {
+  float threshConfMin = mContext->thresh_conf_min;
+  auto threshConf = mContext->thresh_conf;
+  float threshNms = mContext->thresh_nms;
+
+  auto threshConfIt = configure.find(CONFIG_INTERNAL_THRESHOLD_CONF_FIELD);
+  if (configure.end() != threshConfIt) {
+    // 与initContext一致：float对应全局阈值，object对应按类别的阈值
+    if (threshConfIt->is_number() && !mContext->class_thresh_valid) {
+      threshConfMin = threshConfIt->get<float>();
+      if (threshConfMin <= 0 || threshConfMin >= 1)
+        return common::ErrorCode::PARSE_CONFIGURE_FAIL;
+    } else if (threshConfIt->is_object() && mContext->class_thresh_valid) {
+      for (auto it = threshConfIt->begin(); it != threshConfIt->end(); ++it) {
+        if (!it->is_number() || threshConf.find(it.key()) == threshConf.end())
+          return common::ErrorCode::PARSE_CONFIGURE_FAIL;
+        float thresh = it->get<float>();
+        if (thresh <= 0 || thresh >= 1)
+          return common::ErrorCode::PARSE_CONFIGURE_FAIL;
+        threshConf[it.key()] = thresh;
+      }
+    } else {
+      return common::ErrorCode::PARSE_CONFIGURE_FAIL;
+    }
+  }
+
+  auto threshNmsIt = configure.find(CONFIG_INTERNAL_THRESHOLD_NMS_FIELD);
+  if (configure.end() != threshNmsIt) {
+    if (!threshNmsIt->is_number())
+      return common::ErrorCode::PARSE_CONFIGURE_FAIL;
+    threshNms = threshNmsIt->get<float>();
+    if (threshNms <= 0 || threshNms > 1)
+      return common::ErrorCode::PARSE_CONFIGURE_FAIL;
+  }
+
+  if (check) return common::ErrorCode::SUCCESS;
+
+  mContext->thresh_conf = threshConf;
+  mContext->thresh_conf_min = threshConfMin;
+  mContext->thresh_nms = threshNms;
+  updateThresholds();
+  return common::ErrorCode::SUCCESS;
+}
+
+void Yolov8::updateThresholds() {
+  if (!mContext->class_thresh_valid || mContext->thresh_conf.empty()) return;
+  float threshConfMin = mContext->thresh_conf.begin()->second;
+  for (auto& it : mContext->thresh_conf)
+    threshConfMin = std::min(threshConfMin, it.second);
+  mContext->thresh_conf_min = threshConfMin;
+}
+
+void Yolov8::listenerGetBatchStatistics(const httplib::Request& request,
+                                        httplib::Response& response) {
+  nlohmann::json json_res = mBatcher.getStatistics();
+  response.set_content(json_res.dump(), "application/json");
+  return;
+}
+
 REGISTER_WORKER("yolov8", Yolov8)
 REGISTER_GROUP_WORKER("yolov8_group", sophon_stream::framework::Group<Yolov8>,
                       Yolov8)
@@ -19,22 +19,25 @@ void Yolov8Inference::init(std::shared_ptr<Yolov8Context> context) {}
 
 common::ErrorCode Yolov8Inference::predict(
     std::shared_ptr<Yolov8Context> context,
-    common::ObjectMetadatas& objectMetadatas) {
+    common::ObjectMetadatas& objectMetadatas, int batchSize) {
   if (objectMetadatas.size() == 0) return common::ErrorCode::SUCCESS;
 
-  if (context->max_batch > 1) {
-    auto inputTensors = mergeInputDeviceMem(context, objectMetadatas);
-    auto outputTensors = getOutputDeviceMem(context);
+  if (batchSize <= 0) batchSize = context->max_batch;
+  if (batchSize > 1) {
+    auto inputTensors =
+        mergeInputDeviceMem(context, objectMetadatas, batchSize);
+    auto outputTensors = getOutputDeviceMem(context, batchSize);
 
     int ret = 0;
     ret = context->bmNetwork->forward(inputTensors->tensors,
                                       outputTensors->tensors);
 
-    splitOutputMemIntoObjectMetadatas(context, objectMetadatas, outputTensors);
+    splitOutputMemIntoObjectMetadatas(context, objectMetadatas, outputTensors,
+                                      batchSize);
   } else {
     if (objectMetadatas[0]->mFrame->mEndOfStream)
       return common::ErrorCode::SUCCESS;
-    objectMetadatas[0]->mOutputBMtensors = getOutputDeviceMem(context);
+    objectMetadatas[0]->mOutputBMtensors = getOutputDeviceMem(context, 1);
     int ret = context->bmNetwork->forward(
         objectMetadatas[0]->mInputBMtensors->tensors,
         objectMetadatas[0]->mOutputBMtensors->tensors);
@@ -10,6 +10,8 @@
 
 #include "yolov8_post_process.h"
 
+#include <cstring>
+
 namespace sophon_stream {
 namespace element {
 namespace yolov8 {
@@ -420,36 +422,11 @@ void Yolov8PostProcess::postProcessDetOpt(
       float width = (yolobox_vec[i].x2 - yolobox_vec[i].x1) / ratio;
       float height = (yolobox_vec[i].y2 - yolobox_vec[i].y1) / ratio;
 
-      std::shared_ptr<common::DetectedObjectMetadata> detData =
-          std::make_shared<common::DetectedObjectMetadata>();
-      detData->mBox.mX = std::max(int(centerx - width / 2), 0);
-      detData->mBox.mY = std::max(int(centery - height / 2), 0);
-      detData->mBox.mWidth = width;
-      detData->mBox.mHeight = height;
-      detData->mScores.push_back(yolobox_vec[i].score);
-      detData->mClassify = yolobox_vec[i].class_id;
-
-      if (context->roi_predefined) {
-        detData->mBox.mX += context->roi.start_x;
-        detData->mBox.mY += context->roi.start_y;
-      }
-
-      // check the range of box
-      if (detData->mBox.mX + detData->mBox.mWidth >=
-          obj->mFrame->mSpData->width) {
-        detData->mBox.mWidth =
-            (obj->mFrame->mSpData->width - 1 - detData->mBox.mX);
-      }
-      if (detData->mBox.mY + detData->mBox.mHeight >=
-          obj->mFrame->mSpData->height) {
-        detData->mBox.mHeight =
-            (obj->mFrame->mSpData->height - 1 - detData->mBox.mY);
-      }
-
-      if (context->class_thresh_valid) {
-        detData->mLabelName = context->class_names[detData->mClassify];
-      }
-      obj->mDetectedObjectMetadatas.push_back(detData);
+      addDetection(context, *obj,
+                   common::Rectangle<int>(
+                       std::max(int(centerx - width / 2), 0),
+                       std::max(int(centery - height / 2), 0), width, height),
+                   yolobox_vec[i].score, yolobox_vec[i].class_id);
     }
     ++idx;
   }
@@ -607,39 +584,56 @@ void Yolov8PostProcess::postProcessDet(
     clip_boxes(yolobox_vec, frame_width, frame_height);
 
     for (auto bbox : yolobox_vec) {
-      std::shared_ptr<common::DetectedObjectMetadata> detData =
-          std::make_shared<common::DetectedObjectMetadata>();
-      detData->mBox.mX = std::max(int(bbox.x1), 0);
-      detData->mBox.mY = std::max(int(bbox.y1), 0);
-      detData->mBox.mWidth = bbox.x2 - bbox.x1;
-      detData->mBox.mHeight = bbox.y2 - bbox.y1;
-      detData->mScores.push_back(bbox.score);
-      detData->mClassify = bbox.class_id;
-
-      if (context->roi_predefined) {
-        detData->mBox.mX += context->roi.start_x;
-        detData->mBox.mY += context->roi.start_y;
-      }
-      // check the range of box
-      if (detData->mBox.mX + detData->mBox.mWidth >=
-          obj->mFrame->mSpData->width) {
-        detData->mBox.mWidth =
-            (obj->mFrame->mSpData->width - 1 - detData->mBox.mX);
-      }
-      if (detData->mBox.mY + detData->mBox.mHeight >=
-          obj->mFrame->mSpData->height) {
-        detData->mBox.mHeight =
-            (obj->mFrame->mSpData->height - 1 - detData->mBox.mY);
-      }
-      if (context->class_thresh_valid) {
-        detData->mLabelName = context->class_names[detData->mClassify];
-      }
-      obj->mDetectedObjectMetadatas.push_back(detData);
+      addDetection(context, *obj,
+                   common::Rectangle<int>(std::max(int(bbox.x1), 0),
+                                          std::max(int(bbox.y1), 0),
+                                          bbox.x2 - bbox.x1, bbox.y2 - bbox.y1),
+                   bbox.score, bbox.class_id);
     }
     ++idx;
   }
 }
 
+void Yolov8PostProcess::addDetection(
+    const std::shared_ptr<Yolov8Context>& context,
+    common::ObjectMetadata& objectMetadata, common::Rectangle<int> box,
+    float score, int classId) {
+  if (context->roi_predefined) {
+    box.mX += context->roi.start_x;
+    box.mY += context->roi.start_y;
+  }
+  // check the range of box
+  int frameWidth = objectMetadata.mFrame->mSpData->width;
+  int frameHeight = objectMetadata.mFrame->mSpData->height;
+  if (box.mX + box.mWidth >= frameWidth) box.mWidth = frameWidth - 1 - box.mX;
+  if (box.mY + box.mHeight >= frameHeight)
+    box.mHeight = frameHeight - 1 - box.mY;
+
+  // 上游已经产生了DetectedObjectMetadata时继续追加到vector，保持结果在同一处
+  if (context->detection_batch &&
+      objectMetadata.mDetectedObjectMetadatas.empty()) {
+    if (!objectMetadata.mDetectionBatch) {
+      objectMetadata.mDetectionBatch =
+          std::make_shared<common::DetectionBatch>();
+      objectMetadata.mDetectionBatch->mClassNames =
+          context->detection_class_names;
+    }
+    objectMetadata.mDetectionBatch->push_back(box.mX, box.mY, box.mWidth,
+                                              box.mHeight, score, classId);
+    return;
+  }
+
+  std::shared_ptr<common::DetectedObjectMetadata> detData =
+      std::make_shared<common::DetectedObjectMetadata>();
+  detData->mBox = box;
+  detData->mScores.push_back(score);
+  detData->mClassify = classId;
+  if (context->class_thresh_valid) {
+    detData->mLabelName = context->class_names[classId];
+  }
+  objectMetadata.mDetectedObjectMetadatas.push_back(detData);
+}
+
 void Yolov8PostProcess::postProcessSeg(
     std::shared_ptr<Yolov8Context> context,
     common::ObjectMetadatas& objectMetadatas) {
@@ -770,10 +764,7 @@ void Yolov8PostProcess::postProcessSeg(
         box.x2 = box.x1 + width;
         box.y2 = box.y1 + height;
 
-        for (int k = 0; k < mask_len; k++) {
-          box.mask.emplace_back(
-              detection_data[i + (per_feat_size - mask_len + k) * feat_num]);
-        }
+        box.index = i;
 
         yolobox_vec.push_back(box);
       }
@@ -810,25 +801,34 @@ void Yolov8PostProcess::postProcessSeg(
 
     clip_boxes(yolobox_vec, frame_width, frame_height);
 
+    // 只为NMS后保留下来的框取mask系数
+    for (auto& box : yolobox_vec) {
+      box.mask.resize(mask_len);
+      for (int k = 0; k < mask_len; k++)
+        box.mask[k] =
+            detection_data[box.index + (per_feat_size - mask_len + k) * feat_num];
+    }
+
     // post 4: get mask
     YoloV8BoxVec yolobox_vec_final;
 
-    if (context->seg_tpu_opt) {
-      cv::Vec4f trans = para.trans;
-      int r_x =
-          floor(trans[2] / context->net_w * segmentation_out_shape->dims[3]);
-      int r_y =
-          floor(trans[3] / context->net_h * segmentation_out_shape->dims[2]);
+    // 原型网格中去掉letterbox填充、对应整幅图像的区域
+    int proto_h = segmentation_out_shape->dims[2];
+    int proto_w = segmentation_out_shape->dims[3];
+    cv::Vec4f trans = para.trans;
+    int r_x = floor(trans[2] / context->net_w * proto_w);
+    int r_y = floor(trans[3] / context->net_h * proto_h);
 
-      int r_w = segmentation_out_shape->dims[3] - 2 * r_x;
-      int r_h = segmentation_out_shape->dims[2] - 2 * r_y;
+    int r_w = proto_w - 2 * r_x;
+    int r_h = proto_h - 2 * r_y;
 
-      r_w = MAX(r_w, 1);
-      r_h = MAX(r_h, 1);
+    r_w = MAX(r_w, 1);
+    r_h = MAX(r_h, 1);
 
-      struct Paras paras = {
-          r_x, r_y, r_w, r_h, para.raw_size.width, para.raw_size.height};
+    struct Paras paras = {
+        r_x, r_y, r_w, r_h, para.raw_size.width, para.raw_size.height};
 
+    if (context->seg_tpu_opt) {
       YoloV8BoxVec yolobox_valid_vec;
       for (int i = 0; i < yolobox_vec.size(); i++) {
         if (yolobox_vec[i].x2 > yolobox_vec[i].x1 + 1 &&
@@ -867,21 +867,15 @@ void Yolov8PostProcess::postProcessSeg(
 
       bm_free_device(context->tpu_mask_handle, segmentation_tensor.device_mem);
     } else {
-      int dims = 4;
-      int sizes[] = {
-          segmentation_out_shape->dims[0], segmentation_out_shape->dims[1],
-          segmentation_out_shape->dims[2], segmentation_out_shape->dims[3]};
-      cv::Mat segmentation_out_data(dims, sizes, CV_32F, segmentation_data);
-
       for (int i = 0; i < yolobox_vec.size(); i++) {
         if (yolobox_vec[i].x2 > yolobox_vec[i].x1 + 1 &&
             yolobox_vec[i].y2 > yolobox_vec[i].y1 + 1) {
-          get_mask(context, cv::Mat(yolobox_vec[i].mask).t(),
-                   segmentation_out_data, para,
+          get_mask(yolobox_vec[i].mask.data(), segmentation_data, mask_len,
+                   proto_w, proto_h, paras,
                    cv::Rect{yolobox_vec[i].x1, yolobox_vec[i].y1,
                             yolobox_vec[i].x2 - yolobox_vec[i].x1,
                             yolobox_vec[i].y2 - yolobox_vec[i].y1},
-                   yolobox_vec[i].mask_img);
+                   context->thresh_nms, yolobox_vec[i].seg_mask);
 
           yolobox_vec_final.emplace_back(yolobox_vec[i]);
         }
@@ -889,7 +883,7 @@ void Yolov8PostProcess::postProcessSeg(
     }
 
     // 5. get final results
-    for (auto bbox : yolobox_vec_final) {
+    for (auto& bbox : yolobox_vec_final) {
       std::shared_ptr<common::SegmentedObjectMetadata> segData =
           std::make_shared<common::SegmentedObjectMetadata>();
 
@@ -899,7 +893,7 @@ void Yolov8PostProcess::postProcessSeg(
       segData->mBox.mHeight = bbox.y2 - bbox.y1;
       segData->mScores.push_back(bbox.score);
       segData->mClassify = bbox.class_id;
-      segData->mask_img = bbox.mask_img;
+      segData->mMask = std::move(bbox.seg_mask);
 
       if (context->roi_predefined) {
         segData->mBox.mX += context->roi.start_x;
@@ -987,58 +981,46 @@ void Yolov8PostProcess::getmask_tpu(std::shared_ptr<Yolov8Context> context,
   // 4. crop + mask
   for (int i = 0; i < actual_mask_num; i++) {
     int yi = start + i;
-    cv::Mat temp_mask(mask_height, mask_width, CV_32FC1,
-                      output0 + i * mask_height * mask_width);
-    cv::Mat masks_feature =
-        temp_mask(cv::Rect(paras.r_x, paras.r_y, paras.r_w, paras.r_h));
-    cv::Mat mask;
-    cv::resize(masks_feature, mask, cv::Size(paras.width, paras.height));
-
-    // crop + mask
+    // 只保留目标框覆盖的原型网格区域，插值到图像分辨率推迟到使用时
     cv::Rect bound = cv::Rect{yolov8box_input[yi].x1, yolov8box_input[yi].y1,
                               yolov8box_input[yi].x2 - yolov8box_input[yi].x1,
                               yolov8box_input[yi].y2 - yolov8box_input[yi].y1};
-    yolov8box_input[yi].mask_img = mask(bound) > confThreshold;
+    common::SegmentMask& seg_mask = yolov8box_input[yi].seg_mask;
+    cv::Rect roi =
+        seg_mask.reset(paras.r_w, paras.r_h,
+                       cv::Size(paras.width, paras.height), bound, confThreshold);
+    const float* src = output0 + i * mask_height * mask_width +
+                       (paras.r_y + roi.y) * mask_width + paras.r_x + roi.x;
+    for (int y = 0; y < roi.height; y++)
+      memcpy(seg_mask.data() + y * roi.width, src + y * mask_width,
+             roi.width * sizeof(float));
     yolov8box_output.push_back(yolov8box_input[yi]);
   }
 }
 
-void Yolov8PostProcess::get_mask(std::shared_ptr<Yolov8Context> context,
-                                 const cv::Mat& mask_info,
-                                 const cv::Mat& mask_data,
-                                 const ImageInfo& para, cv::Rect bound,
-                                 cv::Mat& mask_out) {
-  // r r tx1 ty1
-  cv::Vec4f trans = para.trans;
-
-  int r_x = floor(trans[2] / context->net_w * (context->net_w / 4));
-  int r_y = floor(trans[3] / context->net_h * (context->net_h / 4));
-
-  int r_w = (context->net_w / 4) - 2 * r_x;
-  int r_h = (context->net_h / 4) - 2 * r_y;
-
-  r_w = MAX(r_w, 1);
-  r_h = MAX(r_h, 1);
-
-  std::vector<cv::Range> roi_rangs = {cv::Range(0, 1), cv::Range::all(),
-                                      cv::Range(r_y, r_h + r_y),
-                                      cv::Range(r_x, r_w + r_x)};
-
-  cv::Mat temp_mask = mask_data(roi_rangs).clone();  // crop
-  cv::Mat protos = temp_mask.reshape(0, {32, r_w * r_h});
-
-  cv::Mat matmul_res = (mask_info * protos);
-  cv::Mat masks_feature = matmul_res.reshape(1, {r_h, r_w});
-
-  int left = bound.x;
-  int top = bound.y;
-  int width = bound.width;
-  int height = bound.height;
-
-  cv::Mat mask;
-  resize(masks_feature, mask,
-         cv::Size(para.raw_size.width, para.raw_size.height));
-  mask_out = mask(bound) > context->thresh_nms;
+void Yolov8PostProcess::get_mask(const float* mask_info, const float* protos,
+                                 int mask_len, int proto_w, int proto_h,
+                                 const Paras& paras, cv::Rect bound,
+                                 float threshold,
+                                 common::SegmentMask& mask_out) {
+  cv::Rect roi = mask_out.reset(paras.r_w, paras.r_h,
+                                cv::Size(paras.width, paras.height), bound,
+                                threshold);
+  if (roi.empty()) return;
+
+  // logits = mask_info * protos，只在目标框覆盖的原型网格区域内计算
+  float* logits = mask_out.data();
+  int plane = proto_w * proto_h;
+  for (int k = 0; k < mask_len; k++) {
+    const float coef = mask_info[k];
+    const float* proto = protos + k * plane +
+                         (paras.r_y + roi.y) * proto_w + paras.r_x + roi.x;
+    for (int y = 0; y < roi.height; y++) {
+      const float* src = proto + y * proto_w;
+      float* dst = logits + y * roi.width;
+      for (int x = 0; x < roi.width; x++) dst[x] += coef * src[x];
+    }
+  }
 }
 
 void Yolov8PostProcess::postProcessObb(
@@ -1046,6 +1028,7 @@ void Yolov8PostProcess::postProcessObb(
     common::ObjectMetadatas& objectMetadatas) {
   // Yolov8 obb vec
   obbBoxVec yolobox_vec;
+  RotatedNms rotatedNms;
 
   int idx = 0;
   for (auto obj : objectMetadatas) {
@@ -1108,8 +1091,6 @@ void Yolov8PostProcess::postProcessObb(
     int m_class_num = out_tensor->get_shape()->dims[2] - mask_num - 5;
     int feature_num = out_tensor->get_shape()->dims[1];  // 8400
     int nout = m_class_num + mask_num + 5;
-    int max_wh = 7680;  // (pixels) maximum box width and height
-    bool agnostic = false;
 
     float* output_data = nullptr;
     std::vector<float> decoded_data;
@@ -1129,6 +1110,7 @@ void Yolov8PostProcess::postProcessObb(
         (float*)out_tensor->get_cpu_data();  // 如果只有一张图片不要需修改
 
     // Candidates
+    yolobox_vec.clear();
     float* cls_conf = output_data + 4; //output_tensor's last dim: [x, y, w, h, cls_conf0, ..., cls_conf14, rotate_angle]
     for (int i = 0; i < box_num; i++) {
       // multilabel
@@ -1142,9 +1124,8 @@ void Yolov8PostProcess::postProcessObb(
           obbBox box;
           box.score = cur_conf;
           box.class_id = j;
-          int c = agnostic ? 0 : box.class_id * max_wh;
-          box.x = output_data[i * nout + 0] + c;
-          box.y = output_data[i * nout + 1] + c;
+          box.x = output_data[i * nout + 0];
+          box.y = output_data[i * nout + 1];
           box.w = output_data[i * nout + 2];
           box.h = output_data[i * nout + 3];
           box.angle = output_data[(i + 1) * nout - 1];
@@ -1152,17 +1133,11 @@ void Yolov8PostProcess::postProcessObb(
         }
       }
     }
-    nms_rotated(yolobox_vec, context->thresh_nms);
-    if (yolobox_vec.size() > max_det) {
-        yolobox_vec.erase(yolobox_vec.begin(), yolobox_vec.begin() + (yolobox_vec.size() - max_det));
-    }
-    if(!agnostic){
-        for (int i = 0; i < yolobox_vec.size(); i++) {
-            int c = yolobox_vec[i].class_id * max_wh;
-            yolobox_vec[i].x = yolobox_vec[i].x - c;
-            yolobox_vec[i].y = yolobox_vec[i].y - c;
-        }
-    }
+    // 按类别分组做NMS，结果按得分从低到高，最多max_det个
+    rotatedNms.run(yolobox_vec, context->thresh_nms,
+                   context->obb_polygon_iou ? RotatedNms::IouType::Polygon
+                                            : RotatedNms::IouType::ProbIou,
+                   max_det, context->obb_pre_nms_topk);
     regularize_rbox(yolobox_vec);
     float inv_ratio = 1.0 / ratio;
     for (int i = 0; i < yolobox_vec.size(); i++) {
@@ -1199,58 +1174,6 @@ void Yolov8PostProcess::regularize_rbox(obbBoxVec& obbVec){
   }
 }
 
-std::tuple<float, float, float> Yolov8PostProcess::convariance_matrix(const obbBox& obb){
-  float w = obb.w;
-  float h = obb.h;
-  float r = obb.angle;
-  float a = w * w / 12.0;
-  float b = h * h / 12.0;
-  float cos_r = std::cos(r);
-  float sin_r = std::sin(r);
-  float a_val = a * cos_r * cos_r + b * sin_r * sin_r;
-  float b_val = a * sin_r * sin_r + b * cos_r * cos_r;
-  float c_val = (a - b) * cos_r * sin_r;
-  return std::make_tuple(a_val, b_val, c_val);
-}
-
-float Yolov8PostProcess::probiou(const obbBox& obb1, const obbBox& obb2, float eps){
-  // Calculate the prob iou between oriented bounding boxes, https://arxiv.org/pdf/2106.06072v1.pdf.
-  float a1, b1, c1, a2, b2, c2;
-  std::tie(a1, b1, c1) = convariance_matrix(obb1);
-  std::tie(a2, b2, c2) = convariance_matrix(obb2);
-  float x1 = obb1.x, y1 = obb1.y;
-  float x2 = obb2.x, y2 = obb2.y;
-  float t1 = ((a1 + a2) * std::pow(y1 - y2, 2) + (b1 + b2) * std::pow(x1 - x2, 2)) / ((a1 + a2) * (b1 + b2) - std::pow(c1 + c2, 2) + eps);
-  float t2 = ((c1 + c2) * (x2 - x1) * (y1 - y2)) / ((a1 + a2) * (b1 + b2) - std::pow(c1 + c2, 2) + eps);
-  float t3 = std::log(((a1 + a2) * (b1 + b2) - std::pow(c1 + c2, 2)) / (4 * std::sqrt(std::max(a1 * b1 - c1 * c1, 0.0f)) * std::sqrt(std::max(a2 * b2 - c2 * c2, 0.0f)) + eps) + eps);
-  float bd = 0.25 * t1 + 0.5 * t2 + 0.5 * t3;
-  bd = std::max(std::min(bd, 100.0f), eps);
-  float hd = std::sqrt(1.0 - std::exp(-bd) + eps);
-  return 1 - hd;
-}
-
-
-void Yolov8PostProcess::nms_rotated(obbBoxVec& dets, float nmsConfidence) {
-    int length = dets.size();
-    int index = length - 1;
-
-    std::sort(dets.begin(), dets.end(), [](const obbBox& a, const obbBox& b) { return a.score < b.score; });
-
-    while (index > 0) {
-        int i = 0;
-        while (i < index) {
-            float iou = probiou(dets[index], dets[i]);
-            if (iou >= nmsConfidence) {
-                dets.erase(dets.begin() + i);
-                index--;
-            } else {
-                i++;
-            }
-        }
-        index--;
-    }
-}
-
 common::ObbObjectMetadata Yolov8PostProcess::xywhr2xyxyxyxy(const obbBox& obb){
   common::ObbObjectMetadata obb_;
   float cos_value = std::cos(obb.angle);
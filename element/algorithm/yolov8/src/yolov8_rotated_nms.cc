@@ -0,0 +1,349 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#include "yolov8_rotated_nms.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <tuple>
+
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace sophon_stream {
+namespace element {
+namespace yolov8 {
+
+namespace {
+
+constexpr float kInf = std::numeric_limits<float>::infinity();
+
+std::tuple<float, float, float> covarianceMatrix(const obbBox& obb) {
+  float w = obb.w;
+  float h = obb.h;
+  float r = obb.angle;
+  float a = w * w / 12.0;
+  float b = h * h / 12.0;
+  float cos_r = std::cos(r);
+  float sin_r = std::sin(r);
+  float a_val = a * cos_r * cos_r + b * sin_r * sin_r;
+  float b_val = a * sin_r * sin_r + b * cos_r * cos_r;
+  float c_val = (a - b) * cos_r * sin_r;
+  return std::make_tuple(a_val, b_val, c_val);
+}
+
+// 逆时针顺序的4个角点
+void rectCorners(const obbBox& obb, double* pts) {
+  double cos_r = std::cos((double)obb.angle);
+  double sin_r = std::sin((double)obb.angle);
+  double ux = std::fabs(obb.w) / 2 * cos_r, uy = std::fabs(obb.w) / 2 * sin_r;
+  double vx = -std::fabs(obb.h) / 2 * sin_r, vy = std::fabs(obb.h) / 2 * cos_r;
+  const double sx[4] = {1, -1, -1, 1};
+  const double sy[4] = {1, 1, -1, -1};
+  for (int k = 0; k < 4; ++k) {
+    pts[2 * k] = obb.x + sx[k] * ux + sy[k] * vx;
+    pts[2 * k + 1] = obb.y + sx[k] * uy + sy[k] * vy;
+  }
+}
+
+}  // namespace
+
+void RotatedNms::Candidates::resize(int n) {
+  x.resize(n);
+  y.resize(n);
+  rx.resize(n);
+  ry.resize(n);
+  a.resize(n);
+  b.resize(n);
+  limit.resize(n);
+  rank.resize(n);
+  index.resize(n);
+}
+
+float RotatedNms::probiou(const obbBox& obb1, const obbBox& obb2, float eps) {
+  float a1, b1, c1, a2, b2, c2;
+  std::tie(a1, b1, c1) = covarianceMatrix(obb1);
+  std::tie(a2, b2, c2) = covarianceMatrix(obb2);
+  float x1 = obb1.x, y1 = obb1.y;
+  float x2 = obb2.x, y2 = obb2.y;
+  float t1 = ((a1 + a2) * std::pow(y1 - y2, 2) + (b1 + b2) * std::pow(x1 - x2, 2)) / ((a1 + a2) * (b1 + b2) - std::pow(c1 + c2, 2) + eps);
+  float t2 = ((c1 + c2) * (x2 - x1) * (y1 - y2)) / ((a1 + a2) * (b1 + b2) - std::pow(c1 + c2, 2) + eps);
+  float t3 = std::log(((a1 + a2) * (b1 + b2) - std::pow(c1 + c2, 2)) / (4 * std::sqrt(std::max(a1 * b1 - c1 * c1, 0.0f)) * std::sqrt(std::max(a2 * b2 - c2 * c2, 0.0f)) + eps) + eps);
+  float bd = 0.25 * t1 + 0.5 * t2 + 0.5 * t3;
+  bd = std::max(std::min(bd, 100.0f), eps);
+  float hd = std::sqrt(1.0 - std::exp(-bd) + eps);
+  return 1 - hd;
+}
+
+float RotatedNms::polygonIou(const obbBox& obb1, const obbBox& obb2) {
+  double clip[4 * 2];
+  double buf[2][16 * 2];
+  rectCorners(obb2, clip);
+  rectCorners(obb1, buf[0]);
+  int n = 4;
+  int cur = 0;
+  // Sutherland-Hodgman：依次用obb2的4条边裁剪obb1
+  for (int e = 0; e < 4 && n > 0; ++e) {
+    const double* e0 = clip + 2 * e;
+    const double* e1 = clip + 2 * ((e + 1) % 4);
+    double ex = e1[0] - e0[0], ey = e1[1] - e0[1];
+    const double* in = buf[cur];
+    double* out = buf[1 - cur];
+    int m = 0;
+    for (int k = 0; k < n; ++k) {
+      const double* p = in + 2 * k;
+      const double* q = in + 2 * ((k + n - 1) % n);
+      double dp = ex * (p[1] - e0[1]) - ey * (p[0] - e0[0]);
+      double dq = ex * (q[1] - e0[1]) - ey * (q[0] - e0[0]);
+      if ((dp >= 0) != (dq >= 0)) {
+        double t = dq / (dq - dp);
+        out[2 * m] = q[0] + t * (p[0] - q[0]);
+        out[2 * m + 1] = q[1] + t * (p[1] - q[1]);
+        ++m;
+      }
+      if (dp >= 0) {
+        out[2 * m] = p[0];
+        out[2 * m + 1] = p[1];
+        ++m;
+      }
+    }
+    n = m;
+    cur = 1 - cur;
+  }
+
+  double inter = 0;
+  for (int k = 0; k < n; ++k) {
+    const double* p = buf[cur] + 2 * k;
+    const double* q = buf[cur] + 2 * ((k + 1) % n);
+    inter += p[0] * q[1] - q[0] * p[1];
+  }
+  inter = std::fabs(inter) / 2;
+  double area1 = std::fabs((double)obb1.w * obb1.h);
+  double area2 = std::fabs((double)obb2.w * obb2.h);
+  double uni = area1 + area2 - inter;
+  if (!(uni > 0)) return 0;
+  return inter / uni;
+}
+
+bool RotatedNms::bounded(const obbBox& box, IouType iouType) {
+  if (!std::isfinite(box.x) || !std::isfinite(box.y) ||
+      !std::isfinite(box.angle))
+    return false;
+  if (iouType == IouType::Polygon)
+    return std::isfinite(box.w) && std::isfinite(box.h);
+  // 面积过小或过于细长的框，probiou中的eps和舍入误差相对较大，不做提前排除
+  float lo = std::min(box.w, box.h), hi = std::max(box.w, box.h);
+  return box.w * box.h >= 1 && hi <= 100 * lo;
+}
+
+void RotatedNms::prepare(const obbBoxVec& dets, const int* order, int n,
+                         IouType iouType) {
+  // 可以提前排除的框按x排序放在前面，其余的放在后面
+  mSorted.clear();
+  for (int r = 0; r < n; ++r)
+    if (bounded(dets[order[r]], iouType)) mSorted.push_back(r);
+  mNumBounded = mSorted.size();
+  std::sort(mSorted.begin(), mSorted.end(), [&](int l, int r) {
+    float xl = dets[order[l]].x, xr = dets[order[r]].x;
+    return xl != xr ? xl < xr : l < r;
+  });
+  for (int r = 0; r < n; ++r)
+    if (!bounded(dets[order[r]], iouType)) mSorted.push_back(r);
+
+  mCand.resize(n);
+  mPos.resize(n);
+  mMaxRx = 0;
+  for (int k = 0; k < n; ++k) {
+    int r = mSorted[k];
+    const obbBox& box = dets[order[r]];
+    mPos[r] = k;
+    mCand.rank[k] = r;
+    mCand.index[k] = order[r];
+    mCand.x[k] = box.x;
+    mCand.y[k] = box.y;
+    if (k >= mNumBounded) {
+      mCand.rx[k] = mCand.ry[k] = kInf;
+      mCand.a[k] = mCand.b[k] = 1;
+      mCand.limit[k] = kInf;
+      continue;
+    }
+    if (iouType == IouType::Polygon) {
+      // 外接矩形不相交时交集为0，放大一点抵消角点计算的舍入误差
+      float cos_r = std::fabs(std::cos(box.angle));
+      float sin_r = std::fabs(std::sin(box.angle));
+      float hw = std::fabs(box.w) / 2, hh = std::fabs(box.h) / 2;
+      mCand.rx[k] = (hw * cos_r + hh * sin_r) * 1.0001f + 1e-3f;
+      mCand.ry[k] = (hw * sin_r + hh * cos_r) * 1.0001f + 1e-3f;
+      mCand.a[k] = mCand.b[k] = 1;
+      mCand.limit[k] = kInf;
+    } else {
+      float a, b, c;
+      std::tie(a, b, c) = covarianceMatrix(box);
+      mCand.rx[k] = mRadius * std::sqrt(a);
+      mCand.ry[k] = mRadius * std::sqrt(b);
+      mCand.a[k] = a;
+      mCand.b[k] = b;
+      mCand.limit[k] = mBdLimit;
+    }
+    mMaxRx = std::max(mMaxRx, mCand.rx[k]);
+  }
+}
+
+void RotatedNms::sweep(const obbBoxVec& dets, float threshold,
+                       IouType iouType, int i, int begin, int end) {
+  const obbBox& obb1 = dets[mCand.index[i]];
+  int ri = mCand.rank[i];
+  auto test = [&](int j) {
+    int rj = mCand.rank[j];
+    if (rj <= ri || mSuppressed[rj]) return;
+    const obbBox& obb2 = dets[mCand.index[j]];
+    float iou = iouType == IouType::Polygon ? polygonIou(obb1, obb2)
+                                            : probiou(obb1, obb2);
+    if (iou >= threshold) mSuppressed[rj] = 1;
+  };
+
+  float xi = mCand.x[i], yi = mCand.y[i];
+  float rxi = mCand.rx[i], ryi = mCand.ry[i];
+  float ai = mCand.a[i], bi = mCand.b[i], limi = mCand.limit[i];
+  int j = begin;
+  // 排除条件：外接框在x或y方向分离，或者单个方向上的马氏距离已超过上限。
+  // 任一个数为NaN时比较结果为假，交给完整的IoU计算，与逐对计算的行为一致
+#if defined(__aarch64__) || defined(__SSE2__)
+  for (; j + 4 <= end; j += 4) {
+    int reject;
+#if defined(__aarch64__)
+    float32x4_t quarter = vdupq_n_f32(0.25f);
+    float32x4_t dx = vabdq_f32(vld1q_f32(&mCand.x[j]), vdupq_n_f32(xi));
+    float32x4_t dy = vabdq_f32(vld1q_f32(&mCand.y[j]), vdupq_n_f32(yi));
+    float32x4_t lim = vmaxq_f32(vld1q_f32(&mCand.limit[j]), vdupq_n_f32(limi));
+    float32x4_t mx =
+        vdivq_f32(vmulq_f32(vmulq_f32(dx, dx), quarter),
+                  vaddq_f32(vld1q_f32(&mCand.a[j]), vdupq_n_f32(ai)));
+    float32x4_t my =
+        vdivq_f32(vmulq_f32(vmulq_f32(dy, dy), quarter),
+                  vaddq_f32(vld1q_f32(&mCand.b[j]), vdupq_n_f32(bi)));
+    uint32x4_t r = vorrq_u32(
+        vcgtq_f32(dx, vaddq_f32(vld1q_f32(&mCand.rx[j]), vdupq_n_f32(rxi))),
+        vcgtq_f32(dy, vaddq_f32(vld1q_f32(&mCand.ry[j]), vdupq_n_f32(ryi))));
+    r = vorrq_u32(r, vorrq_u32(vcgtq_f32(mx, lim), vcgtq_f32(my, lim)));
+    reject = (vgetq_lane_u32(r, 0) & 1) | (vgetq_lane_u32(r, 1) & 2) |
+             (vgetq_lane_u32(r, 2) & 4) | (vgetq_lane_u32(r, 3) & 8);
+#else
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    __m128 quarter = _mm_set1_ps(0.25f);
+    __m128 dx = _mm_and_ps(
+        _mm_sub_ps(_mm_loadu_ps(&mCand.x[j]), _mm_set1_ps(xi)), absMask);
+    __m128 dy = _mm_and_ps(
+        _mm_sub_ps(_mm_loadu_ps(&mCand.y[j]), _mm_set1_ps(yi)), absMask);
+    __m128 lim = _mm_max_ps(_mm_loadu_ps(&mCand.limit[j]), _mm_set1_ps(limi));
+    __m128 mx =
+        _mm_div_ps(_mm_mul_ps(_mm_mul_ps(dx, dx), quarter),
+                   _mm_add_ps(_mm_loadu_ps(&mCand.a[j]), _mm_set1_ps(ai)));
+    __m128 my =
+        _mm_div_ps(_mm_mul_ps(_mm_mul_ps(dy, dy), quarter),
+                   _mm_add_ps(_mm_loadu_ps(&mCand.b[j]), _mm_set1_ps(bi)));
+    __m128 r = _mm_or_ps(
+        _mm_cmpgt_ps(dx,
+                     _mm_add_ps(_mm_loadu_ps(&mCand.rx[j]), _mm_set1_ps(rxi))),
+        _mm_cmpgt_ps(dy,
+                     _mm_add_ps(_mm_loadu_ps(&mCand.ry[j]), _mm_set1_ps(ryi))));
+    r = _mm_or_ps(r, _mm_or_ps(_mm_cmpgt_ps(mx, lim), _mm_cmpgt_ps(my, lim)));
+    reject = _mm_movemask_ps(r);
+#endif
+    if (reject == 0xf) continue;
+    for (int l = 0; l < 4; ++l)
+      if (!(reject >> l & 1)) test(j + l);
+  }
+#endif
+  for (; j < end; ++j) {
+    float dx = std::fabs(mCand.x[j] - xi), dy = std::fabs(mCand.y[j] - yi);
+    float lim = std::max(mCand.limit[j], limi);
+    bool reject = dx > mCand.rx[j] + rxi || dy > mCand.ry[j] + ryi ||
+                  dx * dx * 0.25f / (mCand.a[j] + ai) > lim ||
+                  dy * dy * 0.25f / (mCand.b[j] + bi) > lim;
+    if (!reject) test(j);
+  }
+}
+
+void RotatedNms::suppress(const obbBoxVec& dets, float threshold,
+                          IouType iouType, int maxDet) {
+  int n = mCand.index.size();
+  const float* xs = mCand.x.data();
+  mSuppressed.assign(n, 0);
+  int kept = 0;
+  for (int r = 0; r < n; ++r) {
+    if (mSuppressed[r]) continue;
+    int i = mPos[r];
+    mKeep.push_back(mCand.index[i]);
+    if (maxDet > 0 && ++kept >= maxDet) break;
+
+    // 前mNumBounded个框按x有序，只需检查x方向可能相交的一段
+    int begin = 0, end = mNumBounded;
+    if (i < mNumBounded) {
+      float reach = mCand.rx[i] + mMaxRx;
+      begin = std::lower_bound(xs, xs + mNumBounded, mCand.x[i] - reach) - xs;
+      end = std::upper_bound(xs, xs + mNumBounded, mCand.x[i] + reach) - xs;
+    }
+    sweep(dets, threshold, iouType, i, begin, end);
+    sweep(dets, threshold, iouType, i, mNumBounded, n);
+  }
+}
+
+void RotatedNms::run(obbBoxVec& dets, float threshold, IouType iouType,
+                     int maxDet, int preTopk) {
+  int num = dets.size();
+  mOrder.resize(num);
+  for (int i = 0; i < num; ++i) mOrder[i] = i;
+  auto higher = [&dets](int l, int r) {
+    if (dets[l].score != dets[r].score) return dets[l].score > dets[r].score;
+    return l < r;
+  };
+  if (preTopk > 0 && num > preTopk) {
+    std::nth_element(mOrder.begin(), mOrder.begin() + preTopk, mOrder.end(),
+                     higher);
+    mOrder.resize(preTopk);
+  }
+  std::sort(mOrder.begin(), mOrder.end(), [&](int l, int r) {
+    if (dets[l].class_id != dets[r].class_id)
+      return dets[l].class_id < dets[r].class_id;
+    return higher(l, r);
+  });
+
+  // probiou >= threshold 等价于 bd <= -log(1 + eps - (1 - threshold)^2)，
+  // 上限留出余量，覆盖probiou中eps和单精度舍入带来的误差
+  double eps = 1e-7;
+  double bdMax = -std::log(1 + eps - (1.0 - threshold) * (1.0 - threshold));
+  mBdLimit = bdMax * 1.01 + 1e-3;
+  mRadius = 2 * std::sqrt(mBdLimit) * 1.001f;
+
+  mKeep.clear();
+  for (std::size_t begin = 0, end = 0; begin < mOrder.size(); begin = end) {
+    int classId = dets[mOrder[begin]].class_id;
+    end = begin;
+    while (end < mOrder.size() && dets[mOrder[end]].class_id == classId) ++end;
+    prepare(dets, &mOrder[begin], end - begin, iouType);
+    suppress(dets, threshold, iouType, maxDet);
+  }
+
+  std::sort(mKeep.begin(), mKeep.end(), higher);
+  if (maxDet > 0 && (int)mKeep.size() > maxDet) mKeep.resize(maxDet);
+  obbBoxVec result;
+  result.reserve(mKeep.size());
+  for (auto it = mKeep.rbegin(); it != mKeep.rend(); ++it)
+    result.push_back(dets[*it]);
+  dets.swap(result);
+}
+
+}  // namespace yolov8
+}  // namespace element
+}  // namespace sophon_stream
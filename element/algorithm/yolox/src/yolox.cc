@@ -270,7 +270,8 @@ common::ErrorCode Yolox::doWork(int dataPipeId) {
     int outDataPipeId =
         getSinkElementFlag()
             ? 0
-            : (channel_id_internal % getOutputConnectorCapacity(outputPort));
+            : getOutputDataPipeId(outputPort, channel_id_internal,
+                                  objectMetadata->mFrame->mEndOfStream);
     errorCode = pushOutputData(outputPort, outDataPipeId,
                                std::static_pointer_cast<void>(objectMetadata));
     if (common::ErrorCode::SUCCESS != errorCode) {
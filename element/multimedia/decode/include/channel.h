@@ -31,6 +31,10 @@ struct ChannelOperateRequest {
     KEEP,
   };
   enum class SourceType { RTSP, RTMP, VIDEO, IMG_DIR, BASE64, GB28181,CAMERA ,UNKNOWN};
+  enum class DecodeMode {
+    ALL,
+    KEYFRAME,
+  };
   int graphId;
   int channelId;
   int loopNum;
@@ -45,7 +49,29 @@ struct ChannelOperateRequest {
   SampleStrategy sampleStrategy;
   bool roi_predefined = false;
   bmcv_rect_t roi;
-
+  int priority = 0;
+  double targetFps = 0;
+  // 以下只对VIDEO和网络流生效
+  DecodeMode decodeMode = DecodeMode::ALL;
+  // 大于0时每隔samplePeriodMs(按码流时间)输出一帧，不参考的帧不送入解码器
+  double samplePeriodMs = 0;
+  // 大于0时解码后立即缩放到该尺寸，与roi一起设置时先裁剪再缩放
+  int outputWidth = 0;
+  int outputHeight = 0;
+  // 以下只对IMG_DIR生效，见image_prefetcher.h
+  struct ImagePrefetch {
+    bool enabled = false;
+    int depth = 16;  // 最多提前读取的图像数
+    int ioThreads = 2;
+    int decodeThreads = 2;
+    bool shuffle = false;
+    unsigned int seed = 0;
+    int shardIndex = 0;
+    int shardCount = 1;
+    std::string progressFile;  // 为空时不记录进度
+    int checkpointInterval = 1000;
+  };
+  ImagePrefetch imagePrefetch;
 };
 
 struct ChannelOperateResponse {
@@ -13,6 +13,7 @@
 #include <dlfcn.h>
 #include <sys/prctl.h>
 
+#include "decode_scheduler.h"
 #include "decoder.h"
 #include "element_factory.h"
 
@@ -130,6 +131,12 @@ struct ChannelInfo {
   std::shared_ptr<std::mutex> mMtx;
   std::shared_ptr<std::condition_variable> mCv;
   std::shared_ptr<ThreadWrapper> mThreadWrapper;
+  // 由mScheduler的线程解码，此时mThreadWrapper为空
+  bool mPooled = false;
+  int mPriority = 0;
+  double mTargetFps = 0;
+  // 负载过高时下一帧允许送出的时间，用于保证target_fps
+  std::chrono::steady_clock::time_point mNextKeepTime;
 };
 
 class Decode : public ::sophon_stream::framework::Element {
@@ -152,6 +159,27 @@ class Decode : public ::sophon_stream::framework::Element {
   static constexpr const char* JSON_BASE64_PORT = "base64_port";
   static constexpr const char* JSON_SKIP_ELEMENT = "skip_element";
   static constexpr const char* JSON_SAMPLE_STRATEGY = "sample_strategy";
+  static constexpr const char* JSON_PRIORITY = "priority";
+  static constexpr const char* JSON_TARGET_FPS = "target_fps";
+  static constexpr const char* JSON_DECODE_MODE = "decode_mode";
+  static constexpr const char* JSON_SAMPLE_PERIOD_MS = "sample_period_ms";
+  static constexpr const char* JSON_OUTPUT_WIDTH = "output_width";
+  static constexpr const char* JSON_OUTPUT_HEIGHT = "output_height";
+  static constexpr const char* JSON_IMAGE_PREFETCH = "image_prefetch";
+  static constexpr const char* JSON_PREFETCH_DEPTH = "depth";
+  static constexpr const char* JSON_PREFETCH_IO_THREADS = "io_threads";
+  static constexpr const char* JSON_PREFETCH_DECODE_THREADS = "decode_threads";
+  static constexpr const char* JSON_PREFETCH_ORDER = "order";
+  static constexpr const char* JSON_PREFETCH_SEED = "seed";
+  static constexpr const char* JSON_PREFETCH_SHARD_INDEX = "shard_index";
+  static constexpr const char* JSON_PREFETCH_SHARD_COUNT = "shard_count";
+  static constexpr const char* JSON_PREFETCH_PROGRESS_FILE = "progress_file";
+  static constexpr const char* JSON_PREFETCH_CHECKPOINT_INTERVAL =
+      "checkpoint_interval";
+  static constexpr const char* CONFIG_INTERNAL_SHED_WATERMARK_FIELD =
+      "shed_watermark";
+  static constexpr const char* CONFIG_INTERNAL_DECODE_THREADS_FIELD =
+      "decode_threads";
   static constexpr const char* JSON_ROI_FILED = "roi";
   static constexpr const char* JSON_LEFT_FILED = "left";
   static constexpr const char* JSON_TOP_FILED = "top";
@@ -168,6 +196,15 @@ class Decode : public ::sophon_stream::framework::Element {
   // {graphId : 已经释放出来的channelIdInternal}
   static std::unordered_map<int, std::queue<int>> mChannelIdInternalReleasedMap;
 
+  // 当前运行中通道的最高优先级，只有低于它的通道才会被降级
+  std::atomic<int> mMaxPriority{0};
+  // 输出队列占用率超过该值时开始对低优先级通道降级丢帧
+  float mShedWatermark = 0.75;
+  std::atomic<std::int64_t> mShedCount{0};
+
+  // 大于0时VIDEO、IMG_DIR和网络流通道共用mScheduler的线程，不再每路一个线程
+  int mDecodeThreads = 0;
+  DecodeScheduler mScheduler;
 
   void onStart() override;
   void onStop() override;
@@ -177,12 +214,38 @@ class Decode : public ::sophon_stream::framework::Element {
   common::ErrorCode pauseTask(std::shared_ptr<ChannelTask>& channelTask);
   common::ErrorCode resumeTask(std::shared_ptr<ChannelTask>& channelTask);
 
+  /**
+   * @brief BASE64和CAMERA在解码时阻塞等待数据或其它通道，仍然使用独立线程
+   */
+  bool usePool(ChannelOperateRequest::SourceType sourceType) const;
+  /**
+   * @brief 在当前线程初始化解码器，再交给mScheduler，调用时需持有mThreadsPoolMtx
+   */
+  common::ErrorCode startPooledTask(std::shared_ptr<ChannelTask>& channelTask,
+                                    std::shared_ptr<ChannelInfo>& channelInfo);
+  /**
+   * @brief 为新通道分配channelIdInternal，优先复用已释放的
+   */
+  void assignChannelIdInternal(int graphId, int channelId);
+
   common::ErrorCode process(const std::shared_ptr<ChannelTask>& channelTask,
                             const std::shared_ptr<ChannelInfo>& channelInfo);
 
   common::ErrorCode parse_channel_task(
       std::shared_ptr<ChannelTask>& channelTask);
 
+  /**
+   * @brief 根据mThreadsPool更新mMaxPriority，调用时需持有mThreadsPoolMtx
+   */
+  void updateMaxPriority();
+  /**
+   * @brief 判断当前帧是否需要因为负载过高而丢弃
+   * @brief
+   * 输出队列占用率超过mShedWatermark时，低于最高优先级的通道只按target_fps送出
+   */
+  bool shouldShed(const std::shared_ptr<ChannelInfo>& channelInfo,
+                  int outputPort, int dataPipeId);
+
   ::sophon_stream::common::FpsProfiler mFpsProfiler;
 
   bm_handle_t handle_;
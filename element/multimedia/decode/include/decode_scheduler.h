@@ -0,0 +1,109 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SOPHON_STREAM_ELEMENT_MULTIMEDIA_DECODE_DECODE_SCHEDULER_H_
+#define SOPHON_STREAM_ELEMENT_MULTIMEDIA_DECODE_DECODE_SCHEDULER_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#include "common/error_code.h"
+#include "common/no_copyable.h"
+
+namespace sophon_stream {
+namespace element {
+namespace decode {
+
+/**
+ * @brief 用固定数量的线程轮流解码多路通道
+ * @brief
+ * 每个通道记录下一帧的到期时间，线程总是取出最早到期的通道解码一帧，再按帧间隔计算下一次到期时间。
+ * 没有到期的通道时线程等待到最早的到期时间，而不是每路各自sleep。同一通道同一时间只在一个线程上解码，
+ * 帧的顺序不变；落后超过一帧间隔的通道从当前时间重新计时，不会连续补帧挤占其它通道
+ */
+class DecodeScheduler : public ::sophon_stream::common::NoCopyable {
+ public:
+  enum class StepResult {
+    FRAME,      // 解码了一帧，按帧间隔调度下一帧
+    NOT_READY,  // 网络流暂时没有数据，稍后重试
+    END,        // 通道结束，不再调度
+  };
+  using StepHandler = std::function<StepResult(void)>;
+
+  DecodeScheduler() {}
+  ~DecodeScheduler() { stop(); }
+
+  common::ErrorCode start(int threadNumber);
+  /**
+   * @brief 等待正在解码的帧完成后退出线程，并移除所有通道
+   */
+  void stop();
+
+  /**
+   * @param[in] intervalMs : 两帧之间的间隔，0表示尽快解码
+   * @return channelId已经在调度(包括刚结束、最后一帧还在解码)时不添加，
+   * 返回common::ErrorCode::DECODE_CHANNEL_USED
+   */
+  common::ErrorCode add(int channelId, double intervalMs, StepHandler handler);
+  /**
+   * @brief 移除通道，通道正在解码时等待这一帧完成。不能在StepHandler中调用
+   */
+  void remove(int channelId);
+  common::ErrorCode pause(int channelId);
+  common::ErrorCode resume(int channelId);
+
+  // 网络流没有数据时的重试间隔
+  static constexpr std::chrono::milliseconds kRetryInterval{5};
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  struct Channel {
+    double mIntervalMs = 0;
+    StepHandler mHandler;
+    Clock::time_point mDue;
+    std::uint64_t mSequence = 0;
+    bool mQueued = false;
+    bool mRunning = false;
+    bool mPaused = false;
+    bool mRemoved = false;
+  };
+
+  void run();
+  // 以下调用时需持有mMutex
+  void enqueue(int channelId, const std::shared_ptr<Channel>& channel);
+  void dequeue(int channelId, const std::shared_ptr<Channel>& channel);
+
+  std::map<int, std::shared_ptr<Channel>> mChannels;
+  // {到期时间, 入队序号, channelId}，到期时间相同时先入队的先解码
+  std::set<std::tuple<Clock::time_point, std::uint64_t, int>> mQueue;
+  std::uint64_t mSequence = 0;
+
+  std::vector<std::thread> mThreads;
+  bool mStop = true;
+  std::mutex mMutex;
+  std::condition_variable mCv;
+  // 通道的一帧解码完成时通知，用于remove等待
+  std::condition_variable mIdleCv;
+};
+
+}  // namespace decode
+}  // namespace element
+}  // namespace sophon_stream
+
+#endif  // SOPHON_STREAM_ELEMENT_MULTIMEDIA_DECODE_DECODE_SCHEDULER_H_
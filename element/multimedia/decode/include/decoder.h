@@ -21,6 +21,7 @@
 #include "common/no_copyable.h"
 #include "ff_decode.h"
 #include "http_base64_mgr.h"
+#include "image_prefetcher.h"
 
 namespace sophon_stream {
 namespace element {
@@ -31,10 +32,20 @@ class Decoder : public ::sophon_stream::common::NoCopyable {
   Decoder();
   ~Decoder();
 
+  /**
+   * @param[in] externalPacing : 由DecodeScheduler控制帧率，解码时不sleep
+   */
   common::ErrorCode init(int graphId, const ChannelOperateRequest& request,
-                         bm_handle_t handle);
+                         bm_handle_t handle, bool externalPacing = false);
+  /**
+   * @return 网络流暂时没有数据时返回DECODE_NOT_READY，objectMetadata为空
+   */
   common::ErrorCode process(
       std::shared_ptr<common::ObjectMetadata>& objectMetadata);
+  /**
+   * @brief 两帧之间的间隔(ms)，fps为-1时为0
+   */
+  double frameInterval() const { return decoder.getFrameInterval(); }
   void uninit();
 
  private:
@@ -49,9 +60,16 @@ class Decoder : public ::sophon_stream::common::NoCopyable {
   int mFrameCount;
   ChannelOperateRequest::SourceType mSourceType;
   std::vector<std::string> mImagePaths;
+  // IMG_DIR开启预读时不使用mImagePaths
+  std::shared_ptr<ImagePrefetcher> mPrefetcher;
   HTTP_Base64_Mgr* mgr;
   bmcv_rect_t mRoi;
   bool mRoiPredefined = false;
+  // 大于0时解码后缩放到该尺寸
+  int mOutputWidth = 0;
+  int mOutputHeight = 0;
+  // 只解码关键帧或者按时间抽帧，输出的帧数少于mFrameCount
+  bool mReducedDecode = false;
 
   double mFps;
   int mSampleInterval;
@@ -12,6 +12,7 @@
 
 #include <pthread.h>
 #include <sys/time.h>
+#include <chrono>
 
 #include <fstream>
 #include <iostream>
@@ -19,6 +20,7 @@
 #include <opencv2/core.hpp>
 #include <queue>
 #include <thread>
+#include <vector>
 
 // for bmcv_api_ext.h
 #include "channel.h"
@@ -68,8 +70,24 @@ std::shared_ptr<bm_image> pngDec(bm_handle_t& handle, std::string input_name);
 std::shared_ptr<bm_image> jpgDec(bm_handle_t& handle, std::string input_name);
 std::shared_ptr<bm_image> bmpDec(bm_handle_t& handle, std::string input_name);
 
+/**
+ * @brief 读取整个文件，末尾补AV_INPUT_BUFFER_PADDING_SIZE个0
+ */
+bool readPicFile(const std::string& path, std::vector<uint8_t>& buffer);
+
+/**
+ * @brief 解码内存中的jpg、png、bmp图像，格式由数据头判断，不支持的格式返回nullptr。
+ * data之后需要有AV_INPUT_BUFFER_PADDING_SIZE字节可读
+ */
+std::shared_ptr<bm_image> picDec(bm_handle_t& handle, uint8_t* data, int size);
+std::shared_ptr<bm_image> pngDec(bm_handle_t& handle, uint8_t* data, int size);
+std::shared_ptr<bm_image> jpgDec(bm_handle_t& handle, uint8_t* data, int size);
+std::shared_ptr<bm_image> bmpDec(bm_handle_t& handle, uint8_t* data, int size);
+
 using sampleStrategy =
     ::sophon_stream::element::decode::ChannelOperateRequest::SampleStrategy;
+using decodeMode =
+    ::sophon_stream::element::decode::ChannelOperateRequest::DecodeMode;
 
 /**
  * video decode class
@@ -106,8 +124,37 @@ class VideoDecFFM {
   /* set fps */
   void setFps(int f);
 
+  /* 由外部调度器控制帧率时，grab和picDec不再sleep；网络流的读包改为非阻塞 */
+  void setExternalPacing(bool external);
+
+  /* 两帧之间的间隔(ms)，不控制帧率时为0；按时间抽帧时不小于抽帧周期 */
+  double getFrameInterval() const;
+
+  /* 按帧间隔sleep到下一帧的时间，由外部调度器控制帧率时直接返回 */
+  void waitFrameInterval();
+
+  /* 只解码关键帧，或者按码流时间抽帧并跳过不参考的帧，需在openDec之前设置 */
+  void setDecodeMode(decodeMode mode, double samplePeriodMs);
+
+  /* 上一次grab因为网络流暂时没有数据或者正在等待重连而返回，不是断流 */
+  bool wouldBlock() const { return would_block; }
+
  private:
   bool quit_flag = false;
+  bool external_pacing = false;
+  bool would_block = false;
+  // 外部调度时网络流断开后处于重连状态，下一次尝试重连的时间
+  bool reconnecting = false;
+  std::chrono::steady_clock::time_point reconnect_due;
+  // 本通道的hardware_decode和data_on_device_mem，见ff_decode.cc
+  bool channel_hardware_decode = true;
+  bool channel_data_on_device_mem = true;
+
+  decodeMode decode_mode = decodeMode::ALL;
+  double sample_period_ms = 0;
+  double last_sample_time = -1;  // ms
+  // avcC/hvcC中NAL长度字段的字节数，Annex B码流为0
+  int nal_length_size = 0;
 
   int is_rtsp;
   int is_rtmp;
@@ -155,6 +202,19 @@ class VideoDecFFM {
   AVFrame* flushDecoder();
 
   AVFrame* grabFrame(int& eof);
+
+  /* 外部调度时的重连：每次调用最多尝试一次openDec，间隔未到或失败时返回NULL，
+   * 由调度器稍后重试，断开的通道不会一直占用线程池的线程 */
+  AVFrame* tryReconnect(int& eof);
+
+  /* 在送入解码器之前丢弃不需要的包 */
+  bool skipPacket(const AVPacket* packet) const;
+
+  /* H.264/HEVC的包中所有图像都不会被后续保留的帧参考 */
+  bool isNonReferencePacket(const AVPacket* packet) const;
+
+  /* 距离上一次输出的帧是否已经达到抽帧周期 */
+  bool isSampleDue(const AVFrame* avframe);
 };
 
 #endif  // SOPHON_STREAM_ELEMENT_MULTIMEDIA_DECODE_FF_DECODE_H_
@@ -0,0 +1,129 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SOPHON_STREAM_ELEMENT_MULTIMEDIA_DECODE_IMAGE_PREFETCHER_H_
+#define SOPHON_STREAM_ELEMENT_MULTIMEDIA_DECODE_IMAGE_PREFETCHER_H_
+
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "channel.h"
+#include "common/error_code.h"
+#include "common/no_copyable.h"
+#include "ff_decode.h"
+
+namespace sophon_stream {
+namespace element {
+namespace decode {
+
+/**
+ * @brief IMG_DIR通道的预读和并行解码
+ * @brief
+ * 输入可以是图片文件夹、清单文件(每行一个路径，相对路径以清单所在目录为起点)或者未压缩的tar包。
+ * io线程提前读取后面depth张以内的图像，解码线程并行解码已读取的图像，next按列表顺序返回。
+ * 列表在排序之后按shard切分，再按需打乱，同一个seed在每次运行中的顺序相同，因此可以从进度文件中
+ * 记录的位置继续
+ */
+class ImagePrefetcher : public ::sophon_stream::common::NoCopyable {
+ public:
+  using Options = ChannelOperateRequest::ImagePrefetch;
+
+  ImagePrefetcher() {}
+  ~ImagePrefetcher() { stop(); }
+
+  /**
+   * @brief 列出输入中的图像，从进度文件恢复起始位置后启动io和解码线程
+   * @param[in] loopNum : 列表重复的次数
+   */
+  common::ErrorCode start(const std::string& url, const Options& options,
+                          int loopNum, bm_handle_t handle);
+  void stop();
+
+  /**
+   * @brief 等待并取出下一张图像
+   * @param[out] index : 从0开始的全局序号，循环时继续累加
+   * @return 所有图像都已取出时返回false
+   */
+  bool next(std::shared_ptr<bm_image>& image, std::int64_t& index);
+
+  /**
+   * @brief 恢复的起始序号，没有进度文件时为0
+   */
+  std::int64_t startIndex() const { return mStartIndex; }
+  std::size_t imageCount() const { return mEntries.size(); }
+
+  // 判断输入为清单文件的后缀
+  static bool isManifest(const std::string& url);
+  static bool isTar(const std::string& url);
+
+ private:
+  // tar包中的图像记录数据偏移，offset为-1表示普通文件
+  struct Entry {
+    std::string path;
+    std::int64_t offset = -1;
+    std::int64_t size = 0;
+  };
+
+  enum class SlotState {
+    EMPTY,
+    READING,
+    READ,
+    DECODING,
+    READY,
+  };
+
+  struct Slot {
+    std::int64_t index = -1;
+    SlotState state = SlotState::EMPTY;
+    std::vector<uint8_t> data;
+    std::shared_ptr<bm_image> image;
+  };
+
+  common::ErrorCode listEntries(const std::string& url);
+  common::ErrorCode listTar(const std::string& url);
+  void arrangeEntries();
+  void loadProgress();
+  void saveProgress(std::int64_t nextIndex);
+
+  void ioLoop();
+  void decodeLoop();
+  bool readEntry(const Entry& entry, std::vector<uint8_t>& data);
+
+  Options mOptions;
+  bm_handle_t mHandle;
+  std::vector<Entry> mEntries;
+  int mTarFd = -1;
+  std::int64_t mTotal = 0;
+  std::int64_t mStartIndex = 0;
+
+  // mSlots[index % depth]保存序号为index的图像，序号不超过mNextOutput + depth
+  std::vector<Slot> mSlots;
+  std::int64_t mNextRead = 0;
+  std::int64_t mNextOutput = 0;
+  // 已读取等待解码的序号，序号小的先解码
+  std::set<std::int64_t> mReadIndexes;
+  std::int64_t mLastSaved = 0;
+
+  std::vector<std::thread> mThreads;
+  bool mStop = true;
+  std::mutex mMutex;
+  std::condition_variable mCv;
+};
+
+}  // namespace decode
+}  // namespace element
+}  // namespace sophon_stream
+
+#endif  // SOPHON_STREAM_ELEMENT_MULTIMEDIA_DECODE_IMAGE_PREFETCHER_H_
@@ -19,9 +19,11 @@ std::unordered_map<int, std::atomic<int>> Decode::mChannelCountMap;
 std::unordered_map<int, std::queue<int>> Decode::mChannelIdInternalReleasedMap;
 
 Decode::~Decode() {
+  mScheduler.stop();
   std::lock_guard<std::mutex> lk(mThreadsPoolMtx);
   for (auto& channelInfo : mThreadsPool) {
-    channelInfo.second->mThreadWrapper->stop();
+    if (channelInfo.second->mThreadWrapper)
+      channelInfo.second->mThreadWrapper->stop();
   }
   mThreadsPool.clear();
   bm_dev_free(handle_);
@@ -37,6 +39,19 @@ common::ErrorCode Decode::initInternal(const std::string& json) {
       break;
     }
     mFpsProfiler.config("fps_decode", 100);
+
+    auto shedWatermarkIt = configure.find(CONFIG_INTERNAL_SHED_WATERMARK_FIELD);
+    if (configure.end() != shedWatermarkIt &&
+        shedWatermarkIt->is_number()) {
+      mShedWatermark = shedWatermarkIt->get<float>();
+    }
+
+    auto decodeThreadsIt = configure.find(CONFIG_INTERNAL_DECODE_THREADS_FIELD);
+    if (configure.end() != decodeThreadsIt &&
+        decodeThreadsIt->is_number_integer()) {
+      mDecodeThreads = decodeThreadsIt->get<int>();
+    }
+
     int dev_id = getDeviceId();
     bm_dev_request(&handle_, dev_id);
   } while (false);
@@ -44,13 +59,20 @@ common::ErrorCode Decode::initInternal(const std::string& json) {
   return errorCode;
 }
 
-void Decode::onStart() { IVS_INFO("Decode start..."); }
+void Decode::onStart() {
+  IVS_INFO("Decode start...");
+  if (mDecodeThreads > 0) mScheduler.start(mDecodeThreads);
+}
 
 void Decode::onStop() {
-  IVS_INFO("Decode stop...");
+  IVS_INFO("Decode stop..., {0} frames shed under overload",
+           mShedCount.load());
+  // 先停调度线程，它们在一帧结束时可能需要mThreadsPoolMtx
+  mScheduler.stop();
   std::lock_guard<std::mutex> lk(mThreadsPoolMtx);
   for (auto& channelInfo : mThreadsPool) {
-    channelInfo.second->mThreadWrapper->stop();
+    if (channelInfo.second->mThreadWrapper)
+      channelInfo.second->mThreadWrapper->stop();
     channelInfo.second->mSpDecoder->uninit();
     channelInfo.second->mThreadWrapper.reset();
   }
@@ -247,6 +269,76 @@ common::ErrorCode Decode::parse_channel_task(
               : ChannelOperateRequest::SampleStrategy::DROP;
     }
 
+    channelTask->request.priority = 0;
+    auto priorityIt = configure.find(JSON_PRIORITY);
+    if (configure.end() != priorityIt && priorityIt->is_number_integer()) {
+      channelTask->request.priority = priorityIt->get<int>();
+    }
+
+    channelTask->request.targetFps = 0;
+    auto targetFpsIt = configure.find(JSON_TARGET_FPS);
+    if (configure.end() != targetFpsIt && targetFpsIt->is_number()) {
+      channelTask->request.targetFps = targetFpsIt->get<double>();
+    }
+
+    channelTask->request.decodeMode = ChannelOperateRequest::DecodeMode::ALL;
+    auto decodeModeIt = configure.find(JSON_DECODE_MODE);
+    if (configure.end() != decodeModeIt && decodeModeIt->is_string()) {
+      channelTask->request.decodeMode =
+          decodeModeIt->get<std::string>() == "KEYFRAME"
+              ? ChannelOperateRequest::DecodeMode::KEYFRAME
+              : ChannelOperateRequest::DecodeMode::ALL;
+    }
+
+    channelTask->request.samplePeriodMs = 0;
+    auto samplePeriodIt = configure.find(JSON_SAMPLE_PERIOD_MS);
+    if (configure.end() != samplePeriodIt && samplePeriodIt->is_number()) {
+      channelTask->request.samplePeriodMs = samplePeriodIt->get<double>();
+    }
+
+    channelTask->request.outputWidth = 0;
+    channelTask->request.outputHeight = 0;
+    auto outputWidthIt = configure.find(JSON_OUTPUT_WIDTH);
+    auto outputHeightIt = configure.find(JSON_OUTPUT_HEIGHT);
+    if (configure.end() != outputWidthIt && configure.end() != outputHeightIt &&
+        outputWidthIt->is_number_integer() &&
+        outputHeightIt->is_number_integer()) {
+      channelTask->request.outputWidth = outputWidthIt->get<int>();
+      channelTask->request.outputHeight = outputHeightIt->get<int>();
+    }
+
+    // 清单文件和tar包只能通过预读读取
+    auto& prefetch = channelTask->request.imagePrefetch;
+    prefetch = ChannelOperateRequest::ImagePrefetch();
+    auto prefetchIt = configure.find(JSON_IMAGE_PREFETCH);
+    if (channelTask->request.sourceType ==
+        ChannelOperateRequest::SourceType::IMG_DIR) {
+      prefetch.enabled =
+          (configure.end() != prefetchIt && prefetchIt->is_object()) ||
+          ImagePrefetcher::isManifest(channelTask->request.url) ||
+          ImagePrefetcher::isTar(channelTask->request.url);
+    }
+    if (prefetch.enabled && configure.end() != prefetchIt &&
+        prefetchIt->is_object()) {
+      prefetch.depth = prefetchIt->value(JSON_PREFETCH_DEPTH, prefetch.depth);
+      prefetch.ioThreads =
+          prefetchIt->value(JSON_PREFETCH_IO_THREADS, prefetch.ioThreads);
+      prefetch.decodeThreads = prefetchIt->value(JSON_PREFETCH_DECODE_THREADS,
+                                                 prefetch.decodeThreads);
+      prefetch.shuffle =
+          prefetchIt->value(JSON_PREFETCH_ORDER, std::string("SORTED")) ==
+          "SHUFFLED";
+      prefetch.seed = prefetchIt->value(JSON_PREFETCH_SEED, prefetch.seed);
+      prefetch.shardIndex =
+          prefetchIt->value(JSON_PREFETCH_SHARD_INDEX, prefetch.shardIndex);
+      prefetch.shardCount =
+          prefetchIt->value(JSON_PREFETCH_SHARD_COUNT, prefetch.shardCount);
+      prefetch.progressFile = prefetchIt->value(JSON_PREFETCH_PROGRESS_FILE,
+                                                prefetch.progressFile);
+      prefetch.checkpointInterval = prefetchIt->value(
+          JSON_PREFETCH_CHECKPOINT_INTERVAL, prefetch.checkpointInterval);
+    }
+
     auto roi_it = configure.find(JSON_ROI_FILED);
     if (roi_it == configure.end()) {
       channelTask->request.roi_predefined = false;
@@ -298,10 +390,14 @@ common::ErrorCode Decode::startTask(std::shared_ptr<ChannelTask>& channelTask) {
   }
 
   std::shared_ptr<ChannelInfo> channelInfo = std::make_shared<ChannelInfo>();
+  if (usePool(channelTask->request.sourceType))
+    return startPooledTask(channelTask, channelInfo);
 
   channelInfo->mThreadWrapper = std::make_shared<ThreadWrapper>();
   channelInfo->mMtx = std::make_shared<std::mutex>();
   channelInfo->mCv = std::make_shared<std::condition_variable>();
+  channelInfo->mPriority = channelTask->request.priority;
+  channelInfo->mTargetFps = channelTask->request.targetFps;
   channelInfo->mThreadWrapper->init(
       [this, channelInfo, channelTask]() -> common::ErrorCode {
         prctl(PR_SET_NAME,
@@ -348,6 +444,7 @@ common::ErrorCode Decode::startTask(std::shared_ptr<ChannelTask>& channelTask) {
         if (iter != mThreadsPool.end()) {
           mThreadsPool.erase(iter);
         }
+        updateMaxPriority();
         return channelTask->response.errorCode;
       });
   channelInfo->mThreadWrapper->start();
@@ -360,10 +457,79 @@ common::ErrorCode Decode::startTask(std::shared_ptr<ChannelTask>& channelTask) {
   }
   mThreadsPool.insert(
       std::make_pair(channelTask->request.channelId, channelInfo));
+  updateMaxPriority();
 
-  int graph_id = channelTask->request.graphId;
   int channel_id = channelTask->request.channelId;
-  // 这里不需要判断channel_id是否在占用，因为本函数开头就在mThreadsPool里处理了
+  assignChannelIdInternal(channelTask->request.graphId, channel_id);
+
+  IVS_INFO("add one channel task finished, channel id = {0}", channel_id);
+  return channelTask->response.errorCode;
+}
+
+bool Decode::usePool(ChannelOperateRequest::SourceType sourceType) const {
+  return mDecodeThreads > 0 &&
+         sourceType != ChannelOperateRequest::SourceType::BASE64 &&
+         sourceType != ChannelOperateRequest::SourceType::CAMERA;
+}
+
+common::ErrorCode Decode::startPooledTask(
+    std::shared_ptr<ChannelTask>& channelTask,
+    std::shared_ptr<ChannelInfo>& channelInfo) {
+  int channel_id = channelTask->request.channelId;
+  channelInfo->mPooled = true;
+  channelInfo->mPriority = channelTask->request.priority;
+  channelInfo->mTargetFps = channelTask->request.targetFps;
+  channelInfo->mSpDecoder = std::make_shared<Decoder>();
+  common::ErrorCode ret = channelInfo->mSpDecoder->init(
+      getGraphId(), channelTask->request, handle_, true);
+  if (ret != common::ErrorCode::SUCCESS) {
+    channelTask->response.errorCode = ret;
+    channelTask->response.errorInfo =
+        "Decoder init failed! channel id is " + std::to_string(channel_id);
+    IVS_ERROR("{0}", channelTask->response.errorInfo);
+    channelInfo->mSpDecoder->uninit();
+    return ret;
+  }
+
+  mThreadsPool.insert(std::make_pair(channel_id, channelInfo));
+  updateMaxPriority();
+  assignChannelIdInternal(channelTask->request.graphId, channel_id);
+
+  ret = mScheduler.add(
+      channel_id, channelInfo->mSpDecoder->frameInterval(),
+      [this, channelTask, channelInfo]() -> DecodeScheduler::StepResult {
+        common::ErrorCode ret = process(channelTask, channelInfo);
+        if (common::ErrorCode::DECODE_NOT_READY == ret)
+          return DecodeScheduler::StepResult::NOT_READY;
+        // 通道已经结束或者被停止
+        std::lock_guard<std::mutex> lk(mThreadsPoolMtx);
+        auto iter = mThreadsPool.find(channelTask->request.channelId);
+        return (iter != mThreadsPool.end() && iter->second == channelInfo)
+                   ? DecodeScheduler::StepResult::FRAME
+                   : DecodeScheduler::StepResult::END;
+      });
+  if (ret != common::ErrorCode::SUCCESS) {
+    // 同一channelId上一次的最后一帧还在解码，撤销这次添加
+    channelTask->response.errorCode = ret;
+    channelTask->response.errorInfo =
+        "this channel is used! channel id is " + std::to_string(channel_id);
+    mThreadsPool.erase(channel_id);
+    updateMaxPriority();
+    int graph_id = channelTask->request.graphId;
+    auto itChannelId = mChannelIdInternalMap[graph_id].find(channel_id);
+    mChannelIdInternalReleasedMap[graph_id].push(itChannelId->second);
+    mChannelIdInternalMap[graph_id].erase(itChannelId);
+    channelInfo->mSpDecoder->uninit();
+    return ret;
+  }
+
+  IVS_INFO("add one pooled channel task finished, channel id = {0}",
+           channel_id);
+  return channelTask->response.errorCode;
+}
+
+void Decode::assignChannelIdInternal(int graph_id, int channel_id) {
+  // 这里不需要判断channel_id是否在占用，因为startTask开头就在mThreadsPool里处理了
   // 更新channel_id。需要判断是否有释放出来的channelIdInternal
   if (mChannelIdInternalReleasedMap[graph_id].empty()) {
     // 没有释放的channelIdInternal，那么只能更新一个。
@@ -374,13 +540,10 @@ common::ErrorCode Decode::startTask(std::shared_ptr<ChannelTask>& channelTask) {
     mChannelIdInternalReleasedMap[graph_id].pop();
     mChannelIdInternalMap[graph_id][channel_id] = channelIdInternal;
   }
-
-  IVS_INFO("add one channel task finished, channel id = {0}", channel_id);
-  return channelTask->response.errorCode;
 }
 
 common::ErrorCode Decode::stopTask(std::shared_ptr<ChannelTask>& channelTask) {
-  std::lock_guard<std::mutex> lk(mThreadsPoolMtx);
+  std::unique_lock<std::mutex> lk(mThreadsPoolMtx);
   auto itTask = mThreadsPool.find(channelTask->request.channelId);
   if (itTask == mThreadsPool.end()) {
     channelTask->response.errorCode =
@@ -390,6 +553,17 @@ common::ErrorCode Decode::stopTask(std::shared_ptr<ChannelTask>& channelTask) {
     IVS_ERROR("{0}", error);
     return common::ErrorCode::DECODE_CHANNEL_NOT_FOUND;
   }
+  bool pooled = itTask->second->mPooled;
+  if (pooled) {
+    // 等待正在解码的帧时不能持有锁，这一帧结束时会检查mThreadsPool
+    auto channelInfo = itTask->second;
+    mThreadsPool.erase(itTask);
+    updateMaxPriority();
+    lk.unlock();
+    mScheduler.remove(channelTask->request.channelId);
+    channelInfo->mSpDecoder->uninit();
+    lk.lock();
+  }
   int graph_id = channelTask->request.graphId;
   // 停止一路码流，需要记录释放出来的channelIdInternal，然后erase一对kv
   auto itChannelId = mChannelIdInternalMap[graph_id].find(channelTask->request.channelId);
@@ -397,10 +571,18 @@ common::ErrorCode Decode::stopTask(std::shared_ptr<ChannelTask>& channelTask) {
   mChannelIdInternalReleasedMap[graph_id].push(channelIdInternal);
   mChannelIdInternalMap[graph_id].erase(itChannelId);
 
+  if (pooled) {
+    channelTask->response.errorCode = common::ErrorCode::SUCCESS;
+    IVS_INFO("stop one pooled channel task finished, channel id = {0}",
+             channelTask->request.channelId);
+    return common::ErrorCode::SUCCESS;
+  }
+
   common::ErrorCode errorCode = itTask->second->mThreadWrapper->stop();
   itTask->second->mSpDecoder->uninit();
   itTask->second->mThreadWrapper.reset();
   mThreadsPool.erase(itTask);
+  updateMaxPriority();
   channelTask->response.errorCode = errorCode;
   IVS_INFO("stop one channel task finished, channel id = {0}",
            channelTask->request.channelId);
@@ -416,6 +598,11 @@ common::ErrorCode Decode::pauseTask(std::shared_ptr<ChannelTask>& channelTask) {
         common::ErrorCode::DECODE_CHANNEL_NOT_FOUND;
     return common::ErrorCode::DECODE_CHANNEL_NOT_FOUND;
   }
+  if (itTask->second->mPooled) {
+    channelTask->response.errorCode =
+        mScheduler.pause(channelTask->request.channelId);
+    return channelTask->response.errorCode;
+  }
   common::ErrorCode errorCode = itTask->second->mThreadWrapper->pause();
   mThreadsPool.erase(itTask);
   channelTask->response.errorCode = errorCode;
@@ -431,6 +618,11 @@ common::ErrorCode Decode::resumeTask(
         common::ErrorCode::DECODE_CHANNEL_NOT_FOUND;
     return common::ErrorCode::DECODE_CHANNEL_NOT_FOUND;
   }
+  if (itTask->second->mPooled) {
+    channelTask->response.errorCode =
+        mScheduler.resume(channelTask->request.channelId);
+    return channelTask->response.errorCode;
+  }
   common::ErrorCode errorCode = itTask->second->mThreadWrapper->resume();
   mThreadsPool.erase(itTask);
   channelTask->response.errorCode = errorCode;
@@ -442,31 +634,29 @@ common::ErrorCode Decode::process(
     const std::shared_ptr<ChannelInfo>& channelInfo) {
   std::shared_ptr<common::ObjectMetadata> objectMetadata;
   common::ErrorCode ret = channelInfo->mSpDecoder->process(objectMetadata);
+  if (ret == common::ErrorCode::DECODE_NOT_READY) return ret;
   int graphId = channelTask->request.graphId;
   mFpsProfiler.add(1);
   if (ret == common::ErrorCode::STREAM_END) {
     // end of stream , detach thread and erase in mThreadsPool,
+    // 共用线程的通道由mScheduler在这一帧结束后移除
     std::lock_guard<std::mutex> lk(mThreadsPoolMtx);
     channelTask->response.errorCode = ret;
-    channelInfo->mThreadWrapper->stop(false);
+    if (channelInfo->mThreadWrapper) channelInfo->mThreadWrapper->stop(false);
     channelInfo->mSpDecoder->uninit();
     auto iter = mThreadsPool.find(channelTask->request.channelId);
-    if (iter != mThreadsPool.end()) {
+    if (iter != mThreadsPool.end() && iter->second == channelInfo) {
       mThreadsPool.erase(iter);
     }
+    updateMaxPriority();
   }
   int channel_id = channelTask->request.channelId;
   std::vector<int> skip_elements = channelTask->request.skip_element;
   objectMetadata->mSkipElements = skip_elements;
   objectMetadata->mFrame->mChannelId = channel_id;
   objectMetadata->mFrame->mChannelIdInternal = mChannelIdInternalMap[graphId][channel_id];
+  objectMetadata->mFrame->mPriority = channelTask->request.priority;
 
-  // push data to next element
-  if (objectMetadata->mFilter && !objectMetadata->mFrame->mEndOfStream &&
-      channelTask->request.sampleStrategy ==
-          ChannelOperateRequest::SampleStrategy::DROP) {
-    return common::ErrorCode::SUCCESS;
-  }
   int channel_id_internal = objectMetadata->mFrame->mChannelIdInternal;
   int outputPort = 0;
   if (!getSinkElementFlag()) {
@@ -476,9 +666,24 @@ common::ErrorCode Decode::process(
   int dataPipeId =
       getSinkElementFlag()
           ? 0
-          : (channel_id_internal % getOutputConnectorCapacity(outputPort));
-  common::ErrorCode errorCode = pushOutputData(
-      outputPort, dataPipeId, std::static_pointer_cast<void>(objectMetadata));
+          : getOutputDataPipeId(outputPort, channel_id_internal,
+                                objectMetadata->mFrame->mEndOfStream);
+
+  // 负载过高时，被降级的帧与抽帧同样处理
+  if (!objectMetadata->mFilter && !objectMetadata->mFrame->mEndOfStream &&
+      shouldShed(channelInfo, outputPort, dataPipeId)) {
+    objectMetadata->mFilter = true;
+    ++mShedCount;
+  }
+
+  // push data to next element
+  if (objectMetadata->mFilter && !objectMetadata->mFrame->mEndOfStream &&
+      channelTask->request.sampleStrategy ==
+          ChannelOperateRequest::SampleStrategy::DROP) {
+    return common::ErrorCode::SUCCESS;
+  }
+  common::ErrorCode errorCode = pushOutputMessage(
+      outputPort, dataPipeId, framework::Message(objectMetadata));
   if (common::ErrorCode::SUCCESS != errorCode) {
     IVS_WARN("Send data fail, element id: {0}, output port: {1}, data: {2:p}",
              getId(), 0, static_cast<void*>(objectMetadata.get()));
@@ -487,6 +692,30 @@ common::ErrorCode Decode::process(
   return ret;
 }
 
+void Decode::updateMaxPriority() {
+  int maxPriority = 0;
+  for (auto& channelInfo : mThreadsPool)
+    maxPriority = std::max(maxPriority, channelInfo.second->mPriority);
+  mMaxPriority = maxPriority;
+}
+
+bool Decode::shouldShed(const std::shared_ptr<ChannelInfo>& channelInfo,
+                        int outputPort, int dataPipeId) {
+  if (getSinkElementFlag()) return false;
+  auto now = std::chrono::steady_clock::now();
+  bool shed = channelInfo->mPriority < mMaxPriority &&
+              getOutputDataPipeOccupancy(outputPort, dataPipeId) >=
+                  mShedWatermark &&
+              (channelInfo->mTargetFps <= 0 ||
+               now < channelInfo->mNextKeepTime);
+  if (!shed && channelInfo->mTargetFps > 0) {
+    channelInfo->mNextKeepTime =
+        now + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                  std::chrono::duration<double>(1.0 / channelInfo->mTargetFps));
+  }
+  return shed;
+}
+
 REGISTER_WORKER("decode", Decode)
 
 }  // namespace decode
@@ -0,0 +1,163 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#include "decode_scheduler.h"
+
+#include <sys/prctl.h>
+
+#include "common/logger.h"
+
+namespace sophon_stream {
+namespace element {
+namespace decode {
+
+common::ErrorCode DecodeScheduler::start(int threadNumber) {
+  std::lock_guard<std::mutex> lk(mMutex);
+  if (!mStop) {
+    IVS_ERROR("Can not start, decode scheduler is running");
+    return common::ErrorCode::THREAD_STATUS_ERROR;
+  }
+  mStop = false;
+  for (int i = 0; i < threadNumber; ++i)
+    mThreads.emplace_back(&DecodeScheduler::run, this);
+  IVS_INFO("Decode scheduler start, thread number: {0}", threadNumber);
+  return common::ErrorCode::SUCCESS;
+}
+
+void DecodeScheduler::stop() {
+  {
+    std::lock_guard<std::mutex> lk(mMutex);
+    if (mStop) return;
+    mStop = true;
+  }
+  mCv.notify_all();
+  for (auto& thread : mThreads) thread.join();
+  mThreads.clear();
+
+  std::lock_guard<std::mutex> lk(mMutex);
+  mQueue.clear();
+  mChannels.clear();
+}
+
+common::ErrorCode DecodeScheduler::add(int channelId, double intervalMs,
+                                       StepHandler handler) {
+  auto channel = std::make_shared<Channel>();
+  channel->mIntervalMs = intervalMs;
+  channel->mHandler = handler;
+  channel->mDue = Clock::now();
+  {
+    std::lock_guard<std::mutex> lk(mMutex);
+    if (mChannels.find(channelId) != mChannels.end()) {
+      IVS_WARN("this channel is scheduled! channel id is {0}", channelId);
+      return common::ErrorCode::DECODE_CHANNEL_USED;
+    }
+    mChannels[channelId] = channel;
+    enqueue(channelId, channel);
+  }
+  mCv.notify_one();
+  return common::ErrorCode::SUCCESS;
+}
+
+void DecodeScheduler::remove(int channelId) {
+  std::unique_lock<std::mutex> lk(mMutex);
+  auto channelIt = mChannels.find(channelId);
+  if (mChannels.end() == channelIt) return;
+  auto channel = channelIt->second;
+  channel->mRemoved = true;
+  dequeue(channelId, channel);
+  mChannels.erase(channelIt);
+  mIdleCv.wait(lk, [&channel]() { return !channel->mRunning; });
+}
+
+common::ErrorCode DecodeScheduler::pause(int channelId) {
+  std::lock_guard<std::mutex> lk(mMutex);
+  auto channelIt = mChannels.find(channelId);
+  if (mChannels.end() == channelIt || channelIt->second->mPaused)
+    return common::ErrorCode::THREAD_STATUS_ERROR;
+  channelIt->second->mPaused = true;
+  dequeue(channelId, channelIt->second);
+  return common::ErrorCode::SUCCESS;
+}
+
+common::ErrorCode DecodeScheduler::resume(int channelId) {
+  {
+    std::lock_guard<std::mutex> lk(mMutex);
+    auto channelIt = mChannels.find(channelId);
+    if (mChannels.end() == channelIt || !channelIt->second->mPaused)
+      return common::ErrorCode::THREAD_STATUS_ERROR;
+    auto& channel = channelIt->second;
+    channel->mPaused = false;
+    channel->mDue = Clock::now();
+    // 暂停时正在解码的通道由解码线程在这一帧完成后重新入队
+    if (!channel->mRunning) enqueue(channelId, channel);
+  }
+  mCv.notify_one();
+  return common::ErrorCode::SUCCESS;
+}
+
+void DecodeScheduler::enqueue(int channelId,
+                              const std::shared_ptr<Channel>& channel) {
+  channel->mSequence = mSequence++;
+  channel->mQueued = true;
+  mQueue.emplace(channel->mDue, channel->mSequence, channelId);
+}
+
+void DecodeScheduler::dequeue(int channelId,
+                              const std::shared_ptr<Channel>& channel) {
+  if (!channel->mQueued) return;
+  mQueue.erase(std::make_tuple(channel->mDue, channel->mSequence, channelId));
+  channel->mQueued = false;
+}
+
+void DecodeScheduler::run() {
+  prctl(PR_SET_NAME, "decode_pool");
+  std::unique_lock<std::mutex> lk(mMutex);
+  while (!mStop) {
+    if (mQueue.empty()) {
+      mCv.wait(lk);
+      continue;
+    }
+    auto first = *mQueue.begin();
+    if (std::get<0>(first) > Clock::now()) {
+      mCv.wait_until(lk, std::get<0>(first));
+      continue;
+    }
+    mQueue.erase(mQueue.begin());
+    int channelId = std::get<2>(first);
+    auto channel = mChannels[channelId];
+    channel->mQueued = false;
+    channel->mRunning = true;
+    // 队首换成了更晚到期的通道，唤醒其它线程重新计算等待时间
+    if (!mQueue.empty()) mCv.notify_one();
+
+    lk.unlock();
+    StepResult result = channel->mHandler();
+    lk.lock();
+
+    channel->mRunning = false;
+    if (channel->mRemoved || StepResult::END == result) {
+      if (!channel->mRemoved) mChannels.erase(channelId);
+      mIdleCv.notify_all();
+      continue;
+    }
+    auto now = Clock::now();
+    if (StepResult::NOT_READY == result) {
+      channel->mDue = now + kRetryInterval;
+    } else {
+      channel->mDue += std::chrono::duration_cast<Clock::duration>(
+          std::chrono::duration<double, std::milli>(channel->mIntervalMs));
+      if (channel->mDue < now) channel->mDue = now;
+    }
+    if (!channel->mPaused) enqueue(channelId, channel);
+  }
+}
+
+}  // namespace decode
+}  // namespace element
+}  // namespace sophon_stream
@@ -80,7 +80,7 @@ Decoder::~Decoder() {
 
 common::ErrorCode Decoder::init(int graphId,
                                 const ChannelOperateRequest& request,
-                                bm_handle_t handle_) {
+                                bm_handle_t handle_, bool externalPacing) {
   common::ErrorCode errorCode = common::ErrorCode::SUCCESS;
   do {
     mUrl = request.url;
@@ -95,6 +95,13 @@ common::ErrorCode Decoder::init(int graphId,
     mSourceType = request.sourceType;
     mImgIndex = 0;
     mRoiPredefined = request.roi_predefined;
+    decoder.setExternalPacing(externalPacing);
+    decoder.setDecodeMode(request.decodeMode, request.samplePeriodMs);
+    mReducedDecode =
+        request.decodeMode == ChannelOperateRequest::DecodeMode::KEYFRAME ||
+        request.samplePeriodMs > 0;
+    mOutputWidth = request.outputWidth;
+    mOutputHeight = request.outputHeight;
     if (mRoiPredefined) {
       mRoi.start_x = request.roi.start_x;
       mRoi.start_y = request.roi.start_y;
@@ -115,7 +122,14 @@ common::ErrorCode Decoder::init(int graphId,
       IVS_INFO("Decoder::init, mFrameCount: {0}", mFrameCount);
     }
 
-    if (mSourceType == ChannelOperateRequest::SourceType::IMG_DIR) {
+    if (mSourceType == ChannelOperateRequest::SourceType::IMG_DIR &&
+        request.imagePrefetch.enabled) {
+      mPrefetcher = std::make_shared<ImagePrefetcher>();
+      errorCode = mPrefetcher->start(mUrl, request.imagePrefetch, mLoopNum,
+                                     m_handle);
+      if (common::ErrorCode::SUCCESS != errorCode) break;
+      decoder.setFps(mFps);
+    } else if (mSourceType == ChannelOperateRequest::SourceType::IMG_DIR) {
       std::vector<std::string> correct_postfixes = {"jpg", "JPEG", "png",
                                                     "bmp"};
       getAllFiles(mUrl, mImagePaths, correct_postfixes);
@@ -164,6 +178,7 @@ common::ErrorCode Decoder::process(
     int64_t pts = 0;
     spBmImage =
         decoder.grab(frame_id, eof, pts, mSampleInterval, mSampleStrategy);
+    if (decoder.wouldBlock()) return common::ErrorCode::DECODE_NOT_READY;
     objectMetadata = std::make_shared<common::ObjectMetadata>();
     objectMetadata->mFrame = std::make_shared<common::Frame>();
     objectMetadata->mFrame->mHandle = m_handle;
@@ -190,6 +205,15 @@ common::ErrorCode Decoder::process(
     int64_t pts = 0;
     spBmImage =
         decoder.grab(frame_id, eof, pts, mSampleInterval, mSampleStrategy);
+    /* 跳帧解码时不知道哪一帧是最后一帧，读到文件结尾再开始下一个循环 */
+    if (mReducedDecode && eof && mLoopNum > 1) {
+      --mLoopNum;
+      eof = 0;
+      decoder.closeDec();
+      decoder.openDec(&m_handle, mUrl.c_str());
+      spBmImage =
+          decoder.grab(frame_id, eof, pts, mSampleInterval, mSampleStrategy);
+    }
     objectMetadata = std::make_shared<common::ObjectMetadata>();
     objectMetadata->mFrame = std::make_shared<common::Frame>();
     objectMetadata->mFrame->mHandle = m_handle;
@@ -199,7 +223,8 @@ common::ErrorCode Decoder::process(
     objectMetadata->mFrame->mTimestamp = pts;
     objectMetadata->mGraphId = mGraphId;
     /* 当mLoopNum > 1，在最后一帧初始化decoder，开始下一个循环 */
-    if (mLoopNum > 1 && (mImgIndex++ == mFrameCount - 1)) {
+    if (!mReducedDecode && mLoopNum > 1 &&
+        (mImgIndex++ == mFrameCount - 1)) {
       --mLoopNum;
       mImgIndex = 0;
       decoder.closeDec();
@@ -217,6 +242,28 @@ common::ErrorCode Decoder::process(
     if (common::ErrorCode::SUCCESS != errorCode) {
       objectMetadata->mErrorCode = errorCode;
     }
+  } else if (mSourceType == ChannelOperateRequest::SourceType::IMG_DIR &&
+             mPrefetcher) {
+    std::shared_ptr<bm_image> spBmImage = nullptr;
+    std::int64_t index = mImgIndex;
+    decoder.waitFrameInterval();
+    bool more = mPrefetcher->next(spBmImage, index);
+    objectMetadata = std::make_shared<common::ObjectMetadata>();
+    objectMetadata->mFrame = std::make_shared<common::Frame>();
+    objectMetadata->mFrame->mHandle = m_handle;
+    objectMetadata->mFrame->mFrameId = index;
+    objectMetadata->mFrame->mSubFrameIdVec.push_back(index);
+    objectMetadata->mFrame->mSpData = spBmImage;
+    objectMetadata->mGraphId = mGraphId;
+    mImgIndex = index + 1;
+
+    if (!more) {
+      objectMetadata->mFrame->mEndOfStream = true;
+      errorCode = common::ErrorCode::STREAM_END;
+      objectMetadata->mErrorCode = errorCode;
+    } else {
+      bm_image2Frame(objectMetadata->mFrame, *spBmImage);
+    }
   } else if (mSourceType == ChannelOperateRequest::SourceType::IMG_DIR) {
     std::shared_ptr<bm_image> spBmImage = nullptr;
 
@@ -311,7 +358,8 @@ common::ErrorCode Decoder::process(
   // objectMetadata->mFrame->mFrameId); else printf("%d keep \n",
   // objectMetadata->mFrame->mFrameId);
 
-  if (objectMetadata->mFrame->mSpData && mRoiPredefined) {
+  bool resize = mOutputWidth > 0 && mOutputHeight > 0;
+  if (objectMetadata->mFrame->mSpData && (mRoiPredefined || resize)) {
     std::shared_ptr<bm_image> cropped = nullptr;
     cropped.reset(new bm_image, [](bm_image* p) {
       bm_image_destroy(*p);
@@ -319,18 +367,20 @@ common::ErrorCode Decoder::process(
       p = nullptr;
     });
     bm_status_t ret = bm_image_create(
-        objectMetadata->mFrame->mHandle, mRoi.crop_h, mRoi.crop_w,
+        objectMetadata->mFrame->mHandle, resize ? mOutputHeight : mRoi.crop_h,
+        resize ? mOutputWidth : mRoi.crop_w,
         objectMetadata->mFrame->mSpData->image_format,
         objectMetadata->mFrame->mSpData->data_type, cropped.get());
 
-    // #if BMCV_VERSION_MAJOR > 1
-    //     ret = bmcv_image_vpp_convert(objectMetadata->mFrame->mHandle, 1,
-    //     *objectMetadata->mFrame->mSpData,
-    //                                 cropped.get(), &mRoi);
-    // #else
-    ret = bmcv_image_crop(objectMetadata->mFrame->mHandle, 1, &mRoi,
-                          *objectMetadata->mFrame->mSpData, cropped.get());
-    // #endif
+    // 需要缩放时裁剪和缩放在一次vpp操作中完成，原尺寸的帧不再向后传递
+    if (resize)
+      ret = bmcv_image_vpp_convert(objectMetadata->mFrame->mHandle, 1,
+                                   *objectMetadata->mFrame->mSpData,
+                                   cropped.get(),
+                                   mRoiPredefined ? &mRoi : NULL);
+    else
+      ret = bmcv_image_crop(objectMetadata->mFrame->mHandle, 1, &mRoi,
+                            *objectMetadata->mFrame->mSpData, cropped.get());
     if (!ret) {
       bm_image2Frame(objectMetadata->mFrame, *cropped);
       objectMetadata->mFrame->mSpData = cropped;
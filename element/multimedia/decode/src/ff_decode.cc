@@ -14,6 +14,28 @@ using namespace std;
 thread_local bool hardware_decode = true;
 thread_local bool data_on_device_mem = true;
 
+namespace {
+
+// 共用解码线程时一个线程会轮流解码多个通道，进入通道的解码函数时换成该通道的状态，退出时保存回通道
+class DecodeStateScope {
+ public:
+  DecodeStateScope(bool& hardwareDecode, bool& dataOnDeviceMem)
+      : mHardwareDecode(hardwareDecode), mDataOnDeviceMem(dataOnDeviceMem) {
+    hardware_decode = mHardwareDecode;
+    data_on_device_mem = mDataOnDeviceMem;
+  }
+  ~DecodeStateScope() {
+    mHardwareDecode = hardware_decode;
+    mDataOnDeviceMem = data_on_device_mem;
+  }
+
+ private:
+  bool& mHardwareDecode;
+  bool& mDataOnDeviceMem;
+};
+
+}  // namespace
+
 const int hw_jpeg_header_fmt_words[] = {
     0x221111,  // yuv420
     0x211111,  // yuv422
@@ -409,6 +431,8 @@ void VideoDecFFM::mFrameCount(const char* video_file, int& mFrameCount) {
 }
 
 int VideoDecFFM::openDec(bm_handle_t* dec_handle, const char* input) {
+  DecodeStateScope stateScope(channel_hardware_decode,
+                              channel_data_on_device_mem);
   // printf("openDec, tid = %d\n", gettid());
   pkt = new AVPacket;
   av_init_packet(pkt);
@@ -468,6 +492,10 @@ int VideoDecFFM::openDec(bm_handle_t* dec_handle, const char* input) {
     return ret;
   }
 
+  // 探测完成后再设置，不支持非阻塞的demuxer忽略该标志，仍然阻塞读包
+  if (external_pacing && (is_rtsp || is_rtmp || is_gb28181))
+    ifmt_ctx->flags |= AVFMT_FLAG_NONBLOCK;
+
   ret = openCodecContext(&video_stream_idx, &video_dec_ctx, ifmt_ctx,
                          AVMEDIA_TYPE_VIDEO, bm_get_devid(*dec_handle));
 
@@ -475,7 +503,20 @@ int VideoDecFFM::openDec(bm_handle_t* dec_handle, const char* input) {
     width = video_dec_ctx->width;
     height = video_dec_ctx->height;
     pix_fmt = video_dec_ctx->pix_fmt;
+
+    // mp4等容器中的H.264/HEVC以长度前缀分隔NAL，网络流为起始码
+    nal_length_size = 0;
+    const uint8_t* extradata = video_dec_par->extradata;
+    int extradata_size = video_dec_par->extradata_size;
+    if (extradata && extradata[0] == 1) {
+      if (video_dec_par->codec_id == AV_CODEC_ID_H264 && extradata_size > 4)
+        nal_length_size = (extradata[4] & 3) + 1;
+      else if (video_dec_par->codec_id == AV_CODEC_ID_HEVC &&
+               extradata_size > 21)
+        nal_length_size = (extradata[21] & 3) + 1;
+    }
   }
+  last_sample_time = -1;
   av_log(video_dec_ctx, AV_LOG_INFO,
          "openDec video_stream_idx = %d, pix_fmt = %d\n", video_stream_idx,
          pix_fmt);
@@ -652,6 +693,29 @@ void VideoDecFFM::reConnectVideoStream() {
   }
 }
 
+AVFrame* VideoDecFFM::tryReconnect(int& eof) {
+  auto now = std::chrono::steady_clock::now();
+  if (reconnecting && now < reconnect_due) return NULL;
+  if (!reconnecting) IVS_INFO("grabFrame failed! Try to reconnect...");
+  reconnecting = true;
+  // 与reConnectVideoStream一致，失败后等待3s再重连
+  reconnect_due = now + std::chrono::seconds(3);
+
+  this->closeDec();
+  // 由于ctrl+C取消推流时会返回EOF，导致stream直接结束，所以重连期间不上报eof
+  eof = 0;
+  if (this->openDec(handle, inputUrl.c_str()) < 0) return NULL;
+  would_block = false;
+  AVFrame* avframe = grabFrame(eof);
+  eof = 0;
+  // 连接成功但还没有数据时，之后按正常的非阻塞读包处理
+  if (avframe || would_block) {
+    reconnecting = false;
+    IVS_INFO("Successfully reconnected, now continue...");
+  }
+  return avframe;
+}
+
 int VideoDecFFM::isNetworkError(int ret) {
   int errCode = AVERROR(ret);
   char errbuf[AV_ERROR_MAX_STRING_SIZE];
@@ -688,6 +752,10 @@ AVFrame* VideoDecFFM::grabFrame(int& eof) {
     ret = av_read_frame(ifmt_ctx, pkt);
     if (ret < 0) {
       if (ret == AVERROR(EAGAIN)) {
+        if (ifmt_ctx->flags & AVFMT_FLAG_NONBLOCK) {
+          would_block = true;
+          return NULL;
+        }
         gettimeofday(&tv2, NULL);
         if (((tv2.tv_sec - tv1.tv_sec) * 1000 +
              (tv2.tv_usec - tv1.tv_usec) / 1000) > 1000 * 60) {
@@ -717,6 +785,10 @@ AVFrame* VideoDecFFM::grabFrame(int& eof) {
       continue;
     }
 
+    if (skipPacket(pkt)) {
+      continue;
+    }
+
     if (!frame) {
       av_log(video_dec_ctx, AV_LOG_ERROR, "Could not allocate frame\n");
       return NULL;
@@ -742,6 +814,10 @@ AVFrame* VideoDecFFM::grabFrame(int& eof) {
     width = video_dec_ctx->width;
     height = video_dec_ctx->height;
     pix_fmt = video_dec_ctx->pix_fmt;
+    if (sample_period_ms > 0 && !isSampleDue(frame)) {
+      continue;
+    }
+
     if (frame->width != width || frame->height != height ||
         frame->format != pix_fmt) {
       av_log(video_dec_ctx, AV_LOG_ERROR,
@@ -764,21 +840,27 @@ AVFrame* VideoDecFFM::grabFrame(int& eof) {
 std::shared_ptr<bm_image> VideoDecFFM::grab(int& frameId, int& eof,
                                             int64_t& pts, int sampleInterval,
                                             sampleStrategy strategy) {
+  DecodeStateScope stateScope(channel_hardware_decode,
+                              channel_data_on_device_mem);
   // 控制帧率
-  if (fps != -1) {
-    gettimeofday(&current_time, NULL);
-    double time_delta =
-        1000 * ((current_time.tv_sec - last_time.tv_sec) +
-                (double)(current_time.tv_usec - last_time.tv_usec) / 1000000.0);
-    int time_to_sleep = frame_interval_time - time_delta;
-    if (time_to_sleep > 0)
-      std::this_thread::sleep_for(std::chrono::milliseconds(time_to_sleep));
-    gettimeofday(&last_time, NULL);
-  }
+  waitFrameInterval();
   std::shared_ptr<bm_image> spBmImage = nullptr;
-  AVFrame* avframe = grabFrame(eof);
+  would_block = false;
+  AVFrame* avframe = NULL;
+  if (!reconnecting) {
+    avframe = grabFrame(eof);
+    if (!avframe && would_block) return spBmImage;
+  }
+  bool network = this->is_rtsp || this->is_rtmp || this->is_gb28181;
+  if (!avframe && network && external_pacing) {
+    avframe = tryReconnect(eof);
+    if (!avframe) {
+      would_block = true;
+      return spBmImage;
+    }
+  }
   // 没有取到avframe，尝试重连
-  if ((!avframe) && (this->is_rtsp || this->is_rtmp || this->is_gb28181)) {
+  if ((!avframe) && network) {
     // 第一个while，关闭并重新访问url。如果失败，则再次尝试
     while (1) {
       IVS_INFO("grabFrame failed! Try to reconnect...");
@@ -848,17 +930,10 @@ bool is_bmp(const char* filename) {
 
 std::shared_ptr<bm_image> VideoDecFFM::picDec(bm_handle_t& handle,
                                               const char* path) {
+  DecodeStateScope stateScope(channel_hardware_decode,
+                              channel_data_on_device_mem);
   // 控制帧率
-  if (fps != -1) {
-    gettimeofday(&current_time, NULL);
-    double time_delta =
-        1000 * ((current_time.tv_sec - last_time.tv_sec) +
-                (double)(current_time.tv_usec - last_time.tv_usec) / 1000000.0);
-    int time_to_sleep = frame_interval_time - time_delta;
-    if (time_to_sleep > 0)
-      std::this_thread::sleep_for(std::chrono::milliseconds(time_to_sleep));
-    gettimeofday(&last_time, NULL);
-  }
+  waitFrameInterval();
 
   string input_name = path;
   if (is_jpg(path)) {
@@ -873,20 +948,50 @@ std::shared_ptr<bm_image> VideoDecFFM::picDec(bm_handle_t& handle,
   }
 }
 
+bool readPicFile(const std::string& path, std::vector<uint8_t>& buffer) {
+  std::ifstream file(path, std::ios::binary | std::ios::ate);
+  if (!file) {
+    fprintf(stderr, "open file %s failed\n", path.c_str());
+    return false;
+  }
+  std::streamsize size = file.tellg();
+  file.seekg(0, std::ios::beg);
+  // ffmpeg的解析器可能越过数据末尾读取，末尾补零
+  buffer.assign(size + AV_INPUT_BUFFER_PADDING_SIZE, 0);
+  return size > 0 && file.read(reinterpret_cast<char*>(buffer.data()), size);
+}
+
+std::shared_ptr<bm_image> picDec(bm_handle_t& handle, uint8_t* data,
+                                 int size) {
+  // 每张图像都按解码线程的初始状态处理，与之前在该线程上解码过的图像无关
+  hardware_decode = true;
+  data_on_device_mem = true;
+  if (size >= 3 && data[0] == 0xFF && data[1] == 0xD8 && data[2] == 0xFF) {
+    return jpgDec(handle, data, size);
+  } else if (size >= 8 &&
+             !std::memcmp(data, "\x89\x50\x4E\x47\x0D\x0A\x1A\x0A", 8)) {
+    return pngDec(handle, data, size);
+  } else if (size >= 2 && data[0] == 'B' && data[1] == 'M') {
+    return bmpDec(handle, data, size);
+  }
+  return nullptr;
+}
+
 std::shared_ptr<bm_image> bmpDec(bm_handle_t& handle, string input_name) {
+  std::vector<uint8_t> buffer;
+  if (!readPicFile(input_name, buffer)) return nullptr;
+  return bmpDec(handle, buffer.data(),
+                buffer.size() - AV_INPUT_BUFFER_PADDING_SIZE);
+}
+
+std::shared_ptr<bm_image> bmpDec(bm_handle_t& handle, uint8_t* bs_buffer,
+                                int numBytes) {
   std::shared_ptr<bm_image> spBmImage = nullptr;
   spBmImage.reset(new bm_image, [](bm_image* p) {
     bm_image_destroy(*p);
     delete p;
     p = nullptr;
   });
-  FILE* infile = fopen(input_name.c_str(), "rb+");
-  fseek(infile, 0, SEEK_END);
-  int numBytes = ftell(infile);
-  fseek(infile, 0, SEEK_SET);
-  uint8_t* bs_buffer = (uint8_t*)av_malloc(numBytes);
-  fread(bs_buffer, sizeof(uint8_t), numBytes, infile);
-  fclose(infile);
 
   const AVCodec* codec;
   AVCodecContext* dec_ctx = NULL;
@@ -944,14 +1049,12 @@ std::shared_ptr<bm_image> bmpDec(bm_handle_t& handle, string input_name) {
 
     data_on_device_mem = false;
     avframe_to_bm_image(handle, frame, spBmImage.get(), false);
-    free(bs_buffer);
     avcodec_free_context(&dec_ctx);
     av_frame_free(&frame);
     av_packet_free(&pkt);
     return spBmImage;
   } else {
     fprintf(stderr, "Error decode bmp, can not read file size\n");
-    free(bs_buffer);
     avcodec_free_context(&dec_ctx);
     av_frame_free(&frame);
     av_packet_free(&pkt);
@@ -960,19 +1063,20 @@ std::shared_ptr<bm_image> bmpDec(bm_handle_t& handle, string input_name) {
 }
 
 std::shared_ptr<bm_image> pngDec(bm_handle_t& handle, string input_name) {
+  std::vector<uint8_t> buffer;
+  if (!readPicFile(input_name, buffer)) return nullptr;
+  return pngDec(handle, buffer.data(),
+                buffer.size() - AV_INPUT_BUFFER_PADDING_SIZE);
+}
+
+std::shared_ptr<bm_image> pngDec(bm_handle_t& handle, uint8_t* bs_buffer,
+                                int numBytes) {
   std::shared_ptr<bm_image> spBmImage = nullptr;
   spBmImage.reset(new bm_image, [](bm_image* p) {
     bm_image_destroy(*p);
     delete p;
     p = nullptr;
   });
-  FILE* infile = fopen(input_name.c_str(), "rb+");
-  fseek(infile, 0, SEEK_END);
-  int numBytes = ftell(infile);
-  fseek(infile, 0, SEEK_SET);
-  uint8_t* bs_buffer = (uint8_t*)av_malloc(numBytes);
-  fread(bs_buffer, sizeof(uint8_t), numBytes, infile);
-  fclose(infile);
 
   const AVCodec* codec;
   AVCodecContext* dec_ctx = NULL;
@@ -1031,14 +1135,12 @@ std::shared_ptr<bm_image> pngDec(bm_handle_t& handle, string input_name) {
     data_on_device_mem = false;
 
     avframe_to_bm_image(handle, frame, spBmImage.get(), false);
-    free(bs_buffer);
     avcodec_free_context(&dec_ctx);
     av_frame_free(&frame);
     av_packet_free(&pkt);
     return spBmImage;
   } else {
     fprintf(stderr, "Error decode png, can not read file size\n");
-    free(bs_buffer);
     avcodec_free_context(&dec_ctx);
     av_frame_free(&frame);
     av_packet_free(&pkt);
@@ -1081,6 +1183,14 @@ std::shared_ptr<bm_image> pngDec(bm_handle_t& handle, string input_name) {
 // }
 
 std::shared_ptr<bm_image> jpgDec(bm_handle_t& handle, string input_name) {
+  std::vector<uint8_t> buffer;
+  if (!readPicFile(input_name, buffer)) return nullptr;
+  return jpgDec(handle, buffer.data(),
+                buffer.size() - AV_INPUT_BUFFER_PADDING_SIZE);
+}
+
+std::shared_ptr<bm_image> jpgDec(bm_handle_t& handle, uint8_t* bs_buffer,
+                                 int numBytes) {
   std::shared_ptr<bm_image> spBmImage = nullptr;
   spBmImage.reset(new bm_image, [](bm_image* p) {
     bm_image_destroy(*p);
@@ -1098,39 +1208,14 @@ std::shared_ptr<bm_image> jpgDec(bm_handle_t& handle, string input_name) {
   AVPacket pkt;
 
   int got_picture;
-  FILE* infile;
-  int numBytes;
 
   uint8_t* aviobuffer = nullptr;
   int aviobuf_size = 32 * 1024;  // 32K
-  uint8_t* bs_buffer = nullptr;
   int bs_size;
   bs_buffer_t bs_obj = {0, 0, 0};
   int tmp = 0;
   bm_status_t ret;
 
-  infile = fopen(input_name.c_str(), "rb+");
-  if (infile == nullptr) {
-    cerr << "open file1 failed" << endl;
-    goto Func_Exit;
-  }
-
-  fseek(infile, 0, SEEK_END);
-  numBytes = ftell(infile);
-  // cout << "infile size: " << numBytes << endl;
-  fseek(infile, 0, SEEK_SET);
-
-  bs_buffer = (uint8_t*)av_malloc(numBytes);
-  if (bs_buffer == nullptr) {
-    cerr << "av malloc for bs buffer failed" << endl;
-    ret = BM_ERR_FAILURE;
-    goto Func_Exit;
-  }
-
-  fread(bs_buffer, sizeof(uint8_t), numBytes, infile);
-  fclose(infile);
-  infile = nullptr;
-
   hardware_decode = determine_hardware_decode(bs_buffer);
 
   aviobuffer = (uint8_t*)av_malloc(aviobuf_size);  // 32k
@@ -1268,10 +1353,6 @@ Func_Exit:
     av_freep(&avio_ctx);
   }
 
-  if (infile) {
-    fclose(infile);
-  }
-
   if (dict) {
     av_dict_free(&dict);
   }
@@ -1279,9 +1360,6 @@ Func_Exit:
   if (dec_ctx) {
     avcodec_free_context(&dec_ctx);
   }
-  if (bs_buffer) {
-    av_free(bs_buffer);
-  }
   return spBmImage;  // TODO
 }
 
@@ -1289,3 +1367,103 @@ void VideoDecFFM::setFps(int f) {
   fps = f;
   frame_interval_time = 1 / fps * 1000;
 }
+
+void VideoDecFFM::setExternalPacing(bool external) {
+  external_pacing = external;
+}
+
+double VideoDecFFM::getFrameInterval() const {
+  return fps == -1 ? 0 : std::max(frame_interval_time, sample_period_ms);
+}
+
+void VideoDecFFM::waitFrameInterval() {
+  if (fps == -1 || external_pacing) return;
+  gettimeofday(&current_time, NULL);
+  double time_delta =
+      1000 * ((current_time.tv_sec - last_time.tv_sec) +
+              (double)(current_time.tv_usec - last_time.tv_usec) / 1000000.0);
+  int time_to_sleep = getFrameInterval() - time_delta;
+  if (time_to_sleep > 0)
+    std::this_thread::sleep_for(std::chrono::milliseconds(time_to_sleep));
+  gettimeofday(&last_time, NULL);
+}
+
+void VideoDecFFM::setDecodeMode(decodeMode mode, double samplePeriodMs) {
+  decode_mode = mode;
+  sample_period_ms = samplePeriodMs;
+}
+
+bool VideoDecFFM::skipPacket(const AVPacket* packet) const {
+  if (decode_mode == decodeMode::KEYFRAME)
+    return !(packet->flags & AV_PKT_FLAG_KEY);
+  if (sample_period_ms > 0) return isNonReferencePacket(packet);
+  return false;
+}
+
+bool VideoDecFFM::isNonReferencePacket(const AVPacket* packet) const {
+  bool is_h264 = video_dec_par->codec_id == AV_CODEC_ID_H264;
+  bool is_hevc = video_dec_par->codec_id == AV_CODEC_ID_HEVC;
+  if (!is_h264 && !is_hevc) return false;
+
+  const uint8_t* data = packet->data;
+  int size = packet->size;
+  int pos = 0;
+  bool has_picture = false;
+  while (pos < size) {
+    int nal_start = 0;
+    if (nal_length_size > 0) {
+      if (pos + nal_length_size > size) break;
+      int nal_size = 0;
+      for (int i = 0; i < nal_length_size; ++i)
+        nal_size = (nal_size << 8) | data[pos + i];
+      nal_start = pos + nal_length_size;
+      pos = nal_start + nal_size;
+    } else {
+      // 跳到下一个00 00 01起始码之后
+      while (pos + 2 < size &&
+             !(data[pos] == 0 && data[pos + 1] == 0 && data[pos + 2] == 1))
+        ++pos;
+      nal_start = pos + 3;
+      pos = nal_start;
+    }
+    if (nal_start + 1 >= size) break;
+
+    uint8_t header = data[nal_start];
+    if (is_h264) {
+      int nal_type = header & 0x1f;
+      if (nal_type < 1 || nal_type > 5) continue;
+      has_picture = true;
+      // nal_ref_idc不为0的图像会被参考
+      if (header & 0x60) return false;
+    } else {
+      int nal_type = (header >> 1) & 0x3f;
+      if (nal_type > 31) continue;
+      has_picture = true;
+      // 低时域层不会参考高时域层，TemporalId大于0的图像全部丢弃后，
+      // 第0层中的子层非参考图像(类型为不大于14的偶数)也不再被参考
+      int temporal_id = (data[nal_start + 1] & 0x7) - 1;
+      if (temporal_id == 0 && (nal_type > 14 || nal_type % 2 == 1))
+        return false;
+    }
+  }
+  return has_picture;
+}
+
+bool VideoDecFFM::isSampleDue(const AVFrame* avframe) {
+  double sample_time;
+  if (avframe->best_effort_timestamp != AV_NOPTS_VALUE) {
+    sample_time =
+        avframe->best_effort_timestamp *
+        av_q2d(ifmt_ctx->streams[video_stream_idx]->time_base) * 1000;
+  } else {
+    struct timeval now;
+    gettimeofday(&now, NULL);
+    sample_time = now.tv_sec * 1000.0 + now.tv_usec / 1000.0;
+  }
+  // 时间戳回退(循环播放或者码流重置)时直接输出
+  if (last_sample_time >= 0 && sample_time >= last_sample_time &&
+      sample_time - last_sample_time < sample_period_ms)
+    return false;
+  last_sample_time = sample_time;
+  return true;
+}
@@ -0,0 +1,380 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#include "image_prefetcher.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/prctl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <random>
+
+#include "common/logger.h"
+
+namespace sophon_stream {
+namespace element {
+namespace decode {
+
+namespace {
+
+bool endsWith(const std::string& s, const std::string& suffix) {
+  return s.size() >= suffix.size() &&
+         0 == s.compare(s.size() - suffix.size(), suffix.size(), suffix);
+}
+
+bool isImagePath(const std::string& path) {
+  auto index = path.rfind('.');
+  if (index == std::string::npos) return false;
+  std::string postfix = path.substr(index + 1);
+  std::transform(postfix.begin(), postfix.end(), postfix.begin(), ::tolower);
+  return postfix == "jpg" || postfix == "jpeg" || postfix == "png" ||
+         postfix == "bmp";
+}
+
+void listDir(const std::string& path, std::vector<std::string>& files) {
+  DIR* dir = opendir(path.c_str());
+  if (dir == NULL) {
+    IVS_ERROR("Open image dir failed, path: {0}", path);
+    return;
+  }
+  struct dirent* ptr;
+  while ((ptr = readdir(dir)) != NULL) {
+    if (std::strcmp(ptr->d_name, ".") == 0 ||
+        std::strcmp(ptr->d_name, "..") == 0)
+      continue;
+    std::string child = path + "/" + ptr->d_name;
+    if (ptr->d_type == DT_REG && isImagePath(child))
+      files.push_back(child);
+    else if (ptr->d_type == DT_DIR)
+      listDir(child, files);
+  }
+  closedir(dir);
+}
+
+// tar头中的数字为八进制字符串
+std::int64_t parseOctal(const char* p, int size) {
+  std::int64_t value = 0;
+  for (int i = 0; i < size && p[i]; ++i) {
+    if (p[i] < '0' || p[i] > '7') continue;
+    value = value * 8 + (p[i] - '0');
+  }
+  return value;
+}
+
+constexpr int kTarBlock = 512;
+
+}  // namespace
+
+bool ImagePrefetcher::isManifest(const std::string& url) {
+  return endsWith(url, ".txt") || endsWith(url, ".lst");
+}
+
+bool ImagePrefetcher::isTar(const std::string& url) {
+  return endsWith(url, ".tar");
+}
+
+common::ErrorCode ImagePrefetcher::start(const std::string& url,
+                                         const Options& options, int loopNum,
+                                         bm_handle_t handle) {
+  mOptions = options;
+  mOptions.depth = std::max(1, mOptions.depth);
+  mOptions.ioThreads = std::max(1, mOptions.ioThreads);
+  mOptions.decodeThreads = std::max(1, mOptions.decodeThreads);
+  mOptions.checkpointInterval = std::max(1, mOptions.checkpointInterval);
+  mHandle = handle;
+  if (mOptions.shardCount < 1 || mOptions.shardIndex < 0 ||
+      mOptions.shardIndex >= mOptions.shardCount) {
+    IVS_ERROR("Invalid image shard {0}/{1}", mOptions.shardIndex,
+              mOptions.shardCount);
+    return common::ErrorCode::PARAMETER_ERROR;
+  }
+
+  common::ErrorCode errorCode = listEntries(url);
+  if (common::ErrorCode::SUCCESS != errorCode) return errorCode;
+  arrangeEntries();
+  if (mEntries.empty()) {
+    IVS_ERROR("No image found in {0}, shard {1}/{2}", url, mOptions.shardIndex,
+              mOptions.shardCount);
+    return common::ErrorCode::PARAMETER_ERROR;
+  }
+
+  mTotal = static_cast<std::int64_t>(mEntries.size()) * std::max(1, loopNum);
+  loadProgress();
+  mNextRead = mNextOutput = mLastSaved = mStartIndex;
+  mSlots.assign(mOptions.depth, Slot());
+  mReadIndexes.clear();
+
+  mStop = false;
+  for (int i = 0; i < mOptions.ioThreads; ++i)
+    mThreads.emplace_back(&ImagePrefetcher::ioLoop, this);
+  for (int i = 0; i < mOptions.decodeThreads; ++i)
+    mThreads.emplace_back(&ImagePrefetcher::decodeLoop, this);
+  IVS_INFO(
+      "Image prefetcher start, images: {0}, start index: {1}, depth: {2}, io "
+      "threads: {3}, decode threads: {4}",
+      mEntries.size(), mStartIndex, mOptions.depth, mOptions.ioThreads,
+      mOptions.decodeThreads);
+  return common::ErrorCode::SUCCESS;
+}
+
+void ImagePrefetcher::stop() {
+  bool running = false;
+  {
+    std::lock_guard<std::mutex> lk(mMutex);
+    running = !mStop;
+    mStop = true;
+  }
+  if (running) {
+    mCv.notify_all();
+    for (auto& thread : mThreads) thread.join();
+    mThreads.clear();
+    saveProgress(mNextOutput);
+    mSlots.clear();
+  }
+  // start失败时也可能已经打开了tar包
+  if (mTarFd >= 0) {
+    ::close(mTarFd);
+    mTarFd = -1;
+  }
+}
+
+bool ImagePrefetcher::next(std::shared_ptr<bm_image>& image,
+                           std::int64_t& index) {
+  std::int64_t checkpoint = -1;
+  {
+    std::unique_lock<std::mutex> lk(mMutex);
+    while (true) {
+      if (mStop || mNextOutput >= mTotal) return false;
+      Slot& slot = mSlots[mNextOutput % mOptions.depth];
+      mCv.wait(lk, [&] {
+        return mStop ||
+               (slot.index == mNextOutput && slot.state == SlotState::READY);
+      });
+      if (mStop) return false;
+
+      image = std::move(slot.image);
+      index = mNextOutput++;
+      slot.image = nullptr;
+      slot.state = SlotState::EMPTY;
+      mCv.notify_all();
+      if (mNextOutput - mLastSaved >= mOptions.checkpointInterval) {
+        mLastSaved = mNextOutput;
+        checkpoint = mNextOutput;
+      }
+      if (image != nullptr) break;
+      IVS_WARN("Skip image that can not be read or decoded: {0}",
+               mEntries[index % mEntries.size()].path);
+    }
+  }
+  if (checkpoint >= 0) saveProgress(checkpoint);
+  return true;
+}
+
+common::ErrorCode ImagePrefetcher::listEntries(const std::string& url) {
+  mEntries.clear();
+  if (isTar(url)) return listTar(url);
+
+  std::vector<std::string> files;
+  if (isManifest(url)) {
+    std::ifstream manifest(url);
+    if (!manifest) {
+      IVS_ERROR("Open image manifest failed, path: {0}", url);
+      return common::ErrorCode::PARAMETER_ERROR;
+    }
+    auto slash = url.rfind('/');
+    std::string base = slash == std::string::npos ? "" : url.substr(0, slash);
+    std::string line;
+    while (std::getline(manifest, line)) {
+      while (!line.empty() && (line.back() == '\r' || line.back() == ' '))
+        line.pop_back();
+      if (line.empty() || line[0] == '#') continue;
+      files.push_back(line[0] == '/' || base.empty() ? line
+                                                     : base + "/" + line);
+    }
+  } else {
+    listDir(url, files);
+  }
+  for (auto& file : files) {
+    Entry entry;
+    entry.path = std::move(file);
+    mEntries.push_back(std::move(entry));
+  }
+  return common::ErrorCode::SUCCESS;
+}
+
+common::ErrorCode ImagePrefetcher::listTar(const std::string& url) {
+  mTarFd = ::open(url.c_str(), O_RDONLY);
+  if (mTarFd < 0) {
+    IVS_ERROR("Open image tar failed, path: {0}", url);
+    return common::ErrorCode::PARAMETER_ERROR;
+  }
+
+  char header[kTarBlock];
+  std::int64_t offset = 0;
+  std::string longName;
+  while (kTarBlock == ::pread(mTarFd, header, kTarBlock, offset)) {
+    // 全0的块表示结束
+    if (header[0] == '\0') break;
+    std::int64_t size = parseOctal(header + 124, 12);
+    char type = header[156];
+    std::int64_t dataOffset = offset + kTarBlock;
+    offset = dataOffset + (size + kTarBlock - 1) / kTarBlock * kTarBlock;
+
+    // GNU长文件名，数据块中是下一个记录的文件名
+    if (type == 'L') {
+      longName.assign(size, '\0');
+      if (size != ::pread(mTarFd, &longName[0], size, dataOffset)) break;
+      longName = longName.c_str();
+      continue;
+    }
+    if (type != '0' && type != '\0') {
+      longName.clear();
+      continue;
+    }
+
+    std::string name = longName;
+    longName.clear();
+    if (name.empty()) {
+      name.assign(header, strnlen(header, 100));
+      // ustar的文件名前缀
+      if (0 == std::memcmp(header + 257, "ustar", 5) && header[345]) {
+        name = std::string(header + 345, strnlen(header + 345, 155)) + "/" +
+               name;
+      }
+    }
+    if (!isImagePath(name)) continue;
+    Entry entry;
+    entry.path = name;
+    entry.offset = dataOffset;
+    entry.size = size;
+    mEntries.push_back(std::move(entry));
+  }
+  return common::ErrorCode::SUCCESS;
+}
+
+void ImagePrefetcher::arrangeEntries() {
+  std::sort(mEntries.begin(), mEntries.end(),
+            [](const Entry& a, const Entry& b) { return a.path < b.path; });
+  if (mOptions.shardCount > 1) {
+    std::vector<Entry> shard;
+    for (std::size_t i = mOptions.shardIndex; i < mEntries.size();
+         i += mOptions.shardCount)
+      shard.push_back(std::move(mEntries[i]));
+    mEntries.swap(shard);
+  }
+  if (mOptions.shuffle) {
+    std::mt19937 engine(mOptions.seed);
+    std::shuffle(mEntries.begin(), mEntries.end(), engine);
+  }
+}
+
+void ImagePrefetcher::loadProgress() {
+  mStartIndex = 0;
+  if (mOptions.progressFile.empty()) return;
+  std::ifstream file(mOptions.progressFile);
+  std::int64_t nextIndex = 0;
+  std::size_t count = 0;
+  if (!(file >> nextIndex >> count)) return;
+  // 列表不同时序号没有意义，从头开始
+  if (count != mEntries.size()) {
+    IVS_WARN(
+        "Image count {0} differs from {1} in progress file {2}, start from "
+        "the beginning",
+        mEntries.size(), count, mOptions.progressFile);
+    return;
+  }
+  mStartIndex = std::min(std::max<std::int64_t>(nextIndex, 0), mTotal);
+}
+
+void ImagePrefetcher::saveProgress(std::int64_t nextIndex) {
+  if (mOptions.progressFile.empty()) return;
+  std::string tmpPath = mOptions.progressFile + ".tmp";
+  {
+    std::ofstream file(tmpPath, std::ios::trunc);
+    file << nextIndex << " " << mEntries.size() << "\n";
+    if (!file) {
+      IVS_WARN("Write progress file failed, path: {0}", tmpPath);
+      return;
+    }
+  }
+  std::rename(tmpPath.c_str(), mOptions.progressFile.c_str());
+}
+
+bool ImagePrefetcher::readEntry(const Entry& entry,
+                                std::vector<uint8_t>& data) {
+  if (entry.offset < 0) return readPicFile(entry.path, data);
+  data.assign(entry.size + AV_INPUT_BUFFER_PADDING_SIZE, 0);
+  return entry.size > 0 &&
+         entry.size == ::pread(mTarFd, data.data(), entry.size, entry.offset);
+}
+
+void ImagePrefetcher::ioLoop() {
+  prctl(PR_SET_NAME, "image_io");
+  std::unique_lock<std::mutex> lk(mMutex);
+  while (true) {
+    mCv.wait(lk, [this] {
+      return mStop || (mNextRead < mTotal &&
+                       mNextRead < mNextOutput + mOptions.depth);
+    });
+    if (mStop) return;
+    std::int64_t index = mNextRead++;
+    Slot& slot = mSlots[index % mOptions.depth];
+    slot.index = index;
+    slot.state = SlotState::READING;
+    const Entry& entry = mEntries[index % mEntries.size()];
+
+    lk.unlock();
+    std::vector<uint8_t> data;
+    bool ok = readEntry(entry, data);
+    lk.lock();
+
+    if (ok) {
+      slot.data.swap(data);
+      slot.state = SlotState::READ;
+      mReadIndexes.insert(index);
+    } else {
+      // 读取失败的图像直接交给next跳过
+      slot.state = SlotState::READY;
+    }
+    mCv.notify_all();
+  }
+}
+
+void ImagePrefetcher::decodeLoop() {
+  prctl(PR_SET_NAME, "image_decode");
+  std::unique_lock<std::mutex> lk(mMutex);
+  while (true) {
+    mCv.wait(lk, [this] { return mStop || !mReadIndexes.empty(); });
+    if (mStop) return;
+    std::int64_t index = *mReadIndexes.begin();
+    mReadIndexes.erase(mReadIndexes.begin());
+    Slot& slot = mSlots[index % mOptions.depth];
+    slot.state = SlotState::DECODING;
+    std::vector<uint8_t> data;
+    data.swap(slot.data);
+
+    lk.unlock();
+    std::shared_ptr<bm_image> image = picDec(
+        mHandle, data.data(), data.size() - AV_INPUT_BUFFER_PADDING_SIZE);
+    lk.lock();
+
+    slot.image = image;
+    slot.state = SlotState::READY;
+    mCv.notify_all();
+  }
+}
+
+}  // namespace decode
+}  // namespace element
+}  // namespace sophon_stream
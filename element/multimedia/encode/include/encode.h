@@ -62,6 +62,11 @@ class Encode : public ::sophon_stream::framework::Element {
 
   common::ErrorCode doWork(int dataPipeId) override;
 
+  /**
+   * @brief 编码器要求同一通道的帧按顺序到达，通道不能在线程之间迁移
+   */
+  bool isChannelStateful() const override { return true; }
+
   static constexpr const char* CONFIG_INTERNAL_ENCODE_TYPE_FIELD =
       "encode_type";
   static constexpr const char* CONFIG_INTERNAL_RTSP_PORT_FIELD = "rtsp_port";
@@ -71,6 +76,19 @@ class Encode : public ::sophon_stream::framework::Element {
   static constexpr const char* CONFIG_INTERNAL_WSS_PORT_FIELD = "wss_port";
   static constexpr const char* CONFIG_INTERNAL_WSS_BACKEND = "wss_backend";
   static constexpr const char* CONFIG_INTERNAL_FPS_FIELD = "fps";
+  static constexpr const char* CONFIG_INTERNAL_BITRATE_FIELD = "bitrate";
+
+  // 输出速率控制，见output_rate_controller.h
+  static constexpr const char* CONFIG_INTERNAL_QUEUE_SIZE_FIELD = "queue_size";
+  static constexpr const char* CONFIG_INTERNAL_DROP_FRAMES_FIELD =
+      "drop_frames";
+  static constexpr const char* CONFIG_INTERNAL_TARGET_FPS_FIELD = "target_fps";
+  static constexpr const char* CONFIG_INTERNAL_ADAPTIVE_BITRATE_FIELD =
+      "adaptive_bitrate";
+  static constexpr const char* CONFIG_INTERNAL_MIN_BITRATE_FIELD =
+      "min_bitrate";
+  static constexpr const char* CONFIG_INTERNAL_RECONNECT_INTERVAL_FIELD =
+      "reconnect_interval_ms";
 
   // for customizing shape and ip
   static constexpr const char* CONFIG_INTERNAL_WIDTH_FIELD = "width";
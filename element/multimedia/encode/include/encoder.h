@@ -24,6 +24,7 @@
 #include <thread>
 
 #include "common/profiler.h"
+#include "output_rate_controller.h"
 
 extern "C" {
 #include <libavformat/avformat.h>
@@ -40,17 +41,26 @@ class Encoder {
  public:
   Encoder();
   Encoder(int dev_id, const std::string& enc_fmt, const std::string& pix_fmt,
-          const std::map<std::string, int>& enc_params, int channel_idx);
+          const std::map<std::string, int>& enc_params, int channel_idx,
+          const OutputRateOptions& rate_options = OutputRateOptions());
 
   ~Encoder();
 
   void set_output_path(const std::string& output_path);
   void set_enc_params_width(int width);
   void set_enc_params_height(int height);
+  /**
+   * @brief 请求连接输出，连接在写出线程中进行，不阻塞调用方
+   */
   void init_writer();
   bool is_opened();
 
-  int video_write(bm_image& image);
+  /**
+   * @brief 把帧交给写出线程编码和发送，输出跟不上时按OutputRateOptions丢帧
+   * @param[in] timestampUs : 帧时间戳，单位微秒，用于抽帧和计算pts
+   * @return 输出断开等待重连时返回-1
+   */
+  int video_write(std::shared_ptr<bm_image> image, std::int64_t timestampUs);
   void release();
 
  private:
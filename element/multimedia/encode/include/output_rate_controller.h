@@ -0,0 +1,186 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SOPHON_STREAM_ELEMENT_ENCODE_OUTPUT_RATE_CONTROLLER_H_
+#define SOPHON_STREAM_ELEMENT_ENCODE_OUTPUT_RATE_CONTROLLER_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+
+namespace sophon_stream {
+namespace element {
+namespace encode {
+
+/**
+ * @brief 编码输出的速率控制参数，对RTSP、RTMP、VIDEO生效
+ */
+struct OutputRateOptions {
+  // 等待编码的帧数上限
+  int queueSize = 2;
+  // 队列满时丢弃最旧的帧；为false时阻塞上游直到有空位，用于不能丢帧的文件输出
+  bool dropFrames = true;
+  // 大于0时按帧时间戳抽帧到该帧率，时间戳间隔小于1/targetFps的帧不编码
+  double targetFps = 0;
+  // 按实际发送速率调整码率，只对RTSP、VIDEO生效
+  // 上限为编码参数中的bitrate，qp不为-1时不生效
+  bool adaptiveBitrate = false;
+  int minBitrate = 500;  // kbps
+  int reconnectIntervalMs = 5000;
+};
+
+/**
+ * @brief 有界的帧队列，push不会因为输出慢而阻塞上游(dropFrames为false时除外)
+ */
+template <typename T>
+class BoundedFrameQueue {
+ public:
+  void configure(int capacity, bool dropOldest) {
+    std::lock_guard<std::mutex> lk(mMutex);
+    mCapacity = capacity > 0 ? capacity : 1;
+    mDropOldest = dropOldest;
+  }
+
+  /**
+   * @return 因为队列已满而丢弃的帧数，队列关闭后返回1表示item被丢弃
+   */
+  int push(T item) {
+    std::unique_lock<std::mutex> lk(mMutex);
+    if (!mDropOldest)
+      mNotFull.wait(lk, [this] {
+        return mClosed || static_cast<int>(mItems.size()) < mCapacity;
+      });
+    if (mClosed) return 1;
+    int dropped = 0;
+    while (static_cast<int>(mItems.size()) >= mCapacity) {
+      mItems.pop_front();
+      ++dropped;
+    }
+    mItems.push_back(std::move(item));
+    mDropped += dropped;
+    mNotEmpty.notify_one();
+    return dropped;
+  }
+
+  /**
+   * @brief 最多等待timeout，期间没有新帧或队列已关闭时返回false
+   */
+  template <typename Rep, typename Period>
+  bool pop(T& item, std::chrono::duration<Rep, Period> timeout) {
+    std::unique_lock<std::mutex> lk(mMutex);
+    if (!mNotEmpty.wait_for(lk, timeout,
+                            [this] { return mClosed || !mItems.empty(); }))
+      return false;
+    if (mItems.empty()) return false;
+    item = std::move(mItems.front());
+    mItems.pop_front();
+    mNotFull.notify_one();
+    return true;
+  }
+
+  // 返回清掉的帧数
+  int clear() {
+    std::lock_guard<std::mutex> lk(mMutex);
+    int n = static_cast<int>(mItems.size());
+    mItems.clear();
+    mDropped += n;
+    mNotFull.notify_all();
+    return n;
+  }
+
+  void close() {
+    std::lock_guard<std::mutex> lk(mMutex);
+    mClosed = true;
+    mNotEmpty.notify_all();
+    mNotFull.notify_all();
+  }
+
+  // 取出上次调用以来丢弃的帧数
+  std::int64_t takeDropped() {
+    std::lock_guard<std::mutex> lk(mMutex);
+    std::int64_t n = mDropped;
+    mDropped = 0;
+    return n;
+  }
+
+ private:
+  std::deque<T> mItems;
+  int mCapacity = 1;
+  bool mDropOldest = true;
+  bool mClosed = false;
+  std::int64_t mDropped = 0;
+  std::mutex mMutex;
+  std::condition_variable mNotEmpty;
+  std::condition_variable mNotFull;
+};
+
+/**
+ * @brief 按帧时间戳抽帧到目标帧率，不依赖到达时间和sleep
+ */
+class FramePacer {
+ public:
+  void setTargetFps(double fps);
+  /**
+   * @param[in] timestampUs : 帧时间戳，单位微秒
+   * @return 该帧是否需要编码
+   */
+  bool accept(std::int64_t timestampUs);
+  void reset() { mStarted = false; }
+
+ private:
+  std::int64_t mPeriodUs = 0;
+  std::int64_t mNextUs = 0;
+  bool mStarted = false;
+};
+
+/**
+ * @brief 按统计窗口内的发送速率和丢帧情况调整码率
+ * @brief
+ * 写出线程在一个窗口内忙碌的比例超过90%，或超过50%且有丢帧时视为拥塞，把码率降到实测发送速率的90%且不超过
+ * 当前码率的85%；连续3个窗口忙碌比例低于50%且没有丢帧时，每个窗口把码率提高10%，直到配置的码率
+ */
+class BitrateAdapter {
+ public:
+  void configure(int maxKbps, int minKbps);
+  int bitrate() const { return mCurrentKbps; }
+
+  /**
+   * @param[in] bytes : 写出的字节数
+   * @param[in] writeUs : 写出耗时，单位微秒
+   */
+  void onWrite(std::int64_t bytes, std::int64_t writeUs);
+  void onDrop(std::int64_t frames) { mDropped += frames; }
+
+  /**
+   * @brief 窗口结束时更新码率
+   * @return 码率有变化时返回true，新码率用bitrate()取出
+   */
+  bool update(std::int64_t nowUs);
+
+ private:
+  static constexpr std::int64_t kWindowUs = 1000000;
+  static constexpr int kRaiseWindows = 3;
+
+  int mMaxKbps = 0;
+  int mMinKbps = 0;
+  int mCurrentKbps = 0;
+  std::int64_t mWindowStartUs = -1;
+  std::int64_t mBytes = 0;
+  std::int64_t mBusyUs = 0;
+  std::int64_t mDropped = 0;
+  int mHealthyWindows = 0;
+};
+
+}  // namespace encode
+}  // namespace element
+}  // namespace sophon_stream
+
+#endif  // SOPHON_STREAM_ELEMENT_ENCODE_OUTPUT_RATE_CONTROLLER_H_
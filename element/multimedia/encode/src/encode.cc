@@ -175,6 +175,38 @@ common::ErrorCode Encode::initInternal(const std::string& json) {
 
       std::map<std::string, int> mEncodeParams;
       mEncodeParams["framerate"] = mFps;
+      auto bitrateIt = configure.find(CONFIG_INTERNAL_BITRATE_FIELD);
+      if (configure.end() != bitrateIt)
+        mEncodeParams["bitrate"] = bitrateIt->get<int>();
+
+      // 网络流默认在输出跟不上时丢弃旧帧，本地文件默认不丢帧
+      OutputRateOptions rateOptions;
+      rateOptions.dropFrames = mEncodeType != EncodeType::VIDEO;
+      auto queueSizeIt = configure.find(CONFIG_INTERNAL_QUEUE_SIZE_FIELD);
+      if (configure.end() != queueSizeIt)
+        rateOptions.queueSize = queueSizeIt->get<int>();
+      auto dropFramesIt = configure.find(CONFIG_INTERNAL_DROP_FRAMES_FIELD);
+      if (configure.end() != dropFramesIt)
+        rateOptions.dropFrames = dropFramesIt->get<bool>();
+      auto targetFpsIt = configure.find(CONFIG_INTERNAL_TARGET_FPS_FIELD);
+      if (configure.end() != targetFpsIt)
+        rateOptions.targetFps = targetFpsIt->get<double>();
+      auto adaptiveIt = configure.find(CONFIG_INTERNAL_ADAPTIVE_BITRATE_FIELD);
+      if (configure.end() != adaptiveIt)
+        rateOptions.adaptiveBitrate = adaptiveIt->get<bool>();
+      auto minBitrateIt = configure.find(CONFIG_INTERNAL_MIN_BITRATE_FIELD);
+      if (configure.end() != minBitrateIt)
+        rateOptions.minBitrate = minBitrateIt->get<int>();
+      auto reconnectIt =
+          configure.find(CONFIG_INTERNAL_RECONNECT_INTERVAL_FIELD);
+      if (configure.end() != reconnectIt)
+        rateOptions.reconnectIntervalMs = reconnectIt->get<int>();
+      if (rateOptions.queueSize <= 0 || rateOptions.targetFps < 0 ||
+          rateOptions.minBitrate <= 0 || rateOptions.reconnectIntervalMs < 0) {
+        errorCode = common::ErrorCode::PARSE_CONFIGURE_FAIL;
+        IVS_ERROR("Invalid output rate control configure, json: {0}", json);
+        break;
+      }
 
       int dev_id = getDeviceId();
       // bm_dev_request(&m_handle, dev_id);
@@ -182,7 +214,8 @@ common::ErrorCode Encode::initInternal(const std::string& json) {
       int threadNumber = getThreadNumber();
       for (int i = 0; i < threadNumber; ++i) {
         mEncoderMap[i] =
-            std::make_shared<Encoder>(dev_id, encFmt, pixFmt, mEncodeParams, i);
+            std::make_shared<Encoder>(dev_id, encFmt, pixFmt, mEncodeParams, i,
+                                      rateOptions);
       }
     } else if (mEncodeType == EncodeType::IMG_DIR) {
       const char* dir_path = "./results";
@@ -286,7 +319,8 @@ common::ErrorCode Encode::doWork(int dataPipeId) {
   int outDataPipeId =
       getSinkElementFlag()
           ? 0
-          : (channel_id_internal % getOutputConnectorCapacity(outputPort));
+          : getOutputDataPipeId(outputPort, channel_id_internal,
+                                objectMetadata->mFrame->mEndOfStream);
   errorCode = pushOutputData(outputPort, outDataPipeId, objectMetadata);
   if (common::ErrorCode::SUCCESS != errorCode) {
     IVS_WARN(
@@ -345,10 +379,18 @@ void Encode::processVideoStream(
           height == -1 ? objectMetadata->mFrame->mHeight : height);
       encodeIt->second->init_writer();
     }
+    // 抽帧和pts按帧时间戳计算，没有时间戳的帧用到达时间代替
+    std::int64_t timestamp = objectMetadata->mFrame->mTimestamp;
+    if (timestamp <= 0)
+      timestamp = std::chrono::duration_cast<std::chrono::microseconds>(
+                      std::chrono::system_clock::now().time_since_epoch())
+                      .count();
     if (objectMetadata->mFrame->mSpDataOsd) {
-      encodeIt->second->video_write(*(objectMetadata->mFrame->mSpDataOsd));
+      encodeIt->second->video_write(objectMetadata->mFrame->mSpDataOsd,
+                                    timestamp);
     } else {
-      encodeIt->second->video_write(*(objectMetadata->mFrame->mSpData));
+      encodeIt->second->video_write(objectMetadata->mFrame->mSpData,
+                                    timestamp);
     }
   }
 }
@@ -9,6 +9,9 @@
 
 #include "encoder.h"
 
+#include <algorithm>
+#include <cmath>
+
 namespace sophon_stream {
 namespace element {
 namespace encode {
@@ -43,14 +46,15 @@ class Encoder::Encoder_CC {
  public:
   Encoder_CC();
   Encoder_CC(int dev_id, const std::string& enc_fmt, const std::string& pix_fmt,
-             const std::map<std::string, int>& enc_params, int channel_idx);
+             const std::map<std::string, int>& enc_params, int channel_idx,
+             const OutputRateOptions& rate_options);
 
   ~Encoder_CC();
 
   void set_output_path(const std::string& output_path);
   void init_writer();
   bool is_opened();
-  int video_write(bm_image& image);
+  int video_write(std::shared_ptr<bm_image> image, std::int64_t timestampUs);
   void release();
   void set_enc_params_width(int width);
   void set_enc_params_height(int height);
@@ -95,17 +99,35 @@ class Encoder::Encoder_CC {
   int bm_image_to_avframe(bm_handle_t& handle, bm_image* image, AVFrame* frame);
   int flush_encoder();
 
-  bool pushQueue(std::shared_ptr<void> p);
-  std::shared_ptr<void> popQueue();
-  int getSize() const;
+  struct PendingFrame {
+    std::shared_ptr<bm_image> image;
+    std::int64_t timestampUs;
+  };
+
+  // 以下只在写出线程中调用
+  int open_writer();
+  int open_codec(int bitrate);
+  void close_writer(bool finish);
+  int write_frame(PendingFrame& frame);
+  int write_packet(AVPacket* pkt);
+  std::int64_t next_pts(std::int64_t timestampUs);
+  int adapt_bitrate();
+  // 等待重连间隔，期间release时返回false
+  bool wait_reconnect();
+  bool running();
   void flowControlFunc();
 
-  static constexpr const int queueMaxSize = 10;
-  static constexpr const int queueMinSize = 5;
-  std::queue<std::shared_ptr<void>> encoderQueue;
-  mutable std::mutex mQueueMtx;
-  std::mutex mIsOpenMtx;  // mutex lock for judging if rtsp opened
-  std::mutex mMtx;        // mutex lock for clearing context
+  OutputRateOptions rate_options_;
+  BoundedFrameQueue<PendingFrame> frame_queue_;
+  FramePacer pacer_;
+  BitrateAdapter bitrate_adapter_;
+  std::int64_t last_pts_ = -1;
+  std::int64_t last_timestamp_ = -1;
+
+  // opened_为false且open_requested_为true时写出线程正在连接
+  bool open_requested_ = false;
+  std::mutex mIsOpenMtx;  // mutex lock for opened_, open_requested_, isRunning
+  std::condition_variable mIsOpenCv;
 
   std::thread flow_control;
   bool isRunning = true;
@@ -115,15 +137,19 @@ Encoder::Encoder() : _impl(new Encoder_CC()) {}
 
 Encoder::Encoder(int dev_id, const std::string& enc_fmt,
                  const std::string& pix_fmt,
-                 const std::map<std::string, int>& enc_params, int channel_idx)
-    : _impl(new Encoder_CC(dev_id, enc_fmt, pix_fmt, enc_params, channel_idx)) {
-}
+                 const std::map<std::string, int>& enc_params, int channel_idx,
+                 const OutputRateOptions& rate_options)
+    : _impl(new Encoder_CC(dev_id, enc_fmt, pix_fmt, enc_params, channel_idx,
+                           rate_options)) {}
 
 Encoder::~Encoder() { delete _impl; }
 
 bool Encoder::is_opened() { return _impl->is_opened(); }
 
-int Encoder::video_write(bm_image& image) { return _impl->video_write(image); }
+int Encoder::video_write(std::shared_ptr<bm_image> image,
+                         std::int64_t timestampUs) {
+  return _impl->video_write(std::move(image), timestampUs);
+}
 
 void Encoder::set_output_path(const std::string& output_path) {
   return _impl->set_output_path(output_path);
@@ -195,7 +221,8 @@ Encoder::Encoder_CC::Encoder_CC() {}
 Encoder::Encoder_CC::Encoder_CC(int dev_id, const std::string& enc_fmt,
                                 const std::string& pix_fmt,
                                 const std::map<std::string, int>& enc_params,
-                                int channel_idx)
+                                int channel_idx,
+                                const OutputRateOptions& rate_options)
     : index(0),
       is_jpeg_(false),
       is_rtsp_(false),
@@ -204,10 +231,12 @@ Encoder::Encoder_CC::Encoder_CC(int dev_id, const std::string& enc_fmt,
       opened_(false),
       enc_ctx_(nullptr),
       enc_dict_(nullptr),
+      enc_format_ctx_(nullptr),
       enc_fmt_(enc_fmt),
       enc_params_(enc_params),
       pix_fmt_(AV_PIX_FMT_NONE),
-      channel_idx(channel_idx) {
+      channel_idx(channel_idx),
+      rate_options_(rate_options) {
   bm_dev_request(&handle_, dev_id);
   enc_params_prase();
   if (pix_fmt == "I420") {
@@ -216,10 +245,53 @@ Encoder::Encoder_CC::Encoder_CC(int dev_id, const std::string& enc_fmt,
     pix_fmt_ = AV_PIX_FMT_NV12;
   } else {
   }
+  frame_queue_.configure(rate_options_.queueSize, rate_options_.dropFrames);
+  pacer_.setTargetFps(rate_options_.targetFps);
   flow_control = std::thread(&Encoder::Encoder_CC::flowControlFunc, this);
 }
 
 void Encoder::Encoder_CC::init_writer() {
+  {
+    std::lock_guard<std::mutex> lock(mIsOpenMtx);
+    open_requested_ = true;
+  }
+  mIsOpenCv.notify_all();
+}
+
+int Encoder::Encoder_CC::open_codec(int bitrate) {
+  enc_ctx_ = avcodec_alloc_context3(encoder_);
+  if (!enc_ctx_) {
+    IVS_ERROR("Cannot alloc encoder named {0}", enc_fmt_);
+    abort();
+  }
+
+  enc_ctx_->codec_id = encoder_->id;
+  enc_ctx_->pix_fmt = pix_fmt_;
+
+  enc_ctx_->width = params_map_["width"];
+  enc_ctx_->height = params_map_["height"];
+  enc_ctx_->gop_size = params_map_["gop"];
+  enc_ctx_->time_base = (AVRational){1, params_map_["framerate"]};
+  enc_ctx_->framerate = (AVRational){params_map_["framerate"], 1};
+
+  if (enc_dict_) av_dict_free(&enc_dict_);
+  av_dict_set_int(&enc_dict_, "sophon_idx", bm_get_devid(handle_), 0);
+  av_dict_set_int(&enc_dict_, "gop_preset", params_map_["gop_preset"], 0);
+  av_dict_set_int(&enc_dict_, "is_dma_buffer", 1, 0);
+  // av_dict_set(&enc_dict_, "rtsp_transport", "tcp", 0);
+
+  if (-1 == params_map_["qp"]) {
+    enc_ctx_->bit_rate_tolerance = bitrate * 1000;
+    enc_ctx_->bit_rate = (int64_t)bitrate * 1000;
+  } else {
+    av_dict_set_int(&enc_dict_, "qp", params_map_["qp"], 0);
+  }
+  return avcodec_open2(enc_ctx_, encoder_, &enc_dict_);
+}
+
+int Encoder::Encoder_CC::open_writer() {
+  last_pts_ = -1;
+  last_timestamp_ = -1;
   if (output_path_.compare(0, 7, "rtmp://") == 0) {
     is_rtmp_ = true;
     std::string enParams =
@@ -239,105 +311,94 @@ void Encoder::Encoder_CC::init_writer() {
                   enParams, true, bm_get_devid(handle_));
     } else {
     }
-    opened_ = true;
-  } else {
-    if (output_path_.compare(0, 7, "rtsp://") == 0) {
-      is_rtsp_ = true;
-      avformat_alloc_output_context2(&enc_format_ctx_, NULL, "rtsp",
-                                     output_path_.c_str());
-      if (!enc_format_ctx_) {
-      }
-    } else {
-      is_video_file_ = true;
-      avformat_alloc_output_context2(&enc_format_ctx_, NULL, NULL,
-                                     output_path_.c_str());
-      // enc_output_fmt_ = av_guess_format(NULL, output_path_.c_str(), NULL);
-      // if (enc_output_fmt_->video_codec == AV_CODEC_ID_NONE) {
-      // }
-      // enc_format_ctx_->oformat = enc_output_fmt_;
-    }
-
-    encoder_ = avcodec_find_encoder_by_name(enc_fmt_.c_str());
-    if (!encoder_) {
-      IVS_ERROR("Cannot find encoder named {0}", enc_fmt_);
-      abort();
-    }
-    enc_ctx_ = avcodec_alloc_context3(encoder_);
-    if (!encoder_) {
-      IVS_ERROR("Cannot alloc encoder named {0}", enc_fmt_);
-      abort();
-    }
-
-    enc_ctx_->codec_id = encoder_->id;
-    enc_ctx_->pix_fmt = pix_fmt_;
-
-    enc_ctx_->width = params_map_["width"];
-    enc_ctx_->height = params_map_["height"];
-    enc_ctx_->gop_size = params_map_["gop"];
-    enc_ctx_->time_base = (AVRational){1, params_map_["framerate"]};
-    enc_ctx_->framerate = (AVRational){params_map_["framerate"], 1};
+    return writer.isOpened() ? 0 : -1;
+  }
 
-    av_dict_set_int(&enc_dict_, "sophon_idx", bm_get_devid(handle_), 0);
-    av_dict_set_int(&enc_dict_, "gop_preset", params_map_["gop_preset"], 0);
-    av_dict_set_int(&enc_dict_, "is_dma_buffer", 1, 0);
-    // av_dict_set(&enc_dict_, "rtsp_transport", "tcp", 0);
+  if (output_path_.compare(0, 7, "rtsp://") == 0) {
+    is_rtsp_ = true;
+    avformat_alloc_output_context2(&enc_format_ctx_, NULL, "rtsp",
+                                   output_path_.c_str());
+  } else {
+    is_video_file_ = true;
+    avformat_alloc_output_context2(&enc_format_ctx_, NULL, NULL,
+                                   output_path_.c_str());
+    // enc_output_fmt_ = av_guess_format(NULL, output_path_.c_str(), NULL);
+    // if (enc_output_fmt_->video_codec == AV_CODEC_ID_NONE) {
+    // }
+    // enc_format_ctx_->oformat = enc_output_fmt_;
+  }
+  if (!enc_format_ctx_) {
+    IVS_ERROR("avformat_alloc_output_context2 failed, output path {0}",
+              output_path_);
+    return -1;
+  }
 
-    if (-1 == params_map_["qp"]) {
-      enc_ctx_->bit_rate_tolerance = params_map_["bitrate"] * 1000;
-      enc_ctx_->bit_rate = (int64_t)params_map_["bitrate"] * 1000;
-    } else {
-      av_dict_set_int(&enc_dict_, "qp", params_map_["qp"], 0);
-    }
+  encoder_ = avcodec_find_encoder_by_name(enc_fmt_.c_str());
+  if (!encoder_) {
+    IVS_ERROR("Cannot find encoder named {0}", enc_fmt_);
+    abort();
+  }
+  int ret = open_codec(params_map_["bitrate"]);
+  if (ret < 0) {
+    IVS_ERROR("avcodec_open2 failed!");
+    abort();
+  }
 
-    out_stream_ = avformat_new_stream(enc_format_ctx_, encoder_);
+  out_stream_ = avformat_new_stream(enc_format_ctx_, encoder_);
 
-    out_stream_->time_base = enc_ctx_->time_base;
-    out_stream_->avg_frame_rate = enc_ctx_->framerate;
-    out_stream_->r_frame_rate = out_stream_->avg_frame_rate;
+  out_stream_->time_base = enc_ctx_->time_base;
+  out_stream_->avg_frame_rate = enc_ctx_->framerate;
+  out_stream_->r_frame_rate = out_stream_->avg_frame_rate;
 
-    int ret = avcodec_open2(enc_ctx_, encoder_, &enc_dict_);
-    if (ret < 0) {
-      IVS_ERROR("avcodec_open2 failed!");
-      abort();
-    }
-    ret = avcodec_parameters_from_context(out_stream_->codecpar, enc_ctx_);
-    if (ret < 0) {
-      IVS_ERROR("avcodec_parameters_from_context failed");
-      abort();
-    }
-    if (is_video_file_) {
-      if (!(enc_format_ctx_->oformat->flags & AVFMT_NOFILE)) {
-        ret = avio_open2(&enc_format_ctx_->pb, output_path_.c_str(),
-                         AVIO_FLAG_WRITE, NULL, NULL);
-        if (ret < 0) {
-          IVS_ERROR("avio_open2 failed");
-          abort();
-        }
+  ret = avcodec_parameters_from_context(out_stream_->codecpar, enc_ctx_);
+  if (ret < 0) {
+    IVS_ERROR("avcodec_parameters_from_context failed");
+    abort();
+  }
+  if (is_video_file_) {
+    if (!(enc_format_ctx_->oformat->flags & AVFMT_NOFILE)) {
+      ret = avio_open2(&enc_format_ctx_->pb, output_path_.c_str(),
+                       AVIO_FLAG_WRITE, NULL, NULL);
+      if (ret < 0) {
+        IVS_ERROR("avio_open2 failed");
+        abort();
       }
     }
-    AVDictionary *header_options = NULL;
-    // av_dict_set(&header_options, "rtsp_transport", "tcp", 0);
-    av_dict_set(&header_options, "timeout", "3000000", 0); // 3s
-    ret = avformat_write_header(enc_format_ctx_, &header_options);
-    av_dict_free(&header_options);
-    if (ret < 0) {
-      IVS_ERROR("avformat_write_header failed {0}", ret);
-      IVS_ERROR(
-          "The RTSP ingest server fails to reconnect, check whether it is "
-          "enabled");
-      std::lock_guard<std::mutex> lock(mIsOpenMtx);
-      opened_ = false;
-    } else {
-      IVS_INFO("The RTSP ingest server success to connect!");
-      std::lock_guard<std::mutex> lock(mIsOpenMtx);
-      opened_ = true;
-    }
+  }
+  AVDictionary *header_options = NULL;
+  // av_dict_set(&header_options, "rtsp_transport", "tcp", 0);
+  av_dict_set(&header_options, "timeout", "3000000", 0); // 3s
+  ret = avformat_write_header(enc_format_ctx_, &header_options);
+  av_dict_free(&header_options);
+  if (ret < 0) {
+    IVS_ERROR("avformat_write_header failed {0}", ret);
+    return ret;
+  }
+  return 0;
+}
+
+void Encoder::Encoder_CC::close_writer(bool finish) {
+  if (is_rtmp_) {
+    if (writer.isOpened()) writer.release();
+    return;
+  }
+  if (finish && enc_ctx_ && enc_format_ctx_) {
+    flush_encoder();
+    av_write_trailer(enc_format_ctx_);
+  }
+  if (enc_dict_) av_dict_free(&enc_dict_);
+  if (enc_ctx_) avcodec_free_context(&enc_ctx_);
+  if (enc_format_ctx_) {
+    if (is_video_file_ && !(enc_format_ctx_->oformat->flags & AVFMT_NOFILE))
+      avio_closep(&enc_format_ctx_->pb);
+    avformat_free_context(enc_format_ctx_);
+    enc_format_ctx_ = nullptr;
   }
 }
 
 Encoder::Encoder_CC::~Encoder_CC() {
   // SPDLOG_INFO("release encoder");
-  // release();
+  release();
   bm_dev_free(handle_);
 }
 
@@ -459,164 +520,182 @@ int Encoder::Encoder_CC::bm_image_to_avframe(bm_handle_t& handle,
   return 0;
 }
 
+
 bool Encoder::Encoder_CC::is_opened() {
   std::lock_guard<std::mutex> lock(mIsOpenMtx);
   return opened_;
 }
 
-bool Encoder::Encoder_CC::pushQueue(std::shared_ptr<void> p) {
-  if (getSize() >= queueMaxSize) {
+bool Encoder::Encoder_CC::running() {
+  std::lock_guard<std::mutex> lock(mIsOpenMtx);
+  return isRunning;
+}
+
+bool Encoder::Encoder_CC::wait_reconnect() {
+  IVS_INFO(
+      "Try clearing context and reconnecting to the streaming server every "
+      "{0} ms",
+      rate_options_.reconnectIntervalMs);
+  std::unique_lock<std::mutex> lock(mIsOpenMtx);
+  opened_ = false;
+  open_requested_ = false;
+  lock.unlock();
+  // 断开期间video_write直接返回，不再入队，也唤醒阻塞在队列上的调用方
+  frame_queue_.clear();
+  lock.lock();
+  if (mIsOpenCv.wait_for(
+          lock, std::chrono::milliseconds(rate_options_.reconnectIntervalMs),
+          [this] { return !isRunning; }))
     return false;
-  }
-  std::lock_guard<std::mutex> lock(mQueueMtx);
-  encoderQueue.push(p);
+  open_requested_ = true;
   return true;
 }
 
-std::shared_ptr<void> Encoder::Encoder_CC::popQueue() {
-  std::lock_guard<std::mutex> lock(mQueueMtx);
-  std::shared_ptr<void> p = nullptr;
-  // printf("encode queue popping! queue size is %d\n", encoderQueue.size());
-  if (!encoderQueue.empty()) {
-    p = encoderQueue.front();
-    encoderQueue.pop();
+std::int64_t Encoder::Encoder_CC::next_pts(std::int64_t timestampUs) {
+  // 有丢帧或抽帧时按时间戳推算pts，保持输出视频的播放速度
+  std::int64_t step = 1;
+  if ((rate_options_.dropFrames || rate_options_.targetFps > 0) &&
+      last_timestamp_ >= 0 && timestampUs > last_timestamp_) {
+    double frames =
+        (timestampUs - last_timestamp_) * params_map_["framerate"] / 1e6;
+    step = std::max<std::int64_t>(1, std::llround(frames));
   }
-  return p;
+  last_timestamp_ = timestampUs;
+  last_pts_ += step;
+  return last_pts_;
 }
 
-int Encoder::Encoder_CC::getSize() const {
-  std::lock_guard<std::mutex> lock(mQueueMtx);
-  return encoderQueue.size();
+int Encoder::Encoder_CC::write_packet(AVPacket* pkt) {
+  av_packet_rescale_ts(pkt, enc_ctx_->time_base, out_stream_->time_base);
+  pkt->stream_index = out_stream_->index;
+  std::int64_t bytes = pkt->size;
+  auto start = std::chrono::steady_clock::now();
+  int ret = av_interleaved_write_frame(enc_format_ctx_, pkt);
+  bitrate_adapter_.onWrite(
+      bytes, std::chrono::duration_cast<std::chrono::microseconds>(
+                 std::chrono::steady_clock::now() - start)
+                 .count());
+  av_packet_unref(pkt);
+  return ret;
 }
 
-void Encoder::Encoder_CC::flowControlFunc() {
-  while (isRunning && getSize() < queueMinSize) {
-    std::this_thread::sleep_for(std::chrono::milliseconds(5));
-  }
-  while (isRunning) {
-    while (!is_opened()) {
-      IVS_INFO(
-          "Try clearing context and reconnecting to the RTSP streaming server "
-          "every 5 seconds");
-      {
-        std::lock_guard<std::mutex> lock(mMtx);
-        if (enc_dict_) {
-          av_dict_free(&enc_dict_);
-          enc_dict_ = nullptr;
-        }
-        if (enc_ctx_) {
-          avcodec_close(enc_ctx_);
-          avcodec_free_context(&enc_ctx_);
-          enc_ctx_ = nullptr;
-        }
-        while (1) {
-          auto p = popQueue();
-          if (p == nullptr) break;
-        }
-      }
-      std::this_thread::sleep_for(std::chrono::milliseconds(5000));
-      init_writer();
-    }
-    auto p = popQueue();
-    if (p == nullptr) {
-      std::this_thread::sleep_for(std::chrono::milliseconds(5));
-      continue;
-    }
-
-    if (is_rtsp_ || is_video_file_) {
-      std::shared_ptr<AVPacket> pp = std::static_pointer_cast<AVPacket>(p);
-      int ret = av_interleaved_write_frame(enc_format_ctx_, pp.get());
-      if (ret) {
-        IVS_ERROR(
-            "The RTSP stream ingest server fails to connect, check whether it "
-            "is "
-            "enabled");
-        {
-          std::lock_guard<std::mutex> lock(mIsOpenMtx);
-          opened_ = false;
-        }
-      }
+int Encoder::Encoder_CC::write_frame(PendingFrame& frame) {
+  if (is_rtmp_) {
+    cv::Mat write_mat;
+    cv::bmcv::toMAT(frame.image.get(), write_mat, true);
+    cv::Mat resized;
+    cv::resize(write_mat, resized,
+               cv::Size(params_map_["width"], params_map_["height"]));
+    writer.write(resized);
+    return writer.isOpened() ? 0 : -1;
+  }
 
-    } else if (is_rtmp_) {
-      std::shared_ptr<cv::Mat> pp = std::static_pointer_cast<cv::Mat>(p);
-      writer.write(*pp);
+  std::shared_ptr<AVFrame> frame_ = nullptr;
+  frame_.reset(av_frame_alloc(), [](AVFrame* p) {
+    if (p != nullptr) {
+      av_frame_free(&p);
     }
+  });
+  // 单帧转换或编码失败时跳过该帧，不断开连接
+  int ret = bm_image_to_avframe(handle_, frame.image.get(), frame_.get());
+  if (ret < 0) return 0;
+  frame_->pts = next_pts(frame.timestampUs);
+
+  AVPacket enc_pkt;
+  enc_pkt.data = NULL;
+  enc_pkt.size = 0;
+  av_init_packet(&enc_pkt);
+  int got_output = 0;
+  ret = avcodec_encode_video2(enc_ctx_, &enc_pkt, frame_.get(), &got_output);
+  if (ret < 0) {
+    IVS_WARN("Encoder {0} failed to encode frame, ret {1}", channel_idx, ret);
+    return 0;
   }
-  return;
+  if (got_output == 0) return 0;
+  return write_packet(&enc_pkt);
 }
 
-int Encoder::Encoder_CC::video_write(bm_image& image) {
-  if (!is_opened()) {
-    IVS_WARN(
-        "The RTSP stream ingest server fails to connect, so the encoder won't "
-        "push data");
-    return -1;
+int Encoder::Encoder_CC::adapt_bitrate() {
+  bitrate_adapter_.onDrop(frame_queue_.takeDropped());
+  if (!rate_options_.adaptiveBitrate || is_rtmp_ || params_map_["qp"] != -1)
+    return 0;
+  std::int64_t now = std::chrono::duration_cast<std::chrono::microseconds>(
+                         std::chrono::steady_clock::now().time_since_epoch())
+                         .count();
+  if (!bitrate_adapter_.update(now)) return 0;
+
+  // 重新打开编码器使新码率生效，新的编码器从IDR帧开始
+  int bitrate = bitrate_adapter_.bitrate();
+  IVS_INFO("Encoder {0} switches bitrate to {1} kbps", channel_idx, bitrate);
+  flush_encoder();
+  avcodec_free_context(&enc_ctx_);
+  int ret = open_codec(bitrate);
+  if (ret < 0) IVS_ERROR("Encoder {0} failed to reopen codec", channel_idx);
+  return ret;
+}
+
+void Encoder::Encoder_CC::flowControlFunc() {
+  {
+    std::unique_lock<std::mutex> lock(mIsOpenMtx);
+    mIsOpenCv.wait(lock, [this] { return !isRunning || open_requested_; });
+    if (!isRunning) return;
   }
-  if (is_rtsp_ || is_video_file_) {
-    // auto _start_time = std::chrono::high_resolution_clock::now();
-
-    int ret = 0;
-    int got_output = 0;
-    // int64_t start_time = 0;
-    std::shared_ptr<AVFrame> frame_ = nullptr;
-    frame_.reset(av_frame_alloc(), [](AVFrame* p) {
-      if (p != nullptr) {
-        av_frame_free(&p);
-      }
-    });
-    std::shared_ptr<AVPacket> test_enc_pkt = nullptr;
-    test_enc_pkt.reset(av_packet_alloc(), [](AVPacket* p) {
-      if (p != nullptr) {
-        av_packet_free(&p);
-      }
-    });
-
-    ret = bm_image_to_avframe(handle_, &image, frame_.get());
-    if (ret < 0) return -1;
-    test_enc_pkt->data = NULL;
-    test_enc_pkt->size = 0;
-    av_init_packet(test_enc_pkt.get());
-    if (!is_opened()) {
-      IVS_WARN(
-          "The RTSP stream ingest server fails to connect, so the encoder "
-          "won't push data");
-      return -1;
+  while (true) {
+    if (open_writer() < 0) {
+      IVS_ERROR(
+          "The stream ingest server fails to connect, check whether it is "
+          "enabled");
+      close_writer(false);
+      if (!wait_reconnect()) return;
+      continue;
     }
+    IVS_INFO("Encoder {0} success to connect {1}", channel_idx, output_path_);
+    bitrate_adapter_.configure(params_map_["bitrate"], rate_options_.minBitrate);
+    frame_queue_.takeDropped();
     {
-      std::lock_guard<std::mutex> lock(mMtx);
-      ret = avcodec_encode_video2(enc_ctx_, test_enc_pkt.get(), frame_.get(),
-                                  &got_output);
+      std::lock_guard<std::mutex> lock(mIsOpenMtx);
+      opened_ = true;
     }
 
-    if (ret < 0) return ret;
-    if (got_output == 0) {
-      return -1;
+    // 队列为空时等待新帧而不是轮询；release后写完队列中剩余的帧再退出
+    while (true) {
+      PendingFrame frame;
+      bool popped = frame_queue_.pop(frame, std::chrono::milliseconds(100));
+      if (!popped && !running()) return;
+      if (popped && write_frame(frame) < 0) break;
+      if (adapt_bitrate() < 0) break;
     }
-    av_packet_rescale_ts(test_enc_pkt.get(), enc_ctx_->time_base,
-                         out_stream_->time_base);
-    pushQueue(std::static_pointer_cast<void>(test_enc_pkt));
-
-    // auto _finish_time = std::chrono::high_resolution_clock::now();
-    // std::chrono::duration<double> dur = _finish_time - _start_time;
-    // IVS_DEBUG("Time Cost on video_write is {0}, Encoder ID is {1}",
-    // dur.count(),
-    //           channel_idx);
-    return ret;
+    IVS_ERROR(
+        "The stream ingest server fails to connect, check whether it is "
+        "enabled");
+    close_writer(false);
+    if (!wait_reconnect()) return;
   }
-  if (is_rtmp_) {
-    cv::Mat write_mat;
-    cv::bmcv::toMAT(&image, write_mat, true);
-    cv::Mat resized;
-    cv::resize(write_mat, resized,
-               cv::Size(params_map_["width"], params_map_["height"]));
-    pushQueue(
-        std::static_pointer_cast<void>(std::make_shared<cv::Mat>(resized)));
-    return 0;
+}
+
+int Encoder::Encoder_CC::video_write(std::shared_ptr<bm_image> image,
+                                     std::int64_t timestampUs) {
+  bool writable = false;
+  {
+    std::lock_guard<std::mutex> lock(mIsOpenMtx);
+    writable = opened_ || open_requested_;
   }
+  if (!writable) {
+    IVS_WARN(
+        "The stream ingest server fails to connect, so the encoder won't "
+        "push data");
+    return -1;
+  }
+  if (!pacer_.accept(timestampUs)) return 0;
+  int dropped = frame_queue_.push({std::move(image), timestampUs});
+  if (dropped > 0)
+    IVS_DEBUG("Encoder {0} output lags, drop {1} frames", channel_idx,
+              dropped);
+  return 0;
 }
 
 int Encoder::Encoder_CC::flush_encoder() {
-  int ret;
+  int ret = 0;
   int got_frame = 0;
   if (!(this->enc_ctx_->codec->capabilities & AV_CODEC_CAP_DELAY)) return 0;
   while (1) {
@@ -631,26 +710,25 @@ int Encoder::Encoder_CC::flush_encoder() {
 
     if (!got_frame) break;
 
-    av_packet_rescale_ts(&temp_enc_pkt, this->enc_ctx_->time_base,
-                         this->out_stream_->time_base);
     /* mux encoded frame */
     av_log(NULL, AV_LOG_DEBUG, "Muxing frame\n");
-    ret = av_interleaved_write_frame(this->enc_format_ctx_, &temp_enc_pkt);
+    ret = write_packet(&temp_enc_pkt);
     if (ret < 0) break;
   }
   return ret;
 }
 
 void Encoder::Encoder_CC::release() {
-  isRunning = false;
-  flow_control.join();
-  if (enc_ctx_) {
-    flush_encoder();
-    av_write_trailer(enc_format_ctx_);
+  {
+    std::lock_guard<std::mutex> lock(mIsOpenMtx);
+    if (!isRunning) return;
+    isRunning = false;
   }
-
-  if (enc_dict_) av_dict_free(&enc_dict_);
-  if (enc_ctx_) avcodec_free_context(&enc_ctx_);
+  mIsOpenCv.notify_all();
+  frame_queue_.close();
+  if (flow_control.joinable()) flow_control.join();
+  close_writer(is_opened());
+  std::lock_guard<std::mutex> lock(mIsOpenMtx);
   opened_ = false;
   return;
 }
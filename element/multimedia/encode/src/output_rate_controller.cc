@@ -0,0 +1,84 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#include "output_rate_controller.h"
+
+#include <algorithm>
+
+namespace sophon_stream {
+namespace element {
+namespace encode {
+
+void FramePacer::setTargetFps(double fps) {
+  mPeriodUs = fps > 0 ? static_cast<std::int64_t>(1000000 / fps) : 0;
+  mStarted = false;
+}
+
+bool FramePacer::accept(std::int64_t timestampUs) {
+  if (mPeriodUs <= 0) return true;
+  // 时间戳回退(循环播放、重连)或跳变超过1秒时重新开始计时
+  if (!mStarted || timestampUs < mNextUs - 2 * mPeriodUs ||
+      timestampUs > mNextUs + 1000000) {
+    mStarted = true;
+    mNextUs = timestampUs + mPeriodUs;
+    return true;
+  }
+  // 允许半个周期的抖动，避免输入帧率略高于目标帧率时隔一帧丢一帧
+  if (timestampUs < mNextUs - mPeriodUs / 2) return false;
+  mNextUs = std::max(mNextUs + mPeriodUs, timestampUs + mPeriodUs / 2);
+  return true;
+}
+
+void BitrateAdapter::configure(int maxKbps, int minKbps) {
+  mMaxKbps = maxKbps;
+  mMinKbps = std::min(minKbps, maxKbps);
+  mCurrentKbps = maxKbps;
+  mWindowStartUs = -1;
+  mBytes = mBusyUs = mDropped = 0;
+  mHealthyWindows = 0;
+}
+
+void BitrateAdapter::onWrite(std::int64_t bytes, std::int64_t writeUs) {
+  mBytes += bytes;
+  mBusyUs += writeUs;
+}
+
+bool BitrateAdapter::update(std::int64_t nowUs) {
+  if (mWindowStartUs < 0) {
+    mWindowStartUs = nowUs;
+    return false;
+  }
+  std::int64_t windowUs = nowUs - mWindowStartUs;
+  if (windowUs < kWindowUs) return false;
+
+  double busy = static_cast<double>(mBusyUs) / windowUs;
+  int sendKbps = static_cast<int>(mBytes * 8 * 1000 / windowUs);
+  bool congested = busy > 0.9 || (mDropped > 0 && busy > 0.5);
+  int target = mCurrentKbps;
+  if (congested) {
+    mHealthyWindows = 0;
+    target = std::min(mCurrentKbps * 85 / 100, sendKbps * 9 / 10);
+  } else if (busy < 0.5 && mDropped == 0) {
+    if (++mHealthyWindows >= kRaiseWindows)
+      target = mCurrentKbps + std::max(1, mCurrentKbps / 10);
+  } else {
+    mHealthyWindows = 0;
+  }
+  target = std::max(mMinKbps, std::min(mMaxKbps, target));
+
+  mWindowStartUs = nowUs;
+  mBytes = mBusyUs = mDropped = 0;
+  if (target == mCurrentKbps) return false;
+  mCurrentKbps = target;
+  return true;
+}
+
+}  // namespace encode
+}  // namespace element
+}  // namespace sophon_stream
@@ -32,6 +32,7 @@
 #include "common/posed_object_metadata.h"
 #include "cvUniText.h"
 #include "element_factory.h"
+#include "osd_canvas.h"
 extern "C" {
 extern bm_status_t bmcv_image_overlay(bm_handle_t handle, bm_image image,
                                       int overlay_num,
@@ -290,6 +291,82 @@ void draw_opencv_track_result(
   }
 }
 
+// 与draw_opencv_det_result的画法相同，图元提交到canvas后统一绘制到YUV图像上
+void draw_yuv_det_result(std::shared_ptr<common::ObjectMetadata> objectMetadata,
+                         std::vector<std::string>& class_names,
+                         OsdCanvas& canvas, LabelCache& labelCache,
+                         bool put_text_flag, bool draw_interval) {
+  int colors_num = colors.size();
+  int thickness = 2;
+  float fontScale = 1;
+  std::shared_ptr<common::ObjectMetadata> objData;
+  {
+    std::lock_guard<std::mutex> lk(mLastObjectMetaDataMtx);
+    objData = (objectMetadata->mFilter && draw_interval)
+                  ? lastObjectMetadataMap[objectMetadata->mFrame->mChannelId]
+                  : objectMetadata;
+    lastObjectMetadataMap[objectMetadata->mFrame->mChannelId] = objData;
+  }
+  if (!objData) return;
+  for (auto detObj : objData->mDetectedObjectMetadatas) {
+    int classId = detObj->mClassify;
+    YuvColor color = YuvColor::fromBgr(colors[classId % colors_num][0],
+                                       colors[classId % colors_num][1],
+                                       colors[classId % colors_num][2]);
+    canvas.addRect(detObj->mBox.mX, detObj->mBox.mY, detObj->mBox.mWidth,
+                   detObj->mBox.mHeight, thickness, color);
+
+    if (put_text_flag) {
+      std::string label = class_names[classId] + ":" +
+                          cv::format("%.2f", detObj->mScores[0]);
+      int baseLine;
+      cv::Size labelSize =
+          getTextSize(label, cv::FONT_HERSHEY_SIMPLEX, 0.5, 1, &baseLine);
+      canvas.addLabel(labelCache.get(label, fontScale, thickness),
+                      detObj->mBox.mX,
+                      std::max(detObj->mBox.mY, labelSize.height) - 5, color);
+    }
+  }
+}
+
+void draw_yuv_track_result(
+    std::shared_ptr<common::ObjectMetadata> objectMetadata,
+    std::vector<std::string>& class_names, OsdCanvas& canvas,
+    LabelCache& labelCache, bool put_text_flag, bool draw_interval) {
+  int colors_num = colors.size();
+  int thickness = 2;
+  float fontScale = 1;
+  int idx = 0;
+  std::shared_ptr<common::ObjectMetadata> objData;
+  {
+    std::lock_guard<std::mutex> lk(mLastObjectMetaDataMtx);
+    objData = (objectMetadata->mFilter && draw_interval)
+                  ? lastObjectMetadataMap[objectMetadata->mFrame->mChannelId]
+                  : objectMetadata;
+    lastObjectMetadataMap[objectMetadata->mFrame->mChannelId] = objData;
+  }
+  if (!objData) return;
+  for (auto detObj : objData->mDetectedObjectMetadatas) {
+    int track_id = objData->mTrackedObjectMetadatas[idx]->mTrackId;
+    YuvColor color = YuvColor::fromBgr(colors[track_id % colors_num][0],
+                                       colors[track_id % colors_num][1],
+                                       colors[track_id % colors_num][2]);
+    canvas.addRect(detObj->mBox.mX, detObj->mBox.mY, detObj->mBox.mWidth,
+                   detObj->mBox.mHeight, thickness, color);
+
+    if (put_text_flag) {
+      std::string label = std::to_string(track_id);
+      int baseLine;
+      cv::Size labelSize =
+          getTextSize(label, cv::FONT_HERSHEY_SIMPLEX, 0.5, 1, &baseLine);
+      canvas.addLabel(labelCache.get(label, fontScale, thickness),
+                      detObj->mBox.mX,
+                      std::max(detObj->mBox.mY, labelSize.height) - 5, color);
+    }
+    ++idx;
+  }
+}
+
 void draw_bmcv_pose_result(
     bm_handle_t& handle, std::shared_ptr<common::ObjectMetadata> objectMetadata,
     bm_image& frame, bool draw_interval) {
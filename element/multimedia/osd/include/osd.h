@@ -16,6 +16,7 @@
 #include "common/object_metadata.h"
 #include "common/profiler.h"
 #include "element.h"
+#include "osd_canvas.h"
 
 namespace sophon_stream {
 namespace element {
@@ -24,7 +25,7 @@ namespace osd {
 class Osd : public ::sophon_stream::framework::Element {
  public:
   enum class OsdType { DET, TRACK, REC, POSE, AREA, OBB, ALGORITHM, TEXT, UNKNOWN };
-  enum class DrawUtils { OPENCV, BMCV, UNKNOWN };
+  enum class DrawUtils { OPENCV, BMCV, YUV, UNKNOWN };
   Osd();
   ~Osd() override;
   common::ErrorCode initInternal(const std::string& json) override;
@@ -72,7 +73,14 @@ class Osd : public ::sophon_stream::framework::Element {
                      cv::Mat&)>
       draw_func_opencv;
   ::sophon_stream::common::FpsProfiler mFpsProfiler;
+  // YUV画图时缓存标签的光栅化结果
+  LabelCache mLabelCache;
   void draw(std::shared_ptr<common::ObjectMetadata> objectMetadata);
+  /**
+   * @brief 只把canvas改写的行搬到系统内存，绘制后搬回image
+   */
+  void renderCanvas(bm_handle_t handle, const OsdCanvas& canvas,
+                    bm_image& image);
 };
 
 }  // namespace osd
@@ -0,0 +1,133 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SOPHON_STREAM_ELEMENT_OSD_OSD_CANVAS_H_
+#define SOPHON_STREAM_ELEMENT_OSD_OSD_CANVAS_H_
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace sophon_stream {
+namespace element {
+namespace osd {
+
+/**
+ * @brief 内存中的YUV420P图像，data和stride依次为Y、U、V平面
+ */
+struct YuvPlanes {
+  std::uint8_t* data[3];
+  int stride[3];
+  int width;
+  int height;
+};
+
+struct YuvColor {
+  std::uint8_t y;
+  std::uint8_t u;
+  std::uint8_t v;
+  /**
+   * @brief BT.601 limited range
+   */
+  static YuvColor fromBgr(int b, int g, int r);
+};
+
+/**
+ * @brief 一个标签光栅化后的alpha蒙版。(originX, originY)为文字基线起点在蒙版中的位置
+ */
+struct LabelMask {
+  int width = 0;
+  int height = 0;
+  int originX = 0;
+  int originY = 0;
+  std::vector<std::uint8_t> alpha;
+};
+
+/**
+ * @brief 按文字、字号和线宽缓存标签蒙版，超过容量时淘汰最久未使用的标签。多线程共用
+ */
+class LabelCache {
+ public:
+  explicit LabelCache(std::size_t capacity = 4096) : mCapacity(capacity) {}
+
+  /**
+   * @brief 取出标签蒙版，不在缓存中时用opencv的HERSHEY_SIMPLEX字体光栅化
+   */
+  std::shared_ptr<const LabelMask> get(const std::string& text,
+                                       double fontScale, int thickness);
+
+ private:
+  using Entry = std::pair<std::string, std::shared_ptr<const LabelMask>>;
+
+  std::size_t mCapacity;
+  // 最近使用的在前
+  std::list<Entry> mEntries;
+  std::unordered_map<std::string, std::list<Entry>::iterator> mIndex;
+  std::mutex mMutex;
+};
+
+/**
+ * @brief 收集一帧的全部图元，只改写图元覆盖的行，直接在YUV平面上绘制和混合
+ * @brief
+ * 先提交全部图元，再用dirtyRows取出需要改写的行区间，调用方只需要把这些行从设备内存搬到
+ * 系统内存、render之后再搬回去。行区间按偶数行对齐，对应的色度行不会跨区间
+ */
+class OsdCanvas {
+ public:
+  void clear() { mPrimitives.clear(); }
+  bool empty() const { return mPrimitives.empty(); }
+
+  /**
+   * @brief 空心矩形，边框向矩形内侧绘制
+   */
+  void addRect(int x, int y, int width, int height, int thickness,
+               YuvColor color);
+  /**
+   * @param[in] x, y : 文字基线起点
+   */
+  void addLabel(std::shared_ptr<const LabelMask> mask, int x, int y,
+                YuvColor color);
+
+  /**
+   * @brief 图元覆盖的行合并后的区间[begin, end)，按行号升序
+   */
+  std::vector<std::pair<int, int>> dirtyRows(int height) const;
+
+  /**
+   * @brief 按提交顺序绘制全部图元中落在[rowBegin, rowEnd)内的部分
+   */
+  void render(YuvPlanes& planes, int rowBegin, int rowEnd) const;
+
+ private:
+  struct Primitive {
+    // 外接矩形[x0, x1) x [y0, y1)
+    int x0, y0, x1, y1;
+    int thickness;
+    YuvColor color;
+    std::shared_ptr<const LabelMask> mask;  // 为空时为矩形
+  };
+
+  static void fillRect(YuvPlanes& planes, int x0, int y0, int x1, int y1,
+                       YuvColor color, int rowBegin, int rowEnd);
+  static void blendMask(YuvPlanes& planes, const Primitive& label,
+                        int rowBegin, int rowEnd);
+
+  std::vector<Primitive> mPrimitives;
+};
+
+}  // namespace osd
+}  // namespace element
+}  // namespace sophon_stream
+
+#endif  // SOPHON_STREAM_ELEMENT_OSD_OSD_CANVAS_H_
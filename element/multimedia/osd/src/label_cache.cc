@@ -0,0 +1,61 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#include "osd_canvas.h"
+
+#include <opencv2/imgproc.hpp>
+
+namespace sophon_stream {
+namespace element {
+namespace osd {
+
+std::shared_ptr<const LabelMask> LabelCache::get(const std::string& text,
+                                                 double fontScale,
+                                                 int thickness) {
+  std::string key = text + '\x1f' + std::to_string(fontScale) + '\x1f' +
+                    std::to_string(thickness);
+  {
+    std::lock_guard<std::mutex> lk(mMutex);
+    auto it = mIndex.find(key);
+    if (it != mIndex.end()) {
+      mEntries.splice(mEntries.begin(), mEntries, it->second);
+      return it->second->second;
+    }
+  }
+
+  auto mask = std::make_shared<LabelMask>();
+  int baseline = 0;
+  cv::Size size = cv::getTextSize(text, cv::FONT_HERSHEY_SIMPLEX, fontScale,
+                                  thickness, &baseline);
+  int margin = thickness;
+  mask->width = size.width + 2 * margin;
+  mask->height = size.height + baseline + 2 * margin;
+  mask->originX = margin;
+  mask->originY = margin + size.height;
+  cv::Mat canvas(mask->height, mask->width, CV_8UC1, cv::Scalar(0));
+  cv::putText(canvas, text, cv::Point(mask->originX, mask->originY),
+              cv::FONT_HERSHEY_SIMPLEX, fontScale, cv::Scalar(255), thickness,
+              cv::LINE_AA);
+  mask->alpha.assign(canvas.data, canvas.data + canvas.total());
+
+  std::lock_guard<std::mutex> lk(mMutex);
+  auto it = mIndex.find(key);
+  if (it != mIndex.end()) return it->second->second;
+  mEntries.emplace_front(key, mask);
+  mIndex[key] = mEntries.begin();
+  if (mEntries.size() > mCapacity) {
+    mIndex.erase(mEntries.back().first);
+    mEntries.pop_back();
+  }
+  return mask;
+}
+
+}  // namespace osd
+}  // namespace element
+}  // namespace sophon_stream
@@ -148,6 +148,7 @@ common::ErrorCode Osd::initInternal(const std::string& json) {
       auto drawUtils = drawUtilsIt->get<std::string>();
       if (drawUtils == "OPENCV") mDrawUtils = DrawUtils::OPENCV;
       if (drawUtils == "BMCV") mDrawUtils = DrawUtils::BMCV;
+      if (drawUtils == "YUV") mDrawUtils = DrawUtils::YUV;
       IVS_DEBUG("drawUtils is {0}", drawUtils);
     } else {
       IVS_ERROR(
@@ -278,7 +279,8 @@ common::ErrorCode Osd::doWork(int dataPipeId) {
   int outDataPipeId =
       getSinkElementFlag()
           ? 0
-          : (channel_id_internal % getOutputConnectorCapacity(outputPort));
+          : getOutputDataPipeId(outputPort, channel_id_internal,
+                                objectMetadata->mFrame->mEndOfStream);
   errorCode = pushOutputData(outputPort, outDataPipeId, objectMetadata);
   if (common::ErrorCode::SUCCESS != errorCode) {
     IVS_WARN(
@@ -389,12 +391,77 @@ void Osd::draw(std::shared_ptr<common::ObjectMetadata> objectMetadata) {
       default:
         IVS_WARN("osd_type not support");
     }
+  } else if (mDrawUtils == DrawUtils::YUV) {
+    bm_image_create(objectMetadata->mFrame->mHandle,
+                    objectMetadata->mFrame->mHeight,
+                    objectMetadata->mFrame->mWidth, FORMAT_YUV420P,
+                    image.data_type, &(*imageStorage));
+    bmcv_image_storage_convert(objectMetadata->mFrame->mHandle, 1, &image,
+                               &(*imageStorage));
+    OsdCanvas canvas;
+    switch (mOsdType) {
+      case OsdType::DET:
+        draw_yuv_det_result(objectMetadata, mClassNames, canvas, mLabelCache,
+                            mPutText, mDrawInterval);
+        break;
+
+      case OsdType::TRACK:
+        draw_yuv_track_result(objectMetadata, mClassNames, canvas,
+                              mLabelCache, mPutText, mDrawInterval);
+        break;
+
+      default:
+        IVS_WARN("osd_type not support");
+    }
+    renderCanvas(objectMetadata->mFrame->mHandle, canvas, *imageStorage);
   } else {
   }
 
   objectMetadata->mFrame->mSpDataOsd = imageStorage;
 }
 
+void Osd::renderCanvas(bm_handle_t handle, const OsdCanvas& canvas,
+                       bm_image& image) {
+  auto rows = canvas.dirtyRows(image.height);
+  if (rows.empty()) return;
+
+  bm_device_mem_t mem[3];
+  int stride[3];
+  bm_image_get_device_mem(image, mem);
+  bm_image_get_stride(image, stride);
+  int planeHeight[3] = {image.height, (image.height + 1) / 2,
+                        (image.height + 1) / 2};
+  // 每个osd线程复用一块系统内存，只有改写的行是有效数据
+  static thread_local std::vector<uint8_t> buffers[3];
+  YuvPlanes planes;
+  planes.width = image.width;
+  planes.height = image.height;
+  for (int i = 0; i < 3; ++i) {
+    buffers[i].resize(stride[i] * planeHeight[i]);
+    planes.data[i] = buffers[i].data();
+    planes.stride[i] = stride[i];
+  }
+
+  for (const auto& row : rows) {
+    for (int i = 0; i < 3; ++i) {
+      int begin = i == 0 ? row.first : row.first / 2;
+      int end = i == 0 ? row.second : (row.second + 1) / 2;
+      bm_memcpy_d2s_partial_offset(handle, planes.data[i] + begin * stride[i],
+                                   mem[i], (end - begin) * stride[i],
+                                   begin * stride[i]);
+    }
+    canvas.render(planes, row.first, row.second);
+    for (int i = 0; i < 3; ++i) {
+      int begin = i == 0 ? row.first : row.first / 2;
+      int end = i == 0 ? row.second : (row.second + 1) / 2;
+      bm_memcpy_s2d_partial_offset(handle, mem[i],
+                                   planes.data[i] + begin * stride[i],
+                                   (end - begin) * stride[i],
+                                   begin * stride[i]);
+    }
+  }
+}
+
 REGISTER_WORKER("osd", Osd)
 
 }  // namespace osd
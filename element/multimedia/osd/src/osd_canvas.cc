@@ -0,0 +1,247 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#include "osd_canvas.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace sophon_stream {
+namespace element {
+namespace osd {
+
+namespace {
+
+inline std::uint8_t clampToByte(int value) {
+  return static_cast<std::uint8_t>(std::min(255, std::max(0, value)));
+}
+
+// alpha为0~255，映射到0~256后用移位代替除以255，alpha为255时结果等于前景色。
+// 中间结果不超过255 * 256，16位无符号整数即可容纳，一次处理8个像素
+inline void blendRow(std::uint8_t* dst, const std::uint8_t* alpha, int n,
+                     std::uint8_t color) {
+  int i = 0;
+#if defined(__aarch64__)
+  uint16x8_t c = vdupq_n_u16(color);
+  uint16x8_t full = vdupq_n_u16(256);
+  for (; i + 8 <= n; i += 8) {
+    uint16x8_t a = vmovl_u8(vld1_u8(alpha + i));
+    a = vaddq_u16(a, vshrq_n_u16(a, 7));
+    uint16x8_t d = vmovl_u8(vld1_u8(dst + i));
+    uint16x8_t r = vmlaq_u16(vmulq_u16(d, vsubq_u16(full, a)), c, a);
+    vst1_u8(dst + i, vshrn_n_u16(r, 8));
+  }
+#elif defined(__SSE2__)
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i c = _mm_set1_epi16(color);
+  const __m128i full = _mm_set1_epi16(256);
+  for (; i + 8 <= n; i += 8) {
+    __m128i a = _mm_unpacklo_epi8(
+        _mm_loadl_epi64(reinterpret_cast<const __m128i*>(alpha + i)), zero);
+    a = _mm_add_epi16(a, _mm_srli_epi16(a, 7));
+    __m128i d = _mm_unpacklo_epi8(
+        _mm_loadl_epi64(reinterpret_cast<const __m128i*>(dst + i)), zero);
+    __m128i r = _mm_add_epi16(_mm_mullo_epi16(d, _mm_sub_epi16(full, a)),
+                              _mm_mullo_epi16(c, a));
+    r = _mm_srli_epi16(r, 8);
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + i),
+                     _mm_packus_epi16(r, r));
+  }
+#endif
+  for (; i < n; ++i) {
+    int a = alpha[i] + (alpha[i] >> 7);
+    dst[i] = static_cast<std::uint8_t>((dst[i] * (256 - a) + color * a) >> 8);
+  }
+}
+
+// sum[i] += row[i]
+inline void accumulateRow(std::uint16_t* sum, const std::uint8_t* row, int n) {
+  int i = 0;
+#if defined(__aarch64__)
+  for (; i + 8 <= n; i += 8)
+    vst1q_u16(sum + i, vaddw_u8(vld1q_u16(sum + i), vld1_u8(row + i)));
+#elif defined(__SSE2__)
+  const __m128i zero = _mm_setzero_si128();
+  for (; i + 8 <= n; i += 8) {
+    __m128i r = _mm_unpacklo_epi8(
+        _mm_loadl_epi64(reinterpret_cast<const __m128i*>(row + i)), zero);
+    __m128i* s = reinterpret_cast<__m128i*>(sum + i);
+    _mm_storeu_si128(s, _mm_add_epi16(_mm_loadu_si128(s), r));
+  }
+#endif
+  for (; i < n; ++i) sum[i] += row[i];
+}
+
+// dst[i] = (sum[2i] + sum[2i+1] + 2) / 4
+inline void averagePairs(std::uint8_t* dst, const std::uint16_t* sum, int n) {
+  int i = 0;
+#if defined(__aarch64__)
+  for (; i + 8 <= n; i += 8) {
+    uint16x8x2_t pair = vld2q_u16(sum + 2 * i);
+    vst1_u8(dst + i, vrshrn_n_u16(vaddq_u16(pair.val[0], pair.val[1]), 2));
+  }
+#elif defined(__SSE2__)
+  const __m128i one = _mm_set1_epi16(1);
+  const __m128i two = _mm_set1_epi32(2);
+  for (; i + 8 <= n; i += 8) {
+    const __m128i* s = reinterpret_cast<const __m128i*>(sum + 2 * i);
+    __m128i lo = _mm_madd_epi16(_mm_loadu_si128(s), one);
+    __m128i hi = _mm_madd_epi16(_mm_loadu_si128(s + 1), one);
+    lo = _mm_srai_epi32(_mm_add_epi32(lo, two), 2);
+    hi = _mm_srai_epi32(_mm_add_epi32(hi, two), 2);
+    __m128i r = _mm_packs_epi32(lo, hi);
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + i),
+                     _mm_packus_epi16(r, r));
+  }
+#endif
+  for (; i < n; ++i) dst[i] = (sum[2 * i] + sum[2 * i + 1] + 2) / 4;
+}
+
+}  // namespace
+
+YuvColor YuvColor::fromBgr(int b, int g, int r) {
+  YuvColor color;
+  color.y = clampToByte(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+  color.u = clampToByte(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+  color.v = clampToByte(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+  return color;
+}
+
+void OsdCanvas::addRect(int x, int y, int width, int height, int thickness,
+                        YuvColor color) {
+  if (width <= 0 || height <= 0 || thickness <= 0) return;
+  Primitive rect;
+  rect.x0 = x;
+  rect.y0 = y;
+  rect.x1 = x + width;
+  rect.y1 = y + height;
+  rect.thickness = thickness;
+  rect.color = color;
+  mPrimitives.push_back(rect);
+}
+
+void OsdCanvas::addLabel(std::shared_ptr<const LabelMask> mask, int x, int y,
+                         YuvColor color) {
+  if (!mask || mask->width == 0 || mask->height == 0) return;
+  Primitive label;
+  label.x0 = x - mask->originX;
+  label.y0 = y - mask->originY;
+  label.x1 = label.x0 + mask->width;
+  label.y1 = label.y0 + mask->height;
+  label.thickness = 0;
+  label.color = color;
+  label.mask = std::move(mask);
+  mPrimitives.push_back(label);
+}
+
+std::vector<std::pair<int, int>> OsdCanvas::dirtyRows(int height) const {
+  std::vector<std::pair<int, int>> rows;
+  for (const auto& primitive : mPrimitives) {
+    int begin = std::max(0, primitive.y0) & ~1;
+    int end = std::min(height, (primitive.y1 + 1) & ~1);
+    if (begin < end) rows.emplace_back(begin, end);
+  }
+  std::sort(rows.begin(), rows.end());
+  std::vector<std::pair<int, int>> merged;
+  for (const auto& row : rows) {
+    if (!merged.empty() && row.first <= merged.back().second)
+      merged.back().second = std::max(merged.back().second, row.second);
+    else
+      merged.push_back(row);
+  }
+  return merged;
+}
+
+void OsdCanvas::render(YuvPlanes& planes, int rowBegin, int rowEnd) const {
+  rowBegin = std::max(0, rowBegin);
+  rowEnd = std::min(planes.height, rowEnd);
+  for (const auto& p : mPrimitives) {
+    if (p.y1 <= rowBegin || p.y0 >= rowEnd) continue;
+    if (p.mask) {
+      blendMask(planes, p, rowBegin, rowEnd);
+      continue;
+    }
+    int t = std::min(p.thickness, std::min(p.x1 - p.x0, p.y1 - p.y0));
+    fillRect(planes, p.x0, p.y0, p.x1, p.y0 + t, p.color, rowBegin, rowEnd);
+    fillRect(planes, p.x0, p.y1 - t, p.x1, p.y1, p.color, rowBegin, rowEnd);
+    fillRect(planes, p.x0, p.y0, p.x0 + t, p.y1, p.color, rowBegin, rowEnd);
+    fillRect(planes, p.x1 - t, p.y0, p.x1, p.y1, p.color, rowBegin, rowEnd);
+  }
+}
+
+void OsdCanvas::fillRect(YuvPlanes& planes, int x0, int y0, int x1, int y1,
+                         YuvColor color, int rowBegin, int rowEnd) {
+  x0 = std::max(0, x0);
+  x1 = std::min(planes.width, x1);
+  y0 = std::max(rowBegin, y0);
+  y1 = std::min(rowEnd, y1);
+  if (x0 >= x1 || y0 >= y1) return;
+
+  for (int y = y0; y < y1; ++y)
+    std::memset(planes.data[0] + y * planes.stride[0] + x0, color.y, x1 - x0);
+
+  int cx0 = x0 / 2, cx1 = (x1 + 1) / 2;
+  for (int cy = y0 / 2; cy < (y1 + 1) / 2; ++cy) {
+    std::memset(planes.data[1] + cy * planes.stride[1] + cx0, color.u,
+                cx1 - cx0);
+    std::memset(planes.data[2] + cy * planes.stride[2] + cx0, color.v,
+                cx1 - cx0);
+  }
+}
+
+void OsdCanvas::blendMask(YuvPlanes& planes, const Primitive& label,
+                          int rowBegin, int rowEnd) {
+  const LabelMask& mask = *label.mask;
+  int x0 = std::max(0, label.x0);
+  int x1 = std::min(planes.width, label.x1);
+  int y0 = std::max(rowBegin, label.y0);
+  int y1 = std::min(rowEnd, label.y1);
+  if (x0 >= x1 || y0 >= y1) return;
+
+  for (int y = y0; y < y1; ++y) {
+    const std::uint8_t* alpha =
+        mask.alpha.data() + (y - label.y0) * mask.width + (x0 - label.x0);
+    blendRow(planes.data[0] + y * planes.stride[0] + x0, alpha, x1 - x0,
+             label.color.y);
+  }
+
+  // 色度取2x2个亮度位置的alpha均值，蒙版外按0计算。先把两行alpha按列累加，
+  // 再把相邻两列相加
+  int cx0 = x0 / 2, cx1 = (x1 + 1) / 2;
+  int px0 = cx0 * 2, px1 = cx1 * 2;
+  int mx0 = std::max(px0, label.x0), mx1 = std::min(px1, label.x1);
+  std::vector<std::uint16_t> sum(px1 - px0);
+  std::vector<std::uint8_t> alpha(cx1 - cx0);
+  for (int cy = y0 / 2; cy < (y1 + 1) / 2; ++cy) {
+    std::fill(sum.begin(), sum.end(), 0);
+    for (int y = cy * 2; y < cy * 2 + 2; ++y) {
+      int my = y - label.y0;
+      if (my < 0 || my >= mask.height) continue;
+      if (mx0 < mx1)
+        accumulateRow(sum.data() + mx0 - px0,
+                      mask.alpha.data() + my * mask.width + mx0 - label.x0,
+                      mx1 - mx0);
+    }
+    averagePairs(alpha.data(), sum.data(), cx1 - cx0);
+    blendRow(planes.data[1] + cy * planes.stride[1] + cx0, alpha.data(),
+             cx1 - cx0, label.color.u);
+    blendRow(planes.data[2] + cy * planes.stride[2] + cx0, alpha.data(),
+             cx1 - cx0, label.color.v);
+  }
+}
+
+}  // namespace osd
+}  // namespace element
+}  // namespace sophon_stream
@@ -13,6 +13,7 @@
 #include "common/object_metadata.h"
 #include "element.h"
 #include "common/profiler.h"
+#include "frame_synchronizer.h"
 void bm_read_bin(bm_image src, const char* input_name);
 void bm_dem_read_bin(bm_handle_t handle, bm_device_mem_t* dmem,
                      const char* input_name, unsigned int size);
@@ -70,6 +71,11 @@ class Blend : public ::sophon_stream::framework::Element {
       sophon_stream::framework::ListenThread* listener) override;
 
   ::sophon_stream::common::FpsProfiler mFpsProfiler;
+
+  // 按dataPipeId对齐左右两路输入
+  framework::FrameSynchronizer::Options mSyncOptions;
+  std::map<int, std::shared_ptr<framework::FrameSynchronizer>>
+      mSynchronizers;
 };
 
 }  // namespace blend
@@ -118,10 +118,11 @@ common::ErrorCode Converger::doWork(int dataPipeId) {
             "frame_id = {2}",
             getId(), channel_id_internal, frame_id);
         auto obj = mCandidates[channel_id_internal][frame_id];
-        int outDataPipeId = getSinkElementFlag()
-                                ? 0
-                                : (channel_id_internal %
-                                   getOutputConnectorCapacity(outputPort));
+        int outDataPipeId =
+            getSinkElementFlag()
+                ? 0
+                : getOutputDataPipeId(outputPort, channel_id_internal,
+                                      obj->mFrame->mEndOfStream);
         errorCode = pushOutputData(outputPort, outDataPipeId,
                                    std::static_pointer_cast<void>(obj));
         if (common::ErrorCode::SUCCESS != errorCode) {
@@ -32,6 +32,13 @@ class Distributor : public ::sophon_stream::framework::Element {
 
   common::ErrorCode doWork(int dataPipeId) override;
 
+  /**
+   * @brief 快照保存每一路距离上次按时间间隔分发经过的时间，停止期间不计入间隔
+   */
+  std::uint32_t getStateVersion() const override { return 1; }
+  common::ErrorCode saveState(common::StateWriter& writer) override;
+  common::ErrorCode loadState(common::StateReader& reader) override;
+
   static constexpr const char* CONFIG_INTERNAL_RULES_FILED = "rules";
   static constexpr const char* CONFIG_INTERNAL_PORT_FILED = "port";
   static constexpr const char* CONFIG_INTERNAL_CLASS_NAMES_FILED = "classes";
@@ -138,6 +138,31 @@ common::ErrorCode Distributor::initInternal(const std::string& json) {
   return errorCode;
 }
 
+common::ErrorCode Distributor::saveState(common::StateWriter& writer) {
+  float cur_time = clocker.tell_ms() / 1000.0;
+  std::unordered_map<int, std::vector<float>> elapsedTimes;
+  for (auto& pair : mChannelLastTimes) {
+    auto& elapsed = elapsedTimes[pair.first];
+    for (float lastTime : pair.second) elapsed.push_back(cur_time - lastTime);
+  }
+  writer.write(elapsedTimes);
+  return common::ErrorCode::SUCCESS;
+}
+
+common::ErrorCode Distributor::loadState(common::StateReader& reader) {
+  std::unordered_map<int, std::vector<float>> elapsedTimes;
+  if (!reader.read(elapsedTimes)) return common::ErrorCode::SNAPSHOT_FAIL;
+  float cur_time = clocker.tell_ms() / 1000.0;
+  mChannelLastTimes.clear();
+  for (auto& pair : elapsedTimes) {
+    // time_interval配置改变后按首次分发处理
+    if (pair.second.size() != mTimeIntervals.size()) continue;
+    auto& lastTimes = mChannelLastTimes[pair.first];
+    for (float elapsed : pair.second) lastTimes.push_back(cur_time - elapsed);
+  }
+  return common::ErrorCode::SUCCESS;
+}
+
 void Distributor::makeSubObjectMetadata(
     std::shared_ptr<common::ObjectMetadata> obj,
     std::shared_ptr<common::DetectedObjectMetadata> detObj,
@@ -595,7 +620,8 @@ common::ErrorCode Distributor::doWork(int dataPipeId) {
   // 先把ObjectMetadata发给默认的汇聚节点
   int channel_id_internal = objectMetadata->mFrame->mChannelIdInternal;
   int outDataPipeId =
-      channel_id_internal % getOutputConnectorCapacity(mDefaultPort);
+      getOutputDataPipeId(mDefaultPort, channel_id_internal,
+                          objectMetadata->mFrame->mEndOfStream);
 
   if (mChannelLastTimes.find(channel_id_internal) == mChannelLastTimes.end()) {
     mChannelLastTimes[channel_id_internal] =
@@ -642,7 +668,7 @@ common::ErrorCode Distributor::doWork(int dataPipeId) {
         objectMetadata->mSubObjectMetadatas.push_back(subObj);
         ++objectMetadata->numBranches;
         int outDataPipeId =
-            channel_id_internal % getOutputConnectorCapacity(outPort);
+            getOutputDataPipeId(outPort, channel_id_internal);
         errorCode = pushOutputData(outPort, outDataPipeId,
                                    std::static_pointer_cast<void>(subObj));
         IVS_DEBUG(
@@ -675,7 +701,7 @@ common::ErrorCode Distributor::doWork(int dataPipeId) {
           ++objectMetadata->numBranches;
 
           int outDataPipeId =
-              channel_id_internal % getOutputConnectorCapacity(target_port);
+              getOutputDataPipeId(target_port, channel_id_internal);
           errorCode = pushOutputData(target_port, outDataPipeId,
                                      std::static_pointer_cast<void>(subObj));
           IVS_DEBUG(
@@ -715,7 +741,7 @@ common::ErrorCode Distributor::doWork(int dataPipeId) {
           objectMetadata->mSubObjectMetadatas.push_back(subObj);
           ++objectMetadata->numBranches;
           int outDataPipeId =
-              channel_id_internal % getOutputConnectorCapacity(target_port);
+              getOutputDataPipeId(target_port, channel_id_internal);
           errorCode = pushOutputData(target_port, outDataPipeId,
                                      std::static_pointer_cast<void>(subObj));
           IVS_DEBUG(
@@ -746,7 +772,7 @@ common::ErrorCode Distributor::doWork(int dataPipeId) {
         ++objectMetadata->numBranches;
         int target_port = *port_it;
         int outDataPipeId =
-            channel_id_internal % getOutputConnectorCapacity(target_port);
+            getOutputDataPipeId(target_port, channel_id_internal);
         errorCode = pushOutputData(target_port, outDataPipeId,
                                    std::static_pointer_cast<void>(subObj));
       }
@@ -580,7 +580,8 @@ common::ErrorCode Dpu::doWork(int dataPipeId) {
     int outDataPipeId =
         getSinkElementFlag()
             ? 0
-            : (channel_id_internal % getOutputConnectorCapacity(outputPort));
+            : getOutputDataPipeId(outputPort, channel_id_internal,
+                                  dpuObj->mFrame->mEndOfStream);
     common::ErrorCode errorCode = pushOutputData(
         outputPort, outDataPipeId, std::static_pointer_cast<void>(dpuObj));
     if (common::ErrorCode::SUCCESS != errorCode) {
@@ -421,7 +421,8 @@ common::ErrorCode Dwa::doWork(int dataPipeId) {
   int outDataPipeId =
       getSinkElementFlag()
           ? 0
-          : (channel_id_internal % getOutputConnectorCapacity(outputPort));
+          : getOutputDataPipeId(outputPort, channel_id_internal,
+                                objectMetadata->mFrame->mEndOfStream);
   common::ErrorCode errorCode =
       pushOutputData(outputPort, outDataPipeId,
                      std::static_pointer_cast<void>(objectMetadata));
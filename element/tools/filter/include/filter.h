@@ -12,6 +12,7 @@
 
 #include <nlohmann/json.hpp>
 #include <queue>
+#include <set>
 
 #include "common/common_defs.h"
 #include "common/logger.h"
@@ -45,6 +46,11 @@ class Filter_Imp {
   void set_type(int type_) { type = type_; };
   void set_direction(int x, int y) { direction.mX = x; direction.mY = y; }
   void set_trajectory_interval(int t) { trajectory_interval = t; };
+  /**
+   * @brief 保存方向筛选的帧计数和轨迹点
+   */
+  void save(common::StateWriter& writer) const;
+  bool load(common::StateReader& reader);
 
  private:
   std::vector<int> classes;
@@ -81,6 +87,21 @@ class Filter : public ::sophon_stream::framework::Element {
 
   common::ErrorCode doWork(int dataPipeId) override;
 
+  /**
+   * @brief 快照按channel_id保存连续追踪计数和方向筛选状态，
+   * 恢复时跳过配置中不存在或者过滤器数量不一致的channel_id
+   */
+  std::uint32_t getStateVersion() const override { return 1; }
+  common::ErrorCode saveState(common::StateWriter& writer) override;
+  common::ErrorCode loadState(common::StateReader& reader) override;
+
+  /**
+   * @brief rules可以热更新，区域、类别、时间段等整体替换
+   */
+  std::set<std::string> getHotConfigureKeys() const override;
+  common::ErrorCode applyConfigure(const nlohmann::json& configure,
+                                   bool check) override;
+
   static constexpr const char* CONFIG_INTERNAL_RULES_FILED = "rules";
   static constexpr const char* CONFIG_INTERNAL_CHANNEL_ID_FILED = "channel_id";
   static constexpr const char* CONFIG_INTERNAL_FILTERS_FILED = "filters";
@@ -104,6 +125,13 @@ class Filter : public ::sophon_stream::framework::Element {
  private:
   int64_t timeToMilliseconds(
       const std::string& time);  // 把时间戳转换成一天内的时间
+  /**
+   * @brief 解析rules，失败时返回PARSE_CONFIGURE_FAIL，输出参数可能只填了一部分
+   */
+  common::ErrorCode parseRules(
+      const nlohmann::json& rules,
+      std::vector<std::vector<Filter_Imp>>& filterImps,
+      std::unordered_map<int, int>& channelIdIndexs);
 
   std::vector<std::vector<Filter_Imp>> Filter_imps;  // 不同路的不同过滤器
   std::unordered_map<int, int>
@@ -15,6 +15,124 @@ namespace filter {
 Filter::Filter() {}
 Filter::~Filter() {}
 
+// 配置不合法时打印错误并返回PARSE_CONFIGURE_FAIL
+#define FILTER_PARSE_CHECK(cond, msg)                   \
+  if (!(cond)) {                                        \
+    IVS_ERROR("{0}, please check your Filter element "  \
+              "configuration file",                     \
+              msg);                                     \
+    return common::ErrorCode::PARSE_CONFIGURE_FAIL;     \
+  }
+
+common::ErrorCode Filter::parseRules(
+    const nlohmann::json& rules,
+    std::vector<std::vector<Filter_Imp>>& filterImps,
+    std::unordered_map<int, int>& channelIdIndexs) {
+  FILTER_PARSE_CHECK(rules.is_array(), "rules must be array");
+  // 遍历 JSON 数组
+  for (auto& filter_array : rules) {
+    std::vector<Filter_Imp> Filter_Imp_s;
+    auto channelidIt = filter_array.find(CONFIG_INTERNAL_CHANNEL_ID_FILED);
+    FILTER_PARSE_CHECK((channelidIt != filter_array.end() &&
+                        channelidIt->is_number_integer()),
+                       "channelid must be int");
+    channelIdIndexs[channelidIt->get<int>()] = filterImps.size();
+
+    auto FiltersIt = filter_array.find(CONFIG_INTERNAL_FILTERS_FILED);
+    FILTER_PARSE_CHECK(
+        (FiltersIt != filter_array.end() && FiltersIt->is_array()),
+        "Filters must be array");
+    for (auto& filter : *FiltersIt) {
+      Filter_Imp Filter_Imp_;
+      Filter_Imp_.set_alert_first_frames(
+          filter.value(CONFIG_INTERNAL_ALERT_FIRST_FRAME_FILED, 0));
+      Filter_Imp_.set_alert_frame_skip_nums(
+          filter.value(CONFIG_INTERNAL_ALERT_FRAME_SKIP_NUM_FILED, 1));
+
+      // Parse areas
+      auto areasIt = filter.find(CONFIG_INTERNAL_AREAS_FILED);
+      FILTER_PARSE_CHECK((areasIt != filter.end() && areasIt->is_array()),
+                         "areas must be array");
+      for (auto& polygon : *areasIt) {
+        FILTER_PARSE_CHECK((polygon.is_array()), "polygon must be array");
+        Area area;
+        for (auto& point : polygon) {
+          auto topIt = point.find(CONFIG_INTERNAL_TOP_FILED);
+          FILTER_PARSE_CHECK(
+              (topIt != point.end() && topIt->is_number_integer()),
+              "top must be int");
+          auto leftIt = point.find(CONFIG_INTERNAL_LEFT_FILED);
+          FILTER_PARSE_CHECK(
+              (leftIt != point.end() && leftIt->is_number_integer()),
+              "left must be int");
+          area.points.push_back({topIt->get<int>(), leftIt->get<int>()});
+        }
+        Filter_Imp_.push_area(area);
+      }
+
+      // Parse classes (assuming it should be a vector of strings)
+      auto classesIt = filter.find(CONFIG_INTERNAL_CLASSES_FILED);
+      FILTER_PARSE_CHECK((classesIt != filter.end() && classesIt->is_array()),
+                         "classes must be array");
+      for (auto& cls : *classesIt) {
+        FILTER_PARSE_CHECK((cls.is_number_integer()), "cls must be int");
+        Filter_Imp_.push_class(cls.get<int>());
+      }
+
+      // Parse times
+      auto timesIt = filter.find(CONFIG_INTERNAL_TIMES_FILED);
+      FILTER_PARSE_CHECK((timesIt != filter.end() && timesIt->is_array()),
+                         "times must be array");
+      for (auto& time_obj : *timesIt) {
+        auto time_sIt = time_obj.find(CONFIG_INTERNAL_TIME_START_FILED);
+        FILTER_PARSE_CHECK(
+            (time_sIt != time_obj.end() && time_sIt->is_string()),
+            "time_start must be string");
+        auto time_tIt = time_obj.find(CONFIG_INTERNAL_TIME_END_FILED);
+        FILTER_PARSE_CHECK(
+            (time_tIt != time_obj.end() && time_tIt->is_string()),
+            "time_end must be string");
+        Filter_Imp_.push_time(
+            {timeToMilliseconds(time_sIt->get<std::string>()),
+             timeToMilliseconds(time_tIt->get<std::string>())});
+      }
+
+      // Parse type
+      auto typeIt = filter.find(CONFIG_INTERNAL_TYPE_FILED);
+      FILTER_PARSE_CHECK(
+          (typeIt != filter.end() && typeIt->is_number_integer()),
+          "type must be int");
+      Filter_Imp_.set_type(typeIt->get<int>());
+
+      // Parse direction
+      auto directionIt = filter.find(CONFIG_INTERNAL_DIRECTION);
+      if (directionIt != filter.end() && directionIt->is_array()) {
+        std::vector<int> direction_array;
+        for (auto& dir_obj : *directionIt) {
+          FILTER_PARSE_CHECK(dir_obj.is_number_integer(),
+                             "dir_obj must be int");
+          direction_array.push_back(dir_obj.get<int>());
+        }
+        FILTER_PARSE_CHECK(direction_array.size() == 2,
+                           "direction_array must have 2 values");
+        Filter_Imp_.set_direction(direction_array[0], direction_array[1]);
+      }
+      auto trajectionIntervalIt =
+          filter.find(CONFIG_INTERNAL_TRAJECTORY_INTERVAL);
+      if (trajectionIntervalIt != filter.end() &&
+          trajectionIntervalIt->is_number_integer()) {
+        Filter_Imp_.set_trajectory_interval(trajectionIntervalIt->get<int>());
+      }
+
+      Filter_Imp_s.push_back(Filter_Imp_);
+    }
+    filterImps.push_back(Filter_Imp_s);
+  }
+  return common::ErrorCode::SUCCESS;
+}
+
+#undef FILTER_PARSE_CHECK
+
 common::ErrorCode Filter::initInternal(const std::string& json) {
   common::ErrorCode errorCode = common::ErrorCode::SUCCESS;
   do {
@@ -24,132 +142,86 @@ common::ErrorCode Filter::initInternal(const std::string& json) {
       errorCode = common::ErrorCode::PARSE_CONFIGURE_FAIL;
       break;
     }
-    // 遍历 JSON 数组
+
     auto rulesIt = configure.find(CONFIG_INTERNAL_RULES_FILED);
-    STREAM_CHECK((rulesIt != configure.end() && rulesIt->is_array()),
-                 "rules must be array, please check your Filter element "
+    STREAM_CHECK((rulesIt != configure.end() &&
+                  common::ErrorCode::SUCCESS ==
+                      parseRules(*rulesIt, Filter_imps, channel_id_indexs)),
+                 "rules is invalid, please check your Filter element "
                  "configuration file");
-    for (auto& filter_array : *rulesIt) {
-      std::vector<Filter_Imp> Filter_Imp_s;
-      auto channelidIt = filter_array.find(CONFIG_INTERNAL_CHANNEL_ID_FILED);
-      STREAM_CHECK((channelidIt != filter_array.end() &&
-                    channelidIt->is_number_integer()),
-                   "channelid must be int, please check your Filter element "
-                   "configuration file");
-      channel_id_indexs[channelidIt->get<int>()] = Filter_imps.size();
-      auto FiltersIt = filter_array.find(CONFIG_INTERNAL_FILTERS_FILED);
-      STREAM_CHECK((FiltersIt != filter_array.end() && FiltersIt->is_array()),
-                   "Filters must be array, please check your Filter element "
-                   "configuration file");
-      for (auto& filter : *FiltersIt) {
-        Filter_Imp Filter_Imp_;
-        Filter_Imp_.set_alert_first_frames(
-            filter.value(CONFIG_INTERNAL_ALERT_FIRST_FRAME_FILED, 0));
-        Filter_Imp_.set_alert_frame_skip_nums(
-            filter.value(CONFIG_INTERNAL_ALERT_FRAME_SKIP_NUM_FILED, 1));
-
-        // Parse areas
-        auto areasIt = filter.find(CONFIG_INTERNAL_AREAS_FILED);
-
-        STREAM_CHECK((areasIt != filter.end() && areasIt->is_array()),
-                     "areas must be array, please check your Filter element "
-                     "configuration file");
-        for (auto& polygon : *areasIt) {
-          STREAM_CHECK(
-              (polygon.is_array()),
-              "polygon must be array, please check your Filter element "
-              "configuration file");
-          Area area;
-          for (auto& point : polygon) {
-            auto topIt = point.find(CONFIG_INTERNAL_TOP_FILED);
-            STREAM_CHECK((topIt != point.end() && topIt->is_number_integer()),
-                         "top must be int, please check your Filter element "
-                         "configuration file");
-            auto leftIt = point.find(CONFIG_INTERNAL_LEFT_FILED);
-            STREAM_CHECK((leftIt != point.end() && leftIt->is_number_integer()),
-                         "left must be int, please check your Filter element "
-                         "configuration file");
-            area.points.push_back({topIt->get<int>(), leftIt->get<int>()});
-          }
-          Filter_Imp_.push_area(area);
-        }
+    continue_frame_num.resize(Filter_imps.size());
 
-        // Parse classes (assuming it should be a vector of strings)
-        auto classesIt = filter.find(CONFIG_INTERNAL_CLASSES_FILED);
-
-        STREAM_CHECK((classesIt != filter.end() && classesIt->is_array()),
-                     "classes must be array, please check your Filter element "
-                     "configuration file");
-        for (auto& cls : *classesIt) {
-          STREAM_CHECK((cls.is_number_integer()),
-                       "cls must be int, please check your Filter element "
-                       "configuration file");
-          Filter_Imp_.push_class(cls.get<int>());
-        }
+  } while (false);
+  return errorCode;
+}
 
-        // Parse times
-        auto timesIt = filter.find(CONFIG_INTERNAL_TIMES_FILED);
-
-        STREAM_CHECK((timesIt != filter.end() && timesIt->is_array()),
-                     "times must be array, please check your Filter element "
-                     "configuration file");
-        for (auto& time_obj : *timesIt) {
-          auto time_sIt = time_obj.find(CONFIG_INTERNAL_TIME_START_FILED);
-
-          STREAM_CHECK(
-              (time_sIt != time_obj.end() && time_sIt->is_string()),
-              "time_start must be string, please check your Filter element "
-              "configuration file");
-          auto time_tIt = time_obj.find(CONFIG_INTERNAL_TIME_END_FILED);
-
-          STREAM_CHECK(
-              (time_tIt != time_obj.end() && time_tIt->is_string()),
-              "time_end must be string, please check your Filter element "
-              "configuration file");
-          Filter_Imp_.push_time(
-              {timeToMilliseconds(time_sIt->get<std::string>()),
-               timeToMilliseconds(time_tIt->get<std::string>())});
-        }
+std::set<std::string> Filter::getHotConfigureKeys() const {
+  return {CONFIG_INTERNAL_RULES_FILED};
+}
 
-        // Parse type
-        auto typeIt = filter.find(CONFIG_INTERNAL_TYPE_FILED);
-        STREAM_CHECK((typeIt != filter.end() && typeIt->is_number_integer()),
-                     "type must be int, please check your Filter element "
-                     "configuration file");
-        Filter_Imp_.set_type(typeIt->get<int>());
-        // STREAM_CHECK((typeIt->get<int>() == 0 || typeIt->get<int>() == 1 ),
-        //              "type only support 0, please check your Filter element "
-        //              "configuration file");
-
-        // Parse direction
-        auto directionIt = filter.find(CONFIG_INTERNAL_DIRECTION);
-        if(directionIt != filter.end() && directionIt->is_array()) {
-          std::vector<int> direction_array;
-          for(auto& dir_obj : *directionIt) {
-            STREAM_CHECK(dir_obj.is_number_integer(),
-                        "dir_obj must be int, please check your Filter element "
-                        "configuration file");
-            direction_array.push_back(dir_obj.get<int>());
-          }
-          STREAM_CHECK(direction_array.size() == 2, 
-                      "direction_array must have 2 values.");
-          Filter_Imp_.set_direction(direction_array[0], direction_array[1]);
-        }
-        auto trajectionIntervalIt = filter.find(CONFIG_INTERNAL_TRAJECTORY_INTERVAL);
-        if(trajectionIntervalIt != filter.end() 
-        && trajectionIntervalIt->is_number_integer()) {
-          Filter_Imp_.set_trajectory_interval(trajectionIntervalIt->get<int>());
-        }
+common::ErrorCode Filter::applyConfigure(const nlohmann::json& configure,
+                                         bool check) {
+  auto rulesIt = configure.find(CONFIG_INTERNAL_RULES_FILED);
+  if (configure.end() == rulesIt) return common::ErrorCode::SUCCESS;
+
+  std::vector<std::vector<Filter_Imp>> filterImps;
+  std::unordered_map<int, int> channelIdIndexs;
+  common::ErrorCode errorCode =
+      parseRules(*rulesIt, filterImps, channelIdIndexs);
+  if (common::ErrorCode::SUCCESS != errorCode || check) return errorCode;
+
+  // 仍然存在的channel_id保留连续追踪计数，方向筛选的轨迹从新规则开始重新统计
+  std::vector<std::unordered_map<std::string, int>> continueFrameNum(
+      filterImps.size());
+  for (auto& pair : channelIdIndexs) {
+    auto oldIt = channel_id_indexs.find(pair.first);
+    if (oldIt != channel_id_indexs.end())
+      continueFrameNum[pair.second] =
+          std::move(continue_frame_num[oldIt->second]);
+  }
+  Filter_imps = std::move(filterImps);
+  channel_id_indexs = std::move(channelIdIndexs);
+  continue_frame_num = std::move(continueFrameNum);
+  return common::ErrorCode::SUCCESS;
+}
 
-        Filter_Imp_s.push_back(Filter_Imp_);
-      }
-      Filter_imps.push_back(Filter_Imp_s);
-      std::unordered_map<std::string, int> continue_frame_num_;
-      continue_frame_num.push_back(continue_frame_num_);
-    }
+common::ErrorCode Filter::saveState(common::StateWriter& writer) {
+  writer.write<std::uint32_t>(channel_id_indexs.size());
+  for (auto& pair : channel_id_indexs) {
+    writer.write(pair.first);
+    writer.write(continue_frame_num[pair.second]);
+    writer.write<std::uint32_t>(Filter_imps[pair.second].size());
+    for (auto& filter_imp : Filter_imps[pair.second]) filter_imp.save(writer);
+  }
+  return common::ErrorCode::SUCCESS;
+}
 
-  } while (false);
-  return errorCode;
+common::ErrorCode Filter::loadState(common::StateReader& reader) {
+  std::uint32_t channel_num = 0;
+  reader.read(channel_num);
+  for (std::uint32_t i = 0; i < channel_num && reader.ok(); i++) {
+    int channel_id = 0;
+    std::unordered_map<std::string, int> continue_frame_num_;
+    std::uint32_t filter_num = 0;
+    reader.read(channel_id);
+    reader.read(continue_frame_num_);
+    reader.read(filter_num);
+    auto indexIt = channel_id_indexs.find(channel_id);
+    bool matched = indexIt != channel_id_indexs.end() &&
+                   Filter_imps[indexIt->second].size() == filter_num;
+    if (!matched)
+      IVS_WARN("Skip filter snapshot of channel_id: {0:d}", channel_id);
+    for (std::uint32_t j = 0; j < filter_num && reader.ok(); j++) {
+      Filter_Imp skipped;
+      Filter_Imp& filter_imp =
+          matched ? Filter_imps[indexIt->second][j] : skipped;
+      filter_imp.load(reader);
+    }
+    if (matched && reader.ok())
+      continue_frame_num[indexIt->second] = continue_frame_num_;
+  }
+  return reader.ok() ? common::ErrorCode::SUCCESS
+                     : common::ErrorCode::SNAPSHOT_FAIL;
 }
 
 common::ErrorCode Filter::doWork(int dataPipeId) {
@@ -175,7 +247,8 @@ common::ErrorCode Filter::doWork(int dataPipeId) {
   int outDataPipeId =
       getSinkElementFlag()
           ? 0
-          : (channel_id_internal % getOutputConnectorCapacity(outputPort));
+          : getOutputDataPipeId(outputPort, channel_id_internal,
+                                objectMetadata->mFrame->mEndOfStream);
   if (objectMetadata->mFrame->mEndOfStream) {
     common::ErrorCode errorCode =
         pushOutputData(outputPort, outDataPipeId,
@@ -465,6 +538,19 @@ bool Filter_Imp::isInDirection(
   frame_count++;
   return flag;
 }
+void Filter_Imp::save(common::StateWriter& writer) const {
+  writer.write(frame_count);
+  writer.write(trajectories_cnt);
+  writer.write(trajectories_pre);
+}
+
+bool Filter_Imp::load(common::StateReader& reader) {
+  reader.read(frame_count);
+  reader.read(trajectories_cnt);
+  reader.read(trajectories_pre);
+  return reader.ok();
+}
+
 bool Filter_Imp::istrack(
     std::shared_ptr<common::ObjectMetadata> objectMetadata,
     std::unordered_map<std::string, int>& continue_frame_num_) {
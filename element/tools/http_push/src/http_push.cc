@@ -210,7 +210,8 @@ common::ErrorCode HttpPush::doWork(int dataPipeId) {
   int outDataPipeId =
       getSinkElementFlag()
           ? 0
-          : (channel_id_internal % getOutputConnectorCapacity(outputPort));
+          : getOutputDataPipeId(outputPort, channel_id_internal,
+                                objectMetadata->mFrame->mEndOfStream);
   common::ErrorCode errorCode =
       pushOutputData(outputPort, outDataPipeId,
                      std::static_pointer_cast<void>(objectMetadata));
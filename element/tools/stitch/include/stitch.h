@@ -13,6 +13,7 @@
 #include "common/object_metadata.h"
 #include "element.h"
 #include "common/profiler.h"
+#include "frame_synchronizer.h"
 
 namespace sophon_stream {
 namespace element {
@@ -40,6 +41,11 @@ class Stitch : public ::sophon_stream::framework::Element {
   std::string stitch_mode;
 
   ::sophon_stream::common::FpsProfiler mFpsProfiler;
+
+  // 按dataPipeId对齐两路输入，默认要求帧号相同
+  framework::FrameSynchronizer::Options mSyncOptions;
+  std::map<int, std::shared_ptr<framework::FrameSynchronizer>>
+      mSynchronizers;
 };
 
 }  // namespace dpu
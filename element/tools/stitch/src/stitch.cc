@@ -26,6 +26,11 @@ common::ErrorCode Stitch::initInternal(const std::string& json) {
     errorCode = common::ErrorCode::PARSE_CONFIGURE_FAIL;
   }
   mFpsProfiler.config("stitch fps:", 100);
+  errorCode =
+      framework::FrameSynchronizer::parseOptions(configure, mSyncOptions);
+  if (common::ErrorCode::SUCCESS != errorCode) return errorCode;
+  for (int i = 0; i < getThreadNumber(); ++i)
+    mSynchronizers[i] = std::make_shared<framework::FrameSynchronizer>();
   stitch_mode = configure.find(CONFIG_INTERNAL_STITCH_MODE_FILED)->get<std::string>();
   
 
@@ -89,6 +94,7 @@ common::ErrorCode Stitch::stitch_work(std::shared_ptr<common::ObjectMetadata> le
   stitchObj->mFrame->mHeight = stitchObj->mFrame->mSpData->height;
   stitchObj->mFrame->mChannelId = leftObj->mFrame->mChannelId;
   stitchObj->mFrame->mFrameId = leftObj->mFrame->mFrameId;
+  stitchObj->mFrame->mTimestamp = leftObj->mFrame->mTimestamp;
 
 
   return common::ErrorCode::SUCCESS;
@@ -102,27 +108,44 @@ common::ErrorCode Stitch::doWork(int dataPipeId) {
     outputPort = outputPorts[0];
   }
 
-  common::ObjectMetadatas inputs;
-
-  for (auto inputPort : inputPorts) {
-    auto data = popInputData(inputPort, dataPipeId);
-    while (!data && (getThreadStatus() == ThreadStatus::RUN)) {
-      std::this_thread::sleep_for(std::chrono::milliseconds(10));
-      data = popInputData(inputPort, dataPipeId);
+  auto& synchronizer = mSynchronizers[dataPipeId];
+  if (!synchronizer->configured())
+    synchronizer->configure(inputPorts.size(), mSyncOptions);
+
+  // 不阻塞地取出各port已到达的数据，较慢的一路不会卡住其他port
+  bool received = false;
+  for (std::size_t i = 0; i < inputPorts.size(); ++i) {
+    for (int n = 0; n < mSyncOptions.bufferSize; ++n) {
+      auto data = popInputData(inputPorts[i], dataPipeId);
+      if (data == nullptr) break;
+      received = true;
+      auto objectMetadata =
+          std::static_pointer_cast<common::ObjectMetadata>(data);
+      IVS_DEBUG("Got Input, port id = {0}, channel_id = {1}, frame_id = {2}",
+                inputPorts[i], objectMetadata->mFrame->mChannelId,
+                objectMetadata->mFrame->mFrameId);
+      // EOS帧只用来通知同步器不再等待这一路
+      if (objectMetadata->mFrame->mSpData == nullptr &&
+          !objectMetadata->mFrame->mEndOfStream)
+        continue;
+      synchronizer->push(i, objectMetadata,
+                         framework::FrameSynchronizer::steadyNowUs());
     }
-    if (data == nullptr) return common::ErrorCode::SUCCESS;
-
-    auto objectMetadata =
-        std::static_pointer_cast<common::ObjectMetadata>(data);
-    inputs.emplace_back(objectMetadata);
-    IVS_DEBUG("Got Input, port id = {0}, channel_id = {1}, frame_id = {2}",
-              inputPort, objectMetadata->mFrame->mChannelId,
-              objectMetadata->mFrame->mFrameId);
   }
 
+  common::ObjectMetadatas inputs;
+  if (!synchronizer->pop(inputs,
+                         framework::FrameSynchronizer::steadyNowUs())) {
+    if (!received) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    return common::ErrorCode::SUCCESS;
+  }
+  std::int64_t dropped = synchronizer->takeDropped();
+  if (dropped > 0)
+    IVS_DEBUG("Drop {0} unaligned frames, dataPipeId: {1}", dropped,
+              dataPipeId);
+
   if (inputs[0]->mFrame->mSpData != nullptr &&
-      inputs[1]->mFrame->mSpData != nullptr &&
-      inputs[0]->mFrame->mFrameId == inputs[1]->mFrame->mFrameId) {
+      inputs[1]->mFrame->mSpData != nullptr) {
     std::shared_ptr<common::ObjectMetadata> stitchObj =
         std::make_shared<common::ObjectMetadata>();
     stitchObj->mFrame = std::make_shared<sophon_stream::common::Frame>();
@@ -135,7 +158,8 @@ common::ErrorCode Stitch::doWork(int dataPipeId) {
     int outDataPipeId =
         getSinkElementFlag()
             ? 0
-            : (channel_id_internal % getOutputConnectorCapacity(outputPort));
+            : getOutputDataPipeId(outputPort, channel_id_internal,
+                                  stitchObj->mFrame->mEndOfStream);
     common::ErrorCode errorCode = pushOutputData(
         outputPort, outDataPipeId, std::static_pointer_cast<void>(stitchObj));
     if (common::ErrorCode::SUCCESS != errorCode) {
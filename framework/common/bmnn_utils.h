@@ -8,8 +8,11 @@
 #include <set>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include "bmruntime_interface.h"
+#include "inference_backend.h"
+#include "logger.h"
 #include "no_copyable.h"
 
 extern "C" {
@@ -261,8 +264,12 @@ class BMNNNetwork : public ::sophon_stream::common::NoCopyable {
   std::unordered_map<std::string, bm_tensor_t*> m_mapInputs;
   std::unordered_map<std::string, bm_tensor_t*> m_mapOutputs;
 
+  // 非空时forward录制TPU的输出，或者用录制的输出/参考模型代替TPU推理
+  std::shared_ptr<::sophon_stream::common::ReplayBackend> m_backend;
+
  public:
   BMNNNetwork(void* bmrt, const std::string& name) : m_bmrt(bmrt) {
+    m_backend = ::sophon_stream::common::ReplayBackend::fromEnv();
     m_handle = static_cast<bm_handle_t>(bmrt_get_bm_handle(bmrt));
     m_netinfo = bmrt_get_network_info(bmrt, name.c_str());
     m_max_batch = -1;
@@ -320,6 +327,11 @@ class BMNNNetwork : public ::sophon_stream::common::NoCopyable {
 
     // assert(m_netinfo->stage_num == 1);
     showInfo();
+
+    // 录制时同时写出网络描述，回放时HostNetwork不需要再加载bmodel
+    if (m_backend &&
+        m_backend->mode() == ::sophon_stream::common::ReplayBackend::Mode::RECORD)
+      m_backend->saveNetworkInfo(networkInfo());
   }
 
   ~BMNNNetwork() {
@@ -390,6 +402,10 @@ class BMNNNetwork : public ::sophon_stream::common::NoCopyable {
     for (int i = 0; i < m_netinfo->output_num; ++i)
       temp_outputTensors[i] = *outputTensors[i];
 
+    if (m_backend && m_backend->mode() ==
+                         ::sophon_stream::common::ReplayBackend::Mode::REPLAY)
+      return replay(temp_inputTensors, temp_outputTensors);
+
     bool ok = false;
     if constexpr (dual_core) {
       // if true, use double core in inference. support in bm1688
@@ -416,6 +432,147 @@ class BMNNNetwork : public ::sophon_stream::common::NoCopyable {
       return -1;
     }
 
+    if (m_backend) return record(temp_inputTensors, temp_outputTensors);
+    return 0;
+  }
+
+  std::shared_ptr<::sophon_stream::common::ReplayBackend> backend() {
+    return m_backend;
+  }
+
+  /**
+   * @brief 按stage 0的shape生成不依赖bmodel的网络描述
+   */
+  ::sophon_stream::common::NetworkInfo networkInfo() const {
+    ::sophon_stream::common::NetworkInfo info;
+    info.name = m_netinfo->name;
+    auto describe = [](const char* name, bm_data_type_t dtype,
+                       const bm_shape_t& shape, float scale) {
+      ::sophon_stream::common::TensorInfo tensor;
+      tensor.name = name;
+      tensor.dtype = dtype;
+      tensor.shape.assign(shape.dims, shape.dims + shape.num_dims);
+      tensor.scale = scale;
+      return tensor;
+    };
+    for (int i = 0; i < m_netinfo->input_num; ++i)
+      info.inputs.push_back(describe(
+          m_netinfo->input_names[i], m_netinfo->input_dtypes[i],
+          m_netinfo->stages[0].input_shapes[i], m_netinfo->input_scales[i]));
+    for (int i = 0; i < m_netinfo->output_num; ++i)
+      info.outputs.push_back(describe(
+          m_netinfo->output_names[i], m_netinfo->output_dtypes[i],
+          m_netinfo->stages[0].output_shapes[i], m_netinfo->output_scales[i]));
+    return info;
+  }
+
+ private:
+  int to_host(const bm_tensor_t& tensor,
+              ::sophon_stream::common::HostTensor& host) {
+    host.dtype = tensor.dtype;
+    host.shape.assign(tensor.shape.dims,
+                      tensor.shape.dims + tensor.shape.num_dims);
+    host.data.resize(bmrt_tensor_bytesize(&tensor));
+    bm_status_t ret = bm_memcpy_d2s_partial(m_handle, host.data.data(),
+                                            tensor.device_mem,
+                                            host.data.size());
+    return BM_SUCCESS == ret ? 0 : -1;
+  }
+
+  int record(const bm_tensor_t* inputTensors,
+             const bm_tensor_t* outputTensors) {
+    ::sophon_stream::common::HostTensors inputs(m_netinfo->input_num);
+    ::sophon_stream::common::HostTensors outputs(m_netinfo->output_num);
+    for (int i = 0; i < m_netinfo->input_num; ++i)
+      if (to_host(inputTensors[i], inputs[i]) != 0) return -1;
+    for (int i = 0; i < m_netinfo->output_num; ++i)
+      if (to_host(outputTensors[i], outputs[i]) != 0) return -1;
+    return m_backend->record(m_netinfo->name, inputs, outputs);
+  }
+
+  // 输入拷回主机计算哈希，取得的输出写回outputTensors的device mem，不启动TPU推理
+  int replay(const bm_tensor_t* inputTensors,
+             const bm_tensor_t* outputTensors) {
+    ::sophon_stream::common::HostTensors inputs(m_netinfo->input_num);
+    ::sophon_stream::common::HostTensors outputs(m_netinfo->output_num);
+    for (int i = 0; i < m_netinfo->input_num; ++i)
+      if (to_host(inputTensors[i], inputs[i]) != 0) return -1;
+    for (int i = 0; i < m_netinfo->output_num; ++i) {
+      outputs[i].dtype = outputTensors[i].dtype;
+      outputs[i].shape.assign(
+          outputTensors[i].shape.dims,
+          outputTensors[i].shape.dims + outputTensors[i].shape.num_dims);
+      outputs[i].data.resize(bmrt_tensor_bytesize(&outputTensors[i]));
+    }
+    if (m_backend->forward(m_netinfo->name, inputs, outputs) != 0) return -1;
+    for (int i = 0; i < m_netinfo->output_num; ++i) {
+      size_t size = outputs[i].data.size();
+      if (size > bm_mem_get_device_size(outputTensors[i].device_mem)) {
+        IVS_ERROR("Replayed output {0} of {1} exceeds device mem", i,
+                  m_netinfo->name);
+        return -1;
+      }
+      if (BM_SUCCESS != bm_memcpy_s2d_partial(m_handle,
+                                              outputTensors[i].device_mem,
+                                              outputs[i].data.data(), size))
+        return -1;
+    }
+    return 0;
+  }
+
+ public:
+
+  /**
+   * @brief 用全零输入把每个stage（即每个batch size）都推理一遍，
+   * 让首帧不再承担运行时的加载开销。回放模式下不使用TPU，直接返回
+   * @return 0表示成功
+   */
+  int warmup() {
+    if (m_backend && m_backend->mode() ==
+                         ::sophon_stream::common::ReplayBackend::Mode::REPLAY)
+      return 0;
+    for (int s = 0; s < m_netinfo->stage_num; s++) {
+      std::vector<bm_tensor_t> inputTensors(m_netinfo->input_num);
+      std::vector<bm_tensor_t> outputTensors(m_netinfo->output_num);
+      bool ok = true;
+      for (int i = 0; i < m_netinfo->input_num; ++i) {
+        inputTensors[i].dtype = m_netinfo->input_dtypes[i];
+        inputTensors[i].shape = m_netinfo->stages[s].input_shapes[i];
+        inputTensors[i].st_mode = BM_STORE_1N;
+        inputTensors[i].device_mem = bm_mem_null();
+        ok = ok && BM_SUCCESS == bm_malloc_device_byte_heap(
+                                     m_handle, &inputTensors[i].device_mem, 0,
+                                     bmrt_tensor_bytesize(&inputTensors[i]));
+        ok = ok && BM_SUCCESS == bm_memset_device(m_handle, 0,
+                                                  inputTensors[i].device_mem);
+      }
+      for (int i = 0; i < m_netinfo->output_num; ++i) {
+        outputTensors[i].dtype = m_netinfo->output_dtypes[i];
+        outputTensors[i].shape = m_netinfo->stages[s].output_shapes[i];
+        outputTensors[i].st_mode = BM_STORE_1N;
+        outputTensors[i].device_mem = bm_mem_null();
+        ok = ok && BM_SUCCESS == bm_malloc_device_byte_heap(
+                                     m_handle, &outputTensors[i].device_mem, 0,
+                                     bmrt_tensor_bytesize(&outputTensors[i]));
+      }
+      if (ok) {
+        ok = bmrt_launch_tensor_ex(m_bmrt, m_netinfo->name,
+                                   inputTensors.data(), m_netinfo->input_num,
+                                   outputTensors.data(), m_netinfo->output_num,
+                                   true, false);
+        ok = ok && BM_SUCCESS == bm_thread_sync(m_handle);
+      }
+      for (auto& tensor : inputTensors)
+        if (tensor.device_mem.size != 0)
+          bm_free_device(m_handle, tensor.device_mem);
+      for (auto& tensor : outputTensors)
+        if (tensor.device_mem.size != 0)
+          bm_free_device(m_handle, tensor.device_mem);
+      if (!ok) {
+        std::cout << "warmup of stage " << s << " failed" << std::endl;
+        return -1;
+      }
+    }
     return 0;
   }
 
@@ -0,0 +1,130 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#include "cpu_image_ops.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace sophon_stream {
+namespace common {
+
+bool cpuCrop(const HostImage& src, int x, int y, int w, int h,
+             HostImage& dst) {
+  int x0 = std::max(x, 0), y0 = std::max(y, 0);
+  int x1 = std::min(x + w, src.width), y1 = std::min(y + h, src.height);
+  if (x1 <= x0 || y1 <= y0) return false;
+  dst.create(x1 - x0, y1 - y0, src.channels);
+  std::size_t rowBytes = static_cast<std::size_t>(dst.width) * src.channels;
+  for (int r = 0; r < dst.height; ++r)
+    std::memcpy(dst.row(r), src.row(y0 + r) + x0 * src.channels, rowBytes);
+  return true;
+}
+
+namespace {
+
+// 按像素中心对齐计算源坐标，预先算好每一列的两个采样点和权重
+struct Sample {
+  int i0;
+  int i1;
+  float w1;
+};
+
+std::vector<Sample> makeSamples(int srcSize, int dstSize, bool bilinear) {
+  std::vector<Sample> samples(dstSize);
+  float scale = static_cast<float>(srcSize) / dstSize;
+  for (int d = 0; d < dstSize; ++d) {
+    float s = (d + 0.5f) * scale - 0.5f;
+    if (!bilinear) {
+      int i = std::min(static_cast<int>(std::floor((d + 0.5f) * scale)),
+                       srcSize - 1);
+      samples[d] = {i, i, 0.f};
+      continue;
+    }
+    s = std::max(s, 0.f);
+    int i0 = std::min(static_cast<int>(s), srcSize - 1);
+    int i1 = std::min(i0 + 1, srcSize - 1);
+    samples[d] = {i0, i1, s - i0};
+  }
+  return samples;
+}
+
+}  // namespace
+
+void cpuResize(const HostImage& src, int dstW, int dstH, HostImage& dst,
+               bool bilinear, int padX, int padY, int resizeW, int resizeH,
+               std::uint8_t padValue) {
+  const int c = src.channels;
+  dst.create(dstW, dstH, c);
+  if (resizeW <= 0 || resizeH <= 0) {
+    padX = padY = 0;
+    resizeW = dstW;
+    resizeH = dstH;
+  } else {
+    std::fill(dst.data.begin(), dst.data.end(), padValue);
+    resizeW = std::min(resizeW, dstW - padX);
+    resizeH = std::min(resizeH, dstH - padY);
+  }
+  if (src.width <= 0 || src.height <= 0 || resizeW <= 0 || resizeH <= 0)
+    return;
+
+  auto xs = makeSamples(src.width, resizeW, bilinear);
+  auto ys = makeSamples(src.height, resizeH, bilinear);
+  // 先在水平方向插值两行源数据，再在垂直方向合成一行输出
+  std::vector<float> row0(resizeW * c), row1(resizeW * c);
+  auto horizontal = [&](int sy, std::vector<float>& out) {
+    const std::uint8_t* in = src.row(sy);
+    for (int x = 0; x < resizeW; ++x) {
+      const std::uint8_t* p0 = in + xs[x].i0 * c;
+      const std::uint8_t* p1 = in + xs[x].i1 * c;
+      float w1 = xs[x].w1, w0 = 1.f - w1;
+      for (int k = 0; k < c; ++k) out[x * c + k] = p0[k] * w0 + p1[k] * w1;
+    }
+  };
+  int cached0 = -1, cached1 = -1;
+  for (int y = 0; y < resizeH; ++y) {
+    const Sample& sy = ys[y];
+    if (sy.i0 != cached0) {
+      if (sy.i0 == cached1) {
+        std::swap(row0, row1);
+        std::swap(cached0, cached1);
+      } else {
+        horizontal(sy.i0, row0);
+        cached0 = sy.i0;
+      }
+    }
+    if (sy.i1 != cached1) {
+      horizontal(sy.i1, row1);
+      cached1 = sy.i1;
+    }
+    std::uint8_t* out = dst.row(padY + y) + padX * c;
+    float w1 = sy.w1, w0 = 1.f - w1;
+    for (int i = 0; i < resizeW * c; ++i) {
+      float v = row0[i] * w0 + row1[i] * w1 + 0.5f;
+      out[i] = static_cast<std::uint8_t>(std::min(std::max(v, 0.f), 255.f));
+    }
+  }
+}
+
+void cpuConvertTo(const HostImage& src, const float* alpha, const float* beta,
+                  bool swapRB, float* dst) {
+  const int c = src.channels;
+  const std::size_t area = static_cast<std::size_t>(src.width) * src.height;
+  for (int k = 0; k < c; ++k) {
+    int from = swapRB && c == 3 ? 2 - k : k;
+    float a = alpha[k], b = beta[k];
+    const std::uint8_t* in = src.data.data() + from;
+    float* out = dst + k * area;
+    for (std::size_t i = 0; i < area; ++i) out[i] = in[i * c] * a + b;
+  }
+}
+
+}  // namespace common
+}  // namespace sophon_stream
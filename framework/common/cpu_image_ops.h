@@ -0,0 +1,77 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SOPHON_STREAM_COMMON_CPU_IMAGE_OPS_H_
+#define SOPHON_STREAM_COMMON_CPU_IMAGE_OPS_H_
+
+#include <cstdint>
+#include <vector>
+
+namespace sophon_stream {
+namespace common {
+
+/**
+ * @brief 主机内存中的packed图像，例如BGR，按行连续存放
+ */
+struct HostImage {
+  int width = 0;
+  int height = 0;
+  int channels = 3;
+  std::vector<std::uint8_t> data;
+
+  void create(int w, int h, int c) {
+    width = w;
+    height = h;
+    channels = c;
+    data.assign(static_cast<std::size_t>(w) * h * c, 0);
+  }
+  std::uint8_t* row(int y) {
+    return data.data() + static_cast<std::size_t>(y) * width * channels;
+  }
+  const std::uint8_t* row(int y) const {
+    return data.data() + static_cast<std::size_t>(y) * width * channels;
+  }
+};
+
+/**
+ * @brief 以下为bmcv前处理的CPU参考实现，供没有TPU时的测试和基准使用。
+ * 结果与bmcv在插值取整上可能有±1的差别，不用于精度对齐
+ */
+
+/**
+ * @brief 裁剪，对应bmcv_image_crop，矩形超出原图的部分被截掉
+ * @return 裁剪后矩形为空时返回false
+ */
+bool cpuCrop(const HostImage& src, int x, int y, int w, int h, HostImage& dst);
+
+/**
+ * @brief 缩放，对应bmcv_image_vpp_convert_padding
+ * @brief
+ * 原图缩放到dst中(padX, padY)起、大小为resizeW x resizeH的区域，其余部分填充padValue；
+ * resizeW、resizeH小于等于0时缩放到整个dst
+ * @param dstW 目标宽度
+ * @param dstH 目标高度
+ * @param bilinear true为双线性插值，false为最近邻
+ */
+void cpuResize(const HostImage& src, int dstW, int dstH, HostImage& dst,
+               bool bilinear = true, int padX = 0, int padY = 0,
+               int resizeW = 0, int resizeH = 0, std::uint8_t padValue = 114);
+
+/**
+ * @brief 归一化并转为planar的float，对应bmcv_image_convert_to
+ * @brief dst[c][y][x] = src[y][x][c'] * alpha[c] + beta[c]，swapRB为true时c'为BGR与RGB互换后的通道
+ * @param dst 至少channels * height * width个float
+ */
+void cpuConvertTo(const HostImage& src, const float* alpha, const float* beta,
+                  bool swapRB, float* dst);
+
+}  // namespace common
+}  // namespace sophon_stream
+
+#endif  // SOPHON_STREAM_COMMON_CPU_IMAGE_OPS_H_
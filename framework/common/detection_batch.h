@@ -0,0 +1,142 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SOPHON_STREAM_COMMON_DETECTION_BATCH_H_
+#define SOPHON_STREAM_COMMON_DETECTION_BATCH_H_
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "detected_object_metadata.h"
+#include "tracked_object_metadata.h"
+
+namespace sophon_stream {
+namespace common {
+
+/**
+ * @brief 一帧的检测结果，按列连续存放
+ * @brief
+ * 第i个目标由各数组的第i个元素组成，所有数组长度相同。只保存跟踪和过滤需要的字段，
+ * 需要完整字段的element通过toLegacy()得到DetectedObjectMetadata
+ */
+struct DetectionBatch {
+  std::size_t size() const { return mScores.size(); }
+
+  bool empty() const { return mScores.empty(); }
+
+  void reserve(std::size_t n) {
+    mX.reserve(n);
+    mY.reserve(n);
+    mWidth.reserve(n);
+    mHeight.reserve(n);
+    mScores.reserve(n);
+    mClassIds.reserve(n);
+    mTrackIds.reserve(n);
+  }
+
+  void clear() {
+    mX.clear();
+    mY.clear();
+    mWidth.clear();
+    mHeight.clear();
+    mScores.clear();
+    mClassIds.clear();
+    mTrackIds.clear();
+  }
+
+  void push_back(int x, int y, int width, int height, float score,
+                 int classId, long long trackId = -1) {
+    mX.push_back(x);
+    mY.push_back(y);
+    mWidth.push_back(width);
+    mHeight.push_back(height);
+    mScores.push_back(score);
+    mClassIds.push_back(classId);
+    mTrackIds.push_back(trackId);
+  }
+
+  /**
+   * @brief 只保留keep[i]不为0的目标，保持原有顺序
+   */
+  void compact(const std::vector<char>& keep) {
+    std::size_t n = 0;
+    for (std::size_t i = 0; i < size(); ++i) {
+      if (!keep[i]) continue;
+      mX[n] = mX[i];
+      mY[n] = mY[i];
+      mWidth[n] = mWidth[i];
+      mHeight[n] = mHeight[i];
+      mScores[n] = mScores[i];
+      mClassIds[n] = mClassIds[i];
+      mTrackIds[n] = mTrackIds[i];
+      ++n;
+    }
+    mX.resize(n);
+    mY.resize(n);
+    mWidth.resize(n);
+    mHeight.resize(n);
+    mScores.resize(n);
+    mClassIds.resize(n);
+    mTrackIds.resize(n);
+  }
+
+  bool hasTrackIds() const {
+    for (auto trackId : mTrackIds)
+      if (trackId >= 0) return true;
+    return false;
+  }
+
+  /**
+   * @brief 追加为DetectedObjectMetadata，有跟踪id时同时追加TrackedObjectMetadata
+   */
+  void toLegacy(
+      std::vector<std::shared_ptr<DetectedObjectMetadata> >& detected,
+      std::vector<std::shared_ptr<TrackedObjectMetadata> >& tracked) const {
+    bool withTrack = hasTrackIds();
+    detected.reserve(detected.size() + size());
+    if (withTrack) tracked.reserve(tracked.size() + size());
+    for (std::size_t i = 0; i < size(); ++i) {
+      auto detData = std::make_shared<DetectedObjectMetadata>();
+      detData->mBox = Rectangle<int>(mX[i], mY[i], mWidth[i], mHeight[i]);
+      detData->mScores.push_back(mScores[i]);
+      detData->mClassify = mClassIds[i];
+      if (mClassNames && mClassIds[i] >= 0 &&
+          mClassIds[i] < static_cast<int>(mClassNames->size()))
+        detData->mLabelName = (*mClassNames)[mClassIds[i]];
+      detected.push_back(detData);
+      if (withTrack) {
+        auto trackData = std::make_shared<TrackedObjectMetadata>();
+        trackData->mTrackId = mTrackIds[i];
+        tracked.push_back(trackData);
+      }
+    }
+  }
+
+  std::vector<int> mX;
+  std::vector<int> mY;
+  std::vector<int> mWidth;
+  std::vector<int> mHeight;
+  std::vector<float> mScores;
+  std::vector<int> mClassIds;
+  /**
+   * @brief 跟踪id，未跟踪时为-1
+   */
+  std::vector<long long> mTrackIds;
+  /**
+   * @brief 类别名称，由产生检测结果的element共享，不为空时用于填充mLabelName
+   */
+  std::shared_ptr<const std::vector<std::string> > mClassNames;
+};
+
+}  // namespace common
+}  // namespace sophon_stream
+
+#endif  // SOPHON_STREAM_COMMON_DETECTION_BATCH_H_
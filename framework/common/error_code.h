@@ -39,6 +39,12 @@ enum class ErrorCode {
   ERR_METADATA_SIZE = 21,
   DATA_PIPE_FULL = 22,
   DECODE_CHANNEL_PIPE_FULL = 23,
+  CONFIGURE_NEED_RESTART = 24,
+  WARMUP_FAIL = 25,
+  GRAPH_NOT_READY = 26,
+  SNAPSHOT_FAIL = 27,
+  DECODE_NOT_READY = 28,
+  ELEMENT_NOT_READY = 29,
 
   ERR_FFMPEG_FIND_ENCODER = 1000,      // Can not find encoder
   ERR_FFMPEG_AVCODEC_CTX_ALLOC,        // avcodec context alloc failed
@@ -156,6 +162,12 @@ const std::unordered_map<ErrorCode, std::string> ErrorCodeMap = {
     {ErrorCode::ERR_METADATA_SIZE, "ERR_METADATA_SIZE"},
     {ErrorCode::DATA_PIPE_FULL, "DATA_PIPE_FULL"},
     {ErrorCode::DECODE_CHANNEL_PIPE_FULL, "DECODE_CHANNEL_PIPE_FULL"},
+    {ErrorCode::CONFIGURE_NEED_RESTART, "CONFIGURE_NEED_RESTART"},
+    {ErrorCode::WARMUP_FAIL, "WARMUP_FAIL"},
+    {ErrorCode::GRAPH_NOT_READY, "GRAPH_NOT_READY"},
+    {ErrorCode::SNAPSHOT_FAIL, "SNAPSHOT_FAIL"},
+    {ErrorCode::DECODE_NOT_READY, "DECODE_NOT_READY"},
+    {ErrorCode::ELEMENT_NOT_READY, "ELEMENT_NOT_READY"},
     {ErrorCode::ERR_FFMPEG_FIND_ENCODER, "ERR_FFMPEG_FIND_ENCODER"},
     {ErrorCode::ERR_FFMPEG_AVCODEC_CTX_ALLOC, "ERR_FFMPEG_AVCODEC_CTX_ALLOC"},
     {ErrorCode::ERR_FFMPEG_OPEN_CODEC, "ERR_FFMPEG_OPEN_CODEC"},
@@ -298,6 +310,18 @@ static std::string ErrorCodeToString(ErrorCode code) {
       return "DATA_PIPE_FULL";
     case ErrorCode::DECODE_CHANNEL_PIPE_FULL:
       return "CHANNEL_DATA_PIPE_FULL";
+    case ErrorCode::CONFIGURE_NEED_RESTART:
+      return "CONFIGURE_NEED_RESTART";
+    case ErrorCode::WARMUP_FAIL:
+      return "WARMUP_FAIL";
+    case ErrorCode::GRAPH_NOT_READY:
+      return "GRAPH_NOT_READY";
+    case ErrorCode::SNAPSHOT_FAIL:
+      return "SNAPSHOT_FAIL";
+    case ErrorCode::DECODE_NOT_READY:
+      return "DECODE_NOT_READY";
+    case ErrorCode::ELEMENT_NOT_READY:
+      return "ELEMENT_NOT_READY";
     case ErrorCode::ERR_FFMPEG_FIND_ENCODER:
       return "ERR_FFMPEG_FIND_ENCODER";
     case ErrorCode::ERR_FFMPEG_AVCODEC_CTX_ALLOC:
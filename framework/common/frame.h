@@ -39,6 +39,7 @@ struct Frame {
         mDataType(DATA_TYPE_EXT_1N_BYTE),
         mTimestamp(0),
         mEndOfStream(false),
+        mPriority(0),
         mChannel(0),
         mChannelStep(0),
         mWidth(0),
@@ -63,6 +64,10 @@ struct Frame {
   Rational mFrameRate;
   std::int64_t mTimestamp;
   bool mEndOfStream;
+  /**
+   * @brief 所属通道的优先级，数值越大越优先，由decode根据addChannel请求设置
+   */
+  int mPriority;
 
   std::string mSide;
 
@@ -61,7 +61,12 @@ void to_json(nlohmann::json& j, const RequestAddChannel& p) {
       {"source_type", p.source_type}, {"sample_interval", p.sample_interval},
       {"decode_id", p.decode_id},     {"fps", p.fps},
       {"loop_num", p.loop_num},       {"sample_strategy", p.sample_strategy},
-      {"graph_id", p.graph_id}};
+      {"graph_id", p.graph_id},       {"priority", p.priority},
+      {"target_fps", p.target_fps},   {"decode_mode", p.decode_mode},
+      {"sample_period_ms", p.sample_period_ms},
+      {"output_width", p.output_width},
+      {"output_height", p.output_height}};
+  if (p.image_prefetch.is_object()) j["image_prefetch"] = p.image_prefetch;
 }
 void from_json(const nlohmann::json& j, RequestAddChannel& p) {
   if (j.count("url") == 0 || j.count("source_type") == 0 ||
@@ -90,6 +95,27 @@ void from_json(const nlohmann::json& j, RequestAddChannel& p) {
   if (j.count("graph_id")) {
     p.graph_id = j.at("graph_id").get<int>();
   }
+  if (j.count("priority")) {
+    p.priority = j.at("priority").get<int>();
+  }
+  if (j.count("target_fps")) {
+    p.target_fps = j.at("target_fps").get<float>();
+  }
+  if (j.count("decode_mode")) {
+    p.decode_mode = j.at("decode_mode").get<std::string>();
+  }
+  if (j.count("sample_period_ms")) {
+    p.sample_period_ms = j.at("sample_period_ms").get<float>();
+  }
+  if (j.count("output_width")) {
+    p.output_width = j.at("output_width").get<int>();
+  }
+  if (j.count("output_height")) {
+    p.output_height = j.at("output_height").get<int>();
+  }
+  if (j.count("image_prefetch")) {
+    p.image_prefetch = j.at("image_prefetch");
+  }
 }
 bool str_to_object(const std::string& strjson, RequestAddChannel& request) {
   nlohmann::json json_object = nlohmann::json::parse(strjson);
@@ -55,6 +55,31 @@ struct RequestAddChannel {
   int loop_num = 1;
   std::string sample_strategy = "DROP";
   int graph_id = 0;
+  /**
+   * @brief 通道优先级，数值越大越优先，0为普通通道
+   */
+  int priority = 0;
+  /**
+   * @brief 负载过高时低优先级通道降级后保证的帧率，0表示不保证
+   */
+  float target_fps = 0;
+  /**
+   * @brief 解码方式，ALL解码所有帧，KEYFRAME只解码关键帧
+   */
+  std::string decode_mode = "ALL";
+  /**
+   * @brief 按码流时间抽帧的周期(ms)，0表示不抽帧
+   */
+  float sample_period_ms = 0;
+  /**
+   * @brief 解码后输出的尺寸，0表示保持原尺寸
+   */
+  int output_width = 0;
+  int output_height = 0;
+  /**
+   * @brief IMG_DIR的预读配置，格式与配置文件中的image_prefetch相同
+   */
+  nlohmann::json image_prefetch;
   ErrorCode errorCode = ErrorCode::SUCCESS;
 };
 void to_json(nlohmann::json& j, const RequestAddChannel& p);
@@ -0,0 +1,324 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#include "inference_backend.h"
+
+#include <sys/stat.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <nlohmann/json.hpp>
+
+#include "common/logger.h"
+
+namespace sophon_stream {
+namespace common {
+
+std::size_t HostTensor::count() const {
+  std::size_t n = 1;
+  for (int dim : shape) n *= dim;
+  return n;
+}
+
+void HostTensor::allocate(int type, const std::vector<int>& dims) {
+  dtype = type;
+  shape = dims;
+  data.assign(count() * elementSize(dtype), 0);
+}
+
+std::size_t HostTensor::elementSize(int dtype) {
+  switch (dtype) {
+    case 0:  // BM_FLOAT32
+    case 6:  // BM_INT32
+    case 7:  // BM_UINT32
+      return 4;
+    case 1:  // BM_FLOAT16
+    case 4:  // BM_INT16
+    case 5:  // BM_UINT16
+    case 8:  // BM_BFLOAT16
+      return 2;
+    default:
+      return 1;
+  }
+}
+
+ReplayBackend::ReplayBackend(Mode mode, const std::string& recordDir)
+    : mMode(mode), mRecordDir(recordDir) {
+  if (mMode == Mode::RECORD) ::mkdir(mRecordDir.c_str(), 0755);
+}
+
+std::shared_ptr<ReplayBackend> ReplayBackend::fromEnv() {
+  static std::shared_ptr<ReplayBackend> backend = []() {
+    std::shared_ptr<ReplayBackend> created;
+    const char* env = std::getenv(ENV_BACKEND);
+    if (env == nullptr) return created;
+    std::string name = env;
+    Mode mode;
+    if (name == "record") {
+      mode = Mode::RECORD;
+    } else if (name == "replay") {
+      mode = Mode::REPLAY;
+    } else {
+      if (!name.empty())
+        IVS_WARN("{0} should be record or replay, got {1}, ignored",
+                 ENV_BACKEND, name);
+      return created;
+    }
+    const char* dir = std::getenv(ENV_RECORD_DIR);
+    std::string recordDir =
+        dir != nullptr && dir[0] != '\0' ? dir : "infer_records";
+    IVS_INFO("Inference backend: {0}, record dir: {1}", name, recordDir);
+    created = std::make_shared<ReplayBackend>(mode, recordDir);
+    return created;
+  }();
+  return backend;
+}
+
+void ReplayBackend::registerReferenceModel(const std::string& netName,
+                                           ReferenceModel model) {
+  std::lock_guard<std::mutex> lock(mMutex);
+  mReferenceModels[netName] = std::move(model);
+}
+
+std::uint64_t ReplayBackend::hashInputs(const std::string& netName,
+                                        const HostTensors& inputs) {
+  std::uint64_t hash = 14695981039346656037ULL;
+  auto mix = [&hash](const void* bytes, std::size_t size) {
+    const std::uint8_t* p = static_cast<const std::uint8_t*>(bytes);
+    for (std::size_t i = 0; i < size; ++i) {
+      hash ^= p[i];
+      hash *= 1099511628211ULL;
+    }
+  };
+  mix(netName.data(), netName.size());
+  for (const auto& tensor : inputs) {
+    mix(&tensor.dtype, sizeof(tensor.dtype));
+    mix(tensor.shape.data(), tensor.shape.size() * sizeof(int));
+    mix(tensor.data.data(), tensor.data.size());
+  }
+  return hash;
+}
+
+std::string ReplayBackend::recordPath(const std::string& netName,
+                                      std::uint64_t hash) const {
+  char name[32];
+  std::snprintf(name, sizeof(name), "%016llx",
+                static_cast<unsigned long long>(hash));
+  return mRecordDir + "/" + netName + "_" + name + ".bin";
+}
+
+// 文件格式: 张量个数, 之后每个张量依次为dtype, 维数, 各维大小, 字节数, 数据
+bool ReplayBackend::save(const std::string& path, const HostTensors& tensors) {
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  if (!file) return false;
+  std::int32_t num = tensors.size();
+  file.write(reinterpret_cast<const char*>(&num), sizeof(num));
+  for (const auto& tensor : tensors) {
+    std::int32_t dtype = tensor.dtype, dims = tensor.shape.size();
+    std::uint64_t bytes = tensor.data.size();
+    file.write(reinterpret_cast<const char*>(&dtype), sizeof(dtype));
+    file.write(reinterpret_cast<const char*>(&dims), sizeof(dims));
+    for (int dim : tensor.shape) {
+      std::int32_t d = dim;
+      file.write(reinterpret_cast<const char*>(&d), sizeof(d));
+    }
+    file.write(reinterpret_cast<const char*>(&bytes), sizeof(bytes));
+    file.write(reinterpret_cast<const char*>(tensor.data.data()), bytes);
+  }
+  return static_cast<bool>(file);
+}
+
+bool ReplayBackend::load(const std::string& path, HostTensors& tensors) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file) return false;
+  std::int32_t num = 0;
+  if (!file.read(reinterpret_cast<char*>(&num), sizeof(num)) || num < 0)
+    return false;
+  HostTensors loaded(num);
+  for (auto& tensor : loaded) {
+    std::int32_t dtype = 0, dims = 0;
+    std::uint64_t bytes = 0;
+    if (!file.read(reinterpret_cast<char*>(&dtype), sizeof(dtype)) ||
+        !file.read(reinterpret_cast<char*>(&dims), sizeof(dims)) || dims < 0 ||
+        dims > 8)
+      return false;
+    tensor.dtype = dtype;
+    tensor.shape.resize(dims);
+    for (int& dim : tensor.shape) {
+      std::int32_t d = 0;
+      if (!file.read(reinterpret_cast<char*>(&d), sizeof(d))) return false;
+      dim = d;
+    }
+    if (!file.read(reinterpret_cast<char*>(&bytes), sizeof(bytes)))
+      return false;
+    tensor.data.resize(bytes);
+    if (!file.read(reinterpret_cast<char*>(tensor.data.data()), bytes))
+      return false;
+  }
+  tensors = std::move(loaded);
+  return true;
+}
+
+int ReplayBackend::record(const std::string& netName,
+                          const HostTensors& inputs,
+                          const HostTensors& outputs) {
+  std::string path = recordPath(netName, hashInputs(netName, inputs));
+  if (!save(path, outputs)) {
+    IVS_ERROR("Failed to write inference record {0}", path);
+    return -1;
+  }
+  return 0;
+}
+
+namespace {
+
+nlohmann::json tensorInfosToJson(const std::vector<TensorInfo>& tensors) {
+  nlohmann::json array = nlohmann::json::array();
+  for (const auto& tensor : tensors)
+    array.push_back({{"name", tensor.name},
+                     {"dtype", tensor.dtype},
+                     {"shape", tensor.shape},
+                     {"scale", tensor.scale}});
+  return array;
+}
+
+bool tensorInfosFromJson(const nlohmann::json& array,
+                         std::vector<TensorInfo>& tensors) {
+  if (!array.is_array()) return false;
+  tensors.clear();
+  for (const auto& item : array) {
+    TensorInfo tensor;
+    auto nameIt = item.find("name");
+    auto dtypeIt = item.find("dtype");
+    auto shapeIt = item.find("shape");
+    auto scaleIt = item.find("scale");
+    if (item.end() == dtypeIt || item.end() == shapeIt ||
+        !dtypeIt->is_number_integer() || !shapeIt->is_array())
+      return false;
+    if (item.end() != nameIt) tensor.name = nameIt->get<std::string>();
+    tensor.dtype = dtypeIt->get<int>();
+    tensor.shape = shapeIt->get<std::vector<int>>();
+    if (item.end() != scaleIt) tensor.scale = scaleIt->get<float>();
+    tensors.push_back(std::move(tensor));
+  }
+  return true;
+}
+
+}  // namespace
+
+int ReplayBackend::saveNetworkInfo(const NetworkInfo& info) {
+  nlohmann::json json = {{"name", info.name},
+                         {"inputs", tensorInfosToJson(info.inputs)},
+                         {"outputs", tensorInfosToJson(info.outputs)}};
+  std::string path = mRecordDir + "/" + info.name + ".json";
+  std::ofstream file(path, std::ios::trunc);
+  file << json.dump(2);
+  if (!file) {
+    IVS_ERROR("Failed to write network info {0}", path);
+    return -1;
+  }
+  return 0;
+}
+
+int ReplayBackend::loadNetworkInfo(const std::string& netName,
+                                   NetworkInfo& info) const {
+  std::string path = mRecordDir + "/" + netName + ".json";
+  std::ifstream file(path);
+  if (!file) return -1;
+  auto json = nlohmann::json::parse(file, nullptr, false);
+  NetworkInfo loaded;
+  loaded.name = netName;
+  if (!json.is_object() || json.end() == json.find("inputs") ||
+      json.end() == json.find("outputs") ||
+      !tensorInfosFromJson(json["inputs"], loaded.inputs) ||
+      !tensorInfosFromJson(json["outputs"], loaded.outputs)) {
+    IVS_ERROR("Invalid network info {0}", path);
+    return -1;
+  }
+  info = std::move(loaded);
+  return 0;
+}
+
+int ReplayBackend::forward(const std::string& netName,
+                           const HostTensors& inputs, HostTensors& outputs) {
+  std::uint64_t hash = hashInputs(netName, inputs);
+  HostTensors recorded;
+  if (load(recordPath(netName, hash), recorded)) {
+    if (recorded.size() != outputs.size()) {
+      IVS_ERROR("Inference record of {0} has {1} outputs, expect {2}", netName,
+                recorded.size(), outputs.size());
+      return -1;
+    }
+    outputs = std::move(recorded);
+    return 0;
+  }
+
+  ReferenceModel model;
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto it = mReferenceModels.find(netName);
+    if (it != mReferenceModels.end()) model = it->second;
+  }
+  if (model) return model(inputs, outputs);
+  IVS_ERROR("No inference record of {0} for input hash {1:016x}", netName,
+            hash);
+  return -1;
+}
+
+std::shared_ptr<HostNetwork> HostNetwork::fromRecords(
+    std::shared_ptr<ReplayBackend> backend, const std::string& netName) {
+  NetworkInfo info;
+  if (!backend || backend->loadNetworkInfo(netName, info) != 0) return nullptr;
+  return std::make_shared<HostNetwork>(std::move(backend), std::move(info));
+}
+
+int HostNetwork::forward(const HostTensors& inputs, HostTensors& outputs) {
+  if (inputs.size() != mInfo.inputs.size()) {
+    IVS_ERROR("{0} expects {1} inputs, got {2}", mInfo.name,
+              mInfo.inputs.size(), inputs.size());
+    return -1;
+  }
+  int batch = 0;
+  for (std::size_t i = 0; i < inputs.size(); ++i) {
+    const auto& expected = mInfo.inputs[i];
+    const auto& input = inputs[i];
+    bool match = input.dtype == expected.dtype &&
+                 input.shape.size() == expected.shape.size() &&
+                 !input.shape.empty() &&
+                 input.data.size() ==
+                     input.count() * HostTensor::elementSize(input.dtype);
+    for (std::size_t d = 1; match && d < input.shape.size(); ++d)
+      match = input.shape[d] == expected.shape[d];
+    if (match && i > 0) match = input.shape[0] == batch;
+    if (!match) {
+      IVS_ERROR("Input {0} of {1} does not match the network info", i,
+                mInfo.name);
+      return -1;
+    }
+    batch = input.shape[0];
+  }
+
+  outputs.resize(mInfo.outputs.size());
+  for (std::size_t i = 0; i < outputs.size(); ++i) {
+    std::vector<int> shape = mInfo.outputs[i].shape;
+    if (!shape.empty()) shape[0] = batch;
+    outputs[i].allocate(mInfo.outputs[i].dtype, shape);
+  }
+  if (mBackend->forward(mInfo.name, inputs, outputs) != 0) return -1;
+  if (outputs.size() != mInfo.outputs.size()) {
+    IVS_ERROR("{0} returned {1} outputs, expect {2}", mInfo.name,
+              outputs.size(), mInfo.outputs.size());
+    return -1;
+  }
+  return 0;
+}
+
+}  // namespace common
+}  // namespace sophon_stream
@@ -0,0 +1,186 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SOPHON_STREAM_COMMON_INFERENCE_BACKEND_H_
+#define SOPHON_STREAM_COMMON_INFERENCE_BACKEND_H_
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace sophon_stream {
+namespace common {
+
+/**
+ * @brief 主机内存中的张量，data保存原始字节，dtype与bm_data_type_t取值一致
+ */
+struct HostTensor {
+  int dtype = 0;  // 0表示FLOAT32
+  std::vector<int> shape;
+  std::vector<std::uint8_t> data;
+
+  std::size_t count() const;
+  /**
+   * @brief 按dtype和shape分配data，内容清零
+   */
+  void allocate(int type, const std::vector<int>& dims);
+  /**
+   * @brief bm_data_type_t对应的字节数，INT4、UINT4按1字节计
+   */
+  static std::size_t elementSize(int dtype);
+  // 仅当dtype为FLOAT32时有效
+  float* floatData() { return reinterpret_cast<float*>(data.data()); }
+  const float* floatData() const {
+    return reinterpret_cast<const float*>(data.data());
+  }
+};
+
+using HostTensors = std::vector<HostTensor>;
+
+/**
+ * @brief 网络一个输入或输出的描述，shape为stage 0的shape
+ */
+struct TensorInfo {
+  std::string name;
+  int dtype = 0;
+  std::vector<int> shape;
+  float scale = 1.f;
+};
+
+/**
+ * @brief 不依赖bmodel的网络描述，录制时由BMNNNetwork写出，回放时代替bmodel中的网络信息
+ */
+struct NetworkInfo {
+  std::string name;
+  std::vector<TensorInfo> inputs;
+  std::vector<TensorInfo> outputs;
+};
+
+/**
+ * @brief 推理后端，在主机内存上计算网络输出，不依赖TPU
+ */
+class InferenceBackend {
+ public:
+  virtual ~InferenceBackend() = default;
+
+  /**
+   * @brief outputs传入时已按网络输出的dtype和shape填好，由后端写入data
+   * @return 0表示成功
+   */
+  virtual int forward(const std::string& netName, const HostTensors& inputs,
+                      HostTensors& outputs) = 0;
+};
+
+/**
+ * @brief CPU参考后端
+ * @brief
+ * RECORD模式下由BMNNNetwork在TPU推理后调用record()，把输出张量按输入内容的哈希写入目录；
+ * REPLAY模式下forward()按输入哈希读取录制的输出，未命中时调用注册的参考模型。
+ * 录制一次后，前后处理、跟踪等CPU侧的改动可以在相同输入下复现TPU的输出，
+ * 用于回归测试和性能测试
+ */
+class ReplayBackend : public InferenceBackend {
+ public:
+  enum class Mode {
+    RECORD,
+    REPLAY,
+  };
+
+  // 参考模型，按输入计算outputs，返回0表示成功
+  using ReferenceModel =
+      std::function<int(const HostTensors& inputs, HostTensors& outputs)>;
+
+  // 选择模式的环境变量，取值为record或replay，未设置时不启用后端
+  static constexpr const char* ENV_BACKEND = "SOPHON_STREAM_INFER_BACKEND";
+  // 录制文件所在目录，缺省为当前目录下的infer_records
+  static constexpr const char* ENV_RECORD_DIR = "SOPHON_STREAM_INFER_RECORD_DIR";
+
+  ReplayBackend(Mode mode, const std::string& recordDir);
+
+  /**
+   * @brief 根据环境变量创建后端，进程内的所有网络共享同一个实例，未启用时返回nullptr
+   */
+  static std::shared_ptr<ReplayBackend> fromEnv();
+
+  Mode mode() const { return mMode; }
+
+  /**
+   * @brief 为某个网络注册参考模型，REPLAY模式下录制未命中时使用
+   */
+  void registerReferenceModel(const std::string& netName, ReferenceModel model);
+
+  int forward(const std::string& netName, const HostTensors& inputs,
+              HostTensors& outputs) override;
+
+  /**
+   * @brief 写入一组输入对应的输出，已存在的录制会被覆盖
+   */
+  int record(const std::string& netName, const HostTensors& inputs,
+             const HostTensors& outputs);
+
+  /**
+   * @brief 写入/读取网络描述，文件为录制目录下的<网络名>.json
+   */
+  int saveNetworkInfo(const NetworkInfo& info);
+  int loadNetworkInfo(const std::string& netName, NetworkInfo& info) const;
+
+  // 网络名和输入的dtype、shape、内容共同决定的FNV-1a哈希
+  static std::uint64_t hashInputs(const std::string& netName,
+                                  const HostTensors& inputs);
+
+ private:
+  std::string recordPath(const std::string& netName, std::uint64_t hash) const;
+  static bool load(const std::string& path, HostTensors& tensors);
+  static bool save(const std::string& path, const HostTensors& tensors);
+
+  Mode mMode;
+  std::string mRecordDir;
+  std::mutex mMutex;  // 保护mReferenceModels
+  std::map<std::string, ReferenceModel> mReferenceModels;
+};
+
+/**
+ * @brief 只使用主机内存的网络，在推理后端上按NetworkInfo检查输入并准备输出
+ * @brief
+ * 与BMNNNetwork::forward处在同一层，但不需要bmodel、bmlib和TPU：前处理用cpu_image_ops
+ * 生成输入，后处理直接读取输出的主机内存，可以在没有设备的机器上测试整条算法流程
+ */
+class HostNetwork {
+ public:
+  HostNetwork(std::shared_ptr<InferenceBackend> backend, NetworkInfo info)
+      : mBackend(std::move(backend)), mInfo(std::move(info)) {}
+
+  /**
+   * @brief 从录制目录读取网络描述，找不到时返回nullptr
+   */
+  static std::shared_ptr<HostNetwork> fromRecords(
+      std::shared_ptr<ReplayBackend> backend, const std::string& netName);
+
+  const NetworkInfo& info() const { return mInfo; }
+
+  /**
+   * @brief 输入的个数、dtype以及除batch外的shape必须与网络描述一致，
+   * 输出按网络描述和输入的batch准备好后交给后端写入
+   * @return 0表示成功
+   */
+  int forward(const HostTensors& inputs, HostTensors& outputs);
+
+ private:
+  std::shared_ptr<InferenceBackend> mBackend;
+  NetworkInfo mInfo;
+};
+
+}  // namespace common
+}  // namespace sophon_stream
+
+#endif  // SOPHON_STREAM_COMMON_INFERENCE_BACKEND_H_
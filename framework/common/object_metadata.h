@@ -17,6 +17,7 @@
 
 #include "common_defs.h"
 #include "detected_object_metadata.h"
+#include "detection_batch.h"
 #include "error_code.h"
 #include "face_object_metadata.h"
 #include "frame.h"
@@ -101,6 +102,20 @@ struct ObjectMetadata {
     }
   }
 
+  /**
+   * @brief 把mDetectionBatch追加到mDetectedObjectMetadatas和mTrackedObjectMetadatas，
+   * 之后mDetectionBatch为空，子ObjectMetadata同样处理
+   */
+  void materializeDetectionBatch() {
+    if (mDetectionBatch) {
+      mDetectionBatch->toLegacy(mDetectedObjectMetadatas,
+                                mTrackedObjectMetadatas);
+      mDetectionBatch.reset();
+    }
+    for (auto& subObjectMetadata : mSubObjectMetadatas)
+      if (subObjectMetadata) subObjectMetadata->materializeDetectionBatch();
+  }
+
   common::ErrorCode mErrorCode;
 
   std::shared_ptr<common::Frame> mFrame;
@@ -145,6 +160,13 @@ struct ObjectMetadata {
    */
   std::vector<std::shared_ptr<common::DetectedObjectMetadata>>
       mDetectedObjectMetadatas;
+  /**
+   * @brief 按列存放的检测和跟踪结果，可选
+   * @brief
+   * 不为空时是检测结果的唯一来源，mDetectedObjectMetadatas和mTrackedObjectMetadatas中没有对应的目标；
+   * 不支持的element取数据时由框架调用materializeDetectionBatch()转换
+   */
+  std::shared_ptr<common::DetectionBatch> mDetectionBatch;
   /**
    * @brief 姿态结果的vector，一个目标对应一个PosedObjectMetadata
    */
@@ -0,0 +1,121 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#include "segment_mask.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace sophon_stream {
+namespace common {
+
+void SegmentMask::linearCoeff(int dst, double scale, int srcSize, int& src,
+                              float& weight) {
+  float f = (float)((dst + 0.5) * scale - 0.5);
+  src = (int)std::floor(f);
+  f -= src;
+  if (src < 0) {
+    f = 0;
+    src = 0;
+  }
+  if (src >= srcSize - 1) {
+    f = 0;
+    src = srcSize - 1;
+  }
+  weight = f;
+}
+
+cv::Rect SegmentMask::reset(int gridWidth, int gridHeight,
+                            const cv::Size& imageSize, const cv::Rect& box,
+                            float threshold) {
+  mGridWidth = gridWidth;
+  mGridHeight = gridHeight;
+  mImageSize = imageSize;
+  mBox = box;
+  mThreshold = threshold;
+  mRoi = cv::Rect();
+  mLogits.clear();
+  if (box.width <= 0 || box.height <= 0 || gridWidth <= 0 || gridHeight <= 0)
+    return mRoi;
+
+  // 目标框两端的像素插值时用到的原型网格坐标决定ROI
+  double scaleX = 1. / ((double)imageSize.width / gridWidth);
+  double scaleY = 1. / ((double)imageSize.height / gridHeight);
+  int x0, x1, y0, y1;
+  float unused;
+  linearCoeff(box.x, scaleX, gridWidth, x0, unused);
+  linearCoeff(box.x + box.width - 1, scaleX, gridWidth, x1, unused);
+  linearCoeff(box.y, scaleY, gridHeight, y0, unused);
+  linearCoeff(box.y + box.height - 1, scaleY, gridHeight, y1, unused);
+  x1 = std::min(x1 + 1, gridWidth - 1);
+  y1 = std::min(y1 + 1, gridHeight - 1);
+  mRoi = cv::Rect(x0, y0, x1 - x0 + 1, y1 - y0 + 1);
+  mLogits.assign(mRoi.area(), 0.f);
+  return mRoi;
+}
+
+cv::Mat SegmentMask::decode() const {
+  if (empty()) return cv::Mat();
+  cv::Mat mask(mBox.height, mBox.width, CV_8UC1);
+  double scaleX = 1. / ((double)mImageSize.width / mGridWidth);
+  double scaleY = 1. / ((double)mImageSize.height / mGridHeight);
+
+  std::vector<int> xs0(mBox.width), xs1(mBox.width);
+  std::vector<float> alpha(mBox.width);
+  for (int i = 0; i < mBox.width; ++i) {
+    int sx;
+    linearCoeff(mBox.x + i, scaleX, mGridWidth, sx, alpha[i]);
+    xs0[i] = sx - mRoi.x;
+    xs1[i] = std::min(sx + 1, mGridWidth - 1) - mRoi.x;
+  }
+
+  std::vector<float> row0(mBox.width), row1(mBox.width);
+  for (int j = 0; j < mBox.height; ++j) {
+    int sy;
+    float beta;
+    linearCoeff(mBox.y + j, scaleY, mGridHeight, sy, beta);
+    const float* s0 = mLogits.data() + (sy - mRoi.y) * mRoi.width;
+    const float* s1 = mLogits.data() +
+                      (std::min(sy + 1, mGridHeight - 1) - mRoi.y) * mRoi.width;
+    for (int i = 0; i < mBox.width; ++i) {
+      float a1 = alpha[i], a0 = 1.f - a1;
+      row0[i] = s0[xs0[i]] * a0 + s0[xs1[i]] * a1;
+      row1[i] = s1[xs0[i]] * a0 + s1[xs1[i]] * a1;
+    }
+    float b1 = beta, b0 = 1.f - b1;
+    unsigned char* out = mask.ptr<unsigned char>(j);
+    for (int i = 0; i < mBox.width; ++i)
+      out[i] = row0[i] * b0 + row1[i] * b1 > mThreshold ? 255 : 0;
+  }
+  return mask;
+}
+
+std::vector<int> SegmentMask::rle() const {
+  std::vector<int> counts;
+  if (empty()) return counts;
+  cv::Mat mask = decode();
+  unsigned char current = 0;
+  int run = 0;
+  for (int j = 0; j < mask.rows; ++j) {
+    const unsigned char* row = mask.ptr<unsigned char>(j);
+    for (int i = 0; i < mask.cols; ++i) {
+      if (row[i] != current) {
+        counts.push_back(run);
+        current = row[i];
+        run = 0;
+      }
+      ++run;
+    }
+  }
+  counts.push_back(run);
+  return counts;
+}
+
+}  // namespace common
+}  // namespace sophon_stream
@@ -0,0 +1,77 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SOPHON_STREAM_COMMON_SEGMENT_MASK_H_
+#define SOPHON_STREAM_COMMON_SEGMENT_MASK_H_
+
+#include <vector>
+
+#include "opencv2/core.hpp"
+
+namespace sophon_stream {
+namespace common {
+
+/**
+ * @brief 实例分割mask的紧凑表示
+ * @brief
+ * 只保存目标框在原型网格上覆盖到的logits，使用时再按图像分辨率做双线性插值和阈值化，
+ * 插值方式与把整张原型图cv::resize(INTER_LINEAR)到图像大小后再裁剪目标框相同。
+ * 存储和计算量与目标框面积成正比，与图像大小和目标个数的乘积无关
+ */
+class SegmentMask {
+ public:
+  /**
+   * @brief 设置映射关系，返回需要填入的原型网格ROI
+   * @param gridWidth 原型网格中对应整幅图像的区域宽度
+   * @param gridHeight 原型网格中对应整幅图像的区域高度
+   * @param imageSize 图像大小
+   * @param box 目标框，图像坐标
+   * @param threshold 插值结果大于threshold的像素属于目标
+   * @return ROI，相对于原型网格中对应图像的区域，box为空时返回空矩形
+   */
+  cv::Rect reset(int gridWidth, int gridHeight, const cv::Size& imageSize,
+                 const cv::Rect& box, float threshold);
+
+  /**
+   * @brief ROI内的logits，行优先，行宽为ROI宽度，由调用者填写
+   */
+  float* data() { return mLogits.data(); }
+
+  bool empty() const { return mLogits.empty(); }
+  const cv::Rect& box() const { return mBox; }
+  const cv::Rect& roi() const { return mRoi; }
+
+  /**
+   * @brief 生成目标框大小的二值mask，CV_8UC1，前景为255
+   */
+  cv::Mat decode() const;
+
+  /**
+   * @brief 目标框内按行优先的游程长度，从背景开始，背景与前景交替
+   */
+  std::vector<int> rle() const;
+
+ private:
+  // 与cv::resize(INTER_LINEAR)相同的源坐标和权重
+  static void linearCoeff(int dst, double scale, int srcSize, int& src,
+                          float& weight);
+
+  int mGridWidth = 0;
+  int mGridHeight = 0;
+  cv::Size mImageSize;
+  cv::Rect mBox;
+  cv::Rect mRoi;
+  float mThreshold = 0;
+  std::vector<float> mLogits;
+};
+
+}  // namespace common
+}  // namespace sophon_stream
+
+#endif  // SOPHON_STREAM_COMMON_SEGMENT_MASK_H_
@@ -16,6 +16,7 @@
 
 #include "opencv2/opencv.hpp"
 #include "graphics.h"
+#include "segment_mask.h"
 
 namespace sophon_stream {
 namespace common {
@@ -28,6 +29,15 @@ struct SegmentedObjectMetadata {
   int mClassify;  // class_id
   std::vector<float> mScores;  // score
   cv::Mat mask_img; // the seg mask
+  SegmentMask mMask;  // 紧凑的mask，mask_img为空时由它按需生成
+
+  /**
+   * @brief 目标框大小的二值mask，mask_img为空时每次调用都由mMask插值得到
+   * @brief 不缓存到mask_img，多个下游element可以并发读取同一个结果
+   */
+  cv::Mat maskImage() const {
+    return mask_img.empty() && !mMask.empty() ? mMask.decode() : mask_img;
+  }
   
   std::string mItemName;
   std::string mLabelName;
@@ -215,7 +215,7 @@ void to_json(nlohmann::json& j, Frame frame) {
   j["mSpData"] = frame_to_base64(frame);
 }
 
-NLOHMANN_JSONIFY_ALL_THINGS(TrackedObjectMetadata, mTrackId)
+NLOHMANN_JSONIFY_ALL_THINGS(TrackedObjectMetadata, mTrackId, mInterpolated)
 
 NLOHMANN_JSONIFY_ALL_THINGS(Rectangle<int>, mX, mY, mWidth, mHeight)
 
@@ -0,0 +1,245 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SOPHON_STREAM_COMMON_STATE_ARCHIVE_H_
+#define SOPHON_STREAM_COMMON_STATE_ARCHIVE_H_
+
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "graphics.h"
+
+namespace sophon_stream {
+namespace common {
+
+/**
+ * @brief 在小端字节序和本机字节序之间转换，小端机器上什么都不做
+ */
+inline void swapToLittleEndian(char* bytes, std::size_t size) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  for (std::size_t i = 0; i < size / 2; ++i)
+    std::swap(bytes[i], bytes[size - 1 - i]);
+#else
+  (void)bytes;
+  (void)size;
+#endif
+}
+
+/**
+ * @brief element运行状态的二进制快照
+ * @brief
+ * 文件由固定的文件头和element写入的数据组成。文件头包含魔数、格式版本、element名称和element状态版本，
+ * 读取时格式版本不支持、名称不一致或者状态版本高于当前实现时拒绝恢复
+ * @brief 数值统一按小端字节序写入，只支持算术类型、枚举以及由它们组成的容器，
+ * 结构体需要逐个成员写入，快照可以在不同字节序的设备之间迁移
+ */
+class StateWriter {
+ public:
+  template <typename T>
+  void write(const T& value) {
+    static_assert(std::is_arithmetic<T>::value || std::is_enum<T>::value,
+                  "StateWriter::write needs an arithmetic or enum type");
+    char bytes[sizeof(T)];
+    std::memcpy(bytes, &value, sizeof(T));
+    swapToLittleEndian(bytes, sizeof(T));
+    mBuffer.insert(mBuffer.end(), bytes, bytes + sizeof(T));
+  }
+
+  void write(const std::string& value) {
+    write<std::uint32_t>(value.size());
+    mBuffer.insert(mBuffer.end(), value.begin(), value.end());
+  }
+
+  template <typename T>
+  void write(const std::vector<T>& values) {
+    write<std::uint32_t>(values.size());
+    for (const auto& value : values) write(value);
+  }
+
+  template <typename T, std::size_t N>
+  void write(const std::array<T, N>& values) {
+    for (const auto& value : values) write(value);
+  }
+
+  template <typename T>
+  void write(const Point<T>& value) {
+    write(value.mX);
+    write(value.mY);
+  }
+
+  template <typename K, typename V>
+  void write(const std::unordered_map<K, V>& values) {
+    write<std::uint32_t>(values.size());
+    for (const auto& pair : values) {
+      write(pair.first);
+      write(pair.second);
+    }
+  }
+
+  /**
+   * @brief 写入文件头和数据，先写临时文件再改名，进程中途退出不会留下不完整的快照
+   */
+  bool save(const std::string& path, const std::string& elementName,
+            std::uint32_t stateVersion) const {
+    StateWriter header;
+    header.write(kMagic);
+    header.write(kFormatVersion);
+    header.write(elementName);
+    header.write(stateVersion);
+    header.write<std::uint64_t>(mBuffer.size());
+
+    std::string tmpPath = path + ".tmp";
+    {
+      std::ofstream file(tmpPath, std::ios::binary | std::ios::trunc);
+      if (!file) return false;
+      file.write(header.mBuffer.data(), header.mBuffer.size());
+      file.write(mBuffer.data(), mBuffer.size());
+      if (!file) return false;
+    }
+    return 0 == std::rename(tmpPath.c_str(), path.c_str());
+  }
+
+  static constexpr std::uint32_t kMagic = 0x54535353;  // "SSST"
+  /**
+   * @brief 1: 本机字节序；2: 小端字节序，并且只写入算术类型
+   */
+  static constexpr std::uint32_t kFormatVersion = 2;
+
+ private:
+  std::vector<char> mBuffer;
+};
+
+class StateReader {
+ public:
+  /**
+   * @brief 读取并校验文件头
+   * @return 文件不存在、损坏或者element名称不一致时返回false
+   */
+  bool load(const std::string& path, const std::string& elementName) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return false;
+    mBuffer.assign(std::istreambuf_iterator<char>(file),
+                   std::istreambuf_iterator<char>());
+    mOffset = 0;
+    mOk = true;
+
+    std::uint32_t magic = 0, formatVersion = 0;
+    std::string name;
+    std::uint64_t size = 0;
+    read(magic);
+    read(formatVersion);
+    read(name);
+    read(mStateVersion);
+    read(size);
+    mOk = mOk && StateWriter::kMagic == magic &&
+          isSupportedFormat(formatVersion) && elementName == name &&
+          mBuffer.size() - mOffset == size;
+    return mOk;
+  }
+
+  /**
+   * @brief 版本1按本机字节序写入，在小端机器上与版本2的布局相同
+   */
+  static bool isSupportedFormat(std::uint32_t formatVersion) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    return StateWriter::kFormatVersion == formatVersion;
+#else
+    return 1 == formatVersion || StateWriter::kFormatVersion == formatVersion;
+#endif
+  }
+
+  std::uint32_t stateVersion() const { return mStateVersion; }
+
+  /**
+   * @brief 之前的读取全部成功，并且没有越界
+   */
+  bool ok() const { return mOk; }
+
+  template <typename T>
+  bool read(T& value) {
+    static_assert(std::is_arithmetic<T>::value || std::is_enum<T>::value,
+                  "StateReader::read needs an arithmetic or enum type");
+    if (!mOk || mBuffer.size() - mOffset < sizeof(T)) return mOk = false;
+    char bytes[sizeof(T)];
+    std::memcpy(bytes, mBuffer.data() + mOffset, sizeof(T));
+    swapToLittleEndian(bytes, sizeof(T));
+    std::memcpy(&value, bytes, sizeof(T));
+    mOffset += sizeof(T);
+    return true;
+  }
+
+  bool read(std::string& value) {
+    std::uint32_t size = 0;
+    if (!read(size) || mBuffer.size() - mOffset < size) return mOk = false;
+    value.assign(mBuffer.data() + mOffset, size);
+    mOffset += size;
+    return true;
+  }
+
+  template <typename T>
+  bool read(std::vector<T>& values) {
+    std::uint32_t size = 0;
+    if (!read(size)) return false;
+    values.clear();
+    for (std::uint32_t i = 0; i < size && mOk; ++i) {
+      T value;
+      read(value);
+      values.push_back(value);
+    }
+    return mOk;
+  }
+
+  template <typename T, std::size_t N>
+  bool read(std::array<T, N>& values) {
+    for (auto& value : values) read(value);
+    return mOk;
+  }
+
+  template <typename T>
+  bool read(Point<T>& value) {
+    read(value.mX);
+    read(value.mY);
+    return mOk;
+  }
+
+  template <typename K, typename V>
+  bool read(std::unordered_map<K, V>& values) {
+    std::uint32_t size = 0;
+    if (!read(size)) return false;
+    values.clear();
+    for (std::uint32_t i = 0; i < size && mOk; ++i) {
+      K key;
+      V value;
+      read(key);
+      read(value);
+      values[key] = value;
+    }
+    return mOk;
+  }
+
+ private:
+  std::vector<char> mBuffer;
+  std::size_t mOffset = 0;
+  std::uint32_t mStateVersion = 0;
+  bool mOk = false;
+};
+
+}  // namespace common
+}  // namespace sophon_stream
+
+#endif  // SOPHON_STREAM_COMMON_STATE_ARCHIVE_H_
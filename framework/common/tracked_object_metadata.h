@@ -20,6 +20,7 @@ struct TrackedObjectMetadata {
   std::string mName;
   bool mTrackerFilter = false;
   long long mTrackId = -1;  // 跟踪id
+  bool mInterpolated = false;  // 当前帧没有检测，位置由运动模型预测得到
   int mTrackFlag = TrNormal;
   float mQualityScore = 0.0;
   std::string mCaptureTime;
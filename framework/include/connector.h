@@ -10,18 +10,73 @@
 #ifndef SOPHON_STREAM_FRAMEWORK_CONNECTOR_H_
 #define SOPHON_STREAM_FRAMEWORK_CONNECTOR_H_
 
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
 #include "common/no_copyable.h"
 #include "datapipe.h"
+#include "message.h"
 
 namespace sophon_stream {
 namespace framework {
 
 class Connector : public ::sophon_stream::common::NoCopyable {
  public:
+  /**
+   * @brief 通道到dataPipe的路由策略
+   */
+  enum class RoutingStrategy {
+    /**
+     * @brief channelIdInternal % capacity，与历史行为一致
+     */
+    MODULO,
+    /**
+     * @brief 新通道分配给当前通道数最少的dataPipe，之后保持不变
+     */
+    STICKY,
+    /**
+     * @brief 逐帧轮询，只适用于不保存通道状态的element
+     * @brief 同一通道的帧会被多个线程并行处理，下游看到的帧顺序不再保证
+     */
+    ROUND_ROBIN,
+  };
+
+  static RoutingStrategy parseRoutingStrategy(const std::string& name);
+
   Connector(int dataPipeCount);
 
-  std::shared_ptr<void> popData(int id);
-  common::ErrorCode pushData(int id, std::shared_ptr<void> data);
+  /**
+   * @brief 设置路由策略
+   * @param[in] channelStateful :
+   * 下游element是否按线程保存通道状态或依赖帧顺序，为true时不会轮询，也不会迁移已分配的通道
+   * @param[in] affinity : {channelIdInternal : dataPipeId}，优先于路由策略
+   */
+  void setRouting(RoutingStrategy strategy, bool channelStateful,
+                  const std::map<int, int>& affinity = {});
+
+  /**
+   * @brief 为通道的一帧数据选择dataPipe
+   * @param[in] endOfStream :
+   * 通道的最后一帧，按原路由送出后释放该通道，并在STICKY策略下重新均衡负载
+   * @return int dataPipeId
+   */
+  int route(int channelIdInternal, bool endOfStream = false);
+
+  /**
+   * @brief 从指定dataPipe弹出消息，属于某个通道的消息记为该dataPipe正在处理
+   */
+  Message popData(int id);
+  /**
+   * @brief 向指定dataPipe推入消息，队列已满时message保持不变
+   * @brief 成功时该消息所属通道的在途消息数加一
+   */
+  common::ErrorCode pushData(int id, Message&& message);
+  /**
+   * @brief dataPipe对应的线程处理完此前弹出的消息，减少这些消息所属通道的在途消息数
+   */
+  void release(int id);
   /**
    * @brief 获取Connector中dataPipe的数量
    * @return int 当前Connector中dataPipe数量
@@ -32,8 +87,34 @@ class Connector : public ::sophon_stream::common::NoCopyable {
 
 
  private:
+  void releaseRoute(int channelIdInternal);
+  void decreaseInFlight(int channelIdInternal);
+
   std::vector<std::shared_ptr<DataPipe>> mDataPipes;
   int mCapacity = 0;
+
+  std::mutex mRouteMutex;
+  RoutingStrategy mStrategy = RoutingStrategy::MODULO;
+  bool mChannelStateful = false;
+  std::map<int, int> mAffinity;
+  // {channelIdInternal : dataPipeId}
+  std::map<int, int> mRoutes;
+  /**
+   * @brief 重新均衡时等待迁移的通道，{channelIdInternal : 目标dataPipeId}
+   * @brief 通道没有在途消息时才切换，避免同一通道的帧乱序
+   */
+  std::map<int, int> mMigrations;
+  /**
+   * @brief 每个通道已推入但还没有处理完的消息数，{channelIdInternal : count}
+   */
+  std::map<int, int> mInFlight;
+  /**
+   * @brief 每个dataPipe自上次release以来弹出的消息所属的通道
+   */
+  std::vector<std::vector<int>> mPopped;
+  // 每个dataPipe当前分配的通道数
+  std::vector<int> mPipeLoads;
+  int mRoundRobinIndex = 0;
 };
 
 }  // namespace framework
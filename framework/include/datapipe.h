@@ -10,55 +10,202 @@
 #ifndef SOPHON_STREAM_FRAMEWORK_DATAPIPE_H_
 #define SOPHON_STREAM_FRAMEWORK_DATAPIPE_H_
 
+#include <algorithm>
 #include <chrono>
-#include <condition_variable>
 #include <cstddef>
+#include <cstdint>
 #include <deque>
-#include <functional>
-#include <memory>
+#include <limits>
+#include <map>
 #include <mutex>
+#include <utility>
 
 #include "common/error_code.h"
-#include "common/logger.h"
 #include "common/no_copyable.h"
+#include "message_header.h"
 
 namespace sophon_stream {
 namespace framework {
 
-class DataPipe : public ::sophon_stream::common::NoCopyable {
- public:
-  using PushHandler = std::function<void()>;
+class Message;
 
-  DataPipe();
+/**
+ * @brief element之间的消息队列
+ * @tparam MessageT 提供header()和isControl()的消息，header()返回MessageHeader
+ */
+template <typename MessageT>
+class BasicDataPipe : public ::sophon_stream::common::NoCopyable {
+ public:
+  static constexpr std::size_t DEFAULT_CAPACITY = 20;
 
-  ~DataPipe();
+  BasicDataPipe()
+      : mCapacity(DEFAULT_CAPACITY),
+        mHeadroom(std::max<std::size_t>(1, DEFAULT_CAPACITY / 8)) {}
 
   /**
-   * @brief 从队首弹出数据
-   * @return std::shared_ptr<void> 若队列非空则弹出队首，队列为空返回nullptr
+   * @brief 从队首弹出消息
+   * @brief
+   * 不同优先级的消息按加权公平队列调度，优先级为p的队列权重为p+1；同一优先级内先进先出。
+   * 控制消息不参与调度，之前入队的数据出队后立即弹出
+   * @return MessageT 若队列非空则弹出队首，队列为空返回空消息
    */
-  std::shared_ptr<void> popData();
+  MessageT popData() {
+    std::lock_guard<std::mutex> lock(mDataQueueMutex);
+    if (mSize == 0) return MessageT();
+
+    // 通道的控制消息排在该通道数据所在的子队列中，到达队首即可弹出
+    for (auto it = mDataQueues.rbegin(); it != mDataQueues.rend(); ++it) {
+      auto& queue = it->second.mDataQueue;
+      if (!queue.empty() && queue.front().isControl())
+        return take(queue);
+    }
+
+    // 选择虚拟完成时间最小的非空队列，时间相同时高优先级先出；
+    // 此时各子队列的队首都是数据，入队序号最小的就是最早入队的数据
+    PriorityQueue* selected = nullptr;
+    int selectedPriority = 0;
+    std::uint64_t oldestSequence = std::numeric_limits<std::uint64_t>::max();
+    for (auto it = mDataQueues.rbegin(); it != mDataQueues.rend(); ++it) {
+      if (it->second.mDataQueue.empty()) continue;
+      oldestSequence = std::min(
+          oldestSequence, it->second.mDataQueue.front().header().mSequence);
+      if (!selected || it->second.mVirtualFinish < selected->mVirtualFinish) {
+        selected = &it->second;
+        selectedPriority = it->first;
+      }
+    }
+
+    // 不属于某个通道的控制消息等待之前入队的所有数据出队
+    if (!mControlQueue.empty() &&
+        mControlQueue.front().first < oldestSequence) {
+      MessageT message = std::move(mControlQueue.front().second);
+      mControlQueue.pop_front();
+      --mSize;
+      return message;
+    }
+
+    MessageT message = take(selected->mDataQueue);
+    mVirtualTime = selected->mVirtualFinish;
+    selected->mVirtualFinish += 1.0 / (selectedPriority + 1);
+    return message;
+  }
 
   /**
-   * @brief 向队列末尾push数据
+   * @brief 向队列末尾push消息，按消息头的mPriority排队，小于0时按0处理
+   * @brief
+   * 所有优先级共用容量，但每个出现过的更高优先级都会为自己保留一部分位置，
+   * 低优先级的数据占满可用部分后，高优先级的数据仍然可以入队
+   * @brief
+   * 控制消息不携带数据，只受总容量限制。指定通道的控制消息排在该通道最近一个数据所在的
+   * 子队列末尾，优先级改为该通道的优先级；不属于某个通道的控制消息排在之前入队的所有数据之后
+   * @brief 成功时记录入队时间，数据消息还会分配入队序号
+   * @param[in] message : 成功时被移走，队列已满时保持不变，可以直接重试
    * @return common::ErrorCode
    * 成功返回common::ErrorCode::SUCCESS，失败返回common::ErrorCode::DATA_PIPE_FULL
    */
-  common::ErrorCode pushData(std::shared_ptr<void> data);
+  common::ErrorCode pushData(MessageT&& message) {
+    std::unique_lock<std::mutex> lock(mDataQueueMutex);
+    auto& header = message.header();
+    if (message.isControl()) {
+      if (mSize >= mCapacity) return common::ErrorCode::DATA_PIPE_FULL;
+      header.mEnqueueTime = std::chrono::steady_clock::now();
+      auto channel = mChannelPriority.find(header.mChannelId);
+      if (header.mChannelId < 0 || mChannelPriority.end() == channel) {
+        mControlQueue.emplace_back(mSequence, std::move(message));
+      } else {
+        header.mPriority = channel->second;
+        if (MessageKind::EOS == header.mKind) mChannelPriority.erase(channel);
+        mDataQueues[header.mPriority].mDataQueue.push_back(std::move(message));
+      }
+      ++mSize;
+      return common::ErrorCode::SUCCESS;
+    }
+
+    int priority = header.mPriority < 0 ? 0 : header.mPriority;
+    // 入队失败也登记这个优先级，低优先级从此开始为它让出位置
+    auto& queue = mDataQueues[priority];
+    if (mSize < getLimit(priority)) {
+      // 积压中的队列不会落后于mVirtualTime，队列中只有控制消息时也按新激活处理
+      if (queue.mVirtualFinish < mVirtualTime)
+        queue.mVirtualFinish = mVirtualTime;
+      header.mEnqueueTime = std::chrono::steady_clock::now();
+      header.mSequence = ++mSequence;
+      if (header.mChannelId >= 0)
+        mChannelPriority[header.mChannelId] = priority;
+      queue.mDataQueue.push_back(std::move(message));
+      ++mSize;
+      return common::ErrorCode::SUCCESS;
+    }
+    return common::ErrorCode::DATA_PIPE_FULL;
+  }
+
   /**
    * @brief 获取当前队列中元素的数量
-   * @return mDataQueue中元素数量
+   * @return 所有优先级队列中元素数量之和
    */
-  int getSize();
+  int getSize() {
+    std::lock_guard<std::mutex> lock(mDataQueueMutex);
+    int sz = mSize;
+    return sz;
+  }
+
+  int getCapacity() const { return mCapacity; }
 
  private:
-  std::deque<std::shared_ptr<void> > mDataQueue;
+  /**
+   * @brief 单个优先级的子队列
+   * @brief mVirtualFinish为该队列下一个数据出队后的虚拟完成时间
+   */
+  struct PriorityQueue {
+    std::deque<MessageT> mDataQueue;
+    double mVirtualFinish = 0;
+  };
+
+  /**
+   * @brief 优先级为priority的消息入队时队列总长度的上限
+   */
+  std::size_t getLimit(int priority) const {
+    // 每个出现过的更高优先级为其保留mHeadroom个位置，至少留1个位置给priority
+    std::size_t reserved = 0;
+    for (auto it = mDataQueues.upper_bound(priority); it != mDataQueues.end();
+         ++it)
+      reserved += mHeadroom;
+    return reserved < mCapacity ? mCapacity - reserved : 1;
+  }
+
+  MessageT take(std::deque<MessageT>& queue) {
+    MessageT message = std::move(queue.front());
+    queue.pop_front();
+    --mSize;
+    return message;
+  }
+
+  std::map<int /* priority */, PriorityQueue> mDataQueues;
+  /**
+   * @brief 不属于某个通道的控制消息，以及入队时所属通道没有数据记录的控制消息，
+   * first为入队时最后一个数据的入队序号
+   */
+  std::deque<std::pair<std::uint64_t, MessageT>> mControlQueue;
+  /**
+   * @brief 各通道最近一个数据消息的优先级，收到该通道的EOS后删除
+   */
+  std::map<int /* channelId */, int /* priority */> mChannelPriority;
   mutable std::mutex mDataQueueMutex;
   std::size_t mCapacity;
-
-  const std::chrono::milliseconds timeout{200};
+  /**
+   * @brief 每个更高优先级保留的位置数
+   */
+  std::size_t mHeadroom;
+  std::size_t mSize = 0;
+  /**
+   * @brief 最近一次出队数据的虚拟开始时间，新激活的队列从这里开始计时
+   */
+  double mVirtualTime = 0;
+  std::uint64_t mSequence = 0;
 };
 
+using DataPipe = BasicDataPipe<Message>;
+
 }  // namespace framework
 }  // namespace sophon_stream
 
@@ -22,6 +22,7 @@
 #include <memory>
 #include <mutex>
 #include <nlohmann/json.hpp>
+#include <set>
 #include <string>
 #include <thread>
 #include <vector>
@@ -30,9 +31,11 @@
 #include "common/http_defs.h"
 // #include "common/logger.h"
 #include "common/no_copyable.h"
+#include "common/state_archive.h"
 #include "connector.h"
 #include "datapipe.h"
 #include "listen_thread.h"
+#include "message.h"
 
 namespace sophon_stream {
 namespace framework {
@@ -53,6 +56,28 @@ class Element : public ::sophon_stream::common::NoCopyable {
     PAUSE,
   };
 
+  /**
+   * @brief 初始化状态
+   */
+  enum class InitStatus {
+    /**
+     * @brief 尚未完成初始化或预热
+     */
+    PENDING,
+    /**
+     * @brief 延迟到第一个通道的数据到达时再初始化
+     */
+    LAZY,
+    /**
+     * @brief 正在延迟初始化或预热
+     */
+    WARMUP,
+    READY,
+    FAIL,
+  };
+
+  static const char* initStatusToString(InitStatus status);
+
   /**
    * @brief
    * 连接两个element，初始化connector并填入srcElement的mOutputConnectorMap
@@ -75,6 +100,36 @@ class Element : public ::sophon_stream::common::NoCopyable {
    */
   common::ErrorCode init(const std::string& json);
 
+  /**
+   * @brief init之后、start之前调用，配置了warmup时先用合成数据预热
+   * @brief 配置了lazy_init的element跳过，在第一个通道的数据到达时再初始化和预热
+   */
+  common::ErrorCode prepare();
+
+  virtual InitStatus getInitStatus() const { return mInitStatus; }
+
+  bool isLazyInit() const { return mLazyInit; }
+
+  bool isWarmupEnabled() const { return mWarmup; }
+
+  /**
+   * @brief 初始化和预热的耗时，单位毫秒
+   */
+  int getInitCostMs() const { return mInitCostMs; }
+  int getWarmupCostMs() const { return mWarmupCostMs; }
+
+  /**
+   * @brief 设置延迟初始化函数，element的线程在输入数据到达后调用一次
+   * @brief 用于group把内部element的模型加载推迟到第一个通道
+   */
+  void setLazyInit(std::function<common::ErrorCode()> lazyInitFunc);
+
+  /**
+   * @brief 用合成数据把模型的每个batch size都推理一遍，避免首帧的冷启动开销
+   * @brief 只有加载模型的element需要重写，默认实现只打印警告，说明warmup配置没有效果
+   */
+  virtual common::ErrorCode warmup();
+
   common::ErrorCode start();
 
   common::ErrorCode stop();
@@ -85,10 +140,18 @@ class Element : public ::sophon_stream::common::NoCopyable {
 
   /**
    * @brief 从指定inputPort的指定dataPipe中弹出数据，用于数据处理阶段
+   * @brief 控制消息在这里直接转发给下游，不会返回给调用者
    * @brief 若队列为空，返回nullptr
    */
   std::shared_ptr<void> popInputData(int inputPort, int dataPipeId);
 
+  /**
+   * @brief 从指定inputPort的指定dataPipe中弹出消息，包含控制消息
+   * @brief 调用者需要自行处理控制消息，并通过forwardControlMessage()转发
+   * @brief 若队列为空，返回空消息
+   */
+  Message popInputMessage(int inputPort, int dataPipeId);
+
   /**
    * @brief 向指定inputPort的指定dataPipe推入数据，用于启动解码任务
    * @param[in] data : sophon_stream::element::decode::ChannelTask结构体指针
@@ -96,15 +159,37 @@ class Element : public ::sophon_stream::common::NoCopyable {
   common::ErrorCode pushInputData(int inputPort, int dataPipeId,
                                   std::shared_ptr<void> data);
 
+  /**
+   * @brief 向指定inputPort推入控制消息
+   * @brief 指定channelId时按该通道的路由送入一个dataPipe，否则送入所有dataPipe
+   */
+  common::ErrorCode pushControlMessage(int inputPort, MessageKind kind,
+                                       int channelId = -1);
+
   std::shared_ptr<void> popOutputData(int outputPort, int dataPipeId) = delete;
 
   /**
    * @brief 向指定outputPort的指定dataPipe推入数据，将数据传递给下一个element
    * @brief 如果当前element是sink element，那么改为使用sinkHandler处理数据
+   * @param[in] data : ObjectMetadata指针，下游dataPipe按mFrame的优先级加权调度
    */
   common::ErrorCode pushOutputData(int outputPort, int dataPipeId,
                                    std::shared_ptr<void> data);
 
+  /**
+   * @brief 向指定outputPort的指定dataPipe推入消息
+   * @brief sink element的数据消息交给sinkHandler处理，控制消息直接丢弃
+   */
+  common::ErrorCode pushOutputMessage(int outputPort, int dataPipeId,
+                                      Message&& message);
+
+  /**
+   * @brief 把控制消息转发给所有outputPort
+   * @brief
+   * 多个线程收到同一个控制消息时只转发一次；EOS指定了通道时沿该通道的路由送出，其余送入所有dataPipe
+   */
+  void forwardControlMessage(const Message& message);
+
   void setSinkHandler(int outputPort, SinkHandler sinkHandler);
 
   /**
@@ -118,6 +203,20 @@ class Element : public ::sophon_stream::common::NoCopyable {
 
   virtual bool getGroup() { return false; }
 
+  /**
+   * @brief 是否按线程保存通道状态或依赖帧顺序，例如每个dataPipe线程一个跟踪器
+   * @brief
+   * 返回true时，输入connector不会轮询，也不会迁移已分配给某个线程的通道
+   */
+  virtual bool isChannelStateful() const { return false; }
+
+  /**
+   * @brief 是否直接读取ObjectMetadata::mDetectionBatch
+   * @brief 返回false时，popInputData()和sinkHandler得到的数据已经转换为
+   * mDetectedObjectMetadatas
+   */
+  virtual bool acceptsDetectionBatch() const { return false; }
+
   /**
    * @brief 仅group element重写，用于向graph的elementMap注册内部各个element
    * @param mapPtr graph的elementMap
@@ -155,6 +254,86 @@ class Element : public ::sophon_stream::common::NoCopyable {
 
   virtual void registListenFunc(ListenThread* listener) {}
 
+  /**
+   * @brief configure中可以在运行时热更新的字段，其它字段需要重建graph才能生效
+   */
+  virtual std::set<std::string> getHotConfigureKeys() const { return {}; }
+
+  /**
+   * @brief 应用热更新配置，configure中只包含getHotConfigureKeys()中的字段
+   * @param[in] check : 为true时只校验不生效，用于多个element整体更新前的检查
+   * @brief 生效时当前element的所有线程都停在两帧之间
+   */
+  virtual common::ErrorCode applyConfigure(const nlohmann::json& configure,
+                                           bool check) {
+    return common::ErrorCode::SUCCESS;
+  }
+
+  /**
+   * @brief 检查configure补丁能否应用
+   * @param[in] stage :
+   * 补丁中包含需要重启的字段时，为true则暂存这部分字段，否则整体拒绝
+   */
+  common::ErrorCode checkConfigure(const nlohmann::json& patch, bool stage);
+
+  /**
+   * @brief 应用configure补丁，热更新字段立即生效，其余字段暂存
+   * @brief 调用前需要先通过checkConfigure()并且已经quiesce
+   */
+  common::ErrorCode commitConfigure(const nlohmann::json& patch);
+
+  /**
+   * @brief 记录configure补丁涉及的热更新字段的当前值和暂存的configure
+   * @brief 在commitConfigure()之前调用，多个element整体更新失败时用于回滚
+   */
+  nlohmann::json snapshotConfigure(const nlohmann::json& patch) const;
+
+  /**
+   * @brief 恢复snapshotConfigure()记录的configure，调用前需要已经quiesce
+   */
+  void rollbackConfigure(const nlohmann::json& snapshot);
+
+  /**
+   * @brief 获取当前configure
+   * @param[in] withStaged : 为true时合并暂存的字段，用于重建graph
+   */
+  nlohmann::json getConfigure(bool withStaged) const;
+  nlohmann::json getStagedConfigure() const;
+
+  /**
+   * @brief 请求所有线程在处理完当前帧后暂停
+   * @brief 线程在doWork之前、输入队列为空时或者输出队列满时停下
+   */
+  virtual void requestQuiesce();
+  /**
+   * @brief 等待所有线程停下
+   * @return 超时返回false
+   */
+  virtual bool waitQuiesced(std::chrono::steady_clock::time_point deadline);
+  virtual void releaseQuiesce();
+
+  /**
+   * @brief 运行状态的版本，0表示没有需要跨重启保存的状态
+   * @brief 状态格式变化时增加版本，loadState()需要能读取不高于当前版本的快照
+   */
+  virtual std::uint32_t getStateVersion() const { return 0; }
+
+  /**
+   * @brief 保存运行状态，例如跟踪器和计数器，不包含配置和正在处理的数据
+   * @brief 调用时element的线程已经停止或者停在两帧之间
+   */
+  virtual common::ErrorCode saveState(common::StateWriter& writer) {
+    return common::ErrorCode::SUCCESS;
+  }
+
+  /**
+   * @brief 从快照恢复运行状态，在element的线程启动之前调用
+   * @param[in] reader : 已经通过文件头校验，reader.stateVersion()为快照的版本
+   */
+  virtual common::ErrorCode loadState(common::StateReader& reader) {
+    return common::ErrorCode::SUCCESS;
+  }
+
   static constexpr const char* JSON_ID_FIELD = "id";
   static constexpr const char* JSON_SIDE_FIELD = "side";
   static constexpr const char* JSON_DEVICE_ID_FIELD = "device_id";
@@ -162,6 +341,10 @@ class Element : public ::sophon_stream::common::NoCopyable {
   static constexpr const char* JSON_CONFIGURE_FIELD = "configure";
   static constexpr const char* JSON_IS_SINK_FILED = "is_sink";
   static constexpr const char* JSON_INNER_ELEMENTS_ID = "inner_elements_id";
+  static constexpr const char* JSON_ROUTING_FIELD = "routing";
+  static constexpr const char* JSON_CHANNEL_AFFINITY_FIELD = "channel_affinity";
+  static constexpr const char* JSON_LAZY_INIT_FIELD = "lazy_init";
+  static constexpr const char* JSON_WARMUP_FIELD = "warmup";
 
   std::map<int, std::shared_ptr<framework::Connector>>& getInputConnectorMap() {
     return mInputConnectorMap;
@@ -187,6 +370,15 @@ class Element : public ::sophon_stream::common::NoCopyable {
   inline virtual void setListener(ListenThread* p) { listenThreadPtr = p; }
 
  protected:
+  /**
+   * @brief initInternal是否已经完成
+   * @brief 延迟初始化之前不能应用热更新配置，算法element也还没有context
+   */
+  bool isInitialized() const {
+    InitStatus status = getInitStatus();
+    return InitStatus::READY == status || InitStatus::PENDING == status;
+  }
+
   /**
    * @brief 从配置文件初始化某个派生element的特有属性
    * @param[in] json : json格式的配置文件
@@ -220,6 +412,16 @@ class Element : public ::sophon_stream::common::NoCopyable {
    * @brief 获取指定inputPort对应的Connector中datapipe的数量
    */
   int getInputConnectorCapacity(int inputPort);
+  /**
+   * @brief 获取指定outputPort的指定dataPipe的占用率，范围[0, 1]
+   */
+  float getOutputDataPipeOccupancy(int outputPort, int dataPipeId);
+  /**
+   * @brief 由下游connector的路由策略为通道的一帧数据选择dataPipe
+   * @param[in] endOfStream : 通道的最后一帧，送出后释放该通道的路由
+   */
+  int getOutputDataPipeId(int outputPort, int channelIdInternal,
+                          bool endOfStream = false);
 
  private:
   int mId;
@@ -257,6 +459,53 @@ class Element : public ::sophon_stream::common::NoCopyable {
 
   bool mSinkElementFlag = false;
 
+  /**
+   * @brief 输入connector的路由配置，在创建connector时生效
+   */
+  Connector::RoutingStrategy mRoutingStrategy =
+      Connector::RoutingStrategy::MODULO;
+  std::map<int, int> mChannelAffinity;
+
+  std::shared_ptr<framework::Connector> makeInputConnector();
+
+  /**
+   * @brief 延迟初始化的element在当前线程有输入数据时完成初始化
+   * @return 已经可以处理数据时返回true
+   */
+  bool tryLazyInit(int dataPipeId);
+
+  bool hasInputData(int dataPipeId);
+
+  common::ErrorCode timedWarmup();
+
+  bool mLazyInit = false;
+  bool mWarmup = false;
+  std::atomic<InitStatus> mInitStatus{InitStatus::PENDING};
+  std::function<common::ErrorCode()> mLazyInitFunc;
+  std::once_flag mLazyInitFlag;
+  std::atomic<int> mInitCostMs{0};
+  std::atomic<int> mWarmupCostMs{0};
+
+  /**
+   * @brief 有quiesce请求时在两帧之间停下，直到releaseQuiesce()
+   */
+  void parkIfQuiescing();
+
+  mutable std::mutex mConfigureMutex;
+  nlohmann::json mConfigure = nlohmann::json::object();
+  nlohmann::json mStagedConfigure = nlohmann::json::object();
+
+  /**
+   * @brief 最近转发过的控制消息序号，用于多个线程之间去重
+   */
+  std::mutex mControlMutex;
+  std::set<std::uint64_t> mForwardedControls;
+
+  std::mutex mQuiesceMutex;
+  std::condition_variable mQuiesceCv;
+  std::atomic<bool> mQuiesceRequested{false};
+  int mParkedThreads = 0;
+
   friend class ListenThread;
   ListenThread* listenThreadPtr;
 };
@@ -13,6 +13,7 @@
 #include <functional>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <string>
 
 #include "common/error_code.h"
@@ -50,6 +51,8 @@ class ElementFactory : public ::sophon_stream::common::NoCopyable {
   ElementFactory();
 
   std::map<std::string, ElementMaker> mElementMakerMap;
+  // 多个graph并行初始化时，动态库注册element与创建element可能同时发生
+  std::mutex mElementMakerMutex;
 
   ~ElementFactory();
 };
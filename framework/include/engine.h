@@ -10,6 +10,7 @@
 #ifndef SOPHON_STREAM_FRAMEWORK_ELEMENT_ENGINE_H_
 #define SOPHON_STREAM_FRAMEWORK_ELEMENT_ENGINE_H_
 
+#include <atomic>
 #include <chrono>
 #include <map>
 #include <memory>
@@ -41,6 +42,11 @@ class Engine : public ::sophon_stream::common::NoCopyable {
    */
   common::ErrorCode addGraph(const std::string& json);
 
+  /**
+   * @brief 并行初始化多个graph，返回第一个失败的错误码
+   */
+  common::ErrorCode addGraphs(const std::vector<std::string>& jsons);
+
   void removeGraph(int graphId);
 
   bool graphExist(int graphId);
@@ -51,6 +57,13 @@ class Engine : public ::sophon_stream::common::NoCopyable {
    */
   common::ErrorCode pushSourceData(int graphId, int elementId, int inputPort,
                                    std::shared_ptr<void> data);
+
+  /**
+   * @brief 向指定graph的指定element推入控制消息，例如FLUSH
+   */
+  common::ErrorCode pushControlMessage(int graphId, int elementId,
+                                       int inputPort, MessageKind kind,
+                                       int channelId = -1);
   /**
    * @brief
    * 为指定graph的指定element设置sinkHandler，sinkHandler当且仅当指定element是sink
@@ -63,15 +76,53 @@ class Engine : public ::sophon_stream::common::NoCopyable {
 
   std::vector<int> getGraphIds();
 
+  /**
+   * @brief 对运行中的graph应用configure补丁，见Graph::reconfigure
+   */
+  common::ErrorCode reconfigure(int graphId, const nlohmann::json& patch);
+
+  nlohmann::json getConfigure(int graphId, bool withStaged);
+
+  /**
+   * @brief 保存graph中element的运行状态，见Graph::saveSnapshot
+   */
+  common::ErrorCode saveSnapshot(int graphId);
+
+  /**
+   * @brief 获取所有graph的初始化状态
+   * @brief 没有正在添加的graph并且所有graph都就绪时ready为true
+   */
+  nlohmann::json getHealth();
+
+  bool isReady();
+
   inline ListenThread* getListener() { return listenThreadPtr; }
 
-  inline void setListener(ListenThread* p) { listenThreadPtr = p; }
+  /**
+   * @brief 设置监听线程，并注册健康检查和就绪检查接口
+   */
+  void setListener(ListenThread* p);
 
   static constexpr const char* JSON_GRAPH_ID_FIELD = "graph_id";
+  static constexpr const char* graphNameConfigure = "/graph/Configure";
+  static constexpr const char* elementNameConfigure = "/element/Configure";
+  static constexpr const char* graphNameSnapshot = "/graph/Snapshot";
+  static constexpr const char* engineNameHealth = "/engine/Health";
+  static constexpr const char* engineNameReady = "/engine/Ready";
 
  private:
   friend class common::Singleton<Engine>;
 
+  std::shared_ptr<framework::Graph> findGraph(int graphId);
+
+  /**
+   * @brief 为graph和其中每个element注册查询、修改configure的http接口，
+   * 以及保存graph运行状态快照的接口
+   */
+  void registConfigureFunc(const std::shared_ptr<framework::Graph>& graph);
+
+  void registHealthFunc();
+
   Engine();
 
   ~Engine();
@@ -81,6 +132,9 @@ class Engine : public ::sophon_stream::common::NoCopyable {
 
   std::vector<int> mGraphIds;
 
+  // 正在初始化、尚未加入mGraphMap的graph数量
+  std::atomic<int> mPendingGraphCount{0};
+
   ListenThread* listenThreadPtr;
 };
 
@@ -0,0 +1,257 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SOPHON_STREAM_FRAMEWORK_FRAME_SYNCHRONIZER_H_
+#define SOPHON_STREAM_FRAMEWORK_FRAME_SYNCHRONIZER_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <limits>
+#include <memory>
+#include <nlohmann/json.hpp>
+#include <vector>
+
+#include "common/error_code.h"
+#include "common/no_copyable.h"
+
+namespace sophon_stream {
+namespace common {
+struct ObjectMetadata;
+}  // namespace common
+
+namespace framework {
+
+/**
+ * @brief 帧同步的参数和配置解析，与数据类型无关
+ */
+class FrameSynchronizerBase : public ::sophon_stream::common::NoCopyable {
+ public:
+  enum class SyncKey {
+    TIMESTAMP,  // Frame::mTimestamp，单位微秒
+    FRAME_ID,   // Frame::mFrameId，适用于同源的本地文件
+  };
+
+  enum class Policy {
+    /**
+     * @brief 等待超时后用各port最近的帧组成一组，缺帧的port使用上一次输出的帧
+     */
+    NEAREST,
+    /**
+     * @brief 只输出误差在容差内的组，等待超时后丢弃无法对齐的帧
+     */
+    DROP,
+  };
+
+  struct Options {
+    SyncKey key = SyncKey::FRAME_ID;
+    // 同一组内各帧与组内最新一帧的最大差值，按key分别取
+    double toleranceMs = 20;
+    int toleranceFrames = 0;
+    Policy policy = Policy::DROP;
+    int bufferSize = 8;  // 每个port最多缓存的帧数
+    int maxWaitMs = 200;
+  };
+
+  static constexpr const char* JSON_SYNC_KEY = "sync_key";
+  static constexpr const char* JSON_SYNC_TOLERANCE_MS = "sync_tolerance_ms";
+  static constexpr const char* JSON_SYNC_TOLERANCE_FRAMES =
+      "sync_tolerance_frames";
+  static constexpr const char* JSON_SYNC_POLICY = "sync_policy";
+  static constexpr const char* JSON_SYNC_BUFFER_SIZE = "sync_buffer_size";
+  static constexpr const char* JSON_SYNC_MAX_WAIT_MS = "sync_max_wait_ms";
+
+  /**
+   * @brief 从element配置中读取同步参数，缺省的字段保留options中的值
+   */
+  static common::ErrorCode parseOptions(const nlohmann::json& configure,
+                                        Options& options);
+
+  // push和pop使用的单调时钟，单位微秒
+  static std::int64_t steadyNowUs();
+};
+
+/**
+ * @brief 多输入element的输入对齐，例如多路拼接、融合
+ * @brief
+ * 每个输入port一个有界的抖动缓冲，按帧时间戳(或帧号)把各port的帧对齐成一组再交给element。
+ * 某一路较快时只丢弃该路缓冲中最旧的帧，不会阻塞其他port；某一路缺帧时最多等待maxWaitMs，
+ * 之后按策略用最近的帧补齐或丢弃无法对齐的帧。某一路收到EOS后不再等待该路，
+ * 其他port缓存的帧立即按策略输出或丢弃。不加锁，每个dataPipe线程使用各自的实例
+ * @tparam Data 带mFrame的元数据，mFrame提供mTimestamp、mFrameId和mEndOfStream
+ */
+template <typename Data>
+class BasicFrameSynchronizer : public FrameSynchronizerBase {
+ public:
+  void configure(int portCount, const Options& options) {
+    mOptions = options;
+    mTolerance = options.key == SyncKey::TIMESTAMP
+                     ? static_cast<std::int64_t>(options.toleranceMs * 1000)
+                     : options.toleranceFrames;
+    mBuffers.assign(portCount, {});
+    mLast.assign(portCount, nullptr);
+    mEnded.assign(portCount, false);
+    mDropped = 0;
+  }
+
+  bool configured() const { return !mBuffers.empty(); }
+
+  /**
+   * @brief 放入port收到的一帧，缓冲已满时丢弃该port最旧的帧。
+   * EOS帧不进入缓冲，只标记该port已结束，之后再收到普通帧时恢复
+   */
+  void push(int portIndex, std::shared_ptr<Data> data, std::int64_t nowUs) {
+    if (portIndex < 0 || portIndex >= static_cast<int>(mBuffers.size()) ||
+        !data)
+      return;
+    if (data->mFrame && data->mFrame->mEndOfStream) {
+      mEnded[portIndex] = true;
+      return;
+    }
+    mEnded[portIndex] = false;
+    if (static_cast<int>(mBuffers[portIndex].size()) >= mOptions.bufferSize)
+      dropHead(portIndex);
+    std::int64_t key = keyOf(*data);
+    mBuffers[portIndex].push_back({std::move(data), key, nowUs});
+  }
+
+  /**
+   * @brief 取出对齐的一组帧，group[i]对应第i个port
+   * @return 没有可以输出的组时返回false
+   */
+  bool pop(std::vector<std::shared_ptr<Data>>& group, std::int64_t nowUs) {
+    const std::int64_t maxWaitUs =
+        static_cast<std::int64_t>(mOptions.maxWaitMs) * 1000;
+    while (true) {
+      bool allReady = true;
+      // 已结束且缓冲为空的port不会再有帧，不必等待
+      bool starved = false;
+      int oldestPort = -1;
+      std::int64_t oldestArrival = std::numeric_limits<std::int64_t>::max();
+      for (int i = 0; i < static_cast<int>(mBuffers.size()); ++i) {
+        if (mBuffers[i].empty()) {
+          allReady = false;
+          if (mEnded[i]) starved = true;
+        } else if (mBuffers[i].front().arrivalUs < oldestArrival) {
+          oldestArrival = mBuffers[i].front().arrivalUs;
+          oldestPort = i;
+        }
+      }
+      if (oldestPort < 0) return false;
+      // 最旧的一帧等待超过maxWait之前，继续等待落后或缺帧的port
+      bool timeout = starved || nowUs - oldestArrival >= maxWaitUs;
+
+      if (allReady) {
+        std::int64_t target = skipSuperseded();
+        bool aligned = true;
+        for (const auto& buffer : mBuffers)
+          if (target - buffer.front().key > mTolerance) aligned = false;
+        if (aligned || (timeout && mOptions.policy == Policy::NEAREST)) {
+          emit(group);
+          return true;
+        }
+        if (!timeout) return false;
+        for (int i = 0; i < static_cast<int>(mBuffers.size()); ++i)
+          if (target - mBuffers[i].front().key > mTolerance) dropHead(i);
+        continue;
+      }
+
+      if (!timeout) return false;
+      if (mOptions.policy == Policy::NEAREST) {
+        bool canFill = true;
+        for (std::size_t i = 0; i < mBuffers.size(); ++i)
+          if (mBuffers[i].empty() && !mLast[i]) canFill = false;
+        if (canFill) {
+          emit(group);
+          return true;
+        }
+      }
+      dropHead(oldestPort);
+    }
+  }
+
+  /**
+   * @brief 取出上次调用以来因为缓冲溢出或无法对齐而丢弃的帧数
+   */
+  std::int64_t takeDropped() {
+    std::int64_t dropped = mDropped;
+    mDropped = 0;
+    return dropped;
+  }
+
+ private:
+  struct Entry {
+    std::shared_ptr<Data> data;
+    std::int64_t key;
+    std::int64_t arrivalUs;
+  };
+
+  std::int64_t keyOf(const Data& data) const {
+    if (!data.mFrame) return 0;
+    return mOptions.key == SyncKey::TIMESTAMP ? data.mFrame->mTimestamp
+                                              : data.mFrame->mFrameId;
+  }
+
+  // 对齐目标为各port队首中最新的一帧，丢弃已有更接近目标的后续帧的队首，返回目标
+  std::int64_t skipSuperseded() {
+    std::int64_t target = 0;
+    bool changed = true;
+    while (changed) {
+      changed = false;
+      target = std::numeric_limits<std::int64_t>::min();
+      for (const auto& buffer : mBuffers)
+        target = std::max(target, buffer.front().key);
+      for (int i = 0; i < static_cast<int>(mBuffers.size()); ++i) {
+        auto& buffer = mBuffers[i];
+        while (buffer.size() >= 2) {
+          std::int64_t current = buffer[0].key, next = buffer[1].key;
+          if (next > target &&
+              std::abs(next - target) >= std::abs(current - target))
+            break;
+          dropHead(i);
+          changed = true;
+        }
+      }
+    }
+    return target;
+  }
+
+  void emit(std::vector<std::shared_ptr<Data>>& group) {
+    group.resize(mBuffers.size());
+    for (std::size_t i = 0; i < mBuffers.size(); ++i) {
+      if (mBuffers[i].empty()) {
+        group[i] = mLast[i];
+        continue;
+      }
+      group[i] = std::move(mBuffers[i].front().data);
+      mBuffers[i].pop_front();
+      mLast[i] = group[i];
+    }
+  }
+
+  void dropHead(int portIndex) {
+    mBuffers[portIndex].pop_front();
+    ++mDropped;
+  }
+
+  Options mOptions;
+  std::int64_t mTolerance = 0;
+  std::vector<std::deque<Entry>> mBuffers;
+  std::vector<std::shared_ptr<Data>> mLast;
+  std::vector<bool> mEnded;
+  std::int64_t mDropped = 0;
+};
+
+using FrameSynchronizer = BasicFrameSynchronizer<common::ObjectMetadata>;
+
+}  // namespace framework
+}  // namespace sophon_stream
+
+#endif  // SOPHON_STREAM_FRAMEWORK_FRAME_SYNCHRONIZER_H_
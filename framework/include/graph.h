@@ -14,7 +14,9 @@
 #include <chrono>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <vector>
 
 #include "common/error_code.h"
 #include "common/logger.h"
@@ -55,6 +57,13 @@ class Graph : public ::sophon_stream::common::NoCopyable {
   common::ErrorCode pushSourceData(int elementId, int inputPort,
                                    std::shared_ptr<void> data);
 
+  /**
+   * @brief 向指定element推入控制消息，控制消息会沿连接逐级转发
+   * @param[in] channelId : 只对EOS有效，指定时沿该通道的路由送出
+   */
+  common::ErrorCode pushControlMessage(int elementId, int inputPort,
+                                       MessageKind kind, int channelId = -1);
+
   /**
    * @brief
    * 为指定element设置sinkHandler，sinkHandler当且仅当指定element是sink
@@ -66,6 +75,51 @@ class Graph : public ::sophon_stream::common::NoCopyable {
 
   int getId() const;
 
+  /**
+   * @brief 对运行中的graph应用configure补丁，不重新加载模型，也不中断码流
+   * @param[in] patch :
+   * {"elements": [{"id": 5001, "configure": {...}}], "stage": false}
+   * @brief
+   * 先检查所有element，任一element不能应用时整体拒绝；需要重启的字段在stage为true时暂存
+   * @brief 检查通过后所有相关element同时停在两帧之间，一起生效后再继续运行
+   */
+  common::ErrorCode reconfigure(const nlohmann::json& patch);
+
+  /**
+   * @brief 获取graph配置
+   * @param[in] withStaged :
+   * 为true时合并各element暂存的字段，可以直接用于重建graph
+   */
+  nlohmann::json getConfigure(bool withStaged);
+
+  /**
+   * @brief 获取element的当前配置、可热更新字段和暂存字段
+   */
+  nlohmann::json getElementConfigure(int elementId);
+
+  /**
+   * @brief 配置文件中声明的element id，group内部element不包含在内
+   */
+  const std::vector<int>& getElementIds() const { return mElementIds; }
+
+  /**
+   * @brief graph已经启动，并且所有element都完成了初始化和预热
+   * @brief 配置了lazy_init、尚未收到数据的element视为就绪
+   */
+  bool isReady();
+
+  /**
+   * @brief 获取graph和各element的初始化状态及耗时
+   */
+  nlohmann::json getHealth();
+
+  /**
+   * @brief 把有运行状态的element的状态保存到snapshot_dir
+   * @brief 运行中调用时相关element先停在两帧之间，保存完成后继续运行；
+   * 配置了snapshot_dir时stop()会自动保存，start()会自动恢复
+   */
+  common::ErrorCode saveSnapshot();
+
   inline ListenThread* getListener() { return listenThreadPtr; }
 
   inline void setListener(ListenThread* p) { listenThreadPtr = p; }
@@ -73,18 +127,28 @@ class Graph : public ::sophon_stream::common::NoCopyable {
   static constexpr const char* JSON_GRAPH_ID_FIELD = "graph_id";
   static constexpr const char* JSON_WORKERS_FIELD = "elements";
   static constexpr const char* JSON_CONNECTIONS_FIELD = "connections";
+  static constexpr const char* JSON_INIT_PARALLELISM_FIELD = "init_parallelism";
+  static constexpr const char* JSON_SNAPSHOT_DIR_FIELD = "snapshot_dir";
   static constexpr const char* JSON_MODEL_SHARED_OBJECT_FIELD = "shared_object";
   static constexpr const char* JSON_WORKER_NAME_FIELD = "name";
   static constexpr const char* JSON_CONNECTION_SRC_ID_FIELD = "src_id";
   static constexpr const char* JSON_CONNECTION_SRC_PORT_FIELD = "src_port";
   static constexpr const char* JSON_CONNECTION_DST_ID_FIELD = "dst_id";
   static constexpr const char* JSON_CONNECTION_DST_PORT_FIELD = "dst_port";
+  static constexpr const char* JSON_RECONFIGURE_STAGE_FIELD = "stage";
+  static constexpr const char* JSON_ELEMENT_ID_FIELD = "id";
+  static constexpr const char* JSON_ELEMENT_CONFIGURE_FIELD = "configure";
 
  private:
   common::ErrorCode initElements(const std::string& json);
   common::ErrorCode initConnections(const std::string& json);
   common::ErrorCode connect(int srcId, int srcPort, int dstId, int dstPort);
 
+  std::string getSnapshotPath(int elementId) const;
+  common::ErrorCode writeSnapshot(
+      const std::vector<std::shared_ptr<framework::Element> >& elements);
+  void loadSnapshot();
+
   int mId;
 
   std::atomic<ThreadStatus> mThreadStatus;
@@ -94,6 +158,21 @@ class Graph : public ::sophon_stream::common::NoCopyable {
   std::map<int /* elementId */, std::shared_ptr<framework::Element> >
       mElementMap;
 
+  std::vector<int> mElementIds;
+
+  // 并行初始化element的线程数，默认为cpu核数
+  int mInitParallelism = 1;
+
+  // init时的graph配置
+  nlohmann::json mConfigure;
+  // 同一时间只允许一个reconfigure或者saveSnapshot
+  std::mutex mReconfigureMutex;
+
+  // 运行状态快照的目录，为空时不保存
+  std::string mSnapshotDir;
+  // {elementId : 配置中的name}，写入快照用于校验
+  std::map<int, std::string> mElementNames;
+
   // friend class ListenThread;
   ListenThread* listenThreadPtr;
 };
@@ -53,7 +53,7 @@ class Group : public ::sophon_stream::framework::Element {
 
       if (!preElement || !inferElement || !postElement) break;
 
-      initElements(json);
+      errorCode = initElements(json);
 
     } while (false);
     return errorCode;
@@ -65,6 +65,22 @@ class Group : public ::sophon_stream::framework::Element {
 
   bool getGroup() override { return true; }
 
+  // lazy_init时以preElement的状态为准，它负责加载模型和预热
+  InitStatus getInitStatus() const override {
+    if (isLazyInit() && preElement) return preElement->getInitStatus();
+    return Element::getInitStatus();
+  }
+
+  common::ErrorCode warmup() override { return preElement->warmup(); }
+
+  bool isChannelStateful() const override {
+    return preElement && preElement->isChannelStateful();
+  }
+
+  bool acceptsDetectionBatch() const override {
+    return preElement && preElement->acceptsDetectionBatch();
+  }
+
   void groupInsert(
       std::map<int, std::shared_ptr<framework::Element>>& mapPtr) override {
     auto preElement = this->getPreElement();
@@ -104,6 +120,35 @@ class Group : public ::sophon_stream::framework::Element {
     postElement->registListenFunc(listener);
   }
 
+  std::set<std::string> getHotConfigureKeys() const override {
+    return preElement ? preElement->getHotConfigureKeys()
+                      : std::set<std::string>();
+  }
+
+  // 三个内部element共用同一个context，只需要通过preElement应用一次
+  common::ErrorCode applyConfigure(const nlohmann::json& configure,
+                                   bool check) override {
+    return preElement->applyConfigure(configure, check);
+  }
+
+  void requestQuiesce() override {
+    preElement->requestQuiesce();
+    inferElement->requestQuiesce();
+    postElement->requestQuiesce();
+  }
+
+  bool waitQuiesced(std::chrono::steady_clock::time_point deadline) override {
+    return preElement->waitQuiesced(deadline) &&
+           inferElement->waitQuiesced(deadline) &&
+           postElement->waitQuiesced(deadline);
+  }
+
+  void releaseQuiesce() override {
+    preElement->releaseQuiesce();
+    inferElement->releaseQuiesce();
+    postElement->releaseQuiesce();
+  }
+
   void afterConnect(bool is_dst, bool is_src) {
     auto preElement = getPreElement();
     auto postElement = getPostElement();
@@ -168,9 +213,43 @@ class Group : public ::sophon_stream::framework::Element {
     inferElement->setThreadNumber(threadNum);
     postElement->setThreadNumber(threadNum);
 
-    preElement->initInternal(json);
-    preElement->setStage(true, false, false);
+    common::ErrorCode errorCode = common::ErrorCode::SUCCESS;
+    if (isLazyInit()) {
+      // preElement在第一个通道到达时加载模型，之后数据才会流到另外两个element
+      preElement->setLazyInit([this]() {
+        auto configure = getConfigure(false);
+        configure[JSON_INNER_ELEMENTS_ID] = inner_elements_id;
+        common::ErrorCode errorCode = initContext(configure.dump());
+        if (common::ErrorCode::SUCCESS == errorCode && isWarmupEnabled())
+          errorCode = preElement->warmup();
+        return errorCode;
+      });
+      auto waitContext = []() { return common::ErrorCode::SUCCESS; };
+      inferElement->setLazyInit(waitContext);
+      postElement->setLazyInit(waitContext);
+    } else {
+      errorCode = initContext(json);
+    }
+
     preElement->initProfiler("fps_" + elementName + "_pre", 100);
+    inferElement->setStage(false, true, false);
+    inferElement->initProfiler("fps_" + elementName + "_infer", 100);
+    postElement->setStage(false, false, true);
+    postElement->initProfiler("fps_" + elementName + "_post", 100);
+
+    connect(*preElement, 0, *inferElement, 0);
+    connect(*inferElement, 0, *postElement, 0);
+
+    return errorCode;
+  }
+
+  /**
+   * @brief preElement加载模型，并把context和前处理、推理、后处理对象共享给另外两个element
+   */
+  common::ErrorCode initContext(const std::string& json) {
+    common::ErrorCode errorCode = preElement->initInternal(json);
+    if (common::ErrorCode::SUCCESS != errorCode) return errorCode;
+    preElement->setStage(true, false, false);
 
     auto context = preElement->getContext();
     auto pre = preElement->getPreProcess();
@@ -181,18 +260,11 @@ class Group : public ::sophon_stream::framework::Element {
     inferElement->setPreprocess(pre);
     inferElement->setInference(infer);
     inferElement->setPostprocess(post);
-    inferElement->setStage(false, true, false);
-    inferElement->initProfiler("fps_" + elementName + "_infer", 100);
 
     postElement->setContext(context);
     postElement->setPreprocess(pre);
     postElement->setInference(infer);
     postElement->setPostprocess(post);
-    postElement->setStage(false, false, true);
-    postElement->initProfiler("fps_" + elementName + "_post", 100);
-
-    connect(*preElement, 0, *inferElement, 0);
-    connect(*inferElement, 0, *postElement, 0);
 
     return common::ErrorCode::SUCCESS;
   }
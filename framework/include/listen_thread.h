@@ -69,6 +69,8 @@ class ListenThread {
 
  private:
   httplib::Server server;
+  // 多个graph并行初始化时会同时注册handler
+  std::mutex handlerMutex;
   std::shared_ptr<ReportImpl_> client;
   http_config report_config;
   http_config listen_config;
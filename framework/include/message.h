@@ -0,0 +1,123 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SOPHON_STREAM_FRAMEWORK_MESSAGE_H_
+#define SOPHON_STREAM_FRAMEWORK_MESSAGE_H_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <variant>
+
+#include "common/object_metadata.h"
+#include "message_header.h"
+
+namespace sophon_stream {
+namespace framework {
+
+/**
+ * @brief element之间传递的消息
+ * @brief
+ * 消息按值传递，dataPipe和connector内部只做移动，每经过一个element不再有额外的引用计数操作和堆分配；
+ * 控制消息只有消息头，不分配内存
+ */
+class Message {
+ public:
+  Message() = default;
+
+  /**
+   * @brief 携带ObjectMetadata的数据消息，消息头的通道和优先级取自mFrame
+   */
+  explicit Message(std::shared_ptr<common::ObjectMetadata> objectMetadata) {
+    if (objectMetadata && objectMetadata->mFrame) {
+      mHeader.mChannelId = objectMetadata->mFrame->mChannelIdInternal;
+      mHeader.mPriority = objectMetadata->mFrame->mPriority;
+    }
+    mPayload = std::move(objectMetadata);
+  }
+
+  /**
+   * @brief 携带其它类型数据的消息，例如发给decode的ChannelTask
+   */
+  explicit Message(std::shared_ptr<void> data, int priority = 0) {
+    mHeader.mPriority = priority;
+    mPayload = std::move(data);
+  }
+
+  static Message control(MessageKind kind, int channelId = -1) {
+    static std::atomic<std::uint64_t> controlSequence{0};
+    Message message;
+    message.mHeader.mKind = kind;
+    message.mHeader.mChannelId = channelId;
+    message.mHeader.mSequence = ++controlSequence;
+    return message;
+  }
+
+  /**
+   * @brief 是否为空消息，空消息表示队列中没有数据
+   */
+  bool empty() const {
+    return MessageKind::DATA == mHeader.mKind &&
+           std::holds_alternative<std::monostate>(mPayload);
+  }
+
+  explicit operator bool() const { return !empty(); }
+
+  bool isControl() const { return MessageKind::DATA != mHeader.mKind; }
+
+  MessageHeader& header() { return mHeader; }
+  const MessageHeader& header() const { return mHeader; }
+
+  /**
+   * @brief 获取ObjectMetadata，其它类型的数据返回nullptr
+   */
+  std::shared_ptr<common::ObjectMetadata> getObjectMetadata() const {
+    auto objectMetadata =
+        std::get_if<std::shared_ptr<common::ObjectMetadata> >(&mPayload);
+    return objectMetadata ? *objectMetadata : nullptr;
+  }
+
+  /**
+   * @brief 取出数据，之后消息为空
+   */
+  std::shared_ptr<void> takePayload() {
+    std::shared_ptr<void> data;
+    if (auto objectMetadata =
+            std::get_if<std::shared_ptr<common::ObjectMetadata> >(&mPayload))
+      data = std::move(*objectMetadata);
+    else if (auto opaque = std::get_if<std::shared_ptr<void> >(&mPayload))
+      data = std::move(*opaque);
+    mPayload = std::monostate();
+    return data;
+  }
+
+  /**
+   * @brief 取出ObjectMetadata，其它类型的数据返回nullptr且不取出
+   */
+  std::shared_ptr<common::ObjectMetadata> takeObjectMetadata() {
+    auto objectMetadata =
+        std::get_if<std::shared_ptr<common::ObjectMetadata> >(&mPayload);
+    if (!objectMetadata) return nullptr;
+    auto data = std::move(*objectMetadata);
+    mPayload = std::monostate();
+    return data;
+  }
+
+ private:
+  MessageHeader mHeader;
+  std::variant<std::monostate, std::shared_ptr<common::ObjectMetadata>,
+               std::shared_ptr<void> >
+      mPayload;
+};
+
+}  // namespace framework
+}  // namespace sophon_stream
+
+#endif  // SOPHON_STREAM_FRAMEWORK_MESSAGE_H_
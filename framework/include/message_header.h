@@ -0,0 +1,61 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SOPHON_STREAM_FRAMEWORK_MESSAGE_HEADER_H_
+#define SOPHON_STREAM_FRAMEWORK_MESSAGE_HEADER_H_
+
+#include <chrono>
+#include <cstdint>
+
+namespace sophon_stream {
+namespace framework {
+
+/**
+ * @brief 消息类型
+ */
+enum class MessageKind {
+  /**
+   * @brief 携带数据的消息
+   */
+  DATA,
+  /**
+   * @brief 通道结束，不携带数据。指定通道时沿该通道的路由送出并释放路由
+   */
+  EOS,
+  /**
+   * @brief 要求下游立即送出正在收集的batch，不携带数据
+   */
+  FLUSH,
+};
+
+/**
+ * @brief 消息头，调度时只需要读取消息头
+ */
+struct MessageHeader {
+  /**
+   * @brief channelIdInternal，未知或者不属于某个通道时为-1
+   */
+  int mChannelId = -1;
+  /**
+   * @brief 数据消息为dataPipe内的入队序号；控制消息为创建时分配的全局序号，
+   * 转发时保持不变，用于去重
+   */
+  std::uint64_t mSequence = 0;
+  /**
+   * @brief 最近一次进入dataPipe的时间
+   */
+  std::chrono::steady_clock::time_point mEnqueueTime;
+  MessageKind mKind = MessageKind::DATA;
+  int mPriority = 0;
+};
+
+}  // namespace framework
+}  // namespace sophon_stream
+
+#endif  // SOPHON_STREAM_FRAMEWORK_MESSAGE_HEADER_H_
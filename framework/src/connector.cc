@@ -19,15 +19,136 @@ Connector::Connector(int dataPipeCount) {
     auto datapipe = std::make_shared<DataPipe>();
     mDataPipes.push_back(datapipe);
   }
+  mPipeLoads.assign(mCapacity, 0);
+  mPopped.resize(mCapacity);
 }
 
-std::shared_ptr<void> Connector::popData(int id) {
-  return getDataPipe(id)->popData();
+Connector::RoutingStrategy Connector::parseRoutingStrategy(
+    const std::string& name) {
+  if (name == "sticky") return RoutingStrategy::STICKY;
+  if (name == "round_robin") return RoutingStrategy::ROUND_ROBIN;
+  if (name != "modulo")
+    IVS_WARN("Unknown routing strategy {0}, use modulo", name);
+  return RoutingStrategy::MODULO;
 }
 
-common::ErrorCode Connector::pushData(
-    int id, std::shared_ptr<void> data) {
-  return getDataPipe(id)->pushData(data);
+void Connector::setRouting(RoutingStrategy strategy, bool channelStateful,
+                           const std::map<int, int>& affinity) {
+  std::lock_guard<std::mutex> lock(mRouteMutex);
+  if (channelStateful && strategy == RoutingStrategy::ROUND_ROBIN) {
+    IVS_WARN(
+        "Element keeps per channel state or needs ordered frames, round robin "
+        "falls back to sticky");
+    strategy = RoutingStrategy::STICKY;
+  }
+  mStrategy = strategy;
+  mChannelStateful = channelStateful;
+  mAffinity = affinity;
+}
+
+int Connector::route(int channelIdInternal, bool endOfStream) {
+  std::lock_guard<std::mutex> lock(mRouteMutex);
+  if (mCapacity <= 1) return 0;
+
+  auto affinityIt = mAffinity.find(channelIdInternal);
+  if (affinityIt != mAffinity.end()) return affinityIt->second % mCapacity;
+
+  if (mStrategy == RoutingStrategy::MODULO)
+    return channelIdInternal % mCapacity;
+  if (mStrategy == RoutingStrategy::ROUND_ROBIN) {
+    int id = mRoundRobinIndex;
+    mRoundRobinIndex = (mRoundRobinIndex + 1) % mCapacity;
+    return id;
+  }
+
+  auto routeIt = mRoutes.find(channelIdInternal);
+  if (routeIt == mRoutes.end()) {
+    // 通道数相同时选择当前积压最少的dataPipe
+    int id = 0;
+    for (int i = 1; i < mCapacity; ++i) {
+      if (mPipeLoads[i] < mPipeLoads[id] ||
+          (mPipeLoads[i] == mPipeLoads[id] &&
+           mDataPipes[i]->getSize() < mDataPipes[id]->getSize()))
+        id = i;
+    }
+    ++mPipeLoads[id];
+    routeIt = mRoutes.emplace(channelIdInternal, id).first;
+  }
+
+  auto migrationIt = mMigrations.find(channelIdInternal);
+  if (migrationIt != mMigrations.end() &&
+      mInFlight.find(channelIdInternal) == mInFlight.end()) {
+    routeIt->second = migrationIt->second;
+    mMigrations.erase(migrationIt);
+  }
+
+  int id = routeIt->second;
+  if (endOfStream) releaseRoute(channelIdInternal);
+  return id;
+}
+
+void Connector::releaseRoute(int channelIdInternal) {
+  auto routeIt = mRoutes.find(channelIdInternal);
+  if (routeIt == mRoutes.end()) return;
+  auto migrationIt = mMigrations.find(channelIdInternal);
+  int freed = migrationIt == mMigrations.end() ? routeIt->second
+                                               : migrationIt->second;
+  --mPipeLoads[freed];
+  mRoutes.erase(routeIt);
+  if (migrationIt != mMigrations.end()) mMigrations.erase(migrationIt);
+
+  if (mChannelStateful) return;
+  // 最忙的dataPipe比释放出来的dataPipe多一个以上通道时，迁移其中一个通道
+  int busiest = 0;
+  for (int i = 1; i < mCapacity; ++i)
+    if (mPipeLoads[i] > mPipeLoads[busiest]) busiest = i;
+  if (mPipeLoads[busiest] - mPipeLoads[freed] <= 1) return;
+  for (auto& route : mRoutes) {
+    if (route.second != busiest || mMigrations.count(route.first)) continue;
+    mMigrations[route.first] = freed;
+    --mPipeLoads[busiest];
+    ++mPipeLoads[freed];
+    break;
+  }
+}
+
+Message Connector::popData(int id) {
+  auto message = getDataPipe(id)->popData();
+  int channelIdInternal = message.header().mChannelId;
+  if (!message.empty() && channelIdInternal >= 0) {
+    std::lock_guard<std::mutex> lock(mRouteMutex);
+    mPopped[id].push_back(channelIdInternal);
+  }
+  return message;
+}
+
+common::ErrorCode Connector::pushData(int id, Message&& message) {
+  int channelIdInternal = message.header().mChannelId;
+  if (channelIdInternal < 0)
+    return getDataPipe(id)->pushData(std::move(message));
+  // 先计数再入队，消费线程可能在pushData返回之前就处理完这条消息
+  {
+    std::lock_guard<std::mutex> lock(mRouteMutex);
+    ++mInFlight[channelIdInternal];
+  }
+  auto ret = getDataPipe(id)->pushData(std::move(message));
+  if (common::ErrorCode::SUCCESS != ret) {
+    std::lock_guard<std::mutex> lock(mRouteMutex);
+    decreaseInFlight(channelIdInternal);
+  }
+  return ret;
+}
+
+void Connector::release(int id) {
+  if (id < 0 || id >= mCapacity) return;
+  std::lock_guard<std::mutex> lock(mRouteMutex);
+  for (int channelIdInternal : mPopped[id]) decreaseInFlight(channelIdInternal);
+  mPopped[id].clear();
+}
+
+void Connector::decreaseInFlight(int channelIdInternal) {
+  auto it = mInFlight.find(channelIdInternal);
+  if (it != mInFlight.end() && --it->second <= 0) mInFlight.erase(it);
 }
 
 
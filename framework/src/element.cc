@@ -7,8 +7,7 @@ void Element::connect(Element& srcElement, int srcElementPort,
                       Element& dstElement, int dstElementPort) {
   auto& inputConnector = dstElement.mInputConnectorMap[dstElementPort];
   if (!inputConnector) {
-    inputConnector =
-        std::make_shared<framework::Connector>(dstElement.getThreadNumber());
+    inputConnector = dstElement.makeInputConnector();
     IVS_DEBUG(
         "InputConnector initialized, mId = {0}, inputPort = {1}, dataPipeNum = "
         "{2}",
@@ -73,6 +72,28 @@ common::ErrorCode Element::init(const std::string& json) {
       mThreadNumber = threadNumberIt->get<int>();
     }
 
+    auto routingIt = configure.find(JSON_ROUTING_FIELD);
+    if (configure.end() != routingIt && routingIt->is_string()) {
+      mRoutingStrategy =
+          Connector::parseRoutingStrategy(routingIt->get<std::string>());
+    }
+
+    auto affinityIt = configure.find(JSON_CHANNEL_AFFINITY_FIELD);
+    if (configure.end() != affinityIt && affinityIt->is_object()) {
+      for (auto& it : affinityIt->items())
+        mChannelAffinity[std::stoi(it.key())] = it.value().get<int>();
+    }
+
+    auto lazyInitIt = configure.find(JSON_LAZY_INIT_FIELD);
+    if (configure.end() != lazyInitIt && lazyInitIt->is_boolean()) {
+      mLazyInit = lazyInitIt->get<bool>();
+    }
+
+    auto warmupIt = configure.find(JSON_WARMUP_FIELD);
+    if (configure.end() != warmupIt && warmupIt->is_boolean()) {
+      mWarmup = warmupIt->get<bool>();
+    }
+
     std::vector<int> inner_elements_id;
     bool is_group = false;
     auto innerIdsIt = configure.find(JSON_INNER_ELEMENTS_ID);
@@ -83,13 +104,33 @@ common::ErrorCode Element::init(const std::string& json) {
     std::string internalConfigure;
     auto internalConfigureIt = configure.find(JSON_CONFIGURE_FIELD);
     if (configure.end() != internalConfigureIt) {
+      if (internalConfigureIt->is_object()) {
+        std::lock_guard<std::mutex> lock(mConfigureMutex);
+        mConfigure = *internalConfigureIt;
+      }
       if (getGroup())
         (*internalConfigureIt)[JSON_INNER_ELEMENTS_ID] = inner_elements_id;
       internalConfigure = internalConfigureIt->dump();
     }
 
+    // group的内部element在Group::initInternal中按lazy_init处理
+    if (mLazyInit && !getGroup()) {
+      setLazyInit([this]() {
+        return initInternal(getConfigure(false).dump());
+      });
+      IVS_INFO("Init internal is deferred to the first channel, element id: "
+               "{0:d}",
+               mId);
+      break;
+    }
+
+    auto initStart = std::chrono::steady_clock::now();
     errorCode = initInternal(internalConfigure);
+    mInitCostMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+                      std::chrono::steady_clock::now() - initStart)
+                      .count();
     if (common::ErrorCode::SUCCESS != errorCode) {
+      mInitStatus = InitStatus::FAIL;
       IVS_ERROR("Init internal fail, json: {0}", internalConfigure);
       break;
     }
@@ -100,6 +141,42 @@ common::ErrorCode Element::init(const std::string& json) {
   return errorCode;
 }
 
+common::ErrorCode Element::prepare() {
+  // lazy_init的group由内部element在第一个通道到达时完成预热
+  if (InitStatus::PENDING != mInitStatus || mLazyInit)
+    return common::ErrorCode::SUCCESS;
+
+  common::ErrorCode errorCode = common::ErrorCode::SUCCESS;
+  if (mWarmup) {
+    mInitStatus = InitStatus::WARMUP;
+    errorCode = timedWarmup();
+  }
+  mInitStatus = common::ErrorCode::SUCCESS == errorCode ? InitStatus::READY
+                                                        : InitStatus::FAIL;
+  return errorCode;
+}
+
+void Element::setLazyInit(std::function<common::ErrorCode()> lazyInitFunc) {
+  mLazyInitFunc = lazyInitFunc;
+  mInitStatus = InitStatus::LAZY;
+}
+
+const char* Element::initStatusToString(InitStatus status) {
+  switch (status) {
+    case InitStatus::PENDING:
+      return "pending";
+    case InitStatus::LAZY:
+      return "lazy";
+    case InitStatus::WARMUP:
+      return "warmup";
+    case InitStatus::READY:
+      return "ready";
+    case InitStatus::FAIL:
+      return "fail";
+  }
+  return "unknown";
+}
+
 common::ErrorCode Element::start() {
   IVS_INFO("Start element thread start, element id: {0:d}", mId);
 
@@ -129,6 +206,10 @@ common::ErrorCode Element::stop() {
   }
 
   mThreadStatus = ThreadStatus::STOP;
+  {
+    std::lock_guard<std::mutex> lock(mQuiesceMutex);
+    mQuiesceCv.notify_all();
+  }
 
   for (auto thread : mThreads) {
     thread->join();
@@ -171,12 +252,81 @@ void Element::run(int dataPipeId) {
   onStart();
   prctl(PR_SET_NAME, std::to_string(mId).c_str());
   while (ThreadStatus::RUN == mThreadStatus) {
+    parkIfQuiescing();
+    if (mLazyInitFunc && !tryLazyInit(dataPipeId)) continue;
     doWork(dataPipeId);
+    // 本线程弹出的消息已经处理完，对应通道可以迁移到其它线程
+    for (auto& it : mInputConnectorMap)
+      if (it.second) it.second->release(dataPipeId);
     std::this_thread::yield();
   }
   onStop();
 }
 
+bool Element::tryLazyInit(int dataPipeId) {
+  InitStatus status = mInitStatus;
+  if (InitStatus::READY == status) return true;
+
+  if (InitStatus::LAZY == status && hasInputData(dataPipeId)) {
+    // 其它线程在call_once中等待初始化完成
+    std::call_once(mLazyInitFlag, [this]() {
+      IVS_INFO("Lazy init start, element id: {0:d}", mId);
+      mInitStatus = InitStatus::WARMUP;
+      auto initStart = std::chrono::steady_clock::now();
+      common::ErrorCode errorCode = mLazyInitFunc();
+      mInitCostMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+                        std::chrono::steady_clock::now() - initStart)
+                        .count();
+      if (common::ErrorCode::SUCCESS == errorCode && mWarmup)
+        errorCode = timedWarmup();
+      if (common::ErrorCode::SUCCESS != errorCode) {
+        mInitStatus = InitStatus::FAIL;
+        IVS_ERROR("Lazy init fail, element id: {0:d}, error: {1}", mId,
+                  common::ErrorCodeToString(errorCode));
+        return;
+      }
+      mInitStatus = InitStatus::READY;
+      IVS_INFO("Lazy init finish, element id: {0:d}, cost: {1:d} ms", mId,
+               mInitCostMs + mWarmupCostMs);
+    });
+    if (InitStatus::READY == mInitStatus) return true;
+  }
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  return false;
+}
+
+bool Element::hasInputData(int dataPipeId) {
+  for (auto& it : mInputConnectorMap) {
+    if (!it.second || dataPipeId >= it.second->getCapacity()) continue;
+    auto dataPipe = it.second->getDataPipe(dataPipeId);
+    if (dataPipe && dataPipe->getSize() > 0) return true;
+  }
+  return false;
+}
+
+common::ErrorCode Element::warmup() {
+  IVS_WARN("Element {0:d} does not support warmup, warmup is ignored", mId);
+  return common::ErrorCode::SUCCESS;
+}
+
+common::ErrorCode Element::timedWarmup() {
+  IVS_INFO("Warmup start, element id: {0:d}", mId);
+  auto warmupStart = std::chrono::steady_clock::now();
+  common::ErrorCode errorCode = warmup();
+  mWarmupCostMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+                      std::chrono::steady_clock::now() - warmupStart)
+                      .count();
+  if (common::ErrorCode::SUCCESS != errorCode) {
+    IVS_ERROR("Warmup fail, element id: {0:d}, error: {1}", mId,
+              common::ErrorCodeToString(errorCode));
+  } else {
+    IVS_INFO("Warmup finish, element id: {0:d}, cost: {1:d} ms", mId,
+             static_cast<int>(mWarmupCostMs));
+  }
+  return errorCode;
+}
+
 common::ErrorCode Element::pushInputData(int inputPort, int dataPipeId,
                                          std::shared_ptr<void> data) {
   IVS_DEBUG("push data, element id: {0:d}, input port: {1:d}, data: {2:p}", mId,
@@ -184,13 +334,15 @@ common::ErrorCode Element::pushInputData(int inputPort, int dataPipeId,
 
   auto& inputConnector = mInputConnectorMap[inputPort];
   if (!inputConnector) {
-    inputConnector = std::make_shared<framework::Connector>(mThreadNumber);
+    inputConnector = makeInputConnector();
     IVS_DEBUG(
         "InputConnector initialized, mId = {0}, inputPort = {1}, dataPipeNum = "
         "{2}",
         mId, inputPort, mThreadNumber);
   }
-  while (mInputConnectorMap[inputPort]->pushData(dataPipeId, data) !=
+  Message message(std::move(data));
+  while (mInputConnectorMap[inputPort]->pushData(dataPipeId,
+                                                 std::move(message)) !=
          common::ErrorCode::SUCCESS) {
     listenThreadPtr->report_status(common::ErrorCode::DECODE_CHANNEL_PIPE_FULL);
     IVS_DEBUG("Input DataPipe is full, now sleeping...");
@@ -199,11 +351,51 @@ common::ErrorCode Element::pushInputData(int inputPort, int dataPipeId,
   return common::ErrorCode::SUCCESS;
 }
 
-std::shared_ptr<void> Element::popInputData(int inputPort, int dataPipeId) {
+common::ErrorCode Element::pushControlMessage(int inputPort, MessageKind kind,
+                                              int channelId) {
+  auto& inputConnector = mInputConnectorMap[inputPort];
+  if (!inputConnector) inputConnector = makeInputConnector();
+
+  Message message = Message::control(kind, channelId);
+  std::vector<int> dataPipeIds;
+  if (channelId >= 0) {
+    dataPipeIds.push_back(
+        inputConnector->route(channelId, MessageKind::EOS == kind));
+  } else {
+    for (int i = 0; i < inputConnector->getCapacity(); ++i)
+      dataPipeIds.push_back(i);
+  }
+  for (int dataPipeId : dataPipeIds) {
+    Message copy = message;
+    while (inputConnector->pushData(dataPipeId, std::move(copy)) !=
+           common::ErrorCode::SUCCESS) {
+      if (ThreadStatus::STOP == mThreadStatus)
+        return common::ErrorCode::DATA_PIPE_FULL;
+      std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+  }
+  return common::ErrorCode::SUCCESS;
+}
+
+Message Element::popInputMessage(int inputPort, int dataPipeId) {
   if (mInputConnectorMap[inputPort] == nullptr)
-    mInputConnectorMap[inputPort] =
-        std::make_shared<framework::Connector>(mThreadNumber);
-  return mInputConnectorMap[inputPort]->popData(dataPipeId);
+    mInputConnectorMap[inputPort] = makeInputConnector();
+  auto message = mInputConnectorMap[inputPort]->popData(dataPipeId);
+  if (message.empty()) parkIfQuiescing();
+  return message;
+}
+
+std::shared_ptr<void> Element::popInputData(int inputPort, int dataPipeId) {
+  auto message = popInputMessage(inputPort, dataPipeId);
+  while (message.isControl()) {
+    forwardControlMessage(message);
+    message = popInputMessage(inputPort, dataPipeId);
+  }
+  if (!acceptsDetectionBatch()) {
+    auto objectMetadata = message.getObjectMetadata();
+    if (objectMetadata) objectMetadata->materializeDetectionBatch();
+  }
+  return message.takePayload();
 }
 
 void Element::setSinkHandler(int outputPort, SinkHandler dataHandler) {
@@ -214,25 +406,40 @@ void Element::setSinkHandler(int outputPort, SinkHandler dataHandler) {
 
 common::ErrorCode Element::pushOutputData(int outputPort, int dataPipeId,
                                           std::shared_ptr<void> data) {
-  IVS_DEBUG("send data, element id: {0:d}, output port: {1:d}, data:{2:p}", mId,
-            outputPort, data.get());
+  // element之间传递的数据都是ObjectMetadata
+  return pushOutputMessage(
+      outputPort, dataPipeId,
+      Message(std::static_pointer_cast<common::ObjectMetadata>(data)));
+}
+
+common::ErrorCode Element::pushOutputMessage(int outputPort, int dataPipeId,
+                                             Message&& message) {
+  IVS_DEBUG("send message, element id: {0:d}, output port: {1:d}, channel: "
+            "{2:d}, kind: {3:d}",
+            mId, outputPort, message.header().mChannelId,
+            static_cast<int>(message.header().mKind));
   if (mSinkElementFlag) {
     auto handlerIt = mSinkHandlerMap.find(outputPort);
     if (mSinkHandlerMap.end() != handlerIt) {
       auto dataHandler = handlerIt->second;
       if (dataHandler) {
-        dataHandler(data);
+        if (message.isControl()) return common::ErrorCode::SUCCESS;
+        auto objectMetadata = message.getObjectMetadata();
+        if (objectMetadata) objectMetadata->materializeDetectionBatch();
+        dataHandler(message.takePayload());
         return common::ErrorCode::SUCCESS;
       }
     }
   }
-  while (mOutputConnectorMap[outputPort].lock()->pushData(dataPipeId, data) !=
-         common::ErrorCode::SUCCESS && mThreadStatus != ThreadStatus::STOP) {
+  while (mOutputConnectorMap[outputPort].lock()->pushData(
+             dataPipeId, std::move(message)) != common::ErrorCode::SUCCESS &&
+         mThreadStatus != ThreadStatus::STOP) {
     listenThreadPtr->report_status(common::ErrorCode::DATA_PIPE_FULL);
     IVS_DEBUG(
         "DataPipe is full, now sleeping. ElementID is {0}, outputPort is {1}, "
         "dataPipeId is {2}",
         mId, outputPort, dataPipeId);
+    parkIfQuiescing();
     std::this_thread::sleep_for(std::chrono::milliseconds(5));
   }
   return common::ErrorCode::SUCCESS;
@@ -244,6 +451,42 @@ common::ErrorCode Element::pushOutputData(int outputPort, int dataPipeId,
   return common::ErrorCode::NO_SUCH_WORKER_PORT;
 }
 
+void Element::forwardControlMessage(const Message& message) {
+  {
+    std::lock_guard<std::mutex> lock(mControlMutex);
+    if (!mForwardedControls.insert(message.header().mSequence).second) return;
+    // 控制消息很少，只保留最近的序号
+    if (mForwardedControls.size() > 64)
+      mForwardedControls.erase(mForwardedControls.begin());
+  }
+
+  const auto& header = message.header();
+  for (auto& it : mOutputConnectorMap) {
+    auto outputConnector = it.second.lock();
+    if (!outputConnector) continue;
+    if (MessageKind::EOS == header.mKind && header.mChannelId >= 0) {
+      int dataPipeId = getOutputDataPipeId(it.first, header.mChannelId, true);
+      pushOutputMessage(it.first, dataPipeId, Message(message));
+      continue;
+    }
+    for (int i = 0; i < outputConnector->getCapacity(); ++i)
+      pushOutputMessage(it.first, i, Message(message));
+  }
+}
+
+std::shared_ptr<framework::Connector> Element::makeInputConnector() {
+  auto connector = std::make_shared<framework::Connector>(mThreadNumber);
+  connector->setRouting(mRoutingStrategy, isChannelStateful(),
+                        mChannelAffinity);
+  return connector;
+}
+
+int Element::getOutputDataPipeId(int outputPort, int channelIdInternal,
+                                 bool endOfStream) {
+  return mOutputConnectorMap[outputPort].lock()->route(channelIdInternal,
+                                                       endOfStream);
+}
+
 int Element::getOutputConnectorCapacity(int outputPort) {
   return mOutputConnectorMap[outputPort].lock()->getCapacity();
 }
@@ -252,6 +495,128 @@ int Element::getInputConnectorCapacity(int inputPort) {
   return mInputConnectorMap[inputPort]->getCapacity();
 }
 
+float Element::getOutputDataPipeOccupancy(int outputPort, int dataPipeId) {
+  auto outputConnector = mOutputConnectorMap[outputPort].lock();
+  if (!outputConnector) return 0.f;
+  auto dataPipe = outputConnector->getDataPipe(dataPipeId);
+  if (!dataPipe || dataPipe->getCapacity() <= 0) return 0.f;
+  return static_cast<float>(dataPipe->getSize()) / dataPipe->getCapacity();
+}
+
+common::ErrorCode Element::checkConfigure(const nlohmann::json& patch,
+                                          bool stage) {
+  if (!patch.is_object()) return common::ErrorCode::PARSE_CONFIGURE_FAIL;
+  auto hotKeys = getHotConfigureKeys();
+  nlohmann::json hotConfigure = nlohmann::json::object();
+  for (auto& it : patch.items()) {
+    if (hotKeys.count(it.key())) {
+      hotConfigure[it.key()] = it.value();
+    } else if (!stage) {
+      IVS_ERROR(
+          "Configure {0} of element {1} can not be hot applied, restart is "
+          "needed",
+          it.key(), mId);
+      return common::ErrorCode::CONFIGURE_NEED_RESTART;
+    }
+  }
+  if (hotConfigure.empty() || !isInitialized())
+    return common::ErrorCode::SUCCESS;
+  return applyConfigure(hotConfigure, true);
+}
+
+common::ErrorCode Element::commitConfigure(const nlohmann::json& patch) {
+  auto hotKeys = getHotConfigureKeys();
+  nlohmann::json hotConfigure = nlohmann::json::object();
+  std::lock_guard<std::mutex> lock(mConfigureMutex);
+  for (auto& it : patch.items()) {
+    if (hotKeys.count(it.key()))
+      hotConfigure[it.key()] = it.value();
+    else
+      mStagedConfigure[it.key()] = it.value();
+  }
+  if (hotConfigure.empty()) return common::ErrorCode::SUCCESS;
+
+  // 尚未加载模型时只更新configure，延迟初始化时直接使用
+  common::ErrorCode errorCode = isInitialized()
+                                    ? applyConfigure(hotConfigure, false)
+                                    : common::ErrorCode::SUCCESS;
+  if (common::ErrorCode::SUCCESS == errorCode) {
+    for (auto& it : hotConfigure.items()) mConfigure[it.key()] = it.value();
+    IVS_INFO("Element {0} reconfigured: {1}", mId, hotConfigure.dump());
+  }
+  return errorCode;
+}
+
+nlohmann::json Element::snapshotConfigure(const nlohmann::json& patch) const {
+  auto hotKeys = getHotConfigureKeys();
+  nlohmann::json hotConfigure = nlohmann::json::object();
+  std::lock_guard<std::mutex> lock(mConfigureMutex);
+  for (auto& it : patch.items()) {
+    auto configureIt = mConfigure.find(it.key());
+    if (hotKeys.count(it.key()) && mConfigure.end() != configureIt)
+      hotConfigure[it.key()] = *configureIt;
+  }
+  return nlohmann::json{{"configure", hotConfigure},
+                        {"staged", mStagedConfigure}};
+}
+
+void Element::rollbackConfigure(const nlohmann::json& snapshot) {
+  std::lock_guard<std::mutex> lock(mConfigureMutex);
+  mStagedConfigure = snapshot.at("staged");
+  const auto& hotConfigure = snapshot.at("configure");
+  if (hotConfigure.empty()) return;
+  // 旧值此前已经生效过，重新应用不会失败
+  if (isInitialized() &&
+      common::ErrorCode::SUCCESS != applyConfigure(hotConfigure, false))
+    IVS_ERROR("Element {0} rollback configure fail: {1}", mId,
+              hotConfigure.dump());
+  for (auto& it : hotConfigure.items()) mConfigure[it.key()] = it.value();
+  IVS_INFO("Element {0} configure rolled back: {1}", mId, hotConfigure.dump());
+}
+
+nlohmann::json Element::getConfigure(bool withStaged) const {
+  std::lock_guard<std::mutex> lock(mConfigureMutex);
+  nlohmann::json configure = mConfigure;
+  if (withStaged)
+    for (auto& it : mStagedConfigure.items()) configure[it.key()] = it.value();
+  return configure;
+}
+
+nlohmann::json Element::getStagedConfigure() const {
+  std::lock_guard<std::mutex> lock(mConfigureMutex);
+  return mStagedConfigure;
+}
+
+void Element::requestQuiesce() {
+  std::lock_guard<std::mutex> lock(mQuiesceMutex);
+  mQuiesceRequested = true;
+}
+
+bool Element::waitQuiesced(std::chrono::steady_clock::time_point deadline) {
+  std::unique_lock<std::mutex> lock(mQuiesceMutex);
+  return mQuiesceCv.wait_until(lock, deadline, [this]() {
+    return ThreadStatus::RUN != mThreadStatus ||
+           mParkedThreads >= static_cast<int>(mThreads.size());
+  });
+}
+
+void Element::releaseQuiesce() {
+  std::lock_guard<std::mutex> lock(mQuiesceMutex);
+  mQuiesceRequested = false;
+  mQuiesceCv.notify_all();
+}
+
+void Element::parkIfQuiescing() {
+  if (!mQuiesceRequested) return;
+  std::unique_lock<std::mutex> lock(mQuiesceMutex);
+  ++mParkedThreads;
+  mQuiesceCv.notify_all();
+  mQuiesceCv.wait(lock, [this]() {
+    return !mQuiesceRequested || ThreadStatus::STOP == mThreadStatus;
+  });
+  --mParkedThreads;
+}
+
 void Element::addInputPort(int port) { mInputPorts.push_back(port); }
 void Element::addOutputPort(int port) { mOutputPorts.push_back(port); }
 
@@ -23,6 +23,7 @@ namespace framework {
 
 common::ErrorCode ElementFactory::addElementMaker(
     const std::string& elementName, ElementMaker elementMaker) {
+  std::lock_guard<std::mutex> lock(mElementMakerMutex);
   auto elementMakerIt = mElementMakerMap.find(elementName);
   std::cout << "current element added:" << elementName << std::endl;
   if (mElementMakerMap.end() != elementMakerIt) {
@@ -37,9 +38,15 @@ common::ErrorCode ElementFactory::addElementMaker(
 
 std::shared_ptr<framework::Element> ElementFactory::make(
     const std::string& elementName) {
-  auto elementMakerIt = mElementMakerMap.find(elementName);
-  if (mElementMakerMap.end() != elementMakerIt && elementMakerIt->second) {
-    return elementMakerIt->second();
+  ElementMaker elementMaker;
+  {
+    std::lock_guard<std::mutex> lock(mElementMakerMutex);
+    auto elementMakerIt = mElementMakerMap.find(elementName);
+    if (mElementMakerMap.end() != elementMakerIt)
+      elementMaker = elementMakerIt->second;
+  }
+  if (elementMaker) {
+    return elementMaker();
   } else {
     IVS_ERROR("Can not find element maker, name: {0}", elementName);
     return std::shared_ptr<framework::Element>();
@@ -1,6 +1,8 @@
 
 #include "engine.h"
 
+#include <future>
+
 #include "common/logger.h"
 
 namespace sophon_stream {
@@ -93,17 +95,17 @@ common::ErrorCode Engine::addGraph(const std::string& json) {
   IVS_INFO("Add graph start, json: {0}", json);
 
   common::ErrorCode errorCode = common::ErrorCode::SUCCESS;
+  ++mPendingGraphCount;
 
   do {
-    std::lock_guard<std::mutex> lk(mGraphMapLock);
-
+    // 加载模型耗时较长，初始化期间不持有mGraphMapLock，多个graph可以同时初始化
     auto graph = std::make_shared<framework::Graph>();
     graph->setListener(listenThreadPtr);
     errorCode = graph->init(json);
     listenThreadPtr->report_status(errorCode);
     if (common::ErrorCode::SUCCESS != errorCode) {
       IVS_ERROR("Graph init fail, json: {0}", json);
-      return errorCode;
+      break;
     }
 
     errorCode = graph->start();
@@ -111,15 +113,34 @@ common::ErrorCode Engine::addGraph(const std::string& json) {
 
     if (common::ErrorCode::SUCCESS != errorCode) {
       IVS_ERROR("Graph start fail");
-      return errorCode;
+      break;
     }
 
-    mGraphMap[graph->getId()] = graph;
+    {
+      std::lock_guard<std::mutex> lk(mGraphMapLock);
+      mGraphMap[graph->getId()] = graph;
+      mGraphIds.push_back(graph->getId());
+    }
+    if (listenThreadPtr) registConfigureFunc(graph);
     IVS_INFO("Add graph finish, json: {0}", json);
-    mGraphIds.push_back(graph->getId());
 
   } while (false);
 
+  --mPendingGraphCount;
+  return errorCode;
+}
+
+common::ErrorCode Engine::addGraphs(const std::vector<std::string>& jsons) {
+  std::vector<std::future<common::ErrorCode> > results;
+  for (auto& json : jsons)
+    results.push_back(
+        std::async(std::launch::async, &Engine::addGraph, this, json));
+
+  common::ErrorCode errorCode = common::ErrorCode::SUCCESS;
+  for (auto& result : results) {
+    common::ErrorCode ret = result.get();
+    if (common::ErrorCode::SUCCESS == errorCode) errorCode = ret;
+  }
   return errorCode;
 }
 
@@ -184,6 +205,18 @@ common::ErrorCode Engine::pushSourceData(int graphId, int elementId,
   return graph->pushSourceData(elementId, inputPort, data);
 }
 
+common::ErrorCode Engine::pushControlMessage(int graphId, int elementId,
+                                             int inputPort, MessageKind kind,
+                                             int channelId) {
+  auto graph = findGraph(graphId);
+  if (!graph) {
+    IVS_ERROR("Can not find graph, graph id: {0:d}", graphId);
+    return common::ErrorCode::NO_SUCH_GRAPH_ID;
+  }
+
+  return graph->pushControlMessage(elementId, inputPort, kind, channelId);
+}
+
 std::pair<std::string, int> Engine::getSideAndDeviceId(int graphId,
                                                        int elementId) {
   IVS_INFO("Get side and device id, graph id: {0:d}, element id: {1:d}",
@@ -204,7 +237,165 @@ std::pair<std::string, int> Engine::getSideAndDeviceId(int graphId,
   return graph->getSideAndDeviceId(elementId);
 }
 
-std::vector<int> Engine::getGraphIds() { return mGraphIds; }
+std::vector<int> Engine::getGraphIds() {
+  std::lock_guard<std::mutex> lk(mGraphMapLock);
+  return mGraphIds;
+}
+
+nlohmann::json Engine::getHealth() {
+  std::vector<std::shared_ptr<framework::Graph> > graphs;
+  {
+    std::lock_guard<std::mutex> lk(mGraphMapLock);
+    for (auto& it : mGraphMap) graphs.push_back(it.second);
+  }
+
+  int pendingGraphCount = mPendingGraphCount;
+  bool ready = 0 == pendingGraphCount;
+  nlohmann::json graphsHealth = nlohmann::json::array();
+  for (auto& graph : graphs) {
+    if (!graph) continue;
+    ready = graph->isReady() && ready;
+    graphsHealth.push_back(graph->getHealth());
+  }
+  return nlohmann::json{{"ready", ready},
+                        {"pending_graphs", pendingGraphCount},
+                        {"graphs", graphsHealth}};
+}
+
+bool Engine::isReady() { return getHealth()["ready"].get<bool>(); }
+
+void Engine::setListener(ListenThread* p) {
+  listenThreadPtr = p;
+  if (listenThreadPtr) registHealthFunc();
+}
+
+void Engine::registHealthFunc() {
+  listenThreadPtr->setHandler(
+      engineNameHealth, RequestType::GET,
+      [this](const httplib::Request& request, httplib::Response& response) {
+        nlohmann::json json_res = getHealth();
+        response.set_content(json_res.dump(), "application/json");
+      });
+  // 未就绪时返回503，可以直接作为负载均衡和容器编排的就绪探针
+  listenThreadPtr->setHandler(
+      engineNameReady, RequestType::GET,
+      [this](const httplib::Request& request, httplib::Response& response) {
+        common::ErrorCode errorCode = isReady()
+                                          ? common::ErrorCode::SUCCESS
+                                          : common::ErrorCode::GRAPH_NOT_READY;
+        common::Response resp;
+        resp.code = static_cast<int>(errorCode);
+        resp.msg = common::ErrorCodeToString(errorCode);
+        nlohmann::json json_res = resp;
+        response.status = common::ErrorCode::SUCCESS == errorCode ? 200 : 503;
+        response.set_content(json_res.dump(), "application/json");
+      });
+}
+
+std::shared_ptr<framework::Graph> Engine::findGraph(int graphId) {
+  std::lock_guard<std::mutex> lk(mGraphMapLock);
+  auto graphIt = mGraphMap.find(graphId);
+  if (mGraphMap.end() == graphIt) {
+    IVS_ERROR("Can not find graph, graph id: {0:d}", graphId);
+    return nullptr;
+  }
+  return graphIt->second;
+}
+
+common::ErrorCode Engine::reconfigure(int graphId,
+                                      const nlohmann::json& patch) {
+  // 不持有mGraphMapLock，避免等待element停下时阻塞其它graph操作
+  auto graph = findGraph(graphId);
+  if (!graph) return common::ErrorCode::NO_SUCH_GRAPH_ID;
+  return graph->reconfigure(patch);
+}
+
+common::ErrorCode Engine::saveSnapshot(int graphId) {
+  auto graph = findGraph(graphId);
+  if (!graph) return common::ErrorCode::NO_SUCH_GRAPH_ID;
+  return graph->saveSnapshot();
+}
+
+nlohmann::json Engine::getConfigure(int graphId, bool withStaged) {
+  auto graph = findGraph(graphId);
+  if (!graph) return nullptr;
+  return graph->getConfigure(withStaged);
+}
+
+void Engine::registConfigureFunc(
+    const std::shared_ptr<framework::Graph>& graph) {
+  int graphId = graph->getId();
+  // handler中通过graphId查找graph，graph被移除后返回错误而不是访问失效的指针
+  auto replyErrorCode = [](httplib::Response& response,
+                           common::ErrorCode errorCode) {
+    common::Response resp;
+    resp.code = static_cast<int>(errorCode);
+    resp.msg = common::ErrorCodeToString(errorCode);
+    nlohmann::json json_res = resp;
+    response.set_content(json_res.dump(), "application/json");
+  };
+
+  std::string handlerName = std::string(graphNameConfigure) + "/" +
+                            std::to_string(graphId);
+  listenThreadPtr->setHandler(
+      handlerName, RequestType::GET,
+      [this, graphId](const httplib::Request& request,
+                      httplib::Response& response) {
+        nlohmann::json json_res = getConfigure(graphId, true);
+        response.set_content(json_res.dump(), "application/json");
+      });
+  listenThreadPtr->setHandler(
+      handlerName, RequestType::POST,
+      [this, graphId, replyErrorCode](const httplib::Request& request,
+                                      httplib::Response& response) {
+        auto patch = nlohmann::json::parse(request.body, nullptr, false);
+        replyErrorCode(response, patch.is_object()
+                                     ? reconfigure(graphId, patch)
+                                     : common::ErrorCode::PARSE_CONFIGURE_FAIL);
+      });
+  listenThreadPtr->setHandler(
+      std::string(graphNameSnapshot) + "/" + std::to_string(graphId),
+      RequestType::POST,
+      [this, graphId, replyErrorCode](const httplib::Request& request,
+                                      httplib::Response& response) {
+        replyErrorCode(response, saveSnapshot(graphId));
+      });
+
+  for (int elementId : graph->getElementIds()) {
+    handlerName = std::string(elementNameConfigure) + "/" +
+                  std::to_string(elementId);
+    listenThreadPtr->setHandler(
+        handlerName, RequestType::GET,
+        [this, graphId, elementId](const httplib::Request& request,
+                                   httplib::Response& response) {
+          auto graph = findGraph(graphId);
+          nlohmann::json json_res =
+              graph ? graph->getElementConfigure(elementId) : nullptr;
+          response.set_content(json_res.dump(), "application/json");
+        });
+    // 请求体为{"configure": {...}, "stage": false}
+    listenThreadPtr->setHandler(
+        handlerName, RequestType::POST,
+        [this, graphId, elementId, replyErrorCode](
+            const httplib::Request& request, httplib::Response& response) {
+          auto body = nlohmann::json::parse(request.body, nullptr, false);
+          if (!body.is_object() ||
+              !body.contains(Graph::JSON_ELEMENT_CONFIGURE_FIELD)) {
+            replyErrorCode(response, common::ErrorCode::PARSE_CONFIGURE_FAIL);
+            return;
+          }
+          nlohmann::json elementPatch{
+              {Graph::JSON_ELEMENT_ID_FIELD, elementId},
+              {Graph::JSON_ELEMENT_CONFIGURE_FIELD,
+               body[Graph::JSON_ELEMENT_CONFIGURE_FIELD]}};
+          nlohmann::json patch{
+              {Graph::JSON_WORKERS_FIELD, nlohmann::json::array({elementPatch})},
+              {Graph::JSON_RECONFIGURE_STAGE_FIELD,
+               body.value(Graph::JSON_RECONFIGURE_STAGE_FIELD, false)}};
+          replyErrorCode(response, reconfigure(graphId, patch));
+        });
+  }
+}
 
 }  // namespace framework
 }  // namespace sophon_stream
@@ -0,0 +1,74 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#include "frame_synchronizer.h"
+
+#include <chrono>
+
+#include "common/logger.h"
+
+namespace sophon_stream {
+namespace framework {
+
+common::ErrorCode FrameSynchronizerBase::parseOptions(
+    const nlohmann::json& configure, Options& options) {
+  auto keyIt = configure.find(JSON_SYNC_KEY);
+  if (configure.end() != keyIt) {
+    std::string key = keyIt->get<std::string>();
+    if (key == "TIMESTAMP") {
+      options.key = SyncKey::TIMESTAMP;
+    } else if (key == "FRAME_ID") {
+      options.key = SyncKey::FRAME_ID;
+    } else {
+      IVS_ERROR("{0} should be TIMESTAMP or FRAME_ID, got {1}", JSON_SYNC_KEY,
+                key);
+      return common::ErrorCode::PARSE_CONFIGURE_FAIL;
+    }
+  }
+  auto policyIt = configure.find(JSON_SYNC_POLICY);
+  if (configure.end() != policyIt) {
+    std::string policy = policyIt->get<std::string>();
+    if (policy == "NEAREST") {
+      options.policy = Policy::NEAREST;
+    } else if (policy == "DROP") {
+      options.policy = Policy::DROP;
+    } else {
+      IVS_ERROR("{0} should be NEAREST or DROP, got {1}", JSON_SYNC_POLICY,
+                policy);
+      return common::ErrorCode::PARSE_CONFIGURE_FAIL;
+    }
+  }
+  auto toleranceMsIt = configure.find(JSON_SYNC_TOLERANCE_MS);
+  if (configure.end() != toleranceMsIt)
+    options.toleranceMs = toleranceMsIt->get<double>();
+  auto toleranceFramesIt = configure.find(JSON_SYNC_TOLERANCE_FRAMES);
+  if (configure.end() != toleranceFramesIt)
+    options.toleranceFrames = toleranceFramesIt->get<int>();
+  auto bufferSizeIt = configure.find(JSON_SYNC_BUFFER_SIZE);
+  if (configure.end() != bufferSizeIt)
+    options.bufferSize = bufferSizeIt->get<int>();
+  auto maxWaitIt = configure.find(JSON_SYNC_MAX_WAIT_MS);
+  if (configure.end() != maxWaitIt) options.maxWaitMs = maxWaitIt->get<int>();
+
+  if (options.toleranceMs < 0 || options.toleranceFrames < 0 ||
+      options.bufferSize <= 0 || options.maxWaitMs < 0) {
+    IVS_ERROR("Invalid frame synchronizer configure: {0}", configure.dump());
+    return common::ErrorCode::PARSE_CONFIGURE_FAIL;
+  }
+  return common::ErrorCode::SUCCESS;
+}
+
+std::int64_t FrameSynchronizerBase::steadyNowUs() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+}  // namespace framework
+}  // namespace sophon_stream
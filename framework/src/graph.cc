@@ -11,9 +11,12 @@
 
 #include <dlfcn.h>
 
+#include <algorithm>
+#include <atomic>
 #include <nlohmann/json.hpp>
 #include <set>
 #include <string>
+#include <thread>
 
 #include "common/logger.h"
 #include "element_factory.h"
@@ -21,6 +24,9 @@
 namespace sophon_stream {
 namespace framework {
 
+// 等待element停在两帧之间的最长时间
+static constexpr std::chrono::milliseconds kQuiesceTimeout{3000};
+
 Graph::Graph() : mId(-1), mThreadStatus(ThreadStatus::STOP) {}
 
 Graph::~Graph() {
@@ -53,6 +59,18 @@ common::ErrorCode Graph::init(const std::string& json) {
     }
 
     mId = graphIdIt->get<int>();
+    mConfigure = configure;
+
+    mInitParallelism = std::max<int>(std::thread::hardware_concurrency(), 1);
+    auto parallelismIt = configure.find(JSON_INIT_PARALLELISM_FIELD);
+    if (configure.end() != parallelismIt &&
+        parallelismIt->is_number_integer() && parallelismIt->get<int>() > 0) {
+      mInitParallelism = parallelismIt->get<int>();
+    }
+
+    auto snapshotDirIt = configure.find(JSON_SNAPSHOT_DIR_FIELD);
+    if (configure.end() != snapshotDirIt && snapshotDirIt->is_string())
+      mSnapshotDir = snapshotDirIt->get<std::string>();
 
     auto elementsIt = configure.find(JSON_WORKERS_FIELD);
     if (configure.end() != elementsIt) {
@@ -104,6 +122,8 @@ common::ErrorCode Graph::start() {
     return common::ErrorCode::THREAD_STATUS_ERROR;
   }
 
+  if (!mSnapshotDir.empty()) loadSnapshot();
+
   for (auto pair : mElementMap) {
     auto element = pair.second;
     if (!element) {
@@ -138,6 +158,13 @@ common::ErrorCode Graph::stop() {
 
   mThreadStatus = ThreadStatus::STOP;
 
+  // 线程已经全部停止，不需要quiesce
+  if (!mSnapshotDir.empty()) {
+    std::vector<std::shared_ptr<framework::Element> > elements;
+    for (int elementId : mElementIds) elements.push_back(mElementMap[elementId]);
+    writeSnapshot(elements);
+  }
+
   IVS_INFO("Stop graph thread finish, graph id: {0:d}", mId);
   return common::ErrorCode::SUCCESS;
 }
@@ -207,7 +234,11 @@ common::ErrorCode Graph::initElements(const std::string& json) {
       break;
     }
 
+    // 1. 依次加载动态库并创建element，动态库中的element要先注册到工厂
     int numElements = elementsConfigure.size();
+    std::vector<std::shared_ptr<framework::Element> > elements;
+    std::vector<std::string> elementJsons;
+    std::vector<std::string> elementNames;
     for (int elementIndex = 0; elementIndex < numElements; elementIndex++) {
       auto& elementConfigure = elementsConfigure[elementIndex];
       std::cout << elementConfigure.dump() << "\n";
@@ -259,10 +290,39 @@ common::ErrorCode Graph::initElements(const std::string& json) {
         break;
       }
 
-      errorCode = element->init(elementConfigure.dump());
+      elements.push_back(element);
+      elementJsons.push_back(elementConfigure.dump());
+      elementNames.push_back(nameIt->get<std::string>());
+    }
+    if (common::ErrorCode::SUCCESS != errorCode) {
+      break;
+    }
+
+    // 2. element之间在连接之前没有依赖，并行加载模型和预热
+    std::vector<common::ErrorCode> errorCodes(elements.size(),
+                                              common::ErrorCode::SUCCESS);
+    std::atomic<int> nextIndex{0};
+    auto initWorker = [&]() {
+      for (int i = nextIndex++; i < static_cast<int>(elements.size());
+           i = nextIndex++) {
+        errorCodes[i] = elements[i]->init(elementJsons[i]);
+        if (common::ErrorCode::SUCCESS == errorCodes[i])
+          errorCodes[i] = elements[i]->prepare();
+      }
+    };
+    int parallelism = std::min<int>(mInitParallelism, elements.size());
+    std::vector<std::thread> initThreads;
+    for (int i = 1; i < parallelism; ++i) initThreads.emplace_back(initWorker);
+    initWorker();
+    for (auto& thread : initThreads) thread.join();
+
+    // 3. 按配置顺序注册，保证elementMap和http接口与串行初始化时一致
+    for (std::size_t i = 0; i < elements.size(); ++i) {
+      auto& element = elements[i];
+      errorCode = errorCodes[i];
       if (common::ErrorCode::SUCCESS != errorCode) {
-        IVS_ERROR("Init element fail, graph id: {0:d}, name: {1}", mId,
-                  nameIt->get<std::string>());
+        IVS_ERROR("Init element fail, graph id: {0:d}, json: {1}", mId,
+                  elementJsons[i]);
         break;
       }
 
@@ -282,6 +342,8 @@ common::ErrorCode Graph::initElements(const std::string& json) {
       }
 
       mElementMap[element->getId()] = element;
+      mElementIds.push_back(element->getId());
+      mElementNames[element->getId()] = elementNames[i];
     }
     if (common::ErrorCode::SUCCESS != errorCode) {
       break;
@@ -465,6 +527,23 @@ common::ErrorCode Graph::pushSourceData(int elementId, int inputPort,
   return element->pushInputData(inputPort, 0, data);
 }
 
+common::ErrorCode Graph::pushControlMessage(int elementId, int inputPort,
+                                            MessageKind kind, int channelId) {
+  IVS_INFO(
+      "Send control message, graph id: {0:d}, element id: {1:d}, input port: "
+      "{2:d}, kind: {3:d}, channel: {4:d}",
+      mId, elementId, inputPort, static_cast<int>(kind), channelId);
+
+  auto elementIt = mElementMap.find(elementId);
+  if (mElementMap.end() == elementIt || !elementIt->second) {
+    IVS_ERROR("Can not find element, graph id: {0:d}, element id: {1:d}", mId,
+              elementId);
+    return common::ErrorCode::NO_SUCH_WORKER_ID;
+  }
+
+  return elementIt->second->pushControlMessage(inputPort, kind, channelId);
+}
+
 std::pair<std::string, int> Graph::getSideAndDeviceId(int elementId) {
   IVS_INFO("Get side and device id, graph id: {0:d}, element id: {1:d}", mId,
            elementId);
@@ -487,5 +566,226 @@ std::pair<std::string, int> Graph::getSideAndDeviceId(int elementId) {
 }
 
 int Graph::getId() const { return mId; }
+
+common::ErrorCode Graph::reconfigure(const nlohmann::json& patch) {
+  IVS_INFO("Reconfigure start, graph id: {0:d}, patch: {1}", mId,
+           patch.dump());
+  std::lock_guard<std::mutex> lock(mReconfigureMutex);
+
+  auto elementsIt = patch.find(JSON_WORKERS_FIELD);
+  if (!patch.is_object() || patch.end() == elementsIt ||
+      !elementsIt->is_array()) {
+    IVS_ERROR("Can not find {0} with array type in patch, graph id: {1:d}",
+              JSON_WORKERS_FIELD, mId);
+    return common::ErrorCode::PARSE_CONFIGURE_FAIL;
+  }
+  bool stage = false;
+  auto stageIt = patch.find(JSON_RECONFIGURE_STAGE_FIELD);
+  if (patch.end() != stageIt && stageIt->is_boolean())
+    stage = stageIt->get<bool>();
+
+  // 1. 检查所有element，任一失败则整体拒绝
+  std::vector<std::pair<std::shared_ptr<Element>, nlohmann::json> > targets;
+  for (auto& elementPatch : *elementsIt) {
+    auto idIt = elementPatch.find(JSON_ELEMENT_ID_FIELD);
+    auto configureIt = elementPatch.find(JSON_ELEMENT_CONFIGURE_FIELD);
+    if (elementPatch.end() == idIt || !idIt->is_number_integer() ||
+        elementPatch.end() == configureIt) {
+      IVS_ERROR("Invalid element patch, graph id: {0:d}, json: {1}", mId,
+                elementPatch.dump());
+      return common::ErrorCode::PARSE_CONFIGURE_FAIL;
+    }
+    auto elementIt = mElementMap.find(idIt->get<int>());
+    if (mElementMap.end() == elementIt || !elementIt->second) {
+      IVS_ERROR("Can not find element, graph id: {0:d}, element id: {1:d}",
+                mId, idIt->get<int>());
+      return common::ErrorCode::NO_SUCH_WORKER_ID;
+    }
+    common::ErrorCode errorCode =
+        elementIt->second->checkConfigure(*configureIt, stage);
+    if (common::ErrorCode::SUCCESS != errorCode) {
+      IVS_ERROR("Reconfigure rejected, graph id: {0:d}, element id: {1:d}",
+                mId, idIt->get<int>());
+      return errorCode;
+    }
+    targets.emplace_back(elementIt->second, *configureIt);
+  }
+
+  // 2. 所有element同时停在两帧之间
+  for (auto& target : targets) target.first->requestQuiesce();
+  auto deadline = std::chrono::steady_clock::now() + kQuiesceTimeout;
+  bool quiesced = true;
+  for (auto& target : targets)
+    quiesced = target.first->waitQuiesced(deadline) && quiesced;
+
+  // 3. 一起生效，任一element失败则把已经生效的element恢复原配置
+  common::ErrorCode errorCode = common::ErrorCode::SUCCESS;
+  if (!quiesced) {
+    IVS_ERROR("Wait elements quiesced timeout, graph id: {0:d}", mId);
+    errorCode = common::ErrorCode::TIMEOUT;
+  } else {
+    std::vector<nlohmann::json> snapshots;
+    snapshots.reserve(targets.size());
+    for (auto& target : targets)
+      snapshots.push_back(target.first->snapshotConfigure(target.second));
+    std::size_t committed = 0;
+    for (; committed < targets.size(); ++committed) {
+      auto& target = targets[committed];
+      errorCode = target.first->commitConfigure(target.second);
+      if (common::ErrorCode::SUCCESS != errorCode) break;
+    }
+    if (common::ErrorCode::SUCCESS != errorCode) {
+      IVS_ERROR(
+          "Commit configure fail, graph id: {0:d}, element id: {1:d}, roll "
+          "back",
+          mId, targets[committed].first->getId());
+      // 失败的element可能已经暂存了部分字段，也一并恢复
+      for (std::size_t i = 0; i <= committed; ++i)
+        targets[i].first->rollbackConfigure(snapshots[i]);
+    }
+  }
+  for (auto& target : targets) target.first->releaseQuiesce();
+
+  IVS_INFO("Reconfigure finish, graph id: {0:d}, result: {1}", mId,
+           static_cast<int>(errorCode));
+  return errorCode;
+}
+
+nlohmann::json Graph::getConfigure(bool withStaged) {
+  nlohmann::json configure = mConfigure;
+  auto elementsIt = configure.find(JSON_WORKERS_FIELD);
+  if (configure.end() == elementsIt || !elementsIt->is_array())
+    return configure;
+  for (auto& elementConfigure : *elementsIt) {
+    auto idIt = elementConfigure.find(JSON_ELEMENT_ID_FIELD);
+    if (elementConfigure.end() == idIt || !idIt->is_number_integer()) continue;
+    auto elementIt = mElementMap.find(idIt->get<int>());
+    if (mElementMap.end() == elementIt || !elementIt->second) continue;
+    elementConfigure[JSON_ELEMENT_CONFIGURE_FIELD] =
+        elementIt->second->getConfigure(withStaged);
+  }
+  return configure;
+}
+
+nlohmann::json Graph::getElementConfigure(int elementId) {
+  auto elementIt = mElementMap.find(elementId);
+  if (mElementMap.end() == elementIt || !elementIt->second) return nullptr;
+  auto element = elementIt->second;
+  return nlohmann::json{{"configure", element->getConfigure(false)},
+                        {"hot_keys", element->getHotConfigureKeys()},
+                        {"staged", element->getStagedConfigure()}};
+}
+
+bool Graph::isReady() {
+  if (ThreadStatus::RUN != mThreadStatus) return false;
+  for (int elementId : mElementIds) {
+    auto status = mElementMap[elementId]->getInitStatus();
+    // lazy_init的element在第一个通道到达时才加载，不影响graph接收通道
+    if (Element::InitStatus::READY != status &&
+        Element::InitStatus::LAZY != status)
+      return false;
+  }
+  return true;
+}
+
+nlohmann::json Graph::getHealth() {
+  nlohmann::json elements = nlohmann::json::array();
+  for (int elementId : mElementIds) {
+    auto element = mElementMap[elementId];
+    elements.push_back(
+        {{JSON_ELEMENT_ID_FIELD, elementId},
+         {"status", Element::initStatusToString(element->getInitStatus())},
+         {"init_ms", element->getInitCostMs()},
+         {"warmup_ms", element->getWarmupCostMs()}});
+  }
+  return nlohmann::json{{JSON_GRAPH_ID_FIELD, mId},
+                        {"ready", isReady()},
+                        {"elements", elements}};
+}
+
+std::string Graph::getSnapshotPath(int elementId) const {
+  return mSnapshotDir + "/graph_" + std::to_string(mId) + "_element_" +
+         std::to_string(elementId) + ".state";
+}
+
+common::ErrorCode Graph::writeSnapshot(
+    const std::vector<std::shared_ptr<framework::Element> >& elements) {
+  common::ErrorCode errorCode = common::ErrorCode::SUCCESS;
+  for (auto& element : elements) {
+    std::uint32_t stateVersion = element->getStateVersion();
+    if (0 == stateVersion) continue;
+    common::StateWriter writer;
+    common::ErrorCode ret = element->saveState(writer);
+    if (common::ErrorCode::SUCCESS == ret &&
+        !writer.save(getSnapshotPath(element->getId()),
+                     mElementNames[element->getId()], stateVersion))
+      ret = common::ErrorCode::SNAPSHOT_FAIL;
+    if (common::ErrorCode::SUCCESS != ret) {
+      IVS_ERROR("Save snapshot fail, graph id: {0:d}, element id: {1:d}", mId,
+                element->getId());
+      errorCode = ret;
+      continue;
+    }
+    IVS_INFO("Save snapshot, graph id: {0:d}, element id: {1:d}, path: {2}",
+             mId, element->getId(), getSnapshotPath(element->getId()));
+  }
+  return errorCode;
+}
+
+void Graph::loadSnapshot() {
+  for (int elementId : mElementIds) {
+    auto element = mElementMap[elementId];
+    if (0 == element->getStateVersion()) continue;
+    std::string path = getSnapshotPath(elementId);
+    common::StateReader reader;
+    // 快照不存在时正常启动，校验失败或者版本不兼容时丢弃快照
+    if (!reader.load(path, mElementNames[elementId])) {
+      IVS_INFO("No valid snapshot, graph id: {0:d}, element id: {1:d}", mId,
+               elementId);
+      continue;
+    }
+    if (reader.stateVersion() > element->getStateVersion() ||
+        common::ErrorCode::SUCCESS != element->loadState(reader)) {
+      IVS_WARN(
+          "Discard snapshot, graph id: {0:d}, element id: {1:d}, snapshot "
+          "version: {2}, element version: {3}",
+          mId, elementId, reader.stateVersion(), element->getStateVersion());
+      continue;
+    }
+    IVS_INFO("Restore snapshot, graph id: {0:d}, element id: {1:d}", mId,
+             elementId);
+  }
+}
+
+common::ErrorCode Graph::saveSnapshot() {
+  if (mSnapshotDir.empty()) {
+    IVS_ERROR("No {0} in graph configure, graph id: {1:d}",
+              JSON_SNAPSHOT_DIR_FIELD, mId);
+    return common::ErrorCode::PARAMETER_ERROR;
+  }
+  std::lock_guard<std::mutex> lock(mReconfigureMutex);
+
+  std::vector<std::shared_ptr<framework::Element> > elements;
+  for (int elementId : mElementIds) {
+    if (mElementMap[elementId]->getStateVersion() > 0)
+      elements.push_back(mElementMap[elementId]);
+  }
+  if (ThreadStatus::STOP == mThreadStatus) return writeSnapshot(elements);
+
+  for (auto& element : elements) element->requestQuiesce();
+  auto deadline = std::chrono::steady_clock::now() + kQuiesceTimeout;
+  bool quiesced = true;
+  for (auto& element : elements)
+    quiesced = element->waitQuiesced(deadline) && quiesced;
+
+  common::ErrorCode errorCode = common::ErrorCode::TIMEOUT;
+  if (quiesced)
+    errorCode = writeSnapshot(elements);
+  else
+    IVS_ERROR("Wait elements quiesced timeout, graph id: {0:d}", mId);
+  for (auto& element : elements) element->releaseQuiesce();
+  return errorCode;
+}
+
 }  // namespace framework
 }  // namespace sophon_stream
@@ -146,6 +146,7 @@ void ListenThread::stop() {
 
 void ListenThread::setHandler(const std::string& path, RequestType type,
                               httplib::Server::Handler handler) {
+  std::lock_guard<std::mutex> lock(handlerMutex);
   switch (type) {
     case RequestType::GET:
       server.Get(path, handler);
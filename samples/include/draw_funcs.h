@@ -829,8 +829,9 @@ void draw_yolov8_seg(
     cv::Rect bound = {obj->mBox.mX, obj->mBox.mY, obj->mBox.mWidth,
                       obj->mBox.mHeight};
     cv::rectangle(res, bound, color, 2);
-    if (obj->mask_img.rows && obj->mask_img.cols > 0) {
-      mask(bound).setTo(color, obj->mask_img);
+    cv::Mat mask_img = obj->maskImage();
+    if (mask_img.rows && mask_img.cols > 0) {
+      mask(bound).setTo(color, mask_img);
     }
     std::string label = std::string(class_names[obj->mClassify]) +
                         std::to_string(obj->mScores[0]);
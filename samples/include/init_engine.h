@@ -31,6 +31,7 @@ constexpr const char* JSON_CONFIG_SRC_PORT_FILED = "src_port";
 constexpr const char* JSON_CONFIG_DST_ID_FILED = "dst_element_id";
 constexpr const char* JSON_CONFIG_DST_PORT_FILED = "dst_port";
 constexpr const char* JSON_CONFIG_INNER_ELEMENTS_ID = "inner_elements_id";
+constexpr const char* JSON_CONFIG_INIT_PARALLELISM_FILED = "init_parallelism";
 
 void parse_element_json(
     const nlohmann::detail::iter_impl<nlohmann::json> elements_it,
@@ -117,6 +118,9 @@ void init_engine(
     sophon_stream::framework::Engine& engine, nlohmann::json& engine_json,
     const sophon_stream::framework::Engine::SinkHandler& sinkHandler,
     std::map<int, std::vector<std::pair<int, int>>>& graph_src_id_port_map) {
+  // 先解析所有graph，再并行初始化
+  std::vector<std::string> graphConfigures;
+  std::map<int, std::vector<std::pair<int, int>>> graph_sink_id_port_map;
   for (auto& graph_it : engine_json) {
     nlohmann::json graphConfigure, elementsConfigure;
     std::vector<std::pair<int, int>> src_id_port;   // src_port
@@ -124,6 +128,9 @@ void init_engine(
 
     int graph_id = graph_it.find(JSON_CONFIG_GRAPH_ID_FILED)->get<int>();
     graphConfigure["graph_id"] = graph_id;
+    auto parallelism_it = graph_it.find(JSON_CONFIG_INIT_PARALLELISM_FILED);
+    if (parallelism_it != graph_it.end())
+      graphConfigure["init_parallelism"] = parallelism_it->get<int>();
     int device_id = graph_it.find(JSON_CONFIG_DEVICE_ID_FILED)->get<int>();
     auto elements_it = graph_it.find(JSON_CONFIG_ELEMENTS_FILED);
     parse_element_json(elements_it, elementsConfigure, device_id, src_id_port,
@@ -132,11 +139,16 @@ void init_engine(
     auto connect_it = graph_it.find(JSON_CONFIG_CONNECTION_FILED);
     parse_connection_json(connect_it, graphConfigure);
 
-    engine.addGraph(graphConfigure.dump());
-    for (auto& sink_id_port_obj : sink_id_port) {
-      engine.setSinkHandler(graph_id, sink_id_port_obj.first,
+    graphConfigures.push_back(graphConfigure.dump());
+    graph_src_id_port_map[graph_id] = src_id_port;
+    graph_sink_id_port_map[graph_id] = sink_id_port;
+  }
+
+  engine.addGraphs(graphConfigures);
+  for (auto& graph_sink : graph_sink_id_port_map) {
+    for (auto& sink_id_port_obj : graph_sink.second) {
+      engine.setSinkHandler(graph_sink.first, sink_id_port_obj.first,
                             sink_id_port_obj.second, sinkHandler);
     }
-    graph_src_id_port_map[graph_id] = src_id_port;
   }
 }
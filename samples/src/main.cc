@@ -45,6 +45,19 @@ constexpr const char* JSON_CONFIG_CHANNEL_CONFIG_SKIP_ELEMENT_FILED =
 constexpr const char* JSON_CONFIG_CHANNEL_CONFIG_SAMPLE_STRATEGY_FILED =
     "sample_strategy";
 constexpr const char* JSON_CONFIG_CHANNEL_CONFIG_ROI_FILED = "roi";
+constexpr const char* JSON_CONFIG_CHANNEL_CONFIG_PRIORITY_FILED = "priority";
+constexpr const char* JSON_CONFIG_CHANNEL_CONFIG_TARGET_FPS_FILED =
+    "target_fps";
+constexpr const char* JSON_CONFIG_CHANNEL_CONFIG_DECODE_MODE_FILED =
+    "decode_mode";
+constexpr const char* JSON_CONFIG_CHANNEL_CONFIG_SAMPLE_PERIOD_MS_FILED =
+    "sample_period_ms";
+constexpr const char* JSON_CONFIG_CHANNEL_CONFIG_OUTPUT_WIDTH_FILED =
+    "output_width";
+constexpr const char* JSON_CONFIG_CHANNEL_CONFIG_OUTPUT_HEIGHT_FILED =
+    "output_height";
+constexpr const char* JSON_CONFIG_CHANNEL_CONFIG_IMAGE_PREFETCH_FILED =
+    "image_prefetch";
 
 constexpr const char* JSON_CONFIG_DRAW_FUNC_NAME_FILED = "draw_func_name";
 constexpr const char* JSON_CONFIG_CAR_ATTRIBUTES_FILED = "car_attributes";
@@ -201,6 +214,41 @@ demo_config parse_demo_json(std::string& json_path) {
     if (channel_it.end() != sample_strategy_it)
       channel_json["sample_strategy"] = sample_strategy_it->get<std::string>();
 
+    auto priority_it =
+        channel_it.find(JSON_CONFIG_CHANNEL_CONFIG_PRIORITY_FILED);
+    if (channel_it.end() != priority_it)
+      channel_json["priority"] = priority_it->get<int>();
+
+    auto target_fps_it =
+        channel_it.find(JSON_CONFIG_CHANNEL_CONFIG_TARGET_FPS_FILED);
+    if (channel_it.end() != target_fps_it)
+      channel_json["target_fps"] = target_fps_it->get<double>();
+
+    auto decode_mode_it =
+        channel_it.find(JSON_CONFIG_CHANNEL_CONFIG_DECODE_MODE_FILED);
+    if (channel_it.end() != decode_mode_it)
+      channel_json["decode_mode"] = decode_mode_it->get<std::string>();
+
+    auto sample_period_it =
+        channel_it.find(JSON_CONFIG_CHANNEL_CONFIG_SAMPLE_PERIOD_MS_FILED);
+    if (channel_it.end() != sample_period_it)
+      channel_json["sample_period_ms"] = sample_period_it->get<double>();
+
+    auto output_width_it =
+        channel_it.find(JSON_CONFIG_CHANNEL_CONFIG_OUTPUT_WIDTH_FILED);
+    if (channel_it.end() != output_width_it)
+      channel_json["output_width"] = output_width_it->get<int>();
+
+    auto output_height_it =
+        channel_it.find(JSON_CONFIG_CHANNEL_CONFIG_OUTPUT_HEIGHT_FILED);
+    if (channel_it.end() != output_height_it)
+      channel_json["output_height"] = output_height_it->get<int>();
+
+    auto image_prefetch_it =
+        channel_it.find(JSON_CONFIG_CHANNEL_CONFIG_IMAGE_PREFETCH_FILED);
+    if (channel_it.end() != image_prefetch_it)
+      channel_json["image_prefetch"] = *image_prefetch_it;
+
     auto skip_element_it =
         channel_it.find(JSON_CONFIG_CHANNEL_CONFIG_SKIP_ELEMENT_FILED);
     if (skip_element_it != channel_it.end()) {
@@ -0,0 +1,107 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SOPHON_STREAM_TESTS_BYTETRACK_KALMAN_REFERENCE_H_
+#define SOPHON_STREAM_TESTS_BYTETRACK_KALMAN_REFERENCE_H_
+
+#include <cstddef>
+#include <vector>
+
+#include "bytetrack_strack.h"
+
+// 改为原地预测之前的按列批量预测：先把各轨迹的状态拷贝到按列存放的缓存，
+// 逐列预测后再拷回STrack，只用于对比结果和性能
+
+namespace sophon_stream {
+namespace element {
+namespace bytetrack {
+
+struct ReferenceKalmanBatch {
+  std::size_t size() const { return mean[0].size(); }
+
+  void clear() {
+    for (auto& column : mean) column.clear();
+    for (auto& column : covariance) column.clear();
+  }
+
+  void push_back(const KalmanMean& m, const KalmanCovariance& c) {
+    for (int i = 0; i < 8; ++i) mean[i].push_back(m[i]);
+    for (int i = 0; i < 12; ++i) covariance[i].push_back(c[i]);
+  }
+
+  void get(std::size_t index, KalmanMean& m, KalmanCovariance& c) const {
+    for (int i = 0; i < 8; ++i) m[i] = mean[i][index];
+    for (int i = 0; i < 12; ++i) c[i] = covariance[i][index];
+  }
+
+  std::vector<float> mean[8];
+  std::vector<float> covariance[12];
+};
+
+/**
+ * @brief 原KalmanFilter::predict(KalmanBatch&)，噪声参数与KalmanFilter相同
+ */
+inline void referenceBatchPredict(ReferenceKalmanBatch& batch) {
+  const float std_weight_position = 1. / 20;
+  const float std_weight_velocity = 1. / 160;
+  const float aspect_position_noise = 1e-4;
+  const float aspect_velocity_noise = 1e-10;
+  const std::size_t n = batch.size();
+  const float w_pos = std_weight_position * std_weight_position;
+  const float w_vel = std_weight_velocity * std_weight_velocity;
+  // 高度(第3个块)最后更新，前面的块计算噪声时读到的都是预测前的高度
+  for (int i = 0; i != 4; i++) {
+    float* x = batch.mean[i].data();
+    const float* vx = batch.mean[i + 4].data();
+    const float* h = batch.mean[3].data();
+    float* p = batch.covariance[i].data();
+    float* c = batch.covariance[4 + i].data();
+    float* v = batch.covariance[8 + i].data();
+    if (i == 2) {
+      for (std::size_t k = 0; k < n; k++) {
+        x[k] += vx[k];
+        p[k] += 2 * c[k] + v[k] + aspect_position_noise;
+        c[k] += v[k];
+        v[k] += aspect_velocity_noise;
+      }
+      continue;
+    }
+    for (std::size_t k = 0; k < n; k++) {
+      float hh = h[k] * h[k];
+      p[k] += 2 * c[k] + v[k] + w_pos * hh;
+      c[k] += v[k];
+      v[k] += w_vel * hh;
+      x[k] += vx[k];
+    }
+  }
+}
+
+/**
+ * @brief 原STrack::multi_predict：gather到batch，批量预测，再scatter回轨迹
+ */
+inline void referenceMultiPredict(const std::vector<STrack*>& stracks,
+                                  ReferenceKalmanBatch& batch) {
+  batch.clear();
+  for (auto strack : stracks) {
+    if (strack->state != TrackState::Tracked) {
+      strack->mean[7] = 0;
+    }
+    batch.push_back(strack->mean, strack->covariance);
+  }
+  referenceBatchPredict(batch);
+  for (std::size_t i = 0; i < stracks.size(); i++) {
+    batch.get(i, stracks[i]->mean, stracks[i]->covariance);
+  }
+}
+
+}  // namespace bytetrack
+}  // namespace element
+}  // namespace sophon_stream
+
+#endif  // SOPHON_STREAM_TESTS_BYTETRACK_KALMAN_REFERENCE_H_
@@ -0,0 +1,83 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "bytetrack_strack.h"
+
+namespace sophon_stream {
+namespace element {
+namespace bytetrack {
+namespace {
+
+TEST(BytetrackSTrack, SaveLoadRoundTrip) {
+  auto kalman = std::make_shared<KalmanFilter>();
+  auto strack = std::make_shared<STrack>(
+      std::vector<float>{10.f, 20.f, 30.f, 60.f}, 0.9f, 2);
+  strack->activate(kalman, 1);
+  STracks pool{strack};
+  STrack::multi_predict(pool, kalman);
+  auto detection = std::make_shared<STrack>(
+      std::vector<float>{12.f, 21.f, 30.f, 61.f}, 0.8f, 2);
+  strack->update(kalman, detection, 2, true);
+
+  std::string path = "bytetrack_strack_test.state";
+  common::StateWriter writer;
+  strack->save(writer);
+  ASSERT_TRUE(writer.save(path, "bytetrack", 1));
+  common::StateReader reader;
+  ASSERT_TRUE(reader.load(path, "bytetrack"));
+  auto loaded = STrack::load(reader);
+  std::remove(path.c_str());
+  ASSERT_NE(nullptr, loaded);
+
+  EXPECT_EQ(strack->is_activated, loaded->is_activated);
+  EXPECT_EQ(strack->track_id, loaded->track_id);
+  EXPECT_EQ(strack->state, loaded->state);
+  EXPECT_EQ(strack->_tlwh, loaded->_tlwh);
+  EXPECT_EQ(strack->tlwh, loaded->tlwh);
+  EXPECT_EQ(strack->tlbr, loaded->tlbr);
+  EXPECT_EQ(strack->frame_id, loaded->frame_id);
+  EXPECT_EQ(strack->tracklet_len, loaded->tracklet_len);
+  EXPECT_EQ(strack->start_frame, loaded->start_frame);
+  EXPECT_EQ(strack->mean, loaded->mean);
+  EXPECT_EQ(strack->covariance, loaded->covariance);
+  EXPECT_EQ(strack->score, loaded->score);
+  EXPECT_EQ(strack->class_id, loaded->class_id);
+
+  // 恢复后的轨迹与原轨迹的后续预测一致
+  STracks original{strack}, restored{loaded};
+  STrack::multi_predict(original, kalman);
+  STrack::multi_predict(restored, kalman);
+  EXPECT_EQ(strack->mean, loaded->mean);
+  EXPECT_EQ(strack->covariance, loaded->covariance);
+}
+
+TEST(BytetrackSTrack, LoadRejectsTruncatedState) {
+  std::string path = "bytetrack_strack_trunc.state";
+  // 只有is_activated和track_id
+  common::StateWriter writer;
+  writer.write(true);
+  writer.write(1);
+  ASSERT_TRUE(writer.save(path, "bytetrack", 1));
+  common::StateReader reader;
+  ASSERT_TRUE(reader.load(path, "bytetrack"));
+  EXPECT_EQ(nullptr, STrack::load(reader));
+  std::remove(path.c_str());
+}
+
+}  // namespace
+}  // namespace bytetrack
+}  // namespace element
+}  // namespace sophon_stream
@@ -0,0 +1,118 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "bytetrack_bytetracker.h"
+
+namespace sophon_stream {
+namespace element {
+namespace bytetrack {
+namespace {
+
+std::shared_ptr<BytetrackContext> makeContext() {
+  auto context = std::make_shared<BytetrackContext>();
+  context->trackThresh = 0.5f;
+  context->highThresh = 0.6f;
+  context->matchThresh = 0.7f;
+  context->frameRate = 30;
+  context->trackBuffer = 30;
+  context->minBoxArea = 10;
+  context->correctBox = true;
+  context->agnostic = false;
+  context->interpolate = false;
+  return context;
+}
+
+// 两个目标每帧向右下移动step个像素
+std::shared_ptr<common::ObjectMetadata> makeFrame(int frameId) {
+  auto objects = std::make_shared<common::ObjectMetadata>();
+  objects->mFrame = std::make_shared<common::Frame>();
+  objects->mFrame->mFrameId = frameId;
+  objects->mFrame->mSpData = std::make_shared<bm_image>();
+  objects->mFrame->mSpData->width = 1920;
+  objects->mFrame->mSpData->height = 1080;
+  const int step = 4;
+  for (int i = 0; i < 2; ++i) {
+    auto detection = std::make_shared<common::DetectedObjectMetadata>();
+    detection->mBox.mX = 100 + 400 * i + step * frameId;
+    detection->mBox.mY = 200 + step * frameId;
+    detection->mBox.mWidth = 80;
+    detection->mBox.mHeight = 160;
+    detection->mScores = {0.9f};
+    detection->mClassify = i;
+    objects->mDetectedObjectMetadatas.push_back(detection);
+  }
+  return objects;
+}
+
+TEST(BytetrackTracker, SaveLoadContinuesTracks) {
+  auto context = makeContext();
+  BYTETracker tracker(context);
+  for (int frameId = 0; frameId < 5; ++frameId) {
+    auto objects = makeFrame(frameId);
+    tracker.update(objects);
+  }
+
+  std::string path = "bytetrack_tracker_test.state";
+  common::StateWriter writer;
+  tracker.save(writer);
+  ASSERT_TRUE(writer.save(path, "bytetrack", 1));
+  common::StateReader reader;
+  ASSERT_TRUE(reader.load(path, "bytetrack"));
+  BYTETracker restored(context);
+  ASSERT_TRUE(restored.load(reader));
+  std::remove(path.c_str());
+
+  // 恢复后的tracker与原tracker对同一帧给出相同的轨迹
+  for (int frameId = 5; frameId < 8; ++frameId) {
+    auto expected = makeFrame(frameId);
+    auto actual = makeFrame(frameId);
+    tracker.update(expected);
+    restored.update(actual);
+    ASSERT_EQ(2u, expected->mTrackedObjectMetadatas.size());
+    ASSERT_EQ(expected->mTrackedObjectMetadatas.size(),
+              actual->mTrackedObjectMetadatas.size());
+    for (std::size_t i = 0; i < expected->mTrackedObjectMetadatas.size();
+         ++i) {
+      EXPECT_EQ(expected->mTrackedObjectMetadatas[i]->mTrackId,
+                actual->mTrackedObjectMetadatas[i]->mTrackId);
+      auto& expectedBox = expected->mDetectedObjectMetadatas[i]->mBox;
+      auto& actualBox = actual->mDetectedObjectMetadatas[i]->mBox;
+      EXPECT_EQ(expectedBox.mX, actualBox.mX);
+      EXPECT_EQ(expectedBox.mY, actualBox.mY);
+      EXPECT_EQ(expectedBox.mWidth, actualBox.mWidth);
+      EXPECT_EQ(expectedBox.mHeight, actualBox.mHeight);
+    }
+  }
+}
+
+TEST(BytetrackTracker, LoadRejectsTruncatedState) {
+  std::string path = "bytetrack_tracker_trunc.state";
+  // 帧号和3条跟踪中的轨迹，轨迹数据缺失
+  common::StateWriter writer;
+  writer.write(1);
+  writer.write<std::uint32_t>(3);
+  ASSERT_TRUE(writer.save(path, "bytetrack", 1));
+  common::StateReader reader;
+  ASSERT_TRUE(reader.load(path, "bytetrack"));
+  BYTETracker tracker(makeContext());
+  EXPECT_FALSE(tracker.load(reader));
+  std::remove(path.c_str());
+}
+
+}  // namespace
+}  // namespace bytetrack
+}  // namespace element
+}  // namespace sophon_stream
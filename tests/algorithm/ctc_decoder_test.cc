@@ -0,0 +1,160 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#include "algorithmApi/ctc_decoder.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "ctc_reference.h"
+
+namespace sophon_stream {
+namespace element {
+namespace {
+
+void expectSame(const ReferenceCtcResult& expected,
+                const CtcDecoder::Result& actual) {
+  EXPECT_EQ(expected.labels, actual.labels);
+  EXPECT_EQ(expected.confs, actual.confs);
+}
+
+// 每行的最大值：1 1 0 1 2 2 0，重复的1被blank隔开后保留
+const float kFixture[7][3] = {
+    {0.1f, 0.8f, 0.1f}, {0.2f, 0.7f, 0.1f}, {0.6f, 0.3f, 0.1f},
+    {0.3f, 0.5f, 0.2f}, {0.1f, 0.1f, 0.8f}, {0.3f, 0.1f, 0.6f},
+    {0.9f, 0.05f, 0.05f},
+};
+
+TEST(CtcDecoder, DecodesFixture) {
+  CtcDecoder decoder;
+  CtcDecoder::Result result;
+  decoder.configure(0, 1);
+  decoder.greedy(&kFixture[0][0], 7, 3, result);
+  EXPECT_EQ(std::vector<int>({1, 1, 2}), result.labels);
+  EXPECT_EQ(std::vector<float>({0.8f, 0.5f, 0.8f}), result.confs);
+  expectSame(referencePpocrGreedy(&kFixture[0][0], 7, 3), result);
+
+  decoder.configure(0, 2);
+  decoder.beamSearch(&kFixture[0][0], 7, 3, result);
+  EXPECT_EQ(std::vector<int>({1, 1, 2}), result.labels);
+  expectSame(referencePpocrBeamSearch(&kFixture[0][0], 7, 3, 2), result);
+
+  // 按[C][T]存放，blank为最后一个字符：0 0 2 0 1 1 2
+  float classMajor[3][7];
+  for (int t = 0; t < 7; ++t)
+    for (int c = 0; c < 3; ++c) classMajor[(c + 2) % 3][t] = kFixture[t][c];
+  decoder.configure(2, 1);
+  decoder.greedyClassMajor(&classMajor[0][0], 7, 3, result);
+  EXPECT_EQ(std::vector<int>({0, 0, 1}), result.labels);
+  EXPECT_EQ(referenceLprnetGreedy(&classMajor[0][0], 7, 3), result.labels);
+}
+
+// 并列最大值取下标最小的一个，与原实现的严格比较相同；覆盖SIMD主循环之后的尾部
+TEST(CtcDecoder, ArgmaxTakesFirstMaximum) {
+  const float data[] = {1, 3, 2, 3, 0, 1, 2, 3, 0.5f};
+  float value;
+  for (int num = 1; num <= 9; ++num) {
+    int expected = 0;
+    for (int i = 1; i < num; ++i)
+      if (data[expected] < data[i]) expected = i;
+    EXPECT_EQ(expected, ctcArgmax(data, num, &value)) << num;
+    EXPECT_EQ(data[expected], value);
+  }
+  const float tail[] = {0, 0, 0, 0, 0, 0, 0, 0, 1};
+  EXPECT_EQ(8, ctcArgmax(tail, 9, &value));
+}
+
+struct Shape {
+  int batch, T, C;
+};
+
+// ppocr_rec的字典分别为97类的英文和6625类的中文
+const Shape kShapes[] = {{32, 40, 97}, {8, 40, 6625}, {4, 25, 6625}};
+
+TEST(CtcDecoder, GreedyMatchesPpocrRec) {
+  CtcDecoder decoder;
+  decoder.configure(0, 1);
+  std::vector<CtcDecoder::Result> results;
+  unsigned seed = 1;
+  for (const auto& s : kShapes) {
+    for (float blankRate : {0.f, 0.5f, 0.9f}) {
+      auto logits = makeCtcLogits(s.batch, s.T, s.C, 0, blankRate, seed++);
+      decoder.decode(logits.data(), s.batch, s.T, s.C, results);
+      ASSERT_EQ(std::size_t(s.batch), results.size());
+      for (int b = 0; b < s.batch; ++b)
+        expectSame(referencePpocrGreedy(&logits[std::size_t(b) * s.T * s.C],
+                                        s.T, s.C),
+                   results[b]);
+    }
+  }
+}
+
+TEST(CtcDecoder, BeamSearchMatchesPpocrRec) {
+  CtcDecoder decoder;
+  std::vector<CtcDecoder::Result> results;
+  unsigned seed = 100;
+  for (const auto& s : kShapes) {
+    // 原实现每步对全部字符排序，只取前几条
+    const int batch = std::min(s.batch, 4);
+    auto logits = makeCtcLogits(batch, s.T, s.C, 0, 0.5f, seed++);
+    for (int k : {2, 3, 5, 10}) {
+      decoder.configure(0, k);
+      decoder.decode(logits.data(), batch, s.T, s.C, results);
+      for (int b = 0; b < batch; ++b)
+        expectSame(referencePpocrBeamSearch(
+                       &logits[std::size_t(b) * s.T * s.C], s.T, s.C, k),
+                   results[b]);
+    }
+  }
+}
+
+// lprnet输出未经softmax，按[C][T]存放，blank为最后一个字符
+TEST(CtcDecoder, ClassMajorMatchesLprnet) {
+  const int T = 18, C = 68;
+  CtcDecoder decoder;
+  decoder.configure(C - 1, 1);
+  CtcDecoder::Result result;
+  for (unsigned seed = 1; seed <= 50; ++seed) {
+    auto probs = makeCtcLogits(1, T, C, C - 1, seed % 5 * 0.2f, seed);
+    std::vector<float> logits(T * C);
+    for (int t = 0; t < T; ++t)
+      for (int c = 0; c < C; ++c)
+        logits[c * T + t] = std::log(probs[t * C + c]);
+    decoder.greedyClassMajor(logits.data(), T, C, result);
+    EXPECT_EQ(referenceLprnetGreedy(logits.data(), T, C), result.labels)
+        << seed;
+  }
+}
+
+// 字符白名单：被屏蔽的字符即使概率最高也不输出，blank始终参与
+TEST(CtcDecoder, AllowedClasses) {
+  const float row[2][5] = {{0.1f, 0.9f, 0.2f, 0.3f, 0.8f},
+                           {0.5f, 0.1f, 0.1f, 0.2f, 0.1f}};
+  std::vector<std::uint8_t> allowed(5, 0);
+  allowed[3] = 1;
+  CtcDecoder decoder;
+  decoder.setAllowedClasses(allowed);
+  CtcDecoder::Result result;
+  for (int k : {1, 3}) {
+    decoder.configure(0, k);
+    if (k > 1)
+      decoder.beamSearch(&row[0][0], 2, 5, result);
+    else
+      decoder.greedy(&row[0][0], 2, 5, result);
+    EXPECT_EQ(std::vector<int>({3}), result.labels) << k;
+    EXPECT_EQ(std::vector<float>({0.3f}), result.confs) << k;
+  }
+}
+
+}  // namespace
+}  // namespace element
+}  // namespace sophon_stream
@@ -0,0 +1,212 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SOPHON_STREAM_TESTS_CTC_REFERENCE_H_
+#define SOPHON_STREAM_TESTS_CTC_REFERENCE_H_
+
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <vector>
+
+// 改为CtcDecoder之前PpocrRecPostProcess和LprnetPostProcess中的解码循环，
+// 输出字符串改为输出字符下标，只用于对比结果和性能
+
+namespace sophon_stream {
+namespace element {
+
+struct ReferenceCtcResult {
+  std::vector<int> labels;
+  std::vector<float> confs;
+};
+
+/**
+ * @brief ppocr_rec的贪心解码，blank为0，logits布局为[T][C]
+ */
+inline ReferenceCtcResult referencePpocrGreedy(const float* predict_batch,
+                                               int outputdim_1,
+                                               int outputdim_2) {
+  ReferenceCtcResult result;
+  std::vector<int> argmax_idx(outputdim_1);
+  std::vector<float> max_value(outputdim_1);
+  for (int n = 0; n < outputdim_1; n++) {
+    int char_start_indx = n * outputdim_2;
+    int char_end_indx = (n + 1) * outputdim_2;
+    argmax_idx[n] = char_start_indx;
+    max_value[n] = predict_batch[char_start_indx];
+    for (int j = char_start_indx; j < char_end_indx; j++)
+      if (max_value[n] < predict_batch[j]) {
+        argmax_idx[n] = j;
+        max_value[n] = predict_batch[j];
+      }
+    argmax_idx[n] -= char_start_indx;
+  }
+
+  int last_index = 0;
+  for (int n = 0; n < outputdim_1; n++) {
+    if (argmax_idx[n] > 0 && (!(n > 0 && argmax_idx[n] == last_index))) {
+      result.labels.push_back(argmax_idx[n]);
+      result.confs.push_back(max_value[n]);
+    }
+    last_index = argmax_idx[n];
+  }
+  return result;
+}
+
+struct BeamSearchCandidate {
+  std::vector<int> prefix;
+  float score;
+  std::vector<float> confs;
+  BeamSearchCandidate() : score(0.0f) {}
+  BeamSearchCandidate(const std::vector<int>& pref, float scr,
+                      const std::vector<float>& cfs)
+      : prefix(pref), score(scr), confs(cfs) {}
+};
+
+/**
+ * @brief ppocr_rec的beam search，blank为0，logits布局为[T][C]
+ */
+inline ReferenceCtcResult referencePpocrBeamSearch(const float* predict_batch,
+                                                   int outputdim_1,
+                                                   int outputdim_2, int k) {
+  std::vector<BeamSearchCandidate> beams;
+  beams.push_back(BeamSearchCandidate({}, 1.0f, {}));
+
+  for (int t = 0; t < outputdim_1; t++) {
+    std::vector<BeamSearchCandidate> new_beams;
+    std::vector<float> next_char_probs;
+
+    for (int c = 0; c < outputdim_2; c++) {
+      float token_score = predict_batch[t * outputdim_2 + c];
+      next_char_probs.push_back(token_score);
+    }
+
+    std::vector<int> top_candidates(next_char_probs.size());
+    std::iota(top_candidates.begin(), top_candidates.end(), 0);
+    std::sort(top_candidates.begin(), top_candidates.end(),
+              [&](int i, int j) {
+                return next_char_probs[i] > next_char_probs[j];
+              });
+
+    top_candidates.resize(k);
+
+    for (const BeamSearchCandidate& beam : beams) {
+      for (std::size_t c = 0; c < top_candidates.size(); c++) {
+        std::vector<int> new_prefix = beam.prefix;
+        new_prefix.push_back(top_candidates[c]);
+        float new_score = beam.score;
+        new_score = new_score * next_char_probs[top_candidates[c]];
+        std::vector<float> new_confs = beam.confs;
+        new_confs.push_back(next_char_probs[top_candidates[c]]);
+        new_beams.emplace_back(
+            BeamSearchCandidate(new_prefix, new_score, new_confs));
+      }
+    }
+    std::sort(new_beams.begin(), new_beams.end(),
+              [](const BeamSearchCandidate& a, const BeamSearchCandidate& b) {
+                return a.score > b.score;
+              });
+    new_beams.resize(k);
+    beams = new_beams;
+  }
+  BeamSearchCandidate best_beam = beams[0];
+
+  ReferenceCtcResult result;
+  int pre_c = best_beam.prefix[0];
+  if (pre_c != 0) {
+    result.labels.push_back(pre_c);
+    result.confs.push_back(best_beam.confs[0]);
+  }
+  for (std::size_t idx = 0; idx < best_beam.prefix.size(); idx++) {
+    if (pre_c == best_beam.prefix[idx] || best_beam.prefix[idx] == 0) {
+      if (best_beam.prefix[idx] == 0) {
+        pre_c = best_beam.prefix[idx];
+      }
+      continue;
+    }
+    result.labels.push_back(best_beam.prefix[idx]);
+    result.confs.push_back(best_beam.confs[idx]);
+    pre_c = best_beam.prefix[idx];
+  }
+  return result;
+}
+
+/**
+ * @brief lprnet的贪心解码，blank为clas_char - 1，logits布局为[C][T]
+ */
+inline std::vector<int> referenceLprnetGreedy(const float* output_data,
+                                              int len_char, int clas_char) {
+  std::vector<float> ptr(clas_char);
+  std::vector<int> pred_num(len_char);
+  for (int j = 0; j < len_char; j++) {
+    for (int k = 0; k < clas_char; k++) {
+      ptr[k] = *(output_data + k * len_char + j);
+    }
+    float max_value = -1e10;
+    int class_id = 0;
+    for (int i = 0; i < clas_char; ++i) {
+      if (ptr[i] > max_value) {
+        max_value = ptr[i];
+        class_id = i;
+      }
+    }
+    pred_num[j] = class_id;
+  }
+
+  std::vector<int> no_repeat_blank;
+  int pre_c = pred_num[0];
+  if (pre_c != clas_char - 1) no_repeat_blank.push_back(pre_c);
+  for (int i = 0; i < len_char; i++) {
+    if (pred_num[i] == pre_c) continue;
+    if (pred_num[i] == clas_char - 1) {
+      pre_c = pred_num[i];
+      continue;
+    }
+    no_repeat_blank.push_back(pred_num[i]);
+    pre_c = pred_num[i];
+  }
+  return no_repeat_blank;
+}
+
+/**
+ * @brief 模拟识别网络softmax之后的输出，布局为[batch][T][C]：
+ * 每个时间步有一个主导字符，blankRate比例的时间步主导字符为blank，
+ * 主导字符经常与上一步相同，构造重复字符；各概率互不相等
+ */
+inline std::vector<float> makeCtcLogits(int batch, int T, int C, int blank,
+                                        float blankRate, unsigned seed) {
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<float> uniform(0.f, 1.f);
+  std::vector<float> logits(static_cast<std::size_t>(batch) * T * C);
+  for (int b = 0; b < batch; ++b) {
+    int last = blank;
+    for (int t = 0; t < T; ++t) {
+      float* row = &logits[(static_cast<std::size_t>(b) * T + t) * C];
+      float sum = 0;
+      for (int c = 0; c < C; ++c) sum += row[c] = uniform(rng) + 1e-3f;
+      int top;
+      if (uniform(rng) < blankRate)
+        top = blank;
+      else if (uniform(rng) < 0.3f)
+        top = last;
+      else
+        top = rng() % C;
+      const float peak = 0.3f + 0.69f * uniform(rng);
+      for (int c = 0; c < C; ++c) row[c] *= (1 - peak) / sum;
+      row[top] += peak;
+      last = top;
+    }
+  }
+  return logits;
+}
+
+}  // namespace element
+}  // namespace sophon_stream
+
+#endif  // SOPHON_STREAM_TESTS_CTC_REFERENCE_H_
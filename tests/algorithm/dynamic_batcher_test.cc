@@ -0,0 +1,242 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#include <gtest/gtest.h>
+
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include "algorithmApi/batcher.h"
+
+namespace sophon_stream {
+namespace element {
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using std::chrono::milliseconds;
+
+struct FakeFrame {
+  bool mEndOfStream = false;
+};
+
+struct FakeObject {
+  int mId = 0;
+  bool mFilter = false;
+  std::shared_ptr<FakeFrame> mFrame = std::make_shared<FakeFrame>();
+};
+
+struct FakeHeader {
+  Clock::time_point mEnqueueTime;
+  int mPriority = 0;
+};
+
+// 与framework::Message接口相同的消息，不依赖SDK
+class FakeMessage {
+ public:
+  FakeMessage() = default;
+  FakeMessage(std::shared_ptr<FakeObject> object, Clock::time_point enqueue,
+              int priority = 0)
+      : mObject(std::move(object)) {
+    mHeader.mEnqueueTime = enqueue;
+    mHeader.mPriority = priority;
+  }
+  static FakeMessage flush() {
+    FakeMessage message;
+    message.mControl = true;
+    return message;
+  }
+
+  bool isControl() const { return mControl; }
+  bool empty() const { return !mControl && !mObject; }
+  const FakeHeader& header() const { return mHeader; }
+  std::shared_ptr<FakeObject> takeObjectMetadata() {
+    return std::move(mObject);
+  }
+
+ private:
+  FakeHeader mHeader;
+  bool mControl = false;
+  std::shared_ptr<FakeObject> mObject;
+};
+
+using Batcher = BasicDynamicBatcher<FakeMessage>;
+using Objects = std::vector<std::shared_ptr<FakeObject>>;
+
+// 用模拟时钟驱动batcher：sleep直接推进时间，消息在指定时间进入队列
+class DynamicBatcherTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    mNow = Clock::time_point() + std::chrono::hours(1);
+    mStart = mNow;
+    mBatcher.setClock([this] { return mNow; },
+                      [this](Clock::duration d) {
+                        mSleepCount++;
+                        mNow += d;
+                      });
+  }
+
+  // 在start + at时进入队列的数据
+  void arrive(milliseconds at, int priority = 0, bool eos = false,
+              bool filter = false) {
+    auto object = std::make_shared<FakeObject>();
+    object->mId = mNextId++;
+    object->mFilter = filter;
+    object->mFrame->mEndOfStream = eos;
+    mQueue.push_back({mStart + at, FakeMessage(object, mStart + at, priority)});
+  }
+
+  void arriveFlush(milliseconds at) {
+    mQueue.push_back({mStart + at, FakeMessage::flush()});
+  }
+
+  int collect() {
+    mObjects.clear();
+    mPending.clear();
+    mControls.clear();
+    return mBatcher.collect(
+        [this] {
+          if (mQueue.empty() || mQueue.front().first > mNow)
+            return FakeMessage();
+          auto message = std::move(mQueue.front().second);
+          mQueue.pop_front();
+          return message;
+        },
+        [this] { return mNow - mStart < std::chrono::seconds(10); }, mObjects,
+        mPending, mControls);
+  }
+
+  milliseconds elapsed() const {
+    return std::chrono::duration_cast<milliseconds>(mNow - mStart);
+  }
+
+  Batcher mBatcher;
+  Clock::time_point mStart, mNow;
+  int mSleepCount = 0;
+  int mNextId = 0;
+  std::deque<std::pair<Clock::time_point, FakeMessage>> mQueue;
+  Objects mObjects, mPending;
+  std::vector<FakeMessage> mControls;
+};
+
+TEST_F(DynamicBatcherTest, FullBatchReturnsWithoutWaiting) {
+  mBatcher.init(4, {1, 2, 4}, 10000);
+  for (int i = 0; i < 5; ++i) arrive(milliseconds(0));
+  EXPECT_EQ(4, collect());
+  EXPECT_EQ(4u, mObjects.size());
+  EXPECT_EQ(0, mSleepCount);
+  EXPECT_EQ(1u, mQueue.size());
+}
+
+TEST_F(DynamicBatcherTest, TimeoutPicksSmallestFittingBatchSize) {
+  mBatcher.init(8, {1, 4, 8}, 10000);
+  arrive(milliseconds(0));
+  arrive(milliseconds(3));
+  EXPECT_EQ(4, collect());
+  EXPECT_EQ(2u, mObjects.size());
+  // 从第一帧入队起等待10ms
+  EXPECT_EQ(milliseconds(10), elapsed());
+
+  auto statistics = mBatcher.getStatistics();
+  EXPECT_EQ(1, statistics.mBatchCount);
+  EXPECT_EQ(1, statistics.mTimeoutCount);
+  EXPECT_EQ(2, statistics.mObjectCount);
+  EXPECT_EQ(4, statistics.mSlotCount);
+  EXPECT_FLOAT_EQ(0.5f, statistics.fillRate());
+  EXPECT_EQ(1, statistics.mBatchSizeHistogram[4]);
+}
+
+TEST_F(DynamicBatcherTest, OnlyCompiledBatchSizeIsUsed) {
+  mBatcher.init(4, {4}, 5000);
+  arrive(milliseconds(0));
+  EXPECT_EQ(4, collect());
+  EXPECT_EQ(1u, mObjects.size());
+}
+
+TEST_F(DynamicBatcherTest, QueueingTimeCountsTowardsDeadline) {
+  mBatcher.init(4, {1, 4}, 10000);
+  // 数据在8ms时入队，batcher在9ms才开始收集，只需要再等1ms
+  arrive(milliseconds(8));
+  mNow = mStart + milliseconds(9);
+  EXPECT_EQ(1, collect());
+  EXPECT_EQ(milliseconds(18), elapsed());
+}
+
+TEST_F(DynamicBatcherTest, HigherPriorityShortensDeadline) {
+  mBatcher.init(4, {1, 2, 4}, 12000);
+  arrive(milliseconds(0));
+  // 优先级2的数据最多等待12ms / 3 = 4ms
+  arrive(milliseconds(1), 2);
+  EXPECT_EQ(2, collect());
+  EXPECT_EQ(milliseconds(5), elapsed());
+}
+
+TEST_F(DynamicBatcherTest, NegativeWaitWaitsForFullBatch) {
+  mBatcher.init(2, {1, 2}, -1);
+  arrive(milliseconds(0));
+  arrive(milliseconds(500));
+  EXPECT_EQ(2, collect());
+  EXPECT_GE(elapsed(), milliseconds(500));
+  EXPECT_EQ(0, mBatcher.getStatistics().mTimeoutCount);
+}
+
+TEST_F(DynamicBatcherTest, ControlMessageFlushesImmediately) {
+  mBatcher.init(4, {1, 2, 4}, 10000);
+  arrive(milliseconds(0));
+  arriveFlush(milliseconds(1));
+  EXPECT_EQ(1, collect());
+  EXPECT_EQ(1u, mControls.size());
+  EXPECT_LT(elapsed(), milliseconds(2));
+}
+
+TEST_F(DynamicBatcherTest, EndOfStreamStopsCollecting) {
+  mBatcher.init(4, {4}, 10000);
+  arrive(milliseconds(0));
+  arrive(milliseconds(0), 0, true);
+  arrive(milliseconds(0));
+  collect();
+  EXPECT_EQ(2u, mPending.size());
+  EXPECT_TRUE(mPending.back()->mFrame->mEndOfStream);
+  EXPECT_EQ(1u, mQueue.size());
+}
+
+TEST_F(DynamicBatcherTest, FilteredObjectsAreNotInferred) {
+  mBatcher.init(2, {1, 2}, 10000);
+  arrive(milliseconds(0), 0, false, true);
+  arrive(milliseconds(0));
+  arrive(milliseconds(0));
+  EXPECT_EQ(2, collect());
+  EXPECT_EQ(2u, mObjects.size());
+  EXPECT_EQ(3u, mPending.size());
+  EXPECT_EQ(0, mPending[0]->mId);
+}
+
+TEST_F(DynamicBatcherTest, NothingCollectedReturnsZero) {
+  mBatcher.init(4, {4}, 10000);
+  EXPECT_EQ(0, collect());
+  EXPECT_EQ(0, mBatcher.getStatistics().mBatchCount);
+}
+
+TEST(DynamicBatcher, ChooseBatchSize) {
+  Batcher batcher;
+  batcher.init(8, {1, 4, 8}, 0);
+  EXPECT_EQ(0, batcher.chooseBatchSize(0));
+  EXPECT_EQ(1, batcher.chooseBatchSize(1));
+  EXPECT_EQ(4, batcher.chooseBatchSize(2));
+  EXPECT_EQ(4, batcher.chooseBatchSize(4));
+  EXPECT_EQ(8, batcher.chooseBatchSize(5));
+  EXPECT_EQ(8, batcher.chooseBatchSize(9));
+
+  batcher.init(4, {}, 0);
+  EXPECT_EQ(4, batcher.chooseBatchSize(1));
+}
+
+}  // namespace
+}  // namespace element
+}  // namespace sophon_stream
@@ -0,0 +1,137 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#include "algorithmApi/host_pre_process.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace sophon_stream {
+namespace element {
+namespace {
+
+using common::ErrorCode;
+using common::HostImage;
+using common::HostTensor;
+using common::TensorInfo;
+
+// 每个像素为(x, y, x + y)的BGR图
+HostImage gradient(int w, int h) {
+  HostImage image;
+  image.create(w, h, 3);
+  for (int y = 0; y < h; ++y)
+    for (int x = 0; x < w; ++x) {
+      std::uint8_t* p = image.row(y) + x * 3;
+      p[0] = x;
+      p[1] = y;
+      p[2] = x + y;
+    }
+  return image;
+}
+
+TEST(HostPreProcess, LetterboxMatchesYolov5Geometry) {
+  HostPreProcess pre;
+  auto wide = pre.letterbox(1920, 1080, 640, 640);
+  EXPECT_FLOAT_EQ(640.f / 1920, wide.ratioW);
+  EXPECT_EQ(640, wide.width);
+  EXPECT_EQ(360, wide.height);
+  EXPECT_EQ(0, wide.padX);
+  EXPECT_EQ(140, wide.padY);
+
+  auto tall = pre.letterbox(300, 600, 640, 640);
+  EXPECT_EQ(320, tall.width);
+  EXPECT_EQ(160, tall.padX);
+  EXPECT_EQ(0, tall.padY);
+
+  pre.keepAspect = false;
+  auto stretched = pre.letterbox(1920, 1080, 640, 640);
+  EXPECT_EQ(0, stretched.padX);
+  EXPECT_EQ(0, stretched.padY);
+  EXPECT_FLOAT_EQ(640.f / 1080, stretched.ratioH);
+}
+
+TEST(HostPreProcess, FillsBatchedInput) {
+  HostPreProcess pre;
+  pre.setMeanStd({0, 0, 0}, {255, 255, 255});
+  TensorInfo info;
+  info.shape = {1, 3, 8, 8};
+
+  HostImage wide;
+  wide.create(16, 8, 3);
+  for (int y = 0; y < 8; ++y)
+    for (int x = 0; x < 16; ++x) {
+      std::uint8_t* p = wide.row(y) + x * 3;
+      p[0] = 255;  // B
+      p[1] = 0;
+      p[2] = 51;  // R
+    }
+  HostImage square = gradient(8, 8);
+
+  HostTensor input;
+  std::vector<HostPreProcess::Letterbox> boxes;
+  ASSERT_EQ(ErrorCode::SUCCESS,
+            pre.preProcess({wide, square}, info, input, boxes));
+  ASSERT_EQ((std::vector<int>{2, 3, 8, 8}), input.shape);
+  ASSERT_EQ(2u, boxes.size());
+  EXPECT_EQ(2, boxes[0].padY);
+  EXPECT_EQ(4, boxes[0].height);
+
+  // 第一张图：上下各2行填充114，中间为RGB顺序的纯色
+  const float* r = input.floatData();
+  const float* b = r + 2 * 64;
+  EXPECT_FLOAT_EQ(114.f / 255, r[0]);
+  EXPECT_FLOAT_EQ(114.f / 255, b[7 * 8 + 7]);
+  EXPECT_FLOAT_EQ(51.f / 255, r[2 * 8]);
+  EXPECT_FLOAT_EQ(1.f, b[5 * 8 + 7]);
+
+  // 第二张图大小与网络一致，不缩放
+  const float* second = input.floatData() + 3 * 64;
+  EXPECT_EQ(0, boxes[1].padX);
+  EXPECT_FLOAT_EQ((3 + 5) / 255.f, second[5 * 8 + 3]);
+}
+
+TEST(HostPreProcess, RejectsMismatchedChannels) {
+  HostPreProcess pre;
+  TensorInfo info;
+  info.shape = {1, 1, 8, 8};
+  HostTensor input;
+  std::vector<HostPreProcess::Letterbox> boxes;
+  EXPECT_EQ(ErrorCode::PARAMETER_ERROR,
+            pre.preProcess({gradient(8, 8)}, info, input, boxes));
+  info.shape = {1, 3, 8, 8};
+  info.dtype = 1;
+  EXPECT_EQ(ErrorCode::PARAMETER_ERROR,
+            pre.preProcess({gradient(8, 8)}, info, input, boxes));
+}
+
+TEST(HostPreProcess, QuantizesInt8Input) {
+  HostPreProcess pre;
+  pre.setMeanStd({128, 128, 128}, {1, 1, 1});
+  TensorInfo info;
+  info.dtype = 2;
+  info.shape = {1, 3, 8, 8};
+  HostImage image;
+  image.create(8, 8, 3);
+  std::fill(image.data.begin(), image.data.end(), 255);
+  image.row(0)[0] = 0;
+  HostTensor input;
+  std::vector<HostPreProcess::Letterbox> boxes;
+  ASSERT_EQ(ErrorCode::SUCCESS, pre.preProcess({image}, info, input, boxes));
+  ASSERT_EQ(3u * 64, input.data.size());
+  auto* data = reinterpret_cast<const std::int8_t*>(input.data.data());
+  EXPECT_EQ(127, data[0]);
+  // B通道转为RGB后是第3个平面
+  EXPECT_EQ(-128, data[2 * 64]);
+}
+
+}  // namespace
+}  // namespace element
+}  // namespace sophon_stream
@@ -0,0 +1,126 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#include "openpose_cpu_decoder.h"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "openpose_reference.h"
+
+namespace sophon_stream {
+namespace element {
+namespace openpose {
+namespace {
+
+using Model = common::PosedObjectMetadata::EModelType;
+using People = std::vector<std::shared_ptr<common::PosedObjectMetadata>>;
+
+const int kMaxPeaks = kReferenceMaxPeople;
+const int kPeaksOffset = (kMaxPeaks + 1) * 3;
+
+struct Decoded {
+  std::vector<float> peaks;
+  People people;
+};
+
+// 与OpenposePostProcess相同的参数：9, 0.05, 3, 0.4, 1
+Decoded decodeReference(std::vector<float>& maps, int width, int height,
+                        int parts, Model model) {
+  Decoded out;
+  out.peaks.assign(parts * kPeaksOffset, 0.f);
+  referenceNms(maps.data(), out.peaks.data(), parts, height, width, kMaxPeaks,
+               0.05f, width * height, kPeaksOffset);
+  referenceConnectBodyParts(out.people, maps.data(), out.peaks.data(),
+                            ReferenceSize{width, height}, kMaxPeaks, 9, 0.05f,
+                            3, 0.4f, 1, model);
+  return out;
+}
+
+Decoded decode(OpenposeCpuDecoder& decoder, const std::vector<float>& maps,
+               int width, int height, int parts, Model model) {
+  Decoded out;
+  out.peaks.assign(parts * kPeaksOffset, 0.f);
+  for (int c = 0; c < parts; ++c)
+    OpenposeCpuDecoder::findPeaks(maps.data() + c * width * height, height,
+                                  width, kMaxPeaks, 0.05f,
+                                  out.peaks.data() + c * kPeaksOffset);
+  decoder.connect(out.people, maps.data(), out.peaks.data(), width, height,
+                  kMaxPeaks, 9, 0.05f, 3, 0.4f, 1, referencePosePairs(model),
+                  referencePoseMapIdx(model), referenceNumberBodyParts(model),
+                  kReferenceMaxPeople, model);
+  return out;
+}
+
+void expectSame(const Decoded& expected, const Decoded& actual) {
+  ASSERT_EQ(expected.peaks, actual.peaks);
+  ASSERT_EQ(expected.people.size(), actual.people.size());
+  for (std::size_t i = 0; i < expected.people.size(); ++i) {
+    EXPECT_EQ(expected.people[i]->keypoints, actual.people[i]->keypoints) << i;
+    EXPECT_EQ(expected.people[i]->modeltype, actual.people[i]->modeltype);
+  }
+}
+
+TEST(OpenposeCpuDecoder, MatchesReferenceOnCrowds) {
+  const int width = 160, height = 120;
+  // 同一个decoder跨帧复用内部数组
+  OpenposeCpuDecoder decoder;
+  int totalPeople = 0;
+  for (int people : {0, 1, 4, 12, 30}) {
+    auto maps = makeCrowdMaps(width, height, people, 100 + people);
+    Decoded expected = decodeReference(maps, width, height, 18, Model::COCO_18);
+    Decoded actual = decode(decoder, maps, width, height, 18, Model::COCO_18);
+    expectSame(expected, actual);
+    totalPeople += expected.people.size();
+  }
+  // 确认测试数据确实组装出了人体
+  EXPECT_GT(totalPeople, 10);
+}
+
+// 每个通道都是[0, 1)的噪声：峰值达到maxPeaks上限，PAF得分随机，覆盖提前结束的分支
+TEST(OpenposeCpuDecoder, MatchesReferenceOnNoise) {
+  const int width = 64, height = 48;
+  OpenposeCpuDecoder decoder;
+  for (Model model : {Model::COCO_18, Model::BODY_25}) {
+    const int parts = referenceNumberBodyParts(model);
+    const int channels = model == Model::BODY_25 ? 78 : 57;
+    std::mt19937 rng(static_cast<unsigned>(channels));
+    std::uniform_real_distribution<float> uniform(0.f, 1.f);
+    std::vector<float> maps(channels * width * height);
+    for (auto& v : maps) v = uniform(rng);
+
+    Decoded expected = decodeReference(maps, width, height, parts, model);
+    Decoded actual = decode(decoder, maps, width, height, parts, model);
+    EXPECT_EQ(kMaxPeaks, static_cast<int>(expected.peaks[0]));
+    expectSame(expected, actual);
+  }
+}
+
+// 宽度不是4的倍数时，SIMD主循环之后的标量尾部也要检测到峰值
+TEST(OpenposeCpuDecoder, FindsPeaksInScalarTail) {
+  const int width = 11, height = 5;
+  std::vector<float> map(width * height, 0.f);
+  map[2 * width + 9] = 1.f;
+  map[2 * width + 1] = 0.5f;
+  std::vector<float> expected(kPeaksOffset, 0.f), actual(kPeaksOffset, 0.f);
+  referenceNms(map.data(), expected.data(), 1, height, width, kMaxPeaks, 0.05f,
+               width * height, kPeaksOffset);
+  OpenposeCpuDecoder::findPeaks(map.data(), height, width, kMaxPeaks, 0.05f,
+                                actual.data());
+  EXPECT_EQ(2.f, actual[0]);
+  EXPECT_EQ(expected, actual);
+}
+
+}  // namespace
+}  // namespace openpose
+}  // namespace element
+}  // namespace sophon_stream
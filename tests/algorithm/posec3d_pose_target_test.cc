@@ -0,0 +1,231 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#include "posec3d_pose_target.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "posec3d_reference.h"
+
+namespace sophon_stream {
+namespace element {
+namespace posec3d {
+namespace {
+
+// 与preProcess相同：centerCrop后为64x64，17个关键点，两个crop。
+// 为了控制heatmap大小，clip_len和num_clips比模型小
+const int kSize = 64, kKeypoints = 17, kClipLen = 8, kNumClips = 2;
+const int kOutNum = 2 * kNumClips * kClipLen * kKeypoints * kSize * kSize;
+const float kSigma = 0.6f;
+
+struct Frames {
+  fpptr_dim3 keypoints;
+  fpptr_dim3 scores;
+};
+
+// 关键点可能落在图像外，置信度包含低于、等于和高于1e-4的值
+Frames makeFrames(int num, int persons, unsigned seed) {
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<float> position(-4.f, kSize + 4.f);
+  std::uniform_real_distribution<float> uniform(0.f, 1.f);
+  const float lowScores[] = {0.f, 5e-5f, 1e-4f, 2e-4f};
+  Frames frames;
+  for (int f = 0; f < num; ++f) {
+    auto keypoints = std::make_shared<fpptr_dim2>();
+    auto scores = std::make_shared<fpptr_dim2>();
+    for (int p = 0; p < persons; ++p) {
+      auto kp = std::make_shared<std::vector<float>>();
+      auto sc = std::make_shared<std::vector<float>>();
+      for (int j = 0; j < kKeypoints; ++j) {
+        kp->push_back(position(rng));
+        kp->push_back(position(rng));
+        sc->push_back(uniform(rng) < 0.2f ? lowScores[rng() % 4]
+                                          : 0.05f + 0.95f * uniform(rng));
+      }
+      keypoints->push_back(kp);
+      scores->push_back(sc);
+    }
+    frames.keypoints.push_back(keypoints);
+    frames.scores.push_back(scores);
+  }
+  return frames;
+}
+
+// 每个采样位置随机取一个源帧，部分源帧不会被采样
+std::vector<int> makeInds(int num, unsigned seed) {
+  std::mt19937 rng(seed);
+  std::vector<int> inds(kNumClips * kClipLen);
+  for (auto& ind : inds) ind = rng() % num;
+  return inds;
+}
+
+fpptr_dim3 deepCopy(const fpptr_dim3& keypoints) {
+  fpptr_dim3 copy;
+  for (auto& frame : keypoints) {
+    auto persons = std::make_shared<fpptr_dim2>();
+    for (auto& person : *frame)
+      persons->push_back(std::make_shared<std::vector<float>>(*person));
+    copy.push_back(persons);
+  }
+  return copy;
+}
+
+// 分离计算的高斯与直接计算二维高斯只有舍入误差
+void expectSameHeatmap(const std::vector<float>& expected,
+                       const std::vector<float>& actual) {
+  ASSERT_EQ(expected.size(), actual.size());
+  int mismatches = 0;
+  for (std::size_t i = 0; i < expected.size(); ++i) {
+    float tolerance = 1e-5f * std::max(1.f, std::fabs(expected[i]));
+    if ((expected[i] == 0) != (actual[i] == 0) ||
+        std::fabs(expected[i] - actual[i]) > tolerance)
+      ++mismatches;
+  }
+  EXPECT_EQ(0, mismatches);
+}
+
+std::vector<float> renderLegacy(const Frames& frames,
+                                const std::vector<int>& inds,
+                                float input_scale) {
+  fpptr_dim3 sampled, sampledScores;
+  referenceExpandFrames(frames.keypoints, frames.scores, inds, sampled,
+                        sampledScores);
+  std::vector<float> heatmap(kOutNum, -1.f);
+  referenceGeneratePoseTarget(sampled, sampledScores, kSize, kSize,
+                              kKeypoints, input_scale, kSigma, kClipLen,
+                              heatmap.data(), kOutNum);
+  return heatmap;
+}
+
+std::vector<float> render(const Frames& frames, const std::vector<int>& inds,
+                          float input_scale) {
+  std::vector<float> heatmap(kOutNum, -1.f);
+  renderPoseTarget(frames.keypoints, frames.scores, inds, kSize, kSize,
+                   kKeypoints, input_scale, kSigma, kClipLen, heatmap.data(),
+                   kOutNum);
+  return heatmap;
+}
+
+TEST(Posec3dPoseTarget, MatchesPerSampleRender) {
+  unsigned seed = 1;
+  for (int num : {1, 5, 16, 30}) {
+    for (int persons : {0, 1, 3}) {
+      Frames frames = makeFrames(num, persons, seed);
+      auto inds = makeInds(num, seed++);
+      for (float input_scale : {1.f, 0.5f}) {
+        SCOPED_TRACE(testing::Message() << num << " frames, " << persons
+                                        << " persons, scale " << input_scale);
+        expectSameHeatmap(renderLegacy(frames, inds, input_scale),
+                          render(frames, inds, input_scale));
+      }
+    }
+  }
+}
+
+// 贴着边缘和超出边缘的关键点，以及刚好等于和低于阈值的置信度
+TEST(Posec3dPoseTarget, BordersAndLowScores) {
+  const float xs[] = {-2.9f, -1.9f, -0.5f, 0.f,   0.4f,  31.5f,
+                      63.f,  63.5f, 63.9f, 64.4f, 65.9f, 66.1f};
+  const float scores[] = {1.f, 1e-4f, 9.9e-5f, 0.f, 0.7f};
+  Frames frames = makeFrames(2, 1, 3);
+  int k = 0;
+  for (auto& frame : frames.keypoints) {
+    for (auto& person : *frame)
+      for (int j = 0; j < kKeypoints; ++j, ++k) {
+        (*person)[2 * j] = xs[k % 12];
+        (*person)[2 * j + 1] = xs[(k * 5 + 3) % 12];
+      }
+  }
+  k = 0;
+  for (auto& frame : frames.scores)
+    for (auto& person : *frame)
+      for (auto& score : *person) score = scores[k++ % 5];
+  auto inds = makeInds(2, 4);
+  auto expected = renderLegacy(frames, inds, 1.f);
+  expectSameHeatmap(expected, render(frames, inds, 1.f));
+  // 至少有一个关键点被渲染
+  EXPECT_GT(*std::max_element(expected.begin(), expected.end()), 0.f);
+}
+
+// window_stride小于窗口时逐次滑动的结果与每次用最近的帧重新组成窗口相同，
+// 后续步骤原地修改关键点不影响历史
+TEST(Posec3dPoseTarget, SlidingWindowMatchesFullRecompute) {
+  const int windowSize = 6, stride = 2, total = 15, channel = 3;
+  Frames stream = makeFrames(total, 2, 7);
+  fpptr_dim3 original = deepCopy(stream.keypoints);
+  PoseWindow window;
+  unsigned seed = 10;
+  for (int start = 0; start < total; start += stride) {
+    int end = std::min(start + stride, total);
+    Frames batch;
+    batch.keypoints.assign(stream.keypoints.begin() + start,
+                           stream.keypoints.begin() + end);
+    batch.scores.assign(stream.scores.begin() + start,
+                        stream.scores.begin() + end);
+    window.slide(channel, windowSize, batch.keypoints, batch.scores);
+
+    int first = std::max(0, end - windowSize);
+    Frames recomputed;
+    recomputed.keypoints.assign(original.begin() + first,
+                                original.begin() + end);
+    recomputed.scores.assign(stream.scores.begin() + first,
+                             stream.scores.begin() + end);
+    recomputed.keypoints = deepCopy(recomputed.keypoints);
+    ASSERT_EQ(recomputed.keypoints.size(), batch.keypoints.size());
+    for (std::size_t f = 0; f < batch.keypoints.size(); ++f) {
+      ASSERT_EQ(recomputed.keypoints[f]->size(), batch.keypoints[f]->size());
+      for (std::size_t p = 0; p < batch.keypoints[f]->size(); ++p)
+        EXPECT_EQ(*recomputed.keypoints[f]->at(p), *batch.keypoints[f]->at(p));
+    }
+
+    auto inds = makeInds(batch.keypoints.size(), seed++);
+    expectSameHeatmap(renderLegacy(recomputed, inds, 1.f),
+                      render(batch, inds, 1.f));
+
+    // 与preProcess一样原地平移、缩放窗口内的关键点
+    for (auto& frame : batch.keypoints)
+      for (auto& person : *frame)
+        for (auto& value : *person) value = value * 2 - 5;
+  }
+  for (int f = 0; f < total; ++f)
+    for (std::size_t p = 0; p < original[f]->size(); ++p)
+      EXPECT_EQ(*original[f]->at(p), *stream.keypoints[f]->at(p));
+}
+
+TEST(Posec3dPoseTarget, ResetClearsOnlyThatChannel) {
+  Frames frames = makeFrames(4, 1, 9);
+  PoseWindow window;
+  auto slide = [&](int channel, int first, int last) {
+    Frames batch;
+    batch.keypoints.assign(frames.keypoints.begin() + first,
+                           frames.keypoints.begin() + last);
+    batch.scores.assign(frames.scores.begin() + first,
+                        frames.scores.begin() + last);
+    window.slide(channel, 4, batch.keypoints, batch.scores);
+    return batch;
+  };
+  slide(0, 0, 2);
+  slide(1, 0, 3);
+  window.reset(0);
+  Frames batch = slide(0, 2, 3);
+  ASSERT_EQ(1u, batch.keypoints.size());
+  EXPECT_EQ(frames.scores[2], batch.scores[0]);
+  EXPECT_EQ(*frames.keypoints[2]->at(0), *batch.keypoints[0]->at(0));
+  EXPECT_EQ(4u, slide(1, 3, 4).keypoints.size());
+}
+
+}  // namespace
+}  // namespace posec3d
+}  // namespace element
+}  // namespace sophon_stream
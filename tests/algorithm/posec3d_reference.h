@@ -0,0 +1,96 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SOPHON_STREAM_TESTS_POSEC3D_REFERENCE_H_
+#define SOPHON_STREAM_TESTS_POSEC3D_REFERENCE_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#include "posec3d_pose_target.h"
+
+// 改为按源帧渲染之前Posec3dPreProcess的heatmap生成：uniformSampleFrames先把源帧
+// 按inds复制成num_clips * clip_len帧，再对每个采样帧的每个像素计算二维高斯，
+// 只用于对比结果
+
+namespace sophon_stream {
+namespace element {
+namespace posec3d {
+
+/**
+ * @brief 原uniformSampleFrames末尾按inds展开源帧
+ */
+inline void referenceExpandFrames(const fpptr_dim3& keypoints,
+                                  const fpptr_dim3& keypoint_scores,
+                                  const std::vector<int>& inds,
+                                  fpptr_dim3& sampled_keypoints,
+                                  fpptr_dim3& sampled_keypoint_scores) {
+  sampled_keypoints.clear();
+  sampled_keypoint_scores.clear();
+  for (std::size_t i = 0; i < inds.size(); i++) {
+    sampled_keypoints.push_back(keypoints[inds[i]]);
+    sampled_keypoint_scores.push_back(keypoint_scores[inds[i]]);
+  }
+}
+
+/**
+ * @brief 原generatePoseTarget的渲染循环，关键点已按heatmap尺寸缩放
+ */
+inline void referenceGeneratePoseTarget(
+    const fpptr_dim3& sampled_keypoints,
+    const fpptr_dim3& sampled_keypoint_scores, int img_h, int img_w,
+    int num_c, float input_scale, float sigma, int clip_len, float* heatmap,
+    int out_num) {
+  const float eps = 1e-4;
+  int num_frame = sampled_keypoints.size();
+  float* data = heatmap;
+  memset((void*)data, 0, out_num * sizeof(float));
+  int heatmap_start_indx = out_num / 2;
+  for (int i = 0; i < num_frame; i++) {
+    for (int j = 0; j < num_c; j++) {
+      for (std::size_t person_id = 0;
+           person_id < sampled_keypoints[i]->size(); person_id++) {
+        if (sampled_keypoint_scores[i]->at(person_id)->at(j) < eps) continue;
+
+        float mu_x = sampled_keypoints[i]->at(person_id)->at(j * 2);
+        float mu_y = sampled_keypoints[i]->at(person_id)->at(j * 2 + 1);
+
+        int st_x = std::max(int(mu_x - 3 * sigma), 0);
+        int ed_x = std::min(int(mu_x + 3 * sigma) + 1, img_w);
+        int st_y = std::max(int(mu_y - 3 * sigma), 0);
+        int ed_y = std::min(int(mu_y + 3 * sigma) + 1, img_h);
+        if (st_x >= ed_x || st_y >= ed_y) continue;
+
+        float* base = data + i / clip_len * num_c * clip_len * img_h * img_w +
+                      j * clip_len * img_h * img_w +
+                      i % clip_len * img_h * img_w;
+        for (int patch_x = st_x; patch_x < ed_x; patch_x++)
+          for (int patch_y = st_y; patch_y < ed_y; patch_y++) {
+            float value = exp(-(std::pow(patch_x - mu_x, 2) +
+                                std::pow(patch_y - mu_y, 2)) /
+                              2 / std::pow(sigma, 2)) *
+                          sampled_keypoint_scores[i]->at(person_id)->at(j);
+            value *= input_scale;
+            if (value > *(base + patch_y * img_w + patch_x)) {
+              *(base + patch_y * img_w + patch_x) = value;
+              *(base + patch_y * img_w + patch_x + heatmap_start_indx) = value;
+            }
+          }
+      }
+    }
+  }
+}
+
+}  // namespace posec3d
+}  // namespace element
+}  // namespace sophon_stream
+
+#endif  // SOPHON_STREAM_TESTS_POSEC3D_REFERENCE_H_
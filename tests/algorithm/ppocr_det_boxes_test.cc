@@ -0,0 +1,233 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+#include "ppocr_det_post_processor.h"
+#include "ppocr_det_reference.h"
+#include "ppocr_det_region_extractor.h"
+
+namespace sophon_stream {
+namespace element {
+namespace ppocr_det {
+namespace {
+
+using Box = std::vector<std::vector<int>>;
+using Boxes = std::vector<Box>;
+
+struct MapCase {
+  int width, height, stride, rows, cols, specks;
+};
+
+const MapCase kMapCases[] = {
+    {160, 96, 160, 4, 2, 0},
+    {320, 240, 336, 8, 3, 40},
+    {640, 640, 640, 24, 4, 200},
+    {257, 131, 264, 5, 5, 30},
+};
+
+// 与ppocr_det_post_process中的参数相同
+const float kBoxThresh = 0.6f;
+const float kUnclipRatio = 1.5f;
+
+// 原流程：整张概率图转成uchar，裁出有效区域后阈值化，在二值图上findContours
+struct LegacyMaps {
+  std::vector<unsigned char> cbuf;
+  cv::Mat pred;
+  cv::Mat bitmap;
+};
+
+LegacyMaps makeLegacyMaps(std::vector<float>& pred, const MapCase& c) {
+  LegacyMaps maps;
+  maps.cbuf.resize(pred.size());
+  for (std::size_t i = 0; i < pred.size(); ++i)
+    maps.cbuf[i] = (unsigned char)(pred[i] * 255);
+  cv::Rect crop(0, 0, c.width, c.height);
+  maps.pred = cv::Mat(c.height, c.stride, CV_32F, pred.data())(crop);
+  cv::Mat cbuf(c.height, c.stride, CV_8UC1, maps.cbuf.data());
+  cv::threshold(cbuf(crop), maps.bitmap, kReferenceThreshold, 255,
+                cv::THRESH_BINARY);
+  return maps;
+}
+
+Boxes ordered(PostProcessor& processor, Boxes boxes) {
+  for (auto& box : boxes) box = processor.OrderPointsClockwise(box);
+  return boxes;
+}
+
+int maxCornerDistance(const Box& l, const Box& r) {
+  int distance = 0;
+  for (int k = 0; k < 4; ++k)
+    distance = std::max({distance, std::abs(l[k][0] - r[k][0]),
+                         std::abs(l[k][1] - r[k][1])});
+  return distance;
+}
+
+// 两组框一一对应，对应顶点相差不超过tolerance像素；findContours的输出顺序与光栅顺序不同
+void expectSameBoxes(const Boxes& expected, const Boxes& actual,
+                     int tolerance) {
+  ASSERT_EQ(expected.size(), actual.size());
+  std::vector<char> used(actual.size(), 0);
+  for (std::size_t i = 0; i < expected.size(); ++i) {
+    int best = -1, bestDistance = 0;
+    for (std::size_t j = 0; j < actual.size(); ++j) {
+      if (used[j]) continue;
+      int distance = maxCornerDistance(expected[i], actual[j]);
+      if (best < 0 || distance < bestDistance) {
+        best = j;
+        bestDistance = distance;
+      }
+    }
+    ASSERT_GE(best, 0);
+    EXPECT_LE(bestDistance, tolerance)
+        << "box " << i << " (" << expected[i][0][0] << ", "
+        << expected[i][0][1] << ")";
+    used[best] = 1;
+  }
+}
+
+// BoxesFromRegions与findContours + clipper外扩的BoxesFromBitmap输出相同的框，
+// 外扩从clipper的整数多边形改为解析计算，顶点最多相差1-2像素
+TEST(PpocrDetBoxes, MatchesFindContoursAndClipper) {
+  PostProcessor processor;
+  RegionExtractor extractor;
+  std::vector<TextRegion> regions;
+  unsigned seed = 1;
+  for (const auto& c : kMapCases) {
+    auto pred = makeTextMap(c.width, c.height, c.stride, c.rows, c.cols,
+                            c.specks, seed++);
+    LegacyMaps maps = makeLegacyMaps(pred, c);
+    extractor.extract(pred.data(), c.stride, c.width, c.height,
+                      kReferenceThreshold, 3, 1000, regions);
+    // 输出到2倍大小的原图
+    const int destW = c.width * 2, destH = c.height * 2;
+    for (bool polygon : {false, true}) {
+      Boxes expected = ordered(
+          processor,
+          processor.BoxesFromBitmap(maps.pred, maps.bitmap, kBoxThresh,
+                                    kUnclipRatio, polygon, destW, destH));
+      Boxes actual = ordered(
+          processor, processor.BoxesFromRegions(
+                         pred.data(), c.stride, c.width, c.height, regions,
+                         kBoxThresh, kUnclipRatio, polygon, destW, destH));
+      EXPECT_GE(expected.size(), std::size_t(c.rows * c.cols));
+      expectSameBoxes(expected, actual, 4);
+    }
+  }
+}
+
+// 区域得分：BoxScoreScan对应BoxScoreFast，区域概率均值对应PolygonScoreAcc
+TEST(PpocrDetBoxes, ScoresMatchLegacy) {
+  PostProcessor processor;
+  RegionExtractor extractor;
+  std::vector<TextRegion> regions;
+  const auto& c = kMapCases[1];
+  auto pred = makeTextMap(c.width, c.height, c.stride, c.rows, c.cols,
+                          c.specks, 7);
+  LegacyMaps maps = makeLegacyMaps(pred, c);
+  extractor.extract(pred.data(), c.stride, c.width, c.height,
+                    kReferenceThreshold, 0, 100000, regions);
+
+  // 测试数据没有空洞，外轮廓与区域一一对应，按外接框匹配
+  std::vector<std::vector<cv::Point>> contours;
+  cv::findContours(maps.bitmap, contours, cv::RETR_EXTERNAL,
+                   cv::CHAIN_APPROX_SIMPLE);
+  ASSERT_EQ(regions.size(), contours.size());
+  int compared = 0;
+  for (const auto& contour : contours) {
+    cv::Rect rect = cv::boundingRect(contour);
+    auto region = std::find_if(
+        regions.begin(), regions.end(), [&rect](const TextRegion& r) {
+          return r.xmin == rect.x && r.ymin == rect.y &&
+                 r.xmax == rect.x + rect.width - 1 &&
+                 r.ymax == rect.y + rect.height - 1;
+        });
+    ASSERT_TRUE(region != regions.end());
+    EXPECT_NEAR(processor.PolygonScoreAcc(contour, maps.pred),
+                region->scoreSum / region->area, 0.01);
+
+    float ssid;
+    auto box = processor.GetMiniBoxes(cv::minAreaRect(contour), ssid);
+    if (ssid < 3) continue;
+    EXPECT_NEAR(processor.BoxScoreFast(box, maps.pred),
+                processor.BoxScoreScan(box, pred.data(), c.stride, c.width,
+                                       c.height),
+                0.02);
+    ++compared;
+  }
+  EXPECT_GE(compared, c.rows * c.cols);
+}
+
+bool insideBox(const Box& inner, const Box& outer) {
+  int xmin = outer[0][0], xmax = xmin, ymin = outer[0][1], ymax = ymin;
+  for (const auto& point : outer) {
+    xmin = std::min(xmin, point[0]);
+    xmax = std::max(xmax, point[0]);
+    ymin = std::min(ymin, point[1]);
+    ymax = std::max(ymax, point[1]);
+  }
+  for (const auto& point : inner)
+    if (point[0] < xmin || point[0] > xmax || point[1] < ymin ||
+        point[1] > ymax)
+      return false;
+  return true;
+}
+
+// 带细长空洞的文本区域：原流程用RETR_LIST，空洞轮廓的框得分也能超过box_thresh，
+// 输出一个套在文本框内部的重复框；BoxesFromRegions只输出外轮廓的框
+TEST(PpocrDetBoxes, HoleDoesNotYieldNestedBox) {
+  const MapCase c = {96, 48, 96, 0, 0, 0};
+  std::vector<float> pred(c.stride * c.height, 0.05f);
+  for (int y = 12; y <= 35; ++y)
+    for (int x = 8; x <= 87; ++x) pred[y * c.stride + x] = 1.f;
+  // 两行高的空洞，概率略低于二值化阈值
+  for (int y = 23; y <= 24; ++y)
+    for (int x = 20; x <= 60; ++x) pred[y * c.stride + x] = 0.29f;
+  LegacyMaps maps = makeLegacyMaps(pred, c);
+
+  std::vector<std::vector<cv::Point>> contours;
+  cv::findContours(maps.bitmap, contours, cv::RETR_LIST,
+                   cv::CHAIN_APPROX_SIMPLE);
+  ASSERT_EQ(2u, contours.size());
+  RegionExtractor extractor;
+  std::vector<TextRegion> regions;
+  extractor.extract(pred.data(), c.stride, c.width, c.height,
+                    kReferenceThreshold, 3, 1000, regions);
+  ASSERT_EQ(1u, regions.size());
+
+  PostProcessor processor;
+  for (bool polygon : {false, true}) {
+    Boxes legacy = ordered(
+        processor,
+        processor.BoxesFromBitmap(maps.pred, maps.bitmap, kBoxThresh,
+                                  kUnclipRatio, polygon, c.width, c.height));
+    Boxes actual = ordered(
+        processor, processor.BoxesFromRegions(
+                       pred.data(), c.stride, c.width, c.height, regions,
+                       kBoxThresh, kUnclipRatio, polygon, c.width, c.height));
+    ASSERT_EQ(2u, legacy.size()) << polygon;
+    ASSERT_EQ(1u, actual.size()) << polygon;
+    // 外轮廓的框与原流程相同，原流程多出的框在其内部
+    int outer = maxCornerDistance(legacy[0], actual[0]) <=
+                        maxCornerDistance(legacy[1], actual[0])
+                    ? 0
+                    : 1;
+    EXPECT_LE(maxCornerDistance(legacy[outer], actual[0]), 4) << polygon;
+    EXPECT_TRUE(insideBox(legacy[1 - outer], actual[0])) << polygon;
+  }
+}
+
+}  // namespace
+}  // namespace ppocr_det
+}  // namespace element
+}  // namespace sophon_stream
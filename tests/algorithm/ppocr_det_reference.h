@@ -0,0 +1,141 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SOPHON_STREAM_TESTS_PPOCR_DET_REFERENCE_H_
+#define SOPHON_STREAM_TESTS_PPOCR_DET_REFERENCE_H_
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <utility>
+#include <vector>
+
+// RegionExtractor的对照实现和测试数据，只用于对比结果
+
+namespace sophon_stream {
+namespace element {
+namespace ppocr_det {
+
+// 与ppocr_det_post_process中min_score_thresh * 255相同
+const double kReferenceThreshold = 0.3 * 255;
+
+struct ReferenceRegion {
+  int area = 0;
+  double scoreSum = 0;
+  int xmin, xmax, ymin, ymax;
+};
+
+inline bool referenceForeground(float p, double threshold) {
+  return (unsigned char)(p * 255) > threshold;
+}
+
+/**
+ * @brief 逐像素8连通泛洪标记，区域按首个像素的光栅顺序编号
+ * @param labels 输出每个像素所属的区域，背景为-1，行间距为width
+ */
+inline std::vector<ReferenceRegion> referenceLabelRegions(
+    const float* pred, int stride, int width, int height, double threshold,
+    std::vector<int>& labels) {
+  std::vector<ReferenceRegion> regions;
+  labels.assign(static_cast<std::size_t>(width) * height, -1);
+  std::vector<std::pair<int, int>> stack;
+  for (int y = 0; y < height; ++y)
+    for (int x = 0; x < width; ++x) {
+      if (labels[y * width + x] >= 0 ||
+          !referenceForeground(pred[y * stride + x], threshold))
+        continue;
+      const int label = regions.size();
+      ReferenceRegion region;
+      region.xmin = region.xmax = x;
+      region.ymin = region.ymax = y;
+      labels[y * width + x] = label;
+      stack.assign(1, {x, y});
+      while (!stack.empty()) {
+        auto [cx, cy] = stack.back();
+        stack.pop_back();
+        ++region.area;
+        region.scoreSum += pred[cy * stride + cx];
+        region.xmin = std::min(region.xmin, cx);
+        region.xmax = std::max(region.xmax, cx);
+        region.ymin = std::min(region.ymin, cy);
+        region.ymax = std::max(region.ymax, cy);
+        for (int ny = cy - 1; ny <= cy + 1; ++ny)
+          for (int nx = cx - 1; nx <= cx + 1; ++nx) {
+            if (nx < 0 || ny < 0 || nx >= width || ny >= height) continue;
+            if (labels[ny * width + nx] >= 0 ||
+                !referenceForeground(pred[ny * stride + nx], threshold))
+              continue;
+            labels[ny * width + nx] = label;
+            stack.push_back({nx, ny});
+          }
+      }
+      regions.push_back(region);
+    }
+  return regions;
+}
+
+/**
+ * @brief 模拟DB概率图：网格中每格一条旋转的文本行，边缘有1-2像素的过渡带，
+ * 另加若干孤立噪点。文本行互不相交，区域内没有空洞
+ * @param stride 行间距，大于width时多出的列填充高概率值，不应被读到
+ */
+inline std::vector<float> makeTextMap(int width, int height, int stride,
+                                      int rows, int cols, int specks,
+                                      unsigned seed) {
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<float> uniform(0.f, 1.f);
+  std::vector<float> pred(static_cast<std::size_t>(stride) * height);
+  for (int y = 0; y < height; ++y)
+    for (int x = 0; x < stride; ++x)
+      pred[y * stride + x] = x < width ? uniform(rng) * 0.05f : 0.95f;
+
+  const float cellW = float(width) / cols, cellH = float(height) / rows;
+  for (int r = 0; r < rows; ++r)
+    for (int c = 0; c < cols; ++c) {
+      const float cx = (c + 0.5f) * cellW, cy = (r + 0.5f) * cellH;
+      const float angle = (uniform(rng) - 0.5f) * 0.5f;
+      const float cosA = std::cos(angle), sinA = std::sin(angle);
+      // 旋转并加上过渡带后仍留在格子内
+      const float halfH = 2.f + uniform(rng) * (cellH * 0.2f);
+      const float maxW =
+          std::min((cellW / 2 - 3 - halfH * std::fabs(sinA)) / cosA,
+                   (cellH / 2 - 3 - halfH * cosA) /
+                       std::max(std::fabs(sinA), 1e-3f));
+      const float halfW =
+          std::max(halfH, maxW * (0.5f + 0.5f * uniform(rng)));
+      for (int y = int(cy - cellH / 2); y < int(cy + cellH / 2); ++y)
+        for (int x = int(cx - cellW / 2); x < int(cx + cellW / 2); ++x) {
+          if (x < 0 || y < 0 || x >= width || y >= height) continue;
+          const float dx = x - cx, dy = y - cy;
+          const float u = std::fabs(dx * cosA + dy * sinA) - halfW;
+          const float v = std::fabs(-dx * sinA + dy * cosA) - halfH;
+          const float outside = std::max(u, v);
+          float p;
+          if (outside <= 0)
+            p = 0.8f + uniform(rng) * 0.2f;
+          else if (outside < 2)
+            p = 0.6f - outside * 0.25f;
+          else
+            continue;
+          float& dst = pred[y * stride + x];
+          dst = std::max(dst, p);
+        }
+    }
+  for (int i = 0; i < specks; ++i) {
+    int x = rng() % width, y = rng() % height;
+    pred[y * stride + x] = 0.9f;
+  }
+  return pred;
+}
+
+}  // namespace ppocr_det
+}  // namespace element
+}  // namespace sophon_stream
+
+#endif  // SOPHON_STREAM_TESTS_PPOCR_DET_REFERENCE_H_
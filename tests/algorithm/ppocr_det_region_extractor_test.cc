@@ -0,0 +1,241 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#include "ppocr_det_region_extractor.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "ppocr_det_reference.h"
+
+namespace sophon_stream {
+namespace element {
+namespace ppocr_det {
+namespace {
+
+using Hull = std::vector<RegionPoint>;
+
+long long cross(const RegionPoint& o, const RegionPoint& a,
+                const RegionPoint& b) {
+  return (long long)(a.x - o.x) * (b.y - o.y) -
+         (long long)(a.y - o.y) * (b.x - o.x);
+}
+
+// 单调链凸包，去掉共线点，从最小点开始逆时针
+Hull convexHull(std::vector<RegionPoint> points) {
+  std::sort(points.begin(), points.end(),
+            [](const RegionPoint& l, const RegionPoint& r) {
+              return l.x != r.x ? l.x < r.x : l.y < r.y;
+            });
+  points.erase(std::unique(points.begin(), points.end(),
+                           [](const RegionPoint& l, const RegionPoint& r) {
+                             return l.x == r.x && l.y == r.y;
+                           }),
+               points.end());
+  if (points.size() < 3) return points;
+  Hull hull(points.size() * 2);
+  std::size_t k = 0;
+  for (std::size_t i = 0; i < points.size(); ++i) {
+    while (k >= 2 && cross(hull[k - 2], hull[k - 1], points[i]) <= 0) --k;
+    hull[k++] = points[i];
+  }
+  for (std::size_t i = points.size() - 1, t = k + 1; i > 0; --i) {
+    while (k >= t && cross(hull[k - 2], hull[k - 1], points[i - 1]) <= 0) --k;
+    hull[k++] = points[i - 1];
+  }
+  hull.resize(k - 1);
+  return hull;
+}
+
+void expectSameRegions(const std::vector<ReferenceRegion>& expected,
+                       const std::vector<int>& labels, int width,
+                       const std::vector<TextRegion>& actual) {
+  ASSERT_EQ(expected.size(), actual.size());
+  for (std::size_t i = 0; i < expected.size(); ++i) {
+    EXPECT_EQ(expected[i].area, actual[i].area) << i;
+    EXPECT_NEAR(expected[i].scoreSum, actual[i].scoreSum, 1e-6) << i;
+    EXPECT_EQ(expected[i].xmin, actual[i].xmin) << i;
+    EXPECT_EQ(expected[i].xmax, actual[i].xmax) << i;
+    EXPECT_EQ(expected[i].ymin, actual[i].ymin) << i;
+    EXPECT_EQ(expected[i].ymax, actual[i].ymax) << i;
+    for (const RegionPoint& point : actual[i].points)
+      ASSERT_EQ(int(i), labels[point.y * width + point.x]) << i;
+  }
+}
+
+struct MapCase {
+  int width, height, stride, rows, cols, specks;
+};
+
+const MapCase kMapCases[] = {
+    {160, 96, 160, 4, 2, 0},
+    {320, 240, 336, 8, 3, 40},
+    {640, 640, 640, 24, 4, 200},
+    {257, 131, 264, 5, 5, 30},
+};
+
+// 连通域、像素数、概率和、外接框与逐像素泛洪标记一致，端点都属于所在区域
+TEST(RegionExtractor, MatchesFloodFillOnTextMaps) {
+  RegionExtractor extractor;
+  std::vector<TextRegion> regions;
+  unsigned seed = 1;
+  for (const auto& c : kMapCases) {
+    auto pred = makeTextMap(c.width, c.height, c.stride, c.rows, c.cols,
+                            c.specks, seed++);
+    std::vector<int> labels;
+    auto expected = referenceLabelRegions(pred.data(), c.stride, c.width,
+                                          c.height, kReferenceThreshold, labels);
+    extractor.extract(pred.data(), c.stride, c.width, c.height,
+                      kReferenceThreshold, 0, 100000, regions);
+    EXPECT_GE(expected.size(), std::size_t(c.rows * c.cols));
+    expectSameRegions(expected, labels, c.width, regions);
+  }
+}
+
+// 随机密度的噪声图：大量相互粘连、带空洞和对角连接的区域
+TEST(RegionExtractor, MatchesFloodFillOnNoise) {
+  RegionExtractor extractor;
+  std::vector<TextRegion> regions;
+  std::mt19937 rng(3);
+  std::uniform_real_distribution<float> uniform(0.f, 1.f);
+  for (int trial = 0; trial < 200; ++trial) {
+    const int width = 1 + rng() % 60, height = 1 + rng() % 60;
+    const int stride = width + rng() % 5;
+    const float density = uniform(rng);
+    std::vector<float> pred(stride * height);
+    for (auto& p : pred)
+      p = uniform(rng) < density ? 0.5f + 0.5f * uniform(rng)
+                                 : 0.2f * uniform(rng);
+    std::vector<int> labels;
+    auto expected = referenceLabelRegions(pred.data(), stride, width, height,
+                                          kReferenceThreshold, labels);
+    extractor.extract(pred.data(), stride, width, height, kReferenceThreshold,
+                      0, 100000, regions);
+    expectSameRegions(expected, labels, width, regions);
+    if (HasFatalFailure()) return;
+  }
+}
+
+// 游程端点的凸包等于区域全部像素的凸包，即findContours外轮廓的凸包，
+// 所以minAreaRect的结果相同
+TEST(RegionExtractor, EndpointHullEqualsRegionHull) {
+  RegionExtractor extractor;
+  std::vector<TextRegion> regions;
+  unsigned seed = 10;
+  for (const auto& c : kMapCases) {
+    auto pred = makeTextMap(c.width, c.height, c.stride, c.rows, c.cols,
+                            c.specks, seed++);
+    std::vector<int> labels;
+    auto expected = referenceLabelRegions(pred.data(), c.stride, c.width,
+                                          c.height, kReferenceThreshold, labels);
+    extractor.extract(pred.data(), c.stride, c.width, c.height,
+                      kReferenceThreshold, 0, 100000, regions);
+    ASSERT_EQ(expected.size(), regions.size());
+
+    std::vector<std::vector<RegionPoint>> pixels(expected.size());
+    for (int y = 0; y < c.height; ++y)
+      for (int x = 0; x < c.width; ++x)
+        if (labels[y * c.width + x] >= 0)
+          pixels[labels[y * c.width + x]].push_back({x, y});
+    for (std::size_t i = 0; i < regions.size(); ++i) {
+      // 端点数远少于像素数
+      EXPECT_LE(regions[i].points.size(), pixels[i].size());
+      Hull want = convexHull(pixels[i]);
+      Hull got = convexHull(regions[i].points);
+      ASSERT_EQ(want.size(), got.size()) << i;
+      for (std::size_t k = 0; k < want.size(); ++k) {
+        EXPECT_EQ(want[k].x, got[k].x) << i;
+        EXPECT_EQ(want[k].y, got[k].y) << i;
+      }
+    }
+  }
+}
+
+// minSize按外接框提前跳过的区域，最小外接矩形的短边必然小于minSize；
+// maxCandidates在跳过之后计数
+TEST(RegionExtractor, SkipsSmallRegionsAndLimitsCandidates) {
+  const auto& c = kMapCases[2];
+  auto pred = makeTextMap(c.width, c.height, c.stride, c.rows, c.cols,
+                          c.specks, 20);
+  std::vector<int> labels;
+  auto all = referenceLabelRegions(pred.data(), c.stride, c.width, c.height,
+                                   kReferenceThreshold, labels);
+  std::vector<ReferenceRegion> large;
+  for (const auto& region : all)
+    if (std::min(region.xmax - region.xmin, region.ymax - region.ymin) *
+            std::sqrt(2.f) >=
+        3)
+      large.push_back(region);
+  // 噪点被跳过，文本行都保留
+  EXPECT_LT(large.size(), all.size());
+  EXPECT_GE(large.size(), std::size_t(c.rows * c.cols));
+
+  RegionExtractor extractor;
+  std::vector<TextRegion> regions;
+  extractor.extract(pred.data(), c.stride, c.width, c.height,
+                    kReferenceThreshold, 3, 100000, regions);
+  ASSERT_EQ(large.size(), regions.size());
+  for (std::size_t i = 0; i < large.size(); ++i) {
+    EXPECT_EQ(large[i].area, regions[i].area);
+    EXPECT_EQ(large[i].xmin, regions[i].xmin);
+    EXPECT_EQ(large[i].ymin, regions[i].ymin);
+  }
+
+  extractor.extract(pred.data(), c.stride, c.width, c.height,
+                    kReferenceThreshold, 3, 10, regions);
+  ASSERT_EQ(10u, regions.size());
+  for (std::size_t i = 0; i < regions.size(); ++i) {
+    EXPECT_EQ(large[i].area, regions[i].area);
+    EXPECT_EQ(large[i].xmin, regions[i].xmin);
+    EXPECT_EQ(large[i].ymin, regions[i].ymin);
+  }
+}
+
+// 环形区域只输出一个外轮廓区域，空洞不单独成为区域；空洞内的孤岛是独立的区域。
+// 原流程用RETR_LIST时空洞轮廓也会生成一个套在文本框内部的框
+TEST(RegionExtractor, RingYieldsOuterRegionOnly) {
+  const int width = 48, height = 40, stride = 48;
+  std::vector<float> pred(stride * height, 0.05f);
+  auto fill = [&](int x0, int y0, int x1, int y1, float p) {
+    for (int y = y0; y <= y1; ++y)
+      for (int x = x0; x <= x1; ++x) pred[y * stride + x] = p;
+  };
+  // 外框[4,43]x[4,35]，空洞[10,37]x[10,29]，孤岛[20,27]x[18,21]
+  fill(4, 4, 43, 35, 0.9f);
+  fill(10, 10, 37, 29, 0.05f);
+  fill(20, 18, 27, 21, 0.8f);
+
+  std::vector<int> labels;
+  auto expected = referenceLabelRegions(pred.data(), stride, width, height,
+                                        kReferenceThreshold, labels);
+  ASSERT_EQ(2u, expected.size());
+  RegionExtractor extractor;
+  std::vector<TextRegion> regions;
+  extractor.extract(pred.data(), stride, width, height, kReferenceThreshold,
+                    3, 1000, regions);
+  expectSameRegions(expected, labels, width, regions);
+  ASSERT_EQ(2u, regions.size());
+  EXPECT_EQ(40 * 32 - 28 * 20, regions[0].area);
+  EXPECT_EQ(4, regions[0].xmin);
+  EXPECT_EQ(43, regions[0].xmax);
+  EXPECT_EQ(4, regions[0].ymin);
+  EXPECT_EQ(35, regions[0].ymax);
+  EXPECT_EQ(8 * 4, regions[1].area);
+  EXPECT_EQ(20, regions[1].xmin);
+  EXPECT_EQ(18, regions[1].ymin);
+}
+
+}  // namespace
+}  // namespace ppocr_det
+}  // namespace element
+}  // namespace sophon_stream
@@ -0,0 +1,211 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#include "resnet_heads.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include "resnet_reference.h"
+
+namespace sophon_stream {
+namespace element {
+namespace resnet {
+namespace {
+
+// batch行logits，行宽stride，前classNum个数互不相同且间隔至少0.01，
+// 两种实现的舍入误差不会改变类别的先后顺序
+std::vector<float> makeLogits(int batch, int classNum, int stride,
+                              unsigned seed) {
+  std::mt19937 rng(seed);
+  std::vector<float> logits(static_cast<std::size_t>(batch) * stride, 1e3f);
+  std::vector<int> order(classNum);
+  for (int i = 0; i < batch; ++i) {
+    std::iota(order.begin(), order.end(), 0);
+    std::shuffle(order.begin(), order.end(), rng);
+    for (int j = 0; j < classNum; ++j)
+      logits[i * stride + j] = order[j] * 0.01f - classNum * 0.005f;
+  }
+  return logits;
+}
+
+struct Shape {
+  int batch, classNum, stride;
+  float scale;
+};
+
+// 类别数覆盖SIMD主循环之后的尾部，stride大于classNum时行尾的填充不参与计算
+const Shape kShapes[] = {
+    {1, 1, 1, 1.f},    {4, 3, 3, 1.f},         {8, 5, 8, 0.5f},
+    {16, 10, 10, 2.f}, {32, 1000, 1001, 1.f}, {3, 1003, 1003, 0.0625f},
+};
+
+TEST(ResNetHeads, TopOneMatchesLegacy) {
+  ResNetHeads heads;
+  unsigned seed = 1;
+  for (const auto& s : kShapes) {
+    auto logits = makeLogits(s.batch, s.classNum, s.stride, seed++);
+    std::vector<int> labels(s.batch);
+    std::vector<float> scores(s.batch);
+    heads.softmaxTopK(logits.data(), s.batch, s.classNum, s.stride, s.scale,
+                      1, labels.data(), scores.data());
+    for (int i = 0; i < s.batch; ++i) {
+      float expectedScore;
+      int expected = referenceClassify(&logits[i * s.stride], s.classNum,
+                                       s.scale, &expectedScore);
+      EXPECT_EQ(expected, labels[i]) << s.classNum << " row " << i;
+      EXPECT_NEAR(expectedScore, scores[i], 1e-6f);
+    }
+  }
+}
+
+TEST(ResNetHeads, TopKMatchesSortedLegacyScores) {
+  ResNetHeads heads;
+  unsigned seed = 100;
+  for (const auto& s : kShapes) {
+    auto logits = makeLogits(s.batch, s.classNum, s.stride, seed++);
+    for (int k : {2, 5}) {
+      int kk = std::min(k, s.classNum);
+      std::vector<int> labels(s.batch * kk);
+      std::vector<float> scores(s.batch * kk);
+      heads.softmaxTopK(logits.data(), s.batch, s.classNum, s.stride, s.scale,
+                        k, labels.data(), scores.data());
+      for (int i = 0; i < s.batch; ++i) {
+        auto legacy = referenceSoftmax(&logits[i * s.stride], s.classNum,
+                                       s.scale);
+        std::vector<int> order(s.classNum);
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&](int l, int r) {
+          return legacy[l] > legacy[r];
+        });
+        for (int j = 0; j < kk; ++j) {
+          EXPECT_EQ(order[j], labels[i * kk + j]) << s.classNum << " k " << k;
+          EXPECT_NEAR(legacy[order[j]], scores[i * kk + j], 1e-6f);
+        }
+      }
+    }
+  }
+}
+
+// 得分相同时类别小的在前，top-1与原实现的严格比较一致
+TEST(ResNetHeads, TiesKeepClassOrder) {
+  const float row[] = {1, 3, 2, 3, 0, 3, 2};
+  ResNetHeads heads;
+  int labels[4];
+  float scores[4];
+  heads.softmaxTopK(row, 1, 7, 7, 1.f, 4, labels, scores);
+  EXPECT_EQ(std::vector<int>({1, 3, 5, 2}),
+            std::vector<int>(labels, labels + 4));
+  EXPECT_EQ(scores[0], scores[1]);
+  EXPECT_EQ(scores[1], scores[2]);
+  EXPECT_GT(scores[2], scores[3]);
+
+  float expectedScore;
+  heads.softmaxTopK(row, 1, 7, 7, 1.f, 1, labels, scores);
+  EXPECT_EQ(referenceClassify(row, 7, 1.f, &expectedScore), labels[0]);
+  EXPECT_EQ(1, labels[0]);
+  EXPECT_NEAR(expectedScore, scores[0], 1e-6f);
+
+  // 全部相同
+  const float flat[] = {0.5f, 0.5f, 0.5f, 0.5f, 0.5f};
+  heads.softmaxTopK(flat, 1, 5, 5, 1.f, 3, labels, scores);
+  EXPECT_EQ(std::vector<int>({0, 1, 2}),
+            std::vector<int>(labels, labels + 3));
+  EXPECT_FLOAT_EQ(0.2f, scores[0]);
+}
+
+TEST(ResNetHeads, ThresholdMatchesLegacy) {
+  ResNetHeads heads;
+  std::mt19937 rng(7);
+  std::uniform_real_distribution<float> uniform(0.f, 0.2f);
+  unsigned seed = 200;
+  for (const auto& s : kShapes) {
+    auto logits = makeLogits(s.batch, s.classNum, s.stride, seed++);
+    std::vector<float> thresh(s.classNum);
+    for (auto& t : thresh) t = uniform(rng) / s.classNum;
+    std::vector<float> scores(s.batch * s.classNum);
+    std::vector<int> labels(s.batch * s.classNum);
+    heads.softmaxThreshold(logits.data(), s.batch, s.classNum, s.stride,
+                           s.scale, thresh.data(), scores.data(),
+                           labels.data());
+    std::vector<float> legacyScores;
+    std::vector<int> legacyLabels;
+    for (int i = 0; i < s.batch; ++i) {
+      referenceMultiLabel(&logits[i * s.stride], s.classNum, s.scale, thresh,
+                          legacyScores, legacyLabels);
+      for (int j = 0; j < s.classNum; ++j) {
+        float score = scores[i * s.classNum + j];
+        EXPECT_NEAR(legacyScores[j], score, 1e-6f);
+        // 与阈值几乎相等的得分两种实现的舍入可能不同
+        if (std::fabs(legacyScores[j] - thresh[j]) > 1e-6f) {
+          EXPECT_EQ(legacyLabels[j], labels[i * s.classNum + j]);
+        }
+      }
+    }
+  }
+}
+
+// 阈值不小于1时没有类别能通过，所有标签为0，得分照常输出
+TEST(ResNetHeads, ThresholdNoClassPasses) {
+  const int batch = 3, classNum = 6;
+  auto logits = makeLogits(batch, classNum, classNum, 9);
+  std::vector<float> thresh(classNum, 1.f);
+  std::vector<float> scores(batch * classNum);
+  std::vector<int> labels(batch * classNum, -1);
+  ResNetHeads heads;
+  heads.softmaxThreshold(logits.data(), batch, classNum, classNum, 1.f,
+                         thresh.data(), scores.data(), labels.data());
+  EXPECT_EQ(std::vector<int>(batch * classNum, 0), labels);
+  for (int i = 0; i < batch; ++i) {
+    float sum = 0;
+    for (int j = 0; j < classNum; ++j) sum += scores[i * classNum + j];
+    EXPECT_NEAR(1.f, sum, 1e-5f);
+  }
+}
+
+TEST(ResNetHeads, L2Normalize) {
+  std::mt19937 rng(11);
+  std::uniform_real_distribution<float> uniform(-1.f, 1.f);
+  for (int dim : {1, 3, 4, 5, 512, 513}) {
+    const int batch = 3;
+    std::vector<float> src(batch * dim);
+    for (auto& v : src) v = uniform(rng);
+    // 第二行为零向量
+    std::fill(src.begin() + dim, src.begin() + 2 * dim, 0.f);
+    std::vector<float> dst(batch * dim, -1.f);
+    ResNetHeads::l2Normalize(src.data(), batch, dim, dst.data());
+    for (int i = 0; i < batch; ++i) {
+      double norm = 0;
+      for (int j = 0; j < dim; ++j)
+        norm += double(src[i * dim + j]) * src[i * dim + j];
+      norm = std::sqrt(norm);
+      for (int j = 0; j < dim; ++j) {
+        float value = dst[i * dim + j];
+        ASSERT_FALSE(std::isnan(value)) << dim << " row " << i;
+        float expected = norm > 0 ? float(src[i * dim + j] / norm) : 0.f;
+        EXPECT_NEAR(expected, value, 1e-6f) << dim << " row " << i;
+      }
+    }
+
+    // 原地归一化结果相同
+    std::vector<float> inPlace = src;
+    ResNetHeads::l2Normalize(inPlace.data(), batch, dim, inPlace.data());
+    EXPECT_EQ(dst, inPlace);
+  }
+}
+
+}  // namespace
+}  // namespace resnet
+}  // namespace element
+}  // namespace sophon_stream
@@ -0,0 +1,88 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SOPHON_STREAM_TESTS_RESNET_REFERENCE_H_
+#define SOPHON_STREAM_TESTS_RESNET_REFERENCE_H_
+
+#include <cmath>
+#include <vector>
+
+// 改为ResNetHeads之前ResNetMultiTask中逐个目标的后处理：
+// 每个目标先求exp的和，再对每个类别重新求exp，只用于对比结果
+
+namespace sophon_stream {
+namespace element {
+namespace resnet {
+
+/**
+ * @brief post_process_classfy的一行，返回得分最高的类别
+ */
+inline int referenceClassify(const float* output_data, int class_num,
+                             float output_scale, float* max_score_out) {
+  float exp_sum = 0;
+  for (int j = 0; j < class_num; j++) {
+    exp_sum += std::exp(*(output_data + j) * output_scale);
+  }
+  int max_idx = -1;
+  float max_score = -1;
+  for (int j = 0; j < class_num; j++) {
+    float score = 0;
+    score = std::exp(*(output_data + j) * output_scale) / exp_sum;
+    if (max_score < score) {
+      max_score = score;
+      max_idx = j;
+    }
+  }
+  *max_score_out = max_score;
+  return max_idx;
+}
+
+/**
+ * @brief post_process_classfy的softmax得分，用于构造top-K的期望结果
+ */
+inline std::vector<float> referenceSoftmax(const float* output_data,
+                                           int class_num, float output_scale) {
+  float exp_sum = 0;
+  for (int j = 0; j < class_num; j++) {
+    exp_sum += std::exp(*(output_data + j) * output_scale);
+  }
+  std::vector<float> scores(class_num);
+  for (int j = 0; j < class_num; j++) {
+    scores[j] = std::exp(*(output_data + j) * output_scale) / exp_sum;
+  }
+  return scores;
+}
+
+/**
+ * @brief post_process_multilabel的一行
+ */
+inline void referenceMultiLabel(const float* output_data, int class_num,
+                                float output_scale,
+                                const std::vector<float>& class_thresh,
+                                std::vector<float>& scores,
+                                std::vector<int>& labels) {
+  scores.clear();
+  labels.clear();
+  float exp_sum = 0;
+  for (int j = 0; j < class_num; j++) {
+    exp_sum += std::exp(*(output_data + j) * output_scale);
+  }
+  for (int j = 0; j < class_num; j++) {
+    float score = 0;
+    score = std::exp(*(output_data + j) * output_scale) / exp_sum;
+    scores.push_back(score);
+    labels.push_back((score > class_thresh[j]) ? 1 : 0);
+  }
+}
+
+}  // namespace resnet
+}  // namespace element
+}  // namespace sophon_stream
+
+#endif  // SOPHON_STREAM_TESTS_RESNET_REFERENCE_H_
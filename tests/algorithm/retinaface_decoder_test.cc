@@ -0,0 +1,112 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#include "retinaface_decoder.h"
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <vector>
+
+#include "retinaface_reference.h"
+
+namespace sophon_stream {
+namespace element {
+namespace retinaface {
+namespace {
+
+struct Outputs {
+  std::vector<float> cls, loc, land;
+};
+
+// 约keep比例的先验框置信度高于0.5
+Outputs randomOutputs(std::size_t numPriors, double keep, unsigned seed) {
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<float> uniform(0.f, 1.f), offset(-1.f, 1.f);
+  Outputs outputs;
+  outputs.cls.resize(numPriors * 2);
+  outputs.loc.resize(numPriors * 4);
+  outputs.land.resize(numPriors * 10);
+  for (std::size_t i = 0; i < numPriors; ++i) {
+    float score = uniform(rng) < keep ? 0.5f + uniform(rng) * 0.5f
+                                      : uniform(rng) * 0.5f;
+    outputs.cls[i * 2] = 1.f - score;
+    outputs.cls[i * 2 + 1] = score;
+  }
+  for (auto& v : outputs.loc) v = offset(rng);
+  for (auto& v : outputs.land) v = offset(rng);
+  return outputs;
+}
+
+TEST(RetinafaceDecoder, PriorCountMatchesFeatureMaps) {
+  // (80 * 80 + 40 * 40 + 20 * 20) * 2
+  EXPECT_EQ(16800u, buildRetinafacePriors(640, 640).size());
+  // 宽度向上取整：ceil(100 / 8) = 13, ceil(100 / 16) = 7, ceil(100 / 32) = 4
+  EXPECT_EQ((13 * 8 + 7 * 4 + 4 * 2) * 2u,
+            buildRetinafacePriors(100, 64).size());
+}
+
+TEST(RetinafaceDecoder, MatchesReferenceAt640) {
+  auto priors = buildRetinafacePriors(640, 640);
+  for (double keep : {0.0, 0.01, 0.2}) {
+    Outputs outputs = randomOutputs(priors.size(), keep, 7);
+    std::vector<FaceDetectInfo> expected, actual;
+    referenceDecodeFaces(outputs.cls.data(), outputs.loc.data(),
+                         outputs.land.data(), 0.5f, 640, 640, 0.75f, expected);
+    decodeRetinafaceFaces(priors, outputs.cls.data(), outputs.loc.data(),
+                          outputs.land.data(), 0.5f, 640, 640, 0.75f, actual);
+    ASSERT_EQ(expected.size(), actual.size()) << keep;
+    for (std::size_t i = 0; i < expected.size(); ++i) {
+      EXPECT_EQ(expected[i].score, actual[i].score);
+      EXPECT_FLOAT_EQ(expected[i].rect.x1, actual[i].rect.x1);
+      EXPECT_FLOAT_EQ(expected[i].rect.y1, actual[i].rect.y1);
+      EXPECT_FLOAT_EQ(expected[i].rect.x2, actual[i].rect.x2);
+      EXPECT_FLOAT_EQ(expected[i].rect.y2, actual[i].rect.y2);
+      for (int k = 0; k < 5; ++k) {
+        EXPECT_FLOAT_EQ(expected[i].pts.x[k], actual[i].pts.x[k]);
+        EXPECT_FLOAT_EQ(expected[i].pts.y[k], actual[i].pts.y[k]);
+      }
+    }
+  }
+}
+
+// 旧代码固定按640映射，其他输入尺寸的框会被放大640 / net_w倍
+TEST(RetinafaceDecoder, MapsWithNetworkSize) {
+  const int netW = 320, netH = 480;
+  auto priors = buildRetinafacePriors(netW, netH);
+  Outputs outputs = randomOutputs(priors.size(), 0.0, 1);
+  std::fill(outputs.loc.begin(), outputs.loc.end(), 0.f);
+  std::fill(outputs.land.begin(), outputs.land.end(), 0.f);
+  // 第一层(2, 3)处的第一个先验框：中心(20, 28)，边长16
+  const int index = (3 * (netW / 8) + 2) * 2;
+  outputs.cls[index * 2 + 1] = 0.9f;
+
+  std::vector<FaceDetectInfo> faces;
+  decodeRetinafaceFaces(priors, outputs.cls.data(), outputs.loc.data(),
+                        outputs.land.data(), 0.5f, netW, netH, 0.5f, faces);
+  ASSERT_EQ(1u, faces.size());
+  EXPECT_FLOAT_EQ(0.9f, faces[0].score);
+  EXPECT_FLOAT_EQ(24.f, faces[0].rect.x1);
+  EXPECT_FLOAT_EQ(56.f, faces[0].rect.x2);
+  EXPECT_FLOAT_EQ(40.f, faces[0].rect.y1);
+  EXPECT_FLOAT_EQ(72.f, faces[0].rect.y2);
+  EXPECT_FLOAT_EQ(40.f, faces[0].pts.x[0]);
+  EXPECT_FLOAT_EQ(56.f, faces[0].pts.y[4]);
+
+  std::vector<FaceDetectInfo> legacy;
+  referenceDecodeFaces(outputs.cls.data(), outputs.loc.data(),
+                       outputs.land.data(), 0.5f, netW, netH, 0.5f, legacy);
+  ASSERT_EQ(1u, legacy.size());
+  EXPECT_FLOAT_EQ(80.f, legacy[0].pts.x[0]);
+}
+
+}  // namespace
+}  // namespace retinaface
+}  // namespace element
+}  // namespace sophon_stream
@@ -0,0 +1,88 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SOPHON_STREAM_TESTS_RETINAFACE_REFERENCE_H_
+#define SOPHON_STREAM_TESTS_RETINAFACE_REFERENCE_H_
+
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#include "retinaface_decoder.h"
+
+namespace sophon_stream {
+namespace element {
+namespace retinaface {
+
+/**
+ * @brief 改为缓存先验框之前get_faceInfo中的解码循环，不含NMS，
+ * 只用于对比结果和性能。归一化坐标按640映射，ws、hs为网络输入尺寸
+ */
+inline void referenceDecodeFaces(const float* cls_data, const float* loc_data,
+                                 const float* land_data, float threshold,
+                                 int ws, int hs, float ratio_,
+                                 std::vector<FaceDetectInfo>& faceInfo) {
+  const int num_layer = 3;
+  const size_t steps[] = {8, 16, 32};
+  const int num_anchor = 2;
+  const size_t anchor_sizes[][2] = {{16, 32}, {64, 128}, {256, 512}};
+  const float variances[] = {0.1, 0.2};
+
+  size_t index = 0, min_size;
+  const float *loc, *land;
+  float x, y, w, h, conf;
+  float anchor_w, anchor_h, anchor_x, anchor_y;
+
+  FaceDetectInfo obj;
+  for (int il = 0; il < num_layer; ++il) {
+    int feature_width = (ws + steps[il] - 1) / steps[il];
+    int feature_height = (hs + steps[il] - 1) / steps[il];
+    for (int iy = 0; iy < feature_height; ++iy) {
+      for (int ix = 0; ix < feature_width; ++ix) {
+        for (int ia = 0; ia < num_anchor; ++ia) {
+          conf = cls_data[index * 2 + 1];
+          if (conf < threshold) goto cond;
+          min_size = anchor_sizes[il][ia];
+          anchor_x = (ix + 0.5) * steps[il] / ws;
+          anchor_y = (iy + 0.5) * steps[il] / hs;
+          anchor_w = min_size * 1. / ws;
+          anchor_h = min_size * 1. / hs;
+          obj.score = conf;
+          loc = loc_data + index * 4;
+          w = std::exp(loc[2] * variances[1]) * anchor_w;
+          h = std::exp(loc[3] * variances[1]) * anchor_h;
+          x = anchor_x + loc[0] * variances[0] * anchor_w;
+          y = anchor_y + loc[1] * variances[0] * anchor_h;
+          obj.rect.x1 = (x - w / 2) * 640 / ratio_;
+          obj.rect.x2 = (x + w / 2) * 640 / ratio_;
+          obj.rect.y1 = (y - h / 2) * 640 / ratio_;
+          obj.rect.y2 = (y + h / 2) * 640 / ratio_;
+          land = land_data + index * 10;
+          for (int i = 0; i < 5; ++i) {
+            obj.pts.x[i] =
+                (anchor_x + land[i * 2] * variances[0] * anchor_w) * 640 /
+                ratio_;
+            obj.pts.y[i] =
+                (anchor_y + land[i * 2 + 1] * variances[0] * anchor_h) * 640 /
+                ratio_;
+          }
+          faceInfo.push_back(obj);
+        cond:
+          ++index;
+        }
+      }
+    }
+  }
+}
+
+}  // namespace retinaface
+}  // namespace element
+}  // namespace sophon_stream
+
+#endif  // SOPHON_STREAM_TESTS_RETINAFACE_REFERENCE_H_
@@ -0,0 +1,152 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SOPHON_STREAM_TESTS_YOLOV8_OBB_REFERENCE_H_
+#define SOPHON_STREAM_TESTS_YOLOV8_OBB_REFERENCE_H_
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <random>
+#include <tuple>
+#include <vector>
+
+#include "yolov8_rotated_nms.h"
+
+// 改为RotatedNms之前Yolov8PostProcess中的旋转框NMS，只用于对比结果和性能
+
+namespace sophon_stream {
+namespace element {
+namespace yolov8 {
+
+inline std::tuple<float, float, float> referenceConvarianceMatrix(
+    const obbBox& obb) {
+  float w = obb.w;
+  float h = obb.h;
+  float r = obb.angle;
+  float a = w * w / 12.0;
+  float b = h * h / 12.0;
+  float cos_r = std::cos(r);
+  float sin_r = std::sin(r);
+  float a_val = a * cos_r * cos_r + b * sin_r * sin_r;
+  float b_val = a * sin_r * sin_r + b * cos_r * cos_r;
+  float c_val = (a - b) * cos_r * sin_r;
+  return std::make_tuple(a_val, b_val, c_val);
+}
+
+inline float referenceProbiou(const obbBox& obb1, const obbBox& obb2,
+                              float eps = 1e-7) {
+  float a1, b1, c1, a2, b2, c2;
+  std::tie(a1, b1, c1) = referenceConvarianceMatrix(obb1);
+  std::tie(a2, b2, c2) = referenceConvarianceMatrix(obb2);
+  float x1 = obb1.x, y1 = obb1.y;
+  float x2 = obb2.x, y2 = obb2.y;
+  float t1 = ((a1 + a2) * std::pow(y1 - y2, 2) + (b1 + b2) * std::pow(x1 - x2, 2)) / ((a1 + a2) * (b1 + b2) - std::pow(c1 + c2, 2) + eps);
+  float t2 = ((c1 + c2) * (x2 - x1) * (y1 - y2)) / ((a1 + a2) * (b1 + b2) - std::pow(c1 + c2, 2) + eps);
+  float t3 = std::log(((a1 + a2) * (b1 + b2) - std::pow(c1 + c2, 2)) / (4 * std::sqrt(std::max(a1 * b1 - c1 * c1, 0.0f)) * std::sqrt(std::max(a2 * b2 - c2 * c2, 0.0f)) + eps) + eps);
+  float bd = 0.25 * t1 + 0.5 * t2 + 0.5 * t3;
+  bd = std::max(std::min(bd, 100.0f), eps);
+  float hd = std::sqrt(1.0 - std::exp(-bd) + eps);
+  return 1 - hd;
+}
+
+inline void referenceNmsRotated(obbBoxVec& dets, float nmsConfidence) {
+  int length = dets.size();
+  int index = length - 1;
+
+  std::sort(dets.begin(), dets.end(),
+            [](const obbBox& a, const obbBox& b) { return a.score < b.score; });
+
+  while (index > 0) {
+    int i = 0;
+    while (i < index) {
+      float iou = referenceProbiou(dets[index], dets[i]);
+      if (iou >= nmsConfidence) {
+        dets.erase(dets.begin() + i);
+        index--;
+      } else {
+        i++;
+      }
+    }
+    index--;
+  }
+}
+
+/**
+ * @brief 原后处理中的完整流程：按类别偏移坐标，NMS，保留max_det个，再去掉偏移
+ * @param offset 为false时不偏移，用于与RotatedNms在相同输入上逐位对比
+ */
+inline obbBoxVec referenceObbNms(obbBoxVec dets, float threshold, int maxDet,
+                                 bool offset = true) {
+  int max_wh = 7680;
+  if (offset)
+    for (auto& box : dets) {
+      box.x += box.class_id * max_wh;
+      box.y += box.class_id * max_wh;
+    }
+  referenceNmsRotated(dets, threshold);
+  if ((int)dets.size() > maxDet)
+    dets.erase(dets.begin(), dets.begin() + (dets.size() - maxDet));
+  if (offset)
+    for (auto& box : dets) {
+      box.x -= box.class_id * max_wh;
+      box.y -= box.class_id * max_wh;
+    }
+  return dets;
+}
+
+/**
+ * @brief 模拟航拍场景的候选框：成簇的旋转框，少量框换成别的类别、
+ * 极小的框和长宽比很大的框；得分互不相同
+ */
+inline obbBoxVec makeAerialBoxes(int num, int classes, unsigned seed) {
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<float> uniform(0.f, 1.f);
+  int numClusters = std::max(num / 8, 1);
+  obbBoxVec clusters(numClusters);
+  for (auto& c : clusters) {
+    c.x = uniform(rng) * 1024;
+    c.y = uniform(rng) * 1024;
+    c.w = 4 + uniform(rng) * 40;
+    c.h = 2 + uniform(rng) * 20;
+    c.angle = uniform(rng) * 3.2f - 0.5f;
+    c.class_id = rng() % classes;
+  }
+  std::vector<int> ranks(num);
+  std::iota(ranks.begin(), ranks.end(), 1);
+  std::shuffle(ranks.begin(), ranks.end(), rng);
+
+  obbBoxVec boxes;
+  for (int i = 0; i < num; ++i) {
+    obbBox box = clusters[rng() % numClusters];
+    box.x += (uniform(rng) - 0.5f) * box.w * 0.6f;
+    box.y += (uniform(rng) - 0.5f) * box.h * 0.6f;
+    box.w *= 0.8f + 0.4f * uniform(rng);
+    box.h *= 0.8f + 0.4f * uniform(rng);
+    box.angle += (uniform(rng) - 0.5f) * 0.3f;
+    if (uniform(rng) < 0.1f) box.class_id = rng() % classes;
+    if (i % 97 == 0) {
+      box.w = 0.5f;
+      box.h = 0.3f;
+    }
+    if (i % 89 == 0) {
+      box.w = 500;
+      box.h = 2;
+    }
+    box.score = static_cast<float>(ranks[i]) / (num + 1);
+    boxes.push_back(box);
+  }
+  return boxes;
+}
+
+}  // namespace yolov8
+}  // namespace element
+}  // namespace sophon_stream
+
+#endif  // SOPHON_STREAM_TESTS_YOLOV8_OBB_REFERENCE_H_
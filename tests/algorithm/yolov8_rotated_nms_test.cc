@@ -0,0 +1,141 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#include "yolov8_rotated_nms.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "yolov8_obb_reference.h"
+
+namespace sophon_stream {
+namespace element {
+namespace yolov8 {
+namespace {
+
+void sortByScore(obbBoxVec& boxes) {
+  std::sort(boxes.begin(), boxes.end(),
+            [](const obbBox& l, const obbBox& r) { return l.score < r.score; });
+}
+
+struct Case {
+  int num;
+  int classes;
+  float threshold;
+  int maxDet;
+};
+
+const Case kCases[] = {
+    {400, 1, 0.5f, 300},  {800, 1, 0.3f, 50},   {800, 1, 0.7f, 300},
+    {1200, 5, 0.5f, 300}, {1200, 15, 0.3f, 300}, {1500, 15, 0.7f, 50},
+};
+
+// 输入相同时（都带类别偏移），保留的框与逐对计算probiou的原实现完全一致
+TEST(RotatedNms, MatchesReferenceOnSameInput) {
+  RotatedNms nms;
+  unsigned seed = 1;
+  for (const auto& c : kCases) {
+    obbBoxVec boxes = makeAerialBoxes(c.num, c.classes, seed++);
+    for (auto& box : boxes) {
+      box.x += box.class_id * 7680;
+      box.y += box.class_id * 7680;
+    }
+    obbBoxVec expected = referenceObbNms(boxes, c.threshold, c.maxDet, false);
+    obbBoxVec actual = boxes;
+    nms.run(actual, c.threshold, RotatedNms::IouType::ProbIou, c.maxDet, -1);
+
+    // 两者都按得分从低到高输出
+    ASSERT_EQ(expected.size(), actual.size()) << c.num << " " << c.threshold;
+    EXPECT_LT(expected.size(), boxes.size());
+    for (std::size_t i = 0; i < expected.size(); ++i) {
+      EXPECT_EQ(expected[i].score, actual[i].score) << i;
+      EXPECT_EQ(expected[i].class_id, actual[i].class_id);
+      EXPECT_EQ(expected[i].x, actual[i].x);
+      EXPECT_EQ(expected[i].y, actual[i].y);
+    }
+  }
+}
+
+// 端到端：原流程按类别偏移坐标，RotatedNms按类别分组，保留的框相同，
+// 坐标只差偏移带来的舍入
+TEST(RotatedNms, MatchesReferencePostProcess) {
+  RotatedNms nms;
+  unsigned seed = 100;
+  for (const auto& c : kCases) {
+    obbBoxVec boxes = makeAerialBoxes(c.num, c.classes, seed++);
+    obbBoxVec expected = referenceObbNms(boxes, c.threshold, c.maxDet);
+    obbBoxVec actual = boxes;
+    nms.run(actual, c.threshold, RotatedNms::IouType::ProbIou, c.maxDet, -1);
+    ASSERT_EQ(expected.size(), actual.size()) << c.num << " " << c.threshold;
+    for (std::size_t i = 0; i < expected.size(); ++i) {
+      EXPECT_EQ(expected[i].score, actual[i].score) << i;
+      EXPECT_EQ(expected[i].class_id, actual[i].class_id);
+      EXPECT_NEAR(expected[i].x, actual[i].x, 0.01f);
+      EXPECT_NEAR(expected[i].y, actual[i].y, 0.01f);
+    }
+  }
+}
+
+TEST(RotatedNms, PreTopkEqualsNmsOnTopCandidates) {
+  RotatedNms nms;
+  obbBoxVec boxes = makeAerialBoxes(1000, 3, 7);
+  obbBoxVec actual = boxes;
+  nms.run(actual, 0.5f, RotatedNms::IouType::ProbIou, 300, 200);
+
+  obbBoxVec top = boxes;
+  sortByScore(top);
+  top.erase(top.begin(), top.end() - 200);
+  nms.run(top, 0.5f, RotatedNms::IouType::ProbIou, 300, -1);
+  ASSERT_EQ(top.size(), actual.size());
+  for (std::size_t i = 0; i < top.size(); ++i)
+    EXPECT_EQ(top[i].score, actual[i].score);
+}
+
+TEST(RotatedNms, ProbiouMatchesReference) {
+  obbBoxVec boxes = makeAerialBoxes(200, 1, 11);
+  for (std::size_t i = 1; i < boxes.size(); ++i)
+    EXPECT_EQ(referenceProbiou(boxes[i - 1], boxes[i]),
+              RotatedNms::probiou(boxes[i - 1], boxes[i]));
+}
+
+TEST(RotatedNms, PolygonIou) {
+  obbBox square{0, 0, 10, 10, 0.3f, 1.f, 0};
+  EXPECT_NEAR(1.0, RotatedNms::polygonIou(square, square), 1e-5);
+
+  // 两个轴对齐正方形错开半个边长：交50，并150
+  obbBox a{0, 0, 10, 10, 0, 1.f, 0}, b{5, 0, 10, 10, 0, 1.f, 0};
+  EXPECT_NEAR(1.0 / 3, RotatedNms::polygonIou(a, b), 1e-5);
+  // 旋转90度后宽高互换，是同一个矩形
+  obbBox wide{0, 0, 20, 4, 0, 1.f, 0};
+  obbBox tall{0, 0, 4, 20, static_cast<float>(M_PI / 2), 1.f, 0};
+  EXPECT_NEAR(1.0, RotatedNms::polygonIou(wide, tall), 1e-5);
+  // 十字形交叉：交16，并144
+  obbBox cross{0, 0, 4, 20, 0, 1.f, 0};
+  EXPECT_NEAR(16.0 / 144, RotatedNms::polygonIou(wide, cross), 1e-5);
+  obbBox far{100, 0, 10, 10, 0, 1.f, 0};
+  EXPECT_EQ(0.f, RotatedNms::polygonIou(a, far));
+
+  RotatedNms nms;
+  obbBoxVec dets = {a, b, far};
+  dets[0].score = 0.9f;
+  dets[1].score = 0.8f;
+  dets[2].score = 0.7f;
+  nms.run(dets, 0.3f, RotatedNms::IouType::Polygon, 0, -1);
+  ASSERT_EQ(2u, dets.size());
+  EXPECT_EQ(0.7f, dets[0].score);
+  EXPECT_EQ(0.9f, dets[1].score);
+}
+
+}  // namespace
+}  // namespace yolov8
+}  // namespace element
+}  // namespace sophon_stream
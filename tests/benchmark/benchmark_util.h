@@ -0,0 +1,38 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SOPHON_STREAM_TESTS_BENCHMARK_UTIL_H_
+#define SOPHON_STREAM_TESTS_BENCHMARK_UTIL_H_
+
+#include <chrono>
+
+namespace sophon_stream {
+namespace benchmark {
+
+/**
+ * @brief 运行fn共repeat次，返回单次最短耗时，单位微秒
+ */
+template <typename Fn>
+double bestOfUs(int repeat, Fn&& fn) {
+  double best = 0;
+  for (int i = 0; i < repeat; ++i) {
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    double us = std::chrono::duration<double, std::micro>(
+                    std::chrono::steady_clock::now() - start)
+                    .count();
+    if (i == 0 || us < best) best = us;
+  }
+  return best;
+}
+
+}  // namespace benchmark
+}  // namespace sophon_stream
+
+#endif  // SOPHON_STREAM_TESTS_BENCHMARK_UTIL_H_
@@ -0,0 +1,98 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+// bytetrack卡尔曼预测：STrack::multi_predict的原地预测与原来按列批量预测对比，
+// 输出每条轨迹的耗时
+// 用法：bytetrack_predict_benchmark [重复次数]
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "benchmark_util.h"
+#include "bytetrack_kalman_reference.h"
+#include "bytetrack_strack.h"
+
+using namespace sophon_stream::element::bytetrack;
+using sophon_stream::benchmark::bestOfUs;
+
+namespace {
+
+// 随机位置和速度的已激活轨迹，部分为丢失状态
+STracks makeTracks(int count, unsigned seed) {
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<float> uniform(0.f, 1.f);
+  auto kalman = std::make_shared<KalmanFilter>();
+  STracks tracks;
+  for (int i = 0; i < count; ++i) {
+    auto strack = std::make_shared<STrack>(
+        std::vector<float>{1800 * uniform(rng), 1000 * uniform(rng),
+                           20 + 100 * uniform(rng), 40 + 200 * uniform(rng)},
+        0.9f, 0);
+    strack->activate(kalman, 1);
+    for (int k = 4; k < 8; ++k) strack->mean[k] = 4 * uniform(rng) - 2;
+    if (i % 4 == 3) strack->mark_lost();
+    tracks.push_back(strack);
+  }
+  return tracks;
+}
+
+STracks copyTracks(const STracks& tracks) {
+  STracks copies;
+  for (auto& strack : tracks)
+    copies.push_back(std::make_shared<STrack>(*strack));
+  return copies;
+}
+
+bool close(float a, float b) {
+  return std::fabs(a - b) <= 1e-5f * std::fmax(1.f, std::fabs(a));
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  const int repeat = argc > 1 ? std::atoi(argv[1]) : 200;
+  auto kalman = std::make_shared<KalmanFilter>();
+  ReferenceKalmanBatch batch;
+
+  // 一个通道的轨迹数，到一个线程上多个通道合计的轨迹数
+  for (int count : {8, 32, 128, 512, 2048}) {
+    STracks inPlace = makeTracks(count, count);
+    STracks batched = copyTracks(inPlace);
+    std::vector<STrack*> pointers;
+    for (auto& strack : batched) pointers.push_back(strack.get());
+
+    // 预测一次，两种方式的结果只有浮点运算顺序带来的误差
+    STrack::multi_predict(inPlace, kalman);
+    referenceMultiPredict(pointers, batch);
+    for (int i = 0; i < count; ++i) {
+      for (int k = 0; k < 8; ++k)
+        if (!close(inPlace[i]->mean[k], batched[i]->mean[k])) {
+          std::fprintf(stderr, "mean mismatch, tracks=%d\n", count);
+          return 1;
+        }
+      for (int k = 0; k < 12; ++k)
+        if (!close(inPlace[i]->covariance[k], batched[i]->covariance[k])) {
+          std::fprintf(stderr, "covariance mismatch, tracks=%d\n", count);
+          return 1;
+        }
+    }
+
+    double batchUs =
+        bestOfUs(repeat, [&] { referenceMultiPredict(pointers, batch); });
+    double inPlaceUs =
+        bestOfUs(repeat, [&] { STrack::multi_predict(inPlace, kalman); });
+    std::printf("tracks=%d batch=%.1fns/track in-place=%.1fns/track\n", count,
+                batchUs * 1000 / count, inPlaceUs * 1000 / count);
+  }
+  return 0;
+}
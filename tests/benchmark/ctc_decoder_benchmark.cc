@@ -0,0 +1,86 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+// CTC解码：CtcDecoder与ppocr_rec、lprnet原来的解码循环对比
+// 用法：ctc_decoder_benchmark [重复次数]
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "algorithmApi/ctc_decoder.h"
+#include "benchmark_util.h"
+#include "ctc_reference.h"
+
+using namespace sophon_stream::element;
+using sophon_stream::benchmark::bestOfUs;
+
+int main(int argc, char** argv) {
+  const int repeat = argc > 1 ? std::atoi(argv[1]) : 20;
+  CtcDecoder decoder;
+  std::vector<CtcDecoder::Result> results;
+  std::vector<ReferenceCtcResult> legacy;
+
+  // ppocr_rec：一个batch的文本行，6625类中文字典
+  const int batch = 16, T = 40, C = 6625;
+  auto logits = makeCtcLogits(batch, T, C, 0, 0.5f, 1);
+  for (int k : {1, 3, 5}) {
+    double legacyUs = bestOfUs(repeat, [&] {
+      legacy.clear();
+      for (int b = 0; b < batch; ++b) {
+        const float* data = &logits[std::size_t(b) * T * C];
+        legacy.push_back(k > 1 ? referencePpocrBeamSearch(data, T, C, k)
+                               : referencePpocrGreedy(data, T, C));
+      }
+    });
+    decoder.configure(0, k);
+    double newUs = bestOfUs(
+        repeat, [&] { decoder.decode(logits.data(), batch, T, C, results); });
+    for (int b = 0; b < batch; ++b)
+      if (legacy[b].labels != results[b].labels ||
+          legacy[b].confs != results[b].confs) {
+        std::fprintf(stderr, "ppocr_rec result mismatch, beam=%d\n", k);
+        return 1;
+      }
+    std::printf("ppocr_rec batch=%d T=%d C=%d beam=%d legacy=%.1fus new=%.1fus\n",
+                batch, T, C, k, legacyUs, newUs);
+  }
+
+  // lprnet：按[C][T]存放的车牌输出
+  const int lprT = 18, lprC = 68, plates = 64;
+  auto probs = makeCtcLogits(plates, lprT, lprC, lprC - 1, 0.5f, 2);
+  std::vector<float> classMajor(probs.size());
+  for (int p = 0; p < plates; ++p)
+    for (int t = 0; t < lprT; ++t)
+      for (int c = 0; c < lprC; ++c)
+        classMajor[(std::size_t(p) * lprC + c) * lprT + t] =
+            std::log(probs[(std::size_t(p) * lprT + t) * lprC + c]);
+  std::vector<std::vector<int>> legacyPlates(plates);
+  double legacyUs = bestOfUs(repeat, [&] {
+    for (int p = 0; p < plates; ++p)
+      legacyPlates[p] = referenceLprnetGreedy(
+          &classMajor[std::size_t(p) * lprC * lprT], lprT, lprC);
+  });
+  decoder.configure(lprC - 1, 1);
+  results.resize(plates);
+  double newUs = bestOfUs(repeat, [&] {
+    for (int p = 0; p < plates; ++p)
+      decoder.greedyClassMajor(&classMajor[std::size_t(p) * lprC * lprT],
+                               lprT, lprC, results[p]);
+  });
+  for (int p = 0; p < plates; ++p)
+    if (legacyPlates[p] != results[p].labels) {
+      std::fprintf(stderr, "lprnet result mismatch\n");
+      return 1;
+    }
+  std::printf("lprnet plates=%d T=%d C=%d legacy=%.1fus new=%.1fus\n", plates,
+              lprT, lprC, legacyUs, newUs);
+  return 0;
+}
@@ -0,0 +1,78 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+// openpose CPU后处理：OpenposeCpuDecoder与原nmsFunc、connectBodyPartsCpu对比
+// 用法：openpose_cpu_decoder_benchmark [重复次数]
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "benchmark_util.h"
+#include "openpose_cpu_decoder.h"
+#include "openpose_reference.h"
+
+using namespace sophon_stream::element::openpose;
+using sophon_stream::benchmark::bestOfUs;
+using Model = sophon_stream::common::PosedObjectMetadata::EModelType;
+using People =
+    std::vector<std::shared_ptr<sophon_stream::common::PosedObjectMetadata>>;
+
+int main(int argc, char** argv) {
+  const int repeat = argc > 1 ? std::atoi(argv[1]) : 20;
+  // 432x768输入的COCO模型输出为1/8大小
+  const int width = 96, height = 54, parts = 18;
+  const int maxPeaks = kReferenceMaxPeople, peaksOffset = (maxPeaks + 1) * 3;
+  const auto pairs = referencePosePairs(Model::COCO_18);
+  const auto mapIdx = referencePoseMapIdx(Model::COCO_18);
+  OpenposeCpuDecoder decoder;
+
+  for (int people : {1, 8, 32}) {
+    auto maps = makeCrowdMaps(width, height, people, people);
+    std::vector<float> legacyPeaks(parts * peaksOffset),
+        decoderPeaks(parts * peaksOffset);
+    People legacyPeople, decoderPeople;
+
+    double legacyNmsUs = bestOfUs(repeat, [&] {
+      referenceNms(maps.data(), legacyPeaks.data(), parts, height, width,
+                   maxPeaks, 0.05f, width * height, peaksOffset);
+    });
+    double legacyConnectUs = bestOfUs(repeat, [&] {
+      referenceConnectBodyParts(legacyPeople, maps.data(), legacyPeaks.data(),
+                                ReferenceSize{width, height}, maxPeaks, 9,
+                                0.05f, 3, 0.4f, 1, Model::COCO_18);
+    });
+    double nmsUs = bestOfUs(repeat, [&] {
+      for (int c = 0; c < parts; ++c)
+        OpenposeCpuDecoder::findPeaks(maps.data() + c * width * height, height,
+                                      width, maxPeaks, 0.05f,
+                                      decoderPeaks.data() + c * peaksOffset);
+    });
+    double connectUs = bestOfUs(repeat, [&] {
+      decoder.connect(decoderPeople, maps.data(), decoderPeaks.data(), width,
+                      height, maxPeaks, 9, 0.05f, 3, 0.4f, 1, pairs, mapIdx,
+                      parts, kReferenceMaxPeople, Model::COCO_18);
+    });
+
+    bool same = legacyPeaks == decoderPeaks &&
+                legacyPeople.size() == decoderPeople.size();
+    for (std::size_t i = 0; same && i < legacyPeople.size(); ++i)
+      same = legacyPeople[i]->keypoints == decoderPeople[i]->keypoints;
+    if (!same) {
+      std::fprintf(stderr, "result mismatch\n");
+      return 1;
+    }
+    std::printf(
+        "people=%d found=%zu nms legacy=%.1fus decoder=%.1fus, "
+        "connect legacy=%.1fus decoder=%.1fus\n",
+        people, decoderPeople.size(), legacyNmsUs, nmsUs, legacyConnectUs,
+        connectUs);
+  }
+  return 0;
+}
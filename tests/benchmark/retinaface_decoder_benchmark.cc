@@ -0,0 +1,62 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+// retinaface解码：缓存先验框后的decodeRetinafaceFaces与原来逐层生成先验框的循环对比
+// 用法：retinaface_decoder_benchmark [重复次数]
+
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "benchmark_util.h"
+#include "retinaface_decoder.h"
+#include "retinaface_reference.h"
+
+using namespace sophon_stream::element::retinaface;
+using sophon_stream::benchmark::bestOfUs;
+
+int main(int argc, char** argv) {
+  const int repeat = argc > 1 ? std::atoi(argv[1]) : 200;
+  const int net = 640;
+  auto priors = buildRetinafacePriors(net, net);
+  const std::size_t n = priors.size();
+
+  std::mt19937 rng(1);
+  std::uniform_real_distribution<float> uniform(0.f, 1.f), offset(-1.f, 1.f);
+  std::vector<float> cls(n * 2), loc(n * 4), land(n * 10);
+  for (auto& v : loc) v = offset(rng);
+  for (auto& v : land) v = offset(rng);
+
+  std::printf("priors=%zu\n", n);
+  for (double keep : {0.001, 0.01, 0.1}) {
+    for (std::size_t i = 0; i < n; ++i)
+      cls[i * 2 + 1] = uniform(rng) < keep ? 0.9f : 0.01f;
+    std::vector<FaceDetectInfo> legacy, cached;
+    legacy.reserve(n);
+    cached.reserve(n);
+    double legacyUs = bestOfUs(repeat, [&] {
+      legacy.clear();
+      referenceDecodeFaces(cls.data(), loc.data(), land.data(), 0.5f, net, net,
+                           1.f, legacy);
+    });
+    double cachedUs = bestOfUs(repeat, [&] {
+      cached.clear();
+      decodeRetinafaceFaces(priors, cls.data(), loc.data(), land.data(), 0.5f,
+                            net, net, 1.f, cached);
+    });
+    if (legacy.size() != cached.size()) {
+      std::fprintf(stderr, "result mismatch\n");
+      return 1;
+    }
+    std::printf("keep=%.3f faces=%zu legacy=%.1fus cached=%.1fus\n", keep,
+                cached.size(), legacyUs, cachedUs);
+  }
+  return 0;
+}
@@ -0,0 +1,59 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+// yolov8 obb的旋转框NMS：RotatedNms与原来逐对计算probiou的实现对比
+// 用法：yolov8_rotated_nms_benchmark [重复次数]
+
+#include <cstdio>
+#include <cstdlib>
+
+#include "benchmark_util.h"
+#include "yolov8_obb_reference.h"
+#include "yolov8_rotated_nms.h"
+
+using namespace sophon_stream::element::yolov8;
+using sophon_stream::benchmark::bestOfUs;
+
+int main(int argc, char** argv) {
+  const int repeat = argc > 1 ? std::atoi(argv[1]) : 3;
+  struct Case {
+    int num;
+    int classes;
+    int maxDet;
+  };
+  // maxDet足够大时不会提前结束，单独看预排除的效果
+  const Case cases[] = {
+      {1000, 1, 300}, {5000, 1, 300}, {5000, 15, 300}, {5000, 15, 100000}};
+  RotatedNms nms;
+  for (const auto& c : cases) {
+    obbBoxVec boxes = makeAerialBoxes(c.num, c.classes, c.num + c.classes);
+    obbBoxVec legacy, probiou, polygon;
+    double legacyUs = bestOfUs(repeat, [&] {
+      legacy = referenceObbNms(boxes, 0.5f, c.maxDet);
+    });
+    double probiouUs = bestOfUs(repeat, [&] {
+      probiou = boxes;
+      nms.run(probiou, 0.5f, RotatedNms::IouType::ProbIou, c.maxDet, -1);
+    });
+    double polygonUs = bestOfUs(repeat, [&] {
+      polygon = boxes;
+      nms.run(polygon, 0.5f, RotatedNms::IouType::Polygon, c.maxDet, -1);
+    });
+    if (legacy.size() != probiou.size()) {
+      std::fprintf(stderr, "result mismatch\n");
+      return 1;
+    }
+    std::printf(
+        "boxes=%d classes=%d max_det=%d kept=%zu legacy=%.2fms probiou=%.2fms "
+        "polygon=%.2fms (kept %zu)\n",
+        c.num, c.classes, c.maxDet, probiou.size(), legacyUs / 1000, probiouUs / 1000,
+        polygonUs / 1000, polygon.size());
+  }
+  return 0;
+}
@@ -0,0 +1,112 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#include "common/cpu_image_ops.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace sophon_stream {
+namespace common {
+namespace {
+
+// 每个像素为(x, y, x + y)的BGR图
+HostImage gradient(int w, int h) {
+  HostImage image;
+  image.create(w, h, 3);
+  for (int y = 0; y < h; ++y)
+    for (int x = 0; x < w; ++x) {
+      std::uint8_t* p = image.row(y) + x * 3;
+      p[0] = x;
+      p[1] = y;
+      p[2] = x + y;
+    }
+  return image;
+}
+
+TEST(CpuImageOps, CropCopiesRect) {
+  HostImage src = gradient(8, 6), dst;
+  ASSERT_TRUE(cpuCrop(src, 2, 1, 3, 4, dst));
+  EXPECT_EQ(3, dst.width);
+  EXPECT_EQ(4, dst.height);
+  EXPECT_EQ(2, dst.row(0)[0]);
+  EXPECT_EQ(1, dst.row(0)[1]);
+  EXPECT_EQ(4, dst.row(3)[2 * 3 + 1]);
+}
+
+TEST(CpuImageOps, CropIsClippedToImage) {
+  HostImage src = gradient(8, 6), dst;
+  ASSERT_TRUE(cpuCrop(src, -2, 4, 5, 10, dst));
+  EXPECT_EQ(3, dst.width);
+  EXPECT_EQ(2, dst.height);
+  EXPECT_EQ(0, dst.row(0)[0]);
+  EXPECT_EQ(4, dst.row(0)[1]);
+  EXPECT_FALSE(cpuCrop(src, 8, 0, 2, 2, dst));
+}
+
+TEST(CpuImageOps, NearestDownscalePicksPixelCenters) {
+  HostImage src = gradient(8, 8), dst;
+  cpuResize(src, 4, 4, dst, false);
+  // 目标像素x对应源像素中心(x + 0.5) * 2，取整为2x + 1
+  for (int y = 0; y < 4; ++y)
+    for (int x = 0; x < 4; ++x) {
+      EXPECT_EQ(2 * x + 1, dst.row(y)[x * 3]);
+      EXPECT_EQ(2 * y + 1, dst.row(y)[x * 3 + 1]);
+    }
+}
+
+TEST(CpuImageOps, BilinearKeepsLinearGradient) {
+  HostImage src = gradient(8, 8), dst;
+  cpuResize(src, 4, 4, dst, true);
+  // 2倍缩小时采样点落在两个源像素中间，线性梯度上结果为2x + 0.5，四舍五入
+  for (int y = 0; y < 4; ++y)
+    for (int x = 0; x < 4; ++x) {
+      EXPECT_EQ(2 * x + 1, dst.row(y)[x * 3]);
+      EXPECT_EQ(2 * y + 1, dst.row(y)[x * 3 + 1]);
+    }
+  HostImage same;
+  cpuResize(src, 8, 8, same, true);
+  EXPECT_EQ(src.data, same.data);
+}
+
+TEST(CpuImageOps, ResizeIntoPaddedRegion) {
+  HostImage src;
+  src.create(4, 2, 3);
+  std::fill(src.data.begin(), src.data.end(), 7);
+  HostImage dst;
+  cpuResize(src, 4, 4, dst, true, 0, 1, 4, 2, 114);
+  for (int y = 0; y < 4; ++y) {
+    std::uint8_t expected = y == 1 || y == 2 ? 7 : 114;
+    for (int i = 0; i < 4 * 3; ++i) EXPECT_EQ(expected, dst.row(y)[i]) << y;
+  }
+}
+
+TEST(CpuImageOps, ConvertToIsPlanarAndSwapsRB) {
+  HostImage src;
+  src.create(2, 1, 3);
+  const std::uint8_t pixels[] = {10, 20, 30, 40, 50, 60};
+  std::copy(pixels, pixels + 6, src.data.begin());
+  const float alpha[] = {1.f, 2.f, 0.5f};
+  const float beta[] = {0.f, 1.f, -1.f};
+  float dst[6];
+  cpuConvertTo(src, alpha, beta, false, dst);
+  const float bgr[] = {10, 40, 41, 101, 14, 29};
+  for (int i = 0; i < 6; ++i) EXPECT_FLOAT_EQ(bgr[i], dst[i]) << i;
+
+  cpuConvertTo(src, alpha, beta, true, dst);
+  const float rgb[] = {30, 60, 41, 101, 4, 19};
+  for (int i = 0; i < 6; ++i) EXPECT_FLOAT_EQ(rgb[i], dst[i]) << i;
+}
+
+}  // namespace
+}  // namespace common
+}  // namespace sophon_stream
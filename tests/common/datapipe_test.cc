@@ -0,0 +1,165 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#include "datapipe.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+namespace sophon_stream {
+namespace framework {
+namespace {
+
+// 与framework::Message接口相同的消息，用名字代替数据，不依赖SDK
+class FakeMessage {
+ public:
+  FakeMessage() = default;
+
+  static FakeMessage data(const std::string& name, int channelId,
+                          int priority) {
+    FakeMessage message;
+    message.mName = name;
+    message.mHeader.mChannelId = channelId;
+    message.mHeader.mPriority = priority;
+    return message;
+  }
+
+  static FakeMessage control(const std::string& name, MessageKind kind,
+                             int channelId = -1) {
+    FakeMessage message;
+    message.mName = name;
+    message.mHeader.mKind = kind;
+    message.mHeader.mChannelId = channelId;
+    return message;
+  }
+
+  bool isControl() const { return MessageKind::DATA != mHeader.mKind; }
+  bool empty() const { return mName.empty(); }
+  MessageHeader& header() { return mHeader; }
+  const MessageHeader& header() const { return mHeader; }
+  const std::string& name() const { return mName; }
+
+ private:
+  MessageHeader mHeader;
+  std::string mName;
+};
+
+using Pipe = BasicDataPipe<FakeMessage>;
+
+void push(Pipe& pipe, FakeMessage message) {
+  ASSERT_EQ(common::ErrorCode::SUCCESS, pipe.pushData(std::move(message)));
+}
+
+std::vector<std::string> popAll(Pipe& pipe) {
+  std::vector<std::string> names;
+  for (FakeMessage message = pipe.popData(); !message.empty();
+       message = pipe.popData())
+    names.push_back(message.name());
+  return names;
+}
+
+// 同一优先级内先进先出，优先级为p的队列按p+1的权重出队
+TEST(DataPipe, WeightedFairQueuing) {
+  Pipe pipe;
+  for (int i = 0; i < 4; ++i) {
+    push(pipe, FakeMessage::data("low" + std::to_string(i), 0, 0));
+    push(pipe, FakeMessage::data("high" + std::to_string(i), 1, 2));
+  }
+  EXPECT_EQ(std::vector<std::string>({"high0", "low0", "high1", "high2",
+                                      "high3", "low1", "low2", "low3"}),
+            popAll(pipe));
+}
+
+// 通道的EOS按该通道的优先级排队，在该通道之前的数据之后立即出队，
+// 不会排到低优先级通道的数据后面
+TEST(DataPipe, ChannelControlFollowsChannelData) {
+  Pipe pipe;
+  for (int i = 0; i < 3; ++i)
+    push(pipe, FakeMessage::data("low" + std::to_string(i), 0, 0));
+  for (int i = 0; i < 2; ++i)
+    push(pipe, FakeMessage::data("high" + std::to_string(i), 1, 5));
+  push(pipe, FakeMessage::control("eos1", MessageKind::EOS, 1));
+  push(pipe, FakeMessage::control("eos0", MessageKind::EOS, 0));
+
+  std::vector<std::string> names;
+  int eosPriority = -1;
+  for (FakeMessage message = pipe.popData(); !message.empty();
+       message = pipe.popData()) {
+    names.push_back(message.name());
+    if ("eos1" == message.name()) eosPriority = message.header().mPriority;
+  }
+  EXPECT_EQ(std::vector<std::string>(
+                {"high0", "low0", "high1", "eos1", "low1", "low2", "eos0"}),
+            names);
+  EXPECT_EQ(5, eosPriority);
+  EXPECT_EQ(0, pipe.getSize());
+}
+
+// 不属于某个通道的控制消息在之前入队的所有数据之后、之后入队的数据之前出队
+TEST(DataPipe, BroadcastControlWaitsForEarlierData) {
+  Pipe pipe;
+  push(pipe, FakeMessage::data("low", 0, 0));
+  push(pipe, FakeMessage::data("high0", 1, 5));
+  push(pipe, FakeMessage::control("flush", MessageKind::FLUSH));
+  push(pipe, FakeMessage::data("high1", 1, 5));
+  EXPECT_EQ(std::vector<std::string>({"high0", "low", "flush", "high1"}),
+            popAll(pipe));
+
+  // 没有数据时立即出队；没有数据记录的通道按不属于某个通道处理
+  push(pipe, FakeMessage::control("flush", MessageKind::FLUSH));
+  push(pipe, FakeMessage::data("high2", 1, 5));
+  push(pipe, FakeMessage::control("eos2", MessageKind::EOS, 2));
+  EXPECT_EQ(std::vector<std::string>({"flush", "high2", "eos2"}),
+            popAll(pipe));
+}
+
+// EOS之后通道重新开始时按新的优先级排队
+TEST(DataPipe, EndOfStreamForgetsChannelPriority) {
+  Pipe pipe;
+  push(pipe, FakeMessage::data("first", 1, 5));
+  push(pipe, FakeMessage::control("eos", MessageKind::EOS, 1));
+  EXPECT_EQ(std::vector<std::string>({"first", "eos"}), popAll(pipe));
+
+  push(pipe, FakeMessage::data("second", 1, 0));
+  push(pipe, FakeMessage::data("other", 3, 5));
+  push(pipe, FakeMessage::control("flush", MessageKind::FLUSH, 1));
+  FakeMessage message = pipe.popData();
+  EXPECT_EQ("second", message.name());
+  message = pipe.popData();
+  EXPECT_EQ("flush", message.name());
+  EXPECT_EQ(0, message.header().mPriority);
+  message = pipe.popData();
+  EXPECT_EQ("other", message.name());
+}
+
+// 低优先级的数据不能占用为高优先级保留的位置，控制消息只受总容量限制
+TEST(DataPipe, ReservesHeadroomForHigherPriority) {
+  Pipe pipe;
+  push(pipe, FakeMessage::data("high", 1, 5));
+  int low = 0;
+  while (common::ErrorCode::SUCCESS ==
+         pipe.pushData(FakeMessage::data("low", 0, 0)))
+    ++low;
+  const int headroom = Pipe::DEFAULT_CAPACITY / 8;
+  EXPECT_EQ(int(Pipe::DEFAULT_CAPACITY) - headroom - 1, low);
+
+  push(pipe, FakeMessage::data("high", 1, 5));
+  for (int i = pipe.getSize(); i < pipe.getCapacity(); ++i)
+    push(pipe, FakeMessage::control("eos", MessageKind::EOS, 0));
+  EXPECT_EQ(common::ErrorCode::DATA_PIPE_FULL,
+            pipe.pushData(FakeMessage::control("eos", MessageKind::EOS, 0)));
+  EXPECT_EQ(common::ErrorCode::DATA_PIPE_FULL,
+            pipe.pushData(FakeMessage::data("high", 1, 5)));
+}
+
+}  // namespace
+}  // namespace framework
+}  // namespace sophon_stream
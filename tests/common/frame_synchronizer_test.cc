@@ -0,0 +1,253 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#include "frame_synchronizer.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace sophon_stream {
+namespace framework {
+namespace {
+
+// 只包含同步器用到的字段，代替依赖SDK的ObjectMetadata
+struct TestFrame {
+  std::int64_t mFrameId = -1;
+  std::int64_t mTimestamp = 0;
+  bool mEndOfStream = false;
+};
+
+struct TestData {
+  std::shared_ptr<TestFrame> mFrame;
+};
+
+using Synchronizer = BasicFrameSynchronizer<TestData>;
+using Group = std::vector<std::shared_ptr<TestData>>;
+
+const std::int64_t kMs = 1000;
+
+std::shared_ptr<TestData> frame(std::int64_t id,
+                                std::int64_t timestampMs = 0) {
+  auto data = std::make_shared<TestData>();
+  data->mFrame = std::make_shared<TestFrame>();
+  data->mFrame->mFrameId = id;
+  data->mFrame->mTimestamp = timestampMs * kMs;
+  return data;
+}
+
+std::shared_ptr<TestData> endOfStream() {
+  auto data = frame(-1);
+  data->mFrame->mEndOfStream = true;
+  return data;
+}
+
+Synchronizer::Options options(Synchronizer::Policy policy) {
+  Synchronizer::Options options;
+  options.policy = policy;
+  options.maxWaitMs = 200;
+  return options;
+}
+
+void expectIds(const Group& group, std::int64_t left, std::int64_t right) {
+  ASSERT_EQ(2u, group.size());
+  ASSERT_TRUE(group[0] && group[1]);
+  EXPECT_EQ(left, group[0]->mFrame->mFrameId);
+  EXPECT_EQ(right, group[1]->mFrame->mFrameId);
+}
+
+TEST(FrameSynchronizer, AlignsEqualFrameIds) {
+  Synchronizer sync;
+  sync.configure(2, options(Synchronizer::Policy::DROP));
+  Group group;
+  for (int id = 1; id <= 3; ++id) sync.push(0, frame(id), 0);
+  EXPECT_FALSE(sync.pop(group, 0));
+  for (int id = 1; id <= 3; ++id) {
+    sync.push(1, frame(id), 0);
+    ASSERT_TRUE(sync.pop(group, 0));
+    expectIds(group, id, id);
+  }
+  EXPECT_FALSE(sync.pop(group, 0));
+  EXPECT_EQ(0, sync.takeDropped());
+}
+
+// 时间戳在容差内成组；一路帧率较高时跳过离目标更远的旧帧
+TEST(FrameSynchronizer, AlignsTimestampsWithinTolerance) {
+  auto opts = options(Synchronizer::Policy::DROP);
+  opts.key = Synchronizer::SyncKey::TIMESTAMP;
+  opts.toleranceMs = 20;
+  Synchronizer sync;
+  sync.configure(2, opts);
+  // port0为60fps，port1为30fps且相位偏移5ms
+  for (int i = 0; i < 6; ++i) sync.push(0, frame(i, i * 16), 0);
+  for (int i = 0; i < 3; ++i) sync.push(1, frame(100 + i, i * 33 + 5), 0);
+
+  Group group;
+  ASSERT_TRUE(sync.pop(group, 0));
+  expectIds(group, 0, 100);
+  // 目标38ms：port0的16ms被32ms取代
+  ASSERT_TRUE(sync.pop(group, 0));
+  expectIds(group, 2, 101);
+  // 目标71ms：port0的48ms被64ms取代
+  ASSERT_TRUE(sync.pop(group, 0));
+  expectIds(group, 4, 102);
+  EXPECT_EQ(2, sync.takeDropped());
+  // port0剩下80ms的一帧，等待port1
+  EXPECT_FALSE(sync.pop(group, 0));
+}
+
+TEST(FrameSynchronizer, DropsUnmatchedFramesAfterTimeout) {
+  Synchronizer sync;
+  sync.configure(2, options(Synchronizer::Policy::DROP));
+  sync.push(0, frame(1), 0);
+  sync.push(0, frame(2), 100 * kMs);
+  Group group;
+  EXPECT_FALSE(sync.pop(group, 199 * kMs));
+  EXPECT_EQ(0, sync.takeDropped());
+  // 只丢弃已等待超过200ms的一帧
+  EXPECT_FALSE(sync.pop(group, 250 * kMs));
+  EXPECT_EQ(1, sync.takeDropped());
+  sync.push(1, frame(2), 260 * kMs);
+  ASSERT_TRUE(sync.pop(group, 260 * kMs));
+  expectIds(group, 2, 2);
+}
+
+// 各port都有帧但超出容差：DROP超时后丢弃落后的帧，NEAREST超时后直接成组
+TEST(FrameSynchronizer, UnalignedHeadsAfterTimeout) {
+  Group group;
+  {
+    Synchronizer sync;
+    sync.configure(2, options(Synchronizer::Policy::DROP));
+    sync.push(0, frame(1), 0);
+    sync.push(1, frame(5), 100 * kMs);
+    EXPECT_FALSE(sync.pop(group, 100 * kMs));
+    // 丢弃落后的port0，port1的帧还未等满200ms
+    EXPECT_FALSE(sync.pop(group, 200 * kMs));
+    EXPECT_EQ(1, sync.takeDropped());
+    sync.push(0, frame(5), 210 * kMs);
+    ASSERT_TRUE(sync.pop(group, 210 * kMs));
+    expectIds(group, 5, 5);
+  }
+  {
+    Synchronizer sync;
+    sync.configure(2, options(Synchronizer::Policy::NEAREST));
+    sync.push(0, frame(1), 0);
+    sync.push(1, frame(5), 0);
+    EXPECT_FALSE(sync.pop(group, 100 * kMs));
+    ASSERT_TRUE(sync.pop(group, 200 * kMs));
+    expectIds(group, 1, 5);
+    EXPECT_EQ(0, sync.takeDropped());
+  }
+}
+
+// NEAREST：缺帧的port超时后沿用上一次输出的帧；从未输出过的port无法补齐，只能丢弃
+TEST(FrameSynchronizer, NearestReusesLastFrameOfMissingPort) {
+  Synchronizer sync;
+  sync.configure(2, options(Synchronizer::Policy::NEAREST));
+  Group group;
+  sync.push(0, frame(1), 0);
+  EXPECT_FALSE(sync.pop(group, 200 * kMs));
+  EXPECT_EQ(1, sync.takeDropped());
+
+  sync.push(0, frame(2), 300 * kMs);
+  sync.push(1, frame(2), 300 * kMs);
+  ASSERT_TRUE(sync.pop(group, 300 * kMs));
+  expectIds(group, 2, 2);
+
+  sync.push(0, frame(3), 400 * kMs);
+  EXPECT_FALSE(sync.pop(group, 599 * kMs));
+  ASSERT_TRUE(sync.pop(group, 600 * kMs));
+  expectIds(group, 3, 2);
+  EXPECT_EQ(0, sync.takeDropped());
+}
+
+TEST(FrameSynchronizer, OverflowDropsOldestFrameOfThatPort) {
+  auto opts = options(Synchronizer::Policy::DROP);
+  opts.bufferSize = 3;
+  Synchronizer sync;
+  sync.configure(2, opts);
+  for (int id = 1; id <= 5; ++id) sync.push(0, frame(id), 0);
+  EXPECT_EQ(2, sync.takeDropped());
+
+  // port0剩下3、4、5，port1不受影响
+  Group group;
+  sync.push(1, frame(3), 0);
+  ASSERT_TRUE(sync.pop(group, 0));
+  expectIds(group, 3, 3);
+  sync.push(1, frame(4), 0);
+  ASSERT_TRUE(sync.pop(group, 0));
+  expectIds(group, 4, 4);
+  EXPECT_EQ(0, sync.takeDropped());
+}
+
+// 一路收到EOS后不等待maxWait，另一路缓存的帧立即按策略处理
+TEST(FrameSynchronizer, EndOfStreamFlushesOtherPorts) {
+  Group group;
+  {
+    Synchronizer sync;
+    sync.configure(2, options(Synchronizer::Policy::DROP));
+    for (int id = 1; id <= 3; ++id) sync.push(0, frame(id), 0);
+    sync.push(1, frame(1), 0);
+    sync.push(1, endOfStream(), 0);
+    ASSERT_TRUE(sync.pop(group, 0));
+    expectIds(group, 1, 1);
+    EXPECT_FALSE(sync.pop(group, 0));
+    EXPECT_EQ(2, sync.takeDropped());
+  }
+  {
+    Synchronizer sync;
+    sync.configure(2, options(Synchronizer::Policy::NEAREST));
+    for (int id = 1; id <= 3; ++id) sync.push(0, frame(id), 0);
+    sync.push(1, frame(1), 0);
+    sync.push(1, endOfStream(), 0);
+    for (int id = 1; id <= 3; ++id) {
+      ASSERT_TRUE(sync.pop(group, 0));
+      expectIds(group, id, 1);
+    }
+    EXPECT_FALSE(sync.pop(group, 0));
+    EXPECT_EQ(0, sync.takeDropped());
+
+    // 该路重新开始后恢复等待
+    sync.push(1, frame(10), 0);
+    sync.push(0, frame(10), 0);
+    sync.push(0, frame(11), 0);
+    ASSERT_TRUE(sync.pop(group, 0));
+    expectIds(group, 10, 10);
+    EXPECT_FALSE(sync.pop(group, 100 * kMs));
+  }
+}
+
+TEST(FrameSynchronizer, ParseOptions) {
+  Synchronizer::Options opts;
+  auto configure = nlohmann::json::parse(
+      R"({"sync_key": "TIMESTAMP", "sync_policy": "NEAREST",
+          "sync_tolerance_ms": 15.5, "sync_buffer_size": 4,
+          "sync_max_wait_ms": 50})");
+  ASSERT_EQ(common::ErrorCode::SUCCESS,
+            Synchronizer::parseOptions(configure, opts));
+  EXPECT_EQ(Synchronizer::SyncKey::TIMESTAMP, opts.key);
+  EXPECT_EQ(Synchronizer::Policy::NEAREST, opts.policy);
+  EXPECT_DOUBLE_EQ(15.5, opts.toleranceMs);
+  EXPECT_EQ(0, opts.toleranceFrames);
+  EXPECT_EQ(4, opts.bufferSize);
+  EXPECT_EQ(50, opts.maxWaitMs);
+
+  EXPECT_EQ(common::ErrorCode::PARSE_CONFIGURE_FAIL,
+            Synchronizer::parseOptions(
+                nlohmann::json::parse(R"({"sync_policy": "LATEST"})"), opts));
+  EXPECT_EQ(common::ErrorCode::PARSE_CONFIGURE_FAIL,
+            Synchronizer::parseOptions(
+                nlohmann::json::parse(R"({"sync_buffer_size": 0})"), opts));
+}
+
+}  // namespace
+}  // namespace framework
+}  // namespace sophon_stream
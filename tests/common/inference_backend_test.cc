@@ -0,0 +1,203 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#include "common/inference_backend.h"
+
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "algorithmApi/host_pre_process.h"
+
+namespace sophon_stream {
+namespace common {
+namespace {
+
+HostTensor floatTensor(const std::vector<int>& shape,
+                       const std::vector<float>& values) {
+  HostTensor tensor;
+  tensor.allocate(0, shape);
+  std::copy(values.begin(), values.end(), tensor.floatData());
+  return tensor;
+}
+
+// 输入为[N, 2]，输出为每行两个数之和[N, 1]
+NetworkInfo sumNetwork() {
+  NetworkInfo info;
+  info.name = "sum";
+  info.inputs.push_back({"in", 0, {4, 2}, 1.f});
+  info.outputs.push_back({"out", 0, {4, 1}, 1.f});
+  return info;
+}
+
+int sumModel(const HostTensors& inputs, HostTensors& outputs) {
+  const float* in = inputs[0].floatData();
+  float* out = outputs[0].floatData();
+  for (int n = 0; n < inputs[0].shape[0]; ++n) out[n] = in[2 * n] + in[2 * n + 1];
+  return 0;
+}
+
+class InferenceBackendTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    mRecorder = std::make_shared<ReplayBackend>(ReplayBackend::Mode::RECORD,
+                                                mDir);
+    mReplayer = std::make_shared<ReplayBackend>(ReplayBackend::Mode::REPLAY,
+                                                mDir);
+  }
+
+  void TearDown() override {
+    for (const auto& path : mFiles) std::remove(path.c_str());
+    ::rmdir(mDir.c_str());
+  }
+
+  // 录制并登记需要清理的文件
+  void record(const std::string& netName, const HostTensors& inputs,
+              const HostTensors& outputs) {
+    ASSERT_EQ(0, mRecorder->record(netName, inputs, outputs));
+    char hash[32];
+    std::snprintf(hash, sizeof(hash), "%016llx",
+                  static_cast<unsigned long long>(
+                      ReplayBackend::hashInputs(netName, inputs)));
+    mFiles.push_back(mDir + "/" + netName + "_" + hash + ".bin");
+  }
+
+  void saveInfo(const NetworkInfo& info) {
+    ASSERT_EQ(0, mRecorder->saveNetworkInfo(info));
+    mFiles.push_back(mDir + "/" + info.name + ".json");
+  }
+
+  const std::string mDir = "inference_backend_test_records";
+  std::vector<std::string> mFiles;
+  std::shared_ptr<ReplayBackend> mRecorder, mReplayer;
+};
+
+TEST_F(InferenceBackendTest, ReplaysRecordedOutputs) {
+  HostTensors inputs = {floatTensor({1, 2}, {1.f, 2.f})};
+  HostTensors outputs = {floatTensor({1, 1}, {42.f})};
+  record("net", inputs, outputs);
+
+  HostTensors replayed = {floatTensor({1, 1}, {0.f})};
+  ASSERT_EQ(0, mReplayer->forward("net", inputs, replayed));
+  ASSERT_EQ(1u, replayed.size());
+  EXPECT_EQ((std::vector<int>{1, 1}), replayed[0].shape);
+  EXPECT_FLOAT_EQ(42.f, replayed[0].floatData()[0]);
+}
+
+TEST_F(InferenceBackendTest, HashCoversNameShapeAndContent) {
+  HostTensors a = {floatTensor({1, 2}, {1.f, 2.f})};
+  HostTensors b = {floatTensor({1, 2}, {1.f, 3.f})};
+  HostTensors c = {floatTensor({2, 1}, {1.f, 2.f})};
+  auto hash = ReplayBackend::hashInputs("net", a);
+  EXPECT_EQ(hash, ReplayBackend::hashInputs("net", a));
+  EXPECT_NE(hash, ReplayBackend::hashInputs("net2", a));
+  EXPECT_NE(hash, ReplayBackend::hashInputs("net", b));
+  EXPECT_NE(hash, ReplayBackend::hashInputs("net", c));
+}
+
+TEST_F(InferenceBackendTest, MissingRecordFallsBackToReferenceModel) {
+  HostTensors inputs = {floatTensor({1, 2}, {1.f, 2.f})};
+  HostTensors outputs = {floatTensor({1, 1}, {0.f})};
+  EXPECT_NE(0, mReplayer->forward("sum", inputs, outputs));
+
+  mReplayer->registerReferenceModel("sum", sumModel);
+  ASSERT_EQ(0, mReplayer->forward("sum", inputs, outputs));
+  EXPECT_FLOAT_EQ(3.f, outputs[0].floatData()[0]);
+}
+
+TEST_F(InferenceBackendTest, RecordWithWrongOutputCountIsRejected) {
+  HostTensors inputs = {floatTensor({1, 2}, {1.f, 2.f})};
+  record("net", inputs, {floatTensor({1, 1}, {1.f})});
+  HostTensors outputs(2);
+  EXPECT_NE(0, mReplayer->forward("net", inputs, outputs));
+}
+
+TEST_F(InferenceBackendTest, NetworkInfoRoundTrip) {
+  saveInfo(sumNetwork());
+  NetworkInfo loaded;
+  ASSERT_EQ(0, mReplayer->loadNetworkInfo("sum", loaded));
+  EXPECT_EQ("sum", loaded.name);
+  ASSERT_EQ(1u, loaded.inputs.size());
+  EXPECT_EQ("in", loaded.inputs[0].name);
+  EXPECT_EQ((std::vector<int>{4, 2}), loaded.inputs[0].shape);
+  ASSERT_EQ(1u, loaded.outputs.size());
+  EXPECT_EQ((std::vector<int>{4, 1}), loaded.outputs[0].shape);
+
+  EXPECT_NE(0, mReplayer->loadNetworkInfo("missing", loaded));
+  EXPECT_EQ(nullptr, HostNetwork::fromRecords(mReplayer, "missing"));
+}
+
+TEST_F(InferenceBackendTest, HostNetworkChecksInputs) {
+  mReplayer->registerReferenceModel("sum", sumModel);
+  HostNetwork network(mReplayer, sumNetwork());
+  HostTensors outputs;
+
+  HostTensors inputs = {floatTensor({3, 2}, {1, 2, 3, 4, 5, 6})};
+  ASSERT_EQ(0, network.forward(inputs, outputs));
+  ASSERT_EQ(1u, outputs.size());
+  // 输出的batch跟随输入
+  EXPECT_EQ((std::vector<int>{3, 1}), outputs[0].shape);
+  EXPECT_FLOAT_EQ(11.f, outputs[0].floatData()[2]);
+
+  HostTensors wrongShape = {floatTensor({1, 3}, {1, 2, 3})};
+  EXPECT_NE(0, network.forward(wrongShape, outputs));
+  HostTensors wrongType = inputs;
+  wrongType[0].dtype = 6;
+  EXPECT_NE(0, network.forward(wrongType, outputs));
+  HostTensors truncated = inputs;
+  truncated[0].data.resize(4);
+  EXPECT_NE(0, network.forward(truncated, outputs));
+  EXPECT_NE(0, network.forward({}, outputs));
+}
+
+// 录制一次后，用HostPreProcess生成相同的输入即可在没有TPU时复现网络输出
+TEST_F(InferenceBackendTest, HostPipelineReplaysRecording) {
+  NetworkInfo info;
+  info.name = "det";
+  info.inputs.push_back({"images", 0, {1, 3, 4, 4}, 1.f});
+  info.outputs.push_back({"boxes", 0, {1, 2}, 1.f});
+  saveInfo(info);
+
+  HostImage image;
+  image.create(8, 4, 3);
+  for (std::size_t i = 0; i < image.data.size(); ++i) image.data[i] = i % 251;
+  element::HostPreProcess pre;
+  HostTensors inputs(1);
+  std::vector<element::HostPreProcess::Letterbox> boxes;
+  ASSERT_EQ(ErrorCode::SUCCESS,
+            pre.preProcess({image}, info.inputs[0], inputs[0], boxes));
+  record("det", inputs, {floatTensor({1, 2}, {7.f, 9.f})});
+
+  auto network = HostNetwork::fromRecords(mReplayer, "det");
+  ASSERT_NE(nullptr, network);
+  HostTensors replayInputs(1), outputs;
+  ASSERT_EQ(ErrorCode::SUCCESS,
+            pre.preProcess({image}, network->info().inputs[0], replayInputs[0],
+                           boxes));
+  ASSERT_EQ(0, network->forward(replayInputs, outputs));
+  EXPECT_FLOAT_EQ(7.f, outputs[0].floatData()[0]);
+  EXPECT_FLOAT_EQ(9.f, outputs[0].floatData()[1]);
+  EXPECT_EQ(1, boxes[0].padY);
+  EXPECT_FLOAT_EQ(0.5f, boxes[0].ratioW);
+
+  // 前处理改变后输入哈希不同，录制不再命中
+  pre.bgr2rgb = false;
+  ASSERT_EQ(ErrorCode::SUCCESS,
+            pre.preProcess({image}, network->info().inputs[0], replayInputs[0],
+                           boxes));
+  EXPECT_NE(0, network->forward(replayInputs, outputs));
+}
+
+}  // namespace
+}  // namespace common
+}  // namespace sophon_stream
@@ -0,0 +1,156 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#include "common/segment_mask.h"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <opencv2/imgproc.hpp>
+#include <random>
+#include <vector>
+
+namespace sophon_stream {
+namespace common {
+namespace {
+
+cv::Mat makeGrid(int width, int height, unsigned seed) {
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<float> uniform(-1.f, 1.f);
+  cv::Mat grid(height, width, CV_32FC1);
+  for (int j = 0; j < height; ++j)
+    for (int i = 0; i < width; ++i) grid.at<float>(j, i) = uniform(rng);
+  return grid;
+}
+
+// 按reset()返回的ROI从原型网格中拷贝logits
+SegmentMask makeMask(const cv::Mat& grid, const cv::Size& imageSize,
+                     const cv::Rect& box, float threshold) {
+  SegmentMask mask;
+  cv::Rect roi = mask.reset(grid.cols, grid.rows, imageSize, box, threshold);
+  for (int j = 0; j < roi.height; ++j)
+    for (int i = 0; i < roi.width; ++i)
+      mask.data()[j * roi.width + i] = grid.at<float>(roi.y + j, roi.x + i);
+  return mask;
+}
+
+struct Case {
+  int gridWidth, gridHeight;
+  cv::Size imageSize;
+  std::vector<cv::Rect> boxes;
+};
+
+// 原来的做法：整张原型图cv::resize(INTER_LINEAR)到图像大小，裁剪目标框后阈值化。
+// 插值结果与阈值相差不到1e-4的像素两边的舍入可能不同，不参与比较
+void expectMatchesResize(const Case& c, float threshold, unsigned seed) {
+  cv::Mat grid = makeGrid(c.gridWidth, c.gridHeight, seed);
+  cv::Mat resized;
+  cv::resize(grid, resized, c.imageSize, 0, 0, cv::INTER_LINEAR);
+  for (const auto& box : c.boxes) {
+    SCOPED_TRACE(testing::Message()
+                 << "grid " << c.gridWidth << "x" << c.gridHeight << " box "
+                 << box.x << "," << box.y << " " << box.width << "x"
+                 << box.height);
+    cv::Mat actual = makeMask(grid, c.imageSize, box, threshold).decode();
+    ASSERT_EQ(CV_8UC1, actual.type());
+    ASSERT_EQ(box.height, actual.rows);
+    ASSERT_EQ(box.width, actual.cols);
+    cv::Mat expected = resized(box);
+    int mismatches = 0;
+    for (int j = 0; j < box.height; ++j)
+      for (int i = 0; i < box.width; ++i) {
+        float value = expected.at<float>(j, i);
+        if (std::fabs(value - threshold) < 1e-4f) continue;
+        unsigned char want = value > threshold ? 255 : 0;
+        if (actual.at<unsigned char>(j, i) != want) ++mismatches;
+      }
+    EXPECT_EQ(0, mismatches);
+  }
+}
+
+// 整数倍与非整数倍放大，图像宽高为奇数，目标框宽高为奇数或1
+TEST(SegmentMask, OddBoxesMatchResize) {
+  const Case cases[] = {
+      {160, 160, cv::Size(640, 640),
+       {{1, 1, 3, 5}, {17, 33, 101, 77}, {320, 240, 1, 1}, {63, 401, 1, 9}}},
+      {160, 120, cv::Size(641, 479),
+       {{1, 1, 3, 5}, {17, 33, 101, 77}, {100, 200, 333, 151}, {5, 7, 1, 1}}},
+      {80, 45, cv::Size(1919, 1079),
+       {{1, 1, 3, 5}, {999, 333, 377, 255}, {1201, 61, 13, 1}}},
+  };
+  unsigned seed = 1;
+  for (const auto& c : cases)
+    for (float threshold : {0.f, 0.5f})
+      expectMatchesResize(c, threshold, seed++);
+}
+
+// 目标框贴着图像边缘时插值坐标被截断到网格边界，ROI不能越界
+TEST(SegmentMask, BoxesTouchingBordersMatchResize) {
+  const Case cases[] = {
+      {160, 120, cv::Size(641, 479),
+       {{0, 0, 641, 479},
+        {0, 100, 57, 83},
+        {600, 0, 41, 39},
+        {640, 478, 1, 1},
+        {0, 0, 641, 1},
+        {0, 0, 1, 479},
+        {500, 300, 141, 179}}},
+      {80, 45, cv::Size(1919, 1079),
+       {{0, 0, 1919, 1079}, {1900, 1070, 19, 9}, {0, 1000, 3, 79}}},
+  };
+  unsigned seed = 100;
+  for (const auto& c : cases)
+    for (float threshold : {0.f, 0.5f})
+      expectMatchesResize(c, threshold, seed++);
+}
+
+// rle()从背景开始交替计数，按游程还原后与decode()相同
+TEST(SegmentMask, RleRoundTrip) {
+  const cv::Size imageSize(641, 479);
+  cv::Mat grid = makeGrid(160, 120, 7);
+  const cv::Rect boxes[] = {{0, 0, 641, 479}, {17, 33, 101, 77},
+                            {640, 478, 1, 1}, {0, 0, 1, 479}};
+  for (const auto& box : boxes) {
+    for (float threshold : {-2.f, 0.f, 2.f}) {
+      SegmentMask mask = makeMask(grid, imageSize, box, threshold);
+      cv::Mat decoded = mask.decode();
+      std::vector<int> counts = mask.rle();
+      ASSERT_FALSE(counts.empty());
+      for (std::size_t k = 1; k < counts.size(); ++k) EXPECT_GT(counts[k], 0);
+
+      cv::Mat restored(box.height, box.width, CV_8UC1);
+      unsigned char* out = restored.ptr<unsigned char>(0);
+      ASSERT_TRUE(restored.isContinuous());
+      int offset = 0;
+      for (std::size_t k = 0; k < counts.size(); ++k) {
+        ASSERT_LE(offset + counts[k], box.area());
+        for (int n = 0; n < counts[k]; ++n) out[offset++] = k % 2 ? 255 : 0;
+      }
+      ASSERT_EQ(box.area(), offset);
+      EXPECT_EQ(0, cv::countNonZero(decoded != restored));
+    }
+  }
+  // 阈值低于所有logits时整个目标框都是前景
+  SegmentMask full = makeMask(grid, imageSize, boxes[1], -2.f);
+  EXPECT_EQ(std::vector<int>({0, boxes[1].area()}), full.rle());
+}
+
+TEST(SegmentMask, EmptyBox) {
+  SegmentMask mask;
+  cv::Rect roi = mask.reset(160, 160, cv::Size(640, 640),
+                            cv::Rect(10, 10, 0, 5), 0.f);
+  EXPECT_EQ(0, roi.area());
+  EXPECT_TRUE(mask.empty());
+  EXPECT_TRUE(mask.decode().empty());
+  EXPECT_TRUE(mask.rle().empty());
+}
+
+}  // namespace
+}  // namespace common
+}  // namespace sophon_stream
@@ -0,0 +1,157 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#include "common/state_archive.h"
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace sophon_stream {
+namespace common {
+namespace {
+
+class StateArchiveTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    mPath = "state_archive_test.state";
+  }
+  void TearDown() override { std::remove(mPath.c_str()); }
+
+  std::vector<unsigned char> readFile() const {
+    std::ifstream in(mPath, std::ios::binary);
+    return std::vector<unsigned char>(std::istreambuf_iterator<char>(in),
+                                      std::istreambuf_iterator<char>());
+  }
+
+  void writeFile(const std::vector<unsigned char>& bytes) const {
+    std::ofstream out(mPath, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+  }
+
+  std::string mPath;
+};
+
+enum class Color : std::uint8_t { Red = 1, Blue = 7 };
+
+TEST_F(StateArchiveTest, RoundTrip) {
+  std::unordered_map<std::string, int> counts{{"a", 1}, {"bb", -2}};
+  std::unordered_map<std::string, Point<int>> points{{"7", {3, -4}}};
+  std::unordered_map<int, std::vector<float>> times{{0, {0.5f, 1.5f}}, {3, {}}};
+  std::array<float, 3> array{1.f, -2.f, 3.25f};
+
+  StateWriter writer;
+  writer.write(7);
+  writer.write(true);
+  writer.write(2.5);
+  writer.write(Color::Blue);
+  writer.write(std::string("bytetrack"));
+  writer.write(array);
+  writer.write(counts);
+  writer.write(points);
+  writer.write(times);
+  ASSERT_TRUE(writer.save(mPath, "element", 3));
+
+  StateReader reader;
+  ASSERT_TRUE(reader.load(mPath, "element"));
+  EXPECT_EQ(3u, reader.stateVersion());
+  int i = 0;
+  bool b = false;
+  double d = 0;
+  Color color = Color::Red;
+  std::string s;
+  std::array<float, 3> array2{};
+  std::unordered_map<std::string, int> counts2;
+  std::unordered_map<std::string, Point<int>> points2;
+  std::unordered_map<int, std::vector<float>> times2;
+  reader.read(i);
+  reader.read(b);
+  reader.read(d);
+  reader.read(color);
+  reader.read(s);
+  reader.read(array2);
+  reader.read(counts2);
+  reader.read(points2);
+  reader.read(times2);
+  ASSERT_TRUE(reader.ok());
+  EXPECT_EQ(7, i);
+  EXPECT_TRUE(b);
+  EXPECT_EQ(2.5, d);
+  EXPECT_EQ(Color::Blue, color);
+  EXPECT_EQ("bytetrack", s);
+  EXPECT_EQ(array, array2);
+  EXPECT_EQ(counts, counts2);
+  ASSERT_EQ(1u, points2.count("7"));
+  EXPECT_EQ(3, points2["7"].mX);
+  EXPECT_EQ(-4, points2["7"].mY);
+  EXPECT_EQ(times, times2);
+
+  // 数据读完之后继续读取失败
+  int extra = 0;
+  EXPECT_FALSE(reader.read(extra));
+  EXPECT_FALSE(reader.ok());
+}
+
+TEST_F(StateArchiveTest, ValuesAreLittleEndian) {
+  StateWriter writer;
+  writer.write<std::uint32_t>(0x01020304);
+  ASSERT_TRUE(writer.save(mPath, "e", 1));
+
+  // 文件头：magic、格式版本、名称长度、名称、状态版本、数据长度
+  auto bytes = readFile();
+  const std::vector<unsigned char> expected{
+      'S', 'S', 'S', 'T', 2, 0, 0, 0, 1, 0, 0, 0, 'e', 1, 0, 0, 0,
+      4,   0,   0,   0,   0, 0, 0, 0, 4, 3, 2, 1};
+  EXPECT_EQ(expected, bytes);
+}
+
+TEST_F(StateArchiveTest, RejectsMismatch) {
+  StateWriter writer;
+  writer.write(1);
+  ASSERT_TRUE(writer.save(mPath, "filter", 1));
+  EXPECT_FALSE(StateReader().load(mPath, "distributor"));
+  EXPECT_FALSE(StateReader().load(mPath + ".missing", "filter"));
+
+  auto bytes = readFile();
+  // 未知的格式版本
+  auto future = bytes;
+  future[4] = 3;
+  writeFile(future);
+  EXPECT_FALSE(StateReader().load(mPath, "filter"));
+  // 截断的数据
+  bytes.pop_back();
+  writeFile(bytes);
+  EXPECT_FALSE(StateReader().load(mPath, "filter"));
+}
+
+#if !defined(__BYTE_ORDER__) || __BYTE_ORDER__ != __ORDER_BIG_ENDIAN__
+TEST_F(StateArchiveTest, ReadsVersion1OnLittleEndian) {
+  StateWriter writer;
+  writer.write(42);
+  ASSERT_TRUE(writer.save(mPath, "filter", 1));
+  auto bytes = readFile();
+  bytes[4] = 1;
+  writeFile(bytes);
+
+  StateReader reader;
+  ASSERT_TRUE(reader.load(mPath, "filter"));
+  int value = 0;
+  EXPECT_TRUE(reader.read(value));
+  EXPECT_EQ(42, value);
+}
+#endif
+
+}  // namespace
+}  // namespace common
+}  // namespace sophon_stream
@@ -0,0 +1,92 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#include "decode_scheduler.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+namespace sophon_stream {
+namespace element {
+namespace decode {
+namespace {
+
+using StepResult = DecodeScheduler::StepResult;
+
+// 最多等待1秒，predicate成立后不再调用
+template <typename Predicate>
+bool waitFor(Predicate predicate) {
+  for (int i = 0; i < 1000; ++i) {
+    if (predicate()) return true;
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return false;
+}
+
+TEST(DecodeScheduler, RejectsDuplicateChannel) {
+  DecodeScheduler scheduler;
+  std::atomic<int> first{0}, second{0};
+  auto handler = [](std::atomic<int>& count) {
+    return [&count]() {
+      ++count;
+      return StepResult::FRAME;
+    };
+  };
+  ASSERT_EQ(common::ErrorCode::SUCCESS,
+            scheduler.add(1, 0, handler(first)));
+  EXPECT_EQ(common::ErrorCode::DECODE_CHANNEL_USED,
+            scheduler.add(1, 0, handler(second)));
+  ASSERT_EQ(common::ErrorCode::SUCCESS, scheduler.start(1));
+  EXPECT_TRUE(waitFor([&first] { return first > 10; }));
+  scheduler.remove(1);
+  EXPECT_EQ(0, second);
+
+  // 移除之后可以重新添加
+  ASSERT_EQ(common::ErrorCode::SUCCESS,
+            scheduler.add(1, 0, handler(second)));
+  EXPECT_TRUE(waitFor([&second] { return second > 0; }));
+  scheduler.stop();
+}
+
+// 通道结束时最后一帧还在解码，这时同一channelId不能重新添加
+TEST(DecodeScheduler, RejectsChannelWhileLastFrameRuns) {
+  DecodeScheduler scheduler;
+  std::atomic<bool> running{false}, release{false};
+  ASSERT_EQ(common::ErrorCode::SUCCESS, scheduler.start(1));
+  ASSERT_EQ(common::ErrorCode::SUCCESS,
+            scheduler.add(2, 0, [&running, &release]() {
+              running = true;
+              while (!release)
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+              return StepResult::END;
+            }));
+  ASSERT_TRUE(waitFor([&running] { return running.load(); }));
+  EXPECT_EQ(common::ErrorCode::DECODE_CHANNEL_USED,
+            scheduler.add(2, 0, [] { return StepResult::END; }));
+  release = true;
+
+  std::atomic<int> count{0};
+  auto restart = [&count]() {
+    ++count;
+    return StepResult::END;
+  };
+  EXPECT_TRUE(waitFor([&scheduler, &restart] {
+    return common::ErrorCode::SUCCESS == scheduler.add(2, 0, restart);
+  }));
+  EXPECT_TRUE(waitFor([&count] { return count > 0; }));
+  scheduler.stop();
+}
+
+}  // namespace
+}  // namespace decode
+}  // namespace element
+}  // namespace sophon_stream
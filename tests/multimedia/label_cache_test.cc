@@ -0,0 +1,80 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#include <gtest/gtest.h>
+
+#include <opencv2/imgproc.hpp>
+
+#include "osd_canvas.h"
+
+namespace sophon_stream {
+namespace element {
+namespace osd {
+namespace {
+
+TEST(LabelCache, MaskMatchesPutText) {
+  LabelCache cache;
+  auto mask = cache.get("person 0.87", 1.0, 2);
+  ASSERT_NE(nullptr, mask);
+
+  int baseline = 0;
+  cv::Size size = cv::getTextSize("person 0.87", cv::FONT_HERSHEY_SIMPLEX, 1.0,
+                                  2, &baseline);
+  ASSERT_EQ(size.width + 4, mask->width);
+  ASSERT_EQ(size.height + baseline + 4, mask->height);
+  cv::Mat expected(mask->height, mask->width, CV_8UC1, cv::Scalar(0));
+  cv::putText(expected, "person 0.87", cv::Point(mask->originX, mask->originY),
+              cv::FONT_HERSHEY_SIMPLEX, 1.0, cv::Scalar(255), 2, cv::LINE_AA);
+  cv::Mat actual(mask->height, mask->width, CV_8UC1,
+                 const_cast<std::uint8_t*>(mask->alpha.data()));
+  EXPECT_EQ(0, cv::norm(expected, actual, cv::NORM_INF));
+}
+
+// 绘制到Y平面的结果与opencv直接在灰度图上绘制的结果一致，笔画重叠处两边取整
+// 的次数不同，允许差2
+TEST(LabelCache, CanvasMatchesOpencvOnLuma) {
+  LabelCache cache;
+  auto mask = cache.get("car", 0.8, 1);
+  cv::Mat y(48, 96, CV_8UC1, cv::Scalar(40));
+  cv::Mat uv(24, 48, CV_8UC1, cv::Scalar(128));
+  cv::Mat v = uv.clone();
+  YuvPlanes planes;
+  planes.data[0] = y.data;
+  planes.data[1] = uv.data;
+  planes.data[2] = v.data;
+  planes.stride[0] = 96;
+  planes.stride[1] = planes.stride[2] = 48;
+  planes.width = 96;
+  planes.height = 48;
+  OsdCanvas canvas;
+  canvas.addLabel(mask, 10, 30, {235, 128, 128});
+  canvas.render(planes, 0, 48);
+
+  cv::Mat expected(48, 96, CV_8UC1, cv::Scalar(40));
+  cv::putText(expected, "car", cv::Point(10, 30), cv::FONT_HERSHEY_SIMPLEX,
+              0.8, cv::Scalar(235), 1, cv::LINE_AA);
+  EXPECT_LE(cv::norm(expected, y, cv::NORM_INF), 2);
+}
+
+TEST(LabelCache, ReusesAndEvictsLeastRecentlyUsed) {
+  LabelCache cache(2);
+  auto a = cache.get("a", 1.0, 1);
+  auto b = cache.get("b", 1.0, 1);
+  EXPECT_EQ(a, cache.get("a", 1.0, 1));
+  EXPECT_NE(a, cache.get("a", 0.5, 1));
+  EXPECT_NE(a, cache.get("a", 1.0, 2));
+  // 容量为2，"a"在最近两次访问之外，已被淘汰
+  EXPECT_NE(a, cache.get("a", 1.0, 1));
+  EXPECT_NE(b, cache.get("b", 1.0, 1));
+}
+
+}  // namespace
+}  // namespace osd
+}  // namespace element
+}  // namespace sophon_stream
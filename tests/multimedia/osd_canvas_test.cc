@@ -0,0 +1,242 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#include "osd_canvas.h"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace sophon_stream {
+namespace element {
+namespace osd {
+namespace {
+
+// 系统内存中的YUV420P图像，宽高为偶数
+struct Image {
+  Image(int width, int height, std::uint8_t fill = 0)
+      : width(width),
+        height(height),
+        y(width * height, fill),
+        u(width * height / 4, fill),
+        v(width * height / 4, fill) {}
+
+  YuvPlanes planes() {
+    YuvPlanes planes;
+    planes.data[0] = y.data();
+    planes.data[1] = u.data();
+    planes.data[2] = v.data();
+    planes.stride[0] = width;
+    planes.stride[1] = planes.stride[2] = width / 2;
+    planes.width = width;
+    planes.height = height;
+    return planes;
+  }
+
+  int width, height;
+  std::vector<std::uint8_t> y, u, v;
+};
+
+std::shared_ptr<LabelMask> randomMask(std::mt19937& rng, int width,
+                                      int height) {
+  auto mask = std::make_shared<LabelMask>();
+  mask->width = width;
+  mask->height = height;
+  mask->originX = 2;
+  mask->originY = height - 3;
+  std::uniform_int_distribution<int> value(0, 255);
+  for (int i = 0; i < width * height; ++i) {
+    int a = value(rng);
+    // 文字蒙版大部分是0或255
+    mask->alpha.push_back(a < 96 ? 0 : a > 160 ? 255 : a);
+  }
+  return mask;
+}
+
+// 逐像素按定义计算的参考结果：浮点alpha混合，色度取2x2亮度位置alpha的均值
+std::uint8_t blendReference(std::uint8_t dst, int alpha, std::uint8_t color) {
+  return static_cast<std::uint8_t>(
+      std::lround((dst * (255 - alpha) + color * alpha) / 255.0));
+}
+
+void drawLabelReference(Image& image, const LabelMask& mask, int x, int y,
+                        YuvColor color) {
+  int x0 = x - mask.originX, y0 = y - mask.originY;
+  auto maskAt = [&](int px, int py) -> int {
+    int mx = px - x0, my = py - y0;
+    if (mx < 0 || my < 0 || mx >= mask.width || my >= mask.height) return 0;
+    return mask.alpha[my * mask.width + mx];
+  };
+  for (int py = 0; py < image.height; ++py)
+    for (int px = 0; px < image.width; ++px) {
+      auto& value = image.y[py * image.width + px];
+      value = blendReference(value, maskAt(px, py), color.y);
+    }
+  for (int cy = 0; cy < image.height / 2; ++cy)
+    for (int cx = 0; cx < image.width / 2; ++cx) {
+      int px = cx * 2, py = cy * 2;
+      int alpha = (maskAt(px, py) + maskAt(px + 1, py) + maskAt(px, py + 1) +
+                   maskAt(px + 1, py + 1) + 2) /
+                  4;
+      auto& u = image.u[cy * image.width / 2 + cx];
+      auto& v = image.v[cy * image.width / 2 + cx];
+      u = blendReference(u, alpha, color.u);
+      v = blendReference(v, alpha, color.v);
+    }
+}
+
+void expectNear(const std::vector<std::uint8_t>& expected,
+                const std::vector<std::uint8_t>& actual, int tolerance) {
+  ASSERT_EQ(expected.size(), actual.size());
+  for (std::size_t i = 0; i < expected.size(); ++i)
+    ASSERT_LE(std::abs(expected[i] - actual[i]), tolerance) << "at " << i;
+}
+
+TEST(OsdCanvas, RectGoldenImage) {
+  Image image(8, 6, 16);
+  OsdCanvas canvas;
+  canvas.addRect(1, 1, 6, 4, 1, {235, 100, 200});
+  auto planes = image.planes();
+  canvas.render(planes, 0, image.height);
+
+  const std::uint8_t W = 235, o = 16;
+  const std::vector<std::uint8_t> y{
+      o, o, o, o, o, o, o, o,  //
+      o, W, W, W, W, W, W, o,  //
+      o, W, o, o, o, o, W, o,  //
+      o, W, o, o, o, o, W, o,  //
+      o, W, W, W, W, W, W, o,  //
+      o, o, o, o, o, o, o, o,  //
+  };
+  EXPECT_EQ(y, image.y);
+  // 与边框有交集的2x2块对应的色度都改写，完全在矩形内部的块不改写
+  const std::uint8_t U = 100;
+  EXPECT_EQ(std::vector<std::uint8_t>({U, U, U, U,  //
+                                       U, o, o, U,  //
+                                       U, U, U, U}),
+            image.u);
+}
+
+TEST(OsdCanvas, RectIsClippedToImage) {
+  Image image(16, 8, 16);
+  OsdCanvas canvas;
+  // 边框各有一半在图像外，只剩图像最外一圈
+  canvas.addRect(-1, -1, 18, 10, 2, {200, 90, 90});
+  auto planes = image.planes();
+  canvas.render(planes, 0, image.height);
+  for (int py = 0; py < image.height; ++py)
+    for (int px = 0; px < image.width; ++px) {
+      bool border = py == 0 || py == 7 || px == 0 || px == 15;
+      EXPECT_EQ(border ? 200 : 16, image.y[py * image.width + px])
+          << px << "," << py;
+    }
+}
+
+// SIMD路径每次处理8个像素，宽度取不是8的倍数的值覆盖尾部
+TEST(OsdCanvas, LabelMatchesReferenceBlend) {
+  std::mt19937 rng(7);
+  for (int width : {5, 8, 17, 37}) {
+    Image image(64, 32), expected(64, 32);
+    std::uniform_int_distribution<int> value(0, 255);
+    for (std::size_t i = 0; i < image.y.size(); ++i)
+      image.y[i] = expected.y[i] = value(rng);
+    for (std::size_t i = 0; i < image.u.size(); ++i) {
+      image.u[i] = expected.u[i] = value(rng);
+      image.v[i] = expected.v[i] = value(rng);
+    }
+    auto mask = randomMask(rng, width, 11);
+    YuvColor color = YuvColor::fromBgr(0, 0, 255);
+
+    OsdCanvas canvas;
+    // 起点为奇数，标签左上方有一部分在图像外
+    canvas.addLabel(mask, 1, 7, color);
+    auto planes = image.planes();
+    canvas.render(planes, 0, image.height);
+    drawLabelReference(expected, *mask, 1, 7, color);
+
+    // 移位代替除以255，与浮点结果最多差1
+    expectNear(expected.y, image.y, 1);
+    expectNear(expected.u, image.u, 1);
+    expectNear(expected.v, image.v, 1);
+  }
+}
+
+TEST(OsdCanvas, OpaqueLabelPixelsTakeColor) {
+  Image image(16, 4, 50);
+  auto mask = std::make_shared<LabelMask>();
+  mask->width = 16;
+  mask->height = 4;
+  mask->alpha.assign(64, 255);
+  OsdCanvas canvas;
+  canvas.addLabel(mask, 0, 0, {180, 60, 70});
+  auto planes = image.planes();
+  canvas.render(planes, 0, image.height);
+  EXPECT_EQ(std::vector<std::uint8_t>(64, 180), image.y);
+  EXPECT_EQ(std::vector<std::uint8_t>(16, 60), image.u);
+  EXPECT_EQ(std::vector<std::uint8_t>(16, 70), image.v);
+}
+
+TEST(OsdCanvas, DirtyRowsAreMergedAndEvenAligned) {
+  OsdCanvas canvas;
+  EXPECT_TRUE(canvas.dirtyRows(100).empty());
+  canvas.addRect(0, 3, 10, 4, 1, {});    // 行3~6
+  canvas.addRect(0, 7, 10, 2, 1, {});    // 行7~8，与上一个相邻
+  canvas.addRect(0, 41, 10, 10, 1, {});  // 行41~50
+  canvas.addRect(0, 95, 10, 10, 1, {});  // 超出图像
+  auto rows = canvas.dirtyRows(100);
+  ASSERT_EQ(3u, rows.size());
+  EXPECT_EQ(std::make_pair(2, 10), rows[0]);
+  EXPECT_EQ(std::make_pair(40, 52), rows[1]);
+  EXPECT_EQ(std::make_pair(94, 100), rows[2]);
+}
+
+// 只渲染dirtyRows中的行与整帧渲染结果相同
+TEST(OsdCanvas, RenderingDirtyRowsMatchesFullFrame) {
+  std::mt19937 rng(11);
+  Image full(96, 64, 80), banded(96, 64, 80);
+  OsdCanvas canvas;
+  canvas.addRect(3, 5, 40, 21, 3, YuvColor::fromBgr(0, 255, 0));
+  canvas.addLabel(randomMask(rng, 29, 13), 5, 18, {235, 128, 128});
+  canvas.addRect(50, 33, 30, 17, 2, YuvColor::fromBgr(255, 0, 0));
+  canvas.addLabel(randomMask(rng, 23, 9), 52, 41, {16, 128, 128});
+
+  auto fullPlanes = full.planes();
+  canvas.render(fullPlanes, 0, full.height);
+  auto bandedPlanes = banded.planes();
+  for (auto& rows : canvas.dirtyRows(banded.height))
+    canvas.render(bandedPlanes, rows.first, rows.second);
+
+  EXPECT_EQ(full.y, banded.y);
+  EXPECT_EQ(full.u, banded.u);
+  EXPECT_EQ(full.v, banded.v);
+}
+
+TEST(YuvColor, FromBgr) {
+  YuvColor white = YuvColor::fromBgr(255, 255, 255);
+  EXPECT_EQ(235, white.y);
+  EXPECT_EQ(128, white.u);
+  EXPECT_EQ(128, white.v);
+  YuvColor black = YuvColor::fromBgr(0, 0, 0);
+  EXPECT_EQ(16, black.y);
+  EXPECT_EQ(128, black.u);
+  EXPECT_EQ(128, black.v);
+  YuvColor red = YuvColor::fromBgr(0, 0, 255);
+  EXPECT_EQ(82, red.y);
+  EXPECT_EQ(90, red.u);
+  EXPECT_EQ(240, red.v);
+}
+
+}  // namespace
+}  // namespace osd
+}  // namespace element
+}  // namespace sophon_stream
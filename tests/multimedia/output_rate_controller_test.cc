@@ -0,0 +1,233 @@
+//===----------------------------------------------------------------------===//
+//
+// Copyright (C) 2022 Sophgo Technologies Inc.  All rights reserved.
+//
+// SOPHON-STREAM is licensed under the 2-Clause BSD License except for the
+// third-party components.
+//
+//===----------------------------------------------------------------------===//
+
+#include "output_rate_controller.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+namespace sophon_stream {
+namespace element {
+namespace encode {
+namespace {
+
+using std::chrono::milliseconds;
+
+TEST(BoundedFrameQueue, DropsOldestWhenFull) {
+  BoundedFrameQueue<int> queue;
+  queue.configure(2, true);
+  EXPECT_EQ(0, queue.push(1));
+  EXPECT_EQ(0, queue.push(2));
+  EXPECT_EQ(1, queue.push(3));
+  EXPECT_EQ(1, queue.push(4));
+  EXPECT_EQ(2, queue.takeDropped());
+  EXPECT_EQ(0, queue.takeDropped());
+
+  int item = 0;
+  ASSERT_TRUE(queue.pop(item, milliseconds(0)));
+  EXPECT_EQ(3, item);
+  ASSERT_TRUE(queue.pop(item, milliseconds(0)));
+  EXPECT_EQ(4, item);
+  EXPECT_FALSE(queue.pop(item, milliseconds(1)));
+}
+
+TEST(BoundedFrameQueue, CapacityIsAtLeastOne) {
+  BoundedFrameQueue<int> queue;
+  queue.configure(0, true);
+  EXPECT_EQ(0, queue.push(1));
+  EXPECT_EQ(1, queue.push(2));
+}
+
+TEST(BoundedFrameQueue, BlockingPushWaitsForSpace) {
+  BoundedFrameQueue<int> queue;
+  queue.configure(1, false);
+  EXPECT_EQ(0, queue.push(1));
+
+  std::atomic<bool> pushed{false};
+  std::thread producer([&] {
+    EXPECT_EQ(0, queue.push(2));
+    pushed = true;
+  });
+  std::this_thread::sleep_for(milliseconds(20));
+  EXPECT_FALSE(pushed);
+
+  int item = 0;
+  ASSERT_TRUE(queue.pop(item, milliseconds(0)));
+  EXPECT_EQ(1, item);
+  producer.join();
+  EXPECT_TRUE(pushed);
+  ASSERT_TRUE(queue.pop(item, milliseconds(0)));
+  EXPECT_EQ(2, item);
+  EXPECT_EQ(0, queue.takeDropped());
+}
+
+TEST(BoundedFrameQueue, CloseWakesBlockedCallers) {
+  BoundedFrameQueue<int> queue;
+  queue.configure(1, false);
+  queue.push(1);
+  std::thread producer([&] { EXPECT_EQ(1, queue.push(2)); });
+  std::this_thread::sleep_for(milliseconds(10));
+  queue.close();
+  producer.join();
+
+  // 关闭后队列中剩余的帧仍然可以取出，取完后pop立即返回
+  int item = 0;
+  EXPECT_TRUE(queue.pop(item, milliseconds(0)));
+  auto start = std::chrono::steady_clock::now();
+  EXPECT_FALSE(queue.pop(item, std::chrono::seconds(5)));
+  EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(1));
+  EXPECT_EQ(1, queue.push(3));
+}
+
+TEST(BoundedFrameQueue, ClearCountsAsDropped) {
+  BoundedFrameQueue<int> queue;
+  queue.configure(4, true);
+  queue.push(1);
+  queue.push(2);
+  EXPECT_EQ(2, queue.clear());
+  EXPECT_EQ(2, queue.takeDropped());
+  int item = 0;
+  EXPECT_FALSE(queue.pop(item, milliseconds(0)));
+}
+
+// 输入帧率为inputFps时，duration秒内通过的帧数
+int countAccepted(FramePacer& pacer, double inputFps, int seconds,
+                  std::int64_t jitterUs = 0) {
+  int accepted = 0;
+  int frames = static_cast<int>(inputFps * seconds);
+  for (int i = 0; i < frames; ++i) {
+    std::int64_t timestamp = static_cast<std::int64_t>(i * 1e6 / inputFps);
+    if (i % 2) timestamp += jitterUs;
+    if (pacer.accept(timestamp)) ++accepted;
+  }
+  return accepted;
+}
+
+TEST(FramePacer, ZeroFpsAcceptsAll) {
+  FramePacer pacer;
+  pacer.setTargetFps(0);
+  EXPECT_EQ(300, countAccepted(pacer, 30, 10));
+}
+
+TEST(FramePacer, DownsamplesToTargetFps) {
+  FramePacer pacer;
+  pacer.setTargetFps(25);
+  EXPECT_NEAR(250, countAccepted(pacer, 60, 10), 1);
+  pacer.setTargetFps(10);
+  EXPECT_NEAR(100, countAccepted(pacer, 30, 10), 1);
+  pacer.setTargetFps(15);
+  EXPECT_NEAR(150, countAccepted(pacer, 25, 10), 1);
+}
+
+// 输入帧率等于或略高于目标帧率、时间戳有抖动时不隔帧丢帧
+TEST(FramePacer, ToleratesJitter) {
+  FramePacer pacer;
+  pacer.setTargetFps(30);
+  EXPECT_EQ(300, countAccepted(pacer, 30, 10, 8000));
+  pacer.setTargetFps(30);
+  EXPECT_NEAR(300, countAccepted(pacer, 31, 10), 1);
+}
+
+TEST(FramePacer, RestartsOnTimestampJump) {
+  FramePacer pacer;
+  pacer.setTargetFps(10);
+  EXPECT_TRUE(pacer.accept(5000000));
+  EXPECT_FALSE(pacer.accept(5040000));
+  // 循环播放，时间戳回到0
+  EXPECT_TRUE(pacer.accept(0));
+  EXPECT_FALSE(pacer.accept(40000));
+  // 跳变超过1秒
+  EXPECT_TRUE(pacer.accept(9000000));
+}
+
+class BitrateAdapterTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    mAdapter.configure(4000, 500);
+    EXPECT_FALSE(mAdapter.update(mNowUs));
+  }
+
+  // 一个1秒的窗口，发送kbps码率的数据，写出线程忙碌busy比例的时间
+  bool window(int kbps, double busy, std::int64_t dropped = 0) {
+    mAdapter.onWrite(static_cast<std::int64_t>(kbps) * 1000 / 8,
+                     static_cast<std::int64_t>(busy * 1000000));
+    mAdapter.onDrop(dropped);
+    mNowUs += 1000000;
+    return mAdapter.update(mNowUs);
+  }
+
+  BitrateAdapter mAdapter;
+  std::int64_t mNowUs = 0;
+};
+
+TEST_F(BitrateAdapterTest, StartsAtMaxBitrate) {
+  EXPECT_EQ(4000, mAdapter.bitrate());
+  EXPECT_FALSE(window(4000, 0.3));
+  EXPECT_EQ(4000, mAdapter.bitrate());
+}
+
+TEST_F(BitrateAdapterTest, UpdatesOnlyAfterFullWindow) {
+  mAdapter.onWrite(1000000, 990000);
+  EXPECT_FALSE(mAdapter.update(mNowUs + 500000));
+  EXPECT_EQ(4000, mAdapter.bitrate());
+  EXPECT_TRUE(mAdapter.update(mNowUs + 1000000));
+}
+
+TEST_F(BitrateAdapterTest, LowersToMeasuredRateWhenBusy) {
+  // 发送速率只有2000kbps，降到其90%
+  EXPECT_TRUE(window(2000, 0.95));
+  EXPECT_EQ(1800, mAdapter.bitrate());
+  // 发送速率接近当前码率时每个窗口至少降15%
+  EXPECT_TRUE(window(1800, 0.95));
+  EXPECT_EQ(1530, mAdapter.bitrate());
+}
+
+TEST_F(BitrateAdapterTest, DropsWithModerateLoadCountAsCongestion) {
+  EXPECT_FALSE(window(4000, 0.6));
+  EXPECT_EQ(4000, mAdapter.bitrate());
+  EXPECT_TRUE(window(4000, 0.6, 3));
+  EXPECT_EQ(3400, mAdapter.bitrate());
+}
+
+TEST_F(BitrateAdapterTest, NeverGoesBelowMinimum) {
+  for (int i = 0; i < 20; ++i) window(100, 1.0);
+  EXPECT_EQ(500, mAdapter.bitrate());
+}
+
+TEST_F(BitrateAdapterTest, RaisesAfterThreeHealthyWindows) {
+  window(1000, 1.0);
+  ASSERT_EQ(900, mAdapter.bitrate());
+  EXPECT_FALSE(window(900, 0.2));
+  EXPECT_FALSE(window(900, 0.2));
+  EXPECT_TRUE(window(900, 0.2));
+  EXPECT_EQ(990, mAdapter.bitrate());
+  // 此后每个健康的窗口都继续提高
+  EXPECT_TRUE(window(990, 0.2));
+  EXPECT_EQ(1089, mAdapter.bitrate());
+  // 中间出现一个不健康的窗口后重新计数
+  EXPECT_FALSE(window(1089, 0.7));
+  EXPECT_FALSE(window(1089, 0.2));
+  EXPECT_FALSE(window(1089, 0.2));
+  EXPECT_TRUE(window(1089, 0.2));
+}
+
+TEST_F(BitrateAdapterTest, RaiseIsCappedAtMaxBitrate) {
+  window(4000, 0.95);
+  ASSERT_EQ(3400, mAdapter.bitrate());
+  for (int i = 0; i < 10; ++i) window(3400, 0.1);
+  EXPECT_EQ(4000, mAdapter.bitrate());
+}
+
+}  // namespace
+}  // namespace encode
+}  // namespace element
+}  // namespace sophon_stream